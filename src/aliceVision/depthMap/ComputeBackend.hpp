@@ -0,0 +1,85 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/config.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Implementation used for the plane sweeping computations (SGM and Refine)
+ */
+enum class EComputeBackend {
+    CUDA = 0, //< PlaneSweepingCuda kernels, on all the available CUDA devices
+    CPU = 1   //< PlaneSweepingCpu, multithreaded with OpenMP
+};
+
+/**
+ * @brief Default compute backend: CUDA if AliceVision is built with CUDA, CPU otherwise.
+ */
+inline EComputeBackend EComputeBackend_default()
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    return EComputeBackend::CUDA;
+#else
+    return EComputeBackend::CPU;
+#endif
+}
+
+/**
+ * @brief converts an EComputeBackend enum to a string.
+ * @param[in] backend the EComputeBackend enum to convert.
+ * @return the string associated to the EComputeBackend enum.
+ */
+inline std::string EComputeBackend_enumToString(EComputeBackend backend)
+{
+    switch(backend)
+    {
+        case EComputeBackend::CUDA: return "cuda";
+        case EComputeBackend::CPU: return "cpu";
+    }
+    throw std::out_of_range("Invalid EComputeBackend enum");
+}
+
+/**
+ * @brief returns the EComputeBackend enum from a string.
+ * @param[in] backend the input string.
+ * @return the associated EComputeBackend enum.
+ */
+inline EComputeBackend EComputeBackend_stringToEnum(const std::string& backend)
+{
+    std::string b = backend;
+    std::transform(b.begin(), b.end(), b.begin(), ::tolower);
+
+    if(b == "cuda")
+        return EComputeBackend::CUDA;
+    if(b == "cpu")
+        return EComputeBackend::CPU;
+    throw std::out_of_range("Invalid compute backend: " + backend);
+}
+
+inline std::ostream& operator<<(std::ostream& os, EComputeBackend backend)
+{
+    return os << EComputeBackend_enumToString(backend);
+}
+
+inline std::istream& operator>>(std::istream& in, EComputeBackend& backend)
+{
+    std::string token;
+    in >> token;
+    backend = EComputeBackend_stringToEnum(token);
+    return in;
+}
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -6,6 +6,7 @@
 
 #include "RefineRc.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/depthMap/ComputeBackend.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
@@ -345,6 +346,16 @@ void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::
 
 void refineDepthMaps(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
 {
+    const EComputeBackend computeBackend = EComputeBackend_stringToEnum(
+        mp->_ini.get<std::string>("global.computeBackend", EComputeBackend_enumToString(EComputeBackend_default())));
+    if(computeBackend == EComputeBackend::CPU)
+    {
+        // a single PlaneSweepingCpu, its operations are multithreaded
+        ALICEVISION_LOG_INFO("Compute backend: cpu, number of CPU threads: " << omp_get_max_threads());
+        refineDepthMaps(mp->CUDADeviceNo, mp, pc, cams);
+        return;
+    }
+
     int num_gpus = listCUDADevices(true);
     int num_cpu_threads = omp_get_num_procs();
     ALICEVISION_LOG_INFO("Number of GPU devices: " << num_gpus << ", number of CPU threads: " << num_cpu_threads);
@@ -0,0 +1,129 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LabImage.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+/// Conversion of a float to unsigned char with saturation (as the CUDA conversion)
+inline unsigned char toUChar(float v)
+{
+    return static_cast<unsigned char>(std::fmin(255.0f, std::fmax(0.0f, v)));
+}
+
+inline float labF(float r)
+{
+    return (r > 216.0f / 24389.0f) ? std::cbrt(r) : (24389.0f / 27.0f * r + 16.0f) / 116.0f;
+}
+
+} // namespace
+
+LabPixel rgbToLab(const rgb& c)
+{
+    // linear RGB (0..1) to XYZ
+    const float r = c.r / 255.0f;
+    const float g = c.g / 255.0f;
+    const float b = c.b / 255.0f;
+    const float x = 0.4124564f * r + 0.3575761f * g + 0.1804375f * b;
+    const float y = 0.2126729f * r + 0.7151522f * g + 0.0721750f * b;
+    const float z = 0.0193339f * r + 0.1191920f * g + 0.9503041f * b;
+
+    // XYZ to Lab, assuming whitepoint D65, XYZ=(0.95047, 1.00000, 1.08883)
+    const float fx = labF(x / 0.95047f);
+    const float fy = labF(y);
+    const float fz = labF(z / 1.08883f);
+
+    LabPixel out;
+    out.x = toUChar((116.0f * fy - 16.0f) * 2.55f);
+    out.y = toUChar((500.0f * (fx - fy)) * 2.55f);
+    out.z = toUChar((200.0f * (fy - fz)) * 2.55f);
+    out.w = 0;
+    return out;
+}
+
+void computeGradientSizeOfL(LabImage& image)
+{
+    const int width = image.width();
+    const int height = image.height();
+
+    // only the L channel is read, so the w channel can be updated in place
+#pragma omp parallel for
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const float gx = static_cast<float>(image.fetch(x - 1, y).x) - static_cast<float>(image.fetch(x + 1, y).x);
+            const float gy = static_cast<float>(image.fetch(x, y - 1).x) - static_cast<float>(image.fetch(x, y + 1).x);
+            image.at(x, y).w = toUChar(std::sqrt(gx * gx + gy * gy));
+        }
+    }
+}
+
+void buildLabPyramid(const LabImage& level0, int scales, int varianceWsh, std::vector<LabImage>& pyramid)
+{
+    pyramid.resize(scales);
+    pyramid[0] = level0;
+    if(varianceWsh > 0)
+        computeGradientSizeOfL(pyramid[0]);
+
+    const LabImage& src = pyramid[0];
+
+    for(int s = 1; s < scales; ++s)
+    {
+        const int scale = s + 1;
+        const int radius = s + 1;
+        const int width = src.width() / scale;
+        const int height = src.height() / scale;
+
+        std::vector<float> gaussian(2 * radius + 1);
+        for(int i = -radius; i <= radius; ++i)
+            gaussian[i + radius] = std::exp(-static_cast<float>(i * i) / 2.0f);
+
+        LabImage& dst = pyramid[s];
+        dst = LabImage(width, height);
+
+#pragma omp parallel for
+        for(int y = 0; y < height; ++y)
+        {
+            for(int x = 0; x < width; ++x)
+            {
+                LabColor t;
+                float sum = 0.0f;
+                for(int i = -radius; i <= radius; ++i)
+                {
+                    for(int j = -radius; j <= radius; ++j)
+                    {
+                        // texture coordinates (x * scale + j + scale / 2) in pixel coordinates
+                        const LabColor c = src.sample(static_cast<float>(x * scale + j) + scale / 2.0f - 0.5f,
+                                                      static_cast<float>(y * scale + i) + scale / 2.0f - 0.5f);
+                        const float factor = gaussian[i + radius] * gaussian[j + radius];
+                        t.x += c.x * factor;
+                        t.y += c.y * factor;
+                        t.z += c.z * factor;
+                        t.w += c.w * factor;
+                        sum += factor;
+                    }
+                }
+                LabPixel& out = dst.at(x, y);
+                out.x = toUChar(t.x / sum);
+                out.y = toUChar(t.y / sum);
+                out.z = toUChar(t.z / sum);
+                out.w = toUChar(t.w / sum);
+            }
+        }
+
+        if(varianceWsh > 0)
+            computeGradientSizeOfL(dst);
+    }
+}
+
+} // namespace depthMap
+} // namespace aliceVision
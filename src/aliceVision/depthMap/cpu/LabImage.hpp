@@ -0,0 +1,149 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Rgb.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Lab pixel as stored in the CUDA textures:
+ *        x: L, y: a, z: b (clamped to 0..255) and w: size of the gradient of L.
+ */
+struct LabPixel
+{
+    unsigned char x = 0;
+    unsigned char y = 0;
+    unsigned char z = 0;
+    unsigned char w = 0;
+};
+
+/**
+ * @brief Interpolated Lab value (in 0..255)
+ */
+struct LabColor
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 0.0f;
+};
+
+/**
+ * @brief Image in Lab colorspace, used by the CPU implementation of the plane sweeping.
+ *
+ * The lookups reproduce the behavior of the CUDA textures used by the kernels
+ * (clamped borders, bilinear filtering with 8 bits of fractional weights).
+ */
+class LabImage
+{
+public:
+    LabImage() = default;
+
+    LabImage(int width, int height)
+        : _width(width)
+        , _height(height)
+        , _data(static_cast<std::size_t>(width) * height)
+    {}
+
+    inline int width() const { return _width; }
+    inline int height() const { return _height; }
+
+    inline LabPixel& at(int x, int y) { return _data[static_cast<std::size_t>(y) * _width + x]; }
+    inline const LabPixel& at(int x, int y) const { return _data[static_cast<std::size_t>(y) * _width + x]; }
+
+    /// Pixel value with clamped coordinates
+    inline const LabPixel& fetch(int x, int y) const
+    {
+        return at(std::min(std::max(x, 0), _width - 1), std::min(std::max(y, 0), _height - 1));
+    }
+
+    /**
+     * @brief Bilinear interpolation at pixel coordinates (x, y).
+     *        Same as 255 * tex2D(tex, x + 0.5, y + 0.5) on a normalized float texture with linear filtering.
+     */
+    inline LabColor sample(float x, float y) const
+    {
+        // avoid integer overflows on far away (or NaN) coordinates, the borders are clamped anyway
+        x = std::fmin(std::fmax(x, -1.0f), static_cast<float>(_width));
+        y = std::fmin(std::fmax(y, -1.0f), static_cast<float>(_height));
+
+        const float fx = std::floor(x);
+        const float fy = std::floor(y);
+        const int x0 = static_cast<int>(fx);
+        const int y0 = static_cast<int>(fy);
+        // texture units use 8 bits for the fractional part of the weights
+        const float a = std::round((x - fx) * 256.0f) / 256.0f;
+        const float b = std::round((y - fy) * 256.0f) / 256.0f;
+
+        const LabPixel& p00 = fetch(x0, y0);
+        const LabPixel& p10 = fetch(x0 + 1, y0);
+        const LabPixel& p01 = fetch(x0, y0 + 1);
+        const LabPixel& p11 = fetch(x0 + 1, y0 + 1);
+
+        const float w00 = (1.0f - a) * (1.0f - b);
+        const float w10 = a * (1.0f - b);
+        const float w01 = (1.0f - a) * b;
+        const float w11 = a * b;
+
+        LabColor out;
+        out.x = w00 * p00.x + w10 * p10.x + w01 * p01.x + w11 * p11.x;
+        out.y = w00 * p00.y + w10 * p10.y + w01 * p01.y + w11 * p11.y;
+        out.z = w00 * p00.z + w10 * p10.z + w01 * p01.z + w11 * p11.z;
+        out.w = w00 * p00.w + w10 * p10.w + w01 * p01.w + w11 * p11.w;
+        return out;
+    }
+
+    /// Pixel value at integer coordinates (clamped) as an interpolated color
+    inline LabColor sample(int x, int y) const
+    {
+        const LabPixel& p = fetch(x, y);
+        LabColor out;
+        out.x = p.x;
+        out.y = p.y;
+        out.z = p.z;
+        out.w = p.w;
+        return out;
+    }
+
+private:
+    int _width = 0;
+    int _height = 0;
+    std::vector<LabPixel> _data;
+};
+
+inline float euclidean3(const LabColor& c1, const LabColor& c2)
+{
+    return std::sqrt((c1.x - c2.x) * (c1.x - c2.x) + (c1.y - c2.y) * (c1.y - c2.y) + (c1.z - c2.z) * (c1.z - c2.z));
+}
+
+/**
+ * @brief Convert an RGB color to Lab as stored in the textures (w is set to 0).
+ */
+LabPixel rgbToLab(const rgb& c);
+
+/**
+ * @brief Store the size of the gradient of L in the w channel of each pixel.
+ */
+void computeGradientSizeOfL(LabImage& image);
+
+/**
+ * @brief Build the image pyramid used by the plane sweeping, as done by ps_deviceUpdateCam.
+ * @param[in] level0 the full resolution Lab image (w channel not computed)
+ * @param[in] scales number of pyramid levels, level s is downscaled by s+1
+ * @param[in] varianceWsh if > 0, the gradient size of L is computed in the w channel
+ * @param[out] pyramid the image pyramid
+ */
+void buildLabPyramid(const LabImage& level0, int scales, int varianceWsh, std::vector<LabImage>& pyramid);
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,154 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PlaneSweepingCpu.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/depthMap/cpu/planeSweepingKernels.hpp>
+#include <aliceVision/depthMap/cpu/sgmVolume.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace aliceVision {
+namespace depthMap {
+
+PlaneSweepingCpu::PlaneSweepingCpu(mvsUtils::ImagesCache* ic, mvsUtils::MultiViewParams* mp, int scales,
+                                   int nbCamsInCache, int varianceWSH)
+    : _ic(ic)
+    , _mp(mp)
+    , _scales(scales)
+    , _varianceWSH(varianceWSH)
+    , _cacheCamIds(std::max(2, nbCamsInCache), -1)
+    , _cacheTimes(std::max(2, nbCamsInCache), 0)
+    , _cachePyramids(std::max(2, nbCamsInCache))
+{
+    ALICEVISION_LOG_INFO("PlaneSweepingCpu:" << std::endl
+                         << "\t- nb images in cache: " << _cacheCamIds.size() << std::endl
+                         << "\t- nb threads: " << omp_get_max_threads());
+}
+
+const std::vector<LabImage>& PlaneSweepingCpu::getImagePyramid(int camId)
+{
+    ++_cacheClock;
+
+    const auto it = std::find(_cacheCamIds.begin(), _cacheCamIds.end(), camId);
+    if(it != _cacheCamIds.end())
+    {
+        const std::size_t id = std::distance(_cacheCamIds.begin(), it);
+        _cacheTimes[id] = _cacheClock;
+        return _cachePyramids[id];
+    }
+
+    // replace the oldest one
+    const std::size_t id = std::distance(_cacheTimes.begin(), std::min_element(_cacheTimes.begin(), _cacheTimes.end()));
+
+    long t1 = clock();
+
+    const int width = _mp->getWidth(camId);
+    const int height = _mp->getHeight(camId);
+
+    const mvsUtils::ImagesCache::ImgSharedPtr img = _ic->getImg_sync(camId);
+
+    LabImage level0(width, height);
+#pragma omp parallel for
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+            level0.at(x, y) = rgbToLab(img->getPixelValue(Pixel(x, y)));
+    }
+
+    buildLabPyramid(level0, _scales, _varianceWSH, _cachePyramids[id]);
+
+    if(_mp->verbose)
+        mvsUtils::printfElapsedTime(t1, "load image pyramid ");
+
+    _cacheCamIds[id] = camId;
+    _cacheTimes[id] = _cacheClock;
+    return _cachePyramids[id];
+}
+
+PlaneSweepingCamera PlaneSweepingCpu::getCamera(int camId, int scale)
+{
+    PlaneSweepingCamera camera;
+    camera.K = _mp->KArr[camId];
+    camera.R = _mp->RArr[camId];
+    camera.C = _mp->CArr[camId];
+    camera.image = &getImagePyramid(camId)[scale - 1];
+    return camera;
+}
+
+float PlaneSweepingCpu::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX,
+                                            int volDimY, int volDimZ, int volStepXY, int volLUX, int volLUY,
+                                            int volLUZ, const StaticVector<float>* depths, int rc, int tc, int wsh,
+                                            float gammaC, float gammaP, const StaticVector<Voxel>* pixels, int scale,
+                                            float epipShift)
+{
+    return computeSweepVolume(getCamera(rc, scale), getCamera(tc, scale), scale, nDepthsToSearch,
+                              volume->getDataWritable().data(), volDimX, volDimY, volDimZ, volStepXY, volLUX, volLUY,
+                              volLUZ, *depths, *pixels, wsh, gammaC, gammaP, epipShift);
+}
+
+void PlaneSweepingCpu::SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                                            int volDimZ, int scale, unsigned char P1)
+{
+    const LabImage& rcImage = getImagePyramid(rc)[scale - 1];
+    sgmOptimizeSimVolume(rcImage, volume->getDataWritable().data(), volDimX, volDimY, volDimZ, P1);
+}
+
+void PlaneSweepingCpu::refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                                          StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh,
+                                          float gammaC, float gammaP, float epipShift, int xFrom, int wPart)
+{
+    refineDepthMap(getCamera(rc, scale), getCamera(tc, scale), scale, useTcOrRcPixSize, nStepsToRefine,
+                   simMap->getDataWritable().data(), rcDepthMap->getDataWritable().data(), wsh, gammaC, gammaP,
+                   epipShift, xFrom, wPart);
+}
+
+void PlaneSweepingCpu::fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                                            const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                                            int nSamplesHalf, int nDepthsToRefine, float sigma)
+{
+    fuseDepthSimMaps(w, h, *oDepthSimMap, *dataMaps, nSamplesHalf, nDepthsToRefine, sigma);
+}
+
+void PlaneSweepingCpu::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                                          const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                                          int rc, int nIters, int yFrom, int hPart)
+{
+    optimizeDepthSimMap(getCamera(rc, 1), *oDepthSimMap, *dataMaps, nIters, yFrom, hPart);
+}
+
+void PlaneSweepingCpu::getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc)
+{
+    const int w = _mp->getWidth(rc) / scale;
+    const int h = _mp->getHeight(rc) / scale;
+    const LabImage& rcImage = getImagePyramid(rc)[scale - 1];
+    const LabPixel maskColorLab = rgbToLab(maskColor);
+
+#pragma omp parallel for
+    for(int y = 0; y < h / step; ++y)
+    {
+        for(int x = 0; x < w / step; ++x)
+        {
+            const LabPixel& col = rcImage.fetch(x * step, y * step);
+            (*oMap)[y * (w / step) + x] = ((maskColorLab.x == col.x) && (maskColorLab.y == col.y) && (maskColorLab.z == col.z));
+        }
+    }
+}
+
+Point3d PlaneSweepingCpu::getMemoryInfo() const
+{
+    const system::MemoryInfo memInfo = system::getMemoryInfo();
+    const double toMB = 1.0 / (1024.0 * 1024.0);
+    return Point3d(memInfo.freeRam * toMB, memInfo.totalRam * toMB, (memInfo.totalRam - memInfo.freeRam) * toMB);
+}
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,98 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/Rgb.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/depthMap/DepthSimMap.hpp>
+#include <aliceVision/depthMap/cpu/LabImage.hpp>
+#include <aliceVision/depthMap/cpu/planeSweepingKernels.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief CPU implementation of the PlaneSweepingCuda operations used by the SGM and Refine steps.
+ *
+ * The computations reproduce the CUDA kernels (same Lab image pyramids, texture lookups, similarity,
+ * aggregation and refinement), so the depth maps can be estimated on machines without a CUDA device.
+ * Each operation is parallelized with OpenMP over independent pixels or scanlines.
+ *
+ * @note Only the operations called by SemiGlobalMatchingRc and RefineRc are ported. The other PlaneSweepingCuda
+ *       operations, like refinePixelsAll and refinePixelsAllFine, have no CPU version.
+ */
+class PlaneSweepingCpu
+{
+public:
+    /**
+     * @param[in] ic the images cache
+     * @param[in] mp the multi-view parameters
+     * @param[in] scales number of pyramid levels of the images
+     * @param[in] nbCamsInCache number of image pyramids kept in memory
+     * @param[in] varianceWSH if > 0, the gradient of the images is computed (used by the depth map optimization)
+     */
+    PlaneSweepingCpu(mvsUtils::ImagesCache* ic, mvsUtils::MultiViewParams* mp, int scales, int nbCamsInCache,
+                     int varianceWSH);
+
+    /**
+     * @brief Similarity volume of the reference camera with one target camera.
+     * @return the size of the volume in MB
+     */
+    float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                              int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
+                              const StaticVector<float>* depths, int rc, int tc, int wsh, float gammaC, float gammaP,
+                              const StaticVector<Voxel>* pixels, int scale, float epipShift);
+
+    void SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY, int volDimZ,
+                              int scale, unsigned char P1);
+
+    void refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                            StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh, float gammaC,
+                            float gammaP, float epipShift, int xFrom, int wPart);
+
+    void fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                              const StaticVector<StaticVector<DepthSim>*>* dataMaps, int nSamplesHalf,
+                                              int nDepthsToRefine, float sigma);
+
+    void optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                            const StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc, int nIters,
+                                            int yFrom, int hPart);
+
+    void getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc);
+
+    /**
+     * @brief RAM information, in the same form as the device memory information
+     * @return (available, total, used) in MB
+     */
+    Point3d getMemoryInfo() const;
+
+private:
+    /// Lab image pyramid of a camera, loaded from the images cache if needed
+    const std::vector<LabImage>& getImagePyramid(int camId);
+    /// Camera matrices of a camera and its image at the given scale
+    PlaneSweepingCamera getCamera(int camId, int scale);
+
+    mvsUtils::ImagesCache* _ic;
+    mvsUtils::MultiViewParams* _mp;
+    int _scales;
+    int _varianceWSH;
+
+    /// LRU cache of the image pyramids
+    std::vector<int> _cacheCamIds;
+    std::vector<long> _cacheTimes;
+    std::vector<std::vector<LabImage>> _cachePyramids;
+    long _cacheClock = 0;
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,649 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "planeSweepingKernels.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+// Single precision geometry, as in the CUDA kernels (device_matrix.cu, device_patch_es.cu)
+
+struct Vec2
+{
+    float x;
+    float y;
+};
+
+struct Vec3
+{
+    float x;
+    float y;
+    float z;
+};
+
+inline Vec2 operator+(const Vec2& a, const Vec2& b) { return {a.x + b.x, a.y + b.y}; }
+inline Vec2 operator-(const Vec2& a, const Vec2& b) { return {a.x - b.x, a.y - b.y}; }
+inline Vec2 operator*(const Vec2& a, float k) { return {a.x * k, a.y * k}; }
+
+inline Vec3 operator+(const Vec3& a, const Vec3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+inline Vec3 operator-(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+inline Vec3 operator*(const Vec3& a, float k) { return {a.x * k, a.y * k, a.z * k}; }
+inline Vec3 operator/(const Vec3& a, float k) { return {a.x / k, a.y / k, a.z / k}; }
+
+inline float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3 cross(const Vec3& a, const Vec3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+inline float size(const Vec3& a) { return std::sqrt(dot(a, a)); }
+inline Vec3 normalized(const Vec3& a) { return a / size(a); }
+inline Vec2 normalized(const Vec2& a) { const float d = std::sqrt(a.x * a.x + a.y * a.y); return {a.x / d, a.y / d}; }
+
+inline float sigmoid(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((xval - sigMid) / sigwidth))));
+}
+
+inline float sigmoid2(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((sigMid - xval) / sigwidth))));
+}
+
+/**
+ * @brief Camera matrices at a given scale (column-major, as cameraStruct) and image at the same scale.
+ */
+struct CameraCpu
+{
+    float P[12];
+    float iP[9];
+    Vec3 C;
+    Vec3 ZVect;
+    const LabImage* image = nullptr;
+};
+
+CameraCpu makeCamera(const PlaneSweepingCamera& camera, int scale)
+{
+    Matrix3x3 scaleM;
+    scaleM.m11 = 1.0 / (float)scale;
+    scaleM.m12 = 0.0;
+    scaleM.m13 = 0.0;
+    scaleM.m21 = 0.0;
+    scaleM.m22 = 1.0 / (float)scale;
+    scaleM.m23 = 0.0;
+    scaleM.m31 = 0.0;
+    scaleM.m32 = 0.0;
+    scaleM.m33 = 1.0;
+    const Matrix3x3 K = scaleM * camera.K;
+    const Matrix3x3 iK = K.inverse();
+    const Matrix3x3 iR = camera.R.transpose();
+    const Matrix3x4 P = K * (camera.R | (Point3d(0.0, 0.0, 0.0) - camera.R * camera.C));
+    const Matrix3x3 iP = iR * iK;
+
+    CameraCpu cam;
+    const double Parr[12] = {P.m11, P.m21, P.m31, P.m12, P.m22, P.m32, P.m13, P.m23, P.m33, P.m14, P.m24, P.m34};
+    const double iParr[9] = {iP.m11, iP.m21, iP.m31, iP.m12, iP.m22, iP.m32, iP.m13, iP.m23, iP.m33};
+    for(int i = 0; i < 12; ++i)
+        cam.P[i] = static_cast<float>(Parr[i]);
+    for(int i = 0; i < 9; ++i)
+        cam.iP[i] = static_cast<float>(iParr[i]);
+    cam.C = {static_cast<float>(camera.C.x), static_cast<float>(camera.C.y), static_cast<float>(camera.C.z)};
+    cam.ZVect = normalized(Vec3{static_cast<float>(iR.m13), static_cast<float>(iR.m23), static_cast<float>(iR.m33)});
+    cam.image = camera.image;
+    return cam;
+}
+
+inline Vec2 project3DPoint(const float* P, const Vec3& p)
+{
+    const float x = P[0] * p.x + P[3] * p.y + P[6] * p.z + P[9];
+    const float y = P[1] * p.x + P[4] * p.y + P[7] * p.z + P[10];
+    const float z = P[2] * p.x + P[5] * p.y + P[8] * p.z + P[11];
+    return {x / z, y / z};
+}
+
+inline Vec3 M3x3mulV2(const float* M, const Vec2& v)
+{
+    return {M[0] * v.x + M[3] * v.y + M[6], M[1] * v.x + M[4] * v.y + M[7], M[2] * v.x + M[5] * v.y + M[8]};
+}
+
+inline float pointLineDistance3D(const Vec3& point, const Vec3& linePoint, const Vec3& lineVectNormalized)
+{
+    return size(cross(lineVectNormalized, linePoint - point));
+}
+
+inline Vec3 closestPointToLine3D(const Vec3& point, const Vec3& linePoint, const Vec3& lineVectNormalized)
+{
+    return linePoint + lineVectNormalized * dot(lineVectNormalized, point - linePoint);
+}
+
+inline float angleBetwABandAC(const Vec3& A, const Vec3& B, const Vec3& C)
+{
+    const Vec3 V1 = normalized(B - A);
+    const Vec3 V2 = normalized(C - A);
+    float a = std::acos(dot(V1, V2));
+    a = std::isinf(a) ? 0.0f : a;
+    return std::fabs(a) / (static_cast<float>(M_PI) / 180.0f);
+}
+
+inline Vec3 get3DPointForPixelAndDepthFromRC(const CameraCpu& rc, const Vec2& pix, float depth)
+{
+    return rc.C + normalized(M3x3mulV2(rc.iP, pix)) * depth;
+}
+
+inline Vec3 get3DPointForPixelAndFrontoParellePlaneRC(const CameraCpu& rc, const Vec2& pix, float fpPlaneDepth)
+{
+    const Vec3 planep = rc.C + rc.ZVect * fpPlaneDepth;
+    const Vec3 v = normalized(M3x3mulV2(rc.iP, pix));
+    const float k = (dot(planep, rc.ZVect) - dot(rc.ZVect, rc.C)) / dot(rc.ZVect, v);
+    return rc.C + v * k;
+}
+
+inline float computePixSize(const CameraCpu& rc, const Vec3& p)
+{
+    const Vec2 rp1 = project3DPoint(rc.P, p) + Vec2{1.0f, 0.0f};
+    const Vec3 refvect = normalized(M3x3mulV2(rc.iP, rp1));
+    return pointLineDistance3D(p, rc.C, refvect);
+}
+
+Vec3 triangulateMatchRef(const CameraCpu& rc, const CameraCpu& tc, const Vec2& refpix, const Vec2& tarpix)
+{
+    const Vec3 refvect = normalized(M3x3mulV2(rc.iP, refpix));
+    const Vec3 refpoint = refvect + rc.C;
+    const Vec3 tarvect = normalized(M3x3mulV2(tc.iP, tarpix));
+    const Vec3 tarpoint = tarvect + tc.C;
+
+    // shortest segment between the lines (rC, refpoint) and (tC, tarpoint) (Paul Bourke)
+    const Vec3 p13 = rc.C - tc.C;
+    const Vec3 p43 = tarpoint - tc.C;
+    const Vec3 p21 = refpoint - rc.C;
+    const float d1343 = dot(p13, p43);
+    const float d4321 = dot(p43, p21);
+    const float d1321 = dot(p13, p21);
+    const float d4343 = dot(p43, p43);
+    const float d2121 = dot(p21, p21);
+    const float denom = d2121 * d4343 - d4321 * d4321;
+    const float numer = d1343 * d4321 - d1321 * d4343;
+    const float k = numer / denom;
+
+    return rc.C + refvect * k;
+}
+
+inline void move3DPointByRcPixSize(const CameraCpu& rc, Vec3& p, float rcPixSize)
+{
+    p = p + normalized(p - rc.C) * rcPixSize;
+}
+
+void move3DPointByTcPixStep(const CameraCpu& rc, const CameraCpu& tc, Vec3& p, float tcPixStep)
+{
+    const Vec3 rpv = rc.C - p;
+    const Vec3 prp1 = p + rpv / 2.0f;
+
+    const Vec2 rp = project3DPoint(rc.P, p);
+    const Vec2 tpo = project3DPoint(tc.P, p);
+    const Vec2 tpv = normalized(project3DPoint(tc.P, prp1) - tpo);
+    const Vec2 tpd = tpo + tpv * tcPixStep;
+
+    p = triangulateMatchRef(rc, tc, rp, tpd);
+}
+
+inline void move3DPointByTcOrRcPixStep(const CameraCpu& rc, const CameraCpu& tc, Vec3& p, float pixStep,
+                                       bool moveByTcOrRc)
+{
+    if(moveByTcOrRc)
+        move3DPointByTcPixStep(rc, tc, p, pixStep);
+    else
+        move3DPointByRcPixSize(rc, p, pixStep * computePixSize(rc, p));
+}
+
+struct Patch
+{
+    Vec3 p;
+    Vec3 n;
+    Vec3 x;
+    Vec3 y;
+    float d;
+};
+
+inline void computeRotCSEpip(const CameraCpu& rc, const CameraCpu& tc, Patch& ptch, const Vec3& p)
+{
+    ptch.p = p;
+    const Vec3 v1 = normalized(rc.C - p);
+    const Vec3 v2 = normalized(tc.C - p);
+    // y orthogonal to the epipolar plane, n and x on the epipolar plane
+    ptch.y = normalized(cross(v1, v2));
+    ptch.n = normalized((v1 + v2) / 2.0f);
+    ptch.x = normalized(cross(ptch.y, ptch.n));
+}
+
+/**
+ * @brief Weighted NCC of the patch between the reference and the target images (compNCCby3DptsYK)
+ * @return similarity value in range (-1, 0) or 1 if it cannot be computed
+ */
+float compNCCby3DptsYK(const CameraCpu& rc, const CameraCpu& tc, const Patch& ptch, int wsh, int width, int height,
+                       float gammaC, float gammaP, float epipShift)
+{
+    const Vec2 rp = project3DPoint(rc.P, ptch.p);
+    Vec2 tp = project3DPoint(tc.P, ptch.p);
+
+    // assuming that ptch.y is orthogonal to the epipolar plane
+    const Vec2 tvUp = normalized(project3DPoint(tc.P, ptch.p + ptch.y * (ptch.d * 10.0f)) - tp);
+    const Vec2 vEpipShift = tvUp * epipShift;
+    tp = tp + vEpipShift;
+
+    const float dd = wsh + 2.0f;
+    if((rp.x < dd) || (rp.x > (float)(width - 1) - dd) || (rp.y < dd) || (rp.y > (float)(height - 1) - dd) ||
+       (tp.x < dd) || (tp.x > (float)(width - 1) - dd) || (tp.y < dd) || (tp.y > (float)(height - 1) - dd))
+    {
+        return 1.0f;
+    }
+
+    const LabColor gcr = rc.image->sample(rp.x, rp.y);
+    const LabColor gct = tc.image->sample(tp.x, tp.y);
+
+    float wsum = 0.0f;
+    float xsum = 0.0f;
+    float ysum = 0.0f;
+    float xxsum = 0.0f;
+    float yysum = 0.0f;
+    float xysum = 0.0f;
+
+    for(int yp = -wsh; yp <= wsh; ++yp)
+    {
+        for(int xp = -wsh; xp <= wsh; ++xp)
+        {
+            const Vec3 p = ptch.p + ptch.x * (ptch.d * (float)xp) + ptch.y * (ptch.d * (float)yp);
+            const Vec2 rp1 = project3DPoint(rc.P, p);
+            const Vec2 tp1 = project3DPoint(tc.P, p) + vEpipShift;
+            const LabColor gcr1 = rc.image->sample(rp1.x, rp1.y);
+            const LabColor gct1 = tc.image->sample(tp1.x, tp1.y);
+
+            // Yoon & Kweon weights: color difference and distance to the center of the patch
+            const float deltaP = std::sqrt(float(xp * xp + yp * yp));
+            const float w = std::exp(-(euclidean3(gcr, gcr1) / gammaC + deltaP / gammaP)) *
+                            std::exp(-(euclidean3(gct, gct1) / gammaC + deltaP / gammaP));
+
+            wsum += w;
+            xsum += w * gcr1.x;
+            ysum += w * gct1.x;
+            xxsum += w * gcr1.x * gcr1.x;
+            yysum += w * gct1.x * gct1.x;
+            xysum += w * gcr1.x * gct1.x;
+        }
+    }
+
+    const float varX = (xxsum - xsum * xsum / wsum) / wsum;
+    const float varY = (yysum - ysum * ysum / wsum) / wsum;
+    const float varXY = (xysum - xsum * ysum / wsum) / wsum;
+    float sim = varXY / std::sqrt(varX * varY);
+    sim = std::isinf(sim) ? 1.0f : 0.0f - sim;
+    return std::fmax(std::fmin(sim, 1.0f), -1.0f);
+}
+
+/**
+ * @brief Similarity of the pixel at the given depth, moved by a number of pixels (refine_compYKNCCSimMapPatch_kernel)
+ */
+inline float computeMovedSim(const CameraCpu& rc, const CameraCpu& tc, const Vec2& pix, float depth, float step,
+                             bool moveByTcOrRc, int wsh, int imWidth, int imHeight, float gammaC, float gammaP,
+                             float epipShift)
+{
+    if(depth <= 0.0f)
+        return 1.1f;
+
+    Vec3 p = get3DPointForPixelAndDepthFromRC(rc, pix, depth);
+    move3DPointByTcOrRcPixStep(rc, tc, p, step, moveByTcOrRc);
+
+    Patch ptch;
+    ptch.d = computePixSize(rc, p);
+    computeRotCSEpip(rc, tc, ptch, p);
+    return compNCCby3DptsYK(rc, tc, ptch, wsh, imWidth, imHeight, gammaC, gammaP, epipShift);
+}
+
+/**
+ * @brief Quadratic interpolation of the depth from the similarities at depth -1, 0, +1
+ * @return the refined depth or -1
+ */
+inline float refineDepthSubPixel(const Vec3& depths, const Vec3& sims)
+{
+    const float simM1 = (sims.x + 1.0f) / 2.0f;
+    const float sim1 = (sims.y + 1.0f) / 2.0f;
+    const float simP1 = (sims.z + 1.0f) / 2.0f;
+
+    if((simM1 > sim1) && (simP1 > sim1))
+    {
+        const float dispStep = -((simP1 - simM1) / (2.0f * (simP1 + simM1 - 2.0f * sim1)));
+        const float b = (depths.z + depths.x) / 2.0f;
+        const float a = b - depths.x;
+        return a * dispStep + b;
+    }
+    return -1.0f;
+}
+
+} // namespace
+float computeSweepVolume(const PlaneSweepingCamera& rc, const PlaneSweepingCamera& tc, int scale,
+                         int nDepthsToSearch, unsigned char* volume, int volDimX, int volDimY, int volDimZ,
+                         int volStepXY, int volLUX, int volLUY, int volLUZ, const StaticVector<float>& depths,
+                         const StaticVector<Voxel>& pixels, int wsh, float gammaC, float gammaP, float epipShift)
+{
+    const int w = rc.image->width();
+    const int h = rc.image->height();
+
+    const CameraCpu rcCam = makeCamera(rc, scale);
+    const CameraCpu tcCam = makeCamera(tc, scale);
+
+    const std::size_t sliceSize = static_cast<std::size_t>(volDimX) * volDimY;
+    std::fill(volume, volume + sliceSize * volDimZ, 255);
+
+    const int ndepths = depths.size();
+    const int npixs = pixels.size();
+    const int slicesAtTime = std::min(npixs, 4096);
+    std::vector<unsigned char> slice(static_cast<std::size_t>(slicesAtTime) * nDepthsToSearch);
+
+    for(int first = 0; first < npixs; first += slicesAtTime)
+    {
+        const int last = std::min(npixs, first + slicesAtTime);
+
+        // similarity of each pixel with all its depths
+#pragma omp parallel for schedule(dynamic, 16)
+        for(int i = first; i < last; ++i)
+        {
+            const Voxel& volPix = pixels[i];
+            const Vec2 pix = {(float)volPix.x, (float)volPix.y};
+            unsigned char* pixSlice = slice.data() + static_cast<std::size_t>(i - first) * nDepthsToSearch;
+
+            for(int sdptid = 0; sdptid < nDepthsToSearch; ++sdptid)
+            {
+                const int depthid = sdptid + volPix.z;
+                if(depthid >= ndepths)
+                    break;
+
+                Patch ptch;
+                const Vec3 p = get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, depths[depthid]);
+                ptch.d = computePixSize(rcCam, p);
+                computeRotCSEpip(rcCam, tcCam, ptch, p);
+
+                float fsim = compNCCby3DptsYK(rcCam, tcCam, ptch, wsh, w, h, gammaC, gammaP, epipShift);
+                fsim = std::fmin(1.0f, std::fmax(0.0f, (fsim + 1.0f) / 2.0f));
+                pixSlice[sdptid] = (unsigned char)(fsim * 255.0f);
+            }
+        }
+
+        // save to the volume
+        for(int i = first; i < last; ++i)
+        {
+            const Voxel& volPix = pixels[i];
+            const unsigned char* pixSlice = slice.data() + static_cast<std::size_t>(i - first) * nDepthsToSearch;
+            const int vx = (volPix.x - volLUX) / volStepXY;
+            const int vy = (volPix.y - volLUY) / volStepXY;
+            if((vx < 0) || (vx >= volDimX) || (vy < 0) || (vy >= volDimY))
+                continue;
+
+            for(int sdptid = 0; sdptid < nDepthsToSearch; ++sdptid)
+            {
+                const int depthid = sdptid + volPix.z;
+                if(depthid >= ndepths)
+                    break;
+                const int vz = depthid - volLUZ;
+                if((vz >= 0) && (vz < volDimZ))
+                {
+                    unsigned char& volsim = volume[vz * sliceSize + static_cast<std::size_t>(vy) * volDimX + vx];
+                    volsim = std::min(pixSlice[sdptid], volsim);
+                }
+            }
+        }
+    }
+
+    return (float)(sliceSize * volDimZ) / (1024.0f * 1024.0f);
+}
+
+void refineDepthMap(const PlaneSweepingCamera& rc, const PlaneSweepingCamera& tc, int scale, bool useTcOrRcPixSize,
+                    int nStepsToRefine, float* simMap, float* rcDepthMap, int wsh, float gammaC, float gammaP,
+                    float epipShift, int xFrom, int wPart)
+{
+    const int w = wPart;
+    const int imWidth = rc.image->width();
+    const int imHeight = rc.image->height();
+    const int h = imHeight;
+
+    const CameraCpu rcCam = makeCamera(rc, scale);
+    const CameraCpu tcCam = makeCamera(tc, scale);
+
+#pragma omp parallel for schedule(dynamic)
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const Vec2 pix = {(float)(x + xFrom), (float)y};
+            const float depth = rcDepthMap[y * w + x];
+
+            // best depth along the steps
+            float bestSim = 1.0f;
+            float bestDpt = depth;
+            for(int i = 0; i < nStepsToRefine; ++i)
+            {
+                float odpt = depth;
+                float osim = 1.0f;
+                if(odpt > 0.0f)
+                {
+                    Vec3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, odpt);
+                    move3DPointByTcOrRcPixStep(rcCam, tcCam, p, (float)(i - (nStepsToRefine - 1) / 2), useTcOrRcPixSize);
+                    odpt = size(p - rcCam.C);
+
+                    Patch ptch;
+                    ptch.d = computePixSize(rcCam, p);
+                    computeRotCSEpip(rcCam, tcCam, ptch, p);
+                    osim = compNCCby3DptsYK(rcCam, tcCam, ptch, wsh, imWidth, imHeight, gammaC, gammaP, epipShift);
+                }
+                if(i == 0 || osim < bestSim)
+                {
+                    bestSim = osim;
+                    bestDpt = odpt;
+                }
+            }
+
+            // sub-pixel refinement from the neighbor steps
+            Vec3 sims;
+            sims.x = computeMovedSim(rcCam, tcCam, pix, bestDpt, -1.0f, useTcOrRcPixSize, wsh, imWidth, imHeight, gammaC, gammaP, epipShift);
+            sims.y = bestSim;
+            sims.z = computeMovedSim(rcCam, tcCam, pix, bestDpt, +1.0f, useTcOrRcPixSize, wsh, imWidth, imHeight, gammaC, gammaP, epipShift);
+
+            float outDepth = bestDpt;
+            if(outDepth > 0.0f)
+            {
+                const Vec3 pMid = get3DPointForPixelAndDepthFromRC(rcCam, pix, bestDpt);
+                Vec3 pm1 = pMid;
+                Vec3 pp1 = pMid;
+                move3DPointByTcOrRcPixStep(rcCam, tcCam, pm1, -1.0f, useTcOrRcPixSize);
+                move3DPointByTcOrRcPixStep(rcCam, tcCam, pp1, +1.0f, useTcOrRcPixSize);
+
+                const Vec3 refineDepths = {size(pm1 - rcCam.C), bestDpt, size(pp1 - rcCam.C)};
+                const float refinedDepth = refineDepthSubPixel(refineDepths, sims);
+                if(refinedDepth > 0.0f)
+                    outDepth = refinedDepth;
+            }
+
+            simMap[y * w + x] = sims.y;
+            rcDepthMap[y * w + x] = outDepth;
+        }
+    }
+}
+
+void fuseDepthSimMaps(int w, int h, StaticVector<DepthSim>& oDepthSimMap,
+                      const StaticVector<StaticVector<DepthSim>*>& dataMaps, int nSamplesHalf, int nDepthsToRefine,
+                      float sigma)
+{
+    const float samplesPerPixSize = (float)(nSamplesHalf / ((nDepthsToRefine - 1) / 2));
+    const float twoTimesSigmaPowerTwo = 2.0f * sigma * sigma;
+    const int nSamples = 2 * nSamplesHalf + 1;
+    const int npixs = w * h;
+
+    const DepthSim* midDepthPixSizeMap = dataMaps[0]->getData().data();
+    DepthSim* oDepthSimMapPtr = oDepthSimMap.getDataWritable().data();
+
+#pragma omp parallel
+    {
+        std::vector<float> samples(nSamples);
+
+#pragma omp for
+        for(int i = 0; i < npixs; ++i)
+        {
+            const DepthSim& midDepthPixSize = midDepthPixSizeMap[i];
+            if(midDepthPixSize.depth <= 0.0f)
+            {
+                oDepthSimMapPtr[i] = DepthSim(-1.0f, 1.0f);
+                continue;
+            }
+
+            // Gaussian kernel voting of the tc depth maps for each depth sample around the mid depth
+            const float depthStep = midDepthPixSize.sim / samplesPerPixSize;
+            std::fill(samples.begin(), samples.end(), 0.0f);
+            for(int c = 1; c < dataMaps.size(); ++c)
+            {
+                const DepthSim& depthSim = (*dataMaps[c])[i];
+                if(depthSim.depth <= 0.0f)
+                    continue;
+
+                const float id = (midDepthPixSize.depth - depthSim.depth) / depthStep;
+                const float sim = -sigmoid(0.0f, 1.0f, 0.7f, -0.7f, depthSim.sim);
+                float* samplesPtr = samples.data();
+#pragma omp simd
+                for(int s = 0; s < nSamples; ++s)
+                {
+                    const float ds = id - (float)(s - nSamplesHalf);
+                    samplesPtr[s] += sim * std::exp(-(ds * ds) / twoTimesSigmaPowerTwo);
+                }
+            }
+
+            // first best sample
+            int bestS = 0;
+            for(int s = 1; s < nSamples; ++s)
+            {
+                if(samples[s] < samples[bestS])
+                    bestS = s;
+            }
+            oDepthSimMapPtr[i] = DepthSim(midDepthPixSize.depth - (float)(bestS - nSamplesHalf) * depthStep, samples[bestS]);
+        }
+    }
+}
+
+void optimizeDepthSimMap(const PlaneSweepingCamera& rc, StaticVector<DepthSim>& oDepthSimMap,
+                         const StaticVector<StaticVector<DepthSim>*>& dataMaps, int nIters, int yFrom, int hPart)
+{
+    const int w = rc.image->width();
+    const int h = hPart;
+
+    const LabImage& rcImage = *rc.image;
+    const CameraCpu rcCam = makeCamera(rc, 1);
+
+    const DepthSim* midDepthPixSizeMap = dataMaps[0]->getData().data() + static_cast<std::size_t>(yFrom) * w;
+    const DepthSim* fusedDepthSimMap = dataMaps[1]->getData().data() + static_cast<std::size_t>(yFrom) * w;
+    DepthSim* optDepthSimMap = oDepthSimMap.getDataWritable().data() + static_cast<std::size_t>(yFrom) * w;
+
+    std::copy(midDepthPixSizeMap, midDepthPixSizeMap + static_cast<std::size_t>(w) * h, optDepthSimMap);
+    std::vector<float> depthMap(static_cast<std::size_t>(w) * h);
+
+    // depths of the previous iteration, with clamped coordinates
+    const auto getDepth = [&](int x, int y) {
+        return depthMap[static_cast<std::size_t>(std::min(std::max(y, 0), h - 1)) * w + std::min(std::max(x, 0), w - 1)];
+    };
+
+    for(int iter = 0; iter < nIters; ++iter)
+    {
+        for(std::size_t i = 0; i < depthMap.size(); ++i)
+            depthMap[i] = optDepthSimMap[i].depth;
+
+#pragma omp parallel for
+        for(int y = 0; y < h; ++y)
+        {
+            for(int x = 0; x < w; ++x)
+            {
+                const std::size_t i = static_cast<std::size_t>(y) * w + x;
+                const DepthSim& midDepthPixSize = midDepthPixSizeMap[i];
+                const DepthSim& fusedDepthSim = fusedDepthSimMap[i];
+                DepthSim optDepthSim = (iter == 0) ? DepthSim(midDepthPixSize.depth, fusedDepthSim.sim) : optDepthSimMap[i];
+
+                const float depthOpt = optDepthSim.depth;
+                if(depthOpt > 0.0f)
+                {
+                    // smoothing step and energy from the neighbors (getCellSmoothStepEnergy)
+                    // note: as in the CUDA kernel, the 3D points are computed from the coordinates in the part
+                    float depthSmoothStep = 0.0f;
+                    float depthSmoothVal = 180.0f;
+                    {
+                        const float d0 = getDepth(x, y);
+                        const float dL = getDepth(x, y - 1);
+                        const float dR = getDepth(x, y + 1);
+                        const float dU = getDepth(x - 1, y);
+                        const float dB = getDepth(x + 1, y);
+                        if(d0 > 0.0f)
+                        {
+                            const Vec3 p0 = get3DPointForPixelAndDepthFromRC(rcCam, {(float)x, (float)y}, d0);
+                            const Vec3 pL = get3DPointForPixelAndDepthFromRC(rcCam, {(float)x, (float)(y - 1)}, dL);
+                            const Vec3 pR = get3DPointForPixelAndDepthFromRC(rcCam, {(float)x, (float)(y + 1)}, dR);
+                            const Vec3 pU = get3DPointForPixelAndDepthFromRC(rcCam, {(float)(x - 1), (float)y}, dU);
+                            const Vec3 pB = get3DPointForPixelAndDepthFromRC(rcCam, {(float)(x + 1), (float)y}, dB);
+
+                            Vec3 cg = {0.0f, 0.0f, 0.0f};
+                            float n = 0.0f;
+                            if(dL > 0.0f) { cg = cg + pL; n++; }
+                            if(dR > 0.0f) { cg = cg + pR; n++; }
+                            if(dU > 0.0f) { cg = cg + pU; n++; }
+                            if(dB > 0.0f) { cg = cg + pB; n++; }
+                            if(n > 1.0f)
+                            {
+                                cg = cg / n;
+                                const Vec3 pS = closestPointToLine3D(cg, p0, normalized(rcCam.C - p0));
+                                depthSmoothStep = size(rcCam.C - pS) - d0;
+                            }
+
+                            float e = 0.0f;
+                            n = 0.0f;
+                            if(dL > 0.0f && dR > 0.0f)
+                            {
+                                e = std::fmax(e, (180.0f - angleBetwABandAC(p0, pL, pR)));
+                                n++;
+                            }
+                            if(dU > 0.0f && dB > 0.0f)
+                            {
+                                e = std::fmax(e, (180.0f - angleBetwABandAC(p0, pU, pB)));
+                                n++;
+                            }
+                            if(n > 0.0f)
+                                depthSmoothVal = e;
+                        }
+                    }
+
+                    const float maxStep = midDepthPixSize.sim / 10.0f;
+                    depthSmoothStep = std::copysign(std::fmin(std::fabs(depthSmoothStep), maxStep), depthSmoothStep);
+                    float depthPhotoStep = fusedDepthSim.depth - depthOpt;
+                    depthPhotoStep = std::copysign(std::fmin(std::fabs(depthPhotoStep), maxStep), depthPhotoStep);
+                    const float depthVisStep = midDepthPixSize.depth - depthOpt;
+                    const float depthPhotoStepVal = fusedDepthSim.sim;
+
+                    const float varianceGray = rcImage.sample(x, y + yFrom).w;
+                    const float varianceGrayAndleWeight = sigmoid2(5.0f, 30.0f, 40.0f, 20.0f, varianceGray);
+                    const float simWeight = sigmoid(0.0f, 1.0f, 0.7f, -0.7f, depthPhotoStepVal);
+                    const float photoWeight = sigmoid(0.0f, 1.0f, 30.0f, varianceGrayAndleWeight, depthSmoothVal);
+                    const float smoothWeight = 1.0f - photoWeight;
+                    const float visWeight = 1.0f - sigmoid(0.0f, 1.0f, 10.0f, 17.0f, std::fabs(depthVisStep / midDepthPixSize.sim));
+
+                    const float depthOptStep = visWeight * depthVisStep + (1.0f - visWeight) * (photoWeight * simWeight * depthPhotoStep + smoothWeight * depthSmoothStep);
+
+                    optDepthSim.depth = depthOpt + depthOptStep;
+                    optDepthSim.sim = (1.0f - visWeight) * photoWeight * simWeight * depthPhotoStepVal + (1.0f - visWeight) * smoothWeight * (depthSmoothVal / 20.0f);
+                }
+                optDepthSimMap[i] = optDepthSim;
+            }
+        }
+    }
+}
+
+} // namespace depthMap
+} // namespace aliceVision
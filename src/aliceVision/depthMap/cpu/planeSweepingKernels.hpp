@@ -0,0 +1,86 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+#include <aliceVision/depthMap/DepthSimMap.hpp>
+#include <aliceVision/depthMap/cpu/LabImage.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Camera used by the CPU kernels.
+ *
+ * The matrices are given at scale 1 (as in MultiViewParams), the image is the pyramid level of the processing scale.
+ */
+struct PlaneSweepingCamera
+{
+    Matrix3x3 K;
+    Matrix3x3 R;
+    Point3d C;
+    const LabImage* image = nullptr;
+};
+
+/**
+ * @brief CPU version of ps_computeSimilarityVolume.
+ *
+ * Similarity of each pixel with the target camera for the fronto-parallel planes of the given depths,
+ * stored as (sim + 1) / 2 * 255 (0 is the best similarity) and merged with a min in \p volume.
+ *
+ * @param[in] rc the reference camera
+ * @param[in] tc the target camera
+ * @param[in] scale the processing scale (scale of the camera images)
+ * @param[in] nDepthsToSearch number of depths to compute for each pixel, from the depth index of the pixel (voxel z)
+ * @param[out] volume the similarity volume (X, Y, Z), Z being the depth
+ * @param[in] depths the depths of the planes
+ * @param[in] pixels the pixels to compute (x, y) and their first depth index (z)
+ * @return the size of the volume in MB
+ */
+float computeSweepVolume(const PlaneSweepingCamera& rc, const PlaneSweepingCamera& tc, int scale,
+                         int nDepthsToSearch, unsigned char* volume, int volDimX, int volDimY, int volDimZ,
+                         int volStepXY, int volLUX, int volLUY, int volLUZ, const StaticVector<float>& depths,
+                         const StaticVector<Voxel>& pixels, int wsh, float gammaC, float gammaP, float epipShift);
+
+/**
+ * @brief CPU version of ps_refineRcDepthMap.
+ *
+ * Search the best similarity with the target camera in the nStepsToRefine pixel steps around the depth of each
+ * pixel, then refine the best depth with a quadratic interpolation of the similarities of its neighbor steps.
+ *
+ * @param[inout] rcDepthMap the depths of the wPart columns starting at xFrom, replaced by the refined depths
+ * @param[out] simMap the similarities of the refined depths
+ */
+void refineDepthMap(const PlaneSweepingCamera& rc, const PlaneSweepingCamera& tc, int scale, bool useTcOrRcPixSize,
+                    int nStepsToRefine, float* simMap, float* rcDepthMap, int wsh, float gammaC, float gammaP,
+                    float epipShift, int xFrom, int wPart);
+
+/**
+ * @brief CPU version of ps_fuseDepthSimMapsGaussianKernelVoting.
+ *
+ * @param[out] oDepthSimMap the fused depth and similarity of each pixel, (-1, 1) if the mid depth is invalid
+ * @param[in] dataMaps the mid depth and pixel size (in sim) map, followed by the depth/sim maps to fuse
+ */
+void fuseDepthSimMaps(int w, int h, StaticVector<DepthSim>& oDepthSimMap,
+                      const StaticVector<StaticVector<DepthSim>*>& dataMaps, int nSamplesHalf, int nDepthsToRefine,
+                      float sigma);
+
+/**
+ * @brief CPU version of ps_optimizeDepthSimMapGradientDescent.
+ *
+ * @param[in] rc the reference camera, with the image at scale 1 (the w channel holds the gradient size of L)
+ * @param[out] oDepthSimMap the optimized depth and similarity of the hPart rows starting at yFrom
+ * @param[in] dataMaps the mid depth and pixel size (in sim) map and the fused depth/sim map
+ */
+void optimizeDepthSimMap(const PlaneSweepingCamera& rc, StaticVector<DepthSim>& oDepthSimMap,
+                         const StaticVector<StaticVector<DepthSim>*>& dataMaps, int nIters, int yFrom, int hPart);
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,281 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/depthMap/cpu/LabImage.hpp>
+#include <aliceVision/depthMap/cpu/planeSweepingKernels.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#define BOOST_TEST_MODULE planeSweepingKernels
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::depthMap;
+
+// Two cameras with the same orientation (looking along +Z), separated by a baseline along X,
+// in front of a textured fronto-parallel plane at depth planeDepth.
+// The disparity between the two images is focal * baseline / depth = 5 pixels on the plane.
+const int width = 64;
+const int height = 48;
+const double focal = 50.0;
+const double baseline = 0.4;
+const double planeDepth = 4.0;
+
+PlaneSweepingCamera createCamera(double cx, const LabImage* image)
+{
+    PlaneSweepingCamera camera;
+    camera.K.m11 = focal;
+    camera.K.m13 = width / 2.0;
+    camera.K.m22 = focal;
+    camera.K.m23 = height / 2.0;
+    camera.K.m33 = 1.0;
+    camera.R.m11 = 1.0;
+    camera.R.m22 = 1.0;
+    camera.R.m33 = 1.0;
+    camera.C = Point3d(cx, 0.0, 0.0);
+    camera.image = image;
+    return camera;
+}
+
+/**
+ * @brief Image of the textured plane seen by a camera of the scene.
+ *        The texture has no period in the sweep range, so the plane is the only match.
+ */
+LabImage renderPlane(double cx)
+{
+    LabImage image(width, height);
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const double X = cx + (x - width / 2.0) / focal * planeDepth;
+            const double Y = (y - height / 2.0) / focal * planeDepth;
+            const double L = 128.0 + 50.0 * std::sin(X / 0.07 + 0.3) + 40.0 * std::sin(Y / 0.06) +
+                             30.0 * std::sin((X + Y) / 0.11);
+            LabPixel& p = image.at(x, y);
+            p.x = static_cast<unsigned char>(std::lround(L));
+            p.y = 128;
+            p.z = 128;
+        }
+    }
+    return image;
+}
+
+/// Distance from the camera center to the plane along the ray of the pixel
+float planeDistance(int x, int y)
+{
+    const double vx = (x - width / 2.0) / focal;
+    const double vy = (y - height / 2.0) / focal;
+    return static_cast<float>(planeDepth * std::sqrt(vx * vx + vy * vy + 1.0));
+}
+
+/// Depth along Z of a point at the given distance on the ray of the pixel
+double distanceToDepth(int x, int y, double distance)
+{
+    return distance * planeDepth / planeDistance(x, y);
+}
+
+/**
+ * @brief Sweep fronto-parallel planes around the textured plane.
+ *        The best similarity of every pixel that can be compared is on the plane depth.
+ */
+BOOST_AUTO_TEST_CASE(planeSweepingKernels_sweepFrontoParallelPlane)
+{
+    const LabImage rcImage = renderPlane(0.0);
+    const LabImage tcImage = renderPlane(baseline);
+    const PlaneSweepingCamera rc = createCamera(0.0, &rcImage);
+    const PlaneSweepingCamera tc = createCamera(baseline, &tcImage);
+
+    // disparities from 6.67 to 3.64 pixels, the plane is depth 4
+    StaticVector<float> depths;
+    depths.reserve(11);
+    for(int d = 0; d < 11; ++d)
+        depths.push_back(3.0f + 0.25f * d);
+    const int planeDepthId = 4;
+
+    // the pixels whose patches are in both images (borders of wsh + 2 pixels and 7 pixels of disparity)
+    const int wsh = 4;
+    const int xMin = 16;
+    const int xMax = width - 8;
+    const int yMin = 8;
+    const int yMax = height - 8;
+    StaticVector<Voxel> pixels;
+    pixels.reserve((xMax - xMin) * (yMax - yMin));
+    for(int y = yMin; y < yMax; ++y)
+        for(int x = xMin; x < xMax; ++x)
+            pixels.push_back(Voxel(x, y, 0));
+
+    // the texture only has variations of L: large gammaC for uniform color weights
+    std::vector<unsigned char> volume(static_cast<std::size_t>(width) * height * depths.size());
+    computeSweepVolume(rc, tc, 1, depths.size(), volume.data(), width, height, depths.size(), 1, 0, 0, 0, depths,
+                       pixels, wsh, 100.0f, 8.0f, 0.0f);
+
+    const auto sim = [&](int x, int y, int z) { return volume[(static_cast<std::size_t>(z) * height + y) * width + x]; };
+
+    int nbWrongDepths = 0;
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const bool computed = (x >= xMin && x < xMax && y >= yMin && y < yMax);
+            if(!computed)
+            {
+                // not computed: worst similarity
+                for(int z = 0; z < depths.size(); ++z)
+                    BOOST_CHECK_EQUAL(sim(x, y, z), 255);
+                continue;
+            }
+            // on the plane, the patches almost match: they are orthogonal to the viewing rays, not to Z
+            BOOST_CHECK_LE(sim(x, y, planeDepthId), 1);
+            for(int z = 0; z < depths.size(); ++z)
+                nbWrongDepths += (z != planeDepthId && sim(x, y, z) <= sim(x, y, planeDepthId));
+        }
+    }
+    BOOST_CHECK_EQUAL(nbWrongDepths, 0);
+}
+
+/**
+ * @brief Refine depths with an error of 1.3 pixels of disparity.
+ *        The best step is 0.3 pixel from the plane, the sub-pixel refinement gets below 0.2 pixel.
+ */
+BOOST_AUTO_TEST_CASE(planeSweepingKernels_refineFrontoParallelPlane)
+{
+    const LabImage rcImage = renderPlane(0.0);
+    const LabImage tcImage = renderPlane(baseline);
+    const PlaneSweepingCamera rc = createCamera(0.0, &rcImage);
+    const PlaneSweepingCamera tc = createCamera(baseline, &tcImage);
+
+    const double planeDisparity = focal * baseline / planeDepth;
+    const double initDepth = focal * baseline / (planeDisparity + 1.3);
+
+    // refine the columns of the pixels whose patches are in both images
+    const int xFrom = 16;
+    const int wPart = width - 8 - xFrom;
+    std::vector<float> depthMap(static_cast<std::size_t>(wPart) * height);
+    std::vector<float> simMap(depthMap.size(), 0.0f);
+    for(int y = 0; y < height; ++y)
+        for(int x = 0; x < wPart; ++x)
+            depthMap[y * wPart + x] = static_cast<float>(initDepth / planeDepth) * planeDistance(x + xFrom, y);
+
+    refineDepthMap(rc, tc, 1, true, 5, simMap.data(), depthMap.data(), 4, 100.0f, 8.0f, 0.0f, xFrom, wPart);
+
+    for(int y = 8; y < height - 8; ++y)
+    {
+        for(int x = 0; x < wPart; ++x)
+        {
+            const double disparity = focal * baseline / distanceToDepth(x + xFrom, y, depthMap[y * wPart + x]);
+            BOOST_CHECK_SMALL(disparity - planeDisparity, 0.2);
+            // similarity of the best step
+            BOOST_CHECK_LT(simMap[y * wPart + x], -0.9f);
+        }
+    }
+}
+
+/**
+ * @brief Fuse 3 consistent depth maps and 1 outlier around a mid depth of 10 with a pixel size of 0.3.
+ *
+ * With nSamplesHalf = 50 and nDepthsToRefine = 31, the samples per pixel size are 50 / 15 = 3 (integers),
+ * so the depth step is 0.1 and the fused depth 10.5 is the sample -5.
+ * Each consistent map votes -sigmoid(0, 1, 0.7, -0.7, -1) = -1 / (1 + exp(-30 / 7)) on its sample.
+ * The outlier at 12 is 20 samples away: its vote is negligible with sigma = 2.
+ */
+BOOST_AUTO_TEST_CASE(planeSweepingKernels_fuseConsistentDepthMaps)
+{
+    const int w = 3;
+    const int h = 2;
+    const int npixs = w * h;
+
+    // pixel 0 has an invalid mid depth
+    StaticVector<DepthSim> midDepthPixSizeMap;
+    midDepthPixSizeMap.resize_with(npixs, DepthSim(10.0f, 0.3f));
+    midDepthPixSizeMap[0] = DepthSim(-1.0f, 0.3f);
+
+    StaticVector<DepthSim> consistentMap;
+    consistentMap.resize_with(npixs, DepthSim(10.5f, -1.0f));
+    StaticVector<DepthSim> outlierMap;
+    outlierMap.resize_with(npixs, DepthSim(12.0f, -1.0f));
+    // pixel 1 has no outlier, pixel 2 only has an invalid depth in the outlier map
+    outlierMap[1] = DepthSim(10.5f, -1.0f);
+    outlierMap[2] = DepthSim(-1.0f, -1.0f);
+
+    StaticVector<StaticVector<DepthSim>*> dataMaps;
+    dataMaps.reserve(5);
+    dataMaps.push_back(&midDepthPixSizeMap);
+    dataMaps.push_back(&consistentMap);
+    dataMaps.push_back(&outlierMap);
+    dataMaps.push_back(&consistentMap);
+    dataMaps.push_back(&consistentMap);
+
+    StaticVector<DepthSim> fusedMap;
+    fusedMap.resize(npixs);
+    fuseDepthSimMaps(w, h, fusedMap, dataMaps, 50, 31, 2.0f);
+
+    const float vote = -1.0f / (1.0f + std::exp(-30.0f / 7.0f));
+
+    BOOST_CHECK_EQUAL(fusedMap[0].depth, -1.0f);
+    BOOST_CHECK_EQUAL(fusedMap[0].sim, 1.0f);
+
+    BOOST_CHECK_CLOSE(fusedMap[1].depth, 10.5f, 1e-4);
+    BOOST_CHECK_CLOSE(fusedMap[1].sim, 4.0f * vote, 1e-3);
+
+    for(int i = 2; i < npixs; ++i)
+    {
+        BOOST_CHECK_CLOSE(fusedMap[i].depth, 10.5f, 1e-4);
+        BOOST_CHECK_CLOSE(fusedMap[i].sim, 3.0f * vote, 1e-3);
+    }
+}
+
+/**
+ * @brief Optimize the depths of the textured plane.
+ *
+ * The smoothing step of a fronto-parallel plane is null, so:
+ * - when the fused depths are the plane, the depths do not move;
+ * - when the fused depths are further by 5% of the pixel size (less than the maximum step), the depths
+ *   converge to the fused depths.
+ * The clamped borders are not planar, so only the pixels further than nIters from the borders are checked.
+ */
+BOOST_AUTO_TEST_CASE(planeSweepingKernels_optimizePlane)
+{
+    std::vector<LabImage> pyramid;
+    buildLabPyramid(renderPlane(0.0), 1, 4, pyramid);
+    const PlaneSweepingCamera rc = createCamera(0.0, &pyramid[0]);
+
+    const int nIters = 10;
+    const int npixs = width * height;
+    const float pixSize = static_cast<float>(planeDepth / focal);
+
+    for(const float offset : {0.0f, 0.05f * pixSize})
+    {
+        StaticVector<DepthSim> midDepthPixSizeMap;
+        midDepthPixSizeMap.resize(npixs);
+        StaticVector<DepthSim> fusedMap;
+        fusedMap.resize(npixs);
+        for(int y = 0; y < height; ++y)
+        {
+            for(int x = 0; x < width; ++x)
+            {
+                midDepthPixSizeMap[y * width + x] = DepthSim(planeDistance(x, y), pixSize);
+                fusedMap[y * width + x] = DepthSim(planeDistance(x, y) + offset, -1.0f);
+            }
+        }
+
+        StaticVector<StaticVector<DepthSim>*> dataMaps;
+        dataMaps.reserve(2);
+        dataMaps.push_back(&midDepthPixSizeMap);
+        dataMaps.push_back(&fusedMap);
+
+        StaticVector<DepthSim> optimizedMap;
+        optimizedMap.resize(npixs);
+        optimizeDepthSimMap(rc, optimizedMap, dataMaps, nIters, 0, height);
+
+        for(int y = nIters + 1; y < height - nIters - 1; ++y)
+            for(int x = nIters + 1; x < width - nIters - 1; ++x)
+                BOOST_CHECK_SMALL(optimizedMap[y * width + x].depth - fusedMap[y * width + x].depth, 1e-3f * pixSize);
+    }
+}
@@ -0,0 +1,236 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "sgmVolume.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+/// Number of X coordinates processed together by the Y paths
+const int blockSizeX = 64;
+
+/**
+ * @brief Adaptive P2 penalty from the color difference between two consecutive pixels of the path
+ *        15 + (255 - 15) * (1 / (1 + exp(10 * ((deltaC - 20) / 80))))
+ */
+inline unsigned int adaptiveP2(const LabColor& c0, const LabColor& c1)
+{
+    const float deltaC = euclidean3(c0, c1);
+    return static_cast<unsigned int>(15.0f + (255.0f - 15.0f) * (1.0f / (1.0f + std::exp(10.0f * ((deltaC - 20.0f) / 80.0f)))));
+}
+
+/**
+ * @brief Running average of the aggregated paths: out = (out * npaths + cost) / (npaths + 1)
+ */
+inline unsigned char updateAverage(unsigned char out, unsigned int cost, int npaths)
+{
+    const float val = (static_cast<float>(out) * npaths + static_cast<float>(std::min(cost, 255u))) / static_cast<float>(npaths + 1);
+    return static_cast<unsigned char>(std::fmin(255.0f, val));
+}
+
+/**
+ * @brief Cost update of one step of a path for n independent scanlines (labels are strided by n)
+ * @param[in] sim similarity of the current step, sim[z * simStride + i]
+ * @param[in] prev path costs of the previous step, prev[z * n + i]
+ * @param[out] cur path costs of the current step, cur[z * n + i]
+ */
+void updatePathCosts(const unsigned char* sim, std::size_t simStride, const unsigned int* prev, unsigned int* cur,
+                     const unsigned int* bestPrev, const unsigned int* P2, unsigned int P1, int n, int volDimZ)
+{
+    // the first and last labels are not aggregated
+    for(int i = 0; i < n; ++i)
+    {
+        cur[i] = 255;
+        cur[(volDimZ - 1) * n + i] = 255;
+    }
+
+    for(int z = 1; z < volDimZ - 1; ++z)
+    {
+        const unsigned char* simZ = sim + z * simStride;
+        const unsigned int* prevZ = prev + z * n;
+        unsigned int* curZ = cur + z * n;
+
+#pragma omp simd
+        for(int i = 0; i < n; ++i)
+        {
+            unsigned int minCost = std::min(prevZ[i], prevZ[i - n] + P1);
+            minCost = std::min(minCost, prevZ[i + n] + P1);
+            minCost = std::min(minCost, bestPrev[i] + P2[i]);
+            curZ[i] = simZ[i] + minCost - bestPrev[i];
+        }
+    }
+}
+
+/**
+ * @brief Path along Y (increasing or decreasing) for the columns [x0, x0 + n)
+ */
+void aggregatePathY(const LabImage& rcImage, const unsigned char* simVolume, unsigned char* volume, int x0, int n,
+                    int volDimX, int volDimY, int volDimZ, unsigned int P1, bool invY, int npaths,
+                    std::vector<unsigned int>& prev, std::vector<unsigned int>& cur,
+                    std::vector<unsigned int>& bestPrev, std::vector<unsigned int>& P2)
+{
+    const std::size_t sliceSize = static_cast<std::size_t>(volDimX) * volDimY;
+
+    for(int t = 0; t < volDimY; ++t)
+    {
+        const int y = invY ? volDimY - 1 - t : t;
+        const unsigned char* sim = simVolume + static_cast<std::size_t>(y) * volDimX + x0;
+
+        if(t == 0)
+        {
+            // the first plane of the path is not aggregated
+            for(int z = 0; z < volDimZ; ++z)
+            {
+                unsigned char* out = volume + z * sliceSize + static_cast<std::size_t>(y) * volDimX + x0;
+                for(int i = 0; i < n; ++i)
+                {
+                    prev[z * n + i] = sim[z * sliceSize + i];
+                    out[i] = updateAverage(out[i], 255, npaths);
+                }
+            }
+            continue;
+        }
+
+        // same image coordinates as the CUDA kernel (shifted by one pixel for the reversed paths)
+        const int imY0 = invY ? volDimY - t : t;
+        const int imY1 = invY ? imY0 + 1 : imY0 - 1;
+        for(int i = 0; i < n; ++i)
+        {
+            P2[i] = adaptiveP2(rcImage.sample(x0 + i, imY0), rcImage.sample(x0 + i, imY1));
+            unsigned int best = prev[i];
+            for(int z = 1; z < volDimZ; ++z)
+                best = std::min(best, prev[z * n + i]);
+            bestPrev[i] = best;
+        }
+
+        updatePathCosts(sim, sliceSize, prev.data(), cur.data(), bestPrev.data(), P2.data(), P1, n, volDimZ);
+
+        for(int z = 0; z < volDimZ; ++z)
+        {
+            unsigned char* out = volume + z * sliceSize + static_cast<std::size_t>(y) * volDimX + x0;
+            const unsigned int* curZ = cur.data() + z * n;
+#pragma omp simd
+            for(int i = 0; i < n; ++i)
+                out[i] = updateAverage(out[i], curZ[i], npaths);
+        }
+        std::swap(prev, cur);
+    }
+}
+
+/**
+ * @brief Path along X (increasing or decreasing) for the row y, on the transposed slice (depth contiguous)
+ */
+void aggregatePathX(const LabImage& rcImage, const std::vector<unsigned char>& simSlice,
+                    std::vector<unsigned char>& outSlice, int y, int volDimX, int volDimZ, unsigned int P1,
+                    bool invX, int npaths, std::vector<unsigned int>& prev, std::vector<unsigned int>& cur)
+{
+    for(int t = 0; t < volDimX; ++t)
+    {
+        const int x = invX ? volDimX - 1 - t : t;
+        const unsigned char* sim = simSlice.data() + static_cast<std::size_t>(x) * volDimZ;
+        unsigned char* out = outSlice.data() + static_cast<std::size_t>(x) * volDimZ;
+
+        if(t == 0)
+        {
+            for(int z = 0; z < volDimZ; ++z)
+            {
+                prev[z] = sim[z];
+                out[z] = updateAverage(out[z], 255, npaths);
+            }
+            continue;
+        }
+
+        // same image coordinates as the CUDA kernel (shifted by one pixel for the reversed paths)
+        const int imX0 = invX ? volDimX - t : t;
+        const int imX1 = invX ? imX0 + 1 : imX0 - 1;
+        const unsigned int P2 = adaptiveP2(rcImage.sample(imX0, y), rcImage.sample(imX1, y));
+        const unsigned int bestPrev = *std::min_element(prev.begin(), prev.end());
+
+        updatePathCosts(sim, 1, prev.data(), cur.data(), &bestPrev, &P2, P1, 1, volDimZ);
+
+#pragma omp simd
+        for(int z = 0; z < volDimZ; ++z)
+            out[z] = updateAverage(out[z], cur[z], npaths);
+        std::swap(prev, cur);
+    }
+}
+
+} // namespace
+
+void sgmOptimizeSimVolume(const LabImage& rcImage, unsigned char* volume, int volDimX, int volDimY, int volDimZ,
+                          unsigned char P1)
+{
+    const std::size_t sliceSize = static_cast<std::size_t>(volDimX) * volDimY;
+    // the aggregation reads the input similarities and writes the average of the paths in the volume
+    const std::vector<unsigned char> simVolume(volume, volume + sliceSize * volDimZ);
+
+    // Y paths: independent blocks of columns
+    const int nbBlocksX = (volDimX + blockSizeX - 1) / blockSizeX;
+
+#pragma omp parallel
+    {
+        std::vector<unsigned int> prev(static_cast<std::size_t>(blockSizeX) * volDimZ);
+        std::vector<unsigned int> cur(static_cast<std::size_t>(blockSizeX) * volDimZ);
+        std::vector<unsigned int> bestPrev(blockSizeX);
+        std::vector<unsigned int> P2(blockSizeX);
+
+#pragma omp for schedule(dynamic)
+        for(int b = 0; b < nbBlocksX; ++b)
+        {
+            const int x0 = b * blockSizeX;
+            const int n = std::min(blockSizeX, volDimX - x0);
+            aggregatePathY(rcImage, simVolume.data(), volume, x0, n, volDimX, volDimY, volDimZ, P1, false, 0,
+                           prev, cur, bestPrev, P2);
+            aggregatePathY(rcImage, simVolume.data(), volume, x0, n, volDimX, volDimY, volDimZ, P1, true, 1,
+                           prev, cur, bestPrev, P2);
+        }
+    }
+
+    // X paths: independent rows, on transposed XZ slices
+#pragma omp parallel
+    {
+        std::vector<unsigned char> simSlice(static_cast<std::size_t>(volDimX) * volDimZ);
+        std::vector<unsigned char> outSlice(static_cast<std::size_t>(volDimX) * volDimZ);
+        std::vector<unsigned int> prev(volDimZ);
+        std::vector<unsigned int> cur(volDimZ);
+
+#pragma omp for schedule(dynamic)
+        for(int y = 0; y < volDimY; ++y)
+        {
+            for(int z = 0; z < volDimZ; ++z)
+            {
+                const unsigned char* sim = simVolume.data() + z * sliceSize + static_cast<std::size_t>(y) * volDimX;
+                const unsigned char* out = volume + z * sliceSize + static_cast<std::size_t>(y) * volDimX;
+                for(int x = 0; x < volDimX; ++x)
+                {
+                    simSlice[static_cast<std::size_t>(x) * volDimZ + z] = sim[x];
+                    outSlice[static_cast<std::size_t>(x) * volDimZ + z] = out[x];
+                }
+            }
+
+            aggregatePathX(rcImage, simSlice, outSlice, y, volDimX, volDimZ, P1, false, 2, prev, cur);
+            aggregatePathX(rcImage, simSlice, outSlice, y, volDimX, volDimZ, P1, true, 3, prev, cur);
+
+            for(int z = 0; z < volDimZ; ++z)
+            {
+                unsigned char* out = volume + z * sliceSize + static_cast<std::size_t>(y) * volDimX;
+                for(int x = 0; x < volDimX; ++x)
+                    out[x] = outSlice[static_cast<std::size_t>(x) * volDimZ + z];
+            }
+        }
+    }
+}
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,35 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/depthMap/cpu/LabImage.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief CPU version of ps_SGMoptimizeSimVolume.
+ *
+ * Aggregate the similarity volume along the 4 paths (+Y, -Y, +X, -X) with depth as the label
+ * and store the running average of the 4 aggregated volumes in \p volume (same results as the CUDA kernels).
+ * The P2 penalty is adaptive (sigmoid of the color difference between consecutive pixels), as in the CUDA kernels.
+ *
+ * The independent scanlines are distributed over the threads and the cost updates are vectorized:
+ * over the X coordinates for the Y paths, over the depths (on a transposed XZ slice) for the X paths.
+ *
+ * @param[in] rcImage the reference image (Lab) at the scale of the volume
+ * @param[inout] volume the similarity volume (X, Y, Z), Z being the depth
+ * @param[in] volDimX volume size along X
+ * @param[in] volDimY volume size along Y
+ * @param[in] volDimZ volume size along Z
+ * @param[in] P1 penalty for depth changes of one label
+ */
+void sgmOptimizeSimVolume(const LabImage& rcImage, unsigned char* volume, int volDimX, int volDimY, int volDimZ,
+                          unsigned char P1);
+
+} // namespace depthMap
+} // namespace aliceVision
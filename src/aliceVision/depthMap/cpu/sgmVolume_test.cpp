@@ -0,0 +1,222 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/depthMap/cpu/LabImage.hpp>
+#include <aliceVision/depthMap/cpu/sgmVolume.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <utility>
+#include <vector>
+
+#define BOOST_TEST_MODULE sgmVolume
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::depthMap;
+
+/**
+ * @brief Straightforward port of the CUDA implementation (ps_SGMoptimizeSimVolume):
+ *        transposition of the volume for each path, reversal of the Z planes, aggregation plane by plane
+ *        and transposition back to the average volume.
+ */
+void referenceSGM(const LabImage& image, std::vector<unsigned char>& volume, int volDimX, int volDimY, int volDimZ,
+                  unsigned int P1)
+{
+    const int volDims[3] = {volDimX, volDimY, volDimZ};
+    const std::vector<unsigned char> volSim = volume;
+    std::vector<unsigned char> volAgr(volume.size(), 0);
+
+    const int paths[4][4] = {{0, 2, 1, 0}, {0, 2, 1, 1}, {1, 2, 0, 0}, {1, 2, 0, 1}};
+    for(int npaths = 0; npaths < 4; ++npaths)
+    {
+        const int* dimsTrn = paths[npaths];
+        const bool invZ = paths[npaths][3] != 0;
+        const int dimX = volDims[dimsTrn[0]];
+        const int dimY = volDims[dimsTrn[1]];
+        const int dimZ = volDims[dimsTrn[2]];
+        const auto indexT = [&](int x, int y, int z) { return (static_cast<std::size_t>(z) * dimY + y) * dimX + x; };
+
+        std::vector<unsigned char> volT(volume.size());
+        for(int z = 0; z < volDimZ; ++z)
+            for(int y = 0; y < volDimY; ++y)
+                for(int x = 0; x < volDimX; ++x)
+                {
+                    const int v[3] = {x, y, z};
+                    volT[indexT(v[dimsTrn[0]], v[dimsTrn[1]], v[dimsTrn[2]])] =
+                        volSim[(static_cast<std::size_t>(z) * volDimY + y) * volDimX + x];
+                }
+
+        const auto shiftZ = [&]() {
+            for(int z = 0; z < dimZ / 2; ++z)
+                for(int y = 0; y < dimY; ++y)
+                    for(int x = 0; x < dimX; ++x)
+                        std::swap(volT[indexT(x, y, z)], volT[indexT(x, y, dimZ - 1 - z)]);
+        };
+        if(invZ)
+            shiftZ();
+
+        // aggregate path volume
+        std::vector<unsigned int> sliceZ(static_cast<std::size_t>(dimX) * dimY);
+        for(int y = 0; y < dimY; ++y)
+            for(int x = 0; x < dimX; ++x)
+            {
+                sliceZ[y * dimX + x] = volT[indexT(x, y, 0)];
+                volT[indexT(x, y, 0)] = 255;
+            }
+        for(int z = 1; z < dimZ; ++z)
+        {
+            const std::vector<unsigned int> sliceZM1 = sliceZ;
+            std::vector<unsigned int> bestInCol(dimX);
+            for(int x = 0; x < dimX; ++x)
+            {
+                bestInCol[x] = sliceZM1[x];
+                for(int y = 0; y < dimY; ++y)
+                    bestInCol[x] = std::min(bestInCol[x], sliceZM1[y * dimX + x]);
+            }
+            for(int y = 0; y < dimY; ++y)
+            {
+                for(int x = 0; x < dimX; ++x)
+                {
+                    const unsigned int sim = volT[indexT(x, y, z)];
+                    unsigned int pathCost = 255;
+                    if((y >= 1) && (y < dimY - 1))
+                    {
+                        const int zc = invZ ? dimZ - z : z;
+                        const int z1 = invZ ? zc + 1 : zc - 1;
+                        const LabPixel& c0 = image.fetch(dimsTrn[0] == 0 ? x : zc, dimsTrn[0] == 0 ? zc : x);
+                        const LabPixel& c1 = image.fetch(dimsTrn[0] == 0 ? x : z1, dimsTrn[0] == 0 ? z1 : x);
+                        const float deltaC = std::sqrt(float((c0.x - c1.x) * (c0.x - c1.x) + (c0.y - c1.y) * (c0.y - c1.y) +
+                                                             (c0.z - c1.z) * (c0.z - c1.z)));
+                        const unsigned int P2 = (unsigned int)(15.0f + (255.0f - 15.0f) * (1.0f / (1.0f + std::exp(10.0f * ((deltaC - 20.0f) / 80.0f)))));
+
+                        unsigned int minCost = std::min(sliceZM1[y * dimX + x], sliceZM1[(y - 1) * dimX + x] + P1);
+                        minCost = std::min(minCost, sliceZM1[(y + 1) * dimX + x] + P1);
+                        minCost = std::min(minCost, bestInCol[x] + P2);
+                        pathCost = sim + minCost - bestInCol[x];
+                    }
+                    volT[indexT(x, y, z)] = (unsigned char)std::min(255u, pathCost);
+                    sliceZ[y * dimX + x] = pathCost;
+                }
+            }
+        }
+
+        if(invZ)
+            shiftZ();
+
+        // transpose back and average
+        int dimsTri[3];
+        dimsTri[dimsTrn[0]] = 0;
+        dimsTri[dimsTrn[1]] = 1;
+        dimsTri[dimsTrn[2]] = 2;
+        for(int z = 0; z < dimZ; ++z)
+            for(int y = 0; y < dimY; ++y)
+                for(int x = 0; x < dimX; ++x)
+                {
+                    const int t[3] = {x, y, z};
+                    unsigned char& out = volAgr[(static_cast<std::size_t>(t[dimsTri[2]]) * volDimY + t[dimsTri[1]]) * volDimX + t[dimsTri[0]]];
+                    const float val = (out * (float)npaths + (float)volT[indexT(x, y, z)]) / (float)(npaths + 1);
+                    out = (unsigned char)(std::fmin(255.0f, val));
+                }
+    }
+    volume = volAgr;
+}
+
+void checkSGM(int volDimX, int volDimY, int volDimZ, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> distribution(0, 255);
+
+    LabImage image(volDimX, volDimY);
+    for(int y = 0; y < volDimY; ++y)
+        for(int x = 0; x < volDimX; ++x)
+        {
+            // smooth colors with some edges, to get various P2 penalties
+            rgb c;
+            c.r = (unsigned char)((x * 7 + (y / 4) * 40) % 256);
+            c.g = (unsigned char)((y * 5) % 256);
+            c.b = (unsigned char)(distribution(generator) / 8);
+            image.at(x, y) = rgbToLab(c);
+        }
+
+    std::vector<unsigned char> volume(static_cast<std::size_t>(volDimX) * volDimY * volDimZ);
+    for(unsigned char& v : volume)
+        v = (unsigned char)distribution(generator);
+
+    std::vector<unsigned char> expected = volume;
+    referenceSGM(image, expected, volDimX, volDimY, volDimZ, 10);
+
+    sgmOptimizeSimVolume(image, volume.data(), volDimX, volDimY, volDimZ, 10);
+
+    std::size_t nbDifferences = 0;
+    for(std::size_t i = 0; i < volume.size(); ++i)
+        nbDifferences += (volume[i] != expected[i]);
+
+    BOOST_CHECK_EQUAL(nbDifferences, 0);
+}
+
+BOOST_AUTO_TEST_CASE(sgmVolume_sameAsReference)
+{
+    checkSGM(37, 23, 15, 0);
+    checkSGM(150, 70, 40, 1);
+}
+
+BOOST_AUTO_TEST_CASE(sgmVolume_smallVolumes)
+{
+    checkSGM(1, 1, 1, 2);
+    checkSGM(5, 3, 2, 3);
+    checkSGM(2, 65, 3, 4);
+}
+
+/**
+ * @brief Aggregate a hand-computed volume of 2 pixels and 3 depths.
+ *
+ * With a uniform image, P2 = 15 + 240 / (1 + exp(-2.5)) = 236, so only P1 = 10 matters.
+ * As in the CUDA kernels, the first pixel of each path and the first and last depths are set to 255.
+ * Pixel 0 has the similarities (10, 20, 30) and pixel 1 (40, 5, 60) along the depths.
+ * - From pixel 0 to pixel 1, depth 1: 5 + min(20, 10 + 10, 30 + 10, 10 + 236) - 10 = 15
+ * - From pixel 1 to pixel 0, depth 1: 20 + min(5, 40 + 10, 60 + 10, 5 + 236) - 5 = 20
+ * The 2 paths along the other axis only have a first pixel (255).
+ * The running average of the 4 paths is truncated to unsigned char after each path.
+ */
+void checkHandComputedSGM(int volDimX, int volDimY, const std::vector<unsigned char>& expected)
+{
+    LabImage image(volDimX, volDimY);
+    rgb c;
+    c.r = 100;
+    c.g = 150;
+    c.b = 200;
+    for(int y = 0; y < volDimY; ++y)
+        for(int x = 0; x < volDimX; ++x)
+            image.at(x, y) = rgbToLab(c);
+
+    // (pixel, depth) similarities, stored by depth planes
+    std::vector<unsigned char> volume = {10, 40,
+                                         20, 5,
+                                         30, 60};
+    sgmOptimizeSimVolume(image, volume.data(), volDimX, volDimY, 3, 10);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(volume.begin(), volume.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(sgmVolume_handComputed)
+{
+    // 2 pixels along Y: the Y paths come first in the average
+    // pixel 0: 255, 20 (137), 255 (176), 255 (195)
+    // pixel 1: 15, 255 (135), 255 (175), 255 (195)
+    checkHandComputedSGM(1, 2, {255, 255,
+                                195, 195,
+                                255, 255});
+
+    // 2 pixels along X: the X paths come last in the average
+    // pixel 0: 255, 255, 255, 20 (196)
+    // pixel 1: 255, 255, 15 (175), 255 (195)
+    checkHandComputedSGM(2, 1, {255, 255,
+                                196, 195,
+                                255, 255});
+}
@@ -12,13 +12,20 @@
 #include <aliceVision/mvsData/SeedPoint.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/depthMap/cpu/PlaneSweepingCpu.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
 #include <aliceVision/depthMap/cuda/commonStructures.hpp>
+#endif
 
 #include <iostream>
+#include <stdexcept>
 
 namespace aliceVision {
 namespace depthMap {
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+
 extern float3 ps_getDeviceMemoryInfo();
 
 /*
@@ -351,7 +358,7 @@ void cps_fillCameraData(mvsUtils::ImagesCache* ic, cameraStruct* cam, int c, mvs
     //	cam->tex_hmh_g->getBuffer(),
     //	cam->tex_hmh_b->getBuffer(), mp->indexes[c], mp, true, 1, 0);
 
-    ic->refreshData(c);
+    const mvsUtils::ImagesCache::ImgSharedPtr img = ic->getImg_sync(c);
 
     Pixel pix;
     for(pix.y = 0; pix.y < mp->getHeight(c); pix.y++)
@@ -359,7 +366,7 @@ void cps_fillCameraData(mvsUtils::ImagesCache* ic, cameraStruct* cam, int c, mvs
         for(pix.x = 0; pix.x < mp->getWidth(c); pix.x++)
         {
              uchar4& pix_rgba = ic->transposed ? (*cam->tex_rgba_hmh)(pix.x, pix.y) : (*cam->tex_rgba_hmh)(pix.y, pix.x);
-             const rgb& pc = ic->getPixelValue(pix, c);
+             const rgb pc = img->getPixelValue(pix);
              pix_rgba.x = pc.r;
              pix_rgba.y = pc.g;
              pix_rgba.z = pc.b;
@@ -381,6 +388,20 @@ void cps_updateCamH(cameraStruct* cam, float** H)
     }
 }
 
+#else
+
+/**
+ * @brief Throw for the PlaneSweepingCuda operations which need the CUDA kernels,
+ *        if AliceVision is built without CUDA.
+ */
+[[noreturn]] void throwCudaNotAvailable(const std::string& function)
+{
+    throw std::runtime_error("PlaneSweepingCuda::" + function + ": AliceVision is built without CUDA, "
+                             "use the cpu compute backend.");
+}
+
+#endif
+
 PlaneSweepingCuda::PlaneSweepingCuda(int _CUDADeviceNo, mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp,
                                          mvsUtils::PreMatchCams* _pc, int _scales)
 {
@@ -417,22 +438,41 @@ PlaneSweepingCuda::PlaneSweepingCuda(int _CUDADeviceNo, mvsUtils::ImagesCache* _
 
     subPixel = mp->_ini.get<bool>("global.subPixel", true);
 
+    computeBackend = EComputeBackend_stringToEnum(
+        mp->_ini.get<std::string>("global.computeBackend", EComputeBackend_enumToString(EComputeBackend_default())));
+    cpuBackend = NULL;
+
+#if !ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    if(computeBackend != EComputeBackend::CPU)
+        throwCudaNotAvailable("PlaneSweepingCuda");
+#endif
+
     ALICEVISION_LOG_INFO("PlaneSweepingCuda:" << std::endl
+                         << "\t- computeBackend: " << computeBackend << std::endl
                          << "\t- nImgsInGPUAtTime: " << nImgsInGPUAtTime << std::endl
                          << "\t- scales: " << scales << std::endl
                          << "\t- subPixel: " << (subPixel ? "Yes" : "No") << std::endl
                          << "\t- varianceWSH: " << varianceWSH);
 
+    cams = new StaticVector<void*>();
+    camsRcs = new StaticVector<int>();
+    camsTimes = new StaticVector<long>();
+
+    if(computeBackend == EComputeBackend::CPU)
+    {
+        ps_texs_arr = NULL;
+        cpuBackend = new PlaneSweepingCpu(ic, mp, scales, nImgsInGPUAtTime, varianceWSH);
+        return;
+    }
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     // allocate global on the device
     ps_deviceAllocate((CudaArray<uchar4, 2>***)&ps_texs_arr, nImgsInGPUAtTime, maxImageWidth, maxImageHeight, scales, CUDADeviceNo);
 
-    cams = new StaticVector<void*>();
     cams->reserve(nImgsInGPUAtTime);
     cams->resize(nImgsInGPUAtTime);
-    camsRcs = new StaticVector<int>();
     camsRcs->reserve(nImgsInGPUAtTime);
     camsRcs->resize(nImgsInGPUAtTime);
-    camsTimes = new StaticVector<long>();
     camsTimes->reserve(nImgsInGPUAtTime);
     camsTimes->resize(nImgsInGPUAtTime);
 
@@ -450,10 +490,12 @@ PlaneSweepingCuda::PlaneSweepingCuda(int _CUDADeviceNo, mvsUtils::ImagesCache* _
         ps_deviceUpdateCam((CudaArray<uchar4, 2>**)ps_texs_arr, (cameraStruct*)(*cams)[rc], rc, CUDADeviceNo,
                            nImgsInGPUAtTime, scales, maxImageWidth, maxImageHeight, varianceWSH);
     }
+#endif
 }
 
 int PlaneSweepingCuda::addCam(int rc, float** H, int scale)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     // fist is oldest
     int id = camsRcs->indexOf(rc);
     if(id == -1)
@@ -486,13 +528,20 @@ int PlaneSweepingCuda::addCam(int rc, float** H, int scale)
         cps_updateCamH((cameraStruct*)(*cams)[id], H);
     }
     return id;
+#else
+    throwCudaNotAvailable("addCam");
+#endif
 }
 
 PlaneSweepingCuda::~PlaneSweepingCuda(void)
 {
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     // deallocate global on the device
-    ps_deviceDeallocate((CudaArray<uchar4, 2>***)&ps_texs_arr, CUDADeviceNo, nImgsInGPUAtTime, scales);
+    if(cpuBackend != NULL)
+        delete cpuBackend;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    else
+        ps_deviceDeallocate((CudaArray<uchar4, 2>***)&ps_texs_arr, CUDADeviceNo, nImgsInGPUAtTime, scales);
 
     for(int c = 0; c < cams->size(); c++)
     {
@@ -503,6 +552,7 @@ PlaneSweepingCuda::~PlaneSweepingCuda(void)
         }
         delete((cameraStruct*)(*cams)[c]);
     }
+#endif
     delete cams;
     delete camsRcs;
     delete camsTimes;
@@ -1103,6 +1153,7 @@ void loadRGBImage(MultiViewParams* mp, CudaHostMemoryHeap<uchar4, 2>& rimg_hmh,
 bool PlaneSweepingCuda::smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float igammaP,
                                          int wsh)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     int w = mp->getWidth(rc) / scale;
     int h = mp->getHeight(rc) / scale;
 
@@ -1144,11 +1195,15 @@ bool PlaneSweepingCuda::smoothDepthMap(StaticVector<float>* depthMap, int rc, in
         mvsUtils::printfElapsedTime(t1);
 
     return true;
+#else
+    throwCudaNotAvailable("smoothDepthMap");
+#endif
 }
 
 bool PlaneSweepingCuda::filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC,
                                          float minCostThr, int wsh)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     int w = mp->getWidth(rc) / scale;
     int h = mp->getHeight(rc) / scale;
 
@@ -1190,11 +1245,15 @@ bool PlaneSweepingCuda::filterDepthMap(StaticVector<float>* depthMap, int rc, in
         mvsUtils::printfElapsedTime(t1);
 
     return true;
+#else
+    throwCudaNotAvailable("filterDepthMap");
+#endif
 }
 
 bool PlaneSweepingCuda::computeNormalMap(StaticVector<float>* depthMap, StaticVector<Color>* normalMap, int rc,
                                            int scale, float igammaC, float igammaP, int wsh)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     int w = mp->getWidth(rc) / scale;
     int h = mp->getHeight(rc) / scale;
 
@@ -1239,12 +1298,16 @@ bool PlaneSweepingCuda::computeNormalMap(StaticVector<float>* depthMap, StaticVe
         mvsUtils::printfElapsedTime(t1);
 
     return true;
+#else
+    throwCudaNotAvailable("computeNormalMap");
+#endif
 }
 
 void PlaneSweepingCuda::alignSourceDepthMapToTarget(StaticVector<float>* sourceDepthMap,
                                                       StaticVector<float>* targetDepthMap, int rc, int scale,
                                                       float igammaC, int wsh, float maxPixelSizeDist)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     int w = mp->getWidth(rc) / scale;
     int h = mp->getHeight(rc) / scale;
 
@@ -1287,12 +1350,16 @@ void PlaneSweepingCuda::alignSourceDepthMapToTarget(StaticVector<float>* sourceD
 
     if(verbose)
         mvsUtils::printfElapsedTime(t1);
+#else
+    throwCudaNotAvailable("alignSourceDepthMapToTarget");
+#endif
 }
 
 bool PlaneSweepingCuda::refineDepthMapReproject(StaticVector<float>* depthMap, StaticVector<float>* simMap, int rc,
                                                   int tc, int wsh, float gammaC, float gammaP, float simThr, int niters,
                                                   bool moveByTcOrRc)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     int scale = 1;
     int w = mp->getWidth(rc);
     int h = mp->getHeight(rc);
@@ -1359,6 +1426,9 @@ bool PlaneSweepingCuda::refineDepthMapReproject(StaticVector<float>* depthMap, S
         mvsUtils::printfElapsedTime(t1);
 
     return true;
+#else
+    throwCudaNotAvailable("refineDepthMapReproject");
+#endif
 }
 
 /*
@@ -1443,6 +1513,7 @@ bool PlaneSweepingCuda::computeSimMapForRcTcDepthMap(StaticVector<float>* oSimMa
                                                        int rc, int tc, int wsh, float gammaC, float gammaP,
                                                        float epipShift)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     int scale = 1;
     int w = mp->getWidth(rc);
     int h = mp->getHeight(rc);
@@ -1501,6 +1572,9 @@ bool PlaneSweepingCuda::computeSimMapForRcTcDepthMap(StaticVector<float>* oSimMa
         mvsUtils::printfElapsedTime(t1);
 
     return true;
+#else
+    throwCudaNotAvailable("computeSimMapForRcTcDepthMap");
+#endif
 }
 
 bool PlaneSweepingCuda::refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
@@ -1513,6 +1587,16 @@ bool PlaneSweepingCuda::refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRe
 
     long t1 = clock();
 
+    if(cpuBackend != NULL)
+    {
+        cpuBackend->refineRcTcDepthMap(useTcOrRcPixSize, nStepsToRefine, simMap, rcDepthMap, rc, tc, scale, wsh,
+                                       gammaC, gammaP, epipShift, xFrom, wPart);
+        if(verbose)
+            mvsUtils::printfElapsedTime(t1);
+        return true;
+    }
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     StaticVector<int>* camsids = new StaticVector<int>();
     camsids->reserve(2);
     camsids->push_back(addCam(rc, NULL, scale));
@@ -1571,6 +1655,9 @@ bool PlaneSweepingCuda::refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRe
         mvsUtils::printfElapsedTime(t1);
 
     return true;
+#else
+    throwCudaNotAvailable("refineRcTcDepthMap");
+#endif
 }
 
 float PlaneSweepingCuda::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX,
@@ -1597,6 +1684,19 @@ float PlaneSweepingCuda::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<u
         return -1.0f;
     }
 
+    if(cpuBackend != NULL)
+    {
+        // as the CUDA kernels, only the first target camera is used
+        const float volumeMB = cpuBackend->sweepPixelsToVolume(nDepthsToSearch, volume, volDimX, volDimY, volDimZ,
+                                                               volStepXY, volLUX, volLUY, volLUZ, depths, rc,
+                                                               (*tcams)[0], wsh, gammaC, gammaP, pixels, scale,
+                                                               epipShift);
+        if(verbose)
+            mvsUtils::printfElapsedTime(t1);
+        return volumeMB;
+    }
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     StaticVector<int> *camsids = new StaticVector<int>();
     camsids->reserve(tcams->size() + 1);
     camsids->push_back(addCam(rc, NULL, scale));
@@ -1685,6 +1785,9 @@ float PlaneSweepingCuda::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<u
         mvsUtils::printfElapsedTime(t1);
 
     return volumeMBinGPUMem;
+#else
+    throwCudaNotAvailable("sweepPixelsToVolume");
+#endif
 }
 
 /**
@@ -1703,6 +1806,15 @@ bool PlaneSweepingCuda::SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>
 
     long t1 = clock();
 
+    if(cpuBackend != NULL)
+    {
+        cpuBackend->SGMoptimizeSimVolume(rc, volume, volDimX, volDimY, volDimZ, scale, P1);
+        if(verbose)
+            mvsUtils::printfElapsedTime(t1);
+        return true;
+    }
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     ps_SGMoptimizeSimVolume((CudaArray<uchar4, 2>**)ps_texs_arr, (cameraStruct*)(*cams)[addCam(rc, NULL, scale)],
                             volume->getDataWritable().data(), volDimX, volDimY, volDimZ, volStepXY, volLUX, volLUY, verbose, P1, P2, scale - 1, // TODO: move the '- 1' inside the function
                             CUDADeviceNo, nImgsInGPUAtTime, scales);
@@ -1711,13 +1823,23 @@ bool PlaneSweepingCuda::SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>
         mvsUtils::printfElapsedTime(t1);
 
     return true;
+#else
+    throwCudaNotAvailable("SGMoptimizeSimVolume");
+#endif
 }
 
 // make_float3(avail,total,used)
 Point3d PlaneSweepingCuda::getDeviceMemoryInfo()
 {
+    if(cpuBackend != NULL)
+        return cpuBackend->getMemoryInfo();
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     float3 dmif3 = ps_getDeviceMemoryInfo();
     return Point3d(dmif3.x, dmif3.y, dmif3.z);
+#else
+    throwCudaNotAvailable("getDeviceMemoryInfo");
+#endif
 }
 /*
 
@@ -2114,6 +2236,16 @@ bool PlaneSweepingCuda::fuseDepthSimMapsGaussianKernelVoting(int w, int h, Stati
 {
     long t1 = clock();
 
+    if(cpuBackend != NULL)
+    {
+        cpuBackend->fuseDepthSimMapsGaussianKernelVoting(w, h, oDepthSimMap, dataMaps, nSamplesHalf, nDepthsToRefine,
+                                                         sigma);
+        if(verbose)
+            mvsUtils::printfElapsedTime(t1);
+        return true;
+    }
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     // sweep
     CudaHostMemoryHeap<float2, 2>** dataMaps_hmh = new CudaHostMemoryHeap<float2, 2>*[dataMaps->size()];
     for(int i = 0; i < dataMaps->size(); i++)
@@ -2157,6 +2289,9 @@ bool PlaneSweepingCuda::fuseDepthSimMapsGaussianKernelVoting(int w, int h, Stati
         mvsUtils::printfElapsedTime(t1);
 
     return true;
+#else
+    throwCudaNotAvailable("fuseDepthSimMapsGaussianKernelVoting");
+#endif
 }
 
 bool PlaneSweepingCuda::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
@@ -2173,6 +2308,15 @@ bool PlaneSweepingCuda::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim
 
     long t1 = clock();
 
+    if(cpuBackend != NULL)
+    {
+        cpuBackend->optimizeDepthSimMapGradientDescent(oDepthSimMap, dataMaps, rc, nIters, yFrom, hPart);
+        if(verbose)
+            mvsUtils::printfElapsedTime(t1);
+        return true;
+    }
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     StaticVector<int>* camsids = new StaticVector<int>();
     camsids->reserve(1);
     camsids->push_back(addCam(rc, NULL, scale));
@@ -2242,6 +2386,9 @@ bool PlaneSweepingCuda::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim
         mvsUtils::printfElapsedTime(t1);
 
     return true;
+#else
+    throwCudaNotAvailable("optimizeDepthSimMapGradientDescent");
+#endif
 }
 
 /*
@@ -2428,6 +2575,15 @@ bool PlaneSweepingCuda::getSilhoueteMap(StaticVectorBool* oMap, int scale, int s
 
     long t1 = clock();
 
+    if(cpuBackend != NULL)
+    {
+        cpuBackend->getSilhoueteMap(oMap, scale, step, maskColor, rc);
+        if(verbose)
+            mvsUtils::printfElapsedTime(t1);
+        return true;
+    }
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     int camId = addCam(rc, NULL, scale);
 
     uchar4 maskColorRgb;
@@ -2450,11 +2606,18 @@ bool PlaneSweepingCuda::getSilhoueteMap(StaticVectorBool* oMap, int scale, int s
         mvsUtils::printfElapsedTime(t1);
 
     return true;
+#else
+    throwCudaNotAvailable("getSilhoueteMap");
+#endif
 }
 
 int listCUDADevices(bool verbose)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     return ps_listCUDADevices(verbose);
+#else
+    return 0;
+#endif
 }
 
 } // namespace depthMap
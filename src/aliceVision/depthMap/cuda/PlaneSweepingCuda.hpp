@@ -18,10 +18,13 @@
 #include <aliceVision/mvsUtils/ImagesCache.hpp>
 #include <aliceVision/mvsUtils/PreMatchCams.hpp>
 #include <aliceVision/depthMap/DepthSimMap.hpp>
+#include <aliceVision/depthMap/ComputeBackend.hpp>
 
 namespace aliceVision {
 namespace depthMap {
 
+class PlaneSweepingCpu;
+
 class PlaneSweepingCuda
 {
 public:
@@ -74,6 +77,11 @@ public:
     // float gammaC,gammaP;
     mvsUtils::ImagesCache* ic;
 
+    /// "global.computeBackend": with the CPU backend, no CUDA device is used
+    /// and the operations used by SGM and Refine are computed by cpuBackend
+    EComputeBackend computeBackend;
+    PlaneSweepingCpu* cpuBackend;
+
     PlaneSweepingCuda(int _CUDADeviceNo, mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc,
                         int _scales);
     ~PlaneSweepingCuda(void);
@@ -78,7 +78,7 @@ void ImageDescriber::Save(const Regions* regions, const std::string& sfileNameFe
   const std::string tmpFeatsPath = (bFeatsPath.parent_path() / bFeatsPath.stem()).string() + "." + fs::unique_path().string() + bFeatsPath.extension().string();
   const std::string tmpDescsPath = (bDescsPath.parent_path() / bDescsPath.stem()).string() + "." + fs::unique_path().string() + bDescsPath.extension().string();
 
-  regions->Save(tmpFeatsPath, tmpDescsPath);
+  regions->Save(tmpFeatsPath, tmpDescsPath, getDescriberType());
 
   // rename temporay filenames
   fs::rename(tmpFeatsPath, sfileNameFeats);
@@ -0,0 +1,105 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/PointFeature.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <string>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Read-only memory mapping of a binary keypoints file (.featb).
+ *
+ * Keypoints are accessed in place, without any parsing or copy.
+ * The mapping stays valid as long as the MappedFeatsFile object is alive.
+ */
+template<typename FeatureT>
+class MappedFeatsFile
+{
+public:
+  typedef const FeatureT* const_iterator;
+
+  MappedFeatsFile() = default;
+
+  explicit MappedFeatsFile(const std::string& sfileNameFeats)
+  {
+    open(sfileNameFeats);
+  }
+
+  /**
+   * @brief Map the given binary keypoints file.
+   * @param[in] sfileNameFeats the file name
+   */
+  void open(const std::string& sfileNameFeats)
+  {
+    close();
+
+    try
+    {
+      _file.open(sfileNameFeats);
+    }
+    catch(const std::exception& e)
+    {
+      throw std::runtime_error("Can't map binary features file, can't open '" + sfileNameFeats + "' : " + e.what());
+    }
+
+    if(_file.size() < sizeof(FeatsBinFileHeader))
+    {
+      close();
+      throw std::runtime_error("Can't map binary features file, '" + sfileNameFeats + "' is incorrect !");
+    }
+
+    try
+    {
+      checkFeatsBinFileHeader<FeatureT>(header(), _file.size(), sfileNameFeats);
+    }
+    catch(...)
+    {
+      close();
+      throw;
+    }
+  }
+
+  void close()
+  {
+    if(_file.is_open())
+      _file.close();
+  }
+
+  bool isOpen() const { return _file.is_open(); }
+
+  const FeatsBinFileHeader& header() const
+  {
+    return *reinterpret_cast<const FeatsBinFileHeader*>(_file.data());
+  }
+
+  EImageDescriberType getDescriberType() const { return header().getDescriberType(); }
+
+  std::size_t size() const { return isOpen() ? static_cast<std::size_t>(header().count) : 0; }
+  bool empty() const { return size() == 0; }
+
+  const FeatureT* data() const
+  {
+    return isOpen() ? reinterpret_cast<const FeatureT*>(_file.data() + sizeof(FeatsBinFileHeader)) : nullptr;
+  }
+
+  const FeatureT& operator[](std::size_t i) const { return data()[i]; }
+
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size(); }
+
+private:
+  boost::iostreams::mapped_file_source _file;
+};
+
+} // namespace feature
+} // namespace aliceVision
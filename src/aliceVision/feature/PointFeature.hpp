@@ -8,6 +8,12 @@
 #pragma once
 
 #include "aliceVision/numeric/numeric.hpp"
+#include "aliceVision/feature/imageDescriberCommon.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <cstdint>
 #include <iostream>
 #include <iterator>
 #include <fstream>
@@ -122,7 +128,186 @@ inline std::istream& operator>>(std::istream& in, SIOPointFeature& obj)
   return in >> *pf >> obj._scale >> obj._orientation;
 }
 
-/// Read feats from file
+/// Extension of the binary keypoints files (ASCII keypoints files use ".feat")
+constexpr const char* featsBinFileExtension = ".featb";
+
+/**
+ * @brief Type of the keypoints stored in a binary keypoints file.
+ */
+enum class EFeatsBinFileType : std::uint32_t
+{
+  POINT = 0,
+  SIO_POINT = 1
+};
+
+template<typename FeatureT>
+struct FeatsBinFileTraits;
+
+template<>
+struct FeatsBinFileTraits<PointFeature>
+{
+  static constexpr EFeatsBinFileType type = EFeatsBinFileType::POINT;
+};
+
+template<>
+struct FeatsBinFileTraits<SIOPointFeature>
+{
+  static constexpr EFeatsBinFileType type = EFeatsBinFileType::SIO_POINT;
+};
+
+/**
+ * @brief Header of a binary keypoints file (.featb).
+ *
+ * The header is followed by @p count keypoints stored as packed floats
+ * (x, y for POINT, x, y, scale, orientation for SIO_POINT), in the native
+ * byte order. The header size is a multiple of 16 bytes, so a memory mapping
+ * of the file can be used directly as an array of keypoints.
+ */
+struct FeatsBinFileHeader
+{
+  /// "AVKP" in little-endian byte order
+  static constexpr std::uint32_t magic = 0x504B5641;
+  static constexpr std::uint32_t currentVersion = 1;
+
+  std::uint32_t fileMagic = magic;
+  std::uint32_t version = currentVersion;
+  EFeatsBinFileType featureType = EFeatsBinFileType::POINT;
+  std::uint32_t describerType = static_cast<std::uint32_t>(EImageDescriberType::UNKNOWN);
+  std::uint64_t count = 0;
+  std::uint64_t reserved = 0;
+
+  bool hasValidMagic() const
+  {
+    return fileMagic == magic;
+  }
+
+  EImageDescriberType getDescriberType() const
+  {
+    return static_cast<EImageDescriberType>(describerType);
+  }
+};
+
+static_assert(sizeof(FeatsBinFileHeader) == 32, "Unexpected binary keypoints file header size.");
+static_assert(sizeof(PointFeature) == 2 * sizeof(float), "PointFeature must be stored as packed floats.");
+static_assert(sizeof(SIOPointFeature) == 4 * sizeof(float), "SIOPointFeature must be stored as packed floats.");
+
+/**
+ * @brief Check that the given header can be read as a list of \p FeatureT.
+ * @param[in] header the header read from the file
+ * @param[in] fileSize the size of the file in bytes (including the header)
+ * @param[in] sfileNameFeats the file name (for error messages)
+ */
+template<typename FeatureT>
+inline void checkFeatsBinFileHeader(const FeatsBinFileHeader& header, std::uint64_t fileSize, const std::string& sfileNameFeats)
+{
+  if(!header.hasValidMagic())
+    throw std::runtime_error("Can't load binary features file, '" + sfileNameFeats + "' is not a binary features file !");
+
+  if(header.version > FeatsBinFileHeader::currentVersion)
+    throw std::runtime_error("Can't load binary features file, '" + sfileNameFeats + "' has an unsupported version (" + std::to_string(header.version) + ") !");
+
+  if(header.featureType != FeatsBinFileTraits<FeatureT>::type)
+    throw std::runtime_error("Can't load binary features file, '" + sfileNameFeats + "' does not contain the expected feature type !");
+
+  // compare the count to the number of features the file can hold, so the size can't overflow
+  if(fileSize < sizeof(FeatsBinFileHeader) ||
+     header.count > (fileSize - sizeof(FeatsBinFileHeader)) / sizeof(FeatureT))
+    throw std::runtime_error("Can't load binary features file, '" + sfileNameFeats + "' is truncated !");
+}
+
+/**
+ * @brief Check whether the given file is a binary keypoints file.
+ * @param[in] sfileNameFeats the file name
+ * @return true if the file starts with the binary keypoints file magic
+ */
+inline bool isFeatsBinFile(const std::string& sfileNameFeats)
+{
+  std::ifstream fileIn(sfileNameFeats, std::ios::in | std::ios::binary);
+  if(!fileIn.is_open())
+    return false;
+
+  std::uint32_t fileMagic = 0;
+  fileIn.read(reinterpret_cast<char*>(&fileMagic), sizeof(fileMagic));
+
+  return fileIn.gcount() == sizeof(fileMagic) && fileMagic == FeatsBinFileHeader::magic;
+}
+
+/**
+ * @brief Read feats from a binary keypoints file (.featb).
+ * @param[in] sfileNameFeats the file name
+ * @param[out] vec_feat the loaded features
+ * @return the header of the file
+ */
+template<typename FeaturesT>
+inline FeatsBinFileHeader loadFeatsFromBinFile(
+  const std::string& sfileNameFeats,
+  FeaturesT& vec_feat)
+{
+  typedef typename FeaturesT::value_type FeatureT;
+
+  vec_feat.clear();
+
+  std::ifstream fileIn(sfileNameFeats, std::ios::in | std::ios::binary);
+
+  if(!fileIn.is_open())
+    throw std::runtime_error("Can't load binary features file, can't open '" + sfileNameFeats + "' !");
+
+  FeatsBinFileHeader header;
+  fileIn.read(reinterpret_cast<char*>(&header), sizeof(FeatsBinFileHeader));
+
+  if(fileIn.gcount() != sizeof(FeatsBinFileHeader))
+    throw std::runtime_error("Can't load binary features file, '" + sfileNameFeats + "' is incorrect !");
+
+  checkFeatsBinFileHeader<FeatureT>(header, boost::filesystem::file_size(sfileNameFeats), sfileNameFeats);
+
+  vec_feat.resize(header.count);
+  fileIn.read(reinterpret_cast<char*>(vec_feat.data()), header.count * sizeof(FeatureT));
+
+  if(fileIn.bad())
+    throw std::runtime_error("Can't load binary features file, '" + sfileNameFeats + "' is incorrect !");
+
+  fileIn.close();
+  return header;
+}
+
+/**
+ * @brief Write feats to a binary keypoints file (.featb).
+ * @param[in] sfileNameFeats the file name
+ * @param[in] vec_feat the features to save
+ * @param[in] describerType the image describer type stored in the header
+ */
+template<typename FeaturesT>
+inline void saveFeatsToBinFile(
+  const std::string& sfileNameFeats,
+  const FeaturesT& vec_feat,
+  EImageDescriberType describerType = EImageDescriberType::UNKNOWN)
+{
+  typedef typename FeaturesT::value_type FeatureT;
+
+  std::ofstream file(sfileNameFeats, std::ios::out | std::ios::binary);
+
+  if(!file.is_open())
+    throw std::runtime_error("Can't save binary features file, can't open '" + sfileNameFeats + "' !");
+
+  FeatsBinFileHeader header;
+  header.featureType = FeatsBinFileTraits<FeatureT>::type;
+  header.describerType = static_cast<std::uint32_t>(describerType);
+  header.count = vec_feat.size();
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(FeatsBinFileHeader));
+  file.write(reinterpret_cast<const char*>(vec_feat.data()), vec_feat.size() * sizeof(FeatureT));
+
+  if(!file.good())
+    throw std::runtime_error("Can't save binary features file, '" + sfileNameFeats + "' is incorrect !");
+
+  file.close();
+}
+
+/**
+ * @brief Read feats from file.
+ * @note Both ASCII (.feat) and binary (.featb) keypoints files are supported,
+ *       the format is detected from the file content.
+ */
 template<typename FeaturesT >
 inline void loadFeatsFromFile(
   const std::string & sfileNameFeats,
@@ -130,6 +315,12 @@ inline void loadFeatsFromFile(
 {
   vec_feat.clear();
 
+  if(isFeatsBinFile(sfileNameFeats))
+  {
+    loadFeatsFromBinFile(sfileNameFeats, vec_feat);
+    return;
+  }
+
   std::ifstream fileIn(sfileNameFeats);
 
   if(!fileIn.is_open())
@@ -144,12 +335,26 @@ inline void loadFeatsFromFile(
   fileIn.close();
 }
 
-/// Write feats to file
+/**
+ * @brief Write feats to file.
+ * @note The binary keypoints format is used if the file extension is ".featb".
+ * @param[in] describerType the image describer type stored in the binary keypoints file header
+ */
 template<typename FeaturesT >
 inline void saveFeatsToFile(
   const std::string & sfileNameFeats,
-  FeaturesT & vec_feat)
+  FeaturesT & vec_feat,
+  EImageDescriberType describerType = EImageDescriberType::UNKNOWN)
 {
+  std::string ext = boost::filesystem::path(sfileNameFeats).extension().string();
+  boost::to_lower(ext);
+
+  if(ext == featsBinFileExtension)
+  {
+    saveFeatsToBinFile(sfileNameFeats, vec_feat, describerType);
+    return;
+  }
+
   std::ofstream file(sfileNameFeats.c_str());
 
   if (!file.is_open())
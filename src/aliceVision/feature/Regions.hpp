@@ -10,6 +10,7 @@
 #include <aliceVision/types.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/feature/PointFeature.hpp>
+#include <aliceVision/feature/MappedFeatsFile.hpp>
 #include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/matching/metric.hpp>
 
@@ -59,7 +60,8 @@ public:
 
   virtual void Save(
     const std::string& sfileNameFeats,
-    const std::string& sfileNameDescs) const = 0;
+    const std::string& sfileNameDescs,
+    EImageDescriberType describerType) const = 0;
 
   virtual void SaveDesc(const std::string& sfileNameDescs) const = 0;
 
@@ -99,6 +101,9 @@ public:
 
   virtual void clearDescriptors() = 0;
 
+  /// Return the memory size (in bytes) of the features and the descriptors
+  virtual std::size_t getMemorySize() const = 0;
+
   /// Return the squared distance between two descriptors
   // A default metric is used according the descriptor type:
   // - Scalar: L2,
@@ -133,10 +138,26 @@ public:
 protected:
   std::vector<FeatureT> _vec_feats;    // region features
 
+  /**
+   * @brief Read the features from a file.
+   * The binary keypoints files are read through a memory mapping and copied
+   * in a single pass into the features container, without stream parsing.
+   */
+  void loadFeats(const std::string& sfileNameFeats)
+  {
+    if(isFeatsBinFile(sfileNameFeats))
+    {
+      const MappedFeatsFile<FeatureT> mappedFeats(sfileNameFeats);
+      _vec_feats.assign(mappedFeats.begin(), mappedFeats.end());
+    }
+    else
+      loadFeatsFromFile(sfileNameFeats, _vec_feats);
+  }
+
 public:
   void LoadFeatures(const std::string& sfileNameFeats)
   {
-    loadFeatsFromFile(sfileNameFeats, _vec_feats);
+    loadFeats(sfileNameFeats);
   }
 
   PointFeatures GetRegionsPositions() const
@@ -221,16 +242,17 @@ public:
     const std::string& sfileNameFeats,
     const std::string& sfileNameDescs) override
   {
-    loadFeatsFromFile(sfileNameFeats, this->_vec_feats);
+    this->loadFeats(sfileNameFeats);
     loadDescsFromBinFile(sfileNameDescs, _vec_descs);
   }
 
   /// Export in two separate files the regions and their corresponding descriptors.
   void Save(
     const std::string& sfileNameFeats,
-    const std::string& sfileNameDescs) const override
+    const std::string& sfileNameDescs,
+    EImageDescriberType describerType) const override
   {
-    saveFeatsToFile(sfileNameFeats, this->_vec_feats);
+    saveFeatsToFile(sfileNameFeats, this->_vec_feats, describerType);
     saveDescsToBinFile(sfileNameDescs, _vec_descs);
   }
 
@@ -249,6 +271,11 @@ public:
 
   inline void clearDescriptors() override { _vec_descs.clear(); }
 
+  std::size_t getMemorySize() const override
+  {
+    return this->_vec_feats.capacity() * sizeof(FeatT) + _vec_descs.capacity() * sizeof(DescriptorT);
+  }
+
   inline void swap(This& other)
   {
     this->_vec_feats.swap(other._vec_feats);
@@ -6,10 +6,12 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/feature/feature.hpp"
+#include "aliceVision/feature/MappedFeatsFile.hpp"
 
 #include <iostream>
 #include <fstream>
 #include <iterator>
+#include <limits>
 #include <vector>
 
 #define BOOST_TEST_MODULE Feature
@@ -70,6 +72,90 @@ BOOST_AUTO_TEST_CASE(featureIO_ASCII) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(featureIO_BINARY) {
+  Feats_T vec_feats;
+  for(int i = 0; i < CARD; ++i)  {
+    vec_feats.push_back(Feature_T(i, i*2, i*3, i*4));
+  }
+
+  //Save them to a binary file (selected from the file extension)
+  BOOST_CHECK_NO_THROW(saveFeatsToFile("tempFeats.featb", vec_feats, EImageDescriberType::SIFT));
+  BOOST_CHECK(isFeatsBinFile("tempFeats.featb"));
+
+  //Read the saved data and compare to input (the format is detected from the file content)
+  Feats_T vec_feats_read;
+  BOOST_CHECK_NO_THROW(loadFeatsFromFile("tempFeats.featb", vec_feats_read));
+  BOOST_CHECK_EQUAL(CARD, vec_feats_read.size());
+
+  //The describer type is kept in the header
+  FeatsBinFileHeader header;
+  BOOST_CHECK_NO_THROW(header = loadFeatsFromBinFile("tempFeats.featb", vec_feats_read));
+  BOOST_CHECK(header.getDescriberType() == EImageDescriberType::SIFT);
+
+  for(int i = 0; i < CARD; ++i) {
+    BOOST_CHECK_EQUAL(vec_feats[i], vec_feats_read[i]);
+  }
+
+  //An ASCII file is not detected as a binary file
+  BOOST_CHECK_NO_THROW(saveFeatsToFile("tempFeats.feat", vec_feats));
+  BOOST_CHECK(!isFeatsBinFile("tempFeats.feat"));
+
+  //The feature type stored in the header must match
+  PointFeatures vec_points;
+  BOOST_CHECK_THROW(loadFeatsFromBinFile("tempFeats.featb", vec_points), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(featureIO_BINARY_MAPPED) {
+  Feats_T vec_feats;
+  for(int i = 0; i < CARD; ++i)  {
+    vec_feats.push_back(Feature_T(i, i*2, i*3, i*4));
+  }
+
+  BOOST_CHECK_NO_THROW(saveFeatsToBinFile("tempFeatsMapped.featb", vec_feats, EImageDescriberType::SIFT));
+
+  MappedFeatsFile<Feature_T> mappedFeats("tempFeatsMapped.featb");
+  BOOST_CHECK(mappedFeats.isOpen());
+  BOOST_CHECK(mappedFeats.getDescriberType() == EImageDescriberType::SIFT);
+  BOOST_CHECK_EQUAL(CARD, mappedFeats.size());
+
+  for(int i = 0; i < CARD; ++i) {
+    BOOST_CHECK_EQUAL(vec_feats[i], mappedFeats[i]);
+  }
+
+  //Empty file
+  BOOST_CHECK_NO_THROW(saveFeatsToBinFile("tempFeatsEmpty.featb", Feats_T()));
+  MappedFeatsFile<Feature_T> mappedEmpty("tempFeatsEmpty.featb");
+  BOOST_CHECK(mappedEmpty.empty());
+
+  //The regions read their binary features through the mapping
+  SIFT_Regions regions;
+  BOOST_CHECK_NO_THROW(regions.LoadFeatures("tempFeatsMapped.featb"));
+  BOOST_CHECK_EQUAL(CARD, regions.RegionCount());
+  for(int i = 0; i < CARD; ++i) {
+    BOOST_CHECK_EQUAL(vec_feats[i], regions.Features()[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(featureIO_BINARY_COUNT_OVERFLOW) {
+  //A count whose size in bytes wraps around to the size of a single feature
+  FeatsBinFileHeader header;
+  header.featureType = FeatsBinFileTraits<Feature_T>::type;
+  header.count = std::numeric_limits<std::uint64_t>::max() / sizeof(Feature_T) + 2;
+  BOOST_CHECK_LT(header.count * sizeof(Feature_T), 2 * sizeof(Feature_T));
+
+  {
+    std::ofstream file("tempFeatsOverflow.featb", std::ios::out | std::ios::binary);
+    const Feature_T feat(1, 2, 3, 4);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&feat), sizeof(feat));
+    file.write(reinterpret_cast<const char*>(&feat), sizeof(feat));
+  }
+
+  Feats_T vec_feats_read;
+  BOOST_CHECK_THROW(loadFeatsFromBinFile("tempFeatsOverflow.featb", vec_feats_read), std::exception);
+  BOOST_CHECK_THROW(MappedFeatsFile<Feature_T>("tempFeatsOverflow.featb"), std::exception);
+}
+
 //--
 //-- Descriptors interface test
 //--
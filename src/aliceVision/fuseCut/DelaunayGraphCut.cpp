@@ -7,6 +7,7 @@
 #include "DelaunayGraphCut.hpp"
 // #include <aliceVision/fuseCut/MaxFlow_CSR.hpp>
 #include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_IBFS.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/jetColorMap.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
@@ -22,6 +23,7 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
 
 // OpenMP >= 3.1 for advanced atomic clauses (https://software.intel.com/en-us/node/608160)
 // OpenMP preprocessor version: https://github.com/jeffhammond/HPCInfo/wiki/Preprocessor-Macros
@@ -39,6 +41,30 @@ namespace fuseCut {
 
 namespace bfs = boost::filesystem;
 
+EMaxFlowMethod EMaxFlowMethod_stringToEnum(const std::string& method)
+{
+    std::string m = method;
+    boost::to_lower(m);
+
+    if(m == "boykovkolmogorov")
+        return EMaxFlowMethod::BoykovKolmogorov;
+    if(m == "ibfs")
+        return EMaxFlowMethod::IBFS;
+    throw std::out_of_range("Invalid maxflow method " + method);
+}
+
+std::string EMaxFlowMethod_enumToString(EMaxFlowMethod method)
+{
+    switch(method)
+    {
+    case EMaxFlowMethod::BoykovKolmogorov:
+        return "BoykovKolmogorov";
+    case EMaxFlowMethod::IBFS:
+        return "IBFS";
+    }
+    throw std::out_of_range("Unrecognized EMaxFlowMethod");
+}
+
 // #define USE_GEOGRAM_KDTREE 1
 
 #ifdef USE_GEOGRAM_KDTREE
@@ -1547,9 +1573,6 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
         }
     }
 
-    // choose random order to prevent waiting
-    StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
-
     int64_t avStepsFront = 0;
     int64_t aAvStepsFront = 0;
     int64_t avStepsBehind = 0;
@@ -1557,39 +1580,56 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
     int avCams = 0;
     int nAvCams = 0;
 
-#pragma omp parallel for reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
-    for(int i = 0; i < vetexesToProcessIdsRand->size(); i++)
+    // Vertices are processed by batches: rays are casted in parallel and store their weights per vertex,
+    // then the weights are added to the cells in the vertices order.
+    // So the result is deterministic and does not depend on the number of threads.
+    const int nbVertices = _verticesAttr.size();
+    const int batchSize = std::max(1, fillGraphBatchSize);
+    std::vector<std::vector<CellContribution>> contributions(std::min(batchSize, nbVertices));
+
+    for(int batchStart = 0; batchStart < nbVertices; batchStart += batchSize)
     {
-        int iV = (*vetexesToProcessIdsRand)[i];
-        const GC_vertexInfo& v = _verticesAttr[iV];
+        const int batchEnd = std::min(batchStart + batchSize, nbVertices);
 
-        if(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0))
+#pragma omp parallel for schedule(dynamic) reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
+        for(int iV = batchStart; iV < batchEnd; ++iV)
         {
-            for(int c = 0; c < v.cams.size(); c++)
+            const GC_vertexInfo& v = _verticesAttr[iV];
+            std::vector<CellContribution>& vertexContributions = contributions[iV - batchStart];
+            vertexContributions.clear();
+
+            if(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0))
             {
-                // "weight" is called alpha(p) in the paper
-                float weight = weightFcn((float)v.nrc, labatutWeights, v.getNbCameras()); // number of cameras
+                for(int c = 0; c < v.cams.size(); c++)
+                {
+                    // "weight" is called alpha(p) in the paper
+                    float weight = weightFcn((float)v.nrc, labatutWeights, v.getNbCameras()); // number of cameras
 
-                assert(v.cams[c] >= 0);
-                assert(v.cams[c] < mp->ncams);
+                    assert(v.cams[c] >= 0);
+                    assert(v.cams[c] < mp->ncams);
 
-                int nstepsFront = 0;
-                int nstepsBehind = 0;
-                fillGraphPartPtRc(nstepsFront, nstepsBehind, iV, v.cams[c], weight, fixesSigma, nPixelSizeBehind,
-                                  allPoints, behind, fillOut, distFcnHeight);
+                    int nstepsFront = 0;
+                    int nstepsBehind = 0;
+                    fillGraphPartPtRc(nstepsFront, nstepsBehind, vertexContributions, iV, v.cams[c], weight, fixesSigma,
+                                      nPixelSizeBehind, allPoints, behind, fillOut, distFcnHeight);
 
-                avStepsFront += nstepsFront;
-                aAvStepsFront += 1;
-                avStepsBehind += nstepsBehind;
-                nAvStepsBehind += 1;
-            } // for c
+                    avStepsFront += nstepsFront;
+                    aAvStepsFront += 1;
+                    avStepsBehind += nstepsBehind;
+                    nAvStepsBehind += 1;
+                } // for c
 
-            avCams += v.cams.size();
-            nAvCams += 1;
+                avCams += v.cams.size();
+                nAvCams += 1;
+            }
         }
-    }
 
-    delete vetexesToProcessIdsRand;
+        for(int i = 0; i < batchEnd - batchStart; ++i)
+        {
+            for(const CellContribution& contribution : contributions[i])
+                addCellContribution(contribution);
+        }
+    }
 
     ALICEVISION_LOG_DEBUG("avStepsFront " << avStepsFront);
     ALICEVISION_LOG_DEBUG("avStepsFront = " << mvsUtils::num2str(avStepsFront) << " // " << mvsUtils::num2str(aAvStepsFront));
@@ -1599,9 +1639,35 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
     mvsUtils::printfElapsedTime(t1, "s-t graph weights computed : ");
 }
 
-void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam,
-                                       float weight, bool fixesSigma, float nPixelSizeBehind, bool allPoints,
-                                       bool behind, bool fillOut, float distFcnHeight)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
+void DelaunayGraphCut::addCellContribution(const CellContribution& contribution)
+{
+    GC_cellInfo& c = _cellsAttr[contribution.cellIndex];
+    switch(contribution.field)
+    {
+        case CellContribution::eIn:
+            c.in += contribution.weight;
+            break;
+        case CellContribution::eOut:
+            c.out += contribution.weight;
+            break;
+        case CellContribution::eOn:
+            c.on += contribution.weight;
+            break;
+        case CellContribution::eTWeight:
+            c.cellTWeight += contribution.weight;
+            break;
+        case CellContribution::eSWeightMax:
+            c.cellSWeight = contribution.weight;
+            break;
+        default:
+            c.gEdgeVisWeight[contribution.field - CellContribution::eEdgeVis0] += contribution.weight;
+            break;
+    }
+}
+
+void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, std::vector<CellContribution>& out_contributions,
+                                       int vertexIndex, int cam, float weight, bool fixesSigma, float nPixelSizeBehind,
+                                       bool allPoints, bool behind, bool fillOut, float distFcnHeight)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
 {
     out_nstepsFront = 0;
     out_nstepsBehind = 0;
@@ -1634,10 +1700,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         bool ok = ci != GEO::NO_CELL;
         while(ok)
         {
-            {
-#pragma OMP_ATOMIC_UPDATE
-                _cellsAttr[ci].out += weight;
-            }
+            out_contributions.push_back({ci, CellContribution::eOut, weight});
 
             ++out_nstepsFront;
             ++nsteps;
@@ -1654,10 +1717,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
             {
                 float dist = distFcn(maxDist, (po - pold).size(), distFcnHeight);
 
-                {
-#pragma OMP_ATOMIC_UPDATE
-                    _cellsAttr[f1.cellIndex].gEdgeVisWeight[f1.localVertexIndex] += weight * dist;
-                }
+                out_contributions.push_back({f1.cellIndex, std::uint8_t(CellContribution::eEdgeVis0 + f1.localVertexIndex), weight * dist});
 
                 if(f2.cellIndex == GEO::NO_CELL)
                     ok = false;
@@ -1669,8 +1729,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         // get the outer tetrahedron of camera c for the ray to p = the last tetrahedron
         if(lastFinite != GEO::NO_CELL)
         {
-#pragma OMP_ATOMIC_WRITE
-            _cellsAttr[lastFinite].cellSWeight = (float)maxint;
+            out_contributions.push_back({lastFinite, CellContribution::eSWeightMax, (float)maxint});
         }
     }
 
@@ -1683,8 +1742,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         CellIndex ci = f1.cellIndex;
         if(ci != GEO::NO_CELL)
         {
-#pragma OMP_ATOMIC_UPDATE
-            _cellsAttr[ci].on += weight;
+            out_contributions.push_back({ci, CellContribution::eOn, weight});
         }
 
         Point3d p = po; // HAS TO BE HERE !!!
@@ -1692,15 +1750,12 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         bool ok = (ci != GEO::NO_CELL) && allPoints;
         while(ok)
         {
-            GC_cellInfo& c = _cellsAttr[ci];
             {
                 if(behind)
                 {
-#pragma OMP_ATOMIC_UPDATE
-                    c.cellTWeight += weight;
+                    out_contributions.push_back({ci, CellContribution::eTWeight, weight});
                 }
-#pragma OMP_ATOMIC_UPDATE
-                c.in += weight;
+                out_contributions.push_back({ci, CellContribution::eIn, weight});
             }
 
             ++out_nstepsBehind;
@@ -1730,8 +1785,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
                 }
                 else
                 {
-#pragma OMP_ATOMIC_UPDATE
-                    _cellsAttr[f2.cellIndex].gEdgeVisWeight[f2.localVertexIndex] += weight * dist;
+                    out_contributions.push_back({f2.cellIndex, std::uint8_t(CellContribution::eEdgeVis0 + f2.localVertexIndex), weight * dist});
                 }
                 ci = f2.cellIndex;
             }
@@ -1742,8 +1796,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         {
             if(ci != GEO::NO_CELL)
             {
-#pragma OMP_ATOMIC_UPDATE
-                _cellsAttr[ci].cellTWeight += weight;
+                out_contributions.push_back({ci, CellContribution::eTWeight, weight});
             }
         }
     }
@@ -2473,12 +2526,28 @@ void DelaunayGraphCut::reconstructGC(const Point3d* hexah)
 }
 
 void DelaunayGraphCut::maxflow()
+{
+    ALICEVISION_LOG_INFO("Maxflow method: " << maxflowMethod);
+
+    switch(maxflowMethod)
+    {
+        case EMaxFlowMethod::BoykovKolmogorov:
+            maxflowImpl<MaxFlow_AdjList>();
+            break;
+        case EMaxFlowMethod::IBFS:
+            maxflowImpl<MaxFlow_IBFS>();
+            break;
+    }
+}
+
+template<class MaxFlowT>
+void DelaunayGraphCut::maxflowImpl()
 {
     long t_maxflow = clock();
 
     ALICEVISION_LOG_INFO("Maxflow: start allocation.");
     // MaxFlow_CSR maxFlowGraph(_cellsAttr.size());
-    MaxFlow_AdjList maxFlowGraph(_cellsAttr.size());
+    MaxFlowT maxFlowGraph(_cellsAttr.size());
 
     ALICEVISION_LOG_INFO("Maxflow: add nodes.");
     // fill s-t edges
@@ -22,8 +22,11 @@
 #include <geogram/mesh/mesh.h>
 #include <geogram/basic/geometry_nd.h>
 
+#include <cstdint>
+#include <iostream>
 #include <map>
 #include <set>
+#include <string>
 
 namespace aliceVision {
 namespace fuseCut {
@@ -51,6 +54,41 @@ struct FuseParams
     bool refineFuse = true;
 };
 
+/**
+ * @brief Available maxflow algorithms for the graph cut
+ */
+enum class EMaxFlowMethod {
+    BoykovKolmogorov = 0, //< Boost Boykov-Kolmogorov on an adjacency list graph (MaxFlow_AdjList)
+    IBFS = 1              //< Incremental breadth-first search on a compact CSR graph (MaxFlow_IBFS)
+};
+
+/**
+ * @brief returns the EMaxFlowMethod enum from a string.
+ * @param[in] method the input string.
+ * @return the associated EMaxFlowMethod enum.
+ */
+EMaxFlowMethod EMaxFlowMethod_stringToEnum(const std::string& method);
+
+/**
+ * @brief converts an EMaxFlowMethod enum to a string.
+ * @param[in] method the EMaxFlowMethod enum to convert.
+ * @return the string associated to the EMaxFlowMethod enum.
+ */
+std::string EMaxFlowMethod_enumToString(EMaxFlowMethod method);
+
+inline std::ostream& operator<<(std::ostream& os, EMaxFlowMethod method)
+{
+    return os << EMaxFlowMethod_enumToString(method);
+}
+
+inline std::istream& operator>>(std::istream& in, EMaxFlowMethod& method)
+{
+    std::string token;
+    in >> token;
+    method = EMaxFlowMethod_stringToEnum(token);
+    return in;
+}
+
 
 class DelaunayGraphCut
 {
@@ -71,6 +109,24 @@ public:
         VertexIndex localVertexIndex = GEO::NO_VERTEX;
     };
 
+    /// Weight added to a cell by the rays casted in fillGraph
+    struct CellContribution
+    {
+        enum EField : std::uint8_t
+        {
+            eIn = 0,
+            eOut,
+            eOn,
+            eTWeight,
+            eSWeightMax, //< set cellSWeight to a large value
+            eEdgeVis0    //< eEdgeVis0 + i is gEdgeVisWeight[i]
+        };
+
+        CellIndex cellIndex;
+        std::uint8_t field;
+        float weight;
+    };
+
     mvsUtils::MultiViewParams* mp;
     mvsUtils::PreMatchCams* pc;
 
@@ -88,6 +144,10 @@ public:
     std::vector<std::vector<CellIndex>> _neighboringCellsPerVertex;
 
     bool saveTemporaryBinFiles;
+    /// Algorithm used to compute the graph cut
+    EMaxFlowMethod maxflowMethod = EMaxFlowMethod::BoykovKolmogorov;
+    /// Number of vertices whose rays are casted in parallel before their weights are added to the cells in fillGraph
+    int fillGraphBatchSize = 10000;
 
     static const GEO::index_t NO_TETRAHEDRON = GEO::NO_CELL;
 
@@ -289,9 +349,14 @@ public:
 
     virtual void fillGraph(bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool labatutWeights,
                            bool fillOut, float distFcnHeight = 0.0f);
-    void fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam, float weight,
-                           bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool fillOut,
-                           float distFcnHeight);
+    /**
+     * @brief Cast the rays between a vertex and one of its cameras through the tetrahedralization.
+     * The weights are not added to _cellsAttr but to out_contributions, so it can be called in parallel.
+     */
+    void fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, std::vector<CellContribution>& out_contributions,
+                           int vertexIndex, int cam, float weight, bool fixesSigma, float nPixelSizeBehind,
+                           bool allPoints, bool behind, bool fillOut, float distFcnHeight);
+    void addCellContribution(const CellContribution& contribution);
 
     void forceTedgesByGradientCVPR11(bool fixesSigma, float nPixelSizeBehind);
     void forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSizeBehind);
@@ -311,6 +376,9 @@ public:
 
     void maxflow();
 
+    template<class MaxFlowT>
+    void maxflowImpl();
+
     void reconstructExpetiments(const StaticVector<int>& cams, const std::string& folderName,
                                 bool update, Point3d hexahInflated[8], const std::string& tmpCamsPtsFolderName,
                                 const Point3d& spaceSteps);
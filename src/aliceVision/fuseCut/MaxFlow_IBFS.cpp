@@ -0,0 +1,376 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MaxFlow_IBFS.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace aliceVision {
+namespace fuseCut {
+
+namespace {
+const MaxFlow_IBFS::ArcIndex noArc = std::numeric_limits<MaxFlow_IBFS::ArcIndex>::max();
+const MaxFlow_IBFS::ArcIndex terminalArc = noArc - 1;
+const MaxFlow_IBFS::ArcIndex orphanArc = noArc - 2;
+}
+
+void MaxFlow_IBFS::buildGraph()
+{
+    const std::size_t nbArcs = _edges.size() * 2;
+    if(nbArcs >= orphanArc)
+        throw std::runtime_error("MaxFlow_IBFS: too many edges (" + std::to_string(_edges.size()) + ").");
+
+    // count the out arcs of each node
+    _firstArc.assign(_numNodes + 1, 0);
+    for(const InputEdge& e : _edges)
+    {
+        ++_firstArc[e.n1 + 1];
+        ++_firstArc[e.n2 + 1];
+    }
+    for(std::size_t n = 0; n < _numNodes; ++n)
+        _firstArc[n + 1] += _firstArc[n];
+
+    _arcHead.resize(nbArcs);
+    _arcSister.resize(nbArcs);
+    _arcResidual.resize(nbArcs);
+
+    // each edge creates an arc and its reverse arc
+    std::vector<ArcIndex> nextArc(_firstArc.begin(), _firstArc.end() - 1);
+    for(const InputEdge& e : _edges)
+    {
+        const ArcIndex a = nextArc[e.n1]++;
+        const ArcIndex r = nextArc[e.n2]++;
+        _arcHead[a] = e.n2;
+        _arcResidual[a] = e.capacity;
+        _arcSister[a] = r;
+        _arcHead[r] = e.n1;
+        _arcResidual[r] = e.reverseCapacity;
+        _arcSister[r] = a;
+    }
+    std::vector<InputEdge>().swap(_edges); // force clear
+}
+
+void MaxFlow_IBFS::enqueue(SearchTree& searchTree, NodeType n)
+{
+    if(_queued[n])
+        return;
+    _queued[n] = true;
+    if(_label[n] <= searchTree.level)
+        searchTree.current.push_back(n);
+    else
+        searchTree.next.push_back(n);
+}
+
+void MaxFlow_IBFS::makeOrphan(SearchTree& searchTree, NodeType n)
+{
+    _parentArc[n] = orphanArc;
+    searchTree.orphans.emplace(_label[n], n);
+}
+
+void MaxFlow_IBFS::adopt(SearchTree& searchTree)
+{
+    // The orphans are processed by increasing label: all the nodes with a lower label have a valid path
+    // to the terminal, so a parent with the label just below cannot be a descendant of the orphan.
+    while(!searchTree.orphans.empty())
+    {
+        const std::uint32_t label = searchTree.orphans.top().first;
+        const NodeType n = searchTree.orphans.top().second;
+        searchTree.orphans.pop();
+
+        if(_tree[n] != searchTree.tree || _parentArc[n] != orphanArc || _label[n] != label)
+            continue;
+
+        const ArcIndex lastArc = _firstArc[n + 1];
+
+        // look for a new parent with the same label
+        if(label == 1)
+        {
+            if(terminalCapacity(searchTree, n) > 0)
+                _parentArc[n] = terminalArc;
+        }
+        else
+        {
+            for(ArcIndex a = _firstArc[n]; a < lastArc; ++a)
+            {
+                const NodeType m = _arcHead[a];
+                if(_tree[m] == searchTree.tree && _label[m] + 1 == label && _parentArc[m] != orphanArc &&
+                   outArcResidual(searchTree, _arcSister[a]) > 0)
+                {
+                    _parentArc[n] = a;
+                    break;
+                }
+            }
+        }
+
+        if(_parentArc[n] != orphanArc)
+        {
+            // its arcs may lead to nodes freed in the meantime
+            enqueue(searchTree, n);
+            continue;
+        }
+
+        // relabel: the children become orphans
+        std::uint32_t minLabel = std::numeric_limits<std::uint32_t>::max();
+        ArcIndex minArc = noArc;
+        for(ArcIndex a = _firstArc[n]; a < lastArc; ++a)
+        {
+            const NodeType m = _arcHead[a];
+            if(_tree[m] != searchTree.tree)
+                continue;
+            if(_parentArc[m] == _arcSister[a])
+                makeOrphan(searchTree, m);
+            else if(_parentArc[m] != orphanArc && _label[m] < minLabel && outArcResidual(searchTree, _arcSister[a]) > 0)
+            {
+                minLabel = _label[m];
+                minArc = a;
+            }
+        }
+
+        if(minArc != noArc && minLabel < label)
+        {
+            // a parent with a lower label has a valid path to the terminal
+            _label[n] = minLabel + 1;
+            _parentArc[n] = minArc;
+            enqueue(searchTree, n);
+        }
+        else if(minArc != noArc && minLabel <= searchTree.level)
+        {
+            // the parent will be looked for with the new label
+            _label[n] = minLabel + 1;
+            searchTree.orphans.emplace(_label[n], n);
+        }
+        else
+        {
+            // no node of the tree scanned so far can reach n
+            _tree[n] = FREE;
+            _parentArc[n] = noArc;
+            _queued[n] = false;
+        }
+    }
+}
+
+void MaxFlow_IBFS::augment(ArcIndex a)
+{
+    const NodeType sourceSide = _arcHead[_arcSister[a]];
+    const NodeType sinkSide = _arcHead[a];
+
+    // bottleneck
+    ValueType delta = _arcResidual[a];
+    NodeType n = sourceSide;
+    for(; _parentArc[n] != terminalArc; n = _arcHead[_parentArc[n]])
+        delta = std::min(delta, _arcResidual[_arcSister[_parentArc[n]]]);
+    delta = std::min(delta, _sourceCapacity[n]);
+    for(n = sinkSide; _parentArc[n] != terminalArc; n = _arcHead[_parentArc[n]])
+        delta = std::min(delta, _arcResidual[_parentArc[n]]);
+    delta = std::min(delta, _sinkCapacity[n]);
+
+    // push the flow, the nodes below a saturated arc become orphans
+    _arcResidual[a] -= delta;
+    _arcResidual[_arcSister[a]] += delta;
+
+    for(n = sourceSide; ;)
+    {
+        const ArcIndex p = _parentArc[n];
+        if(p == terminalArc)
+        {
+            _sourceCapacity[n] -= delta;
+            if(_sourceCapacity[n] <= 0)
+                makeOrphan(_sourceTree, n);
+            break;
+        }
+        const NodeType parent = _arcHead[p];
+        _arcResidual[_arcSister[p]] -= delta;
+        _arcResidual[p] += delta;
+        if(_arcResidual[_arcSister[p]] <= 0)
+            makeOrphan(_sourceTree, n);
+        n = parent;
+    }
+    for(n = sinkSide; ;)
+    {
+        const ArcIndex p = _parentArc[n];
+        if(p == terminalArc)
+        {
+            _sinkCapacity[n] -= delta;
+            if(_sinkCapacity[n] <= 0)
+                makeOrphan(_sinkTree, n);
+            break;
+        }
+        const NodeType parent = _arcHead[p];
+        _arcResidual[p] -= delta;
+        _arcResidual[_arcSister[p]] += delta;
+        if(_arcResidual[p] <= 0)
+            makeOrphan(_sinkTree, n);
+        n = parent;
+    }
+    _flow += delta;
+
+    adopt(_sourceTree);
+    adopt(_sinkTree);
+}
+
+void MaxFlow_IBFS::scan(SearchTree& searchTree, NodeType n)
+{
+    const std::uint32_t label = _label[n];
+    const ArcIndex lastArc = _firstArc[n + 1];
+
+    for(ArcIndex a = _firstArc[n]; a < lastArc; ++a)
+    {
+        while(outArcResidual(searchTree, a) > 0)
+        {
+            const NodeType m = _arcHead[a];
+            if(_tree[m] == FREE)
+            {
+                _tree[m] = searchTree.tree;
+                _label[m] = label + 1;
+                _parentArc[m] = _arcSister[a];
+                enqueue(searchTree, m);
+                break;
+            }
+            if(_tree[m] == searchTree.tree)
+                break;
+
+            augment(searchTree.tree == SOURCE_TREE ? a : _arcSister[a]);
+
+            // n has been freed or relabeled, it is queued again if needed
+            if(_tree[n] != searchTree.tree || _label[n] != label)
+                return;
+        }
+    }
+}
+
+bool MaxFlow_IBFS::grow(SearchTree& searchTree)
+{
+    const auto scanQueue = [&]()
+    {
+        // the queue can grow while it is scanned
+        for(std::size_t i = 0; i < searchTree.current.size(); ++i)
+        {
+            const NodeType n = searchTree.current[i];
+            _queued[n] = false;
+            if(_tree[n] != searchTree.tree)
+                continue;
+            if(_label[n] > searchTree.level)
+                enqueue(searchTree, n);
+            else
+                scan(searchTree, n);
+        }
+        searchTree.current.clear();
+    };
+
+    // nodes waiting for a scan at the current level (orphans attached again)
+    scanQueue();
+
+    if(searchTree.next.empty())
+        return false;
+
+    ++searchTree.level;
+    searchTree.current.swap(searchTree.next);
+    scanQueue();
+    return true;
+}
+
+void MaxFlow_IBFS::computeCut()
+{
+    // backward breadth-first search from the sink in the residual graph
+    _isTarget.assign(_numNodes, false);
+    std::vector<NodeType> queue;
+    queue.reserve(_numNodes);
+    for(NodeType n = 0; n < _numNodes; ++n)
+    {
+        if(_sinkCapacity[n] > 0)
+        {
+            _isTarget[n] = true;
+            queue.push_back(n);
+        }
+    }
+    for(std::size_t i = 0; i < queue.size(); ++i)
+    {
+        const NodeType n = queue[i];
+        for(ArcIndex a = _firstArc[n]; a < _firstArc[n + 1]; ++a)
+        {
+            const NodeType m = _arcHead[a];
+            if(!_isTarget[m] && _arcResidual[_arcSister[a]] > 0)
+            {
+                _isTarget[m] = true;
+                queue.push_back(m);
+            }
+        }
+    }
+}
+
+MaxFlow_IBFS::ValueType MaxFlow_IBFS::compute()
+{
+    ALICEVISION_LOG_INFO("Compute ibfs_max_flow.");
+
+    buildGraph();
+
+    ALICEVISION_LOG_INFO("# vertices: " << _numNodes);
+    ALICEVISION_LOG_INFO("# edges: " << _arcHead.size());
+
+    _tree.assign(_numNodes, FREE);
+    _label.assign(_numNodes, 0);
+    _parentArc.assign(_numNodes, noArc);
+    _queued.assign(_numNodes, false);
+
+    _sourceTree.tree = SOURCE_TREE;
+    _sinkTree.tree = SINK_TREE;
+
+    _flow = 0.0;
+    for(NodeType n = 0; n < _numNodes; ++n)
+    {
+        // the flow going directly from the source to the sink is not stored in the graph
+        const ValueType direct = std::min(_sourceCapacity[n], _sinkCapacity[n]);
+        _sourceCapacity[n] -= direct;
+        _sinkCapacity[n] -= direct;
+        _flow += direct;
+
+        // the nodes linked to a terminal are the roots of the search trees
+        SearchTree* searchTree = nullptr;
+        if(_sourceCapacity[n] > 0)
+            searchTree = &_sourceTree;
+        else if(_sinkCapacity[n] > 0)
+            searchTree = &_sinkTree;
+        else
+            continue;
+
+        _tree[n] = searchTree->tree;
+        _label[n] = 1;
+        _parentArc[n] = terminalArc;
+        enqueue(*searchTree, n);
+    }
+
+    ALICEVISION_LOG_INFO("ibfs_max_flow: start.");
+
+    // grow the smallest tree, until one of them cannot grow anymore
+    while(true)
+    {
+        SearchTree& searchTree = (_sourceTree.next.size() + _sourceTree.current.size() <=
+                                  _sinkTree.next.size() + _sinkTree.current.size()) ? _sourceTree : _sinkTree;
+        if(!grow(searchTree))
+            break;
+    }
+    ALICEVISION_LOG_INFO("ibfs_max_flow: done (source tree depth: " << _sourceTree.level << ", sink tree depth: " << _sinkTree.level << ").");
+
+    computeCut();
+
+    // release the graph, only the cut is needed from now on
+    std::vector<ArcIndex>().swap(_firstArc);
+    std::vector<NodeType>().swap(_arcHead);
+    std::vector<ArcIndex>().swap(_arcSister);
+    std::vector<ValueType>().swap(_arcResidual);
+    std::vector<ETree>().swap(_tree);
+    std::vector<std::uint32_t>().swap(_label);
+    std::vector<ArcIndex>().swap(_parentArc);
+    std::vector<bool>().swap(_queued);
+
+    return static_cast<ValueType>(_flow);
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
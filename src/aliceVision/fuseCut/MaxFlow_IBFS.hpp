@@ -0,0 +1,180 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Maxflow computation based on the Incremental Breadth-First Search algorithm (IBFS)
+ * on a compact compressed sparse row graph.
+ *
+ * IBFS grows a source and a sink search trees, like Boykov-Kolmogorov, but keeps them as
+ * breadth-first search trees with exact distance labels: the trees grow level by level and
+ * the orphans of an augmentation are re-attached by increasing label.
+ * @see Goldberg, Hed, Kaplan, Kohli, Tarjan, Werneck, "Faster and More Dynamic Maximum Flow
+ *      by Incremental Breadth-First Search", ESA 2015.
+ *
+ * - Each edge and its reverse edge are stored next to each other's index (no temporary map is needed
+ *   to retrieve the reverse edges, as in MaxFlow_CSR).
+ * - The source and sink edges are not stored in the graph: they are kept as per-node capacities,
+ *   so the terminal nodes do not need a huge adjacency list.
+ *
+ * The resulting cut is the same as the one of MaxFlow_AdjList: a node is on the target side
+ * if the sink can be reached from it in the residual graph.
+ */
+class MaxFlow_IBFS
+{
+public:
+    using NodeType = unsigned int;
+    using ValueType = float;
+    using ArcIndex = std::uint32_t;
+
+public:
+    explicit MaxFlow_IBFS(std::size_t numNodes)
+        : _numNodes(numNodes)
+        , _sourceCapacity(numNodes, 0.0f)
+        , _sinkCapacity(numNodes, 0.0f)
+    {
+        _edges.reserve(numNodes * 4);
+    }
+
+    inline void addNode(NodeType n, ValueType source, ValueType sink)
+    {
+        assert(source >= 0 && sink >= 0);
+        ValueType score = source - sink;
+        if(score > 0)
+            _sourceCapacity[n] += score;
+        else //if(score <= 0)
+            _sinkCapacity[n] += -score;
+    }
+
+    inline void addEdge(NodeType n1, NodeType n2, ValueType capacity, ValueType reverseCapacity)
+    {
+        assert(capacity >= 0 && reverseCapacity >= 0);
+        _edges.push_back({n1, n2, capacity, reverseCapacity});
+    }
+
+    ValueType compute();
+
+    /// is empty
+    inline bool isSource(NodeType n) const
+    {
+        return !_isTarget[n];
+    }
+    /// is full
+    inline bool isTarget(NodeType n) const
+    {
+        return _isTarget[n];
+    }
+
+private:
+    struct InputEdge
+    {
+        NodeType n1;
+        NodeType n2;
+        ValueType capacity;
+        ValueType reverseCapacity;
+    };
+
+    enum ETree : std::uint8_t
+    {
+        FREE = 0,
+        SOURCE_TREE = 1,
+        SINK_TREE = 2
+    };
+
+    /// Search tree data, for the source or the sink side
+    struct SearchTree
+    {
+        ETree tree;
+        /// all the nodes of the tree with a label up to level have been scanned
+        std::uint32_t level = 0;
+        /// nodes to scan at the current level (new nodes with a lower label and re-attached orphans)
+        std::vector<NodeType> current;
+        /// nodes with the label level + 1, to scan at the next level
+        std::vector<NodeType> next;
+        /// orphans (label, node), re-attached by increasing label
+        std::priority_queue<std::pair<std::uint32_t, NodeType>,
+                            std::vector<std::pair<std::uint32_t, NodeType>>,
+                            std::greater<std::pair<std::uint32_t, NodeType>>> orphans;
+    };
+
+    /// Build the CSR graph from the input edges (which are released)
+    void buildGraph();
+
+    /// Residual capacity of the arc from the parent of n to n in the source tree,
+    /// from n to its parent in the sink tree
+    inline ValueType& treeArcResidual(const SearchTree& searchTree, NodeType n)
+    {
+        return (searchTree.tree == SOURCE_TREE) ? _arcResidual[_arcSister[_parentArc[n]]] : _arcResidual[_parentArc[n]];
+    }
+    /// Residual capacity of the arc a from a node of the tree to the node at its head
+    inline ValueType outArcResidual(const SearchTree& searchTree, ArcIndex a) const
+    {
+        return (searchTree.tree == SOURCE_TREE) ? _arcResidual[a] : _arcResidual[_arcSister[a]];
+    }
+    inline ValueType& terminalCapacity(const SearchTree& searchTree, NodeType n)
+    {
+        return (searchTree.tree == SOURCE_TREE) ? _sourceCapacity[n] : _sinkCapacity[n];
+    }
+
+    /// Add a node to the scan queue matching its label
+    void enqueue(SearchTree& searchTree, NodeType n);
+    /// Scan the queued nodes of a tree, then its next level
+    /// @return false if the tree cannot grow anymore (the flow is maximum)
+    bool grow(SearchTree& searchTree);
+    void scan(SearchTree& searchTree, NodeType n);
+    /// Augment the flow along the path going through the arc a (from the source tree to the sink tree)
+    void augment(ArcIndex a);
+    void makeOrphan(SearchTree& searchTree, NodeType n);
+    /// Re-attach the orphans of a tree, or free them
+    void adopt(SearchTree& searchTree);
+
+    /// Find the nodes that can reach the sink in the residual graph
+    void computeCut();
+
+    std::size_t _numNodes;
+
+    /// Edges added with addEdge, before the CSR graph creation
+    std::vector<InputEdge> _edges;
+    /// Residual capacity from the source, to the sink
+    std::vector<ValueType> _sourceCapacity;
+    std::vector<ValueType> _sinkCapacity;
+
+    /// CSR graph: arcs of node n are [_firstArc[n], _firstArc[n+1])
+    std::vector<ArcIndex> _firstArc;
+    std::vector<NodeType> _arcHead;
+    std::vector<ArcIndex> _arcSister;
+    std::vector<ValueType> _arcResidual;
+
+    /// Search trees
+    std::vector<ETree> _tree;
+    std::vector<std::uint32_t> _label;
+    /// Arc from a node to its parent (or terminalArc / orphanArc)
+    std::vector<ArcIndex> _parentArc;
+    std::vector<bool> _queued;
+
+    SearchTree _sourceTree;
+    SearchTree _sinkTree;
+
+    double _flow = 0.0;
+
+    std::vector<bool> _isTarget;
+};
+
+} // namespace fuseCut
+} // namespace aliceVision
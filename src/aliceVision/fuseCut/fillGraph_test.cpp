@@ -0,0 +1,145 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
+#include <aliceVision/mvsData/structures.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/mvsTestUtils.hpp>
+
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE fillGraph
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+static const int imageWidth = 64;
+static const int imageHeight = 48;
+
+/**
+ * @brief Tetrahedralization of random points around the unit sphere and of the camera centers.
+ * Each point is seen by the cameras in front of it.
+ */
+void initRandomScene(DelaunayGraphCut& delaunayGC, int nbPoints)
+{
+  const mvsUtils::MultiViewParams& mp = *delaunayGC.mp;
+
+  std::mt19937 generator(42);
+  std::normal_distribution<double> direction(0.0, 1.0);
+  std::uniform_real_distribution<double> radius(0.9, 1.1);
+  std::uniform_int_distribution<int> nbRefinements(0, 2);
+
+  for(int i = 0; i < nbPoints; ++i)
+  {
+    Point3d p(direction(generator), direction(generator), direction(generator));
+    p = p.normalize() * radius(generator);
+
+    GC_vertexInfo v;
+    for(int cam = 0; cam < mp.ncams; ++cam)
+    {
+      if(dot(p, mp.CArr[cam]) > 0.0)
+        v.cams.push_back(cam);
+    }
+    v.nrc = v.cams.size() + nbRefinements(generator);
+
+    delaunayGC._verticesCoords.push_back(p);
+    delaunayGC._verticesAttr.push_back(v);
+  }
+
+  // camera centers, as virtual vertices
+  for(int cam = 0; cam < mp.ncams; ++cam)
+  {
+    delaunayGC._camsVertexes[cam] = delaunayGC._verticesCoords.size();
+    delaunayGC._verticesCoords.push_back(mp.CArr[cam]);
+    delaunayGC._verticesAttr.push_back(GC_vertexInfo());
+  }
+
+  delaunayGC.computeDelaunay();
+}
+
+/**
+ * @brief Reference fillGraph: casts the rays one after the other, in the vertices order,
+ * and adds their weights to the cells right away.
+ */
+void fillGraphSerial(DelaunayGraphCut& delaunayGC, bool fixesSigma, float nPixelSizeBehind, bool behind,
+                     bool labatutWeights, bool fillOut)
+{
+  for(GC_cellInfo& c : delaunayGC._cellsAttr)
+    c = GC_cellInfo();
+
+  std::vector<DelaunayGraphCut::CellContribution> contributions;
+  for(int iV = 0; iV < delaunayGC._verticesAttr.size(); ++iV)
+  {
+    const GC_vertexInfo& v = delaunayGC._verticesAttr[iV];
+    if(!v.isReal() || v.nrc <= 0)
+      continue;
+
+    for(int c = 0; c < v.cams.size(); ++c)
+    {
+      const float weight = delaunayGC.weightFcn((float)v.nrc, labatutWeights, v.getNbCameras());
+      int nstepsFront = 0;
+      int nstepsBehind = 0;
+      contributions.clear();
+      delaunayGC.fillGraphPartPtRc(nstepsFront, nstepsBehind, contributions, iV, v.cams[c], weight, fixesSigma,
+                                   nPixelSizeBehind, true, behind, fillOut, 0.0f);
+      for(const DelaunayGraphCut::CellContribution& contribution : contributions)
+        delaunayGC.addCellContribution(contribution);
+    }
+  }
+}
+
+void checkSameCells(const std::vector<GC_cellInfo>& cells, const std::vector<GC_cellInfo>& cellsRef)
+{
+  BOOST_REQUIRE_EQUAL(cells.size(), cellsRef.size());
+  for(std::size_t ci = 0; ci < cells.size(); ++ci)
+  {
+    BOOST_CHECK_EQUAL(cells[ci].cellSWeight, cellsRef[ci].cellSWeight);
+    BOOST_CHECK_EQUAL(cells[ci].cellTWeight, cellsRef[ci].cellTWeight);
+    BOOST_CHECK_EQUAL(cells[ci].in, cellsRef[ci].in);
+    BOOST_CHECK_EQUAL(cells[ci].out, cellsRef[ci].out);
+    BOOST_CHECK_EQUAL(cells[ci].on, cellsRef[ci].on);
+    for(int k = 0; k < 4; ++k)
+      BOOST_CHECK_EQUAL(cells[ci].gEdgeVisWeight[k], cellsRef[ci].gEdgeVisWeight[k]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(fillGraph_batchedEqualsSerial)
+{
+  const mvsUtils::SceneFixture scene("fillGraph", mvsUtils::cameraCentersAroundOrigin(6), imageWidth, imageHeight);
+  DelaunayGraphCut delaunayGC(scene.mp.get(), nullptr);
+  initRandomScene(delaunayGC, 500);
+
+  // several batches, processed by several threads
+  delaunayGC.fillGraphBatchSize = 37;
+  omp_set_num_threads(4);
+
+  for(bool behind : {false, true})
+  {
+    const bool fixesSigma = true;
+    const float nPixelSizeBehind = 0.1f;
+
+    delaunayGC.fillGraph(fixesSigma, nPixelSizeBehind, true, behind, false, true);
+    const std::vector<GC_cellInfo> cells = delaunayGC._cellsAttr;
+
+    fillGraphSerial(delaunayGC, fixesSigma, nPixelSizeBehind, behind, false, true);
+    checkSameCells(cells, delaunayGC._cellsAttr);
+
+    // the rays have been casted through the cells
+    float totalOut = 0.0f;
+    float totalIn = 0.0f;
+    for(const GC_cellInfo& c : cells)
+    {
+      totalOut += c.out;
+      totalIn += c.in;
+    }
+    BOOST_CHECK_GT(totalOut, 0.0f);
+    BOOST_CHECK_GT(totalIn, 0.0f);
+  }
+}
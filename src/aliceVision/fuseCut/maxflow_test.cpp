@@ -0,0 +1,209 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_IBFS.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <cstddef>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#define BOOST_TEST_MODULE maxflow
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+struct TestEdge
+{
+  std::size_t n1;
+  std::size_t n2;
+  float capacity;
+  float reverseCapacity;
+};
+
+struct TestGraph
+{
+  std::size_t nbNodes = 0;
+  std::vector<float> source;
+  std::vector<float> sink;
+  std::vector<TestEdge> edges;
+};
+
+/**
+ * @brief Create a graph similar to the DelaunayGraphCut one on a regular 3D grid:
+ * each node has a source or sink weight and each pair of neighbors is added twice (once per facet side).
+ * Capacities are small integers, so all solvers compute the exact same residual graph values.
+ */
+TestGraph createGridGraph(std::size_t size, unsigned int seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<int> terminalDistribution(0, 20);
+  std::uniform_int_distribution<int> edgeDistribution(0, 10);
+
+  TestGraph graph;
+  graph.nbNodes = size * size * size;
+  graph.source.resize(graph.nbNodes);
+  graph.sink.resize(graph.nbNodes);
+
+  const auto index = [size](std::size_t x, std::size_t y, std::size_t z) { return (z * size + y) * size + x; };
+
+  for(std::size_t z = 0; z < size; ++z)
+  {
+    for(std::size_t y = 0; y < size; ++y)
+    {
+      for(std::size_t x = 0; x < size; ++x)
+      {
+        const std::size_t n = index(x, y, z);
+        // more source weight (empty) outside of a central ball, more sink weight (full) inside
+        const double dx = 2.0 * x / (size - 1) - 1.0;
+        const double dy = 2.0 * y / (size - 1) - 1.0;
+        const double dz = 2.0 * z / (size - 1) - 1.0;
+        const bool inside = (dx * dx + dy * dy + dz * dz) < 0.6;
+        graph.source[n] = float(terminalDistribution(generator) + (inside ? 0 : 20));
+        graph.sink[n] = float(terminalDistribution(generator) + (inside ? 20 : 0));
+
+        const std::size_t neighbors[3] = {
+          (x + 1 < size) ? index(x + 1, y, z) : n,
+          (y + 1 < size) ? index(x, y + 1, z) : n,
+          (z + 1 < size) ? index(x, y, z + 1) : n,
+        };
+        for(std::size_t m : neighbors)
+        {
+          if(m == n)
+            continue;
+          const float c1 = float(edgeDistribution(generator));
+          const float c2 = float(edgeDistribution(generator));
+          graph.edges.push_back({n, m, c1, c2});
+          graph.edges.push_back({m, n, c2, c1});
+        }
+      }
+    }
+  }
+  return graph;
+}
+
+template<class MaxFlowT>
+float computeCut(const TestGraph& graph, std::vector<bool>& isTarget)
+{
+  MaxFlowT maxFlowGraph(graph.nbNodes);
+  for(std::size_t n = 0; n < graph.nbNodes; ++n)
+    maxFlowGraph.addNode(n, graph.source[n], graph.sink[n]);
+  for(const TestEdge& e : graph.edges)
+    maxFlowGraph.addEdge(e.n1, e.n2, e.capacity, e.reverseCapacity);
+
+  const float flow = maxFlowGraph.compute();
+
+  isTarget.resize(graph.nbNodes);
+  for(std::size_t n = 0; n < graph.nbNodes; ++n)
+    isTarget[n] = maxFlowGraph.isTarget(n);
+
+  return flow;
+}
+
+void checkSameCut(std::size_t size, unsigned int seed)
+{
+  const TestGraph graph = createGridGraph(size, seed);
+
+  std::vector<bool> isTargetBK;
+  std::vector<bool> isTargetIBFS;
+
+  const float flowBK = computeCut<MaxFlow_AdjList>(graph, isTargetBK);
+  const float flowIBFS = computeCut<MaxFlow_IBFS>(graph, isTargetIBFS);
+
+  BOOST_CHECK_CLOSE(flowBK, flowIBFS, 1e-4);
+
+  std::size_t nbTargets = 0;
+  std::size_t nbDifferences = 0;
+  for(std::size_t n = 0; n < graph.nbNodes; ++n)
+  {
+    nbTargets += isTargetIBFS[n];
+    nbDifferences += (isTargetBK[n] != isTargetIBFS[n]);
+  }
+
+  BOOST_CHECK_EQUAL(nbDifferences, 0);
+  // the cut is not trivial
+  BOOST_CHECK(nbTargets > 0);
+  BOOST_CHECK(nbTargets < graph.nbNodes);
+}
+
+BOOST_AUTO_TEST_CASE(maxflow_IBFS_small)
+{
+  for(unsigned int seed = 0; seed < 100; ++seed)
+    checkSameCut(8, seed);
+}
+
+BOOST_AUTO_TEST_CASE(maxflow_IBFS_large)
+{
+  checkSameCut(60, 42);
+}
+
+BOOST_AUTO_TEST_CASE(maxflow_IBFS_benchmark)
+{
+  // about 1M cells, all with source and sink weights, as the cells crossed by the camera rays in DelaunayGraphCut
+  const std::size_t size = 100;
+  const TestGraph graph = createGridGraph(size, 7);
+
+  std::vector<bool> isTargetBK;
+  std::vector<bool> isTargetIBFS;
+
+  system::Timer timer;
+  const float flowBK = computeCut<MaxFlow_AdjList>(graph, isTargetBK);
+  const double timeBK = timer.elapsedMs();
+
+  timer.reset();
+  const float flowIBFS = computeCut<MaxFlow_IBFS>(graph, isTargetIBFS);
+  const double timeIBFS = timer.elapsedMs();
+
+  BOOST_CHECK_CLOSE(flowBK, flowIBFS, 1e-4);
+  BOOST_CHECK(isTargetBK == isTargetIBFS);
+
+  std::stringstream ss;
+  ss << "\t- BoykovKolmogorov (MaxFlow_AdjList): " << timeBK << " ms" << std::endl
+     << "\t- IBFS (MaxFlow_IBFS): " << timeIBFS << " ms (x" << timeBK / timeIBFS << ")" << std::endl;
+  ALICEVISION_LOG_INFO("Maxflow on a graph of " << graph.nbNodes << " nodes and " << graph.edges.size()
+                       << " edges (graph construction included):" << std::endl << ss.str());
+}
+
+BOOST_AUTO_TEST_CASE(maxflow_IBFS_empty)
+{
+  // no edge: each node is on the side of its largest terminal weight
+  MaxFlow_IBFS maxFlowGraph(3);
+  maxFlowGraph.addNode(0, 2.0f, 1.0f);
+  maxFlowGraph.addNode(1, 1.0f, 2.0f);
+  maxFlowGraph.addNode(2, 1.0f, 1.0f);
+
+  const float flow = maxFlowGraph.compute();
+
+  BOOST_CHECK_EQUAL(flow, 0.0f);
+  BOOST_CHECK(maxFlowGraph.isSource(0));
+  BOOST_CHECK(maxFlowGraph.isTarget(1));
+  BOOST_CHECK(maxFlowGraph.isSource(2));
+}
+
+BOOST_AUTO_TEST_CASE(maxflow_IBFS_chain)
+{
+  // source -6-> 0 -2-> 1 -1-> 2 -10-> sink, with a bypass 0 -4-> 2
+  MaxFlow_IBFS maxFlowGraph(3);
+  maxFlowGraph.addNode(0, 6.0f, 0.0f);
+  maxFlowGraph.addNode(1, 0.0f, 0.0f);
+  maxFlowGraph.addNode(2, 0.0f, 10.0f);
+  maxFlowGraph.addEdge(0, 1, 2.0f, 0.0f);
+  maxFlowGraph.addEdge(1, 2, 1.0f, 0.0f);
+  maxFlowGraph.addEdge(0, 2, 4.0f, 0.0f);
+
+  // the cut is made of the edges going to node 2
+  const float flow = maxFlowGraph.compute();
+
+  BOOST_CHECK_EQUAL(flow, 5.0f);
+  BOOST_CHECK(maxFlowGraph.isSource(0));
+  BOOST_CHECK(maxFlowGraph.isSource(1));
+  BOOST_CHECK(maxFlowGraph.isTarget(2));
+}
@@ -13,6 +13,8 @@
 #include <lemon/list_graph.h>
 
 #include <algorithm>
+#include <cstddef>
+#include <utility>
 #include <vector>
 
 namespace aliceVision {
@@ -119,28 +121,153 @@ bool List_Triplets(const GraphT & g, std::vector< Triplet > & vec_triplets)
   return (!vec_triplets.empty());
 }
 
-/// Return triplets contained in the graph build from IterablePairs
+/**
+ * @brief Undirected graph with a sorted adjacency in compressed sparse row (CSR) format.
+ *
+ * The nodes are indexed in the order of their ids. Each edge is stored once, in the
+ * neighbours of its node of lower index, and its id is its position in the neighbours.
+ */
+struct SortedAdjacencyGraph
+{
+  /// Sorted ids of the nodes (the index of a node is the position of its id)
+  std::vector<IndexT> nodeIds;
+  /// The neighbours of the node i are neighbours[e] for e in [offsets[i], offsets[i+1])
+  std::vector<std::size_t> offsets;
+  /// Indices of the neighbours greater than the node index, sorted
+  std::vector<std::size_t> neighbours;
+
+  SortedAdjacencyGraph() = default;
+
+  /**
+   * @brief Build the graph of the pairs of node ids.
+   * The self loops are ignored and the pairs (i,j), (j,i) give a single edge.
+   */
+  template <typename IterablePairs>
+  explicit SortedAdjacencyGraph(const IterablePairs & pairs)
+  {
+    std::vector<std::pair<IndexT, IndexT>> edges;
+    for (const auto & pair : pairs)
+    {
+      if (pair.first != pair.second)
+        edges.emplace_back(std::min(pair.first, pair.second), std::max(pair.first, pair.second));
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    nodeIds.reserve(2 * edges.size());
+    for (const auto & edge : edges)
+    {
+      nodeIds.push_back(edge.first);
+      nodeIds.push_back(edge.second);
+    }
+    std::sort(nodeIds.begin(), nodeIds.end());
+    nodeIds.erase(std::unique(nodeIds.begin(), nodeIds.end()), nodeIds.end());
+
+    // The edges are sorted by their first node then by their second node,
+    // so the edge e is stored at the position e of the neighbours.
+    offsets.assign(nodeIds.size() + 1, 0);
+    neighbours.resize(edges.size());
+    for (std::size_t e = 0; e < edges.size(); ++e)
+    {
+      ++offsets[nodeIndex(edges[e].first) + 1];
+      neighbours[e] = nodeIndex(edges[e].second);
+    }
+    for (std::size_t i = 0; i < nodeIds.size(); ++i)
+      offsets[i + 1] += offsets[i];
+  }
+
+  std::size_t nbNodes() const { return nodeIds.size(); }
+  std::size_t nbEdges() const { return neighbours.size(); }
+
+  /// Index of a node id of the graph
+  std::size_t nodeIndex(IndexT nodeId) const
+  {
+    return std::lower_bound(nodeIds.begin(), nodeIds.end(), nodeId) - nodeIds.begin();
+  }
+
+  /// Id of the edge between two node ids, nbEdges() if there is no such edge
+  std::size_t edgeId(IndexT nodeId1, IndexT nodeId2) const
+  {
+    const std::size_t i = nodeIndex(std::min(nodeId1, nodeId2));
+    const std::size_t j = nodeIndex(std::max(nodeId1, nodeId2));
+    if (nodeId1 == nodeId2 || i == nbNodes() || nodeIds[i] != std::min(nodeId1, nodeId2) ||
+        j == nbNodes() || nodeIds[j] != std::max(nodeId1, nodeId2))
+      return nbEdges();
+    const auto first = neighbours.begin() + offsets[i];
+    const auto last = neighbours.begin() + offsets[i + 1];
+    const auto it = std::lower_bound(first, last, j);
+    return (it != last && *it == j) ? static_cast<std::size_t>(it - neighbours.begin()) : nbEdges();
+  }
+};
+
+/**
+ * @brief Call visitor(i, j, k, ij, ik, jk) for each triplet of nodes i < j < k, with i the given node
+ * (node indices and edge ids): the nodes k are the intersection of the sorted neighbours of i and j.
+ */
+template <typename TripletVisitor>
+void forEachNodeTriplet(const SortedAdjacencyGraph & graph, std::size_t i, TripletVisitor & visitor)
+{
+  const std::size_t iEnd = graph.offsets[i + 1];
+  for (std::size_t ij = graph.offsets[i]; ij < iEnd; ++ij)
+  {
+    const std::size_t j = graph.neighbours[ij];
+    const std::size_t jEnd = graph.offsets[j + 1];
+    // The neighbours of i after j are greater than j, like the neighbours of j
+    std::size_t ik = ij + 1;
+    std::size_t jk = graph.offsets[j];
+    while (ik < iEnd && jk < jEnd)
+    {
+      const std::size_t k = graph.neighbours[ik];
+      const std::size_t kj = graph.neighbours[jk];
+      if (k < kj)
+        ++ik;
+      else if (kj < k)
+        ++jk;
+      else
+      {
+        visitor(i, j, k, ij, ik, jk);
+        ++ik;
+        ++jk;
+      }
+    }
+  }
+}
+
+/// Return triplets contained in the graph build from IterablePairs,
+/// sorted by node ids (with i < j < k for each triplet).
 template <typename IterablePairs>
 inline std::vector< graph::Triplet > tripletListing(
   const IterablePairs & pairs)
 {
-  std::vector< graph::Triplet > vec_triplets;
-
-  indexedGraph putativeGraph(pairs);
+  const SortedAdjacencyGraph graph(pairs);
+  const std::ptrdiff_t nbNodes = graph.nbNodes();
 
-  graph::List_Triplets<indexedGraph::GraphT>(putativeGraph.g, vec_triplets);
+  // Count the triplets of each node, then fill them at the offset of the node.
+  std::vector<std::size_t> tripletOffsets(nbNodes + 1, 0);
+  #pragma omp parallel for schedule(dynamic, 16)
+  for (std::ptrdiff_t i = 0; i < nbNodes; ++i)
+  {
+    std::size_t nbTriplets = 0;
+    auto counter = [&nbTriplets](std::size_t, std::size_t, std::size_t, std::size_t, std::size_t, std::size_t)
+    {
+      ++nbTriplets;
+    };
+    forEachNodeTriplet(graph, i, counter);
+    tripletOffsets[i + 1] = nbTriplets;
+  }
+  for (std::ptrdiff_t i = 0; i < nbNodes; ++i)
+    tripletOffsets[i + 1] += tripletOffsets[i];
 
-  //Change triplets to ImageIds
-  for (size_t i = 0; i < vec_triplets.size(); ++i)
+  std::vector< graph::Triplet > vec_triplets(tripletOffsets.back(), graph::Triplet(0, 0, 0));
+  #pragma omp parallel for schedule(dynamic, 16)
+  for (std::ptrdiff_t i = 0; i < nbNodes; ++i)
   {
-    graph::Triplet & triplet = vec_triplets[i];
-    IndexT I = triplet.i, J = triplet.j , K = triplet.k;
-    I = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(I)];
-    J = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(J)];
-    K = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(K)];
-    IndexT triplet_[3] = { I, J, K };
-    std::sort(&triplet_[0], &triplet_[3]);
-    triplet = graph::Triplet(triplet_[0],triplet_[1],triplet_[2]);
+    std::size_t position = tripletOffsets[i];
+    auto filler = [&](std::size_t i, std::size_t j, std::size_t k, std::size_t, std::size_t, std::size_t)
+    {
+      vec_triplets[position++] = graph::Triplet(graph.nodeIds[i], graph.nodeIds[j], graph.nodeIds[k]);
+    };
+    forEachNodeTriplet(graph, i, filler);
   }
   return vec_triplets;
 }
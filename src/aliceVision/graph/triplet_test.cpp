@@ -7,7 +7,12 @@
 
 #include "aliceVision/graph/Triplet.hpp"
 
+#include <aliceVision/types.hpp>
+
+#include <algorithm>
 #include <iostream>
+#include <random>
+#include <tuple>
 #include <vector>
 
 #define BOOST_TEST_MODULE tripletFinder
@@ -268,3 +273,58 @@ BOOST_AUTO_TEST_CASE(test_for_triplet) {
     BOOST_CHECK_EQUAL(4, vec_triplets.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(test_sorted_adjacency_graph) {
+
+  // a_b_c with duplicated and self loop pairs, and the sparse ids 10, 20, 30
+  const aliceVision::PairSet pairs = {{20, 10}, {10, 20}, {20, 30}, {30, 30}};
+  const SortedAdjacencyGraph graph(pairs);
+
+  BOOST_CHECK_EQUAL(3, graph.nbNodes());
+  BOOST_CHECK_EQUAL(2, graph.nbEdges());
+  BOOST_CHECK_EQUAL(1, graph.nodeIndex(20));
+  BOOST_CHECK_EQUAL(0, graph.edgeId(20, 10));
+  BOOST_CHECK_EQUAL(1, graph.edgeId(20, 30));
+  BOOST_CHECK_EQUAL(graph.nbEdges(), graph.edgeId(10, 30));
+  BOOST_CHECK_EQUAL(graph.nbEdges(), graph.edgeId(10, 40));
+  BOOST_CHECK(tripletListing(pairs).empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_triplet_listing) {
+
+  // random graphs of sparse node ids: the triplets are the triplets of the lemon graph
+  std::mt19937 gen(0);
+  for (int nbNodes : {5, 30, 100})
+  {
+    std::uniform_int_distribution<int> nodeDistribution(0, nbNodes - 1);
+    aliceVision::PairSet pairs;
+    for (int e = 0; e < 4 * nbNodes; ++e)
+    {
+      const aliceVision::IndexT i = 3 * nodeDistribution(gen), j = 3 * nodeDistribution(gen);
+      if (i != j)
+        pairs.insert(std::make_pair(std::min(i, j), std::max(i, j)));
+    }
+
+    const std::vector< Triplet > vec_triplets = tripletListing(pairs);
+
+    indexedGraph putativeGraph(pairs);
+    std::vector< Triplet > vec_graphTriplets;
+    List_Triplets(putativeGraph.g, vec_graphTriplets);
+    BOOST_CHECK_EQUAL(vec_graphTriplets.size(), vec_triplets.size());
+
+    for (std::size_t t = 0; t < vec_triplets.size(); ++t)
+    {
+      const Triplet & triplet = vec_triplets[t];
+      // sorted triplets of edges of the graph
+      BOOST_CHECK(triplet.i < triplet.j && triplet.j < triplet.k);
+      BOOST_CHECK(pairs.count(std::make_pair(triplet.i, triplet.j)));
+      BOOST_CHECK(pairs.count(std::make_pair(triplet.i, triplet.k)));
+      BOOST_CHECK(pairs.count(std::make_pair(triplet.j, triplet.k)));
+      if (t > 0)
+      {
+        const Triplet & previous = vec_triplets[t - 1];
+        BOOST_CHECK(std::make_tuple(previous.i, previous.j, previous.k) < std::make_tuple(triplet.i, triplet.j, triplet.k));
+      }
+    }
+  }
+}
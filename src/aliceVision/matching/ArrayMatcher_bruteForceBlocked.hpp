@@ -0,0 +1,431 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "aliceVision/matching/ArrayMatcher.hpp"
+#include "aliceVision/matching/metric.hpp"
+#include <aliceVision/config.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+namespace bruteForceBlocked {
+
+/// Type of the dot products of the descriptors (exact for the unsigned char descriptors)
+template<typename Scalar>
+struct DotProduct { typedef Scalar Type; };
+template<>
+struct DotProduct<unsigned char> { typedef int Type; };
+template<>
+struct DotProduct<short> { typedef int Type; };
+
+/// Type of the packed descriptors: the unsigned char are widened once to 16 bits for the SIMD multiply-add
+template<typename Scalar>
+struct Packed { typedef Scalar Type; };
+template<>
+struct Packed<unsigned char> { typedef short Type; };
+
+/// number of queries of the register tile
+static const int tileQueries = 2;
+/// number of dataset rows of the register tile
+static const int tileRows = 4;
+/// the packed arrays are padded with zeros to a multiple of this length (one AVX2 register of 16 bits values)
+static const int packedAlignment = 16;
+
+/// length of the packed arrays
+inline int packedSize(int size)
+{
+  return (size + packedAlignment - 1) / packedAlignment * packedAlignment;
+}
+
+/**
+ * @brief Copy arrays into contiguous packed arrays, padded with zeros.
+ * @param[in] arrays the first array
+ * @param[in] nbArrays the number of arrays to copy
+ * @param[in] size the length of the arrays
+ * @param[out] out_packed the packed arrays, of length packedSize(size)
+ */
+template<typename Scalar>
+inline void pack(const Scalar* arrays, int nbArrays, int size, typename Packed<Scalar>::Type* out_packed)
+{
+  typedef typename Packed<Scalar>::Type PackedT;
+  const int outSize = packedSize(size);
+  for(int a = 0; a < nbArrays; ++a)
+  {
+    const Scalar* array = arrays + std::size_t(a) * size;
+    PackedT* packed = out_packed + std::size_t(a) * outSize;
+    for(int i = 0; i < size; ++i)
+      packed[i] = static_cast<PackedT>(array[i]);
+    std::fill(packed + size, packed + outSize, PackedT());
+  }
+}
+
+/**
+ * @brief Dot products of a tile of tileQueries packed queries with tileRows packed dataset rows.
+ * @param[in] queries the packed query arrays
+ * @param[in] rows the packed dataset arrays
+ * @param[in] size the length of the packed arrays (multiple of packedAlignment)
+ * @param[out] out_dots the dot products of each query with each row
+ */
+template<typename T>
+inline void dotTile(const T* const queries[tileQueries], const T* const rows[tileRows], int size,
+                    typename DotProduct<T>::Type out_dots[tileQueries][tileRows])
+{
+  typedef typename DotProduct<T>::Type DotT;
+  for(int q = 0; q < tileQueries; ++q)
+  {
+    for(int r = 0; r < tileRows; ++r)
+    {
+      DotT dot = DotT();
+      for(int i = 0; i < size; ++i)
+        dot += static_cast<DotT>(queries[q][i]) * static_cast<DotT>(rows[r][i]);
+      out_dots[q][r] = dot;
+    }
+  }
+}
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+/// 16 bits packed descriptors (SIFT): multiply-add into exact 32 bits integers
+inline void dotTile(const short* const queries[tileQueries], const short* const rows[tileRows], int size,
+                    int out_dots[tileQueries][tileRows])
+{
+  __m128i acc[tileQueries][tileRows];
+  for(int q = 0; q < tileQueries; ++q)
+    for(int r = 0; r < tileRows; ++r)
+      acc[q][r] = _mm_setzero_si128();
+
+#if defined(__AVX2__)
+  __m256i acc256[tileQueries][tileRows];
+  for(int q = 0; q < tileQueries; ++q)
+    for(int r = 0; r < tileRows; ++r)
+      acc256[q][r] = _mm256_setzero_si256();
+
+  for(int i = 0; i < size; i += 16)
+  {
+    __m256i q256[tileQueries];
+    for(int q = 0; q < tileQueries; ++q)
+      q256[q] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(queries[q] + i));
+    for(int r = 0; r < tileRows; ++r)
+    {
+      const __m256i r256 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[r] + i));
+      for(int q = 0; q < tileQueries; ++q)
+        acc256[q][r] = _mm256_add_epi32(acc256[q][r], _mm256_madd_epi16(q256[q], r256));
+    }
+  }
+  for(int q = 0; q < tileQueries; ++q)
+    for(int r = 0; r < tileRows; ++r)
+      acc[q][r] = _mm_add_epi32(_mm256_castsi256_si128(acc256[q][r]), _mm256_extracti128_si256(acc256[q][r], 1));
+#else
+  for(int i = 0; i < size; i += 8)
+  {
+    __m128i q128[tileQueries];
+    for(int q = 0; q < tileQueries; ++q)
+      q128[q] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(queries[q] + i));
+    for(int r = 0; r < tileRows; ++r)
+    {
+      const __m128i r128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[r] + i));
+      for(int q = 0; q < tileQueries; ++q)
+        acc[q][r] = _mm_add_epi32(acc[q][r], _mm_madd_epi16(q128[q], r128));
+    }
+  }
+#endif
+
+  // horizontal sums of the 4 accumulators of each query
+  for(int q = 0; q < tileQueries; ++q)
+  {
+    const __m128i s01 = _mm_add_epi32(_mm_unpacklo_epi32(acc[q][0], acc[q][1]), _mm_unpackhi_epi32(acc[q][0], acc[q][1]));
+    const __m128i s23 = _mm_add_epi32(_mm_unpacklo_epi32(acc[q][2], acc[q][3]), _mm_unpackhi_epi32(acc[q][2], acc[q][3]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out_dots[q]), _mm_add_epi32(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23)));
+  }
+}
+
+/// float descriptors
+inline void dotTile(const float* const queries[tileQueries], const float* const rows[tileRows], int size,
+                    float out_dots[tileQueries][tileRows])
+{
+  __m128 acc[tileQueries][tileRows];
+  for(int q = 0; q < tileQueries; ++q)
+    for(int r = 0; r < tileRows; ++r)
+      acc[q][r] = _mm_setzero_ps();
+
+#if defined(__AVX2__)
+  __m256 acc256[tileQueries][tileRows];
+  for(int q = 0; q < tileQueries; ++q)
+    for(int r = 0; r < tileRows; ++r)
+      acc256[q][r] = _mm256_setzero_ps();
+
+  for(int i = 0; i < size; i += 8)
+  {
+    __m256 q256[tileQueries];
+    for(int q = 0; q < tileQueries; ++q)
+      q256[q] = _mm256_loadu_ps(queries[q] + i);
+    for(int r = 0; r < tileRows; ++r)
+    {
+      const __m256 r256 = _mm256_loadu_ps(rows[r] + i);
+      for(int q = 0; q < tileQueries; ++q)
+        acc256[q][r] = _mm256_add_ps(acc256[q][r], _mm256_mul_ps(q256[q], r256));
+    }
+  }
+  for(int q = 0; q < tileQueries; ++q)
+    for(int r = 0; r < tileRows; ++r)
+      acc[q][r] = _mm_add_ps(_mm256_castps256_ps128(acc256[q][r]), _mm256_extractf128_ps(acc256[q][r], 1));
+#else
+  for(int i = 0; i < size; i += 4)
+  {
+    __m128 q128[tileQueries];
+    for(int q = 0; q < tileQueries; ++q)
+      q128[q] = _mm_loadu_ps(queries[q] + i);
+    for(int r = 0; r < tileRows; ++r)
+    {
+      const __m128 r128 = _mm_loadu_ps(rows[r] + i);
+      for(int q = 0; q < tileQueries; ++q)
+        acc[q][r] = _mm_add_ps(acc[q][r], _mm_mul_ps(q128[q], r128));
+    }
+  }
+#endif
+
+  // horizontal sums of the 4 accumulators of each query
+  for(int q = 0; q < tileQueries; ++q)
+  {
+    const __m128 s01 = _mm_add_ps(_mm_unpacklo_ps(acc[q][0], acc[q][1]), _mm_unpackhi_ps(acc[q][0], acc[q][1]));
+    const __m128 s23 = _mm_add_ps(_mm_unpacklo_ps(acc[q][2], acc[q][3]), _mm_unpackhi_ps(acc[q][2], acc[q][3]));
+    _mm_storeu_ps(out_dots[q], _mm_add_ps(_mm_movelh_ps(s01, s23), _mm_movehl_ps(s23, s01)));
+  }
+}
+#endif
+
+/// squared norm of an array
+template<typename Scalar>
+inline typename DotProduct<Scalar>::Type squaredNorm(const Scalar* array, int size)
+{
+  typedef typename DotProduct<Scalar>::Type DotT;
+  DotT norm = DotT();
+  for(int i = 0; i < size; ++i)
+    norm += static_cast<DotT>(array[i]) * static_cast<DotT>(array[i]);
+  return norm;
+}
+
+} // namespace bruteForceBlocked
+
+/**
+ * @brief Brute force matcher computing the squared L2 distances by blocks of queries x dataset rows.
+ *
+ * The squared distances are expanded as |q|^2 + |r|^2 - 2 q.r, with the squared norms of the dataset
+ * computed once in Build(). As in a matrix product, a block of queries and a block of dataset rows that
+ * stays in cache are packed (widened to 16 bits for unsigned char, padded with zeros), and their dot products
+ * are computed by register tiles of 2 queries x 4 rows with SSE2 (or AVX2 if the compiler targets it).
+ * The N nearest neighbors of each query are kept while the dataset is traversed, without storing all the distances.
+ * The distances of the unsigned char descriptors are exact, the float ones are rounded differently
+ * than the direct computation.
+ *
+ * @note The Metric is only used for the distance type: the distance is always the squared L2 distance.
+ */
+template < typename Scalar = float, typename Metric = L2_Simple<Scalar> >
+class ArrayMatcher_bruteForceBlocked : public ArrayMatcher<Scalar, Metric>
+{
+  public:
+  typedef typename Metric::ResultType DistanceType;
+
+  /// number of queries of a block
+  static const int queryBlockSize = 64;
+  /// memory size (in bytes) of a block of dataset rows
+  static const int datasetBlockMemorySize = 64 * 1024;
+
+  ArrayMatcher_bruteForceBlocked() {}
+  virtual ~ArrayMatcher_bruteForceBlocked() {}
+
+  /**
+   * Build the matching structure
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   *
+   * \return True if success.
+   */
+  bool Build(const Scalar * dataset, int nbRows, int dimension)
+  {
+    if (nbRows < 1) {
+      _dataset = nullptr;
+      _nbRows = 0;
+      return false;
+    }
+    _dataset = dataset;
+    _nbRows = nbRows;
+    _dimension = dimension;
+    _squaredNorms.resize(nbRows);
+    for (int i = 0; i < nbRows; ++i)
+      _squaredNorms[i] = bruteForceBlocked::squaredNorm(dataset + std::size_t(i) * dimension, dimension);
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[out]  indice    The indice of array in the dataset that
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour( const Scalar * query,
+                        int * indice, DistanceType * distance)
+  {
+    IndMatches indices;
+    std::vector<DistanceType> distances;
+    if (!SearchNeighbours(query, 1, &indices, &distances, 1))
+      return false;
+    *indice = indices.front()._j;
+    *distance = distances.front();
+    return true;
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[out]  NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  )
+  {
+    if (_dataset == nullptr) {
+      return false;
+    }
+
+    if (NN < 1 || NN > std::size_t(_nbRows) || nbQuery < 1) {
+      return false;
+    }
+
+    pvec_distances->resize(nbQuery * NN);
+    pvec_indices->resize(nbQuery * NN);
+
+    const int packedDimension = bruteForceBlocked::packedSize(_dimension);
+    const int tileRows = bruteForceBlocked::tileRows;
+    const int tileQueries = bruteForceBlocked::tileQueries;
+    const int datasetBlockSize = std::max(tileRows, datasetBlockMemorySize / int(packedDimension * sizeof(PackedT)) / tileRows * tileRows);
+    const int nbQueryBlocks = (nbQuery + queryBlockSize - 1) / queryBlockSize;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int queryBlock = 0; queryBlock < nbQueryBlocks; ++queryBlock)
+    {
+      const int queryBegin = queryBlock * queryBlockSize;
+      const int queryEnd = std::min(nbQuery, queryBegin + queryBlockSize);
+      const int blockSize = queryEnd - queryBegin;
+
+      std::vector<DotT> queryNorms(blockSize);
+      for (int q = 0; q < blockSize; ++q)
+        queryNorms[q] = bruteForceBlocked::squaredNorm(query + std::size_t(queryBegin + q) * _dimension, _dimension);
+
+      // packed queries and dataset rows, the arrays of the incomplete tiles beyond the blocks are ignored
+      std::vector<PackedT> packedQueries(std::size_t(queryBlockSize) * packedDimension, PackedT());
+      std::vector<PackedT> packedRows(std::size_t(datasetBlockSize) * packedDimension, PackedT());
+      bruteForceBlocked::pack(query + std::size_t(queryBegin) * _dimension, blockSize, _dimension, packedQueries.data());
+
+      // the N nearest neighbors of the queries of the block, sorted by increasing distances
+      std::vector<DotT> nearestDistances(blockSize * NN, std::numeric_limits<DotT>::max());
+      std::vector<int> nearestIndices(blockSize * NN, -1);
+
+      for (int rowBegin = 0; rowBegin < _nbRows; rowBegin += datasetBlockSize)
+      {
+        const int rowEnd = std::min(_nbRows, rowBegin + datasetBlockSize);
+        bruteForceBlocked::pack(_dataset + std::size_t(rowBegin) * _dimension, rowEnd - rowBegin, _dimension, packedRows.data());
+
+        for (int q = 0; q < blockSize; q += tileQueries)
+        {
+          const PackedT * queries[tileQueries];
+          for (int i = 0; i < tileQueries; ++i)
+            queries[i] = &packedQueries[std::size_t(q + i) * packedDimension];
+          const int nbTileQueries = std::min(tileQueries, blockSize - q);
+
+          for (int row = rowBegin; row < rowEnd; row += tileRows)
+          {
+            const PackedT * rows[tileRows];
+            for (int j = 0; j < tileRows; ++j)
+              rows[j] = &packedRows[std::size_t(row - rowBegin + j) * packedDimension];
+
+            DotT dots[tileQueries][tileRows];
+            bruteForceBlocked::dotTile(queries, rows, packedDimension, dots);
+
+            const int nbTileRows = std::min(tileRows, rowEnd - row);
+            for (int i = 0; i < nbTileQueries; ++i)
+            {
+              DotT * distances = &nearestDistances[(q + i) * NN];
+              int * indices = &nearestIndices[(q + i) * NN];
+              for (int j = 0; j < nbTileRows; ++j)
+              {
+                const DotT distance = queryNorms[q + i] + _squaredNorms[row + j] - 2 * dots[i][j];
+                if (distance < distances[NN - 1])
+                  insertNeighbour(distance, row + j, distances, indices, NN);
+              }
+            }
+          }
+        }
+      }
+
+      for (int q = 0; q < blockSize; ++q)
+      {
+        for (std::size_t i = 0; i < NN; ++i)
+        {
+          const std::size_t outIndex = std::size_t(queryBegin + q) * NN + i;
+          // the rounding errors of the float expansion can give small negative distances
+          (*pvec_distances)[outIndex] = static_cast<DistanceType>(std::max(DotT(), nearestDistances[q * NN + i]));
+          (*pvec_indices)[outIndex] = IndMatch(queryBegin + q, nearestIndices[q * NN + i]);
+        }
+      }
+    }
+    return true;
+  };
+
+private:
+  typedef typename bruteForceBlocked::DotProduct<Scalar>::Type DotT;
+  typedef typename bruteForceBlocked::Packed<Scalar>::Type PackedT;
+
+  /// insert a neighbour in the sorted N nearest neighbors of a query, the farthest one is dropped
+  static void insertNeighbour(DotT distance, int index, DotT * distances, int * indices, std::size_t NN)
+  {
+    std::size_t i = NN - 1;
+    for (; i > 0 && distance < distances[i - 1]; --i)
+    {
+      distances[i] = distances[i - 1];
+      indices[i] = indices[i - 1];
+    }
+    distances[i] = distance;
+    indices[i] = index;
+  }
+
+  const Scalar * _dataset = nullptr;
+  int _nbRows = 0;
+  int _dimension = 0;
+  /// squared norms of the dataset rows
+  std::vector<DotT> _squaredNorms;
+};
+
+}  // namespace matching
+}  // namespace aliceVision
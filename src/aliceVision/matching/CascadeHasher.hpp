@@ -10,30 +10,40 @@
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/matching/metric.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
-#include "aliceVision/stl/DynamicBitset.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <random>
-#include <cmath>
+#include <utility>
+#include <vector>
 
 namespace aliceVision {
 namespace matching {
 
-struct HashedDescription {
-  // Hash code generated by the primary hashing function.
-  stl::dynamic_bitset hash_code;
+struct HashedDescriptions{
+  // The number of 64 bits blocks of a hash code.
+  int nb_hash_blocks = 0;
+  // The number of bucket groups.
+  int nb_bucket_groups = 0;
+
+  // Hash codes generated by the primary hashing function:
+  // hash_codes[i * nb_hash_blocks + k] = bits [64 k, 64 k + 64) of the hash code of the description i.
+  std::vector<uint64_t> hash_codes;
 
-  // Each bucket_ids[x] = y means the descriptor belongs to bucket y in bucket
-  // group x.
+  // bucket_ids[i * nb_bucket_groups + x] = y means the description i belongs
+  // to bucket y in bucket group x.
   std::vector<uint16_t> bucket_ids;
-};
 
-struct HashedDescriptions{
-  // The hash information.
-  std::vector<HashedDescription> hashed_desc;
+  // The description ids sorted by bucket group and bucket id (counting sort):
+  // the descriptions of the bucket y of the group x are
+  // bucket_descriptions[x * nb_descriptions + k] for k in [bucket_offsets[x][y], bucket_offsets[x][y+1]).
+  std::vector<std::vector<int> > bucket_offsets;
+  std::vector<int> bucket_descriptions;
+
+  std::size_t size() const { return nb_hash_blocks > 0 ? hash_codes.size() / nb_hash_blocks : 0; }
 
-  typedef std::vector<int> Bucket;
-  // buckets[bucket_group][bucket_id] = bucket (container of description ids).
-  std::vector<std::vector<Bucket> > buckets;
+  const uint64_t* hash_code(int i) const { return &hash_codes[std::size_t(i) * nb_hash_blocks]; }
 };
 
 /**
@@ -103,15 +113,14 @@ public:
     }
 
     // Initialize secondary hash projection.
-    secondary_hash_projection_.resize(nb_bucket_groups);
+    secondary_hash_projection_.resize(nb_bucket_groups * nb_bits_per_bucket_,
+      nb_hash_code);
     for (int i = 0; i < nb_bucket_groups; ++i)
     {
-      secondary_hash_projection_[i].resize(nb_bits_per_bucket_,
-        nb_hash_code);
       for (int j = 0; j < nb_bits_per_bucket_; ++j)
       {
         for (int k = 0; k < nb_hash_code; ++k)
-          secondary_hash_projection_[i](j, k) = d(gen);
+          secondary_hash_projection_(i * nb_bits_per_bucket_ + j, k) = d(gen);
       }
     }
     return true;
@@ -155,66 +164,106 @@ public:
       return hashed_descriptions;
     }
 
+    const int nbDescriptions = descriptions.rows();
+    const int nb_hash_blocks = (nb_hash_code_ + 63) / 64;
+    hashed_descriptions.nb_hash_blocks = nb_hash_blocks;
+    hashed_descriptions.nb_bucket_groups = nb_bucket_groups_;
+
     // Create hash codes for each description.
     {
-      // Allocate space for hash codes.
-      const typename MatrixT::Index nbDescriptions = descriptions.rows();
-      hashed_descriptions.hashed_desc.resize(nbDescriptions);
-      Eigen::VectorXf descriptor(descriptions.cols());
-      for (int i = 0; i < nbDescriptions; ++i)
+      // Allocate space for hash codes and bucket ids.
+      hashed_descriptions.hash_codes.assign(std::size_t(nbDescriptions) * nb_hash_blocks, 0);
+      hashed_descriptions.bucket_ids.resize(std::size_t(nbDescriptions) * nb_bucket_groups_);
+
+      // The projections are computed by chunks of descriptions with matrix products.
+      static const int kChunkSize = 1024;
+      Eigen::MatrixXf descriptors;
+      Eigen::MatrixXf primary_projections;
+      Eigen::MatrixXf secondary_projections;
+      for (int begin = 0; begin < nbDescriptions; begin += kChunkSize)
       {
-        // Allocate space for each bucket id.
-        hashed_descriptions.hashed_desc[i].bucket_ids.resize(nb_bucket_groups_);
+        const int size = std::min(kChunkSize, nbDescriptions - begin);
 
-        for (int k = 0; k < descriptions.cols(); ++k)
-        {
-          descriptor(k) = descriptions(i,k);
-        }
-        descriptor -= zero_mean_descriptor;
+        // Zero mean descriptors in columns.
+        descriptors = descriptions.middleRows(begin, size).template cast<float>().transpose();
+        descriptors.colwise() -= zero_mean_descriptor;
 
-        auto& hash_code = hashed_descriptions.hashed_desc[i].hash_code;
-        hash_code = stl::dynamic_bitset(descriptions.cols());
+        primary_projections.noalias() = primary_hash_projection_ * descriptors;
+        secondary_projections.noalias() = secondary_hash_projection_ * descriptors;
 
-        // Compute hash code.
-        const Eigen::VectorXf primary_projection = primary_hash_projection_ * descriptor;
-        for (int j = 0; j < nb_hash_code_; ++j)
+        for (int i = 0; i < size; ++i)
         {
-          hash_code[j] = primary_projection(j) > 0;
-        }
-
-        // Determine the bucket index for each group.
-        Eigen::VectorXf secondary_projection;
-        for (int j = 0; j < nb_bucket_groups_; ++j)
-        {
-          uint16_t bucket_id = 0;
-          secondary_projection = secondary_hash_projection_[j] * descriptor;
+          // Compute hash code.
+          uint64_t* hash_code = &hashed_descriptions.hash_codes[std::size_t(begin + i) * nb_hash_blocks];
+          for (int j = 0; j < nb_hash_code_; ++j)
+          {
+            if (primary_projections(j, i) > 0)
+              hash_code[j / 64] |= uint64_t(1) << (j % 64);
+          }
 
-          for (int k = 0; k < nb_bits_per_bucket_; ++k)
+          // Determine the bucket index for each group.
+          uint16_t* bucket_ids = &hashed_descriptions.bucket_ids[std::size_t(begin + i) * nb_bucket_groups_];
+          for (int j = 0; j < nb_bucket_groups_; ++j)
           {
-            bucket_id = (bucket_id << 1) + (secondary_projection(k) > 0 ? 1 : 0);
+            uint16_t bucket_id = 0;
+            for (int k = 0; k < nb_bits_per_bucket_; ++k)
+            {
+              bucket_id = (bucket_id << 1) + (secondary_projections(j * nb_bits_per_bucket_ + k, i) > 0 ? 1 : 0);
+            }
+            bucket_ids[j] = bucket_id;
           }
-          hashed_descriptions.hashed_desc[i].bucket_ids[j] = bucket_id;
         }
       }
     }
     // Build the Buckets
     {
-      hashed_descriptions.buckets.resize(nb_bucket_groups_);
+      hashed_descriptions.bucket_offsets.resize(nb_bucket_groups_);
+      hashed_descriptions.bucket_descriptions.resize(std::size_t(nb_bucket_groups_) * nbDescriptions);
+      std::vector<int> positions(nb_buckets_per_group_);
       for (int i = 0; i < nb_bucket_groups_; ++i)
       {
-        hashed_descriptions.buckets[i].resize(nb_buckets_per_group_);
+        // Count the descriptions of each bucket.
+        std::vector<int>& offsets = hashed_descriptions.bucket_offsets[i];
+        offsets.assign(nb_buckets_per_group_ + 1, 0);
+        for (int j = 0; j < nbDescriptions; ++j)
+        {
+          ++offsets[hashed_descriptions.bucket_ids[std::size_t(j) * nb_bucket_groups_ + i] + 1];
+        }
+        for (int j = 0; j < nb_buckets_per_group_; ++j)
+        {
+          offsets[j + 1] += offsets[j];
+        }
 
         // Add the descriptor ID to the proper bucket group and id.
-        for (int j = 0; j < hashed_descriptions.hashed_desc.size(); ++j)
+        std::copy(offsets.begin(), offsets.end() - 1, positions.begin());
+        int* group_descriptions = &hashed_descriptions.bucket_descriptions[std::size_t(i) * nbDescriptions];
+        for (int j = 0; j < nbDescriptions; ++j)
         {
-          const uint16_t bucket_id = hashed_descriptions.hashed_desc[j].bucket_ids[i];
-          hashed_descriptions.buckets[i][bucket_id].push_back(j);
+          const uint16_t bucket_id = hashed_descriptions.bucket_ids[std::size_t(j) * nb_bucket_groups_ + i];
+          group_descriptions[positions[bucket_id]++] = j;
         }
       }
     }
     return hashed_descriptions;
   }
 
+  /**
+   * Buffers of Match_HashedDescriptions, reused from one call to the other
+   * to avoid the allocations for each pair of images (one per thread).
+   */
+  struct MatchingScratch
+  {
+    // The candidate descriptors of a query and their hamming distances.
+    std::vector<int> candidate_descriptors;
+    std::vector<int> candidate_hamming_distances;
+    // The number of candidates with each hamming distance.
+    std::vector<int> num_descriptors_with_hamming_distance;
+    // candidate_stamps[j] == stamp means the descriptor j is already a candidate
+    // of the current query (prevents duplicates).
+    std::vector<unsigned int> candidate_stamps;
+    unsigned int stamp = 0;
+  };
+
   // Matches two collection of hashed descriptions with a fast matching scheme
   // based on the hash codes previously generated.
   template <typename MatrixT, typename DistanceType>
@@ -226,7 +275,8 @@ public:
     const MatrixT & descriptions2,
     IndMatches * pvec_indices,
     std::vector<DistanceType> * pvec_distances,
-    const int NN = 2
+    const int NN = 2,
+    MatchingScratch * scratch = nullptr
   ) const
   {
     typedef L2_Vectorized<typename MatrixT::Scalar> MetricT;
@@ -234,99 +284,121 @@ public:
 
     static const int kNumTopCandidates = 10;
 
-    // Preallocate the candidate descriptors container.
-    std::vector<int> candidate_descriptors;
-    candidate_descriptors.reserve(hashed_descriptions2.hashed_desc.size());
-
-    // Preallocated hamming distances. Each column indicates the hamming distance
-    // and the rows collect the descriptor ids with that
-    // distance. num_descriptors_with_hamming_distance keeps track of how many
-    // descriptors have that distance.
-    Eigen::MatrixXi candidate_hamming_distances(
-      hashed_descriptions2.hashed_desc.size(), nb_hash_code_ + 1);
-    Eigen::VectorXi num_descriptors_with_hamming_distance(nb_hash_code_ + 1);
-
-    // Preallocate the container for keeping euclidean distances.
-    std::vector<std::pair<DistanceType, int> > candidate_euclidean_distances;
-    candidate_euclidean_distances.reserve(kNumTopCandidates);
-
-    // A preallocated vector to determine if we have already used a particular
-    // feature for matching (i.e., prevents duplicates).
-    std::vector<bool> used_descriptor(hashed_descriptions2.hashed_desc.size());
-
-    typedef matching::Hamming<stl::dynamic_bitset::BlockType> HammingMetricType;
-    static const HammingMetricType metricH = {};
-    for (int i = 0; i < hashed_descriptions1.hashed_desc.size(); ++i)
-    {
-      candidate_descriptors.clear();
-      num_descriptors_with_hamming_distance.setZero();
-      candidate_euclidean_distances.clear();
+    const int nb_descriptions1 = hashed_descriptions1.size();
+    const int nb_descriptions2 = hashed_descriptions2.size();
+    if (nb_descriptions1 == 0 || nb_descriptions2 == 0) {
+      return;
+    }
+    const int nb_hash_blocks = hashed_descriptions1.nb_hash_blocks;
+
+    // Preallocate the buffers (kept in the scratch between the calls).
+    MatchingScratch local_scratch;
+    MatchingScratch& buffers = (scratch != nullptr) ? *scratch : local_scratch;
+    buffers.candidate_descriptors.resize(nb_descriptions2);
+    buffers.candidate_hamming_distances.resize(nb_descriptions2);
+    buffers.num_descriptors_with_hamming_distance.resize(nb_hash_code_ + 1);
+    if (buffers.candidate_stamps.size() < std::size_t(nb_descriptions2)) {
+      buffers.candidate_stamps.resize(nb_descriptions2, 0);
+    }
+    int* candidate_descriptors = buffers.candidate_descriptors.data();
+    int* candidate_hamming_distances = buffers.candidate_hamming_distances.data();
+    int* num_descriptors_with_hamming_distance = buffers.num_descriptors_with_hamming_distance.data();
+    unsigned int* candidate_stamps = buffers.candidate_stamps.data();
+
+    // The euclidean distances of the best candidates.
+    std::pair<DistanceType, int> candidate_euclidean_distances[kNumTopCandidates];
 
-      const auto& hashed_desc = hashed_descriptions1.hashed_desc[i];
+    for (int i = 0; i < nb_descriptions1; ++i)
+    {
+      // New stamp for the query (reset the stamps if the counter wraps around).
+      if (++buffers.stamp == 0)
+      {
+        std::fill(buffers.candidate_stamps.begin(), buffers.candidate_stamps.end(), 0);
+        buffers.stamp = 1;
+      }
+      const unsigned int stamp = buffers.stamp;
 
       // Accumulate all descriptors in each bucket group that are in the same
       // bucket id as the query descriptor.
+      int nb_candidates = 0;
+      std::size_t nb_bucket_descriptors = 0;
+      const uint16_t* bucket_ids = &hashed_descriptions1.bucket_ids[std::size_t(i) * nb_bucket_groups_];
       for (int j = 0; j < nb_bucket_groups_; ++j)
       {
-        const uint16_t bucket_id = hashed_desc.bucket_ids[j];
-        for (const auto& feature_id : hashed_descriptions2.buckets[j][bucket_id])
+        const std::vector<int>& offsets = hashed_descriptions2.bucket_offsets[j];
+        const int* group_descriptions = &hashed_descriptions2.bucket_descriptions[std::size_t(j) * nb_descriptions2];
+        const int bucket_begin = offsets[bucket_ids[j]];
+        const int bucket_end = offsets[bucket_ids[j] + 1];
+        nb_bucket_descriptors += bucket_end - bucket_begin;
+        for (int k = bucket_begin; k < bucket_end; ++k)
         {
-          candidate_descriptors.emplace_back(feature_id);
-          used_descriptor[feature_id] = false;
+          const int feature_id = group_descriptions[k];
+          if (candidate_stamps[feature_id] != stamp) // avoid selecting the same candidate multiple times
+          {
+            candidate_stamps[feature_id] = stamp;
+            candidate_descriptors[nb_candidates++] = feature_id;
+          }
         }
       }
 
       // Skip matching this descriptor if there are not at least NN candidates.
-      if (candidate_descriptors.size() <= NN)
+      if (nb_bucket_descriptors <= std::size_t(NN))
       {
         continue;
       }
 
       // Compute the hamming distance of all candidates based on the comp hash
-      // code. Put the descriptors into buckets corresponding to their hamming
-      // distance.
-      for (const int candidate_id : candidate_descriptors)
+      // code, and count the candidates with each hamming distance.
+      std::fill(num_descriptors_with_hamming_distance, num_descriptors_with_hamming_distance + nb_hash_code_ + 1, 0);
+      const uint64_t* hash_code = hashed_descriptions1.hash_code(i);
+      for (int k = 0; k < nb_candidates; ++k)
       {
-        if (!used_descriptor[candidate_id]) // avoid selecting the same candidate multiple times
-        {
-          used_descriptor[candidate_id] = true;
-
-          const HammingMetricType::ResultType hamming_distance = metricH(
-            hashed_desc.hash_code.data(),
-            hashed_descriptions2.hashed_desc[candidate_id].hash_code.data(),
-            hashed_desc.hash_code.num_blocks());
-          candidate_hamming_distances(
-              num_descriptors_with_hamming_distance(hamming_distance)++,
-              hamming_distance) = candidate_id;
-        }
+        const int hamming_distance = HammingDistance(hash_code,
+          hashed_descriptions2.hash_code(candidate_descriptors[k]), nb_hash_blocks);
+        candidate_hamming_distances[k] = hamming_distance;
+        ++num_descriptors_with_hamming_distance[hamming_distance];
+      }
+
+      // The k descriptors with the best hamming distance are the ones with a distance
+      // lower than max_hamming_distance, then the first ones with max_hamming_distance.
+      const int nb_top_candidates = std::min(kNumTopCandidates, nb_candidates);
+      int max_hamming_distance = 0;
+      int nb_lower_candidates = 0;
+      while (nb_lower_candidates + num_descriptors_with_hamming_distance[max_hamming_distance] < nb_top_candidates)
+      {
+        nb_lower_candidates += num_descriptors_with_hamming_distance[max_hamming_distance++];
       }
+      int nb_max_distance_candidates = nb_top_candidates - nb_lower_candidates;
 
       // Compute the euclidean distance of the k descriptors with the best hamming
       // distance.
-      candidate_euclidean_distances.reserve(kNumTopCandidates);
-      for (int j = 0; j < candidate_hamming_distances.cols() &&
-        (candidate_euclidean_distances.size() < kNumTopCandidates); ++j)
+      int nb_euclidean_distances = 0;
+      for (int k = 0; k < nb_candidates && nb_euclidean_distances < nb_top_candidates; ++k)
       {
-        for(int k = 0; k < num_descriptors_with_hamming_distance(j) &&
-          (candidate_euclidean_distances.size() < kNumTopCandidates); ++k)
+        if (candidate_hamming_distances[k] > max_hamming_distance)
+          continue;
+        if (candidate_hamming_distances[k] == max_hamming_distance)
         {
-          const int candidate_id = candidate_hamming_distances(k, j);
-          const DistanceType distance = metric(
-            descriptions2.row(candidate_id).data(),
-            descriptions1.row(i).data(),
-            descriptions1.cols());
-
-          candidate_euclidean_distances.emplace_back(distance, candidate_id);
+          if (nb_max_distance_candidates == 0)
+            continue;
+          --nb_max_distance_candidates;
         }
+        const int candidate_id = candidate_descriptors[k];
+        const DistanceType distance = metric(
+          descriptions2.row(candidate_id).data(),
+          descriptions1.row(i).data(),
+          descriptions1.cols());
+
+        candidate_euclidean_distances[nb_euclidean_distances++] = std::make_pair(distance, candidate_id);
       }
 
       // Assert that each query is having at least NN retrieved neighbors
-      if (candidate_euclidean_distances.size() >= NN)
+      if (nb_euclidean_distances >= NN)
       {
         // Find the top NN candidates based on euclidean distance.
-        std::partial_sort(candidate_euclidean_distances.begin(),
-          candidate_euclidean_distances.begin() + NN,
-          candidate_euclidean_distances.end());
+        std::partial_sort(candidate_euclidean_distances,
+          candidate_euclidean_distances + NN,
+          candidate_euclidean_distances + nb_euclidean_distances);
         // save resulting neighbors
         for (int l = 0; l < NN; ++l)
         {
@@ -339,11 +411,39 @@ public:
   }
 
   private:
+  // Hamming distance of two hash codes.
+  static inline int HammingDistance(const uint64_t* hash_code1, const uint64_t* hash_code2, int nb_hash_blocks)
+  {
+    int distance = 0;
+    int k = 0;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE) && !defined(__POPCNT__)
+    // Without the popcnt instruction, count the bits of 128 bits blocks with SSE2.
+    const __m128i mask1 = _mm_set1_epi8(0x55);
+    const __m128i mask2 = _mm_set1_epi8(0x33);
+    const __m128i mask4 = _mm_set1_epi8(0x0f);
+    for (; k + 2 <= nb_hash_blocks; k += 2)
+    {
+      __m128i bits = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(hash_code1 + k)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(hash_code2 + k)));
+      // Count the bits of each byte, then sum the bytes.
+      bits = _mm_sub_epi8(bits, _mm_and_si128(_mm_srli_epi64(bits, 1), mask1));
+      bits = _mm_add_epi8(_mm_and_si128(bits, mask2), _mm_and_si128(_mm_srli_epi64(bits, 2), mask2));
+      bits = _mm_and_si128(_mm_add_epi8(bits, _mm_srli_epi64(bits, 4)), mask4);
+      bits = _mm_sad_epu8(bits, _mm_setzero_si128());
+      distance += _mm_cvtsi128_si32(bits) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(bits, bits));
+    }
+#endif
+    for (; k < nb_hash_blocks; ++k)
+      distance += Hamming<uint64_t>::popcnt64(hash_code1[k] ^ hash_code2[k]);
+    return distance;
+  }
+
   // Primary hashing function.
   Eigen::MatrixXf primary_hash_projection_;
 
-  // Secondary hashing function.
-  std::vector<Eigen::MatrixXf> secondary_hash_projection_;
+  // Secondary hashing function (the projections of the bucket groups, stacked).
+  Eigen::MatrixXf secondary_hash_projection_;
 };
 
 }  // namespace matching
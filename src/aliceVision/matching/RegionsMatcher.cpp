@@ -8,6 +8,7 @@
 #include "aliceVision/matching/matcherType.hpp"
 #include "aliceVision/matching/RegionsMatcher.hpp"
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceBlocked.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
 
@@ -81,6 +82,12 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BLOCKED_BRUTE_FORCE_L2:
+        {
+          typedef ArrayMatcher_bruteForceBlocked<unsigned char, L2_Simple<unsigned char> > MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<unsigned char> MatcherT;
@@ -110,6 +117,12 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BLOCKED_BRUTE_FORCE_L2:
+        {
+          typedef ArrayMatcher_bruteForceBlocked<float, L2_Simple<float> > MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<float> MatcherT;
@@ -139,6 +152,12 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BLOCKED_BRUTE_FORCE_L2:
+        {
+          typedef ArrayMatcher_bruteForceBlocked<double, L2_Simple<double> > MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<double> MatcherT;
@@ -0,0 +1,220 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceBlocked.hpp"
+#include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
+#include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <random>
+#include <sstream>
+#include <vector>
+
+#define BOOST_TEST_MODULE matchingBruteForceBlocked
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matching;
+
+// Test summary:
+// - Compare the 2 nearest neighbors of the blocked brute force matcher with the brute force matcher,
+//   for unsigned char and float descriptors of dimensions not multiple of the SIMD width
+// - Measure the matching time of the brute force, blocked brute force, kd-tree and cascade hashing matchers
+
+namespace {
+
+/**
+ * @brief Random descriptors: noisy copies of descriptors drawn from a pool, such that the queries have close neighbors.
+ */
+template<typename Scalar>
+std::vector<Scalar> createDescriptors(int nbDescriptors, int dimension, int poolSize, float maxValue, unsigned int seed)
+{
+  std::mt19937 poolGenerator(0);
+  std::uniform_real_distribution<float> valueDistribution(0.0f, maxValue);
+  std::vector<float> pool(poolSize * dimension);
+  for(float& value : pool)
+    value = valueDistribution(poolGenerator);
+
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<int> poolDistribution(0, poolSize - 1);
+  std::normal_distribution<float> noiseDistribution(0.0f, 0.05f * maxValue);
+  std::vector<Scalar> descriptors(nbDescriptors * dimension);
+  for(int i = 0; i < nbDescriptors; ++i)
+  {
+    const float* poolDescriptor = &pool[poolDistribution(generator) * dimension];
+    for(int k = 0; k < dimension; ++k)
+      descriptors[i * dimension + k] = static_cast<Scalar>(std::min(maxValue, std::max(0.0f, poolDescriptor[k] + noiseDistribution(generator))));
+  }
+  return descriptors;
+}
+
+/**
+ * @brief Check the N nearest neighbors of the blocked matcher against the brute force matcher.
+ *        The indices may differ for equal distances.
+ */
+template<typename Scalar>
+void checkNearestNeighbors(int nbRows, int nbQueries, int dimension, std::size_t NN, float maxValue, double tolerance)
+{
+  const std::vector<Scalar> dataset = createDescriptors<Scalar>(nbRows, dimension, 50, maxValue, 1);
+  const std::vector<Scalar> queries = createDescriptors<Scalar>(nbQueries, dimension, 50, maxValue, 2);
+
+  typedef L2_Simple<Scalar> MetricT;
+  typedef typename MetricT::ResultType DistanceT;
+
+  ArrayMatcher_bruteForce<Scalar, MetricT> refMatcher;
+  BOOST_CHECK(refMatcher.Build(dataset.data(), nbRows, dimension));
+  IndMatches refIndices;
+  std::vector<DistanceT> refDistances;
+  BOOST_CHECK(refMatcher.SearchNeighbours(queries.data(), nbQueries, &refIndices, &refDistances, NN));
+
+  ArrayMatcher_bruteForceBlocked<Scalar, MetricT> matcher;
+  BOOST_CHECK(matcher.Build(dataset.data(), nbRows, dimension));
+  IndMatches indices;
+  std::vector<DistanceT> distances;
+  BOOST_CHECK(matcher.SearchNeighbours(queries.data(), nbQueries, &indices, &distances, NN));
+
+  BOOST_REQUIRE_EQUAL(indices.size(), refIndices.size());
+  BOOST_REQUIRE_EQUAL(distances.size(), refDistances.size());
+
+  const MetricT metric;
+  int nbDifferentIndices = 0;
+  for(std::size_t i = 0; i < indices.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(indices[i]._i, refIndices[i]._i);
+    BOOST_CHECK_SMALL(static_cast<double>(distances[i] - refDistances[i]), tolerance);
+
+    // the distance is the one of the returned neighbor
+    const DistanceT distance = metric(&queries[indices[i]._i * dimension], &dataset[indices[i]._j * dimension], dimension);
+    BOOST_CHECK_SMALL(static_cast<double>(distances[i] - distance), tolerance);
+    nbDifferentIndices += static_cast<int>(indices[i]._j != refIndices[i]._j);
+  }
+  BOOST_CHECK_LE(nbDifferentIndices, static_cast<int>(indices.size() / 100));
+}
+
+/**
+ * @brief Search the 2 nearest neighbors of the queries with a matcher.
+ * @return the time (in milliseconds) of the build and the search
+ */
+template<typename MatcherT>
+double searchNearestNeighbors(MatcherT& matcher, const std::vector<unsigned char>& dataset, const std::vector<unsigned char>& queries,
+                              int dimension, IndMatches& out_indices, std::vector<float>& out_distances)
+{
+  system::Timer timer;
+  BOOST_CHECK(matcher.Build(dataset.data(), dataset.size() / dimension, dimension));
+  std::vector<typename MatcherT::DistanceType> distances;
+  BOOST_CHECK(matcher.SearchNeighbours(queries.data(), queries.size() / dimension, &out_indices, &distances, 2));
+  const double time = timer.elapsedMs();
+  out_distances.assign(distances.begin(), distances.end());
+  return time;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_Simple_Dim4)
+{
+  const float array[] = {
+    0, 1, 2, 3,
+    4, 5, 6, 7,
+    8, 9, 10, 11};
+  ArrayMatcher_bruteForceBlocked<float> matcher;
+  BOOST_CHECK( matcher.Build(array, 3, 4) );
+
+  const float query[] = {4, 5, 6, 7};
+  int nIndice = -1;
+  float fDistance = -1.0f;
+  BOOST_CHECK( matcher.SearchNeighbour( query, &nIndice, &fDistance) );
+
+  BOOST_CHECK_EQUAL( 1, nIndice);
+  BOOST_CHECK_SMALL(static_cast<double>(fDistance), 1e-8);
+
+  IndMatches vec_nIndice;
+  std::vector<float> vec_fDistance;
+  BOOST_CHECK( matcher.SearchNeighbours(query, 1, &vec_nIndice, &vec_fDistance, 3) );
+  BOOST_CHECK_EQUAL(IndMatch(0,1), vec_nIndice[0]);
+  BOOST_CHECK_EQUAL(IndMatch(0,0), vec_nIndice[1]);
+  BOOST_CHECK_EQUAL(IndMatch(0,2), vec_nIndice[2]);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[1] - 64.0f), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[2] - 64.0f), 1e-6);
+
+  // more neighbors than the dataset rows
+  BOOST_CHECK( !matcher.SearchNeighbours(query, 1, &vec_nIndice, &vec_fDistance, 4) );
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_EmptyArrays)
+{
+  std::vector<float> array;
+  ArrayMatcher_bruteForceBlocked<float> matcher;
+  BOOST_CHECK(! matcher.Build(&array[0], 0, 4) );
+
+  int nIndice = -1;
+  float fDistance = -1.0f;
+  BOOST_CHECK(! matcher.SearchNeighbour( &array[0], &nIndice, &fDistance) );
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_uchar)
+{
+  // the distances of the unsigned char descriptors are exact
+  checkNearestNeighbors<unsigned char>(1000, 300, 128, 2, 255.0f, 1e-8);
+  checkNearestNeighbors<unsigned char>(301, 150, 61, 2, 255.0f, 1e-8);
+  checkNearestNeighbors<unsigned char>(7, 70, 5, 3, 255.0f, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_float)
+{
+  checkNearestNeighbors<float>(1000, 300, 128, 2, 1.0f, 1e-4);
+  checkNearestNeighbors<float>(301, 150, 61, 2, 1.0f, 1e-4);
+  checkNearestNeighbors<double>(301, 150, 61, 2, 1.0f, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_benchmark)
+{
+  // SIFT like descriptors
+  const int nbRows = 5000;
+  const int nbQueries = 5000;
+  const int dimension = 128;
+  const std::vector<unsigned char> dataset = createDescriptors<unsigned char>(nbRows, dimension, 1000, 255.0f, 1);
+  const std::vector<unsigned char> queries = createDescriptors<unsigned char>(nbQueries, dimension, 1000, 255.0f, 2);
+
+  typedef L2_Vectorized<unsigned char> MetricT;
+  std::vector<IndMatches> indices(4);
+  std::vector<std::vector<float>> distances(4);
+  std::vector<double> times(4);
+  const char* names[] = {"brute force", "blocked brute force", "kd-tree (ANN)", "cascade hashing"};
+  {
+    ArrayMatcher_bruteForce<unsigned char, MetricT> matcher;
+    times[0] = searchNearestNeighbors(matcher, dataset, queries, dimension, indices[0], distances[0]);
+  }
+  {
+    ArrayMatcher_bruteForceBlocked<unsigned char, MetricT> matcher;
+    times[1] = searchNearestNeighbors(matcher, dataset, queries, dimension, indices[1], distances[1]);
+  }
+  {
+    ArrayMatcher_kdtreeFlann<unsigned char> matcher;
+    times[2] = searchNearestNeighbors(matcher, dataset, queries, dimension, indices[2], distances[2]);
+  }
+  {
+    ArrayMatcher_cascadeHashing<unsigned char, MetricT> matcher;
+    times[3] = searchNearestNeighbors(matcher, dataset, queries, dimension, indices[3], distances[3]);
+  }
+
+  // recall of the nearest neighbors of the brute force matcher
+  std::stringstream ss;
+  for(int m = 0; m < 4; ++m)
+  {
+    int nbFound = 0;
+    for(int q = 0; q < nbQueries; ++q)
+      nbFound += static_cast<int>(indices[m][2 * q]._j == indices[0][2 * q]._j || distances[m][2 * q] == distances[0][2 * q]);
+    ss << "\t- " << names[m] << ": " << times[m] << " ms, "
+       << 2.0 * nbRows * nbQueries * dimension / (times[m] * 1e6) << " GOPS equivalent, "
+       << 100.0 * nbFound / nbQueries << "% of the nearest neighbors" << std::endl;
+    if(m == 1)
+      BOOST_CHECK_EQUAL(nbFound, nbQueries);
+  }
+  ALICEVISION_LOG_INFO("Matching of " << nbQueries << " x " << nbRows << " descriptors:" << std::endl << ss.str());
+}
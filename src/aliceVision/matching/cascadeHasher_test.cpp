@@ -0,0 +1,170 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/matching/CascadeHasher.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceBlocked.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE matchingCascadeHasher
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matching;
+
+// Test summary:
+// - Check the buckets of the hashed descriptions
+// - Check that the matching buffers reused between pairs of different sizes give the same matches
+// - Compare the nearest neighbors of the cascade hashing with a brute force matching on SIFT like descriptors
+//   and measure the matching time of a pair
+
+namespace {
+
+typedef Eigen::Matrix<unsigned char, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> DescriptorsMat;
+
+/**
+ * @brief Random SIFT like descriptors: noisy copies of descriptors drawn from a pool.
+ */
+DescriptorsMat createDescriptors(int nbDescriptors, int poolSize, unsigned int seed)
+{
+  std::mt19937 poolGenerator(0);
+  std::uniform_int_distribution<int> valueDistribution(0, 127);
+  DescriptorsMat pool(poolSize, 128);
+  for(int i = 0; i < poolSize; ++i)
+    for(int k = 0; k < 128; ++k)
+      pool(i, k) = static_cast<unsigned char>(valueDistribution(poolGenerator));
+
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<int> poolDistribution(0, poolSize - 1);
+  std::normal_distribution<float> noiseDistribution(0.0f, 8.0f);
+  DescriptorsMat descriptors(nbDescriptors, 128);
+  for(int i = 0; i < nbDescriptors; ++i)
+  {
+    const int p = poolDistribution(generator);
+    for(int k = 0; k < 128; ++k)
+      descriptors(i, k) = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, pool(p, k) + noiseDistribution(generator))));
+  }
+  return descriptors;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(CascadeHasher_buckets)
+{
+  const DescriptorsMat descriptors = createDescriptors(3000, 500, 1);
+
+  CascadeHasher hasher;
+  hasher.Init(128);
+  const HashedDescriptions hashed = hasher.CreateHashedDescriptions(descriptors, CascadeHasher::GetZeroMeanDescriptor(descriptors));
+
+  BOOST_CHECK_EQUAL(hashed.size(), 3000);
+  BOOST_CHECK_EQUAL(hashed.nb_hash_blocks, 2);
+  BOOST_REQUIRE_EQUAL(hashed.nb_bucket_groups, 6);
+  BOOST_REQUIRE_EQUAL(hashed.bucket_offsets.size(), 6);
+
+  // each description is once in each group, in its bucket, and the buckets are sorted by description id
+  for(int group = 0; group < hashed.nb_bucket_groups; ++group)
+  {
+    const std::vector<int>& offsets = hashed.bucket_offsets[group];
+    BOOST_REQUIRE_EQUAL(offsets.size(), 1025);
+    BOOST_CHECK_EQUAL(offsets.front(), 0);
+    BOOST_CHECK_EQUAL(offsets.back(), 3000);
+
+    std::vector<int> nbOccurrences(3000, 0);
+    for(int bucket = 0; bucket < 1024; ++bucket)
+    {
+      for(int k = offsets[bucket]; k < offsets[bucket + 1]; ++k)
+      {
+        const int descriptionId = hashed.bucket_descriptions[group * 3000 + k];
+        ++nbOccurrences[descriptionId];
+        BOOST_CHECK_EQUAL(hashed.bucket_ids[descriptionId * 6 + group], bucket);
+        if(k > offsets[bucket])
+          BOOST_CHECK_LT(hashed.bucket_descriptions[group * 3000 + k - 1], descriptionId);
+      }
+    }
+    BOOST_CHECK(std::all_of(nbOccurrences.begin(), nbOccurrences.end(), [](int n) { return n == 1; }));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CascadeHasher_matchingScratch)
+{
+  const DescriptorsMat descriptors1 = createDescriptors(2000, 500, 1);
+  const DescriptorsMat descriptors2 = createDescriptors(500, 500, 2);
+  const DescriptorsMat descriptors3 = createDescriptors(3000, 500, 3);
+
+  CascadeHasher hasher;
+  hasher.Init(128);
+  const Eigen::VectorXf zeroMean = CascadeHasher::GetZeroMeanDescriptor(descriptors1);
+  const HashedDescriptions hashed1 = hasher.CreateHashedDescriptions(descriptors1, zeroMean);
+  const HashedDescriptions hashed2 = hasher.CreateHashedDescriptions(descriptors2, zeroMean);
+  const HashedDescriptions hashed3 = hasher.CreateHashedDescriptions(descriptors3, zeroMean);
+
+  CascadeHasher::MatchingScratch scratch;
+  const HashedDescriptions* hashedDatabases[] = {&hashed2, &hashed3, &hashed2};
+  const DescriptorsMat* databases[] = {&descriptors2, &descriptors3, &descriptors2};
+  for(int i = 0; i < 3; ++i)
+  {
+    IndMatches indices;
+    std::vector<float> distances;
+    hasher.Match_HashedDescriptions(hashed1, descriptors1, *hashedDatabases[i], *databases[i], &indices, &distances, 2, &scratch);
+
+    IndMatches refIndices;
+    std::vector<float> refDistances;
+    hasher.Match_HashedDescriptions(hashed1, descriptors1, *hashedDatabases[i], *databases[i], &refIndices, &refDistances);
+
+    BOOST_CHECK_GT(indices.size(), 0);
+    BOOST_CHECK(indices == refIndices);
+    BOOST_CHECK(distances == refDistances);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CascadeHasher_nearestNeighbors)
+{
+  const int nbDescriptors = 10000;
+  const DescriptorsMat descriptors1 = createDescriptors(nbDescriptors, 2000, 1);
+  const DescriptorsMat descriptors2 = createDescriptors(nbDescriptors, 2000, 2);
+
+  system::Timer timer;
+  CascadeHasher hasher;
+  hasher.Init(128);
+  const Eigen::VectorXf zeroMean = CascadeHasher::GetZeroMeanDescriptor(descriptors1);
+  const HashedDescriptions hashed1 = hasher.CreateHashedDescriptions(descriptors1, zeroMean);
+  const HashedDescriptions hashed2 = hasher.CreateHashedDescriptions(descriptors2, zeroMean);
+  const double hashingTime = timer.elapsedMs();
+
+  CascadeHasher::MatchingScratch scratch;
+  IndMatches indices;
+  std::vector<float> distances;
+  timer.reset();
+  hasher.Match_HashedDescriptions(hashed1, descriptors1, hashed2, descriptors2, &indices, &distances, 2, &scratch);
+  const double matchingTime = timer.elapsedMs();
+
+  // brute force nearest neighbors
+  ArrayMatcher_bruteForceBlocked<unsigned char, L2_Vectorized<unsigned char> > bruteForceMatcher;
+  BOOST_REQUIRE(bruteForceMatcher.Build(descriptors2.data(), nbDescriptors, 128));
+  IndMatches refIndices;
+  std::vector<float> refDistances;
+  BOOST_REQUIRE(bruteForceMatcher.SearchNeighbours(descriptors1.data(), nbDescriptors, &refIndices, &refDistances, 2));
+
+  int nbFound = 0;
+  for(std::size_t i = 0; i < indices.size(); i += 2)
+  {
+    const int queryId = indices[i]._i;
+    nbFound += static_cast<int>(distances[i] == refDistances[2 * queryId]);
+  }
+
+  ALICEVISION_LOG_INFO("Cascade hashing of " << nbDescriptors << " x " << nbDescriptors << " descriptors:" << std::endl
+                       << "\t- hashing: " << hashingTime << " ms" << std::endl
+                       << "\t- matching: " << matchingTime << " ms" << std::endl
+                       << "\t- nearest neighbors found: " << 100.0 * nbFound / nbDescriptors << "%");
+
+  BOOST_CHECK_GT(nbFound, nbDescriptors * 9 / 10);
+}
@@ -10,6 +10,12 @@
 
 #include <boost/filesystem/operations.hpp>
 
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
 #define BOOST_TEST_MODULE IndMatch
 #include <boost/test/included/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
@@ -87,6 +93,88 @@ BOOST_AUTO_TEST_CASE(IndMatch_IO)
   boost::filesystem::remove_all(testFolder);
 }
 
+BOOST_AUTO_TEST_CASE(IndMatch_IO_Binary)
+{
+  const std::string testFolder = "matchingBinTest";
+  for(bool matchFilePerImage : {false, true})
+  {
+    boost::filesystem::remove_all(testFolder);
+    boost::filesystem::create_directory(testFolder);
+
+    std::set<IndexT> viewsKeys = {0, 1, 2};
+    PairwiseMatches matches;
+    matches[std::make_pair(0,1)][EImageDescriberType::SIFT] = {{0,0},{1,1}};
+    matches[std::make_pair(0,1)][EImageDescriberType::AKAZE] = {{5,4}};
+    matches[std::make_pair(1,2)][EImageDescriberType::SIFT] = {{0,0},{1,1}, {2,7}};
+
+    BOOST_CHECK(Save(matches, testFolder, "bin", matchFilePerImage));
+
+    // load everything
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(Load(loadedMatches, viewsKeys, {testFolder}, {}));
+    BOOST_CHECK_EQUAL(2, loadedMatches.size());
+    BOOST_CHECK_EQUAL(2, loadedMatches.at(std::make_pair(0,1)).size());
+    BOOST_CHECK(matches.at(std::make_pair(0,1)).at(EImageDescriberType::SIFT) == loadedMatches.at(std::make_pair(0,1)).at(EImageDescriberType::SIFT));
+    BOOST_CHECK(matches.at(std::make_pair(0,1)).at(EImageDescriberType::AKAZE) == loadedMatches.at(std::make_pair(0,1)).at(EImageDescriberType::AKAZE));
+    BOOST_CHECK(matches.at(std::make_pair(1,2)).at(EImageDescriberType::SIFT) == loadedMatches.at(std::make_pair(1,2)).at(EImageDescriberType::SIFT));
+
+    // load a subset of the views and describer types
+    loadedMatches.clear();
+    BOOST_CHECK(Load(loadedMatches, {0, 1}, {testFolder}, {EImageDescriberType::AKAZE}));
+    BOOST_CHECK_EQUAL(1, loadedMatches.size());
+    BOOST_CHECK_EQUAL(1, loadedMatches.at(std::make_pair(0,1)).size());
+    BOOST_CHECK_EQUAL(1, loadedMatches.at(std::make_pair(0,1)).at(EImageDescriberType::AKAZE).size());
+  }
+  boost::filesystem::remove_all(testFolder);
+}
+
+BOOST_AUTO_TEST_CASE(IndMatch_IO_Binary_Corrupted)
+{
+  const std::string testFolder = "matchingBinCorruptedTest";
+  const std::string filename = testFolder + "/matches.bin";
+  boost::filesystem::remove_all(testFolder);
+  boost::filesystem::create_directory(testFolder);
+
+  PairwiseMatches matches;
+  matches[std::make_pair(0,1)][EImageDescriberType::SIFT] = {{0,0},{1,1}};
+  BOOST_CHECK(Save(matches, testFolder, "bin", false));
+
+  std::string content;
+  {
+    std::ifstream file(filename, std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+  // header (16 bytes) + 1 index entry (32 bytes) + 2 matches
+  BOOST_REQUIRE_EQUAL(content.size(), 16 + 32 + 2 * 2 * sizeof(IndexT));
+
+  const auto writeCorrupted = [&](std::size_t position, std::uint64_t value)
+  {
+    std::string corrupted = content;
+    std::memcpy(&corrupted[position], &value, sizeof(value));
+    std::ofstream(filename, std::ios::binary) << corrupted;
+  };
+
+  PairwiseMatches loadedMatches;
+
+  // number of entries (header bytes [8,16))
+  writeCorrupted(8, std::numeric_limits<std::uint64_t>::max() / 32);
+  BOOST_CHECK(!LoadMatchFile(loadedMatches, filename));
+
+  // offset of the first entry (entry bytes [16,24))
+  writeCorrupted(16 + 16, content.size() + 1);
+  BOOST_CHECK(!LoadMatchFile(loadedMatches, filename));
+
+  // number of matches of the first entry (entry bytes [24,32))
+  writeCorrupted(16 + 24, std::numeric_limits<std::uint64_t>::max() / 2);
+  BOOST_CHECK(!LoadMatchFile(loadedMatches, filename));
+
+  // truncated matches data
+  std::ofstream(filename, std::ios::binary) << content.substr(0, content.size() - 1);
+  BOOST_CHECK(!LoadMatchFile(loadedMatches, filename));
+
+  boost::filesystem::remove_all(testFolder);
+}
+
 BOOST_AUTO_TEST_CASE(IndMatch_DuplicateRemoval_NoRemoval)
 {
   std::vector<IndMatch> vec_indMatch;
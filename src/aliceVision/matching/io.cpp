@@ -12,6 +12,8 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <map>
 #include <fstream>
 #include <iterator>
@@ -23,7 +25,136 @@ namespace fs = boost::filesystem;
 namespace aliceVision {
 namespace matching {
 
-bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
+/**
+ * @brief Header of a binary matches file (.bin).
+ *
+ * The header is followed by an index of nbEntries MatchesBinFileIndexEntry
+ * (one per image pair and describer type), then by the matches data.
+ * Each match is stored as two IndexT (feature index in I, feature index in J).
+ */
+struct MatchesBinFileHeader
+{
+  /// "AVMB" in little-endian byte order
+  static constexpr std::uint32_t magic = 0x424D5641;
+  static constexpr std::uint32_t currentVersion = 1;
+
+  std::uint32_t fileMagic = magic;
+  std::uint32_t version = currentVersion;
+  std::uint64_t nbEntries = 0;
+};
+
+/**
+ * @brief Index entry of a binary matches file (.bin).
+ */
+struct MatchesBinFileIndexEntry
+{
+  std::uint32_t I = 0;
+  std::uint32_t J = 0;
+  std::uint32_t descType = 0;
+  std::uint32_t padding = 0;
+  /// position of the first match in the file (in bytes)
+  std::uint64_t offset = 0;
+  /// number of matches
+  std::uint64_t count = 0;
+};
+
+static_assert(sizeof(MatchesBinFileHeader) == 16, "Unexpected binary matches file header size.");
+static_assert(sizeof(MatchesBinFileIndexEntry) == 32, "Unexpected binary matches file index entry size.");
+
+static bool loadMatchesBinFile(PairwiseMatches& matches,
+                               const std::string& filepath,
+                               const std::set<IndexT>& viewsKeysFilter,
+                               const std::vector<feature::EImageDescriberType>& descTypesFilter)
+{
+  std::ifstream stream(filepath.c_str(), std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  MatchesBinFileHeader header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(MatchesBinFileHeader));
+
+  if(!stream || header.fileMagic != MatchesBinFileHeader::magic)
+  {
+    ALICEVISION_LOG_WARNING("Invalid binary matches file: " << filepath);
+    return false;
+  }
+
+  if(header.version > MatchesBinFileHeader::currentVersion)
+  {
+    ALICEVISION_LOG_WARNING("Unsupported binary matches file version (" << header.version << "): " << filepath);
+    return false;
+  }
+
+  // read the index, the header and the index entries are checked against the file size
+  // before any allocation, so a corrupted file cannot lead to huge allocations
+  stream.seekg(0, std::ios::end);
+  const std::uint64_t fileSize = static_cast<std::uint64_t>(stream.tellg());
+  stream.seekg(sizeof(MatchesBinFileHeader));
+
+  if(!stream || header.nbEntries > (fileSize - sizeof(MatchesBinFileHeader)) / sizeof(MatchesBinFileIndexEntry))
+  {
+    ALICEVISION_LOG_WARNING("Invalid binary matches file index: " << filepath);
+    return false;
+  }
+
+  std::vector<MatchesBinFileIndexEntry> index(header.nbEntries);
+  stream.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(MatchesBinFileIndexEntry));
+
+  if(!stream)
+  {
+    ALICEVISION_LOG_WARNING("Invalid binary matches file index: " << filepath);
+    return false;
+  }
+
+  for(const MatchesBinFileIndexEntry& entry : index)
+  {
+    if(entry.offset > fileSize || entry.count > (fileSize - entry.offset) / (2 * sizeof(IndexT)))
+    {
+      ALICEVISION_LOG_WARNING("Invalid binary matches file index: matches out of the file: " << filepath);
+      return false;
+    }
+  }
+
+  // only read the matches of the requested pairs and describer types
+  std::vector<IndexT> buffer;
+  for(const MatchesBinFileIndexEntry& entry : index)
+  {
+    const feature::EImageDescriberType descType = static_cast<feature::EImageDescriberType>(entry.descType);
+
+    if(!viewsKeysFilter.empty() &&
+       (viewsKeysFilter.find(entry.I) == viewsKeysFilter.end() ||
+        viewsKeysFilter.find(entry.J) == viewsKeysFilter.end()))
+      continue;
+
+    if(!descTypesFilter.empty() &&
+       std::find(descTypesFilter.begin(), descTypesFilter.end(), descType) == descTypesFilter.end())
+      continue;
+
+    buffer.resize(2 * entry.count);
+    stream.seekg(entry.offset);
+    stream.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(IndexT));
+
+    if(!stream)
+    {
+      ALICEVISION_LOG_WARNING("Invalid binary matches file data: " << filepath);
+      return false;
+    }
+
+    IndMatches& matchesPerDesc = matches[std::make_pair(entry.I, entry.J)][descType];
+    matchesPerDesc.resize(entry.count);
+    for(std::size_t i = 0; i < entry.count; ++i)
+    {
+      matchesPerDesc[i]._i = buffer[2 * i];
+      matchesPerDesc[i]._j = buffer[2 * i + 1];
+    }
+  }
+  return true;
+}
+
+bool LoadMatchFile(PairwiseMatches& matches,
+                   const std::string& filepath,
+                   const std::set<IndexT>& viewsKeysFilter,
+                   const std::vector<feature::EImageDescriberType>& descTypesFilter)
 {
   const std::string ext = fs::extension(filepath);
 
@@ -70,6 +201,10 @@ bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
     stream.close();
     return true;
   }
+  else if(ext == ".bin")
+  {
+    return loadMatchesBinFile(matches, filepath, viewsKeysFilter, descTypesFilter);
+  }
   else
   {
     ALICEVISION_LOG_WARNING("Unknown matching file format: " << ext);
@@ -137,7 +272,8 @@ bool LoadMatchFilePerImage(
   PairwiseMatches& matches,
   const std::set<IndexT>& viewsKeys,
   const std::string& folder,
-  const std::string& basename)
+  const std::string& basename,
+  const std::vector<feature::EImageDescriberType>& descTypesFilter)
 {
   int nbLoadedMatchFiles = 0;
   // Load one match file per image
@@ -149,7 +285,8 @@ bool LoadMatchFilePerImage(
     const IndexT idView = *it;
     const std::string matchFilename = std::to_string(idView) + "." + basename;
     PairwiseMatches fileMatches;
-    if(!LoadMatchFile(fileMatches, (fs::path(folder) / matchFilename).string() ))
+    // binary files are indexed: only the pairs between the given views are read
+    if(!LoadMatchFile(fileMatches, (fs::path(folder) / matchFilename).string(), viewsKeys, descTypesFilter))
     {
       #pragma omp critical
       {
@@ -192,16 +329,25 @@ bool Load(
   const int maxNbMatches)
 {
   bool res = false;
-  const std::string fileName = "matches.txt";
 
   for(const std::string& folder : folders)
   {
-    const fs::path filePath = fs::path(folder) / fileName;
-
-    if(fs::exists(filePath))
-      res = LoadMatchFile(matches, filePath.string());
+    // the binary format is preferred if both formats are available
+    const fs::path binFilePath = fs::path(folder) / "matches.bin";
+    const fs::path txtFilePath = fs::path(folder) / "matches.txt";
+
+    if(fs::exists(binFilePath))
+      res = LoadMatchFile(matches, binFilePath.string(), viewsKeysFilter, descTypesFilter);
+    else if(fs::exists(txtFilePath))
+      res = LoadMatchFile(matches, txtFilePath.string());
     else
-      res = LoadMatchFilePerImage(matches, viewsKeysFilter, folder, fileName);
+    {
+      // use the binary format if there is at least one binary match file per image
+      const bool useBinFiles = std::any_of(viewsKeysFilter.begin(), viewsKeysFilter.end(), [&folder](IndexT viewId) {
+        return fs::exists(fs::path(folder) / (std::to_string(viewId) + ".matches.bin"));
+      });
+      res = LoadMatchFilePerImage(matches, viewsKeysFilter, folder, (useBinFiles ? "matches.bin" : "matches.txt"), descTypesFilter);
+    }
   }
 
   if(!res)
@@ -267,6 +413,81 @@ private:
     fs::rename(tmpPath, filepath);
   }
 
+  void saveBin(
+    const std::string& filepath,
+    const PairwiseMatches::const_iterator& matchBegin,
+    const PairwiseMatches::const_iterator& matchEnd)
+  {
+    const fs::path bPath = fs::path(filepath);
+    const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+    // build the index: one entry per image pair and describer type
+    std::vector<MatchesBinFileIndexEntry> index;
+    for(PairwiseMatches::const_iterator match = matchBegin; match != matchEnd; ++match)
+    {
+      for(const auto& m: match->second)
+      {
+        MatchesBinFileIndexEntry entry;
+        entry.I = static_cast<std::uint32_t>(match->first.first);
+        entry.J = static_cast<std::uint32_t>(match->first.second);
+        entry.descType = static_cast<std::uint32_t>(m.first);
+        entry.count = m.second.size();
+        index.push_back(entry);
+      }
+    }
+
+    MatchesBinFileHeader header;
+    header.nbEntries = index.size();
+
+    std::uint64_t offset = sizeof(MatchesBinFileHeader) + index.size() * sizeof(MatchesBinFileIndexEntry);
+    for(MatchesBinFileIndexEntry& entry : index)
+    {
+      entry.offset = offset;
+      offset += 2 * entry.count * sizeof(IndexT);
+    }
+
+    // write temporary file
+    {
+      std::ofstream stream(tmpPath.c_str(), std::ios::out | std::ios::binary);
+      stream.write(reinterpret_cast<const char*>(&header), sizeof(MatchesBinFileHeader));
+      stream.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(MatchesBinFileIndexEntry));
+
+      std::vector<IndexT> buffer;
+      for(PairwiseMatches::const_iterator match = matchBegin; match != matchEnd; ++match)
+      {
+        for(const auto& m: match->second)
+        {
+          buffer.resize(2 * m.second.size());
+          for(std::size_t i = 0; i < m.second.size(); ++i)
+          {
+            buffer[2 * i] = m.second[i]._i;
+            buffer[2 * i + 1] = m.second[i]._j;
+          }
+          stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(IndexT));
+        }
+      }
+
+      if(!stream.good())
+        throw std::runtime_error("Can't write binary matches file: " + tmpPath);
+    }
+
+    // rename temporary file
+    fs::rename(tmpPath, filepath);
+  }
+
+  void save(
+    const std::string& filepath,
+    const PairwiseMatches::const_iterator& matchBegin,
+    const PairwiseMatches::const_iterator& matchEnd)
+  {
+    if(m_ext == ".txt")
+      saveTxt(filepath, matchBegin, matchEnd);
+    else if(m_ext == ".bin")
+      saveBin(filepath, matchBegin, matchEnd);
+    else
+      throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
+  }
+
 public:
   MatchExporter(
     const PairwiseMatches& matches,
@@ -284,11 +505,7 @@ public:
   void saveGlobalFile()
   {
     const std::string filepath = (fs::path(m_directory) / m_filename).string();
-
-    if(m_ext == ".txt")
-      saveTxt(filepath, m_matches.begin(), m_matches.end());
-    else
-      throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
+    save(filepath, m_matches.begin(), m_matches.end());
   }
 
   /// Export matches into separate files, one for each image.
@@ -305,15 +522,12 @@ public:
     for(IndexT key: keys)
     {
       PairwiseMatches::const_iterator match = matchBegin;
-      while(match->first.first == key && match != matchEnd)
+      while(match != matchEnd && match->first.first == key)
         ++match;
       const std::string filepath = (fs::path(m_directory) / (std::to_string(key) + "." + m_filename)).string();
       ALICEVISION_LOG_DEBUG("Export Matches in: " << filepath);
-      
-      if(m_ext == ".txt")
-        saveTxt(filepath, matchBegin, match);
-      else
-        throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
+
+      save(filepath, matchBegin, match);
 
       matchBegin = match;
     }
@@ -9,7 +9,9 @@
 
 #include <aliceVision/matching/IndMatch.hpp>
 
+#include <set>
 #include <string>
+#include <vector>
 
 namespace aliceVision {
 namespace matching {
@@ -18,24 +20,36 @@ namespace matching {
 /**
  * @brief Load a match file.
  *
+ * Supported formats are text (.txt) and binary (.bin).
+ * Binary files are indexed per image pair and describer type,
+ * so only the matches passing the filters are read.
+ *
  * @param[out] matches: container for the output matches
- * @param[in] folder: folder containing the match files
+ * @param[in] filepath: path of the match file
+ * @param[in] viewsKeysFilter: only load pairs between these views (binary files only, all by default)
+ * @param[in] descTypesFilter: only load these describer types (binary files only, all by default)
  */
 bool LoadMatchFile(
   PairwiseMatches& matches,
-  const std::string& folder,
-  const std::string& filename);
+  const std::string& filepath,
+  const std::set<IndexT>& viewsKeysFilter = std::set<IndexT>(),
+  const std::vector<feature::EImageDescriberType>& descTypesFilter = std::vector<feature::EImageDescriberType>());
 
 /**
  * @brief Load the match file for each image.
  *
  * @param[out] matches: container for the output matches
+ * @param[in] viewsKeys: views for which a match file should be loaded
  * @param[in] folder: folder containing the match files
+ * @param[in] basename: match file basename (matches.txt or matches.bin)
+ * @param[in] descTypesFilter: only load these describer types (binary files only, all by default)
  */
 bool LoadMatchFilePerImage(
   PairwiseMatches& matches,
   const std::set<IndexT>& viewsKeys,
-  const std::string& folder);
+  const std::string& folder,
+  const std::string& basename,
+  const std::vector<feature::EImageDescriberType>& descTypesFilter = std::vector<feature::EImageDescriberType>());
 
 /**
  * @brief Load match files.
@@ -73,6 +87,7 @@ void filterTopMatches(
  * @param[in] sfm_data
  * @param[in] folder: folder containing the match files
  * @param[in] extension: txt or bin file format
+ *            (the binary format stores a per-pair index for random access)
  * @param[in] matchFilePerImage: do we store a global match file
  *            or one match file per image
  */
@@ -14,6 +14,7 @@
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
 #include <aliceVision/system/Logger.hpp>
 #include <xmmintrin.h>
+#include <emmintrin.h>
 #endif
 
 #include <cstddef>
@@ -117,6 +118,34 @@ namespace optim_ss2{
       return 0.0f;
     }
   }
+  // Euclidean distance (SSE2 method) of unsigned char arrays (squared result)
+  inline int l2_sse(const unsigned char * b1, const unsigned char * b2, int size)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i cumSum = zero;
+    int i = 0;
+    for(; i + 16 <= size; i += 16)
+    {
+      const __m128i srcA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b1 + i));
+      const __m128i srcB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b2 + i));
+      //-- Absolute difference
+      const __m128i diff = _mm_or_si128(_mm_subs_epu8(srcA, srcB), _mm_subs_epu8(srcB, srcA));
+      //-- Multiply and sum in 32 bits integers
+      const __m128i diffLow = _mm_unpacklo_epi8(diff, zero);
+      const __m128i diffHigh = _mm_unpackhi_epi8(diff, zero);
+      cumSum = _mm_add_epi32(cumSum, _mm_madd_epi16(diffLow, diffLow));
+      cumSum = _mm_add_epi32(cumSum, _mm_madd_epi16(diffHigh, diffHigh));
+    }
+    cumSum = _mm_add_epi32(cumSum, _mm_shuffle_epi32(cumSum, _MM_SHUFFLE(1, 0, 3, 2)));
+    cumSum = _mm_add_epi32(cumSum, _mm_shuffle_epi32(cumSum, _MM_SHUFFLE(2, 3, 0, 1)));
+    int result = _mm_cvtsi128_si32(cumSum);
+    for(; i < size; ++i)
+    {
+      const int diff = int(b1[i]) - int(b2[i]);
+      result += diff * diff;
+    }
+    return result;
+  }
 } // namespace optim_ss2
 
 // Template specification to run SSE L2 squared distance
@@ -134,6 +163,21 @@ struct L2_Vectorized<float>
   }
 };
 
+// Template specification to run SSE2 L2 squared distance
+//  on unsigned char vector (exact integer computation)
+template<>
+struct L2_Vectorized<unsigned char>
+{
+  typedef unsigned char ElementType;
+  typedef Accumulator<unsigned char>::Type ResultType;
+
+  template <typename Iterator1, typename Iterator2>
+  inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
+  {
+    return static_cast<ResultType>(optim_ss2::l2_sse(a,b,size));
+  }
+};
+
 #endif // ALICEVISION_HAVE_SSE
 
 }  // namespace matching
@@ -44,6 +44,23 @@ BOOST_AUTO_TEST_CASE(Metric_L2_Vectorized)
   BOOST_CHECK_EQUAL(168, DistanceT<L2_Vectorized<double> >());
 }
 
+BOOST_AUTO_TEST_CASE(Metric_L2_Vectorized_Descriptor)
+{
+  // SIFT like descriptors, with a size not multiple of the SIMD width
+  unsigned char array1[133];
+  unsigned char array2[133];
+  for(int i = 0; i < 133; ++i)
+  {
+    array1[i] = static_cast<unsigned char>((i * 37) % 256);
+    array2[i] = static_cast<unsigned char>((i * 101 + 7) % 256);
+  }
+  for(size_t size : {128, 133})
+  {
+    BOOST_CHECK_EQUAL(L2_Simple<unsigned char>()(array1, array2, size), L2_Vectorized<unsigned char>()(array1, array2, size));
+    BOOST_CHECK_EQUAL(0, L2_Vectorized<unsigned char>()(array1, array1, size));
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Metric_HAMMING_BITSET)
 {
   std::bitset<8> a(std::string("01010101"));
@@ -10,6 +10,7 @@
 #include <aliceVision/matching/IndMatchDecorator.hpp>
 #include <aliceVision/matching/filters.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 
@@ -115,6 +116,9 @@ void Match
     }
   }
 
+  // Matching buffers of each thread, reused for all the pairs
+  std::vector<CascadeHasher::MatchingScratch> matchingScratches(omp_get_max_threads());
+
   // Perform matching between all the pairs
   for (Map_vectorT::const_iterator iter = map_Pairs.begin();
     iter != map_Pairs.end(); ++iter)
@@ -138,16 +142,16 @@ void Match
     for (int j = 0; j < (int)indexToCompare.size(); ++j)
     {
       size_t J = indexToCompare[j];
-      const feature::Regions &regionsJ = regionsPerView.getRegions(I, descType);
-
       if (!regionsPerView.viewExist(J)
-          || regionsI.Type_id() != regionsJ.Type_id())
+          || regionsI.Type_id() != regionsPerView.getRegions(J, descType).Type_id())
       {
         #pragma omp critical
         ++my_progress_bar;
         continue;
       }
 
+      const feature::Regions &regionsJ = regionsPerView.getRegions(J, descType);
+
       // Matrix representation of the query input data;
       const ScalarT * tabJ = reinterpret_cast<const ScalarT*>(regionsJ.DescriptorRawData());
       Eigen::Map<BaseMat> mat_J( (ScalarT*)tabJ, regionsJ.RegionCount(), dimension);
@@ -160,9 +164,10 @@ void Match
 
       // Match the query descriptors to the database
       cascade_hasher.Match_HashedDescriptions<BaseMat, ResultType>(
-        hashed_base_[J], mat_J,
-        hashed_base_[I], mat_I,
-        &pvec_indices, &pvec_distances);
+        hashed_base_.at(J), mat_J,
+        hashed_base_.at(I), mat_I,
+        &pvec_indices, &pvec_distances, 2,
+        &matchingScratches.at(omp_get_thread_num()));
 
       std::vector<int> vec_nn_ratio_idx;
       // Filter the matches using a distance ratio test:
@@ -0,0 +1,234 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "RegionsCache.hpp"
+#include <aliceVision/matchingImageCollection/pairBuilder.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+RegionsCache::RegionsCache(const RegionsLoader& loader,
+                           const std::vector<feature::EImageDescriberType>& describerTypes,
+                           std::size_t maxMemorySize)
+  : _loader(loader)
+  , _describerTypes(describerTypes)
+  , _maxMemorySize(maxMemorySize)
+{}
+
+RegionsCache::~RegionsCache()
+{
+  if(_prefetchThread.joinable())
+    _prefetchThread.join();
+}
+
+void RegionsCache::acquire(const std::set<IndexT>& viewIds, feature::RegionsPerView& out_regionsPerView)
+{
+  waitPrefetch();
+
+  for(IndexT viewId : viewIds)
+  {
+    feature::MapRegionsPerDesc regions;
+    bool inCache = false;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_inUse.count(viewId))
+        throw std::logic_error("The regions of the view " + std::to_string(viewId) + " are already in use.");
+
+      auto it = _entries.find(viewId);
+      if(it != _entries.end())
+      {
+        regions = std::move(it->second.regions);
+        _memorySize -= it->second.memorySize;
+        _lru.erase(it->second.lruIt);
+        _entries.erase(it);
+        inCache = true;
+        ++_nbHits;
+      }
+    }
+
+    if(!inCache)
+      regions = load(viewId);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(!inCache)
+      ++_nbLoads;
+    _inUse.insert(viewId);
+    out_regionsPerView.getData()[viewId] = std::move(regions);
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _nextViewIds.clear();
+}
+
+void RegionsCache::release(feature::RegionsPerView& regionsPerView)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  for(auto& regionsPerDesc : regionsPerView.getData())
+  {
+    _inUse.erase(regionsPerDesc.first);
+    insert(regionsPerDesc.first, std::move(regionsPerDesc.second));
+  }
+  regionsPerView.getData().clear();
+
+  // the views of the next block are evicted last
+  for(IndexT viewId : _nextViewIds)
+  {
+    auto it = _entries.find(viewId);
+    if(it != _entries.end())
+      _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+  }
+
+  evict();
+}
+
+void RegionsCache::prefetch(const std::set<IndexT>& viewIds)
+{
+  waitPrefetch();
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _nextViewIds = viewIds;
+  }
+
+  _prefetchThread = std::thread([this, viewIds]()
+  {
+    try
+    {
+      std::size_t prefetchedSize = 0;
+      for(IndexT viewId : viewIds)
+      {
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          auto it = _entries.find(viewId);
+          if(it != _entries.end())
+          {
+            _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+            prefetchedSize += it->second.memorySize;
+            continue;
+          }
+          // the views in use will be released in the cache,
+          // and there is no need to load more regions than the cache can keep
+          if(_inUse.count(viewId) || prefetchedSize >= _maxMemorySize)
+            continue;
+        }
+
+        feature::MapRegionsPerDesc regions = load(viewId);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_nbLoads;
+        insert(viewId, std::move(regions));
+        prefetchedSize += _entries.at(viewId).memorySize;
+        evict();
+      }
+    }
+    catch(...)
+    {
+      _prefetchError = std::current_exception();
+    }
+  });
+}
+
+std::size_t RegionsCache::getMemorySize() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _memorySize;
+}
+
+std::size_t RegionsCache::getNbLoads() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _nbLoads;
+}
+
+std::size_t RegionsCache::getNbHits() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _nbHits;
+}
+
+feature::MapRegionsPerDesc RegionsCache::load(IndexT viewId) const
+{
+  feature::MapRegionsPerDesc regionsPerDesc;
+  for(const feature::EImageDescriberType descType : _describerTypes)
+  {
+    std::unique_ptr<feature::Regions> regions = _loader(viewId, descType);
+    if(!regions)
+      throw std::runtime_error("Can't load the " + feature::EImageDescriberType_enumToString(descType) + " regions of the view " + std::to_string(viewId) + ".");
+    regionsPerDesc[descType] = std::move(regions);
+  }
+  return regionsPerDesc;
+}
+
+void RegionsCache::insert(IndexT viewId, feature::MapRegionsPerDesc&& regions)
+{
+  assert(_entries.count(viewId) == 0);
+
+  std::size_t memorySize = 0;
+  for(const auto& regionsPerDesc : regions)
+    memorySize += regionsPerDesc.second->getMemorySize();
+
+  _lru.push_front(viewId);
+  Entry& entry = _entries[viewId];
+  entry.regions = std::move(regions);
+  entry.memorySize = memorySize;
+  entry.lruIt = _lru.begin();
+  _memorySize += memorySize;
+}
+
+void RegionsCache::evict()
+{
+  while(_memorySize > _maxMemorySize && !_lru.empty())
+  {
+    auto it = _entries.find(_lru.back());
+    assert(it != _entries.end());
+    _memorySize -= it->second.memorySize;
+    _entries.erase(it);
+    _lru.pop_back();
+  }
+}
+
+void RegionsCache::waitPrefetch()
+{
+  if(_prefetchThread.joinable())
+    _prefetchThread.join();
+
+  if(_prefetchError)
+  {
+    std::exception_ptr error = _prefetchError;
+    _prefetchError = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void processPairBlocks(RegionsCache& cache,
+                       const std::vector<PairSet>& blocks,
+                       const std::function<void(const feature::RegionsPerView& regionsPerView, const PairSet& pairs)>& process)
+{
+  for(std::size_t i = 0; i < blocks.size(); ++i)
+  {
+    feature::RegionsPerView regionsPerView;
+    cache.acquire(getPairsViewIds(blocks.at(i)), regionsPerView);
+
+    if(i + 1 < blocks.size())
+      cache.prefetch(getPairsViewIds(blocks.at(i + 1)));
+
+    ALICEVISION_LOG_INFO("Block " << i + 1 << "/" << blocks.size() << ": " << blocks.at(i).size() << " pairs, "
+                         << regionsPerView.getData().size() << " views (" << cache.getMemorySize() / (1024 * 1024) << " MB of regions in cache).");
+
+    process(regionsPerView, blocks.at(i));
+    cache.release(regionsPerView);
+  }
+}
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
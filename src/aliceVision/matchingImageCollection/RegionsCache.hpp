@@ -0,0 +1,137 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/feature/RegionsPerView.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+/**
+ * @brief Cache of the regions of the views, bounded in memory, for the out-of-core matching.
+ *
+ * The regions of the views of a block of pairs are lent to a RegionsPerView for the matching of the block,
+ * then given back to the cache. The cache keeps the regions not in use up to a maximal memory size,
+ * evicting the least recently used views first.
+ * The regions of the next block can be loaded in a background thread while the current block is matched.
+ */
+class RegionsCache
+{
+public:
+  /// function loading the regions of a view for a describer type
+  using RegionsLoader = std::function<std::unique_ptr<feature::Regions>(IndexT viewId, feature::EImageDescriberType descType)>;
+
+  /**
+   * @param[in] loader the function loading the regions (called from the calling thread or the background thread)
+   * @param[in] describerTypes the describer types loaded for each view
+   * @param[in] maxMemorySize the maximal memory size (in bytes) of the regions kept in the cache
+   */
+  RegionsCache(const RegionsLoader& loader,
+               const std::vector<feature::EImageDescriberType>& describerTypes,
+               std::size_t maxMemorySize);
+
+  /// wait for the background loading
+  ~RegionsCache();
+
+  /**
+   * @brief Move the regions of some views into a RegionsPerView, loading the ones not in the cache.
+   *        The regions are in use until they are given back with release().
+   * @param[in] viewIds the views to acquire
+   * @param[out] out_regionsPerView the regions of the views
+   */
+  void acquire(const std::set<IndexT>& viewIds, feature::RegionsPerView& out_regionsPerView);
+
+  /**
+   * @brief Give back the regions of a RegionsPerView to the cache, then evict the least recently used views
+   *        to fit in the maximal memory size.
+   * @param[in,out] regionsPerView the regions to release, emptied
+   */
+  void release(feature::RegionsPerView& regionsPerView);
+
+  /**
+   * @brief Load in a background thread the regions of some views, to acquire them afterwards.
+   *        The views in use are not loaded: they should be released before the next acquire().
+   * @param[in] viewIds the views to load
+   */
+  void prefetch(const std::set<IndexT>& viewIds);
+
+  /// @return the memory size (in bytes) of the regions in the cache, not in use
+  std::size_t getMemorySize() const;
+
+  /// @return the number of views loaded
+  std::size_t getNbLoads() const;
+
+  /// @return the number of views acquired from the cache
+  std::size_t getNbHits() const;
+
+private:
+  struct Entry
+  {
+    feature::MapRegionsPerDesc regions;
+    std::size_t memorySize;
+    std::list<IndexT>::iterator lruIt;
+  };
+
+  /// load the regions of a view for all the describer types
+  feature::MapRegionsPerDesc load(IndexT viewId) const;
+
+  /// add the regions of a view to the cache as the most recently used (the mutex must be locked)
+  void insert(IndexT viewId, feature::MapRegionsPerDesc&& regions);
+
+  /// evict the least recently used views to fit in the maximal memory size (the mutex must be locked)
+  void evict();
+
+  /// wait for the background loading and throw its error if any
+  void waitPrefetch();
+
+  RegionsLoader _loader;
+  std::vector<feature::EImageDescriberType> _describerTypes;
+  std::size_t _maxMemorySize;
+  std::size_t _memorySize = 0;
+  std::size_t _nbLoads = 0;
+  std::size_t _nbHits = 0;
+
+  /// regions in the cache
+  std::map<IndexT, Entry> _entries;
+  /// views in the cache, the most recently used first
+  std::list<IndexT> _lru;
+  /// views lent by acquire()
+  std::set<IndexT> _inUse;
+  /// views of the last prefetch, evicted after the other ones
+  std::set<IndexT> _nextViewIds;
+
+  mutable std::mutex _mutex;
+  std::thread _prefetchThread;
+  std::exception_ptr _prefetchError;
+};
+
+/**
+ * @brief Process blocks of pairs with the regions of their views, acquired from a cache.
+ *        The regions of the next block are prefetched while a block is processed.
+ * @param[in,out] cache the regions cache
+ * @param[in] blocks the blocks of pairs, in their processing order (see getPairBlocks)
+ * @param[in] process the function processing a block with the regions of its views
+ */
+void processPairBlocks(RegionsCache& cache,
+                       const std::vector<PairSet>& blocks,
+                       const std::function<void(const feature::RegionsPerView& regionsPerView, const PairSet& pairs)>& process);
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
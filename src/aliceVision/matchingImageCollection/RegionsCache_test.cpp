@@ -0,0 +1,282 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/matchingImageCollection/RegionsCache.hpp"
+#include "aliceVision/matchingImageCollection/ImageCollectionMatcher_generic.hpp"
+#include "aliceVision/matchingImageCollection/pairBuilder.hpp"
+#include "aliceVision/matchingImageCollection/GeometricFilter.hpp"
+#include "aliceVision/matchingImageCollection/GeometricFilterMatrix_F_AC.hpp"
+#include "aliceVision/feature/regionsFactory.hpp"
+#include "aliceVision/feature/selection.hpp"
+#include "aliceVision/camera/Pinhole.hpp"
+#include "aliceVision/sfmData/SfMData.hpp"
+
+#include <atomic>
+#include <random>
+#include <stdexcept>
+
+#define BOOST_TEST_MODULE matchingImageCollectionRegionsCache
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matchingImageCollection;
+
+namespace {
+
+const feature::EImageDescriberType descType = feature::EImageDescriberType::SIFT;
+
+const std::size_t imageSize = 1000;
+const double focalLength = 1000.0;
+
+// Center of the camera of a view: the cameras translate along the x axis, with the identity rotation
+Vec3 cameraCenter(IndexT viewId)
+{
+  return Vec3(0.1 * viewId, 0.05 * (viewId % 3), 0.0);
+}
+
+// Create the regions of a view: noisy copies of descriptors drawn from a common pool,
+// such that the views have matches (the regions of a view are always the same).
+// Each descriptor of the pool is a 3D point, and its features are the projections of the point,
+// such that the matches are consistent with the geometry of the views.
+std::unique_ptr<feature::Regions> createRegions(IndexT viewId)
+{
+  const int poolSize = 400;
+  const int nbRegions = 200;
+
+  std::mt19937 poolGenerator(0);
+  std::uniform_int_distribution<int> binDistribution(0, 255);
+  std::uniform_real_distribution<double> xDistribution(-1.0, 3.0);
+  std::uniform_real_distribution<double> yDistribution(-3.0, 3.0);
+  std::uniform_real_distribution<double> zDistribution(8.0, 12.0);
+  std::vector<feature::SIFT_Regions::DescriptorT> pool(poolSize);
+  std::vector<Vec3> points(poolSize);
+  for(int p = 0; p < poolSize; ++p)
+  {
+    for(std::size_t k = 0; k < pool[p].size(); ++k)
+      pool[p][k] = static_cast<unsigned char>(binDistribution(poolGenerator));
+    points[p] = Vec3(xDistribution(poolGenerator), yDistribution(poolGenerator), zDistribution(poolGenerator));
+  }
+
+  std::mt19937 generator(viewId);
+  std::uniform_int_distribution<int> poolDistribution(0, poolSize - 1);
+  std::uniform_int_distribution<int> noiseDistribution(-3, 3);
+  std::uniform_real_distribution<float> scaleDistribution(1.0f, 4.0f);
+
+  const Vec3 center = cameraCenter(viewId);
+  std::unique_ptr<feature::SIFT_Regions> regions(new feature::SIFT_Regions());
+  for(int i = 0; i < nbRegions; ++i)
+  {
+    const int p = poolDistribution(generator);
+    feature::SIFT_Regions::DescriptorT descriptor = pool.at(p);
+    for(std::size_t k = 0; k < descriptor.size(); ++k)
+      descriptor[k] = static_cast<unsigned char>(std::min(255, std::max(0, descriptor[k] + noiseDistribution(generator))));
+    const Vec3 point = points.at(p) - center;
+    const double x = focalLength * point(0) / point(2) + imageSize / 2.0;
+    const double y = focalLength * point(1) / point(2) + imageSize / 2.0;
+    regions->Features().emplace_back(x, y, scaleDistribution(generator), 0.0f);
+    regions->Descriptors().push_back(descriptor);
+  }
+  return std::unique_ptr<feature::Regions>(regions.release());
+}
+
+// Create the views and the intrinsic of the regions of createRegions
+sfmData::SfMData createSfMData(const std::set<IndexT>& viewIds)
+{
+  sfmData::SfMData sfmData;
+  sfmData.intrinsics.emplace(0, std::make_shared<camera::Pinhole>(imageSize, imageSize, focalLength, imageSize / 2.0, imageSize / 2.0));
+  for(IndexT viewId : viewIds)
+    sfmData.views.emplace(viewId, std::make_shared<sfmData::View>("", viewId, 0, viewId, imageSize, imageSize));
+  return sfmData;
+}
+
+// Matches of each step of the feature matching
+struct MatchingSteps
+{
+  matching::PairwiseMatches putativeMatches;
+  matching::PairwiseMatches geometricMatches;
+  matching::PairwiseMatches finalMatches;
+};
+
+// Match a set of pairs like the feature matching pipeline: putative matches,
+// geometric filtering with a fundamental matrix and grid filtering
+void matchPairs(const sfmData::SfMData& sfmData,
+                const feature::RegionsPerView& regionsPerView,
+                const PairSet& pairs,
+                MatchingSteps& steps)
+{
+  const ImageCollectionMatcher_generic matcher(0.8f, matching::BRUTE_FORCE_L2);
+  matching::PairwiseMatches putativeMatches;
+  matcher.Match(regionsPerView, pairs, descType, putativeMatches);
+
+  matching::PairwiseMatches geometricMatches;
+  robustModelEstimation(geometricMatches, &sfmData, regionsPerView, GeometricFilterMatrix_F_AC(), putativeMatches);
+
+  for(const auto& pairMatches : geometricMatches)
+  {
+    const Pair& pair = pairMatches.first;
+    const auto& lRegions = dynamic_cast<const feature::SIFT_Regions&>(regionsPerView.getRegions(pair.first, descType));
+    const auto& rRegions = dynamic_cast<const feature::SIFT_Regions&>(regionsPerView.getRegions(pair.second, descType));
+    matching::IndMatches matches;
+    feature::sortMatches_byFeaturesScale(pairMatches.second.at(descType), lRegions, rRegions, matches);
+    feature::matchesGridFiltering(lRegions, rRegions, pair, sfmData, matches);
+    steps.finalMatches[pair][descType] = matches;
+  }
+
+  steps.putativeMatches.insert(putativeMatches.begin(), putativeMatches.end());
+  steps.geometricMatches.insert(geometricMatches.begin(), geometricMatches.end());
+}
+
+void checkSameMatches(const matching::PairwiseMatches& matches, const matching::PairwiseMatches& refMatches)
+{
+  BOOST_CHECK_GT(refMatches.size(), 0);
+  BOOST_CHECK_EQUAL(matches.size(), refMatches.size());
+  for(const auto& pairMatches : refMatches)
+  {
+    BOOST_CHECK(matches.count(pairMatches.first));
+    if(!matches.count(pairMatches.first))
+      continue;
+    const matching::IndMatches& refPairMatches = pairMatches.second.at(descType);
+    const matching::IndMatches& pairMatchesToCheck = matches.at(pairMatches.first).at(descType);
+    BOOST_CHECK_EQUAL(pairMatchesToCheck.size(), refPairMatches.size());
+    BOOST_CHECK(pairMatchesToCheck == refPairMatches);
+  }
+}
+
+std::set<IndexT> createViewIds(IndexT begin, IndexT end)
+{
+  std::set<IndexT> viewIds;
+  for(IndexT viewId = begin; viewId < end; ++viewId)
+    viewIds.insert(viewId);
+  return viewIds;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_regionsCache)
+{
+  std::atomic<int> nbLoads(0);
+  const RegionsCache::RegionsLoader loader = [&nbLoads](IndexT viewId, feature::EImageDescriberType)
+  {
+    ++nbLoads;
+    return createRegions(viewId);
+  };
+
+  const std::size_t viewMemorySize = createRegions(0)->getMemorySize();
+  BOOST_CHECK_GT(viewMemorySize, 0);
+
+  // room for 4 views in the cache
+  RegionsCache cache(loader, {descType}, 4 * viewMemorySize);
+
+  feature::RegionsPerView regionsPerView;
+  cache.acquire(createViewIds(0, 3), regionsPerView);
+  BOOST_CHECK_EQUAL(regionsPerView.getData().size(), 3);
+  BOOST_CHECK_EQUAL(regionsPerView.getRegions(2, descType).RegionCount(), 200);
+  BOOST_CHECK_EQUAL(nbLoads, 3);
+  BOOST_CHECK_EQUAL(cache.getMemorySize(), 0);
+
+  // a view can't be in use twice
+  {
+    feature::RegionsPerView otherRegionsPerView;
+    BOOST_CHECK_THROW(cache.acquire(createViewIds(2, 3), otherRegionsPerView), std::logic_error);
+  }
+
+  const feature::Regions* regions1 = &regionsPerView.getRegions(1, descType);
+  cache.release(regionsPerView);
+  BOOST_CHECK(regionsPerView.isEmpty());
+  BOOST_CHECK_EQUAL(cache.getMemorySize(), 3 * viewMemorySize);
+
+  // the released views are in the cache
+  cache.acquire(createViewIds(1, 4), regionsPerView);
+  BOOST_CHECK_EQUAL(nbLoads, 4);
+  BOOST_CHECK_EQUAL(cache.getNbHits(), 2);
+  BOOST_CHECK_EQUAL(&regionsPerView.getRegions(1, descType), regions1);
+
+  // prefetch while the views are in use: only the views not in use are loaded
+  cache.prefetch(createViewIds(3, 6));
+  cache.release(regionsPerView);
+  cache.acquire(createViewIds(3, 6), regionsPerView);
+  BOOST_CHECK_EQUAL(nbLoads, 6);
+  BOOST_CHECK_EQUAL(cache.getNbLoads(), 6);
+  BOOST_CHECK_EQUAL(cache.getNbHits(), 5);
+  cache.release(regionsPerView);
+
+  // the least recently used views are evicted
+  BOOST_CHECK_EQUAL(cache.getMemorySize(), 4 * viewMemorySize);
+  cache.acquire(createViewIds(0, 1), regionsPerView);
+  BOOST_CHECK_EQUAL(nbLoads, 7);
+  cache.release(regionsPerView);
+  cache.acquire(createViewIds(3, 6), regionsPerView);
+  BOOST_CHECK_EQUAL(nbLoads, 7);
+  cache.release(regionsPerView);
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_regionsCache_prefetchError)
+{
+  const RegionsCache::RegionsLoader loader = [](IndexT viewId, feature::EImageDescriberType) -> std::unique_ptr<feature::Regions>
+  {
+    if(viewId == 3)
+      throw std::runtime_error("Can't find view 3 region files");
+    return createRegions(viewId);
+  };
+
+  RegionsCache cache(loader, {descType}, 1024 * 1024);
+  cache.prefetch(createViewIds(0, 5));
+
+  // the error of the background loading is thrown by the next acquire
+  feature::RegionsPerView regionsPerView;
+  BOOST_CHECK_THROW(cache.acquire(createViewIds(0, 2), regionsPerView), std::runtime_error);
+  BOOST_CHECK_NO_THROW(cache.acquire(createViewIds(0, 2), regionsPerView));
+  BOOST_CHECK_EQUAL(regionsPerView.getData().size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_regionsCache_blockMatching)
+{
+  // all the pairs of 23 views
+  PairSet pairs;
+  for(IndexT i = 0; i < 23; ++i)
+    for(IndexT j = i + 1; j < 23; ++j)
+      pairs.insert(std::make_pair(i, j));
+
+  const sfmData::SfMData sfmData = createSfMData(getPairsViewIds(pairs));
+
+  // in memory matching
+  MatchingSteps inMemorySteps;
+  {
+    feature::RegionsPerView regionsPerView;
+    for(IndexT viewId : getPairsViewIds(pairs))
+      regionsPerView.addRegions(viewId, descType, createRegions(viewId).release());
+    matchPairs(sfmData, regionsPerView, pairs, inMemorySteps);
+  }
+
+  // matching by blocks of pairs, with room for 6 views in the cache
+  MatchingSteps blockSteps;
+  std::atomic<int> nbLoads(0);
+  const RegionsCache::RegionsLoader loader = [&nbLoads](IndexT viewId, feature::EImageDescriberType)
+  {
+    ++nbLoads;
+    return createRegions(viewId);
+  };
+  RegionsCache cache(loader, {descType}, 6 * createRegions(0)->getMemorySize());
+
+  const std::vector<PairSet> blocks = getPairBlocks(pairs, 4);
+  processPairBlocks(cache, blocks, [&](const feature::RegionsPerView& regionsPerView, const PairSet& blockPairs)
+  {
+    BOOST_CHECK_LE(regionsPerView.getData().size(), 8);
+    matchPairs(sfmData, regionsPerView, blockPairs, blockSteps);
+  });
+
+  // the cache avoids reloading the views shared by consecutive blocks
+  std::size_t nbBlockViews = 0;
+  for(const PairSet& block : blocks)
+    nbBlockViews += getPairsViewIds(block).size();
+  BOOST_CHECK_LT(nbLoads, static_cast<int>(nbBlockViews));
+
+  // each step gives the same matches as in memory
+  checkSameMatches(blockSteps.putativeMatches, inMemorySteps.putativeMatches);
+  checkSameMatches(blockSteps.geometricMatches, inMemorySteps.geometricMatches);
+  checkSameMatches(blockSteps.finalMatches, inMemorySteps.finalMatches);
+}
@@ -11,6 +11,8 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <cassert>
+#include <map>
 #include <set>
 #include <iostream>
 #include <fstream>
@@ -123,4 +125,81 @@ bool savePairs(const std::string &sFileName, const PairSet & pairs)
   return bOk;
 }
 
+std::set<IndexT> getPairsViewIds(const PairSet& pairs)
+{
+  std::set<IndexT> viewIds;
+  for(const Pair& pair : pairs)
+  {
+    viewIds.insert(pair.first);
+    viewIds.insert(pair.second);
+  }
+  return viewIds;
+}
+
+std::vector<PairSet> getPairBlocks(const PairSet& pairs, std::size_t blockSize)
+{
+  assert(blockSize > 0);
+
+  // group of each view
+  std::map<IndexT, std::size_t> viewGroups;
+  {
+    const std::set<IndexT> viewIds = getPairsViewIds(pairs);
+    std::size_t i = 0;
+    for(IndexT viewId : viewIds)
+      viewGroups[viewId] = (i++) / blockSize;
+  }
+  const std::size_t nbGroups = viewGroups.empty() ? 0 : viewGroups.rbegin()->second + 1;
+
+  // pairs of each block of the upper triangular matrix of groups
+  std::map<std::pair<std::size_t, std::size_t>, PairSet> blocks;
+  for(const Pair& pair : pairs)
+  {
+    const std::size_t groupA = viewGroups.at(pair.first);
+    const std::size_t groupB = viewGroups.at(pair.second);
+    blocks[std::make_pair(std::min(groupA, groupB), std::max(groupA, groupB))].insert(pair);
+  }
+
+  // order of the blocks (row, col) such that two consecutive blocks share a group:
+  // - even rows from the diagonal to the last column,
+  // - odd rows from the last column, ending with the diagonal and the block next to it,
+  // - if the last row follows an odd row, its block follows the block (0, last) of the first row.
+  const bool moveLastDiagonal = (nbGroups > 2 && (nbGroups - 1) % 2 == 0);
+  std::vector<std::pair<std::size_t, std::size_t>> order;
+  for(std::size_t row = 0; row < nbGroups; ++row)
+  {
+    const std::size_t last = nbGroups - 1;
+    if(row == last && moveLastDiagonal)
+      break;
+    if(row % 2 == 0)
+    {
+      for(std::size_t col = row; col <= last; ++col)
+        order.emplace_back(row, col);
+      if(row == 0 && moveLastDiagonal)
+        order.emplace_back(last, last);
+    }
+    else if(row + 1 < last)
+    {
+      for(std::size_t col = last; col > row + 1; --col)
+        order.emplace_back(row, col);
+      order.emplace_back(row, row);
+      order.emplace_back(row, row + 1);
+    }
+    else
+    {
+      for(std::size_t col = last + 1; col > row; --col)
+        order.emplace_back(row, col - 1);
+    }
+  }
+
+  std::vector<PairSet> orderedBlocks;
+  orderedBlocks.reserve(blocks.size());
+  for(const auto& block : order)
+  {
+    auto it = blocks.find(block);
+    if(it != blocks.end())
+      orderedBlocks.push_back(std::move(it->second));
+  }
+  return orderedBlocks;
+}
+
 }; // namespace aliceVision
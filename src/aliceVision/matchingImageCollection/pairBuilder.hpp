@@ -11,6 +11,8 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 
 #include <algorithm>
+#include <set>
+#include <vector>
 
 namespace aliceVision {
 
@@ -30,4 +32,21 @@ bool loadPairs(
 /// I K
 bool savePairs(const std::string &sFileName, const PairSet & pairs);
 
+/// Get the views of a set of pairs
+std::set<IndexT> getPairsViewIds(const PairSet& pairs);
+
+/**
+ * @brief Split a set of pairs into blocks, for a matching with a limited number of views in memory.
+ *
+ * The sorted views are split into groups of blockSize views: a block contains the pairs between two groups,
+ * as a tile of the pairwise adjacency matrix, so its pairs involve at most 2 * blockSize views.
+ * The blocks are ordered along the rows of the upper triangular matrix, in alternate directions,
+ * such that two consecutive blocks share a group of views (if no block is empty).
+ *
+ * @param[in] pairs the pairs to split
+ * @param[in] blockSize the number of views in a group
+ * @return the non empty blocks of pairs, in their matching order
+ */
+std::vector<PairSet> getPairBlocks(const PairSet& pairs, std::size_t blockSize);
+
 }; // namespace aliceVision
@@ -11,6 +11,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <iterator>
 #include <memory>
 
 #define BOOST_TEST_MODULE matchingImageCollectionPairBuilder
@@ -79,3 +80,58 @@ BOOST_AUTO_TEST_CASE(matchingImageCollection_IO)
   BOOST_CHECK( loadPairs("pairsT_IO.txt", loaded_Pairs));
   BOOST_CHECK( std::equal(loaded_Pairs.begin(), loaded_Pairs.end(), pairSetGTsorted.begin()) );
 }
+
+// Check that the blocks contain each pair once, with a limited number of views, and that consecutive blocks share views
+void checkPairBlocks(const PairSet& pairSet, const std::vector<PairSet>& blocks, std::size_t blockSize)
+{
+  PairSet allPairs;
+  std::set<IndexT> previousViewIds;
+  for(const PairSet& block : blocks)
+  {
+    BOOST_CHECK( checkPairOrder(block) );
+    for(const Pair& pair : block)
+    {
+      // each pair is in a single block
+      BOOST_CHECK( allPairs.insert(pair).second );
+    }
+
+    const std::set<IndexT> viewIds = getPairsViewIds(block);
+    BOOST_CHECK_LE(viewIds.size(), 2 * blockSize);
+
+    // consecutive blocks share views
+    if(!previousViewIds.empty())
+    {
+      std::vector<IndexT> commonViewIds;
+      std::set_intersection(previousViewIds.begin(), previousViewIds.end(), viewIds.begin(), viewIds.end(), std::back_inserter(commonViewIds));
+      BOOST_CHECK(!commonViewIds.empty());
+    }
+    previousViewIds = viewIds;
+  }
+  BOOST_CHECK( allPairs == pairSet );
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_pairBlocks)
+{
+  sfmData::Views views;
+  for(IndexT i = 0; i < 23; ++i)
+    views[3 * i + 1] = std::make_shared<sfmData::View>("filepath", 3 * i + 1);
+
+  const PairSet pairSet = exhaustivePairs(views);
+  const std::size_t blockSize = 5;
+  const std::vector<PairSet> blocks = getPairBlocks(pairSet, blockSize);
+
+  // 5 groups of views: 15 blocks in the upper triangular matrix
+  BOOST_CHECK_EQUAL(blocks.size(), 15);
+  checkPairBlocks(pairSet, blocks, blockSize);
+
+  // even and odd numbers of groups
+  for(std::size_t size = 1; size < 9; ++size)
+    checkPairBlocks(pairSet, getPairBlocks(pairSet, size), size);
+
+  // a single block with all the pairs
+  const std::vector<PairSet> singleBlock = getPairBlocks(pairSet, views.size());
+  BOOST_CHECK_EQUAL(singleBlock.size(), 1);
+  BOOST_CHECK( singleBlock.front() == pairSet );
+
+  BOOST_CHECK( getPairBlocks(PairSet(), blockSize).empty() );
+}
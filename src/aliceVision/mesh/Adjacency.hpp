@@ -0,0 +1,99 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/StaticVector.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Compressed sparse row (CSR) array of arrays of indexes.
+ *
+ * All the arrays are stored contiguously in a single buffer:
+ * the elements of the array i are values[offsets[i]] to values[offsets[i + 1] - 1].
+ * Used for the mesh connectivity (neighbor triangles and points of the vertices, neighbor triangles of the edges),
+ * without the heap allocation per array of StaticVector<StaticVector<int>*>.
+ */
+class Adjacency
+{
+public:
+    /// @return the number of arrays
+    int size() const { return _offsets.empty() ? 0 : static_cast<int>(_offsets.size()) - 1; }
+
+    /// @return true if there is no array
+    bool empty() const { return size() == 0; }
+
+    /// @return the number of elements of the array i
+    int size(int i) const { return _offsets[i + 1] - _offsets[i]; }
+
+    /// @return the number of elements of all the arrays
+    int nbValues() const { return static_cast<int>(_values.size()); }
+
+    /// @return the element j of the array i
+    int operator()(int i, int j) const { return _values[_offsets[i] + j]; }
+
+    const int* begin(int i) const { return _values.data() + _offsets[i]; }
+    const int* end(int i) const { return _values.data() + _offsets[i + 1]; }
+    int* begin(int i) { return _values.data() + _offsets[i]; }
+    int* end(int i) { return _values.data() + _offsets[i + 1]; }
+
+    /// @return the elements of all the arrays
+    std::vector<int>& values() { return _values; }
+    const std::vector<int>& values() const { return _values; }
+
+    /**
+     * @brief Get the position of a value in the array i
+     * @param[in] i the array index
+     * @param[in] value the value to find
+     * @return the position of the value in the array i, or -1
+     */
+    int indexOf(int i, int value) const
+    {
+        const int* it = std::find(begin(i), end(i), value);
+        return it != end(i) ? static_cast<int>(it - begin(i)) : -1;
+    }
+
+    /**
+     * @brief Allocate the arrays from their number of elements.
+     *        The elements are not initialized.
+     * @param[in] sizes the number of elements of each array
+     */
+    void resize(const std::vector<int>& sizes)
+    {
+        _offsets.resize(sizes.size() + 1);
+        _offsets[0] = 0;
+        std::partial_sum(sizes.begin(), sizes.end(), _offsets.begin() + 1);
+        _values.resize(_offsets.back());
+    }
+
+    void clear()
+    {
+        _offsets.clear();
+        _values.clear();
+    }
+
+    /// @return the memory used by the arrays (in bytes)
+    std::size_t memorySize() const
+    {
+        return (_offsets.capacity() + _values.capacity()) * sizeof(int);
+    }
+
+private:
+    /// position of the first element of each array, and total number of elements
+    std::vector<int> _offsets;
+    /// elements of all the arrays
+    std::vector<int> _values;
+};
+
+} // namespace mesh
+} // namespace aliceVision
@@ -5,15 +5,20 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Mesh.hpp"
+#include "meshRasterization.hpp"
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <map>
+#include <numeric>
 
 namespace aliceVision {
 namespace mesh {
@@ -508,148 +513,155 @@ bool Mesh::doesTriangleIntersectsRectangle(Mesh::triangle_proj* tp, Mesh::rectan
     */
 }
 
-StaticVector<StaticVector<int>*>* Mesh::getPtsNeighborTriangles()
+void Mesh::getPtsNeighborTriangles(Adjacency& out_ptsNeighTris) const
 {
-    // array of tuples <x: vertexIndex, y: triangleIndex, z: numberOfNeighbors>
-    StaticVector<Voxel> vertexNeighborhoodPairs;
-    vertexNeighborhoodPairs.reserve(tris->size() * 3);
-    for(int i = 0; i < tris->size(); ++i)
-    {
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[0], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[1], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[2], i, 0));
-    }
-    qsort(&vertexNeighborhoodPairs[0], vertexNeighborhoodPairs.size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
+    // number of neighbor triangles of each vertex
+    std::vector<int> nbNeighTris(pts->size(), 0);
 
-    int i = 0; // index of the unique pair of <vertex, neighborhood>
-    int j = 0; // index of the vertex
-    int k = 0; // number of neighbors
-    int firstid = 0;
-    while(i < vertexNeighborhoodPairs.size())
+    #pragma omp parallel for
+    for(int i = 0; i < tris->size(); ++i)
     {
-        k++;
-        // (*vertexNeighborhoodPairs)[i].z = j;
-        if((i == vertexNeighborhoodPairs.size() - 1) || (vertexNeighborhoodPairs[i].x != vertexNeighborhoodPairs[i + 1].x))
+        for(int k = 0; k < 3; ++k)
         {
-            vertexNeighborhoodPairs[firstid].z = k; // store the number of neighbors
-            ++j;
-            firstid = i + 1;
-            k = 0;
+            #pragma omp atomic
+            ++nbNeighTris[(*tris)[i].v[k]];
         }
-        ++i;
     }
-    int npts = j;
 
-    StaticVector<StaticVector<int>*>* out_ptsNeighTris = new StaticVector<StaticVector<int>*>();
-    out_ptsNeighTris->reserve(pts->size());
-    out_ptsNeighTris->resize_with(pts->size(), nullptr);
+    out_ptsNeighTris.resize(nbNeighTris);
 
-    i = 0;
-    for(j = 0; j < npts; ++j)
-    {
-        int middlePtId = vertexNeighborhoodPairs[i].x;
-        int nbNeighbors = vertexNeighborhoodPairs[i].z;
-        int i0 = i;
-        int i1 = i + nbNeighbors;
-        i = i1;
+    // the triangles are added in parallel (reusing the counters as insertion positions), then sorted
+    std::fill(nbNeighTris.begin(), nbNeighTris.end(), 0);
 
-        StaticVector<int>* triTmp = new StaticVector<int>();
-        triTmp->reserve(nbNeighbors);
-        for(int l = i0; l < i1; ++l)
+    #pragma omp parallel for
+    for(int i = 0; i < tris->size(); ++i)
+    {
+        for(int k = 0; k < 3; ++k)
         {
-            triTmp->push_back(vertexNeighborhoodPairs[l].y); // index of triangle
+            const int ptId = (*tris)[i].v[k];
+            int position;
+            #pragma omp atomic capture
+            position = nbNeighTris[ptId]++;
+            out_ptsNeighTris.begin(ptId)[position] = i;
         }
-
-        (*out_ptsNeighTris)[middlePtId] = triTmp;
     }
 
-    return out_ptsNeighTris;
+    #pragma omp parallel for
+    for(int ptId = 0; ptId < pts->size(); ++ptId)
+        std::sort(out_ptsNeighTris.begin(ptId), out_ptsNeighTris.end(ptId));
 }
 
-StaticVector<StaticVector<int>*>* Mesh::getPtsNeighPtsOrdered()
+void Mesh::getPtsNeighPtsOrdered(Adjacency& out_ptsNeighPts) const
 {
-    StaticVector<StaticVector<int>*>* ptsNeighborTriangles = getPtsNeighborTriangles();
+    Adjacency ptsNeighTris;
+    getPtsNeighborTriangles(ptsNeighTris);
+    getPtsNeighPtsOrdered(ptsNeighTris, out_ptsNeighPts);
+}
 
-    StaticVector<StaticVector<int>*>* out_ptsNeighPts = new StaticVector<StaticVector<int>*>();
-    out_ptsNeighPts->resize_with(pts->size(), nullptr);
+void Mesh::getPtsNeighPtsOrdered(const Adjacency& ptsNeighTris, Adjacency& out_ptsNeighPts) const
+{
+    std::vector<int> nbNeighPts(pts->size(), 0);
 
-    for(int middlePtId = 0; middlePtId < pts->size(); ++middlePtId)
-    {
-        StaticVector<int>* neighborTriangles = (*ptsNeighborTriangles)[middlePtId];
-        if((neighborTriangles == nullptr) || neighborTriangles->empty())
-            continue;
+    // each thread processes a contiguous range of vertices (static schedule),
+    // so the concatenation of the thread buffers follows the vertices order
+    std::vector<std::vector<int>> neighPtsPerThread(omp_get_max_threads());
 
-        StaticVector<int> vhid;
-        vhid.reserve(neighborTriangles->size() * 2);
-        int currentTriPtId = (*tris)[(*neighborTriangles)[0]].v[0];
-        int firstTriPtId = currentTriPtId;
-        vhid.push_back(currentTriPtId);
+    #pragma omp parallel
+    {
+        std::vector<int>& neighPts = neighPtsPerThread.at(omp_get_thread_num());
+        std::vector<int> neighborTriangles;
+        std::vector<int> vhid;
+        std::vector<int> vhidBackward;
 
-        bool isThereTWithCurrentTriPtId = true;
-        while(!neighborTriangles->empty() && isThereTWithCurrentTriPtId)
+        #pragma omp for schedule(static)
+        for(int middlePtId = 0; middlePtId < pts->size(); ++middlePtId)
         {
-            isThereTWithCurrentTriPtId = false;
+            neighborTriangles.assign(ptsNeighTris.begin(middlePtId), ptsNeighTris.end(middlePtId));
+            if(neighborTriangles.empty())
+                continue;
+
+            // start from a vertex of the first triangle, other than the middle point
+            const Mesh::triangle& firstTri = (*tris)[neighborTriangles[0]];
+            vhid.clear();
+            int currentTriPtId = (firstTri.v[0] != middlePtId) ? firstTri.v[0] : firstTri.v[1];
+            const int firstTriPtId = currentTriPtId;
+            vhid.push_back(currentTriPtId);
 
-            // find triangle with middlePtId and currentTriPtId and get remaining point id
-            for(int n = 0; n < neighborTriangles->size(); ++n)
+            // walk around the middle point from a neighbor point, through the triangles sharing their edge
+            const auto walk = [&](int walkPtId, std::vector<int>& walkedPts)
             {
-                bool ok_middlePtId = false;
-                bool ok_actTriPtId = false;
-                int remainingPtId = -1; // remaining pt id
-                for(int k = 0; k < 3; ++k)
+                bool isThereTWithCurrentTriPtId = true;
+                while(!neighborTriangles.empty() && isThereTWithCurrentTriPtId)
                 {
-                    int triPtId = (*tris)[(*neighborTriangles)[n]].v[k];
-                    double length = ((*pts)[middlePtId] - (*pts)[triPtId]).size();
-                    if((triPtId != middlePtId) && (triPtId != currentTriPtId) && (length > 0.0) && (!std::isnan(length)))
-                    {
-                        remainingPtId = triPtId;
-                    }
-                    if(triPtId == middlePtId)
-                    {
-                        ok_middlePtId = true;
-                    }
-                    if(triPtId == currentTriPtId)
+                    isThereTWithCurrentTriPtId = false;
+
+                    // find triangle with middlePtId and walkPtId and get remaining point id
+                    for(std::size_t n = 0; n < neighborTriangles.size(); ++n)
                     {
-                        ok_actTriPtId = true;
+                        bool ok_middlePtId = false;
+                        bool ok_actTriPtId = false;
+                        int remainingPtId = -1; // remaining pt id
+                        for(int k = 0; k < 3; ++k)
+                        {
+                            int triPtId = (*tris)[neighborTriangles[n]].v[k];
+                            double length = ((*pts)[middlePtId] - (*pts)[triPtId]).size();
+                            if((triPtId != middlePtId) && (triPtId != walkPtId) && (length > 0.0) && (!std::isnan(length)))
+                            {
+                                remainingPtId = triPtId;
+                            }
+                            if(triPtId == middlePtId)
+                            {
+                                ok_middlePtId = true;
+                            }
+                            if(triPtId == walkPtId)
+                            {
+                                ok_actTriPtId = true;
+                            }
+                        }
+
+                        if(ok_middlePtId && ok_actTriPtId && (remainingPtId > -1))
+                        {
+                            walkPtId = remainingPtId;
+                            neighborTriangles.erase(neighborTriangles.begin() + n);
+                            walkedPts.push_back(walkPtId);
+                            isThereTWithCurrentTriPtId = true; // we removed one, so we try again
+                            break;
+                        }
                     }
                 }
+                return walkPtId;
+            };
 
-                if(ok_middlePtId && ok_actTriPtId && (remainingPtId > -1))
-                {
-                    currentTriPtId = remainingPtId;
-                    neighborTriangles->remove(n);
-                    vhid.push_back(currentTriPtId);
-                    isThereTWithCurrentTriPtId = true; // we removed one, so we try again
-                    break;
-                }
-            }
-        }
+            currentTriPtId = walk(currentTriPtId, vhid);
 
-        if(!vhid.empty())
-        {
             if(currentTriPtId == firstTriPtId)
             {
-                vhid.pop(); // remove last ... which is first
+                vhid.pop_back(); // remove last ... which is first
+            }
+            else if(!neighborTriangles.empty())
+            {
+                // boundary point: walk the other way from the first point, then prepend
+                vhidBackward.clear();
+                walk(firstTriPtId, vhidBackward);
+                vhid.insert(vhid.begin(), vhidBackward.rbegin(), vhidBackward.rend());
             }
 
             // remove duplicates
-            StaticVector<int>* vhid1 = new StaticVector<int>();
-            vhid1->reserve(vhid.size());
-            for(int k1 = 0; k1 < vhid.size(); k1++)
+            const std::size_t nbNeighPtsBefore = neighPts.size();
+            for(int ptId : vhid)
             {
-                if(vhid1->indexOf(vhid[k1]) == -1)
-                {
-                    vhid1->push_back(vhid[k1]);
-                }
+                if(std::find(neighPts.begin() + nbNeighPtsBefore, neighPts.end(), ptId) == neighPts.end())
+                    neighPts.push_back(ptId);
             }
-
-            (*out_ptsNeighPts)[middlePtId] = vhid1;
+            nbNeighPts[middlePtId] = static_cast<int>(neighPts.size() - nbNeighPtsBefore);
         }
     }
 
-    deleteArrayOfArrays<int>(&ptsNeighborTriangles);
+    out_ptsNeighPts.resize(nbNeighPts);
 
-    return out_ptsNeighPts;
+    std::vector<int>::iterator valuesIt = out_ptsNeighPts.values().begin();
+    for(const std::vector<int>& neighPts : neighPtsPerThread)
+        valuesIt = std::copy(neighPts.begin(), neighPts.end(), valuesIt);
 }
 
 StaticVector<StaticVector<int>*>* Mesh::getTrisMap(const mvsUtils::MultiViewParams* mp, int rc, int  /*scale*/, int w, int h)
@@ -809,11 +821,9 @@ StaticVector<StaticVector<int>*>* Mesh::getTrisMap(StaticVector<int>* visTris, c
     return tmp;
 }
 
-void Mesh::getDepthMap(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int scale, int w, int h)
+void Mesh::getDepthMap(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int w, int h) const
 {
-    StaticVector<StaticVector<int>*>* tmp = getTrisMap(mp, rc, scale, w, h);
-    getDepthMap(depthMap, tmp, mp, rc, scale, w, h);
-    deleteArrayOfArrays<int>(&tmp);
+    rasterizeMesh(*this, *mp, rc, w, h, *depthMap);
 }
 
 void Mesh::getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<int>*>* tmp, const mvsUtils::MultiViewParams* mp,
@@ -975,6 +985,29 @@ StaticVector<int>* Mesh::getVisibleTrianglesIndexes(std::string tmpDir, const mv
     return vistri;
 }
 
+StaticVector<int>* Mesh::getVisibleTrianglesIndexes(const mvsUtils::MultiViewParams* mp, int rc, int w, int h) const
+{
+    StaticVector<float> depthMap;
+    StaticVector<int> trisMap;
+    rasterizeMesh(*this, *mp, rc, w, h, depthMap, &trisMap);
+
+    std::vector<char> isVisible(tris->size(), 0);
+    for(int i = 0; i < trisMap.size(); ++i)
+    {
+        if(trisMap[i] >= 0)
+            isVisible[trisMap[i]] = 1;
+    }
+
+    StaticVector<int>* out = new StaticVector<int>();
+    out->reserve(std::count(isVisible.begin(), isVisible.end(), 1));
+    for(int i = 0; i < tris->size(); ++i)
+    {
+        if(isVisible[i])
+            out->push_back(i);
+    }
+    return out;
+}
+
 StaticVector<int>* Mesh::getVisibleTrianglesIndexes(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc,
                                                        int w, int h)
 {
@@ -1159,95 +1192,107 @@ Mesh* Mesh::generateMeshFromTrianglesSubset(const StaticVector<int>& visTris, St
     return outMesh;
 }
 
-void Mesh::getNotOrientedEdges(StaticVector<StaticVector<int>*>** edgesNeighTris,
-                                  StaticVector<Pixel>** edgesPointsPairs)
+void Mesh::getNotOrientedEdges(Adjacency& edgesNeighTris, StaticVector<Pixel>& edgesPointsPairs) const
 {
-    // printf("getNotOrientedEdges\n");
-    StaticVector<Voxel>* edges = new StaticVector<Voxel>();
-    edges->reserve(tris->size() * 3);
+    const int nbPts = pts->size();
 
-    for(int i = 0; i < tris->size(); i++)
+    // the triangles edges are grouped by their smallest vertex index,
+    // with the largest vertex index and the triangle index packed in a 64 bits key
+    std::vector<int> trisEdgesOffsets(nbPts + 1, 0);
+
+    #pragma omp parallel for
+    for(int i = 0; i < tris->size(); ++i)
     {
-        int a = (*tris)[i].v[0];
-        int b = (*tris)[i].v[1];
-        int c = (*tris)[i].v[2];
-        edges->push_back(Voxel(std::min(a, b), std::max(a, b), i));
-        edges->push_back(Voxel(std::min(b, c), std::max(b, c), i));
-        edges->push_back(Voxel(std::min(c, a), std::max(c, a), i));
+        for(int k = 0; k < 3; ++k)
+        {
+            const int a = std::min((*tris)[i].v[k], (*tris)[i].v[(k + 1) % 3]);
+            #pragma omp atomic
+            ++trisEdgesOffsets[a + 1];
+        }
     }
+    std::partial_sum(trisEdgesOffsets.begin(), trisEdgesOffsets.end(), trisEdgesOffsets.begin());
 
-    qsort(&(*edges)[0], edges->size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
-
-    StaticVector<StaticVector<int>*>* _edgesNeighTris = new StaticVector<StaticVector<int>*>();
-    StaticVector<Pixel>* _edgesPointsPairs = new StaticVector<Pixel>();
-
-    _edgesNeighTris->reserve(tris->size() * 3);
-    _edgesPointsPairs->reserve(tris->size() * 3);
-    // remove duplicities
-    int i0 = 0;
-    long t1 = mvsUtils::initEstimate();
-    for(int i = 0; i < edges->size(); i++)
+    std::vector<std::uint64_t> trisEdges(trisEdgesOffsets.back());
     {
-        if((i == edges->size() - 1) || ((*edges)[i].x != (*edges)[i + 1].x))
+        std::vector<int> positions(trisEdgesOffsets.begin(), trisEdgesOffsets.end() - 1);
+
+        #pragma omp parallel for
+        for(int i = 0; i < tris->size(); ++i)
         {
-            StaticVector<Voxel>* edges1 = new StaticVector<Voxel>();
-            edges1->reserve(i - i0 + 1);
-            for(int j = i0; j <= i; j++)
+            for(int k = 0; k < 3; ++k)
             {
-                edges1->push_back((*edges)[j]);
+                const int a = std::min((*tris)[i].v[k], (*tris)[i].v[(k + 1) % 3]);
+                const int b = std::max((*tris)[i].v[k], (*tris)[i].v[(k + 1) % 3]);
+                int position;
+                #pragma omp atomic capture
+                position = positions[a]++;
+                trisEdges[position] = (static_cast<std::uint64_t>(b) << 32) | static_cast<std::uint32_t>(i);
             }
-            qsort(&(*edges1)[0], edges1->size(), sizeof(Voxel), qSortCompareVoxelByYAsc);
+        }
+    }
 
-            int j0 = 0;
-            for(int j = 0; j < edges1->size(); j++)
+    // sort the edges of each vertex by (largest vertex index, triangle index) and count the unique edges
+    std::vector<int> edgesOffsets(nbPts + 1, 0);
+
+    #pragma omp parallel for
+    for(int a = 0; a < nbPts; ++a)
+    {
+        const auto first = trisEdges.begin() + trisEdgesOffsets[a];
+        const auto last = trisEdges.begin() + trisEdgesOffsets[a + 1];
+        std::sort(first, last);
+
+        int nbEdges = 0;
+        for(auto it = first; it != last; ++it)
+            nbEdges += static_cast<int>((it == first) || (((*it) >> 32) != ((*(it - 1)) >> 32)));
+        edgesOffsets[a + 1] = nbEdges;
+    }
+    std::partial_sum(edgesOffsets.begin(), edgesOffsets.end(), edgesOffsets.begin());
+
+    // edges vertices and number of neighbor triangles
+    const int nbEdges = edgesOffsets.back();
+    std::vector<int> nbEdgesNeighTris(nbEdges, 0);
+    edgesPointsPairs.resize(nbEdges);
+
+    #pragma omp parallel for
+    for(int a = 0; a < nbPts; ++a)
+    {
+        int edgeId = edgesOffsets[a] - 1;
+        for(int i = trisEdgesOffsets[a]; i < trisEdgesOffsets[a + 1]; ++i)
+        {
+            const int b = static_cast<int>(trisEdges[i] >> 32);
+            if((i == trisEdgesOffsets[a]) || (b != static_cast<int>(trisEdges[i - 1] >> 32)))
             {
-                if((j == edges1->size() - 1) || ((*edges1)[j].y != (*edges1)[j + 1].y))
-                {
-                    _edgesPointsPairs->push_back(Pixel((*edges1)[j].x, (*edges1)[j].y));
-                    StaticVector<int>* neighTris = new StaticVector<int>();
-                    neighTris->reserve(j - j0 + 1);
-                    for(int k = j0; k <= j; k++)
-                    {
-                        neighTris->push_back((*edges1)[k].z);
-                    }
-                    _edgesNeighTris->push_back(neighTris);
-                    j0 = j + 1;
-                }
+                ++edgeId;
+                edgesPointsPairs[edgeId] = Pixel(a, b);
             }
-
-            delete edges1;
-            i0 = i + 1;
+            ++nbEdgesNeighTris[edgeId];
         }
-
-        mvsUtils::printfEstimate(i, edges->size(), t1);
     }
-    mvsUtils::finishEstimate();
 
-    (*edgesNeighTris) = _edgesNeighTris;
-    (*edgesPointsPairs) = _edgesPointsPairs;
+    // the sorted keys are grouped by edge: the neighbor triangles are their low bits
+    edgesNeighTris.resize(nbEdgesNeighTris);
+    std::vector<int>& neighTris = edgesNeighTris.values();
 
-    delete edges;
+    #pragma omp parallel for
+    for(int i = 0; i < edgesNeighTris.nbValues(); ++i)
+        neighTris[i] = static_cast<int>(trisEdges[i] & 0xFFFFFFFF);
 }
 
-StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVector<int>*>* ptsNeighPts,
-                                                             double maximalNeighDist)
+StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(const Adjacency& ptsNeighPts, double maximalNeighDist) const
 {
     StaticVector<Point3d>* nms = new StaticVector<Point3d>();
-    nms->reserve(pts->size());
+    nms->resize(pts->size());
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
         Point3d p = (*pts)[i];
-        StaticVector<int>* nei = (*ptsNeighPts)[i];
-        int nneighs = 0;
-        if(nei != nullptr)
-        {
-            nneighs = nei->size();
-        }
+        const int* nei = ptsNeighPts.begin(i);
+        const int nneighs = ptsNeighPts.size(i);
 
         if(nneighs == 0)
         {
-            nms->push_back(Point3d(0.0, 0.0, 0.0));
+            (*nms)[i] = Point3d(0.0, 0.0, 0.0);
         }
         else
         {
@@ -1256,8 +1301,8 @@ StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVec
             Point3d n = Point3d(0.0, 0.0, 0.0);
             for(int j = 0; j < nneighs; j++)
             {
-                n = n + (*pts)[(*nei)[j]];
-                maxNeighDist = std::max(maxNeighDist, (p - (*pts)[(*nei)[j]]).size());
+                n = n + (*pts)[nei[j]];
+                maxNeighDist = std::max(maxNeighDist, (p - (*pts)[nei[j]]).size());
             }
             n = ((n / (float)nneighs) - p);
 
@@ -1285,7 +1330,7 @@ StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVec
                 n = Point3d(0.0, 0.0, 0.0);
             }
 
-            nms->push_back(n);
+            (*nms)[i] = n;
         }
     }
 
@@ -1294,12 +1339,12 @@ StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVec
 
 void Mesh::laplacianSmoothPts(float maximalNeighDist)
 {
-    StaticVector<StaticVector<int>*>* ptsNei = getPtsNeighPtsOrdered();
-    laplacianSmoothPts(ptsNei, maximalNeighDist);
-    deleteArrayOfArrays<int>(&ptsNei);
+    Adjacency ptsNeighPts;
+    getPtsNeighPtsOrdered(ptsNeighPts);
+    laplacianSmoothPts(ptsNeighPts, maximalNeighDist);
 }
 
-void Mesh::laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, double maximalNeighDist)
+void Mesh::laplacianSmoothPts(const Adjacency& ptsNeighPts, double maximalNeighDist)
 {
     StaticVector<Point3d>* nms = getLaplacianSmoothingVectors(ptsNeighPts, maximalNeighDist);
 
@@ -1312,7 +1357,7 @@ void Mesh::laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, dou
     delete nms;
 }
 
-Point3d Mesh::computeTriangleNormal(int idTri)
+Point3d Mesh::computeTriangleNormal(int idTri) const
 {
     return cross(((*pts)[(*tris)[idTri].v[1]] - (*pts)[(*tris)[idTri].v[0]]).normalize(),
                  ((*pts)[(*tris)[idTri].v[2]] - (*pts)[(*tris)[idTri].v[0]]).normalize())
@@ -1331,30 +1376,30 @@ double Mesh::computeTriangleMaxEdgeLength(int idTri) const
                     ((*pts)[(*tris)[idTri].v[2]] - (*pts)[(*tris)[idTri].v[0]]).size());
 }
 
-StaticVector<Point3d>* Mesh::computeNormalsForPts()
+StaticVector<Point3d>* Mesh::computeNormalsForPts() const
 {
-    StaticVector<StaticVector<int>*>* ptsNeighTris = getPtsNeighborTriangles();
-    StaticVector<Point3d>* nms = computeNormalsForPts(ptsNeighTris);
-    deleteArrayOfArrays<int>(&ptsNeighTris);
-    return nms;
+    Adjacency ptsNeighTris;
+    getPtsNeighborTriangles(ptsNeighTris);
+    return computeNormalsForPts(ptsNeighTris);
 }
 
-StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>*>* ptsNeighTris)
+StaticVector<Point3d>* Mesh::computeNormalsForPts(const Adjacency& ptsNeighTris) const
 {
     StaticVector<Point3d>* nms = new StaticVector<Point3d>();
     nms->reserve(pts->size());
     nms->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.0f));
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
-        StaticVector<int>* triTmp = (*ptsNeighTris)[i];
-        if((triTmp != nullptr) && (triTmp->size() > 0))
+        const int* triTmp = ptsNeighTris.begin(i);
+        if(ptsNeighTris.size(i) > 0)
         {
             Point3d n = Point3d(0.0f, 0.0f, 0.0f);
             float nn = 0.0f;
-            for(int j = 0; j < triTmp->size(); j++)
+            for(int j = 0; j < ptsNeighTris.size(i); j++)
             {
-                Point3d n1 = computeTriangleNormal((*triTmp)[j]);
+                Point3d n1 = computeTriangleNormal(triTmp[j]);
                 n1 = n1.normalize();
                 if(std::isnan(n1.x) || std::isnan(n1.y) || std::isnan(n1.z) || (n1.x != n1.x) || (n1.y != n1.y) ||
                    (n1.z != n1.z)) // check if is not NaN
@@ -1363,7 +1408,7 @@ StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>
                 }
                 else
                 {
-                    n = n + computeTriangleNormal((*triTmp)[j]);
+                    n = n + computeTriangleNormal(triTmp[j]);
                     nn += 1.0f;
                 }
             }
@@ -1383,22 +1428,23 @@ StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>
     return nms;
 }
 
-void Mesh::smoothNormals(StaticVector<Point3d>* nms, StaticVector<StaticVector<int>*>* ptsNeighPts)
+void Mesh::smoothNormals(StaticVector<Point3d>* nms, const Adjacency& ptsNeighPts) const
 {
     StaticVector<Point3d>* nmss = new StaticVector<Point3d>();
     nmss->reserve(pts->size());
     nmss->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.0f));
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
         Point3d n = (*nms)[i];
-        for(int j = 0; j < sizeOfStaticVector<int>((*ptsNeighPts)[i]); j++)
+        for(int j = 0; j < ptsNeighPts.size(i); j++)
         {
-            n = n + (*nms)[(*(*ptsNeighPts)[i])[j]];
+            n = n + (*nms)[ptsNeighPts(i, j)];
         }
-        if(sizeOfStaticVector<int>((*ptsNeighPts)[i]) > 0)
+        if(ptsNeighPts.size(i) > 0)
         {
-            n = n / (float)sizeOfStaticVector<int>((*ptsNeighPts)[i]);
+            n = n / (float)ptsNeighPts.size(i);
         }
         n = n.normalize();
         if(std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (n.x != n.x) || (n.y != n.y) || (n.z != n.z))
@@ -1466,17 +1512,17 @@ double Mesh::computeTriangleArea(int idTri)
     return sqrt(p * (p - a) * (p - b) * (p - c));
 }
 
-StaticVector<Voxel>* Mesh::getTrianglesEdgesIds(StaticVector<StaticVector<int>*>* edgesNeighTris)
+StaticVector<Voxel>* Mesh::getTrianglesEdgesIds(const Adjacency& edgesNeighTris) const
 {
     StaticVector<Voxel>* out = new StaticVector<Voxel>();
     out->reserve(tris->size());
     out->resize_with(tris->size(), Voxel(-1, -1, -1));
 
-    for(int i = 0; i < edgesNeighTris->size(); i++)
+    for(int i = 0; i < edgesNeighTris.size(); i++)
     {
-        for(int j = 0; j < (*edgesNeighTris)[i]->size(); j++)
+        for(int j = 0; j < edgesNeighTris.size(i); j++)
         {
-            int idTri = (*(*edgesNeighTris)[i])[j];
+            int idTri = edgesNeighTris(i, j);
 
             if((*out)[idTri].x == -1)
             {
@@ -1624,9 +1670,9 @@ void Mesh::subdivideMeshCase3(int i, StaticVector<Pixel>* edgesi, Pixel& neptIdE
     }
 }
 
-void Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, std::string tmpDir, int maxMeshPts)
+void Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, int scale, int maxMeshPts)
 {
-    StaticVector<StaticVector<int>*>* trisCams = computeTrisCams(mp, tmpDir);
+    StaticVector<StaticVector<int>*>* trisCams = computeTrisCamsFromRasterization(mp, scale);
     StaticVector<StaticVector<int>*>* trisCams1 = subdivideMesh(mp, maxTriArea, 0.0f, true, trisCams, maxMeshPts);
     deleteArrayOfArrays<int>(&trisCams);
     deleteArrayOfArrays<int>(&trisCams1);
@@ -1779,9 +1825,9 @@ int Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, f
                            StaticVector<int>** trisCamsId)
 {
 
-    StaticVector<StaticVector<int>*>* edgesNeighTris;
-    StaticVector<Pixel>* edgesPointsPairs;
-    getNotOrientedEdges(&edgesNeighTris, &edgesPointsPairs);
+    Adjacency edgesNeighTris;
+    StaticVector<Pixel> edgesPointsPairs;
+    getNotOrientedEdges(edgesNeighTris, edgesPointsPairs);
     StaticVector<Voxel>* trisEdges = getTrianglesEdgesIds(edgesNeighTris);
 
     // which triangles should be subdivided
@@ -1821,13 +1867,13 @@ int Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, f
 
     // which edges are going to be subdivided
     StaticVector<int>* edgesToSubdivide = new StaticVector<int>();
-    edgesToSubdivide->reserve(edgesNeighTris->size());
-    for(int i = 0; i < edgesNeighTris->size(); i++)
+    edgesToSubdivide->reserve(edgesNeighTris.size());
+    for(int i = 0; i < edgesNeighTris.size(); i++)
     {
         bool hasNeigTriToSubdivide = false;
-        for(int j = 0; j < (*edgesNeighTris)[i]->size(); j++)
+        for(int j = 0; j < edgesNeighTris.size(i); j++)
         {
-            int idTri = (*(*edgesNeighTris)[i])[j];
+            int idTri = edgesNeighTris(i, j);
             if((*trisToSubdivide)[idTri])
             {
                 hasNeigTriToSubdivide = true;
@@ -1861,7 +1907,7 @@ int Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, f
     {
         if((*edgesToSubdivide)[i] > -1)
         {
-            Point3d p = ((*pts)[(*edgesPointsPairs)[i].x] + (*pts)[(*edgesPointsPairs)[i].y]) / 2.0f;
+            Point3d p = ((*pts)[edgesPointsPairs[i].x] + (*pts)[edgesPointsPairs[i].y]) / 2.0f;
             pts1->push_back(p);
         }
     }
@@ -1913,7 +1959,7 @@ int Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, f
 
             if(n == 1)
             {
-                subdivideMeshCase1(i, edgesPointsPairs, newPtsIds[0], tris1);
+                subdivideMeshCase1(i, &edgesPointsPairs, newPtsIds[0], tris1);
 
                 trisCamsId1->push_back((*(*trisCamsId))[i]);
                 trisCamsId1->push_back((*(*trisCamsId))[i]);
@@ -1921,8 +1967,8 @@ int Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, f
 
             if(n == 2)
             {
-                subdivideMeshCase2(i, edgesPointsPairs, newPtsIds[0], newPtsIds[1], tris1);
-                subdivideMeshCase2(i, edgesPointsPairs, newPtsIds[1], newPtsIds[0], tris1);
+                subdivideMeshCase2(i, &edgesPointsPairs, newPtsIds[0], newPtsIds[1], tris1);
+                subdivideMeshCase2(i, &edgesPointsPairs, newPtsIds[1], newPtsIds[0], tris1);
 
                 trisCamsId1->push_back((*(*trisCamsId))[i]);
                 trisCamsId1->push_back((*(*trisCamsId))[i]);
@@ -1931,12 +1977,12 @@ int Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, f
 
             if(n == 3)
             {
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[0], newPtsIds[1], newPtsIds[2], tris1);
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[0], newPtsIds[2], newPtsIds[1], tris1);
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[1], newPtsIds[0], newPtsIds[2], tris1);
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[1], newPtsIds[2], newPtsIds[0], tris1);
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[2], newPtsIds[0], newPtsIds[1], tris1);
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[2], newPtsIds[1], newPtsIds[0], tris1);
+                subdivideMeshCase3(i, &edgesPointsPairs, newPtsIds[0], newPtsIds[1], newPtsIds[2], tris1);
+                subdivideMeshCase3(i, &edgesPointsPairs, newPtsIds[0], newPtsIds[2], newPtsIds[1], tris1);
+                subdivideMeshCase3(i, &edgesPointsPairs, newPtsIds[1], newPtsIds[0], newPtsIds[2], tris1);
+                subdivideMeshCase3(i, &edgesPointsPairs, newPtsIds[1], newPtsIds[2], newPtsIds[0], tris1);
+                subdivideMeshCase3(i, &edgesPointsPairs, newPtsIds[2], newPtsIds[0], newPtsIds[1], tris1);
+                subdivideMeshCase3(i, &edgesPointsPairs, newPtsIds[2], newPtsIds[1], newPtsIds[0], tris1);
 
                 trisCamsId1->push_back((*(*trisCamsId))[i]);
                 trisCamsId1->push_back((*(*trisCamsId))[i]);
@@ -1959,8 +2005,6 @@ int Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, f
     delete(*trisCamsId);
     (*trisCamsId) = trisCamsId1;
 
-    deleteArrayOfArrays<int>(&edgesNeighTris);
-    delete edgesPointsPairs;
     delete trisEdges;
     delete trisToSubdivide;
     delete edgesToSubdivide;
@@ -2001,66 +2045,51 @@ void Mesh::letJustTringlesIdsInMesh(StaticVector<int>* trisIdsToStay)
     tris = trisTmp;
 }
 
-StaticVector<StaticVector<int>*>* Mesh::computeTrisCams(const mvsUtils::MultiViewParams* mp, std::string tmpDir)
+StaticVector<StaticVector<int>*>* Mesh::computeTrisCamsFromRasterization(const mvsUtils::MultiViewParams* mp, int scale) const
 {
     if(mp->verbose)
-        ALICEVISION_LOG_DEBUG("Computing tris cams.");
+        ALICEVISION_LOG_DEBUG("Computing tris cams from the rasterization of the mesh.");
 
-    StaticVector<int>* ntrisCams = new StaticVector<int>();
-    ntrisCams->reserve(tris->size());
-    ntrisCams->resize_with(tris->size(), 0);
+    // visible triangles of each camera, each rasterization being parallel
+    std::vector<StaticVector<int>*> visTrisPerCam(mp->ncams, nullptr);
 
     long t1 = mvsUtils::initEstimate();
     for(int rc = 0; rc < mp->ncams; ++rc)
     {
-        std::string visTrisFileName = tmpDir + "visTris" + std::to_string(mp->getViewId(rc)) + ".bin";
-        StaticVector<int>* visTris = loadArrayFromFile<int>(visTrisFileName);
-        if(visTris != nullptr)
-        {
-            for(int i = 0; i < visTris->size(); ++i)
-            {
-                int idTri = (*visTris)[i];
-                (*ntrisCams)[idTri]++;
-            }
-            delete visTris;
-        }
+        visTrisPerCam[rc] = getVisibleTrianglesIndexes(mp, rc, mp->getWidth(rc) / scale, mp->getHeight(rc) / scale);
         mvsUtils::printfEstimate(rc, mp->ncams, t1);
     }
     mvsUtils::finishEstimate();
 
+    StaticVector<int> ntrisCams;
+    ntrisCams.resize_with(tris->size(), 0);
+    for(const StaticVector<int>* visTris : visTrisPerCam)
+    {
+        for(int i = 0; i < visTris->size(); ++i)
+            ++ntrisCams[(*visTris)[i]];
+    }
+
     StaticVector<StaticVector<int>*>* trisCams = new StaticVector<StaticVector<int>*>();
     trisCams->reserve(tris->size());
-
     for(int i = 0; i < tris->size(); ++i)
     {
         StaticVector<int>* cams = nullptr;
-        if((*ntrisCams)[i] > 0)
+        if(ntrisCams[i] > 0)
         {
             cams = new StaticVector<int>();
-            cams->reserve((*ntrisCams)[i]);
+            cams->reserve(ntrisCams[i]);
         }
         trisCams->push_back(cams);
     }
 
-    t1 = mvsUtils::initEstimate();
     for(int rc = 0; rc < mp->ncams; ++rc)
     {
-        std::string visTrisFileName = tmpDir + "visTris" + std::to_string(mp->getViewId(rc)) + ".bin";
-        StaticVector<int>* visTris = loadArrayFromFile<int>(visTrisFileName);
-        if(visTris != nullptr)
-        {
-            for(int i = 0; i < visTris->size(); ++i)
-            {
-                int idTri = (*visTris)[i];
-                (*trisCams)[idTri]->push_back(rc);
-            }
-            delete visTris;
-        }
-        mvsUtils::printfEstimate(rc, mp->ncams, t1);
+        const StaticVector<int>* visTris = visTrisPerCam[rc];
+        for(int i = 0; i < visTris->size(); ++i)
+            (*trisCams)[(*visTris)[i]]->push_back(rc);
+        delete visTris;
     }
-    mvsUtils::finishEstimate();
 
-    delete ntrisCams;
     return trisCams;
 }
 
@@ -2355,7 +2384,8 @@ bool Mesh::isTriangleObtuse(int triId)
 
 StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds()
 {
-    StaticVector<StaticVector<int>*>* ptsNeighPtsOrdered = getPtsNeighPtsOrdered();
+    Adjacency ptsNeighPtsOrdered;
+    getPtsNeighPtsOrdered(ptsNeighPtsOrdered);
 
     StaticVector<int>* colors = new StaticVector<int>();
     colors->reserve(pts->size());
@@ -2387,13 +2417,12 @@ StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds()
                 {
                     delete colors;
                     delete buff;
-                    deleteArrayOfArrays<int>(&ptsNeighPtsOrdered);
                     throw std::runtime_error("getLargestConnectedComponentTrisIds: bad condition.");
                 }
             }
-            for(int j = 0; j < sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[ptid]); ++j)
+            for(int j = 0; j < ptsNeighPtsOrdered.size(ptid); ++j)
             {
-                int nptid = (*(*ptsNeighPtsOrdered)[ptid])[j];
+                int nptid = ptsNeighPtsOrdered(ptid, j);
                 if((nptid > -1) && ((*colors)[nptid] == -1))
                 {
                     if(buff->size() >= buff->capacity()) // should not happen but no problem
@@ -2429,7 +2458,6 @@ StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds()
 
     delete colors;
     delete buff;
-    deleteArrayOfArrays<int>(&ptsNeighPtsOrdered);
 
     return out;
 }
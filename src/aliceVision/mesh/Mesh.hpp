@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <aliceVision/mesh/Adjacency.hpp>
 #include <aliceVision/mvsData/Matrix3x3.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
@@ -123,13 +124,48 @@ public:
     StaticVector<StaticVector<int>*>* getTrisMap(const mvsUtils::MultiViewParams* mp, int rc, int scale, int w, int h);
     StaticVector<StaticVector<int>*>* getTrisMap(StaticVector<int>* visTris, const mvsUtils::MultiViewParams* mp, int rc, int scale,
                                                  int w, int h);
-    void getDepthMap(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int scale, int w, int h);
+
+    /**
+     * @brief Get the depth map of the mesh in a camera, rasterized with a z-buffer (see rasterizeMesh).
+     * @param[out] depthMap the distance to the camera center of the nearest surface point in each pixel (x * h + y), -1 if none
+     * @param[in] mp the multi-view parameters
+     * @param[in] rc the camera index
+     * @param[in] w the depth map width (the camera image is resized to w x h)
+     * @param[in] h the depth map height
+     */
+    void getDepthMap(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int w, int h) const;
     void getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<int>*>* tmp, const mvsUtils::MultiViewParams* mp, int rc,
                      int scale, int w, int h);
 
-    StaticVector<StaticVector<int>*>* getPtsNeighborTriangles();
-    StaticVector<StaticVector<int>*>* getPtsNeighPtsOrdered();
-
+    /**
+     * @brief Get the neighbor triangles of each vertex, sorted by index.
+     * @param[out] out_ptsNeighTris the neighbor triangles of each vertex
+     */
+    void getPtsNeighborTriangles(Adjacency& out_ptsNeighTris) const;
+
+    /**
+     * @brief Get the neighbor vertices of each vertex, ordered around the vertex.
+     * @param[out] out_ptsNeighPts the neighbor vertices of each vertex
+     */
+    void getPtsNeighPtsOrdered(Adjacency& out_ptsNeighPts) const;
+
+    /**
+     * @brief Get the neighbor vertices of each vertex, ordered around the vertex.
+     *        The neighbors of a boundary vertex go from one boundary edge to the other.
+     * @param[in] ptsNeighTris the neighbor triangles of each vertex
+     * @param[out] out_ptsNeighPts the neighbor vertices of each vertex
+     */
+    void getPtsNeighPtsOrdered(const Adjacency& ptsNeighTris, Adjacency& out_ptsNeighPts) const;
+
+    /**
+     * @brief Get the triangles visible in a camera: the nearest triangles of the pixels in the rasterized mesh.
+     * @param[in] mp the multi-view parameters
+     * @param[in] rc the camera index
+     * @param[in] w the rasterization width
+     * @param[in] h the rasterization height
+     * @return the sorted indexes of the visible triangles
+     */
+    StaticVector<int>* getVisibleTrianglesIndexes(const mvsUtils::MultiViewParams* mp, int rc, int w, int h) const;
     StaticVector<int>* getVisibleTrianglesIndexes(std::string tmpDir, const mvsUtils::MultiViewParams* mp, int rc, int w, int h);
     StaticVector<int>* getVisibleTrianglesIndexes(std::string depthMapFileName, std::string trisMapFileName,
                                                   const mvsUtils::MultiViewParams* mp, int rc, int w, int h);
@@ -141,17 +177,21 @@ public:
 
     Mesh* generateMeshFromTrianglesSubset(const StaticVector<int> &visTris, StaticVector<int>** out_ptIdToNewPtId) const;
 
-    void getNotOrientedEdges(StaticVector<StaticVector<int>*>** edgesNeighTris, StaticVector<Pixel>** edgesPointsPairs);
-    StaticVector<Voxel>* getTrianglesEdgesIds(StaticVector<StaticVector<int>*>* edgesNeighTris);
+    /**
+     * @brief Get the edges of the mesh, sorted by vertex indexes.
+     * @param[out] edgesNeighTris the neighbor triangles of each edge, sorted by index
+     * @param[out] edgesPointsPairs the vertices of each edge (smallest index first)
+     */
+    void getNotOrientedEdges(Adjacency& edgesNeighTris, StaticVector<Pixel>& edgesPointsPairs) const;
+    StaticVector<Voxel>* getTrianglesEdgesIds(const Adjacency& edgesNeighTris) const;
 
-    StaticVector<Point3d>* getLaplacianSmoothingVectors(StaticVector<StaticVector<int>*>* ptsNeighPts,
-                                                        double maximalNeighDist = -1.0f);
+    StaticVector<Point3d>* getLaplacianSmoothingVectors(const Adjacency& ptsNeighPts, double maximalNeighDist = -1.0f) const;
     void laplacianSmoothPts(float maximalNeighDist = -1.0f);
-    void laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, double maximalNeighDist = -1.0f);
-    StaticVector<Point3d>* computeNormalsForPts();
-    StaticVector<Point3d>* computeNormalsForPts(StaticVector<StaticVector<int>*>* ptsNeighTris);
-    void smoothNormals(StaticVector<Point3d>* nms, StaticVector<StaticVector<int>*>* ptsNeighPts);
-    Point3d computeTriangleNormal(int idTri);
+    void laplacianSmoothPts(const Adjacency& ptsNeighPts, double maximalNeighDist = -1.0f);
+    StaticVector<Point3d>* computeNormalsForPts() const;
+    StaticVector<Point3d>* computeNormalsForPts(const Adjacency& ptsNeighTris) const;
+    void smoothNormals(StaticVector<Point3d>* nms, const Adjacency& ptsNeighPts) const;
+    Point3d computeTriangleNormal(int idTri) const;
     Point3d computeTriangleCenterOfGravity(int idTri) const;
     double computeTriangleMaxEdgeLength(int idTri) const;
 
@@ -179,7 +219,15 @@ public:
 
     Point2d getTrianglePixelInternalPoint(Mesh::triangle_proj* tp, Mesh::rectangle* re);
 
-    void subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, std::string tmpDir, int maxMeshPts);
+    /**
+     * @brief Subdivide the triangles larger than maxTriArea, the cameras of each triangle are computed
+     *        from the rasterization of the mesh in each camera (see computeTrisCamsFromRasterization).
+     * @param[in] mp the multi-view parameters
+     * @param[in] maxTriArea the maximum area of the triangles
+     * @param[in] scale the downscale factor of the rasterization
+     * @param[in] maxMeshPts the maximum number of points of the subdivided mesh
+     */
+    void subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, int scale, int maxMeshPts);
     void subdivideMeshMaxEdgeLengthUpdatePtsCams(const mvsUtils::MultiViewParams* mp, float maxEdgeLength,
                                                  StaticVector<StaticVector<int>*>* ptsCams, int maxMeshPts);
     StaticVector<StaticVector<int>*>* subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, float maxEdgeLength,
@@ -194,7 +242,13 @@ public:
     void subdivideMeshCase3(int i, StaticVector<Pixel>* edgesi, Pixel& neptIdEdgeId1, Pixel& neptIdEdgeId2,
                             Pixel& neptIdEdgeId3, StaticVector<Mesh::triangle>* tris1);
 
-    StaticVector<StaticVector<int>*>* computeTrisCams(const mvsUtils::MultiViewParams* mp, std::string tmpDir);
+    /**
+     * @brief Compute the cameras seeing each triangle, from the rasterization of the mesh in each camera.
+     * @param[in] mp the multi-view parameters
+     * @param[in] scale the downscale factor of the rasterization
+     * @return the cameras of each triangle (nullptr if none)
+     */
+    StaticVector<StaticVector<int>*>* computeTrisCamsFromRasterization(const mvsUtils::MultiViewParams* mp, int scale) const;
     StaticVector<StaticVector<int>*>* computeTrisCamsFromPtsCams(StaticVector<StaticVector<int>*>* ptsCams) const;
 
     void initFromDepthMap(const mvsUtils::MultiViewParams* mp, float* depthMap, int rc, int scale, int step, float alpha);
@@ -69,57 +69,53 @@ int MeshAnalyze::getVertexIdInTriangleForPtId(int ptId, int triId)
     return -1;
 }
 
-bool MeshAnalyze::getVertexSurfaceNormal(int ptId, Point3d& N)
+bool MeshAnalyze::getVertexSurfaceNormal(int ptId, const Adjacency& ptsNeighTris, Point3d& N)
 {
-    StaticVector<int>* ptNeighPtsOrdered = (*ptsNeighPtsOrdered)[ptId];
-    StaticVector<int>* ptNeighTris = (*ptsNeighTrisSortedAsc)[ptId];
-    if((isIsBoundaryPt(ptId)) || (ptNeighPtsOrdered == nullptr) || (ptNeighTris == nullptr) ||
-       (ptNeighTris->size() == 0))
+    if((isIsBoundaryPt(ptId)) || (ptsNeighTris.size(ptId) == 0))
     {
         return false;
     }
 
     N = Point3d();
-    for(int i = 0; i < ptNeighTris->size(); i++)
+    for(int i = 0; i < ptsNeighTris.size(ptId); i++)
     {
-        int triId = (*ptNeighTris)[i];
+        int triId = ptsNeighTris(ptId, i);
         N = N + computeTriangleNormal(triId);
     }
-    N = N / (float)ptNeighTris->size();
+    N = N / (float)ptsNeighTris.size(ptId);
 
     return true;
 }
 
 // gts_vertex_mean_curvature_normal [Meyer et al 2002]
-bool MeshAnalyze::getVertexMeanCurvatureNormal(int ptId, Point3d& Kh)
+bool MeshAnalyze::getVertexMeanCurvatureNormal(int ptId, const Adjacency& ptsNeighTris, const Adjacency& ptsNeighPts, Point3d& Kh)
 {
-    StaticVector<int>* ptNeighPtsOrdered = (*ptsNeighPtsOrdered)[ptId];
-    StaticVector<int>* ptNeighTris = (*ptsNeighTrisSortedAsc)[ptId];
-    if((isIsBoundaryPt(ptId)) || (ptNeighPtsOrdered == nullptr) || (ptNeighTris == nullptr))
+    const int nbNeighPts = ptsNeighPts.size(ptId);
+    if((isIsBoundaryPt(ptId)) || (nbNeighPts == 0) || (ptsNeighTris.size(ptId) == 0))
     {
         return false;
     }
 
     double area = 0.0;
-    for(int i = 0; i < ptNeighTris->size(); i++)
+    for(int i = 0; i < ptsNeighTris.size(ptId); i++)
     {
-        int triId = (*ptNeighTris)[i];
+        int triId = ptsNeighTris(ptId, i);
         int vertexIdInTriangle = getVertexIdInTriangleForPtId(ptId, triId);
         area += getRegionArea(vertexIdInTriangle, triId);
     }
 
     Kh = Point3d(0.0f, 0.0f, 0.0f);
 
-    for(int i = 0; i < ptNeighPtsOrdered->size(); i++)
+    for(int i = 0; i < nbNeighPts; i++)
     {
         int ip1 = i + 1;
-        if(ip1 >= ptNeighPtsOrdered->size())
+        if(ip1 >= nbNeighPts)
         {
             ip1 = 0;
         }
         Point3d v = (*pts)[ptId];
-        Point3d v1 = (*pts)[(*ptNeighPtsOrdered)[i]];
-        Point3d v2 = (*pts)[(*ptNeighPtsOrdered)[ip1]];
+        Point3d v1 = (*pts)[ptsNeighPts(ptId, i)];
+        Point3d v2 = (*pts)[ptsNeighPts(ptId, ip1)];
 
         float temp = getCotanOfAngle(v1, v, v2);
         Kh = Kh + (v2 - v) * temp;
@@ -151,18 +147,17 @@ void MeshAnalyze::getVertexPrincipalCurvatures(double Kh, double Kg, double& K1,
     K2 = Kh - temp;
 }
 
-bool MeshAnalyze::applyLaplacianOperator(int ptId, StaticVector<Point3d>* ptsToApplyLaplacianOp, Point3d& ln)
+bool MeshAnalyze::applyLaplacianOperator(int ptId, const Adjacency& ptsNeighPts, StaticVector<Point3d>* ptsToApplyLaplacianOp, Point3d& ln)
 {
-    StaticVector<int>* ptNeighPtsOrdered = (*ptsNeighPtsOrdered)[ptId];
-    if(ptNeighPtsOrdered == nullptr)
+    if(ptsNeighPts.size(ptId) == 0)
     {
         return false;
     }
 
     ln = Point3d(0.0f, 0.0f, 0.0f);
-    for(int i = 0; i < ptNeighPtsOrdered->size(); i++)
+    for(int i = 0; i < ptsNeighPts.size(ptId); i++)
     {
-        Point3d npt = (*ptsToApplyLaplacianOp)[(*ptNeighPtsOrdered)[i]];
+        Point3d npt = (*ptsToApplyLaplacianOp)[ptsNeighPts(ptId, i)];
 
         if((npt.x == 0.0f) && (npt.y == 0.0f) && (npt.z == 0.0f))
         {
@@ -171,7 +166,7 @@ bool MeshAnalyze::applyLaplacianOperator(int ptId, StaticVector<Point3d>* ptsToA
         }
         ln = ln + npt;
     }
-    ln = (ln / (float)ptNeighPtsOrdered->size()) - (*ptsToApplyLaplacianOp)[ptId];
+    ln = (ln / (float)ptsNeighPts.size(ptId)) - (*ptsToApplyLaplacianOp)[ptId];
 
     Point3d n = ln;
     float d = n.size();
@@ -195,35 +190,28 @@ bool MeshAnalyze::applyLaplacianOperator(int ptId, StaticVector<Point3d>* ptsToA
 
 // othake et al 00 Polyhedral Surface Smoothing with Simultaneous Mesh Regularization
 // page 3 eq (3)
-bool MeshAnalyze::getLaplacianSmoothingVector(int ptId, Point3d& ln)
+bool MeshAnalyze::getLaplacianSmoothingVector(int ptId, const Adjacency& ptsNeighPts, Point3d& ln)
 {
-    return applyLaplacianOperator(ptId, pts, ln);
+    return applyLaplacianOperator(ptId, ptsNeighPts, pts, ln);
 }
 
 // kobbelt kampagna 98 Interactive Multi-Resolution Modeling on Arbitrary Meshes
 // page 5 - U1 - laplacian is obtained when apply to origina pts , U2 - bi-laplacian is obtained when apply to laplacian
 // pts
-bool MeshAnalyze::getBiLaplacianSmoothingVector(int ptId, StaticVector<Point3d>* ptsLaplacian, Point3d& tp)
+bool MeshAnalyze::getBiLaplacianSmoothingVector(int ptId, const Adjacency& ptsNeighPts, StaticVector<Point3d>* ptsLaplacian, Point3d& tp)
 {
-    if(applyLaplacianOperator(ptId, ptsLaplacian, tp))
+    if(applyLaplacianOperator(ptId, ptsNeighPts, ptsLaplacian, tp))
     {
-        StaticVector<int>* ptNeighPtsOrdered = (*ptsNeighPtsOrdered)[ptId];
-        StaticVector<int>* ptNeighTris = (*ptsNeighTrisSortedAsc)[ptId];
-        if((ptNeighPtsOrdered == nullptr) || (ptNeighTris == nullptr))
-        {
-            return false;
-        }
-
         float sum = 0.0f;
-        for(int i = 0; i < sizeOfStaticVector<int>(ptNeighPtsOrdered); i++)
+        for(int i = 0; i < ptsNeighPts.size(ptId); i++)
         {
-            int neighValence = sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[(*ptNeighPtsOrdered)[i]]);
+            int neighValence = ptsNeighPts.size(ptsNeighPts(ptId, i));
             if(neighValence > 0)
             {
                 sum += 1.0f / (float)neighValence;
             }
         }
-        float v = 1.0f + (1.0f / (float)sizeOfStaticVector<int>(ptNeighPtsOrdered)) * sum;
+        float v = 1.0f + (1.0f / (float)ptsNeighPts.size(ptId)) * sum;
 
         tp = Point3d(0.0f, 0.0f, 0.0f) - tp * (1.0f / v);
 
@@ -245,17 +233,17 @@ bool MeshAnalyze::getBiLaplacianSmoothingVector(int ptId, StaticVector<Point3d>*
 
 // othake et al 00 Polyhedral Surface Smoothing with Simultaneous Mesh Regularization
 // page 6 eq (13)
-bool MeshAnalyze::getMeanCurvAndLaplacianSmoothing(int ptId, Point3d& F, float epsilon)
+bool MeshAnalyze::getMeanCurvAndLaplacianSmoothing(int ptId, const Adjacency& ptsNeighTris, const Adjacency& ptsNeighPts, Point3d& F, float epsilon)
 {
     Point3d Hn;
-    if(!getVertexMeanCurvatureNormal(ptId, Hn))
+    if(!getVertexMeanCurvatureNormal(ptId, ptsNeighTris, ptsNeighPts, Hn))
     {
         return false;
     }
 
     Point3d U0;
 
-    if(!getLaplacianSmoothingVector(ptId, U0))
+    if(!getLaplacianSmoothingVector(ptId, ptsNeighPts, U0))
     {
         return false;
     }
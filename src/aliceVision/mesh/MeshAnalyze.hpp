@@ -23,13 +23,13 @@ public:
     double getCotanOfAngle(Point3d& vo, Point3d& v1, Point3d& v2);
     double getRegionArea(int vertexIdInTriangle, int triId);
     int getVertexIdInTriangleForPtId(int ptId, int triId);
-    bool getVertexMeanCurvatureNormal(int ptId, Point3d& Kh);
+    bool getVertexMeanCurvatureNormal(int ptId, const Adjacency& ptsNeighTris, const Adjacency& ptsNeighPts, Point3d& Kh);
     void getVertexPrincipalCurvatures(double Kh, double Kg, double& K1, double& K2);
-    bool applyLaplacianOperator(int ptId, StaticVector<Point3d>* ptsToApplyLaplacianOp, Point3d& ln);
-    bool getLaplacianSmoothingVector(int ptId, Point3d& ln);
-    bool getBiLaplacianSmoothingVector(int ptId, StaticVector<Point3d>* ptsLaplacian, Point3d& tp);
-    bool getMeanCurvAndLaplacianSmoothing(int ptId, Point3d& F, float epsilon);
-    bool getVertexSurfaceNormal(int ptId, Point3d& N);
+    bool applyLaplacianOperator(int ptId, const Adjacency& ptsNeighPts, StaticVector<Point3d>* ptsToApplyLaplacianOp, Point3d& ln);
+    bool getLaplacianSmoothingVector(int ptId, const Adjacency& ptsNeighPts, Point3d& ln);
+    bool getBiLaplacianSmoothingVector(int ptId, const Adjacency& ptsNeighPts, StaticVector<Point3d>* ptsLaplacian, Point3d& tp);
+    bool getMeanCurvAndLaplacianSmoothing(int ptId, const Adjacency& ptsNeighTris, const Adjacency& ptsNeighPts, Point3d& F, float epsilon);
+    bool getVertexSurfaceNormal(int ptId, const Adjacency& ptsNeighTris, Point3d& N);
 };
 
 } // namespace mesh
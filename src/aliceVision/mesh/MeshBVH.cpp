@@ -0,0 +1,582 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshBVH.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/config.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <xmmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/// number of bins of the surface area heuristic
+const int nbBins = 12;
+/// leaves with more triangles are always split (if their centroids are distinct)
+const int maxLeafSize = 4;
+/// maximal depth of the tree, deeper nodes are leaves
+const int maxDepth = 64;
+/// cost of a node traversal, relative to the cost of a triangle intersection
+const float traversalCost = 1.0f;
+
+struct BBox
+{
+    float min[3];
+    float max[3];
+
+    BBox()
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            min[k] = std::numeric_limits<float>::max();
+            max[k] = -std::numeric_limits<float>::max();
+        }
+    }
+
+    void grow(const float p[3])
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            min[k] = std::min(min[k], p[k]);
+            max[k] = std::max(max[k], p[k]);
+        }
+    }
+
+    void grow(const BBox& other)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            min[k] = std::min(min[k], other.min[k]);
+            max[k] = std::max(max[k], other.max[k]);
+        }
+    }
+
+    float area() const
+    {
+        if(min[0] > max[0])
+            return 0.0f;
+        const float dx = max[0] - min[0];
+        const float dy = max[1] - min[1];
+        const float dz = max[2] - min[2];
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+};
+
+struct BuildPrimitive
+{
+    BBox bounds;
+    float centroid[3];
+    int triId;
+};
+
+/// subtree built by a single thread
+struct SubtreeJob
+{
+    int nodeIndex;
+    int begin;
+    int end;
+    int depth;
+};
+
+inline void cross(const float a[3], const float b[3], float out[3])
+{
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+inline float dot(const float a[3], const float b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+} // namespace
+
+/**
+ * @brief Builder of the tree, on the primitives of the whole mesh.
+ *        The subtrees of disjoint primitive ranges can be built in parallel.
+ */
+class MeshBVH::Builder
+{
+public:
+    explicit Builder(std::vector<BuildPrimitive>& primitives)
+        : _primitives(primitives)
+    {}
+
+    /**
+     * @brief Build the subtree of the primitives [begin, end) at nodes[nodeIndex].
+     * @param[in,out] nodes the tree nodes
+     * @param[in] nodeIndex the subtree root index in nodes
+     * @param[in] begin the first primitive
+     * @param[in] end the end of the primitives
+     * @param[in] depth the depth of the subtree root
+     * @param[in,out] maxDepthReached the maximal depth of the nodes
+     * @param[out] jobs if not nullptr, the subtrees of less than jobSize primitives are not built but added to jobs
+     * @param[in] jobSize the maximal number of primitives of the jobs
+     */
+    void build(std::vector<Node>& nodes, int nodeIndex, int begin, int end, int depth, int& maxDepthReached,
+               std::vector<SubtreeJob>* jobs, int jobSize)
+    {
+        maxDepthReached = std::max(maxDepthReached, depth);
+
+        BBox bounds;
+        for(int i = begin; i < end; ++i)
+            bounds.grow(_primitives[i].bounds);
+
+        for(int k = 0; k < 3; ++k)
+        {
+            nodes[nodeIndex].boundsMin[k] = bounds.min[k];
+            nodes[nodeIndex].boundsMax[k] = bounds.max[k];
+        }
+
+        if(jobs != nullptr && end - begin <= jobSize)
+        {
+            jobs->push_back({nodeIndex, begin, end, depth});
+            return;
+        }
+
+        int middle;
+        if(!split(begin, end, bounds, depth, middle))
+        {
+            nodes[nodeIndex].first = begin;
+            nodes[nodeIndex].nbTriangles = end - begin;
+            return;
+        }
+
+        // the two children are consecutive
+        const int left = static_cast<int>(nodes.size());
+        nodes.resize(left + 2);
+        nodes[nodeIndex].first = left;
+        nodes[nodeIndex].nbTriangles = 0;
+
+        build(nodes, left, begin, middle, depth + 1, maxDepthReached, jobs, jobSize);
+        build(nodes, left + 1, middle, end, depth + 1, maxDepthReached, jobs, jobSize);
+    }
+
+private:
+    /**
+     * @brief Find the best split of the primitives [begin, end) with the surface area heuristic and partition them.
+     * @return false if the node should be a leaf
+     */
+    bool split(int begin, int end, const BBox& bounds, int depth, int& out_middle)
+    {
+        const int nbPrimitives = end - begin;
+        if(nbPrimitives <= 1 || depth >= maxDepth)
+            return false;
+
+        BBox centroidBounds;
+        for(int i = begin; i < end; ++i)
+            centroidBounds.grow(_primitives[i].centroid);
+
+        int axis = 0;
+        for(int k = 1; k < 3; ++k)
+        {
+            if(centroidBounds.max[k] - centroidBounds.min[k] > centroidBounds.max[axis] - centroidBounds.min[axis])
+                axis = k;
+        }
+
+        const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+        if(!(extent > 0.0f))
+        {
+            // identical centroids: split in the middle only to keep small leaves
+            if(nbPrimitives <= maxLeafSize)
+                return false;
+            out_middle = begin + nbPrimitives / 2;
+            return true;
+        }
+
+        // bin the primitives on their centroid
+        const float scale = static_cast<float>(nbBins) * (1.0f - 1e-5f) / extent;
+        const float offset = centroidBounds.min[axis];
+        BBox binBounds[nbBins];
+        int binCounts[nbBins] = {0};
+
+        for(int i = begin; i < end; ++i)
+        {
+            const int bin = std::min(nbBins - 1, static_cast<int>((_primitives[i].centroid[axis] - offset) * scale));
+            binBounds[bin].grow(_primitives[i].bounds);
+            ++binCounts[bin];
+        }
+
+        // cost of each split between bins i and i + 1
+        float rightAreas[nbBins - 1];
+        int rightCounts[nbBins - 1];
+        {
+            BBox rightBounds;
+            int rightCount = 0;
+            for(int i = nbBins - 1; i > 0; --i)
+            {
+                rightBounds.grow(binBounds[i]);
+                rightCount += binCounts[i];
+                rightAreas[i - 1] = rightBounds.area();
+                rightCounts[i - 1] = rightCount;
+            }
+        }
+
+        float bestCost = std::numeric_limits<float>::max();
+        int bestSplit = -1;
+        {
+            BBox leftBounds;
+            int leftCount = 0;
+            for(int i = 0; i < nbBins - 1; ++i)
+            {
+                leftBounds.grow(binBounds[i]);
+                leftCount += binCounts[i];
+                if(leftCount == 0 || rightCounts[i] == 0)
+                    continue;
+                const float cost = leftCount * leftBounds.area() + rightCounts[i] * rightAreas[i];
+                if(cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestSplit = i;
+                }
+            }
+        }
+
+        const float nodeArea = bounds.area();
+        const float leafCost = nbPrimitives * nodeArea;
+        const float splitCost = traversalCost * nodeArea + bestCost;
+        if(nbPrimitives <= maxLeafSize && (bestSplit < 0 || splitCost >= leafCost))
+            return false;
+
+        if(bestSplit >= 0)
+        {
+            BuildPrimitive* middle = std::partition(&_primitives[begin], &_primitives[0] + end,
+                [&](const BuildPrimitive& p)
+                {
+                    return std::min(nbBins - 1, static_cast<int>((p.centroid[axis] - offset) * scale)) <= bestSplit;
+                });
+            out_middle = static_cast<int>(middle - &_primitives[0]);
+        }
+        else
+        {
+            out_middle = begin;
+        }
+
+        // split at the median if the binning failed (numerical precision)
+        if(out_middle == begin || out_middle == end)
+        {
+            out_middle = begin + nbPrimitives / 2;
+            std::nth_element(&_primitives[begin], &_primitives[out_middle], &_primitives[0] + end,
+                [axis](const BuildPrimitive& a, const BuildPrimitive& b)
+                {
+                    return a.centroid[axis] < b.centroid[axis];
+                });
+        }
+        return true;
+    }
+
+    std::vector<BuildPrimitive>& _primitives;
+};
+
+/// packet of rays, stored by coordinate for SIMD
+struct MeshBVH::RayPacket
+{
+    alignas(16) float origin[3][packetSize];
+    alignas(16) float direction[3][packetSize];
+    alignas(16) float invDirection[3][packetSize];
+    alignas(16) float tMax[packetSize];
+    /// bit i is set if the ray i is still traced
+    int activeMask;
+};
+
+MeshBVH::MeshBVH(const Mesh& mesh)
+{
+    const int nbTris = (mesh.tris != nullptr) ? mesh.tris->size() : 0;
+
+    std::vector<BuildPrimitive> primitives(nbTris);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
+    {
+        BuildPrimitive& primitive = primitives[i];
+        primitive.triId = i;
+        for(int k = 0; k < 3; ++k)
+        {
+            const Point3d& p = (*mesh.pts)[(*mesh.tris)[i].v[k]];
+            const float pf[3] = {static_cast<float>(p.x), static_cast<float>(p.y), static_cast<float>(p.z)};
+            primitive.bounds.grow(pf);
+        }
+        for(int k = 0; k < 3; ++k)
+            primitive.centroid[k] = 0.5f * (primitive.bounds.min[k] + primitive.bounds.max[k]);
+    }
+
+    Builder builder(primitives);
+    _nodes.resize(1);
+
+    if(nbTris == 0)
+    {
+        _nodes[0] = Node{{0.0f, 0.0f, 0.0f}, 0, {-1.0f, -1.0f, -1.0f}, 0};
+        return;
+    }
+
+    // split the top levels sequentially, then build the subtrees in parallel
+    const int jobSize = std::max(1024, nbTris / (8 * omp_get_max_threads()));
+    std::vector<SubtreeJob> jobs;
+    builder.build(_nodes, 0, 0, nbTris, 0, _depth, &jobs, jobSize);
+
+    std::vector<std::vector<Node>> subtrees(jobs.size());
+    std::vector<int> subtreesDepth(jobs.size(), 0);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int j = 0; j < static_cast<int>(jobs.size()); ++j)
+    {
+        const SubtreeJob& job = jobs[j];
+        subtrees[j].resize(1);
+        builder.build(subtrees[j], 0, job.begin, job.end, job.depth, subtreesDepth[j], nullptr, 0);
+    }
+
+    // move the subtrees into the tree: their root replaces the job node, the other nodes are appended
+    for(int j = 0; j < static_cast<int>(jobs.size()); ++j)
+    {
+        const int offset = static_cast<int>(_nodes.size()) - 1;
+        for(Node& node : subtrees[j])
+        {
+            if(node.nbTriangles == 0)
+                node.first += offset;
+        }
+        _nodes[jobs[j].nodeIndex] = subtrees[j][0];
+        _nodes.insert(_nodes.end(), subtrees[j].begin() + 1, subtrees[j].end());
+        _depth = std::max(_depth, subtreesDepth[j]);
+    }
+
+    // triangles in the order of the leaves
+    _triangles.resize(nbTris);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
+    {
+        const int triId = primitives[i].triId;
+        const Point3d& p0 = (*mesh.pts)[(*mesh.tris)[triId].v[0]];
+        const Point3d& p1 = (*mesh.pts)[(*mesh.tris)[triId].v[1]];
+        const Point3d& p2 = (*mesh.pts)[(*mesh.tris)[triId].v[2]];
+
+        Triangle& tri = _triangles[i];
+        tri.triId = triId;
+        for(int k = 0; k < 3; ++k)
+        {
+            tri.v0[k] = static_cast<float>(p0.m[k]);
+            tri.e1[k] = static_cast<float>(p1.m[k] - p0.m[k]);
+            tri.e2[k] = static_cast<float>(p2.m[k] - p0.m[k]);
+        }
+    }
+}
+
+template<bool anyHit>
+int MeshBVH::traverse(const Ray& ray, double& out_t) const
+{
+    const float origin[3] = {static_cast<float>(ray.origin.x), static_cast<float>(ray.origin.y), static_cast<float>(ray.origin.z)};
+    const float direction[3] = {static_cast<float>(ray.direction.x), static_cast<float>(ray.direction.y), static_cast<float>(ray.direction.z)};
+    const float invDirection[3] = {1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2]};
+
+    float tBest = static_cast<float>(ray.tMax);
+    int hitTriId = -1;
+
+    int stack[2 * maxDepth + 2];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while(stackSize > 0)
+    {
+        const Node& node = _nodes[stack[--stackSize]];
+
+        // slab test
+        float tNear = 0.0f;
+        float tFar = tBest;
+        for(int k = 0; k < 3; ++k)
+        {
+            const float t1 = (node.boundsMin[k] - origin[k]) * invDirection[k];
+            const float t2 = (node.boundsMax[k] - origin[k]) * invDirection[k];
+            tNear = std::max(tNear, std::min(t1, t2));
+            tFar = std::min(tFar, std::max(t1, t2));
+        }
+        if(tNear > tFar)
+            continue;
+
+        if(node.nbTriangles == 0)
+        {
+            stack[stackSize++] = node.first + 1;
+            stack[stackSize++] = node.first;
+            continue;
+        }
+
+        for(int i = node.first; i < node.first + node.nbTriangles; ++i)
+        {
+            // Moller-Trumbore intersection
+            const Triangle& tri = _triangles[i];
+            float p[3];
+            cross(direction, tri.e2, p);
+            const float det = dot(tri.e1, p);
+            if(det == 0.0f)
+                continue;
+            const float invDet = 1.0f / det;
+            const float s[3] = {origin[0] - tri.v0[0], origin[1] - tri.v0[1], origin[2] - tri.v0[2]};
+            const float u = dot(s, p) * invDet;
+            if(u < 0.0f || u > 1.0f)
+                continue;
+            float q[3];
+            cross(s, tri.e1, q);
+            const float v = dot(direction, q) * invDet;
+            if(v < 0.0f || u + v > 1.0f)
+                continue;
+            const float t = dot(tri.e2, q) * invDet;
+            if(t > 0.0f && t < tBest)
+            {
+                tBest = t;
+                hitTriId = tri.triId;
+                if(anyHit)
+                {
+                    out_t = tBest;
+                    return hitTriId;
+                }
+            }
+        }
+    }
+
+    out_t = tBest;
+    return hitTriId;
+}
+
+int MeshBVH::intersect(const Ray& ray, double& out_t) const
+{
+    return traverse<false>(ray, out_t);
+}
+
+bool MeshBVH::isOccluded(const Ray& ray) const
+{
+    double t;
+    return traverse<true>(ray, t) >= 0;
+}
+
+void MeshBVH::isOccluded(const Ray* rays, int nbRays, bool* out_occluded) const
+{
+    const int nbPackets = (nbRays + packetSize - 1) / packetSize;
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(int i = 0; i < nbPackets; ++i)
+    {
+        const int first = i * packetSize;
+        isOccludedPacket(rays + first, std::min(packetSize, nbRays - first), out_occluded + first);
+    }
+}
+
+void MeshBVH::isOccludedPacket(const Ray* rays, int nbRays, bool* out_occluded) const
+{
+    static_assert(packetSize == 4, "the packet traversal uses 4 floats SIMD");
+
+    RayPacket packet;
+    packet.activeMask = 0;
+    for(int r = 0; r < packetSize; ++r)
+    {
+        const bool isRay = r < nbRays;
+        for(int k = 0; k < 3; ++k)
+        {
+            packet.origin[k][r] = isRay ? static_cast<float>(rays[r].origin.m[k]) : 0.0f;
+            packet.direction[k][r] = isRay ? static_cast<float>(rays[r].direction.m[k]) : 1.0f;
+            packet.invDirection[k][r] = 1.0f / packet.direction[k][r];
+        }
+        packet.tMax[r] = isRay ? static_cast<float>(rays[r].tMax) : -1.0f;
+        if(isRay)
+        {
+            out_occluded[r] = false;
+            packet.activeMask |= 1 << r;
+        }
+    }
+
+    int stack[2 * maxDepth + 2];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while(stackSize > 0 && packet.activeMask != 0)
+    {
+        const Node& node = _nodes[stack[--stackSize]];
+
+        // slab test of the rays of the packet
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+        __m128 tNear = _mm_setzero_ps();
+        __m128 tFar = _mm_load_ps(packet.tMax);
+        for(int k = 0; k < 3; ++k)
+        {
+            const __m128 origin = _mm_load_ps(packet.origin[k]);
+            const __m128 invDirection = _mm_load_ps(packet.invDirection[k]);
+            const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin[k]), origin), invDirection);
+            const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax[k]), origin), invDirection);
+            tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+            tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+        }
+        const int hitMask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar)) & packet.activeMask;
+#else
+        int hitMask = 0;
+        for(int r = 0; r < packetSize; ++r)
+        {
+            float tNear = 0.0f;
+            float tFar = packet.tMax[r];
+            for(int k = 0; k < 3; ++k)
+            {
+                const float t1 = (node.boundsMin[k] - packet.origin[k][r]) * packet.invDirection[k][r];
+                const float t2 = (node.boundsMax[k] - packet.origin[k][r]) * packet.invDirection[k][r];
+                tNear = std::max(tNear, std::min(t1, t2));
+                tFar = std::min(tFar, std::max(t1, t2));
+            }
+            hitMask |= static_cast<int>(tNear <= tFar) << r;
+        }
+        hitMask &= packet.activeMask;
+#endif
+        if(hitMask == 0)
+            continue;
+
+        if(node.nbTriangles == 0)
+        {
+            stack[stackSize++] = node.first + 1;
+            stack[stackSize++] = node.first;
+            continue;
+        }
+
+        for(int i = node.first; i < node.first + node.nbTriangles && packet.activeMask != 0; ++i)
+        {
+            const Triangle& tri = _triangles[i];
+
+            // Moller-Trumbore intersection of the rays of the packet, by coordinate
+            int occludedMask = 0;
+            for(int r = 0; r < packetSize; ++r)
+            {
+                const float d[3] = {packet.direction[0][r], packet.direction[1][r], packet.direction[2][r]};
+                const float s[3] = {packet.origin[0][r] - tri.v0[0], packet.origin[1][r] - tri.v0[1], packet.origin[2][r] - tri.v0[2]};
+                float p[3];
+                float q[3];
+                cross(d, tri.e2, p);
+                cross(s, tri.e1, q);
+                const float det = dot(tri.e1, p);
+                const float invDet = 1.0f / det;
+                const float u = dot(s, p) * invDet;
+                const float v = dot(d, q) * invDet;
+                const float t = dot(tri.e2, q) * invDet;
+                const bool isHit = (det != 0.0f) & (u >= 0.0f) & (v >= 0.0f) & (u + v <= 1.0f) & (t > 0.0f) & (t < packet.tMax[r]);
+                occludedMask |= static_cast<int>(isHit) << r;
+            }
+            occludedMask &= packet.activeMask;
+
+            for(int r = 0; r < nbRays; ++r)
+            {
+                if(occludedMask & (1 << r))
+                    out_occluded[r] = true;
+            }
+            packet.activeMask &= ~occludedMask;
+        }
+    }
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,115 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Bounding volume hierarchy of the triangles of a mesh, for ray casting.
+ *
+ * The hierarchy is a binary tree built with the surface area heuristic (SAH) on binned centroids.
+ * The top levels are split sequentially, then the subtrees are built in parallel.
+ * Rays can be traced one by one or by packets of 4 rays traversing the tree together,
+ * which is efficient for coherent rays (e.g. from a camera center toward neighboring points).
+ */
+class MeshBVH
+{
+public:
+    /// number of rays in a packet
+    static const int packetSize = 4;
+
+    /// ray (or segment) origin + t * direction, for t in ]0, tMax[
+    struct Ray
+    {
+        Point3d origin;
+        Point3d direction;
+        double tMax;
+    };
+
+    /**
+     * @brief Build the hierarchy of the triangles of a mesh.
+     *        The mesh vertices are copied: the mesh can be modified or destroyed afterwards.
+     * @param[in] mesh the input mesh
+     */
+    explicit MeshBVH(const Mesh& mesh);
+
+    /// @return the number of nodes of the tree
+    int getNbNodes() const { return static_cast<int>(_nodes.size()); }
+
+    /// @return the depth of the tree
+    int getDepth() const { return _depth; }
+
+    /**
+     * @brief Find the nearest triangle intersected by a ray.
+     * @param[in] ray the input ray
+     * @param[out] out_t the ray parameter of the intersection
+     * @return the intersected triangle index, or -1
+     */
+    int intersect(const Ray& ray, double& out_t) const;
+
+    /**
+     * @brief Check if a ray intersects any triangle.
+     * @param[in] ray the input ray
+     * @return true if a triangle is intersected
+     */
+    bool isOccluded(const Ray& ray) const;
+
+    /**
+     * @brief Check if rays intersect any triangle, traced by packets of packetSize rays.
+     *        The consecutive rays should be coherent (similar origins and directions).
+     * @param[in] rays the input rays
+     * @param[in] nbRays the number of rays
+     * @param[out] out_occluded true for each ray intersecting a triangle
+     */
+    void isOccluded(const Ray* rays, int nbRays, bool* out_occluded) const;
+
+private:
+    /**
+     * @brief Tree node.
+     *        Inner nodes (nbTriangles == 0) have their two children at index first and first + 1.
+     *        Leaves have their triangles at index first to first + nbTriangles - 1.
+     */
+    struct Node
+    {
+        float boundsMin[3];
+        int first;
+        float boundsMax[3];
+        int nbTriangles;
+    };
+
+    /// triangle vertex and edges, for Moller-Trumbore intersection
+    struct Triangle
+    {
+        float v0[3];
+        float e1[3];
+        float e2[3];
+        int triId;
+    };
+
+    class Builder;
+    struct RayPacket;
+
+    /// find the nearest intersection (or any intersection if anyHit) of a ray
+    template<bool anyHit>
+    int traverse(const Ray& ray, double& out_t) const;
+
+    /// occlusion of a packet of up to packetSize rays
+    void isOccludedPacket(const Ray* rays, int nbRays, bool* out_occluded) const;
+
+    std::vector<Node> _nodes;
+    std::vector<Triangle> _triangles;
+    int _depth = 0;
+};
+
+} // namespace mesh
+} // namespace aliceVision
@@ -280,23 +280,6 @@ int MeshClean::path::deployTriangles(StaticVector<int>* trisIds, bool isBoundary
     m_me->ptsBoundary->reserveAddIfNeeded(1, 1000);
     m_me->ptsBoundary->push_back(isBoundaryPt);
 
-    // update ptsNeighTrisSortedAsc
-    m_me->ptsNeighTrisSortedAsc->reserveAddIfNeeded(trisIds->size(), 1000);
-    StaticVector<int>* newPtNeighTrisSortedAsc = new StaticVector<int>();
-    newPtNeighTrisSortedAsc->reserve(trisIds->size());
-    for(int i = 0; i < trisIds->size(); i++)
-    {
-        newPtNeighTrisSortedAsc->push_back((*trisIds)[i]);
-    }
-    qsort(&(*newPtNeighTrisSortedAsc)[0], newPtNeighTrisSortedAsc->size(), sizeof(int), qSortCompareIntAsc);
-    m_me->ptsNeighTrisSortedAsc->push_back(newPtNeighTrisSortedAsc);
-
-    // if ((m_ptId==148062)||(m_ptId==177810))
-    //{
-    //	printf("tris : "); for (int i=0;i<newPtNeighTrisSortedAsc->size();i++) { printf("%i
-    //",(*newPtNeighTrisSortedAsc)[i]); };printf("\n");
-    //};
-
     // update edgesNeigTris
     for(int i = 0; i < trisIds->size(); i++)
     {
@@ -374,41 +357,11 @@ void MeshClean::path::deployPath(StaticVector<MeshClean::path::pathPart>* _pth)
     {
         trisIds->push_back((*_pth)[i].triId);
     }
-    int newPtId = deployTriangles(trisIds, (!isClodePath(_pth)));
-
-    m_me->ptsNeighPtsOrdered->reserveAddIfNeeded(1, 1000);
-    m_me->ptsNeighPtsOrdered->push_back(nullptr);
-    updatePtNeighPtsOrderedByPath(newPtId, _pth);
+    deployTriangles(trisIds, (!isClodePath(_pth)));
 
     delete trisIds;
 }
 
-void MeshClean::path::updatePtNeighPtsOrderedByPath(int _ptId, StaticVector<MeshClean::path::pathPart>* _pth)
-{
-    StaticVector<int>*& ptNeighPtsOrderedByPath = (*m_me->ptsNeighPtsOrdered)[_ptId];
-
-    if(ptNeighPtsOrderedByPath != nullptr)
-    {
-        delete ptNeighPtsOrderedByPath;
-        ptNeighPtsOrderedByPath = nullptr;
-    }
-
-    if((_pth != nullptr) && (_pth->size() > 0))
-    {
-        ptNeighPtsOrderedByPath = new StaticVector<int>();
-        ptNeighPtsOrderedByPath->reserve(_pth->size() + 1);
-
-        if(!isClodePath(_pth))
-        {
-            ptNeighPtsOrderedByPath->push_back((*_pth)[0].ptsIds[0]);
-        }
-        for(int i = 0; i < _pth->size(); i++)
-        {
-            ptNeighPtsOrderedByPath->push_back((*_pth)[i].ptsIds[1]);
-        }
-    }
-}
-
 StaticVector<MeshClean::path::pathPart>*
 MeshClean::path::createPath(StaticVector<int>* ptNeighTrisSortedAscToProcess)
 {
@@ -458,15 +411,15 @@ int MeshClean::path::deployAll()
     StaticVector<MeshClean::path::pathPart>* pth;
 
     {
-      StaticVector<int>* ptsNeighTrisSortedAsc = (*m_me->ptsNeighTrisSortedAsc)[m_ptId];
-      if(sizeOfStaticVector<int>(ptsNeighTrisSortedAsc) == 0)
+      // the triangles of the point are not changed by the cleaning of the other points of the pass
+      const Adjacency& ptsNeighTrisSortedAsc = m_me->ptsNeighTrisSortedAsc;
+      if(ptsNeighTrisSortedAsc.size(m_ptId) == 0)
       {
         return 0;
       }
 
       ptNeighTrisSortedAscToProcess = new StaticVector<int>();
-      ptNeighTrisSortedAscToProcess->reserve(sizeOfStaticVector<int>(ptsNeighTrisSortedAsc));
-      ptNeighTrisSortedAscToProcess->push_back_arr(ptsNeighTrisSortedAsc);
+      ptNeighTrisSortedAscToProcess->getDataWritable().assign(ptsNeighTrisSortedAsc.begin(m_ptId), ptsNeighTrisSortedAsc.end(m_ptId));
       pth = createPath(ptNeighTrisSortedAscToProcess);
     }
 
@@ -475,10 +428,7 @@ int MeshClean::path::deployAll()
     // if there are some not connected triangles then deploy them
     if(ptNeighTrisSortedAscToProcess->size() > 0)
     {
-        int newPtId = deployTriangles(ptNeighTrisSortedAscToProcess, true);
-        m_me->ptsNeighPtsOrdered->reserveAddIfNeeded(1, 1000);
-        m_me->ptsNeighPtsOrdered->push_back(nullptr);
-        updatePtNeighPtsOrderedByPath(newPtId, nullptr);
+        deployTriangles(ptNeighTrisSortedAscToProcess, true);
         ptNeighTrisSortedAscToProcess->resize(0);
         nNewPts++;
         // printf("WARNING createPath :: ptNeighTrisSortedAscToProcess->size()>0\n");
@@ -496,35 +446,8 @@ int MeshClean::path::deployAll()
         }
         else
         {
-            // get an up-to-date pointer to data since me->ptsNeighTrisSortedAsc might have been 
-            // modified inside the while loop by 'deployPath'
-            StaticVector<int>* toUpdate = (*m_me->ptsNeighTrisSortedAsc)[m_ptId];
-            if(toUpdate == nullptr)
-            {
-                printfState(pth);
-                printfState(pthNew);
-                throw std::runtime_error("deployAll: bad condition, pthNew size: " + std::to_string(pthNew->size()));
-            }
-
-            if(toUpdate->capacity() < pthNew->size())
-            {
-                printfState(pth);
-                printfState(pthNew);
-                throw std::runtime_error("deployAll: bad condition, pthNew size: " + std::to_string(pthNew->size()));
-            }
-
-            toUpdate->resize(0);
-            for(int i = 0; i < pthNew->size(); i++)
-            {
-                toUpdate->push_back((*pthNew)[i].triId);
-            }
-            if(pthNew->size() > 0)
-            {
-                qsort(&(*toUpdate)[0], toUpdate->size(), sizeof(int), qSortCompareIntAsc);
-            }
-
+            // the point keeps the triangles of the remaining path
             (*m_me->ptsBoundary)[m_ptId] = (!isClodePath(pthNew));
-            updatePtNeighPtsOrderedByPath(m_ptId, pthNew);
         }
         delete pthNew;
     }
@@ -539,8 +462,7 @@ bool MeshClean::path::isWrongPt()
 {
     int nNewPtsNeededToAdd = 0;
     StaticVector<int>* ptNeighTrisSortedAscToProcess = new StaticVector<int>();
-    ptNeighTrisSortedAscToProcess->reserve(sizeOfStaticVector<int>((*m_me->ptsNeighTrisSortedAsc)[m_ptId]));
-    ptNeighTrisSortedAscToProcess->push_back_arr((*m_me->ptsNeighTrisSortedAsc)[m_ptId]);
+    ptNeighTrisSortedAscToProcess->getDataWritable().assign(m_me->ptsNeighTrisSortedAsc.begin(m_ptId), m_me->ptsNeighTrisSortedAsc.end(m_ptId));
     StaticVector<MeshClean::path::pathPart>* pth = createPath(ptNeighTrisSortedAscToProcess);
 
     // if there are some not connected triangles then deploy them
@@ -578,8 +500,6 @@ MeshClean::MeshClean(mvsUtils::MultiViewParams* _mp)
     edgesXStat = nullptr;
     edgesXYStat = nullptr;
     ptsBoundary = nullptr;
-    ptsNeighTrisSortedAsc = nullptr;
-    ptsNeighPtsOrdered = nullptr;
     newPtsOldPtId = nullptr;
 }
 
@@ -610,14 +530,8 @@ void MeshClean::deallocateCleaningAttributes()
     {
         delete ptsBoundary;
     }
-    if(ptsNeighTrisSortedAsc != nullptr)
-    {
-        deleteArrayOfArrays<int>(&ptsNeighTrisSortedAsc);
-    }
-    if(ptsNeighPtsOrdered != nullptr)
-    {
-        deleteArrayOfArrays<int>(&ptsNeighPtsOrdered);
-    }
+    ptsNeighTrisSortedAsc.clear();
+    ptsNeighPtsOrdered.clear();
     if(newPtsOldPtId != nullptr)
     {
         delete newPtsOldPtId;
@@ -627,8 +541,6 @@ void MeshClean::deallocateCleaningAttributes()
     edgesXStat = nullptr;
     edgesXYStat = nullptr;
     ptsBoundary = nullptr;
-    ptsNeighTrisSortedAsc = nullptr;
-    ptsNeighPtsOrdered = nullptr;
     newPtsOldPtId = nullptr;
 
     nPtsInit = -1;
@@ -664,19 +576,8 @@ void MeshClean::init()
 {
     deallocateCleaningAttributes();
 
-    ptsNeighTrisSortedAsc = getPtsNeighborTriangles();
-    for(int i = 0; i < pts->size(); i++)
-    {
-        StaticVector<int>* ptNeigTris = (*ptsNeighTrisSortedAsc)[i];
-        if(sizeOfStaticVector<int>(ptNeigTris) > 1)
-        {
-            qsort(&(*ptNeigTris)[0], ptNeigTris->size(), sizeof(int), qSortCompareIntAsc);
-        }
-    }
-
-    ptsNeighPtsOrdered = new StaticVector<StaticVector<int>*>();
-    ptsNeighPtsOrdered->reserve(pts->size());
-    ptsNeighPtsOrdered->resize_with(pts->size(), nullptr);
+    getPtsNeighborTriangles(ptsNeighTrisSortedAsc);
+    getPtsNeighPtsOrdered(ptsNeighTrisSortedAsc, ptsNeighPtsOrdered);
 
     ptsBoundary = new StaticVectorBool();
     ptsBoundary->reserve(pts->size());
@@ -766,7 +667,7 @@ void MeshClean::testPtsNeighTrisSortedAsc()
         for(int k = 0; k < 3; k++)
         {
             int ptId = (*tris)[i].v[k];
-            if((*ptsNeighTrisSortedAsc)[ptId]->indexOf(i) == -1)
+            if(ptsNeighTrisSortedAsc.indexOf(ptId, i) == -1)
             {
                 n++;
                 ALICEVISION_LOG_DEBUG("\t- ptid: " << ptId << "triid: " <<  i);
@@ -786,15 +687,14 @@ void MeshClean::testPtsNeighTrisSortedAsc()
     n = 0;
     for(int i = 0; i < pts->size(); i++)
     {
-        StaticVector<int>* ptNeighTris = (*ptsNeighTrisSortedAsc)[i];
         int lastid = -1;
-        for(int k = 0; k < sizeOfStaticVector<int>(ptNeighTris); k++)
+        for(int k = 0; k < ptsNeighTrisSortedAsc.size(i); k++)
         {
-            if(lastid > (*ptNeighTris)[k])
+            if(lastid > ptsNeighTrisSortedAsc(i, k))
             {
                 n++;
             }
-            lastid = (*ptNeighTris)[k];
+            lastid = ptsNeighTrisSortedAsc(i, k);
         }
     }
     if(n == 0)
@@ -859,23 +759,8 @@ void MeshClean::testPtsNeighPtsOrdered()
             int ptId1 = (*tris)[i].v[k];
             int ptId2 = (*tris)[i].v[k1];
 
-            if(sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[ptId1]) == 0)
-            {
-                n++;
-            }
-            else
-            {
-                n += static_cast<int>((*ptsNeighPtsOrdered)[ptId1]->indexOf(ptId2) == -1);
-            }
-
-            if(sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[ptId2]) == 0)
-            {
-                n++;
-            }
-            else
-            {
-                n += static_cast<int>((*ptsNeighPtsOrdered)[ptId2]->indexOf(ptId1) == -1);
-            }
+            n += static_cast<int>(ptsNeighPtsOrdered.indexOf(ptId1, ptId2) == -1);
+            n += static_cast<int>(ptsNeighPtsOrdered.indexOf(ptId2, ptId1) == -1);
         }
     }
     if(n == 0)
@@ -897,6 +782,13 @@ int MeshClean::cleanMesh()
         path pth(this, i);
         nWrongPts += static_cast<int>(pth.deployAll() > 0);
     }
+
+    // the triangles of the wrong points have been split between new points
+    if(pts->size() > nv)
+    {
+        getPtsNeighborTriangles(ptsNeighTrisSortedAsc);
+        getPtsNeighPtsOrdered(ptsNeighTrisSortedAsc, ptsNeighPtsOrdered);
+    }
     ALICEVISION_LOG_INFO("cleanMesh:" << std::endl
                       << "\t- # wrong points: " << nWrongPts << std::endl
                       << "\t- # new points: " << (pts->size() - nv));
@@ -63,7 +63,6 @@ public:
         int deployTriangles(StaticVector<int>* trisIds, bool isBoundaryPt);
         void deployPath(StaticVector<pathPart>* _pth);
         bool isClodePath(StaticVector<pathPart>* _pth);
-        void updatePtNeighPtsOrderedByPath(int _ptId, StaticVector<pathPart>* _pth);
         StaticVector<pathPart>* createPath(StaticVector<int>* ptNeighTrisSortedAscToProcess);
         int deployAll();
         bool isWrongPt();
@@ -71,8 +70,10 @@ public:
 
     mvsUtils::MultiViewParams* mp;
 
-    StaticVector<StaticVector<int>*>* ptsNeighTrisSortedAsc;
-    StaticVector<StaticVector<int>*>* ptsNeighPtsOrdered;
+    /// neighbor triangles of each vertex, sorted by index (built by init and after each cleaning pass adding vertices)
+    Adjacency ptsNeighTrisSortedAsc;
+    /// neighbor vertices of each vertex, ordered around the vertex (built with ptsNeighTrisSortedAsc)
+    Adjacency ptsNeighPtsOrdered;
     StaticVectorBool* ptsBoundary;
     StaticVector<int>* newPtsOldPtId;
 
@@ -23,7 +23,7 @@ MeshEnergyOpt::MeshEnergyOpt(mvsUtils::MultiViewParams* _mp)
 
 MeshEnergyOpt::~MeshEnergyOpt() = default;
 
-StaticVector<Point3d>* MeshEnergyOpt::computeLaplacianPtsParallel()
+StaticVector<Point3d>* MeshEnergyOpt::computeLaplacianPtsParallel(const Adjacency& ptsNeighPts)
 {
     StaticVector<Point3d>* lapPts = new StaticVector<Point3d>();
     lapPts->reserve(pts->size());
@@ -34,7 +34,7 @@ StaticVector<Point3d>* MeshEnergyOpt::computeLaplacianPtsParallel()
     for(int i = 0; i < pts->size(); i++)
     {
         Point3d lapPt;
-        if(getLaplacianSmoothingVector(i, lapPt))
+        if(getLaplacianSmoothingVector(i, ptsNeighPts, lapPt))
         {
             (*lapPts)[i] = lapPt;
             nlabpts++;
@@ -44,11 +44,11 @@ StaticVector<Point3d>* MeshEnergyOpt::computeLaplacianPtsParallel()
     return lapPts;
 }
 
-void MeshEnergyOpt::updateGradientParallel(float lambda, const Point3d& LU,
+void MeshEnergyOpt::updateGradientParallel(const Adjacency& ptsNeighPts, float lambda, const Point3d& LU,
                                                 const Point3d& RD, StaticVectorBool* ptsCanMove)
 {
     // printf("nlabpts %i of %i\n",nlabpts,pts->size());
-    StaticVector<Point3d>* lapPts = computeLaplacianPtsParallel();
+    StaticVector<Point3d>* lapPts = computeLaplacianPtsParallel(ptsNeighPts);
 
     StaticVector<Point3d>* newPts = new StaticVector<Point3d>();
     newPts->reserve(pts->size());
@@ -61,7 +61,7 @@ void MeshEnergyOpt::updateGradientParallel(float lambda, const Point3d& LU,
         {
             Point3d n;
 
-            if(getBiLaplacianSmoothingVector(i, lapPts, n))
+            if(getBiLaplacianSmoothingVector(i, ptsNeighPts, lapPts, n))
             {
                 Point3d p = (*newPts)[i] + n * lambda;
                 if((p.x > LU.x) && (p.y > LU.y) && (p.z > LU.z) && (p.x < RD.x) && (p.y < RD.y) && (p.z < RD.z))
@@ -106,7 +106,8 @@ bool MeshEnergyOpt::optimizeSmooth(float lambda, int niter, StaticVectorBool* pt
     for(int i = 0; i < niter; i++)
     {
         ALICEVISION_LOG_INFO("Optimizing mesh smooth: iteration " << i);
-        updateGradientParallel(lambda, LU, RD, ptsCanMove);
+        // the smoothing only moves the points, the connectivity of the cleaned mesh is kept
+        updateGradientParallel(ptsNeighPtsOrdered, lambda, LU, RD, ptsCanMove);
         if(saveDebug)
             saveToObj(mp->mvDir + "mesh_smoothed_" + std::to_string(i) + ".obj");
     }
@@ -22,8 +22,8 @@ public:
     bool optimizeSmooth(float lambda, int niter, StaticVectorBool* ptsCanMove);
 
 private:
-    StaticVector<Point3d>* computeLaplacianPtsParallel();
-    void updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, StaticVectorBool* ptsCanMove);
+    StaticVector<Point3d>* computeLaplacianPtsParallel(const Adjacency& ptsNeighPts);
+    void updateGradientParallel(const Adjacency& ptsNeighPts, float lambda, const Point3d& LU, const Point3d& RD, StaticVectorBool* ptsCanMove);
 };
 
 } // namespace mesh
@@ -9,11 +9,13 @@
 #include "UVAtlas.hpp"
 
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/mvsData/Color.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/imageIO/image.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <geogram/basic/common.h>
 #include <geogram/basic/geometry_nd.h>
@@ -23,6 +25,7 @@
 
 #include <boost/algorithm/string/case_conv.hpp> 
 
+#include <algorithm>
 #include <map>
 #include <set>
 
@@ -62,11 +65,13 @@ std::string EVisibilityRemappingMethod_enumToString(EVisibilityRemappingMethod m
     switch (method)
     {
     case EVisibilityRemappingMethod::Pull:
-        return "Push";
-    case EVisibilityRemappingMethod::Push:
         return "Pull";
+    case EVisibilityRemappingMethod::Push:
+        return "Push";
     case EVisibilityRemappingMethod::PullPush:
         return "PullPush";
+    case EVisibilityRemappingMethod::RayCast:
+        return "RayCast";
     }
     throw std::out_of_range("Unrecognized EVisibilityRemappingMethod");
 }
@@ -81,6 +86,8 @@ EVisibilityRemappingMethod EVisibilityRemappingMethod_stringToEnum(const std::st
         return EVisibilityRemappingMethod::Push;
     if (m == "pullpush")
         return EVisibilityRemappingMethod::PullPush;
+    if (m == "raycast")
+        return EVisibilityRemappingMethod::RayCast;
     throw std::out_of_range("Invalid unwrap method " + method);
 }
 
@@ -229,17 +236,69 @@ void Texturing::generateUVs(mvsUtils::MultiViewParams& mp)
     // replace internal mesh
     std::swap(me, m);
     delete m;
+    clearTrisCams();
     // replace visibilities
     std::swap(pointsVisibilities, updatedPointsCams);
     deleteArrayOfArrays<int>(&updatedPointsCams);
 }
 
+/// number of texture rows in a unit of work of the pixel color accumulation
+static const unsigned int textureChunkRows = 64;
+
 void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
                                  const boost::filesystem::path &outPath, EImageFileType textureFileType)
 {
+    // the images cache is shared by all the atlases generated at the same time
     mvsUtils::ImagesCache imageCache(&mp, 0, false);
-    for(size_t atlasID = 0; atlasID < _atlases.size(); ++atlasID)
-        generateTexture(mp, atlasID, imageCache, outPath, textureFileType);
+
+    const std::size_t maxNbAtlasesAtOnce = std::max(1, std::min(omp_get_max_threads(),
+                                                    static_cast<int>(getMemoryBudget() / getAtlasMemorySize(textureChunkRows))));
+    ALICEVISION_LOG_INFO("Generating " << _atlases.size() << " textures, up to " << maxNbAtlasesAtOnce << " at once.");
+
+    // the rasterization is shared by all the atlases
+    const StaticVector<StaticVector<int>*>* trisCams = getTrisCams(mp);
+
+    for(size_t atlasFrom = 0; atlasFrom < _atlases.size(); atlasFrom += maxNbAtlasesAtOnce)
+    {
+        std::vector<size_t> atlasIDs;
+        for(size_t atlasID = atlasFrom; atlasID < std::min(_atlases.size(), atlasFrom + maxNbAtlasesAtOnce); ++atlasID)
+            atlasIDs.push_back(atlasID);
+        generateTextures(mp, atlasIDs, imageCache, trisCams, outPath, textureFileType);
+    }
+}
+
+void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
+                                size_t atlasID, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
+{
+    generateTextures(mp, std::vector<size_t>(1, atlasID), imageCache, outPath, textureFileType);
+}
+
+void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp, const std::vector<size_t>& atlasIDs,
+                                 mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
+{
+    generateTextures(mp, atlasIDs, imageCache, getTrisCams(mp), outPath, textureFileType);
+}
+
+const StaticVector<StaticVector<int>*>* Texturing::getTrisCams(const mvsUtils::MultiViewParams& mp)
+{
+    if(!texParams.discardOccludedCameras)
+        return nullptr;
+
+    if(_trisCams == nullptr)
+    {
+        ALICEVISION_LOG_INFO("Rasterizing the mesh in " << mp.ncams << " cameras to discard the occluded cameras.");
+        _trisCams = me->computeTrisCamsFromRasterization(&mp, 1);
+    }
+    return _trisCams;
+}
+
+void Texturing::clearTrisCams()
+{
+    if(_trisCams != nullptr)
+    {
+        deleteArrayOfArrays<int>(&_trisCams);
+        _trisCams = nullptr;
+    }
 }
 
 
@@ -270,20 +329,27 @@ struct AccuColor {
     }
 };
 
-
-void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
-                                size_t atlasID, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
+std::size_t Texturing::getMemoryBudget() const
 {
-    if(atlasID >= _atlases.size())
-        throw std::runtime_error("Invalid atlas ID " + std::to_string(atlasID));
-
-    unsigned int textureSize = texParams.textureSide * texParams.textureSide;
-    std::vector<int> colorIDs(textureSize, -1);
+    if(texParams.maxMemoryMB > 0)
+        return static_cast<std::size_t>(texParams.maxMemoryMB) * 1024 * 1024;
+    // use half of the available memory, the other half being for the images cache and the mesh
+    return system::getMemoryInfo().freeRam / 2;
+}
 
-    std::vector<std::vector<unsigned int>> camTriangles(mp.ncams);
+std::size_t Texturing::getAtlasMemorySize(std::size_t nbTileRows) const
+{
+    const std::size_t textureSize = static_cast<std::size_t>(texParams.textureSide) * texParams.textureSide;
+    // final colors + valid pixels (+ alpha for holes filling) and the colors accumulated for one tile
+    return textureSize * (sizeof(Color) + sizeof(unsigned char) + (texParams.fillHoles ? sizeof(float) : 0)) +
+           nbTileRows * texParams.textureSide * sizeof(AccuColor);
+}
 
-    ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasID + 1 << "/" << _atlases.size()
-              << " (" << _atlases[atlasID].size() << " triangles).");
+void Texturing::selectTrianglesCameras(const mvsUtils::MultiViewParams& mp, size_t atlasID,
+                                       const StaticVector<StaticVector<int>*>* trisCams,
+                                       std::vector<std::vector<unsigned int>>& camTriangles)
+{
+    camTriangles.assign(mp.ncams, std::vector<unsigned int>());
 
     // iterate over atlas' triangles
     for(size_t i = 0; i < _atlases[atlasID].size(); ++i)
@@ -326,6 +392,10 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
 
         assert(!selectedTriCams.empty());
 
+        // cameras where the triangle covers a pixel of the rasterization,
+        // the triangles smaller than a pixel in all the cameras keep the visibilities of their vertices
+        const StaticVector<int>* rasterizedCams = (trisCams != nullptr) ? (*trisCams)[triangleId] : nullptr;
+
         // Select the N best views for texturing
         Point3d triangleNormal;
         Point3d triangleCenter;
@@ -343,6 +413,10 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
             if(texParams.forceVisibleByAllVertices && verticesSupport < 3)
                 continue;
 
+            // occluded by the mesh (the cameras are sorted)
+            if(rasterizedCams != nullptr && !std::binary_search(rasterizedCams->begin(), rasterizedCams->end(), camId))
+                continue;
+
             if (texParams.angleHardThreshold != 0.0)
             {
                 const Point3d vecPointToCam = (mp.CArr[camId] - triangleCenter).normalize();
@@ -393,191 +467,319 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
             camTriangles[camId].push_back(triangleId);
         }
     }
+}
 
-    ALICEVISION_LOG_INFO("Reading pixel color.");
+void Texturing::accumulateTrianglesColors(const mvsUtils::MultiViewParams& mp, int camId,
+                                          const std::vector<unsigned int>& triangles,
+                                          mvsUtils::ImagesCache& imageCache,
+                                          unsigned int rowFrom, unsigned int rowTo, unsigned int tileRowFrom,
+                                          std::vector<AccuColor>& tileColors) const
+{
+    const int texSide = static_cast<int>(texParams.textureSide);
+    // texture rows [rowFrom, rowTo) are the triangle pixels rows [texSide - rowTo, texSide - rowFrom) (inverted Y axis)
+    const int yFrom = texSide - static_cast<int>(rowTo);
+    const int yTo = texSide - static_cast<int>(rowFrom);
 
-    std::vector<AccuColor> perPixelColors(textureSize);
+    const mvsUtils::ImagesCache::ImgSharedPtr img = imageCache.getImg_sync(camId);
 
-    // iterate over triangles for each camera
-    int camId = 0;
-    for(const std::vector<unsigned int>& triangles : camTriangles)
+    for(const unsigned int triangleId : triangles)
     {
-        ALICEVISION_LOG_INFO(" - camera " << camId + 1 << "/" << mp.ncams << " (" << triangles.size() << " triangles)");
+        // retrieve triangle 3D and UV coordinates
+        Point2d triPixs[3];
+        Point3d triPts[3];
 
-        imageCache.refreshData(camId);
-        #pragma omp parallel for
-        for(int ti = 0; ti < triangles.size(); ++ti)
+        for(int k = 0; k < 3; k++)
         {
-            const unsigned int triangleId = triangles[ti];
-            // retrieve triangle 3D and UV coordinates
-            Point2d triPixs[3];
-            Point3d triPts[3];
+            const int pointIndex = (*me->tris)[triangleId].v[k];
+            triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
+            const int uvPointIndex = trisUvIds[triangleId].m[k];
+            triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
+        }
 
-            for(int k = 0; k < 3; k++)
+        // compute triangle bounding box in pixel indexes
+        // min values: floor(value)
+        // max values: ceil(value)
+        Pixel LU, RD;
+        LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+        LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+        RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+        RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+
+        // sanity check: clamp values to [0; textureSide]
+        LU.x = clamp(LU.x, 0, texSide);
+        LU.y = clamp(LU.y, 0, texSide);
+        RD.x = clamp(RD.x, 0, texSide);
+        RD.y = clamp(RD.y, 0, texSide);
+
+        // only the rows of the chunk
+        LU.y = std::max(LU.y, yFrom);
+        RD.y = std::min(RD.y, yTo);
+
+        // iterate over bounding box's pixels
+        for(int y = LU.y; y < RD.y; y++)
+        {
+            for(int x = LU.x; x < RD.x; x++)
             {
-                const int pointIndex = (*me->tris)[triangleId].v[k];
-                triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
-                const int uvPointIndex = trisUvIds[triangleId].m[k];
-                triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
+                Pixel pix(x, y); // top-left corner of the pixel
+                Point2d barycCoords;
+
+                // test if the pixel is inside triangle
+                // and retrieve its barycentric coordinates
+                if(!isPixelInTriangle(triPixs, pix, barycCoords))
+                {
+                    continue;
+                }
+
+                // remap 'y' to image coordinates system (inverted Y axis)
+                const unsigned int y_ = (texParams.textureSide - 1) - y;
+                // 1D pixel index in the tile
+                const std::size_t xyoffset = static_cast<std::size_t>(y_ - tileRowFrom) * texParams.textureSide + x;
+                // get 3D coordinates
+                Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
+                // get 2D coordinates in source image
+                Point2d pixRC;
+                mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
+                // exclude out of bounds pixels
+                if(!mp.isPixelInImage(pixRC, camId))
+                    continue;
+                Color color = img->getPixelValueInterpolated(&pixRC);
+                // If the color is pure zero, we consider it as an invalid pixel.
+                // After correction of radial distortion, some pixels are invalid.
+                // TODO: use an alpha channel instead.
+                if(color == Color(0.f, 0.f, 0.f))
+                    continue;
+                // fill the accumulated color map for this pixel
+                tileColors[xyoffset] += color;
             }
+        }
+    }
+}
+
+void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp, const std::vector<size_t>& atlasIDs,
+                                 mvsUtils::ImagesCache& imageCache, const StaticVector<StaticVector<int>*>* trisCams,
+                                 const bfs::path& outPath, EImageFileType textureFileType)
+{
+    for(size_t atlasID : atlasIDs)
+    {
+        if(atlasID >= _atlases.size())
+            throw std::runtime_error("Invalid atlas ID " + std::to_string(atlasID));
+    }
+
+    const int nbAtlases = static_cast<int>(atlasIDs.size());
+    const unsigned int textureSide = texParams.textureSide;
+    const std::size_t textureSize = static_cast<std::size_t>(textureSide) * textureSide;
+
+    // number of texture rows accumulated at once, bounded by the memory budget
+    const std::size_t memoryBudget = getMemoryBudget();
+    const std::size_t atlasMemorySize = getAtlasMemorySize(0);
+    const std::size_t rowMemorySize = getAtlasMemorySize(1) - atlasMemorySize;
+    std::size_t maxTileRows = 0;
+    if(memoryBudget > nbAtlases * atlasMemorySize)
+        maxTileRows = (memoryBudget - nbAtlases * atlasMemorySize) / (nbAtlases * rowMemorySize);
+    const unsigned int tileRows = std::min(textureSide, std::max(textureChunkRows, static_cast<unsigned int>(
+                                      std::min<std::size_t>(textureSide, maxTileRows) / textureChunkRows * textureChunkRows)));
+    const unsigned int nbTiles = (textureSide + tileRows - 1) / tileRows;
+
+    if(maxTileRows < textureChunkRows)
+        ALICEVISION_LOG_WARNING("The texturing memory budget (" << memoryBudget / (1024 * 1024) << " MB) is too small, "
+                                "it will use about " << (nbAtlases * getAtlasMemorySize(tileRows)) / (1024 * 1024) << " MB.");
+
+    std::vector<std::vector<std::vector<unsigned int>>> camTriangles(nbAtlases);
+    std::vector<std::vector<Color>> colorBuffers(nbAtlases);
+    std::vector<std::vector<unsigned char>> validPixels(nbAtlases);
+    std::vector<std::vector<AccuColor>> tileColors(nbAtlases);
+
+    for(int a = 0; a < nbAtlases; ++a)
+    {
+        ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasIDs[a] + 1 << "/" << _atlases.size()
+                  << " (" << _atlases[atlasIDs[a]].size() << " triangles).");
+    }
 
-            // compute triangle bounding box in pixel indexes
-            // min values: floor(value)
-            // max values: ceil(value)
-            Pixel LU, RD;
-            LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-            RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-
-            // sanity check: clamp values to [0; textureSide]
-            int texSide = static_cast<int>(texParams.textureSide);
-            LU.x = clamp(LU.x, 0, texSide);
-            LU.y = clamp(LU.y, 0, texSide);
-            RD.x = clamp(RD.x, 0, texSide);
-            RD.y = clamp(RD.y, 0, texSide);
-
-            // iterate over bounding box's pixels
-            for(int y = LU.y; y < RD.y; y++)
+    #pragma omp parallel for
+    for(int a = 0; a < nbAtlases; ++a)
+    {
+        selectTrianglesCameras(mp, atlasIDs[a], trisCams, camTriangles[a]);
+        colorBuffers[a].resize(textureSize);
+        validPixels[a].resize(textureSize, 0);
+    }
+
+    // the cameras are read in the same order for each tile: load the next images in the background
+    std::vector<int> accessPlan;
+    for(unsigned int tile = 0; tile < nbTiles; ++tile)
+    {
+        for(int camId = 0; camId < mp.ncams; ++camId)
+        {
+            for(int a = 0; a < nbAtlases; ++a)
             {
-                for(int x = LU.x; x < RD.x; x++)
+                if(!camTriangles[a][camId].empty())
                 {
-                    Pixel pix(x, y); // top-left corner of the pixel
-                    Point2d barycCoords;
+                    accessPlan.push_back(camId);
+                    break;
+                }
+            }
+        }
+    }
+    imageCache.setAccessPlan(accessPlan, texParams.nbPrefetchedImages);
 
-                    // test if the pixel is inside triangle
-                    // and retrieve its barycentric coordinates
-                    if(!isPixelInTriangle(triPixs, pix, barycCoords))
-                    {
-                        continue;
-                    }
+    ALICEVISION_LOG_INFO("Reading pixel color (" << nbTiles << " tile(s) of " << tileRows << " rows).");
 
-                    // remap 'y' to image coordinates system (inverted Y axis)
-                    const unsigned int y_ = (texParams.textureSide - 1) - y;
-                    // 1D pixel index
-                    unsigned int xyoffset = y_ * texParams.textureSide + x;
-                    // get 3D coordinates
-                    Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
-                    // get 2D coordinates in source image
-                    Point2d pixRC;
-                    mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
-                    // exclude out of bounds pixels
-                    if(!mp.isPixelInImage(pixRC, camId))
-                        continue;
-                    Color color = imageCache.getPixelValueInterpolated(&pixRC, camId);
-                    // If the color is pure zero, we consider it as an invalid pixel.
-                    // After correction of radial distortion, some pixels are invalid.
-                    // TODO: use an alpha channel instead.
-                    if(color == Color(0.f, 0.f, 0.f))
-                        continue;
-                    // fill the accumulated color map for this pixel
-                    perPixelColors[xyoffset] += color;
-                    // fill the colorID map
-                    colorIDs[xyoffset] = xyoffset;
-                }
+    // a unit of work: rows [rowFrom, rowTo) of an atlas
+    struct TextureChunk
+    {
+        int atlas;
+        unsigned int rowFrom;
+        unsigned int rowTo;
+    };
+
+    for(unsigned int tile = 0; tile < nbTiles; ++tile)
+    {
+        const unsigned int tileRowFrom = tile * tileRows;
+        const unsigned int tileRowTo = std::min(textureSide, tileRowFrom + tileRows);
+
+        for(int a = 0; a < nbAtlases; ++a)
+            tileColors[a].assign(static_cast<std::size_t>(tileRowTo - tileRowFrom) * textureSide, AccuColor());
+
+        // iterate over triangles for each camera,
+        // the colors of a pixel are accumulated in the same order (cameras, then triangles) whatever the number of threads
+        for(int camId = 0; camId < mp.ncams; ++camId)
+        {
+            std::vector<TextureChunk> chunks;
+            for(int a = 0; a < nbAtlases; ++a)
+            {
+                if(camTriangles[a][camId].empty())
+                    continue;
+                for(unsigned int rowFrom = tileRowFrom; rowFrom < tileRowTo; rowFrom += textureChunkRows)
+                    chunks.push_back({a, rowFrom, std::min(tileRowTo, rowFrom + textureChunkRows)});
+            }
+            if(chunks.empty())
+                continue;
+
+            ALICEVISION_LOG_DEBUG(" - camera " << camId + 1 << "/" << mp.ncams << " (" << chunks.size() << " chunks)");
+
+            #pragma omp parallel for schedule(dynamic)
+            for(int c = 0; c < static_cast<int>(chunks.size()); ++c)
+            {
+                const TextureChunk& chunk = chunks[c];
+                accumulateTrianglesColors(mp, camId, camTriangles[chunk.atlas][camId], imageCache, chunk.rowFrom,
+                                          chunk.rowTo, tileRowFrom, tileColors[chunk.atlas]);
+            }
+        }
+
+        // final (average) color of the tile pixels
+        #pragma omp parallel for
+        for(int a = 0; a < nbAtlases; ++a)
+        {
+            const std::size_t tileOffset = static_cast<std::size_t>(tileRowFrom) * textureSide;
+            for(std::size_t i = 0; i < tileColors[a].size(); ++i)
+            {
+                const AccuColor& accuColor = tileColors[a][i];
+                if(accuColor.count == 0)
+                    continue;
+                colorBuffers[a][tileOffset + i] = accuColor.average();
+                validPixels[a][tileOffset + i] = 1;
             }
         }
-        // increment current cam index
-        camId++;
     }
+    tileColors.clear();
     camTriangles.clear();
 
+    #pragma omp parallel for
+    for(int a = 0; a < nbAtlases; ++a)
+    {
+        writeTexture(atlasIDs[a], colorBuffers[a], validPixels[a], outPath, textureFileType);
+        colorBuffers[a].clear();
+        colorBuffers[a].shrink_to_fit();
+        validPixels[a].clear();
+        validPixels[a].shrink_to_fit();
+    }
+}
+
+void Texturing::writeTexture(size_t atlasID, std::vector<Color>& colorBuffer, std::vector<unsigned char>& validPixels,
+                             const bfs::path& outPath, EImageFileType textureFileType) const
+{
+    const unsigned int textureSide = texParams.textureSide;
+
     if(!texParams.fillHoles && texParams.padding > 0)
     {
         ALICEVISION_LOG_INFO("Edge padding (" << texParams.padding << " pixels).");
         // edge padding (dilate gutter)
+        // pixels filled in a pass are marked with 2 and are only used as source in the next passes
         for(unsigned int g = 0; g < texParams.padding; ++g)
         {
-            for(unsigned int y = 1; y < texParams.textureSide-1; ++y)
+            for(unsigned int y = 1; y < textureSide-1; ++y)
             {
-                unsigned int yoffset = y * texParams.textureSide;
-                for(unsigned int x = 1; x < texParams.textureSide-1; ++x)
+                unsigned int yoffset = y * textureSide;
+                for(unsigned int x = 1; x < textureSide-1; ++x)
                 {
                     unsigned int xyoffset = yoffset + x;
-                    if(colorIDs[xyoffset] > 0)
+                    if(validPixels[xyoffset] != 0)
                         continue;
-                    else if(colorIDs[xyoffset-1] > 0)
-                    {
-                        colorIDs[xyoffset] = (xyoffset-1)*-1;
-                    }
-                    else if(colorIDs[xyoffset+1] > 0)
-                    {
-                        colorIDs[xyoffset] = (xyoffset+1)*-1;
-                    }
-                    else if(colorIDs[xyoffset+texParams.textureSide] > 0)
-                    {
-                        colorIDs[xyoffset] = (xyoffset+texParams.textureSide)*-1;
-                    }
-                    else if(colorIDs[xyoffset-texParams.textureSide] > 0)
-                    {
-                        colorIDs[xyoffset] = (xyoffset-texParams.textureSide)*-1;
-                    }
+                    unsigned int sourceOffset;
+                    if(validPixels[xyoffset-1] == 1)
+                        sourceOffset = xyoffset-1;
+                    else if(validPixels[xyoffset+1] == 1)
+                        sourceOffset = xyoffset+1;
+                    else if(validPixels[xyoffset+textureSide] == 1)
+                        sourceOffset = xyoffset+textureSide;
+                    else if(validPixels[xyoffset-textureSide] == 1)
+                        sourceOffset = xyoffset-textureSide;
+                    else
+                        continue;
+                    colorBuffer[xyoffset] = colorBuffer[sourceOffset];
+                    validPixels[xyoffset] = 2;
                 }
             }
-            for(unsigned int i=0; i < textureSize; ++i)
+            for(std::size_t i = 0; i < validPixels.size(); ++i)
             {
-                if(colorIDs[i] < 0)
-                    colorIDs[i] = colorIDs[colorIDs[i]*-1];
+                if(validPixels[i] == 2)
+                    validPixels[i] = 1;
             }
-        }
-    }
-
-    ALICEVISION_LOG_INFO("Computing final (average) color.");
-
-    // save texture image
-    std::vector<Color> colorBuffer(texParams.textureSide * texParams.textureSide);
-    std::vector<float> alphaBuffer;
-    if(texParams.fillHoles)
-        alphaBuffer.resize(colorBuffer.size(), 0.0f);
-
-    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
-    {
-        unsigned int yoffset = yp * texParams.textureSide;
-        for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
-        {
-            unsigned int xyoffset = yoffset + xp;
-            int colorID = colorIDs[xyoffset];
-            Color color;
-            if(colorID >= 0)
+            // same output as the previous color ids based padding,
+            // where the empty pixels (id -1) were resolved to the id of the pixel 1
+            if(validPixels[1] == 1)
             {
-                color = perPixelColors[colorID].average();
-                if(texParams.fillHoles)
-                    alphaBuffer[xyoffset] = 1.0f;
+                for(std::size_t i = 0; i < validPixels.size(); ++i)
+                {
+                    if(validPixels[i] == 0)
+                    {
+                        colorBuffer[i] = colorBuffer[1];
+                        validPixels[i] = 1;
+                    }
+                }
             }
-            colorBuffer[xyoffset] = color;
         }
     }
 
-    perPixelColors.clear();
-    colorIDs.clear();
-
     std::string textureName = "texture_" + std::to_string(atlasID) + "." + EImageFileType_enumToString(textureFileType);
     bfs::path texturePath = outPath / textureName;
     ALICEVISION_LOG_INFO("Writing texture file: " << texturePath.string());
 
-    unsigned int outTextureSide = texParams.textureSide;
+    unsigned int outTextureSide = textureSide;
 
     // texture holes filling
     if(texParams.fillHoles)
     {
         ALICEVISION_LOG_INFO("Filling texture holes.");
-        imageIO::fillHoles(texParams.textureSide, texParams.textureSide, colorBuffer, alphaBuffer);
-        alphaBuffer.clear();
+        std::vector<float> alphaBuffer(validPixels.size());
+        for(std::size_t i = 0; i < validPixels.size(); ++i)
+            alphaBuffer[i] = validPixels[i] ? 1.0f : 0.0f;
+        validPixels.clear();
+        validPixels.shrink_to_fit();
+        imageIO::fillHoles(textureSide, textureSide, colorBuffer, alphaBuffer);
     }
     // downscale texture if required
     if(texParams.downscale > 1)
     {
         std::vector<Color> resizedColorBuffer;
-        outTextureSide = texParams.textureSide / texParams.downscale;
+        outTextureSide = textureSide / texParams.downscale;
 
         ALICEVISION_LOG_INFO("Downscaling texture (" << texParams.downscale << "x).");
-        imageIO::resizeImage(texParams.textureSide, texParams.textureSide, texParams.downscale, colorBuffer, resizedColorBuffer);
+        imageIO::resizeImage(textureSide, textureSide, texParams.downscale, colorBuffer, resizedColorBuffer);
         std::swap(resizedColorBuffer, colorBuffer);
     }
     imageIO::writeImage(texturePath.string(), outTextureSide, outTextureSide, colorBuffer);
 }
 
-
 void Texturing::clear()
 {
     trisMtlIds.clear();
@@ -593,6 +795,7 @@ void Texturing::clear()
         pointsVisibilities = nullptr;
     }
 
+    clearTrisCams();
     delete me;
     me = nullptr;
 }
@@ -636,7 +839,7 @@ void Texturing::loadFromMeshing(const std::string& meshFilepath, const std::stri
         throw std::runtime_error("Error: Reference mesh and associated visibilities don't have the same size.");
 }
 
-void Texturing::replaceMesh(const std::string& otherMeshPath, bool flipNormals)
+void Texturing::replaceMesh(const mvsUtils::MultiViewParams& mp, const std::string& otherMeshPath, bool flipNormals)
 {
     // keep previous mesh/visibilities as reference
     Mesh* refMesh = me;
@@ -653,6 +856,8 @@ void Texturing::replaceMesh(const std::string& otherMeshPath, bool flipNormals)
         remapMeshVisibilities_pullVerticesVisibility(*refMesh, *refVisibilities, *me, *pointsVisibilities);
     if (texParams.visibilityRemappingMethod & EVisibilityRemappingMethod::Push)
         remapMeshVisibilities_pushVerticesVisibilityToTriangles(*refMesh, *refVisibilities, *me, *pointsVisibilities);
+    if(texParams.visibilityRemappingMethod & EVisibilityRemappingMethod::RayCast)
+        remapMeshVisibilities_rayCast(*refMesh, *refVisibilities, *me, mp, *pointsVisibilities);
     if(pointsVisibilities->empty())
         throw std::runtime_error("No visibility after visibility remapping.");
 
@@ -694,7 +899,7 @@ void Texturing::unwrap(mvsUtils::MultiViewParams& mp, EUnwrapMethod method)
         // save temp mesh with UVs
         GEO::mesh_save(mesh, tmpObjPath);
         // replace initial mesh
-        replaceMesh(tmpObjPath);
+        replaceMesh(mp, tmpObjPath);
         // remove temp mesh
         bfs::remove(tmpObjPath);
     }
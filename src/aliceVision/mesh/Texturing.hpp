@@ -53,7 +53,8 @@ std::string EUnwrapMethod_enumToString(EUnwrapMethod method);
 enum EVisibilityRemappingMethod {
     Pull = 1,    //< For each vertex of the input mesh, pull the visibilities from the closest vertex in the reconstruction.
     Push = 2,    //< For each vertex of the reconstruction, push the visibilities to the closest triangle in the input mesh.
-    PullPush = Pull | Push  //< Combine results from Pull and Push results.
+    PullPush = Pull | Push,  //< Combine results from Pull and Push results.
+    RayCast = 4  //< For each vertex of the input mesh, cast rays from the cameras of the closest vertex in the reconstruction and keep the ones facing the vertex without occlusion by the input mesh.
 };
 
 ALICEVISION_BITMASK(EVisibilityRemappingMethod);
@@ -68,14 +69,19 @@ struct TexturingParams
     double bestScoreThreshold = 0.0; //< 0.0 to disable filtering based on threshold to relative best score
     double angleHardThreshold = 90.0; //< 0.0 to disable angle hard threshold filtering
     bool forceVisibleByAllVertices = false; //< triangle visibility is based on the union of vertices visiblity
+    bool discardOccludedCameras = false; //< discard the cameras where the triangle is hidden by the mesh (z-buffer rasterization)
     EVisibilityRemappingMethod visibilityRemappingMethod = EVisibilityRemappingMethod::PullPush;
 
     unsigned int textureSide = 8192;
     unsigned int padding = 15;
     unsigned int downscale = 2;
     bool fillHoles = false;
+    unsigned int maxMemoryMB = 0; //< memory budget for the texture buffers (0: half of the available memory)
+    int nbPrefetchedImages = 2; //< number of camera images loaded in advance
 };
 
+struct AccuColor;
+
 struct Texturing
 {
     TexturingParams texParams;
@@ -96,6 +102,7 @@ struct Texturing
     {
         if(pointsVisibilities != nullptr)
             deleteArrayOfArrays<int>(&pointsVisibilities);
+        clearTrisCams();
         delete me;
     }
 
@@ -119,10 +126,11 @@ public:
      * @brief Replace inner mesh with the mesh loaded from 'otherMeshPath'
      *        and remap visibilities from the first to the second
      *
+     * @param mp the multi-view parameters, for the ray casting visibility remapping
      * @param otherMeshPath the mesh to load
      * @param flipNormals whether to flip normals when loading the mesh
      */
-    void replaceMesh(const std::string& otherMeshPath, bool flipNormals=false);
+    void replaceMesh(const mvsUtils::MultiViewParams& mp, const std::string& otherMeshPath, bool flipNormals=false);
 
     /// Returns whether UV coordinates are available
     inline bool hasUVs() const { return !uvCoords.empty(); }
@@ -152,8 +160,61 @@ public:
                          size_t atlasID, mvsUtils::ImagesCache& imageCache,
                          const bfs::path &outPath, EImageFileType textureFileType = EImageFileType::PNG);
 
+    /**
+     * @brief Generate texture files for the given texture atlases at the same time.
+     *
+     * The atlases are filled by tiles of rows bounded by the memory budget (texParams.maxMemoryMB),
+     * each camera image is read once per tile for all the atlases.
+     * The result does not depend on the number of threads.
+     */
+    void generateTextures(const mvsUtils::MultiViewParams& mp,
+                          const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache,
+                          const bfs::path &outPath, EImageFileType textureFileType = EImageFileType::PNG);
+
     /// Save textured mesh as an OBJ + MTL file
     void saveAsOBJ(const bfs::path& dir, const std::string& basename, EImageFileType textureFileType = EImageFileType::PNG);
+
+private:
+
+    /// Memory budget for the texture buffers in bytes
+    std::size_t getMemoryBudget() const;
+
+    /// Memory used to generate one texture atlas with the given number of rows in a tile
+    std::size_t getAtlasMemorySize(std::size_t nbTileRows) const;
+
+    /**
+     * @brief Cameras seeing each triangle in the rasterization of the mesh if texParams.discardOccludedCameras, nullptr otherwise.
+     *        The rasterization is computed on the first call and kept until the mesh changes.
+     */
+    const StaticVector<StaticVector<int>*>* getTrisCams(const mvsUtils::MultiViewParams& mp);
+
+    /// Release the cameras of the triangles, to recompute them for a new mesh
+    void clearTrisCams();
+
+    /// Generate texture files for the given texture atlases, with the cameras of each triangle from getTrisCams
+    void generateTextures(const mvsUtils::MultiViewParams& mp,
+                          const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache,
+                          const StaticVector<StaticVector<int>*>* trisCams,
+                          const bfs::path &outPath, EImageFileType textureFileType);
+
+    /// Select the cameras used to texture each triangle of the atlas (triangles per camera),
+    /// among the cameras of the triangle in trisCams if not null
+    void selectTrianglesCameras(const mvsUtils::MultiViewParams& mp, size_t atlasID,
+                                const StaticVector<StaticVector<int>*>* trisCams,
+                                std::vector<std::vector<unsigned int>>& camTriangles);
+
+    /// Accumulate the colors of the triangles in camera camId for the texture rows [rowFrom, rowTo)
+    void accumulateTrianglesColors(const mvsUtils::MultiViewParams& mp, int camId,
+                                   const std::vector<unsigned int>& triangles, mvsUtils::ImagesCache& imageCache,
+                                   unsigned int rowFrom, unsigned int rowTo, unsigned int tileRowFrom,
+                                   std::vector<AccuColor>& tileColors) const;
+
+    /// Edge padding or holes filling, downscale and write the texture file
+    void writeTexture(size_t atlasID, std::vector<Color>& colorBuffer, std::vector<unsigned char>& validPixels,
+                      const bfs::path& outPath, EImageFileType textureFileType) const;
+
+    /// cameras seeing each triangle of the mesh, computed by getTrisCams
+    StaticVector<StaticVector<int>*>* _trisCams = nullptr;
 };
 
 } // namespace mesh
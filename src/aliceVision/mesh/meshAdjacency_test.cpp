@@ -0,0 +1,266 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/mesh/Mesh.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <utility>
+#include <vector>
+
+#define BOOST_TEST_MODULE meshAdjacency
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+// Test summary:
+// - Build the connectivity of a regular grid mesh (neighbor triangles and points of the vertices, edges)
+// - Check it against the expected grid connectivity
+// - Compare the build time and the memory of the neighbor triangles with the array of arrays representation
+
+namespace {
+
+/**
+ * @brief Create a regular grid mesh of size x size vertices, with two triangles per cell.
+ *        The triangles are shuffled so that the neighbors are not ordered.
+ */
+void createGridMesh(Mesh& mesh, int size)
+{
+    mesh.pts = new StaticVector<Point3d>();
+    mesh.tris = new StaticVector<Mesh::triangle>();
+    mesh.pts->reserve(size * size);
+    mesh.tris->reserve(2 * (size - 1) * (size - 1));
+
+    for(int y = 0; y < size; ++y)
+        for(int x = 0; x < size; ++x)
+            mesh.pts->push_back(Point3d(x, y, 0.1 * ((x * y) % 7)));
+
+    for(int y = 0; y < size - 1; ++y)
+    {
+        for(int x = 0; x < size - 1; ++x)
+        {
+            const int a = y * size + x;
+            mesh.tris->push_back(Mesh::triangle(a, a + 1, a + size + 1));
+            mesh.tris->push_back(Mesh::triangle(a, a + size + 1, a + size));
+        }
+    }
+
+    std::srand(0);
+    for(int i = mesh.tris->size() - 1; i > 0; --i)
+        std::swap((*mesh.tris)[i], (*mesh.tris)[std::rand() % (i + 1)]);
+}
+
+/**
+ * @brief Array of arrays of the neighbor triangles of each vertex,
+ *        built with one heap allocation per vertex as before the CSR representation.
+ */
+StaticVector<StaticVector<int>*>* getPtsNeighborTrianglesArrayOfArrays(const Mesh& mesh)
+{
+    StaticVector<StaticVector<int>*>* out = new StaticVector<StaticVector<int>*>();
+    out->resize_with(mesh.pts->size(), nullptr);
+
+    for(int i = 0; i < mesh.tris->size(); ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            StaticVector<int>*& ptNeighTris = (*out)[(*mesh.tris)[i].v[k]];
+            if(ptNeighTris == nullptr)
+                ptNeighTris = new StaticVector<int>();
+            ptNeighTris->push_back(i);
+        }
+    }
+    return out;
+}
+
+std::size_t arrayOfArraysMemorySize(StaticVector<StaticVector<int>*>* arrays)
+{
+    std::size_t memorySize = arrays->capacity() * sizeof(StaticVector<int>*);
+    for(int i = 0; i < arrays->size(); ++i)
+    {
+        if((*arrays)[i] != nullptr)
+            memorySize += sizeof(StaticVector<int>) + (*arrays)[i]->capacity() * sizeof(int);
+    }
+    return memorySize;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MeshAdjacency_grid)
+{
+    const int size = 32;
+    Mesh mesh;
+    createGridMesh(mesh, size);
+
+    // neighbor triangles of the vertices
+    Adjacency ptsNeighTris;
+    mesh.getPtsNeighborTriangles(ptsNeighTris);
+
+    BOOST_CHECK_EQUAL(ptsNeighTris.size(), mesh.pts->size());
+    BOOST_CHECK_EQUAL(ptsNeighTris.nbValues(), 3 * mesh.tris->size());
+    BOOST_CHECK_EQUAL(ptsNeighTris.size(0), 2);
+    BOOST_CHECK_EQUAL(ptsNeighTris.size(size + 1), 6);
+
+    for(int ptId = 0; ptId < mesh.pts->size(); ++ptId)
+    {
+        BOOST_CHECK(std::is_sorted(ptsNeighTris.begin(ptId), ptsNeighTris.end(ptId)));
+        BOOST_CHECK(std::adjacent_find(ptsNeighTris.begin(ptId), ptsNeighTris.end(ptId)) == ptsNeighTris.end(ptId));
+        for(int j = 0; j < ptsNeighTris.size(ptId); ++j)
+        {
+            const Mesh::triangle& t = (*mesh.tris)[ptsNeighTris(ptId, j)];
+            BOOST_CHECK(t.v[0] == ptId || t.v[1] == ptId || t.v[2] == ptId);
+        }
+    }
+
+    // neighbor points of the vertices
+    Adjacency ptsNeighPts;
+    mesh.getPtsNeighPtsOrdered(ptsNeighTris, ptsNeighPts);
+
+    BOOST_CHECK_EQUAL(ptsNeighPts.size(), mesh.pts->size());
+
+    for(int y = 1; y < size - 1; ++y)
+    {
+        for(int x = 1; x < size - 1; ++x)
+        {
+            const int ptId = y * size + x;
+            const std::set<int> neighPts(ptsNeighPts.begin(ptId), ptsNeighPts.end(ptId));
+            const std::set<int> expected = {ptId - size - 1, ptId - size, ptId - 1, ptId + 1, ptId + size, ptId + size + 1};
+            BOOST_CHECK(neighPts == expected);
+            BOOST_CHECK_EQUAL(ptsNeighPts.size(ptId), 6);
+
+            // consecutive neighbors are connected
+            for(int j = 0; j < 6; ++j)
+            {
+                const int a = ptsNeighPts(ptId, j);
+                const int b = ptsNeighPts(ptId, (j + 1) % 6);
+                BOOST_CHECK(std::abs(a % size - b % size) <= 1 && std::abs(a / size - b / size) <= 1);
+            }
+        }
+    }
+
+    // the neighbors of the boundary vertices go from one boundary vertex to the other
+    for(int ptId = 0; ptId < mesh.pts->size(); ++ptId)
+    {
+        const int x = ptId % size;
+        const int y = ptId / size;
+        const auto isBoundary = [size](int i) { return i % size == 0 || i % size == size - 1 || i / size == 0 || i / size == size - 1; };
+        if(!isBoundary(ptId))
+            continue;
+
+        const int nbNeighPts = ptsNeighPts.size(ptId);
+        BOOST_CHECK_EQUAL(nbNeighPts, ptsNeighTris.size(ptId) + 1);
+        BOOST_CHECK(isBoundary(ptsNeighPts(ptId, 0)));
+        BOOST_CHECK(isBoundary(ptsNeighPts(ptId, nbNeighPts - 1)));
+
+        for(int j = 0; j < nbNeighPts; ++j)
+        {
+            const int a = ptsNeighPts(ptId, j);
+            BOOST_CHECK(std::abs(a % size - x) <= 1 && std::abs(a / size - y) <= 1 && a != ptId);
+            if(j + 1 < nbNeighPts)
+            {
+                const int b = ptsNeighPts(ptId, j + 1);
+                BOOST_CHECK(std::abs(a % size - b % size) <= 1 && std::abs(a / size - b / size) <= 1);
+            }
+        }
+    }
+
+    // edges
+    Adjacency edgesNeighTris;
+    StaticVector<Pixel> edgesPointsPairs;
+    mesh.getNotOrientedEdges(edgesNeighTris, edgesPointsPairs);
+
+    const int nbEdges = 3 * (size - 1) * (size - 1) + 2 * (size - 1);
+    BOOST_CHECK_EQUAL(edgesNeighTris.size(), nbEdges);
+    BOOST_CHECK_EQUAL(edgesPointsPairs.size(), nbEdges);
+    BOOST_CHECK_EQUAL(edgesNeighTris.nbValues(), 3 * mesh.tris->size());
+
+    int nbBoundaryEdges = 0;
+    for(int i = 0; i < edgesNeighTris.size(); ++i)
+    {
+        const Pixel& edge = edgesPointsPairs[i];
+        BOOST_CHECK_LT(edge.x, edge.y);
+        if(i > 0)
+            BOOST_CHECK(std::make_pair(edgesPointsPairs[i - 1].x, edgesPointsPairs[i - 1].y) < std::make_pair(edge.x, edge.y));
+
+        nbBoundaryEdges += static_cast<int>(edgesNeighTris.size(i) == 1);
+        BOOST_CHECK(edgesNeighTris.size(i) == 1 || edgesNeighTris.size(i) == 2);
+
+        for(int j = 0; j < edgesNeighTris.size(i); ++j)
+        {
+            const Mesh::triangle& t = (*mesh.tris)[edgesNeighTris(i, j)];
+            BOOST_CHECK(t.v[0] == edge.x || t.v[1] == edge.x || t.v[2] == edge.x);
+            BOOST_CHECK(t.v[0] == edge.y || t.v[1] == edge.y || t.v[2] == edge.y);
+        }
+    }
+    BOOST_CHECK_EQUAL(nbBoundaryEdges, 4 * (size - 1));
+
+    // each triangle has three edges
+    StaticVector<Voxel>* trisEdges = mesh.getTrianglesEdgesIds(edgesNeighTris);
+    for(int i = 0; i < trisEdges->size(); ++i)
+        BOOST_CHECK((*trisEdges)[i].x >= 0 && (*trisEdges)[i].y >= 0 && (*trisEdges)[i].z >= 0);
+    delete trisEdges;
+
+    // normals of the vertices
+    StaticVector<Point3d>* normals = mesh.computeNormalsForPts(ptsNeighTris);
+    BOOST_CHECK_EQUAL(normals->size(), mesh.pts->size());
+    for(int i = 0; i < normals->size(); ++i)
+        BOOST_CHECK_CLOSE((*normals)[i].size(), 1.0, 1e-3);
+    delete normals;
+}
+
+BOOST_AUTO_TEST_CASE(MeshAdjacency_benchmark)
+{
+    const int size = 1024;
+    Mesh mesh;
+    createGridMesh(mesh, size);
+
+    system::Timer timer;
+    StaticVector<StaticVector<int>*>* arrays = getPtsNeighborTrianglesArrayOfArrays(mesh);
+    const double arraysTime = timer.elapsedMs();
+    const std::size_t arraysMemory = arrayOfArraysMemorySize(arrays);
+
+    timer.reset();
+    Adjacency ptsNeighTris;
+    mesh.getPtsNeighborTriangles(ptsNeighTris);
+    const double adjacencyTime = timer.elapsedMs();
+
+    ALICEVISION_LOG_INFO("Neighbor triangles of " << mesh.pts->size() << " vertices:" << std::endl
+                         << "\t- array of arrays: " << arraysTime << " ms, " << arraysMemory / (1024 * 1024) << " MB" << std::endl
+                         << "\t- CSR: " << adjacencyTime << " ms, " << ptsNeighTris.memorySize() / (1024 * 1024) << " MB");
+
+    BOOST_CHECK_LT(ptsNeighTris.memorySize(), arraysMemory);
+
+    // same neighbor triangles in both representations
+    BOOST_REQUIRE_EQUAL(ptsNeighTris.size(), arrays->size());
+    for(int ptId = 0; ptId < arrays->size(); ++ptId)
+    {
+        std::vector<int> neighTris((*arrays)[ptId]->begin(), (*arrays)[ptId]->end());
+        std::sort(neighTris.begin(), neighTris.end());
+        BOOST_CHECK(std::equal(neighTris.begin(), neighTris.end(), ptsNeighTris.begin(ptId), ptsNeighTris.end(ptId)));
+    }
+    deleteArrayOfArrays<int>(&arrays);
+
+    timer.reset();
+    Adjacency ptsNeighPts;
+    mesh.getPtsNeighPtsOrdered(ptsNeighTris, ptsNeighPts);
+    const double neighPtsTime = timer.elapsedMs();
+
+    timer.reset();
+    Adjacency edgesNeighTris;
+    StaticVector<Pixel> edgesPointsPairs;
+    mesh.getNotOrientedEdges(edgesNeighTris, edgesPointsPairs);
+    const double edgesTime = timer.elapsedMs();
+
+    ALICEVISION_LOG_INFO("Ordered neighbor points: " << neighPtsTime << " ms, " << ptsNeighPts.memorySize() / (1024 * 1024) << " MB" << std::endl
+                         << "Edges: " << edgesTime << " ms, " << edgesNeighTris.memorySize() / (1024 * 1024) << " MB");
+
+    BOOST_CHECK_EQUAL(ptsNeighPts.size(), mesh.pts->size());
+    BOOST_CHECK_EQUAL(edgesNeighTris.size(), 3 * (size - 1) * (size - 1) + 2 * (size - 1));
+}
@@ -0,0 +1,172 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/mesh/MeshBVH.hpp>
+#include <aliceVision/mesh/meshTestUtils.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#define BOOST_TEST_MODULE meshBVH
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+// Test summary:
+// - Compare the nearest intersections and the occlusions of random rays with a brute force ray casting
+// - Check that the packets of rays give the same occlusions as the single rays
+// - Benchmark the occlusion throughput of single rays and packets of rays on a large mesh
+
+namespace {
+
+/**
+ * @brief Random number in [a, b].
+ */
+double randomRange(double a, double b)
+{
+    return a + (b - a) * std::rand() / static_cast<double>(RAND_MAX);
+}
+
+/**
+ * @brief Rays from a camera center above the mesh toward a grid of points on the plane z,
+ *        in the order of the tiles of tileSize x tileSize points to keep the consecutive rays coherent.
+ */
+std::vector<MeshBVH::Ray> createCameraRays(const Point3d& C, int size, double extent, double z, int tileSize)
+{
+    std::vector<MeshBVH::Ray> rays;
+    rays.reserve(size * size);
+    for(int ty = 0; ty < size; ty += tileSize)
+    {
+        for(int tx = 0; tx < size; tx += tileSize)
+        {
+            for(int y = ty; y < std::min(size, ty + tileSize); ++y)
+            {
+                for(int x = tx; x < std::min(size, tx + tileSize); ++x)
+                {
+                    const Point3d target(extent * (2.0 * x / (size - 1) - 1.0), extent * (2.0 * y / (size - 1) - 1.0), z);
+                    rays.push_back({C, target - C, 1.0});
+                }
+            }
+        }
+    }
+    return rays;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MeshBVH_intersect)
+{
+    Mesh mesh;
+    createGridMesh(mesh, 41, 3.0, 8.0, 1.0);
+
+    const MeshBVH bvh(mesh);
+    BOOST_CHECK_GT(bvh.getNbNodes(), 1);
+    BOOST_CHECK_GT(bvh.getDepth(), 0);
+
+    std::srand(1);
+    const int nbRays = 2000;
+    int nbHits = 0;
+    int nbDifferences = 0;
+    for(int i = 0; i < nbRays; ++i)
+    {
+        MeshBVH::Ray ray;
+        ray.origin = Point3d(randomRange(-4.0, 4.0), randomRange(-4.0, 4.0), randomRange(0.0, 16.0));
+        ray.direction = Point3d(randomRange(-1.0, 1.0), randomRange(-1.0, 1.0), randomRange(-1.0, 1.0));
+        ray.tMax = randomRange(1.0, 20.0);
+
+        double refT;
+        const int refTriId = rayCast(mesh, ray.origin, ray.direction, ray.tMax, refT);
+
+        double t;
+        const int triId = bvh.intersect(ray, t);
+        const bool occluded = bvh.isOccluded(ray);
+
+        BOOST_CHECK_EQUAL(occluded, triId >= 0);
+        if(refTriId >= 0)
+            ++nbHits;
+
+        // the hits on the triangle edges may differ
+        // (the BVH triangles are in single precision: compare the ray parameters with an absolute tolerance)
+        if(refTriId != triId && (refTriId < 0 || triId < 0 || std::abs(t - refT) > 1e-4))
+            ++nbDifferences;
+        else if(triId >= 0)
+            BOOST_CHECK_SMALL(t - refT, 1e-4);
+    }
+    ALICEVISION_LOG_INFO("Rays different from the brute force ray casting: " << nbDifferences << " / " << nbRays
+                         << " (" << nbHits << " hits)");
+    BOOST_CHECK_GT(nbHits, nbRays / 10);
+    BOOST_CHECK_LE(nbDifferences, nbRays / 500);
+}
+
+BOOST_AUTO_TEST_CASE(MeshBVH_packets)
+{
+    Mesh mesh;
+    createGridMesh(mesh, 41, 3.0, 8.0, 1.0);
+    const MeshBVH bvh(mesh);
+
+    // segments from the camera to the points of a plane through the bumps, some of them are occluded
+    // (odd number of rays to test an incomplete packet)
+    std::vector<MeshBVH::Ray> rays = createCameraRays(Point3d(0.5, -0.5, -2.0), 99, 3.5, 8.0, 8);
+    BOOST_CHECK_NE(rays.size() % MeshBVH::packetSize, 0);
+
+    std::unique_ptr<bool[]> occluded(new bool[rays.size()]);
+    bvh.isOccluded(rays.data(), static_cast<int>(rays.size()), occluded.get());
+
+    int nbOccluded = 0;
+    int nbDifferences = 0;
+    for(std::size_t i = 0; i < rays.size(); ++i)
+    {
+        nbOccluded += static_cast<int>(occluded[i]);
+        nbDifferences += static_cast<int>(occluded[i] != bvh.isOccluded(rays[i]));
+    }
+    BOOST_CHECK_EQUAL(nbDifferences, 0);
+    BOOST_CHECK_GT(nbOccluded, 0);
+    BOOST_CHECK_LT(nbOccluded, static_cast<int>(rays.size()));
+}
+
+BOOST_AUTO_TEST_CASE(MeshBVH_benchmark)
+{
+    // 2M triangles
+    Mesh mesh;
+    createGridMesh(mesh, 1001, 8.0, 10.0, 1.0);
+
+    system::Timer timer;
+    const MeshBVH bvh(mesh);
+    ALICEVISION_LOG_INFO("BVH of " << mesh.tris->size() << " triangles built in " << timer.elapsedMs() << " ms ("
+                         << bvh.getNbNodes() << " nodes, depth " << bvh.getDepth() << ")");
+
+    const std::vector<MeshBVH::Ray> rays = createCameraRays(Point3d(0.0, 0.0, -5.0), 1000, 8.5, 10.0, 16);
+    const int nbRays = static_cast<int>(rays.size());
+
+    timer.reset();
+    int nbOccludedSingle = 0;
+    #pragma omp parallel for reduction(+:nbOccludedSingle)
+    for(int i = 0; i < nbRays; ++i)
+        nbOccludedSingle += static_cast<int>(bvh.isOccluded(rays[i]));
+    const double singleTime = timer.elapsed();
+
+    std::unique_ptr<bool[]> occluded(new bool[nbRays]);
+    timer.reset();
+    bvh.isOccluded(rays.data(), nbRays, occluded.get());
+    const double packetTime = timer.elapsed();
+
+    int nbOccludedPacket = 0;
+    for(int i = 0; i < nbRays; ++i)
+        nbOccludedPacket += static_cast<int>(occluded[i]);
+
+    ALICEVISION_LOG_INFO("Occlusion of " << nbRays << " rays:" << std::endl
+                         << "\t- single rays: " << nbRays / singleTime << " rays/s" << std::endl
+                         << "\t- packets of " << MeshBVH::packetSize << " rays: " << nbRays / packetTime << " rays/s");
+
+    BOOST_CHECK_EQUAL(nbOccludedSingle, nbOccludedPacket);
+    BOOST_CHECK_GT(nbOccludedPacket, 0);
+}
@@ -0,0 +1,381 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "meshRasterization.hpp"
+
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/// size of the tiles rasterized by each thread (in pixels)
+const int tileSize = 64;
+/// size of the blocks of the hierarchical z-buffer (in pixels)
+const int blockSize = 8;
+const int nbBlocksPerTileSide = tileSize / blockSize;
+
+/// vertex projected in the output image
+struct ProjectedVertex
+{
+    float x;
+    float y;
+    /// inverse of the projective depth, 0 for the vertices behind the camera
+    float invZ;
+};
+
+/// triangle in the bin of a tile
+struct BinnedTriangle
+{
+    float minZ;
+    int triId;
+
+    bool operator<(const BinnedTriangle& other) const
+    {
+        return (minZ < other.minZ) || ((minZ == other.minZ) && (triId < other.triId));
+    }
+};
+
+/**
+ * @brief Projected triangle prepared for rasterization.
+ *        The edge function k is zero on the edge opposite to the vertex k and positive inside the triangle:
+ *        e_k(x, y) = a[k] * x + b[k] * y + c[k]
+ */
+struct TriangleSetup
+{
+    double a[3];
+    double b[3];
+    double c[3];
+    /// true if the pixels exactly on the edge belong to the triangle
+    bool ownsEdge[3];
+    double invArea;
+    float invZ[3];
+    float minZ;
+    /// pixel bounding box, clipped to the image
+    int xMin, xMax, yMin, yMax;
+
+    inline double edge(int k, double x, double y) const
+    {
+        return a[k] * x + b[k] * y + c[k];
+    }
+
+    inline bool isInside(double e0, double e1, double e2) const
+    {
+        // bitwise operators, without branches
+        return ((e0 > 0.0) | ((e0 == 0.0) & ownsEdge[0])) &
+               ((e1 > 0.0) | ((e1 == 0.0) & ownsEdge[1])) &
+               ((e2 > 0.0) | ((e2 == 0.0) & ownsEdge[2]));
+    }
+};
+
+/**
+ * @brief Prepare a triangle for rasterization.
+ * @return false if the triangle is behind the camera, degenerated or outside the image
+ */
+bool setupTriangle(const Mesh::triangle& tri, const std::vector<ProjectedVertex>& vertices, int w, int h, TriangleSetup& s)
+{
+    const ProjectedVertex* v[3] = {&vertices[tri.v[0]], &vertices[tri.v[1]], &vertices[tri.v[2]]};
+
+    if(v[0]->invZ <= 0.0f || v[1]->invZ <= 0.0f || v[2]->invZ <= 0.0f)
+        return false;
+
+    const float xMin = std::min({v[0]->x, v[1]->x, v[2]->x});
+    const float xMax = std::max({v[0]->x, v[1]->x, v[2]->x});
+    const float yMin = std::min({v[0]->y, v[1]->y, v[2]->y});
+    const float yMax = std::max({v[0]->y, v[1]->y, v[2]->y});
+
+    // also rejects the non finite coordinates
+    if(!(xMax >= 0.0f && yMax >= 0.0f && xMin <= static_cast<float>(w - 1) && yMin <= static_cast<float>(h - 1)))
+        return false;
+
+    s.xMin = std::max(0, static_cast<int>(std::ceil(xMin)));
+    s.xMax = std::min(w - 1, static_cast<int>(std::floor(xMax)));
+    s.yMin = std::max(0, static_cast<int>(std::ceil(yMin)));
+    s.yMax = std::min(h - 1, static_cast<int>(std::floor(yMax)));
+
+    if(s.xMin > s.xMax || s.yMin > s.yMax)
+        return false;
+
+    for(int k = 0; k < 3; ++k)
+    {
+        const ProjectedVertex& v1 = *v[(k + 1) % 3];
+        const ProjectedVertex& v2 = *v[(k + 2) % 3];
+        s.a[k] = static_cast<double>(v1.y) - static_cast<double>(v2.y);
+        s.b[k] = static_cast<double>(v2.x) - static_cast<double>(v1.x);
+        s.c[k] = -(s.a[k] * v1.x + s.b[k] * v1.y);
+        s.invZ[k] = v[k]->invZ;
+    }
+
+    const double area = s.edge(0, v[0]->x, v[0]->y);
+    if(area == 0.0)
+        return false;
+
+    // orient the edge functions to be positive inside
+    const double sign = (area > 0.0) ? 1.0 : -1.0;
+    for(int k = 0; k < 3; ++k)
+    {
+        s.a[k] *= sign;
+        s.b[k] *= sign;
+        s.c[k] *= sign;
+        // the pixels on an edge shared by two triangles belong to only one of them
+        s.ownsEdge[k] = (s.a[k] > 0.0) || (s.a[k] == 0.0 && s.b[k] > 0.0);
+    }
+    s.invArea = 1.0 / std::abs(area);
+    s.minZ = 1.0f / std::max({s.invZ[0], s.invZ[1], s.invZ[2]});
+
+    return true;
+}
+
+/**
+ * @brief Rasterize a triangle in a block of the tile z-buffer.
+ * @return true if at least one pixel is updated
+ */
+bool rasterizeBlock(const TriangleSetup& s, int triId, int x0, int y0, int x1, int y1, int tileX, int tileY,
+                    std::vector<float>& tileZ, std::vector<int>& tileTriIds)
+{
+    bool updated = false;
+
+    for(int y = y0; y <= y1; ++y)
+    {
+        float* rowZ = &tileZ[(y - tileY) * tileSize];
+        int* rowTriIds = &tileTriIds[(y - tileY) * tileSize];
+
+        // branchless, to let the compiler vectorize the row
+        for(int x = x0; x <= x1; ++x)
+        {
+            const double e0 = s.edge(0, x, y);
+            const double e1 = s.edge(1, x, y);
+            const double e2 = s.edge(2, x, y);
+
+            // 1/z is linear in the image
+            const float invZ = static_cast<float>((e0 * s.invZ[0] + e1 * s.invZ[1] + e2 * s.invZ[2]) * s.invArea);
+            const float z = 1.0f / invZ;
+
+            const int i = x - tileX;
+            const bool isVisible = s.isInside(e0, e1, e2) & (z < rowZ[i]);
+            rowZ[i] = isVisible ? z : rowZ[i];
+            rowTriIds[i] = isVisible ? triId : rowTriIds[i];
+            updated |= isVisible;
+        }
+    }
+    return updated;
+}
+
+/**
+ * @brief Distance to the camera center of the surface point of a triangle seen in a pixel,
+ *        from the perspective correct barycentric coordinates.
+ */
+float getPixelDistance(const Mesh& mesh, const std::vector<ProjectedVertex>& vertices, int triId, int x, int y, const Point3d& C)
+{
+    const Mesh::triangle& tri = (*mesh.tris)[triId];
+
+    double weights[3];
+    double sumWeights = 0.0;
+    for(int k = 0; k < 3; ++k)
+    {
+        const ProjectedVertex& v1 = vertices[tri.v[(k + 1) % 3]];
+        const ProjectedVertex& v2 = vertices[tri.v[(k + 2) % 3]];
+        const double e = (static_cast<double>(v1.y) - v2.y) * (x - v1.x) + (static_cast<double>(v2.x) - v1.x) * (y - v1.y);
+        weights[k] = e * vertices[tri.v[k]].invZ;
+        sumWeights += weights[k];
+    }
+
+    if(sumWeights == 0.0)
+        return static_cast<float>(((*mesh.pts)[tri.v[0]] - C).size());
+
+    Point3d p;
+    for(int k = 0; k < 3; ++k)
+        p = p + (*mesh.pts)[tri.v[k]] * (weights[k] / sumWeights);
+
+    return static_cast<float>((p - C).size());
+}
+
+} // namespace
+
+void rasterizeMesh(const Mesh& mesh, const Matrix3x4& P, const Point3d& C, int w, int h,
+                   StaticVector<float>& out_depthMap, StaticVector<int>* out_trisMap)
+{
+    out_depthMap.clear();
+    if(out_trisMap != nullptr)
+        out_trisMap->clear();
+
+    if(w <= 0 || h <= 0)
+        return;
+
+    out_depthMap.resize_with(w * h, -1.0f);
+    if(out_trisMap != nullptr)
+        out_trisMap->resize_with(w * h, -1);
+
+    if(mesh.pts == nullptr || mesh.tris == nullptr)
+        return;
+
+    // project the vertices
+    std::vector<ProjectedVertex> vertices(mesh.pts->size());
+
+    #pragma omp parallel for
+    for(int i = 0; i < mesh.pts->size(); ++i)
+    {
+        const Point3d p = P * (*mesh.pts)[i];
+        ProjectedVertex& v = vertices[i];
+        if(p.z > 0.0)
+        {
+            v.x = static_cast<float>(p.x / p.z);
+            v.y = static_cast<float>(p.y / p.z);
+            v.invZ = static_cast<float>(1.0 / p.z);
+        }
+        else
+        {
+            v.x = v.y = v.invZ = 0.0f;
+        }
+    }
+
+    // bin the triangles into the tiles they overlap, with one set of bins per thread
+    const int nbTilesX = (w + tileSize - 1) / tileSize;
+    const int nbTilesY = (h + tileSize - 1) / tileSize;
+    const int nbTiles = nbTilesX * nbTilesY;
+    const int nbThreads = omp_get_max_threads();
+
+    std::vector<std::vector<std::vector<BinnedTriangle>>> binsPerThread(nbThreads);
+
+    #pragma omp parallel
+    {
+        std::vector<std::vector<BinnedTriangle>>& bins = binsPerThread[omp_get_thread_num()];
+        bins.resize(nbTiles);
+
+        #pragma omp for
+        for(int triId = 0; triId < mesh.tris->size(); ++triId)
+        {
+            TriangleSetup s;
+            if(!setupTriangle((*mesh.tris)[triId], vertices, w, h, s))
+                continue;
+
+            for(int ty = s.yMin / tileSize; ty <= s.yMax / tileSize; ++ty)
+                for(int tx = s.xMin / tileSize; tx <= s.xMax / tileSize; ++tx)
+                    bins[ty * nbTilesX + tx].push_back({s.minZ, triId});
+        }
+    }
+
+    // rasterize the tiles
+    #pragma omp parallel
+    {
+        std::vector<BinnedTriangle> tileTris;
+        std::vector<float> tileZ(tileSize * tileSize);
+        std::vector<int> tileTriIds(tileSize * tileSize);
+        std::vector<float> blocksMaxZ(nbBlocksPerTileSide * nbBlocksPerTileSide);
+
+        #pragma omp for schedule(dynamic)
+        for(int tileId = 0; tileId < nbTiles; ++tileId)
+        {
+            tileTris.clear();
+            for(const std::vector<std::vector<BinnedTriangle>>& bins : binsPerThread)
+                tileTris.insert(tileTris.end(), bins[tileId].begin(), bins[tileId].end());
+
+            if(tileTris.empty())
+                continue;
+
+            // front to back, so that the farther triangles are mostly rejected by the hierarchical z-buffer
+            std::sort(tileTris.begin(), tileTris.end());
+
+            const int tileX = (tileId % nbTilesX) * tileSize;
+            const int tileY = (tileId / nbTilesX) * tileSize;
+            const int tileXMax = std::min(tileX + tileSize, w) - 1;
+            const int tileYMax = std::min(tileY + tileSize, h) - 1;
+
+            std::fill(tileZ.begin(), tileZ.end(), std::numeric_limits<float>::infinity());
+            std::fill(tileTriIds.begin(), tileTriIds.end(), -1);
+            std::fill(blocksMaxZ.begin(), blocksMaxZ.end(), std::numeric_limits<float>::infinity());
+
+            for(const BinnedTriangle& binnedTri : tileTris)
+            {
+                TriangleSetup s;
+                setupTriangle((*mesh.tris)[binnedTri.triId], vertices, w, h, s);
+
+                const int x0 = std::max(s.xMin, tileX);
+                const int x1 = std::min(s.xMax, tileXMax);
+                const int y0 = std::max(s.yMin, tileY);
+                const int y1 = std::min(s.yMax, tileYMax);
+
+                for(int by = (y0 - tileY) / blockSize; by <= (y1 - tileY) / blockSize; ++by)
+                {
+                    for(int bx = (x0 - tileX) / blockSize; bx <= (x1 - tileX) / blockSize; ++bx)
+                    {
+                        float& blockMaxZ = blocksMaxZ[by * nbBlocksPerTileSide + bx];
+                        if(s.minZ >= blockMaxZ)
+                            continue;
+
+                        const int bx0 = std::max(x0, tileX + bx * blockSize);
+                        const int bx1 = std::min(x1, tileX + bx * blockSize + blockSize - 1);
+                        const int by0 = std::max(y0, tileY + by * blockSize);
+                        const int by1 = std::min(y1, tileY + by * blockSize + blockSize - 1);
+
+                        // reject the block if it is entirely outside of one edge
+                        bool outside = false;
+                        for(int k = 0; k < 3 && !outside; ++k)
+                        {
+                            const double xCorner = (s.a[k] > 0.0) ? bx1 : bx0;
+                            const double yCorner = (s.b[k] > 0.0) ? by1 : by0;
+                            outside = s.edge(k, xCorner, yCorner) < 0.0;
+                        }
+                        if(outside)
+                            continue;
+
+                        if(!rasterizeBlock(s, binnedTri.triId, bx0, by0, bx1, by1, tileX, tileY, tileZ, tileTriIds))
+                            continue;
+
+                        // update the farthest depth of the block
+                        float maxZ = 0.0f;
+                        const int blockX = tileX + bx * blockSize;
+                        const int blockY = tileY + by * blockSize;
+                        for(int y = blockY; y < std::min(blockY + blockSize, tileYMax + 1); ++y)
+                            for(int x = blockX; x < std::min(blockX + blockSize, tileXMax + 1); ++x)
+                                maxZ = std::max(maxZ, tileZ[(y - tileY) * tileSize + (x - tileX)]);
+                        blockMaxZ = maxZ;
+                    }
+                }
+            }
+
+            for(int y = tileY; y <= tileYMax; ++y)
+            {
+                for(int x = tileX; x <= tileXMax; ++x)
+                {
+                    const int triId = tileTriIds[(y - tileY) * tileSize + (x - tileX)];
+                    if(triId < 0)
+                        continue;
+
+                    out_depthMap[x * h + y] = getPixelDistance(mesh, vertices, triId, x, y, C);
+                    if(out_trisMap != nullptr)
+                        (*out_trisMap)[x * h + y] = triId;
+                }
+            }
+        }
+    }
+}
+
+void rasterizeMesh(const Mesh& mesh, const mvsUtils::MultiViewParams& mp, int rc, int w, int h,
+                   StaticVector<float>& out_depthMap, StaticVector<int>* out_trisMap)
+{
+    // from the camera image coordinates to the output image coordinates, keeping the pixel centers aligned
+    const double sx = static_cast<double>(w) / static_cast<double>(mp.getWidth(rc));
+    const double sy = static_cast<double>(h) / static_cast<double>(mp.getHeight(rc));
+
+    Matrix3x3 S;
+    S.m11 = sx;  S.m12 = 0.0; S.m13 = 0.5 * (sx - 1.0);
+    S.m21 = 0.0; S.m22 = sy;  S.m23 = 0.5 * (sy - 1.0);
+    S.m31 = 0.0; S.m32 = 0.0; S.m33 = 1.0;
+
+    rasterizeMesh(mesh, S * mp.camArr[rc], mp.CArr[rc], w, h, out_depthMap, out_trisMap);
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,54 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Rasterize a mesh with a z-buffer: compute the nearest triangle and its depth for each pixel.
+ *
+ * The image is split into tiles processed in parallel: the triangles are projected and binned into the tiles they overlap,
+ * then each tile sorts its triangles front to back and rasterizes them with edge functions at the pixel centers,
+ * skipping the blocks of pixels already covered by nearer triangles (hierarchical z-buffer).
+ * Triangles with a vertex behind the camera are ignored.
+ *
+ * The buffers are stored in columns: pixel (x, y) is at index x * h + y, as in Mesh::getDepthMap.
+ *
+ * @param[in] mesh the input mesh
+ * @param[in] P the camera projection matrix, to the output image coordinates (pixel centers at integer coordinates)
+ * @param[in] C the camera center
+ * @param[in] w the output image width
+ * @param[in] h the output image height
+ * @param[out] out_depthMap the distance to the camera center of the nearest surface point in each pixel, -1 if none
+ * @param[out] out_trisMap the index of the nearest triangle in each pixel, -1 if none (ignored if nullptr)
+ */
+void rasterizeMesh(const Mesh& mesh, const Matrix3x4& P, const Point3d& C, int w, int h,
+                   StaticVector<float>& out_depthMap, StaticVector<int>* out_trisMap = nullptr);
+
+/**
+ * @brief Rasterize a mesh with a z-buffer in the camera @p rc of a MultiViewParams, at a given resolution.
+ * @see rasterizeMesh
+ *
+ * @param[in] mesh the input mesh
+ * @param[in] mp the multi-view parameters
+ * @param[in] rc the camera index
+ * @param[in] w the output image width (the camera image is resized to w x h)
+ * @param[in] h the output image height
+ * @param[out] out_depthMap the distance to the camera center of the nearest surface point in each pixel, -1 if none
+ * @param[out] out_trisMap the index of the nearest triangle in each pixel, -1 if none (ignored if nullptr)
+ */
+void rasterizeMesh(const Mesh& mesh, const mvsUtils::MultiViewParams& mp, int rc, int w, int h,
+                   StaticVector<float>& out_depthMap, StaticVector<int>* out_trisMap = nullptr);
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,184 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/mesh/meshRasterization.hpp>
+#include <aliceVision/mesh/meshTestUtils.hpp>
+
+#include <cmath>
+#include <limits>
+
+#define BOOST_TEST_MODULE meshRasterization
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+// Test summary:
+// - Rasterize planes in a pinhole camera at the origin looking at +z and check the occlusions and the depths
+// - Check that a mesh covering the whole image has no hole
+// - Compare the depth map of a bumpy mesh with a brute force ray casting
+// - Benchmark the rasterization of a large mesh
+
+namespace {
+
+/**
+ * @brief Projection matrix of a camera at the origin looking at +z, with the principal point at the image center.
+ */
+Matrix3x4 createProjection(double focal, int w, int h)
+{
+    Matrix3x4 P;
+    P.m11 = focal;
+    P.m13 = 0.5 * (w - 1);
+    P.m22 = focal;
+    P.m23 = 0.5 * (h - 1);
+    P.m33 = 1.0;
+    return P;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MeshRasterization_occlusion)
+{
+    const int w = 129;
+    const int h = 97;
+    const double focal = 100.0;
+    const Matrix3x4 P = createProjection(focal, w, h);
+
+    Mesh mesh;
+    mesh.pts = new StaticVector<Point3d>();
+    mesh.tris = new StaticVector<Mesh::triangle>();
+    // near quad in front of a far quad, then a quad behind the camera
+    addQuad(mesh, -2.0, -2.0, 2.0, 2.0, 10.0);
+    addQuad(mesh, -0.5, -0.5, 0.5, 0.5, 5.0);
+    addQuad(mesh, -2.0, -2.0, 2.0, 2.0, -1.0);
+
+    StaticVector<float> depthMap;
+    StaticVector<int> trisMap;
+    rasterizeMesh(mesh, P, Point3d(), w, h, depthMap, &trisMap);
+
+    BOOST_CHECK_EQUAL(depthMap.size(), w * h);
+    BOOST_CHECK_EQUAL(trisMap.size(), w * h);
+
+    int nbNear = 0;
+    int nbFar = 0;
+    for(int x = 0; x < w; ++x)
+    {
+        for(int y = 0; y < h; ++y)
+        {
+            const double dx = (x - 0.5 * (w - 1)) / focal;
+            const double dy = (y - 0.5 * (h - 1)) / focal;
+            const int triId = trisMap[x * h + y];
+            const float depth = depthMap[x * h + y];
+
+            BOOST_CHECK(triId < 4);
+            if(triId < 0)
+            {
+                BOOST_CHECK_EQUAL(depth, -1.0f);
+                // outside of the far quad
+                BOOST_CHECK(std::abs(dx) * 10.0 >= 2.0 - 1e-6 || std::abs(dy) * 10.0 >= 2.0 - 1e-6);
+                continue;
+            }
+
+            const double z = (triId >= 2) ? 5.0 : 10.0;
+            BOOST_CHECK_CLOSE(depth, z * std::sqrt(1.0 + dx * dx + dy * dy), 1e-3);
+
+            if(triId >= 2)
+                ++nbNear;
+            else
+                ++nbFar;
+
+            // visible near quad
+            if(std::abs(dx) * 5.0 < 0.5 - 1e-6 && std::abs(dy) * 5.0 < 0.5 - 1e-6)
+                BOOST_CHECK(triId >= 2);
+        }
+    }
+
+    // 20 pixels wide near quad and 40 pixels wide far quad:
+    // the pixel centers on the edges belong to the quads only on their left and top sides
+    BOOST_CHECK_EQUAL(nbNear, 20 * 20);
+    BOOST_CHECK_EQUAL(nbFar, 40 * 40 - 20 * 20);
+    BOOST_CHECK_EQUAL(trisMap[64 * h + 48] >= 2, true);
+    BOOST_CHECK_CLOSE(depthMap[64 * h + 48], 5.0f, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(MeshRasterization_noHole)
+{
+    const int w = 320;
+    const int h = 240;
+    const Matrix3x4 P = createProjection(200.0, w, h);
+
+    // flat grid covering the whole image
+    Mesh mesh;
+    createGridMesh(mesh, 101, 10.0, 10.0, 0.0);
+
+    StaticVector<float> depthMap;
+    StaticVector<int> trisMap;
+    rasterizeMesh(mesh, P, Point3d(), w, h, depthMap, &trisMap);
+
+    int nbHoles = 0;
+    for(int i = 0; i < trisMap.size(); ++i)
+        nbHoles += static_cast<int>(trisMap[i] < 0 || depthMap[i] < 0.0f);
+    BOOST_CHECK_EQUAL(nbHoles, 0);
+}
+
+BOOST_AUTO_TEST_CASE(MeshRasterization_rayCasting)
+{
+    const int w = 160;
+    const int h = 120;
+    const double focal = 150.0;
+    const Matrix3x4 P = createProjection(focal, w, h);
+
+    Mesh mesh;
+    createGridMesh(mesh, 41, 3.0, 8.0, 1.0);
+
+    StaticVector<float> depthMap;
+    rasterizeMesh(mesh, P, Point3d(), w, h, depthMap);
+
+    // the pixel centers on the shared edges belong to one of the triangles, at the same depth
+    for(int x = 0; x < w; ++x)
+    {
+        for(int y = 0; y < h; ++y)
+        {
+            const Point3d dir((x - 0.5 * (w - 1)) / focal, (y - 0.5 * (h - 1)) / focal, 1.0);
+            double t;
+            const int triId = rayCast(mesh, Point3d(), dir, std::numeric_limits<double>::max(), t);
+            const float depth = depthMap[x * h + y];
+
+            if(triId < 0)
+                BOOST_CHECK_EQUAL(depth, -1.0f);
+            else
+                BOOST_CHECK_CLOSE(depth, t * dir.size(), 1e-4);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MeshRasterization_benchmark)
+{
+    const int w = 2048;
+    const int h = 1536;
+    const Matrix3x4 P = createProjection(1500.0, w, h);
+
+    // 2M triangles
+    Mesh mesh;
+    createGridMesh(mesh, 1001, 8.0, 10.0, 1.0);
+
+    StaticVector<float> depthMap;
+    StaticVector<int> trisMap;
+
+    system::Timer timer;
+    rasterizeMesh(mesh, P, Point3d(), w, h, depthMap, &trisMap);
+
+    ALICEVISION_LOG_INFO("Rasterization of " << mesh.tris->size() << " triangles in " << w << "x" << h << ": "
+                         << timer.elapsedMs() << " ms");
+
+    int nbPixels = 0;
+    for(int i = 0; i < trisMap.size(); ++i)
+        nbPixels += static_cast<int>(trisMap[i] >= 0);
+    BOOST_CHECK_GT(nbPixels, 0);
+}
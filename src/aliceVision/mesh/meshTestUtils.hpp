@@ -0,0 +1,113 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Add a quad of two triangles facing +z at depth z.
+ */
+inline void addQuad(Mesh& mesh, double x0, double y0, double x1, double y1, double z)
+{
+    const int first = mesh.pts->size();
+    mesh.pts->push_back(Point3d(x0, y0, z));
+    mesh.pts->push_back(Point3d(x1, y0, z));
+    mesh.pts->push_back(Point3d(x1, y1, z));
+    mesh.pts->push_back(Point3d(x0, y1, z));
+    mesh.tris->push_back(Mesh::triangle(first, first + 1, first + 2));
+    mesh.tris->push_back(Mesh::triangle(first, first + 2, first + 3));
+}
+
+/**
+ * @brief Create a grid mesh of size x size vertices in [-extent, extent]^2, with a bumpy depth around z.
+ *        The triangles are shuffled and have random orientations.
+ */
+inline void createGridMesh(Mesh& mesh, int size, double extent, double z, double bumpiness)
+{
+    mesh.pts = new StaticVector<Point3d>();
+    mesh.tris = new StaticVector<Mesh::triangle>();
+    mesh.pts->reserve(size * size);
+    mesh.tris->reserve(2 * (size - 1) * (size - 1));
+
+    for(int y = 0; y < size; ++y)
+    {
+        for(int x = 0; x < size; ++x)
+        {
+            const double px = extent * (2.0 * x / (size - 1) - 1.0);
+            const double py = extent * (2.0 * y / (size - 1) - 1.0);
+            mesh.pts->push_back(Point3d(px, py, z + bumpiness * std::sin(5.0 * px) * std::cos(3.0 * py)));
+        }
+    }
+
+    std::srand(0);
+    for(int y = 0; y < size - 1; ++y)
+    {
+        for(int x = 0; x < size - 1; ++x)
+        {
+            const int a = y * size + x;
+            if(std::rand() % 2)
+            {
+                mesh.tris->push_back(Mesh::triangle(a, a + 1, a + size + 1));
+                mesh.tris->push_back(Mesh::triangle(a, a + size + 1, a + size));
+            }
+            else
+            {
+                mesh.tris->push_back(Mesh::triangle(a, a + size + 1, a + 1));
+                mesh.tris->push_back(Mesh::triangle(a, a + size, a + size + 1));
+            }
+        }
+    }
+
+    for(int i = mesh.tris->size() - 1; i > 0; --i)
+        std::swap((*mesh.tris)[i], (*mesh.tris)[std::rand() % (i + 1)]);
+}
+
+/**
+ * @brief Nearest triangle intersected by the ray origin + t * direction with t in ]0, tMax[, by brute force.
+ * @param[out] out_t the ray parameter of the intersection (tMax if no triangle is hit)
+ * @return the triangle index, or -1 if no triangle is hit
+ */
+inline int rayCast(const Mesh& mesh, const Point3d& origin, const Point3d& direction, double tMax, double& out_t)
+{
+    int triId = -1;
+    out_t = tMax;
+    for(int i = 0; i < mesh.tris->size(); ++i)
+    {
+        const Point3d& A = (*mesh.pts)[(*mesh.tris)[i].v[0]];
+        const Point3d e1 = (*mesh.pts)[(*mesh.tris)[i].v[1]] - A;
+        const Point3d e2 = (*mesh.pts)[(*mesh.tris)[i].v[2]] - A;
+
+        // Moller-Trumbore intersection
+        const Point3d p = cross(direction, e2);
+        const double det = dot(e1, p);
+        if(std::abs(det) < 1e-12)
+            continue;
+        const Point3d s = origin - A;
+        const double u = dot(s, p) / det;
+        const Point3d q = cross(s, e1);
+        const double v = dot(direction, q) / det;
+        const double t = dot(e2, q) / det;
+        if(u >= 0.0 && v >= 0.0 && u + v <= 1.0 && t > 0.0 && t < out_t)
+        {
+            out_t = t;
+            triId = i;
+        }
+    }
+    return triId;
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -6,8 +6,11 @@
 
 #include "meshVisibility.hpp"
 #include "geoMesh.hpp"
+#include "MeshBVH.hpp"
 
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
 
 #include <geogram/basic/permutation.h>
 #include <geogram/basic/attributes.h>
@@ -15,6 +18,10 @@
 #include <geogram/mesh/mesh_AABB.h>
 #include <geogram/mesh/mesh_reorder.h>
 
+#include <algorithm>
+#include <memory>
+#include <utility>
+
 
 namespace aliceVision {
 namespace mesh {
@@ -147,5 +154,108 @@ void remapMeshVisibilities_pushVerticesVisibilityToTriangles(
     ALICEVISION_LOG_INFO("remapMeshVisibility done.");
 }
 
+void remapMeshVisibilities_rayCast(
+    const Mesh& refMesh, const PointsVisibility& refPtsVisibilities,
+    const Mesh& mesh, const mvsUtils::MultiViewParams& mp, PointsVisibility& out_ptsVisibilities)
+{
+    ALICEVISION_LOG_INFO("remapMeshVisibility based on ray casting start.");
+
+    // the intersections close to the vertex are its own triangles (ratio of the camera to vertex distance)
+    const double vertexMargin = 1e-3;
+    // size of the image tiles used to group the coherent rays into packets
+    const int tileSize = 16;
+
+    system::Timer timer;
+    const MeshBVH bvh(mesh);
+    ALICEVISION_LOG_INFO("BVH of " << mesh.tris->size() << " triangles built in " << timer.elapsed() << " s ("
+                         << bvh.getNbNodes() << " nodes, depth " << bvh.getDepth() << ").");
+
+    const int nbPts = mesh.pts->size();
+    if(out_ptsVisibilities.size() != nbPts)
+        out_ptsVisibilities.resize(nbPts, nullptr);
+    for(int i = 0; i < nbPts; ++i)
+    {
+        if(out_ptsVisibilities[i] == nullptr)
+            out_ptsVisibilities[i] = new StaticVector<int>(); // create and give ownership
+    }
+
+    // candidate vertices of each camera: the cameras seeing the nearest vertex of the reference mesh
+    StaticVector<int> nearestVertex;
+    getNearestVertices(refMesh, mesh, nearestVertex);
+
+    std::vector<std::vector<int>> camsCandidates(mp.ncams);
+    for(int i = 0; i < nbPts; ++i)
+    {
+        const PointVisibility* refVisibility = refPtsVisibilities[nearestVertex[i]];
+        if(refVisibility == nullptr)
+            continue;
+        for(int rc : *refVisibility)
+            camsCandidates[rc].push_back(i);
+    }
+
+    // vertex normals for the back-face test (null normal for the isolated or degenerated vertices)
+    std::unique_ptr<StaticVector<Point3d>> normals(mesh.computeNormalsForPts());
+
+    std::vector<int> tileIds;
+    std::vector<std::pair<int, int>> candidates; // (tile id, vertex id)
+    std::vector<MeshBVH::Ray> rays;
+    std::unique_ptr<bool[]> occluded(new bool[nbPts]);
+    std::size_t nbRays = 0;
+
+    timer.reset();
+    for(int rc = 0; rc < mp.ncams; ++rc)
+    {
+        const std::vector<int>& camCandidates = camsCandidates[rc];
+        const int nbTilesX = (mp.getWidth(rc) + tileSize - 1) / tileSize;
+
+        // candidate vertices in the camera image and facing the camera
+        tileIds.resize(camCandidates.size());
+        #pragma omp parallel for
+        for(int c = 0; c < static_cast<int>(camCandidates.size()); ++c)
+        {
+            const int i = camCandidates[c];
+            const Point3d& p = (*mesh.pts)[i];
+            tileIds[c] = -1;
+            if(dot((*normals)[i], mp.CArr[rc] - p) < 0.0)
+                continue;
+            Pixel pix;
+            mp.getPixelFor3DPoint(&pix, p, rc);
+            if(mp.isPixelInImage(pix, 0, rc))
+                tileIds[c] = (pix.y / tileSize) * nbTilesX + pix.x / tileSize;
+        }
+
+        candidates.clear();
+        for(int c = 0; c < static_cast<int>(camCandidates.size()); ++c)
+        {
+            if(tileIds[c] >= 0)
+                candidates.emplace_back(tileIds[c], camCandidates[c]);
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        // segments from the camera center to the vertices, grouped by image tile
+        rays.resize(candidates.size());
+        for(int i = 0; i < static_cast<int>(candidates.size()); ++i)
+        {
+            MeshBVH::Ray& ray = rays[i];
+            ray.origin = mp.CArr[rc];
+            ray.direction = (*mesh.pts)[candidates[i].second] - mp.CArr[rc];
+            ray.tMax = 1.0 - vertexMargin;
+        }
+
+        bvh.isOccluded(rays.data(), static_cast<int>(rays.size()), occluded.get());
+        nbRays += rays.size();
+
+        for(int i = 0; i < static_cast<int>(candidates.size()); ++i)
+        {
+            if(!occluded[i])
+                out_ptsVisibilities[candidates[i].second]->push_back_distinct(rc);
+        }
+    }
+
+    const double elapsed = timer.elapsed();
+    ALICEVISION_LOG_INFO(nbRays << " rays cast in " << elapsed << " s (" << (elapsed > 0.0 ? nbRays / elapsed : 0.0) << " rays/s).");
+    ALICEVISION_LOG_INFO("remapMeshVisibility done.");
+}
+
 } // namespace mesh
 } // namespace aliceVision
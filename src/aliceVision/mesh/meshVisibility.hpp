@@ -52,6 +52,24 @@ void remapMeshVisibilities_pushVerticesVisibilityToTriangles(
     const Mesh& refMesh, const PointsVisibility& refPtsVisibilities,
     const Mesh& mesh, PointsVisibility& out_ptsVisibilities);
 
+/**
+ * @brief Transfer the visibility per vertex from one mesh to another by ray casting.
+ * For each vertex of the @p mesh, the candidate cameras are the cameras seeing the nearest neighbor vertex in the @p refMesh.
+ * A candidate camera sees the vertex if the vertex projects in its image, if the vertex normal faces the camera
+ * and if the segment from the camera center to the vertex does not intersect the @p mesh.
+ * Unlike the nearest vertex or triangle remapping, the visibilities do not leak through thin geometry.
+ * @note The segments are traced by packets in a bounding volume hierarchy of the mesh triangles (see MeshBVH).
+ * @note The back-face test relies on the orientation of the @p mesh triangles (see the flipNormals option of the texturing).
+ *
+ * @param[in] refMesh input reference mesh
+ * @param[in] refPtsVisibilities visibility array per vertex of @p refMesh
+ * @param[in] mesh input target mesh
+ * @param[in] mp the multi-view parameters
+ * @param[out] out_ptsVisibilities visibility array per vertex of @p mesh, the visible cameras are added if not already present
+ */
+void remapMeshVisibilities_rayCast(
+    const Mesh& refMesh, const PointsVisibility& refPtsVisibilities,
+    const Mesh& mesh, const mvsUtils::MultiViewParams& mp, PointsVisibility& out_ptsVisibilities);
 
 } // namespace mesh
 } // namespace aliceVision
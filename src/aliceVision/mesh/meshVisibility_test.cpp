@@ -0,0 +1,96 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mvsData/structures.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/mvsTestUtils.hpp>
+#include <aliceVision/mesh/meshVisibility.hpp>
+#include <aliceVision/mesh/meshTestUtils.hpp>
+
+#include <vector>
+
+#define BOOST_TEST_MODULE meshVisibility
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+// Test summary:
+// - Remap the visibilities of a mesh onto itself by ray casting, with a quad occluding one vertex in one camera,
+//   a camera behind the mesh and vertices out of a camera image, and compare with the known visibilities
+
+namespace {
+
+const int imageWidth = 64;
+const int imageHeight = 48;
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MeshVisibility_rayCast)
+{
+    // camera 0 in front of the mesh, camera 1 behind it, camera 2 in front of it with an oblique view
+    const mvsUtils::SceneFixture scene("meshVisibility", {Point3d(0.0, 0.0, 5.0), Point3d(0.0, 0.0, -5.0), Point3d(0.0, -4.0, 3.0)},
+                                       imageWidth, imageHeight);
+    const mvsUtils::MultiViewParams& mp = *scene.mp;
+
+    Mesh mesh;
+    mesh.pts = new StaticVector<Point3d>();
+    mesh.tris = new StaticVector<Mesh::triangle>();
+
+    // 3x3 vertices grid in [-1, 1]^2 facing +z at depth 0
+    for(int y = -1; y <= 1; ++y)
+    {
+        for(int x = -1; x <= 1; ++x)
+            mesh.pts->push_back(Point3d(x, y, 0.0));
+    }
+    for(int y = 0; y < 2; ++y)
+    {
+        for(int x = 0; x < 2; ++x)
+        {
+            const int a = y * 3 + x;
+            mesh.tris->push_back(Mesh::triangle(a, a + 1, a + 4));
+            mesh.tris->push_back(Mesh::triangle(a, a + 4, a + 3));
+        }
+    }
+    const int occludedPtId = 8; // vertex (1, 1, 0)
+
+    // small quad between camera 0 and the occluded vertex (the segment crosses it at (0.5, 0.5, 2.5)),
+    // out of the segments from camera 2 and out of its image
+    const int nbGridPts = mesh.pts->size();
+    addQuad(mesh, 0.35, 0.3, 0.75, 0.65, 2.5);
+
+    // all the cameras are candidates
+    PointsVisibility refPtsVisibilities;
+    for(int i = 0; i < mesh.pts->size(); ++i)
+    {
+        PointVisibility* visibility = new PointVisibility();
+        for(int rc = 0; rc < mp.ncams; ++rc)
+            visibility->push_back(rc);
+        refPtsVisibilities.push_back(visibility);
+    }
+
+    PointsVisibility ptsVisibilities;
+    remapMeshVisibilities_rayCast(mesh, refPtsVisibilities, mesh, mp, ptsVisibilities);
+
+    BOOST_REQUIRE_EQUAL(ptsVisibilities.size(), mesh.pts->size());
+    for(int i = 0; i < mesh.pts->size(); ++i)
+    {
+        BOOST_REQUIRE(ptsVisibilities[i] != nullptr);
+        const std::vector<int> visibility(ptsVisibilities[i]->begin(), ptsVisibilities[i]->end());
+        std::vector<int> expected{0, 2};
+        if(i == occludedPtId)
+            expected = {2};
+        else if(i >= nbGridPts)
+            expected = {0};
+        BOOST_CHECK_EQUAL_COLLECTIONS(visibility.begin(), visibility.end(), expected.begin(), expected.end());
+    }
+
+    for(int i = 0; i < mesh.pts->size(); ++i)
+    {
+        delete refPtsVisibilities[i];
+        delete ptsVisibilities[i];
+    }
+}
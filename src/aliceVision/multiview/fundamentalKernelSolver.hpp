@@ -97,6 +97,17 @@ struct SampsonError {
     return Square(y.dot(F_x)) / (  F_x.head<2>().squaredNorm()
                                 + Ft_y.head<2>().squaredNorm());
   }
+
+  /// Errors of all the correspondences (columns of x1 and x2), vectorized over the correspondences
+  static void Errors(const Mat3 &F, const Mat &x1, const Mat &x2, std::vector<double> &errors) {
+    const Mat3X F_x = (F.leftCols<2>() * x1).colwise() + F.col(2);
+    const Mat3X Ft_y = (F.transpose().leftCols<2>() * x2).colwise() + F.row(2).transpose();
+    const Eigen::RowVectorXd y_F_x = F_x.topRows<2>().cwiseProduct(x2).colwise().sum() + F_x.row(2);
+    errors.resize(x1.cols());
+    Eigen::Map<Eigen::RowVectorXd>(errors.data(), x1.cols()) =
+      (y_F_x.array().square() / (  F_x.topRows<2>().colwise().squaredNorm().array()
+                                 + Ft_y.topRows<2>().colwise().squaredNorm().array())).matrix();
+  }
 };
 
 struct SymmetricEpipolarDistanceError {
@@ -110,6 +121,18 @@ struct SymmetricEpipolarDistanceError {
                                 + 1.0 / Ft_y.head<2>().squaredNorm())
       / 4.0;  // The divide by 4 is to make this match the Sampson distance.
   }
+
+  /// Errors of all the correspondences (columns of x1 and x2), vectorized over the correspondences
+  static void Errors(const Mat3 &F, const Mat &x1, const Mat &x2, std::vector<double> &errors) {
+    const Mat3X F_x = (F.leftCols<2>() * x1).colwise() + F.col(2);
+    const Mat3X Ft_y = (F.transpose().leftCols<2>() * x2).colwise() + F.row(2).transpose();
+    const Eigen::RowVectorXd y_F_x = F_x.topRows<2>().cwiseProduct(x2).colwise().sum() + F_x.row(2);
+    errors.resize(x1.cols());
+    Eigen::Map<Eigen::RowVectorXd>(errors.data(), x1.cols()) =
+      (y_F_x.array().square() * (  F_x.topRows<2>().colwise().squaredNorm().array().inverse()
+                                 + Ft_y.topRows<2>().colwise().squaredNorm().array().inverse())
+      / 4.0).matrix();
+  }
 };
 
 struct EpipolarDistanceError {
@@ -121,6 +144,15 @@ struct EpipolarDistanceError {
     Vec3 F_x = F * x;
     return Square(F_x.dot(y)) /  F_x.head<2>().squaredNorm();
   }
+
+  /// Errors of all the correspondences (columns of x1 and x2), vectorized over the correspondences
+  static void Errors(const Mat3 &F, const Mat &x1, const Mat &x2, std::vector<double> &errors) {
+    const Mat3X F_x = (F.leftCols<2>() * x1).colwise() + F.col(2);
+    const Eigen::RowVectorXd F_x_y = F_x.topRows<2>().cwiseProduct(x2).colwise().sum() + F_x.row(2);
+    errors.resize(x1.cols());
+    Eigen::Map<Eigen::RowVectorXd>(errors.data(), x1.cols()) =
+      (F_x_y.array().square() / F_x.topRows<2>().colwise().squaredNorm().array()).matrix();
+  }
 };
 typedef EpipolarDistanceError SimpleError;
 
@@ -121,3 +121,27 @@ BOOST_AUTO_TEST_CASE(EightPointTest_Normalized_EasyCase) {
   typedef fundamental::kernel::NormalizedEightPointKernel Kernel;
   BOOST_CHECK(ExpectKernelProperties<Kernel>(x1, x2));
 }
+
+// Check the vectorized errors against the errors of each correspondence
+template<typename ErrorT>
+void ExpectVectorizedErrors(const Mat3 &F, const Mat &x1, const Mat &x2) {
+  std::vector<double> errors;
+  ErrorT::Errors(F, x1, x2, errors);
+  BOOST_CHECK_EQUAL(errors.size(), x1.cols());
+  for (int i = 0; i < x1.cols(); ++i) {
+    const double error = ErrorT::Error(F, x1.col(i), x2.col(i));
+    BOOST_CHECK_SMALL(errors[i] - error, 1e-10 * std::max(1.0, error));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FundamentalErrors_Vectorized) {
+  Mat3 F;
+  F << 1e-5,  2e-4, -3e-2,
+      -1e-4,  3e-6,  2e-2,
+       4e-2, -1e-2,  1.0;
+  const Mat x1 = Mat::Random(2, 101) * 500.0;
+  const Mat x2 = Mat::Random(2, 101) * 500.0;
+  ExpectVectorizedErrors<fundamental::kernel::SampsonError>(F, x1, x2);
+  ExpectVectorizedErrors<fundamental::kernel::SymmetricEpipolarDistanceError>(F, x1, x2);
+  ExpectVectorizedErrors<fundamental::kernel::EpipolarDistanceError>(F, x1, x2);
+}
@@ -42,6 +42,16 @@ struct AsymmetricError {
     Vec2 x2_est = x2h_est.head<2>() / x2h_est[2];
     return (x2 - x2_est).squaredNorm();
   }
+
+  /// Errors of all the correspondences (columns of x1 and x2), vectorized over the correspondences
+  static void Errors(const Mat3 &H, const Mat &x1, const Mat &x2, std::vector<double> &errors) {
+    const Mat3X x2h_est = (H.leftCols<2>() * x1).colwise() + H.col(2);
+    const Eigen::RowVectorXd w = x2h_est.row(2);
+    errors.resize(x1.cols());
+    Eigen::Map<Eigen::RowVectorXd>(errors.data(), x1.cols()) =
+      (  (x2.row(0).array() - x2h_est.row(0).array() / w.array()).square()
+       + (x2.row(1).array() - x2h_est.row(1).array() / w.array()).square()).matrix();
+  }
 };
 
 // Kernel that works on original data point
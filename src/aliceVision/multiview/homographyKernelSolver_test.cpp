@@ -90,3 +90,21 @@ BOOST_AUTO_TEST_CASE(HomographyKernelTest_Fitting_Normalized) {
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(HomographyKernelTest_VectorizedErrors) {
+  Mat3 H;
+  H << 1.1,  0.05,  20,
+      -0.03, 0.95, -10,
+       1e-4, 2e-5,   1;
+  const Mat x1 = Mat::Random(2, 101) * 500.0;
+  const Mat x2 = Mat::Random(2, 101) * 500.0;
+
+  // Check the vectorized errors against the errors of each correspondence
+  vector<double> errors;
+  homography::kernel::AsymmetricError::Errors(H, x1, x2, errors);
+  BOOST_CHECK_EQUAL(errors.size(), x1.cols());
+  for (int i = 0; i < x1.cols(); ++i) {
+    const double error = homography::kernel::AsymmetricError::Error(H, x1.col(i), x2.col(i));
+    BOOST_CHECK_SMALL(errors[i] - error, 1e-10 * std::max(1.0, error));
+  }
+}
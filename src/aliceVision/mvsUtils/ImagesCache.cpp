@@ -5,12 +5,46 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "ImagesCache.hpp"
+#include <aliceVision/system/Logger.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 
+#include <algorithm>
+
 namespace aliceVision {
 namespace mvsUtils {
 
+Color ImagesCache::Img::getPixelValueInterpolated(const Point2d* pix) const
+{
+    const int xp = static_cast<int>(pix->x);
+    const int yp = static_cast<int>(pix->y);
+
+    // precision to 4 decimal places
+    const float ui = pix->x - static_cast<float>(xp);
+    const float vi = pix->y - static_cast<float>(yp);
+
+    const Color lu = _data[getPixelId(xp,     yp    )];
+    const Color ru = _data[getPixelId(xp + 1, yp    )];
+    const Color rd = _data[getPixelId(xp + 1, yp + 1)];
+    const Color ld = _data[getPixelId(xp,     yp + 1)];
+
+    // bilinear interpolation of the pixel intensity value
+    const Color u = lu + (ru - lu) * ui;
+    const Color d = ld + (rd - ld) * ui;
+    const Color out = u + (d - u) * vi;
+
+    return out;
+}
+
+rgb ImagesCache::Img::getPixelValue(const Pixel& pix) const
+{
+    const Color floatRGB = _data[getPixelId(pix.x, pix.y)] * 255.0f;
+
+    return rgb(static_cast<unsigned char>(floatRGB.r),
+               static_cast<unsigned char>(floatRGB.g),
+               static_cast<unsigned char>(floatRGB.b));
+}
+
 int ImagesCache::getPixelId(int x, int y, int imgid)
 {
     if(!transposed)
@@ -39,10 +73,11 @@ ImagesCache::ImagesCache(const MultiViewParams* _mp, int _bandType, std::vector<
 void ImagesCache::initIC(int _bandType, std::vector<std::string>& _imagesNames,
                              bool _transposed)
 {
-    float oneimagemb = (sizeof(Color) * mp->getMaxImageWidth() * mp->getMaxImageHeight()) / 1024.f / 1024.f;
-    float maxmbCPU = (float)mp->_ini.get<int>("images_cache.maxmbCPU", 5000);
-    int _npreload = std::max((int)(maxmbCPU / oneimagemb), mp->_ini.get<int>("grow.minNumOfConsistentCams", 10));
-    N_PRELOADED_IMAGES = std::min(mp->ncams, _npreload);
+    const std::size_t oneImageSize = sizeof(Color) * mp->getMaxImageWidth() * mp->getMaxImageHeight();
+    const std::size_t maxmbCPU = mp->_ini.get<int>("images_cache.maxmbCPU", 5000);
+    // as before, keep at least enough memory for the images of a reference camera and its neighbors
+    const std::size_t minNbImages = std::min(mp->ncams, mp->_ini.get<int>("grow.minNumOfConsistentCams", 10));
+    _maxMemorySize = std::max(maxmbCPU * 1024 * 1024, minNbImages * oneImageSize);
 
     transposed = _transposed;
     bandType = _bandType;
@@ -51,116 +86,264 @@ void ImagesCache::initIC(int _bandType, std::vector<std::string>& _imagesNames,
     {
         imagesNames.push_back(_imagesNames[rc]);
     }
+}
 
-    imgs = new Color*[N_PRELOADED_IMAGES];
+ImagesCache::~ImagesCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(_prefetchMutex);
+        _stopPrefetch = true;
+        _prefetchQueue.clear();
+    }
+    _prefetchCondition.notify_all();
+    if(_prefetchThread.joinable())
+        _prefetchThread.join();
 
-    camIdMapId = new StaticVector<int>();
-    camIdMapId->reserve(mp->ncams);
-    mapIdCamId = new StaticVector<int>();
-    mapIdCamId->reserve(N_PRELOADED_IMAGES);
-    mapIdClock = new StaticVector<long>();
-    mapIdClock->reserve(N_PRELOADED_IMAGES);
+    const Statistics stats = getStatistics();
+    ALICEVISION_LOG_DEBUG("Images cache statistics:" << std::endl
+                          << "\t- hits: " << stats.nbHits << std::endl
+                          << "\t- misses: " << stats.nbMisses << std::endl
+                          << "\t- prefetched: " << stats.nbPrefetched << std::endl
+                          << "\t- evictions: " << stats.nbEvictions);
+}
 
-    for(int i = 0; i < mp->ncams; ++i)
+std::shared_ptr<ImagesCache::Entry> ImagesCache::getEntry(int camId, bool& loaded)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _entries.find(camId);
+    if(it != _entries.end())
     {
-        camIdMapId->push_back(-1);
+        const std::shared_ptr<Entry>& entry = it->second;
+        // most recently used
+        _lru.splice(_lru.begin(), _lru, entry->lruIt);
+        entry->pinned = false;
+        loaded = (entry->memorySize > 0);
+        return entry;
     }
 
-    for (int ni = 0; ni < N_PRELOADED_IMAGES; ++ni)
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+    _lru.push_front(camId);
+    entry->lruIt = _lru.begin();
+    _entries[camId] = entry;
+    loaded = false;
+    return entry;
+}
+
+ImagesCache::ImgSharedPtr ImagesCache::loadEntry(int camId, Entry& entry, bool prefetched)
+{
+    std::lock_guard<std::mutex> loadLock(entry.loadMutex);
+
+    if(entry.img)
     {
-        imgs[ni] = nullptr;
+        // loaded by another thread in the meantime
+        if(!prefetched)
+            ++_nbHits;
+        return entry.img;
+    }
+
+    long t1 = clock();
+
+    ImgSharedPtr img = std::make_shared<Img>(mp->getWidth(camId), mp->getHeight(camId), transposed);
+    const std::string imagePath = imagesNames.at(camId);
+    memcpyRGBImageFromFileToArr(camId, img->data(), imagePath, mp, transposed, bandType);
+
+    ALICEVISION_LOG_DEBUG("Add " << imagePath << " to image cache. " << formatElapsedTime(t1));
+
+    if(prefetched)
+        ++_nbPrefetched;
+    else
+        ++_nbMisses;
 
-        (*camIdMapId)[ni] = -1;
-        mapIdCamId->push_back(-1);
-        mapIdClock->push_back(clock());
+    entry.img = img;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        entry.memorySize = img->memorySize();
+        _memorySize += entry.memorySize;
+        evict(camId);
     }
+    return img;
 }
 
-ImagesCache::~ImagesCache()
+void ImagesCache::evict(int keepCamId)
 {
-    for(int ni = 0; ni < N_PRELOADED_IMAGES; ni++)
+    evictEntries(keepCamId, false);
+    // the prefetched images are evicted before they are accessed only if the budget is too small
+    evictEntries(keepCamId, true);
+}
+
+void ImagesCache::evictEntries(int keepCamId, bool pinned)
+{
+    auto it = _lru.end();
+    while(_memorySize > _maxMemorySize && it != _lru.begin())
     {
-        delete[] imgs[ni];
-    }
-    delete[] imgs;
+        --it;
+        const int camId = *it;
+        if(camId == keepCamId)
+            continue;
+
+        auto entryIt = _entries.find(camId);
+        const std::size_t memorySize = entryIt->second->memorySize;
+        // images being loaded are not evicted
+        if(memorySize == 0 || entryIt->second->pinned != pinned)
+            continue;
 
-    delete camIdMapId;
-    delete mapIdCamId;
-    delete mapIdClock;
+        // the image is released when it is not used anymore
+        _memorySize -= memorySize;
+        _entries.erase(entryIt);
+        it = _lru.erase(it);
+        ++_nbEvictions;
+    }
 }
 
-void ImagesCache::refreshData(int camId)
+ImagesCache::ImgSharedPtr ImagesCache::getImg_sync(int camId)
 {
-    // printf("camId %i\n",camId);
-    // test if the image is in the memory
-    if((*camIdMapId)[camId] == -1)
-    {
-        // remove the oldest one
-        int mapId = mapIdClock->minValId();
-        int oldCamId = (*mapIdCamId)[mapId];
-        if(oldCamId>=0)
-            (*camIdMapId)[oldCamId] = -1;
-
-        // replace with new new
-        (*camIdMapId)[camId] = mapId;
-        (*mapIdCamId)[mapId] = camId;
-        (*mapIdClock)[mapId] = clock();
-
-        // reload data from files
-        long t1 = clock();
-        if (imgs[mapId] == nullptr)
-        {
-            const std::size_t maxSize = mp->getMaxImageWidth() * mp->getMaxImageHeight();
-            imgs[mapId] = new Color[maxSize];
-        }
+    bool loaded = false;
+    std::shared_ptr<Entry> entry = getEntry(camId, loaded);
 
-        const std::string imagePath = imagesNames.at(camId);
-        memcpyRGBImageFromFileToArr(camId, imgs[mapId], imagePath, mp, transposed, bandType);
+    prefetchFromPlan(camId);
 
-        ALICEVISION_LOG_DEBUG("Add " << imagePath << " to image cache. " << formatElapsedTime(t1));
+    if(loaded)
+    {
+        ++_nbHits;
+        return entry->img;
     }
+    return loadEntry(camId, *entry, false);
+}
+
+void ImagesCache::refreshData(int camId)
+{
+    getImg_sync(camId);
 }
 
 Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
 {
-    refreshData(camId);
+    return getImg_sync(camId)->getPixelValueInterpolated(pix);
+}
 
-    // get the image index in the memory
-    const int i = (*camIdMapId)[camId];
-    const Color* img = imgs[i];
-    
-    const int xp = static_cast<int>(pix->x);
-    const int yp = static_cast<int>(pix->y);
+rgb ImagesCache::getPixelValue(const Pixel& pix, int camId)
+{
+    return getImg_sync(camId)->getPixelValue(pix);
+}
 
-    // precision to 4 decimal places
-    const float ui = pix->x - static_cast<float>(xp);
-    const float vi = pix->y - static_cast<float>(yp);
+void ImagesCache::setAccessPlan(const std::vector<int>& accessPlan, int nbPrefetch)
+{
+    {
+        std::lock_guard<std::mutex> lock(_prefetchMutex);
+        _accessPlan = accessPlan;
+        _accessPlanPos = 0;
+        _nbPrefetch = nbPrefetch;
+        _prefetchQueue.clear();
+    }
 
-    const Color lu = img[getPixelId(xp,     yp,     camId)];
-    const Color ru = img[getPixelId(xp + 1, yp,     camId)];
-    const Color rd = img[getPixelId(xp + 1, yp + 1, camId)];
-    const Color ld = img[getPixelId(xp,     yp + 1, camId)];
+    // the images prefetched for the previous plan may not be accessed anymore
+    std::lock_guard<std::mutex> lock(_mutex);
+    for(auto& entry : _entries)
+        entry.second->pinned = false;
+}
 
-    // bilinear interpolation of the pixel intensity value
-    const Color u = lu + (ru - lu) * ui;
-    const Color d = ld + (rd - ld) * ui;
-    const Color out = u + (d - u) * vi;
+void ImagesCache::prefetch(int camId)
+{
+    {
+        std::lock_guard<std::mutex> lock(_prefetchMutex);
+        if(_stopPrefetch)
+            return;
+        _prefetchQueue.push_back(camId);
+        if(!_prefetchThread.joinable())
+            _prefetchThread = std::thread(&ImagesCache::prefetchLoop, this);
+    }
+    _prefetchCondition.notify_one();
+}
 
-    return out;
+void ImagesCache::prefetchFromPlan(int camId)
+{
+    std::vector<int> camIds;
+    {
+        std::lock_guard<std::mutex> lock(_prefetchMutex);
+        if(_nbPrefetch <= 0)
+            return;
+
+        // next occurrence of the camera in the plan
+        const auto it = std::find(_accessPlan.begin() + _accessPlanPos, _accessPlan.end(), camId);
+        if(it == _accessPlan.end())
+            return;
+        _accessPlanPos = std::distance(_accessPlan.begin(), it) + 1;
+
+        const std::size_t prefetchEnd = std::min(_accessPlan.size(), _accessPlanPos + _nbPrefetch);
+        camIds.assign(_accessPlan.begin() + _accessPlanPos, _accessPlan.begin() + prefetchEnd);
+    }
+
+    for(int nextCamId : camIds)
+    {
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            queued = (_entries.count(nextCamId) == 0);
+        }
+        if(queued)
+            prefetch(nextCamId);
+    }
 }
 
-rgb ImagesCache::getPixelValue(const Pixel& pix, int camId)
+void ImagesCache::prefetchLoop()
 {
-    refreshData(camId);
+    while(true)
+    {
+        int camId;
+        {
+            std::unique_lock<std::mutex> lock(_prefetchMutex);
+            _prefetchCondition.wait(lock, [this] { return _stopPrefetch || !_prefetchQueue.empty(); });
+            if(_stopPrefetch)
+                return;
+            camId = _prefetchQueue.front();
+            _prefetchQueue.pop_front();
+        }
 
-    // get the image index in the memory
-    const int imageId = (*camIdMapId)[camId];
-    const Color* img = imgs[imageId];
-    const Color floatRGB = img[getPixelId(pix.x, pix.y, camId)] * 255.0f;
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(_entries.count(camId) != 0)
+                continue; // already in the cache (or being loaded)
+            entry = std::make_shared<Entry>();
+            // prefetched images are kept until they are accessed
+            entry->pinned = true;
+            _lru.push_front(camId);
+            entry->lruIt = _lru.begin();
+            _entries[camId] = entry;
+        }
 
-    return rgb(static_cast<unsigned char>(floatRGB.r),
-               static_cast<unsigned char>(floatRGB.g),
-               static_cast<unsigned char>(floatRGB.b));
+        try
+        {
+            loadEntry(camId, *entry, true);
+        }
+        catch(const std::exception& e)
+        {
+            // the error will be raised again if the image is accessed
+            ALICEVISION_LOG_WARNING("Cannot prefetch image of camera " << camId << ": " << e.what());
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _entries.find(camId);
+            if(it != _entries.end() && it->second == entry)
+            {
+                _lru.erase(entry->lruIt);
+                _entries.erase(it);
+            }
+        }
+    }
+}
+
+ImagesCache::Statistics ImagesCache::getStatistics() const
+{
+    Statistics stats;
+    stats.nbHits = _nbHits;
+    stats.nbMisses = _nbMisses;
+    stats.nbPrefetched = _nbPrefetched;
+    stats.nbEvictions = _nbEvictions;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        stats.memorySize = _memorySize;
+    }
+    stats.maxMemorySize = _maxMemorySize;
+    return stats;
 }
 
 } // namespace mvsUtils
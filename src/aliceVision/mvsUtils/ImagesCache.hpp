@@ -7,25 +7,104 @@
 #pragma once
 
 #include <aliceVision/mvsData/Color.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Rgb.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace aliceVision {
 namespace mvsUtils {
 
+/**
+ * @brief Cache of the camera images, bounded by a memory size ("images_cache.maxmbCPU" in MB).
+ *
+ * The cache can be used by several threads at the same time:
+ * - the images are returned as shared pointers, so an image stays valid while it is used
+ *   even if it is evicted from the cache in the meantime,
+ * - each cache entry has its own lock, so an image is loaded only once and the threads
+ *   only wait for the images they need.
+ * The least recently used images are evicted when the memory size is exceeded.
+ *
+ * The images of the next cameras of an access plan can be loaded in advance by a background thread.
+ */
 class ImagesCache
 {
 public:
-    const MultiViewParams* mp;
+    /**
+     * @brief Image of the cache, stored with the layout given by ImagesCache::transposed
+     */
+    class Img
+    {
+    public:
+        Img(int width, int height, bool transposed)
+            : _width(width)
+            , _height(height)
+            , _transposed(transposed)
+            , _data(static_cast<std::size_t>(width) * height)
+        {}
+
+        inline int width() const { return _width; }
+        inline int height() const { return _height; }
+        inline std::size_t memorySize() const { return _data.size() * sizeof(Color); }
+
+        inline Color* data() { return _data.data(); }
+
+        inline std::size_t getPixelId(int x, int y) const
+        {
+            if(!_transposed)
+                return static_cast<std::size_t>(x) * _height + y;
+            return static_cast<std::size_t>(y) * _width + x;
+        }
+
+        inline const Color& at(int x, int y) const { return _data[getPixelId(x, y)]; }
+
+        /// Bilinear interpolation of the color at the given pixel coordinates
+        Color getPixelValueInterpolated(const Point2d* pix) const;
+
+        /// Color at the given pixel in [0, 255]
+        rgb getPixelValue(const Pixel& pix) const;
 
-    int N_PRELOADED_IMAGES;
-    Color** imgs;
+    private:
+        int _width;
+        int _height;
+        bool _transposed;
+        std::vector<Color> _data;
+    };
+
+    using ImgSharedPtr = std::shared_ptr<Img>;
+
+    /**
+     * @brief Cache usage statistics
+     */
+    struct Statistics
+    {
+        /// number of image requests with the image already in the cache
+        std::size_t nbHits = 0;
+        /// number of image requests that loaded the image
+        std::size_t nbMisses = 0;
+        /// number of images loaded in advance
+        std::size_t nbPrefetched = 0;
+        /// number of images removed from the cache
+        std::size_t nbEvictions = 0;
+        /// current memory size of the images in the cache (in bytes)
+        std::size_t memorySize = 0;
+        /// maximum memory size of the images in the cache (in bytes)
+        std::size_t maxMemorySize = 0;
+    };
+
+    const MultiViewParams* mp;
 
-    StaticVector<int>* camIdMapId;
-    StaticVector<int>* mapIdCamId;
-    StaticVector<long>* mapIdClock;
     std::vector<std::string> imagesNames;
 
     int bandType;
@@ -37,10 +116,96 @@ public:
     void initIC(int _bandType, std::vector<std::string>& _imagesNames, bool _transposed);
     ~ImagesCache();
 
+    ImagesCache(const ImagesCache&) = delete;
+    ImagesCache& operator=(const ImagesCache&) = delete;
+
     int getPixelId(int x, int y, int imgid);
+
+    /**
+     * @brief Get the image of a camera, loaded from the file if it is not in the cache.
+     *        Thread-safe.
+     */
+    ImgSharedPtr getImg_sync(int camId);
+
+    /// Load the image of a camera in the cache if needed. Thread-safe.
     void refreshData(int camId);
+
+    /// Thread-safe, but getImg_sync should be preferred to read many pixels
     Color getPixelValueInterpolated(const Point2d* pix, int camId);
+
+    /// Thread-safe, but getImg_sync should be preferred to read many pixels
     rgb getPixelValue(const Pixel& pix, int camId);
+
+    /**
+     * @brief Set the expected order of the image accesses.
+     *        When a camera of the plan is accessed, the images of the next nbPrefetch cameras of the plan
+     *        are loaded in the background.
+     * @param[in] accessPlan the camera ids in the expected access order
+     * @param[in] nbPrefetch the number of images to load in advance (0 to disable)
+     */
+    void setAccessPlan(const std::vector<int>& accessPlan, int nbPrefetch);
+
+    /// Load the image of a camera in the background
+    void prefetch(int camId);
+
+    Statistics getStatistics() const;
+
+private:
+    struct Entry
+    {
+        /// lock held while the image is loaded
+        std::mutex loadMutex;
+        ImgSharedPtr img;
+        /// memory size of the loaded image (0 while loading), protected by _mutex
+        std::size_t memorySize = 0;
+        /// position in the LRU list, protected by _mutex
+        std::list<int>::iterator lruIt;
+        /// prefetched image not accessed yet, only evicted if the other images do not free enough memory,
+        /// protected by _mutex
+        bool pinned = false;
+    };
+
+    /// Get the entry of a camera (created if needed) and mark it as the most recently used
+    std::shared_ptr<Entry> getEntry(int camId, bool& loaded);
+
+    /// Load the image of the entry if needed
+    ImgSharedPtr loadEntry(int camId, Entry& entry, bool prefetched);
+
+    /// Remove the least recently used images until the memory size fits in the budget,
+    /// the prefetched images not accessed yet last (_mutex must be locked)
+    void evict(int keepCamId);
+
+    /// Remove the least recently used images with the given pinned state until the memory size fits in the budget
+    void evictEntries(int keepCamId, bool pinned);
+
+    /// Queue the cameras following camId in the access plan
+    void prefetchFromPlan(int camId);
+
+    void prefetchLoop();
+
+    std::size_t _maxMemorySize = 0;
+
+    /// protects the cache state below
+    mutable std::mutex _mutex;
+    std::map<int, std::shared_ptr<Entry>> _entries;
+    /// camera ids from the most to the least recently used
+    std::list<int> _lru;
+    std::size_t _memorySize = 0;
+
+    std::atomic<std::size_t> _nbHits{0};
+    std::atomic<std::size_t> _nbMisses{0};
+    std::atomic<std::size_t> _nbPrefetched{0};
+    std::atomic<std::size_t> _nbEvictions{0};
+
+    /// protects the access plan and the prefetch queue
+    std::mutex _prefetchMutex;
+    std::condition_variable _prefetchCondition;
+    std::vector<int> _accessPlan;
+    std::size_t _accessPlanPos = 0;
+    int _nbPrefetch = 0;
+    std::deque<int> _prefetchQueue;
+    bool _stopPrefetch = false;
+    std::thread _prefetchThread;
 };
 
 } // namespace mvsUtils
@@ -0,0 +1,166 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mvsData/structures.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/mvsTestUtils.hpp>
+
+#include <chrono>
+#include <thread>
+
+#define BOOST_TEST_MODULE ImagesCache
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mvsUtils;
+
+static const int imageWidth = 32;
+static const int imageHeight = 24;
+
+/**
+ * @brief Cameras with small images, and a cache budget of 2 images.
+ */
+struct CacheFixture : public SceneFixture
+{
+    explicit CacheFixture(int nbCameras)
+        : SceneFixture("imagesCache", cameraCentersAroundOrigin(nbCameras), imageWidth, imageHeight,
+                       "[images_cache]\n"
+                       "maxmbCPU=0\n"
+                       "[grow]\n"
+                       "minNumOfConsistentCams=2\n")
+    {}
+
+    static std::size_t imageSize() { return sizeof(Color) * imageWidth * imageHeight; }
+};
+
+/// Wait for the background loading of the images (and the evictions it leads to)
+void waitForPrefetch(const ImagesCache& ic, std::size_t nbPrefetched, std::size_t nbEvictions)
+{
+    for(int i = 0; i < 500; ++i)
+    {
+        const ImagesCache::Statistics stats = ic.getStatistics();
+        if(stats.nbPrefetched >= nbPrefetched && stats.nbEvictions >= nbEvictions)
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+void checkStatistics(const ImagesCache& ic, std::size_t nbHits, std::size_t nbMisses, std::size_t nbPrefetched,
+                     std::size_t nbEvictions)
+{
+    const ImagesCache::Statistics stats = ic.getStatistics();
+    BOOST_CHECK_EQUAL(stats.nbHits, nbHits);
+    BOOST_CHECK_EQUAL(stats.nbMisses, nbMisses);
+    BOOST_CHECK_EQUAL(stats.nbPrefetched, nbPrefetched);
+    BOOST_CHECK_EQUAL(stats.nbEvictions, nbEvictions);
+    // the images in the cache never exceed the memory budget
+    BOOST_CHECK_LE(stats.memorySize, stats.maxMemorySize);
+}
+
+BOOST_AUTO_TEST_CASE(ImagesCache_byteBound)
+{
+    CacheFixture scene(4);
+    ImagesCache ic(scene.mp.get(), 0);
+
+    BOOST_CHECK_EQUAL(ic.getStatistics().maxMemorySize, 2 * CacheFixture::imageSize());
+    BOOST_CHECK_EQUAL(ic.getStatistics().memorySize, 0);
+
+    ImagesCache::ImgSharedPtr img0 = ic.getImg_sync(0);
+    BOOST_CHECK_EQUAL(img0->width(), imageWidth);
+    BOOST_CHECK_EQUAL(img0->height(), imageHeight);
+    BOOST_CHECK_EQUAL(img0->memorySize(), CacheFixture::imageSize());
+    BOOST_CHECK_EQUAL(ic.getStatistics().memorySize, CacheFixture::imageSize());
+
+    for(int camId = 1; camId < 4; ++camId)
+    {
+        ic.getImg_sync(camId);
+        BOOST_CHECK_EQUAL(ic.getStatistics().memorySize, std::min(camId + 1, 2) * CacheFixture::imageSize());
+    }
+    checkStatistics(ic, 0, 4, 0, 2);
+
+    // an evicted image stays valid while it is used
+    BOOST_CHECK_CLOSE(img0->at(1, 1).g, 20.0f / 255.0f, 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(ImagesCache_lruOrder)
+{
+    CacheFixture scene(4);
+    ImagesCache ic(scene.mp.get(), 0);
+
+    ic.getImg_sync(0);
+    ic.getImg_sync(1);
+    checkStatistics(ic, 0, 2, 0, 0);
+
+    // 0 becomes the most recently used image, so 1 is evicted by 2
+    ic.getImg_sync(0);
+    checkStatistics(ic, 1, 2, 0, 0);
+    ic.getImg_sync(2);
+    checkStatistics(ic, 1, 3, 0, 1);
+
+    ic.getImg_sync(0);
+    checkStatistics(ic, 2, 3, 0, 1);
+    ic.getImg_sync(1);
+    checkStatistics(ic, 2, 4, 0, 2);
+
+    // 2 was evicted as the least recently used image
+    ic.getImg_sync(0);
+    checkStatistics(ic, 3, 4, 0, 2);
+    ic.getImg_sync(2);
+    checkStatistics(ic, 3, 5, 0, 3);
+}
+
+BOOST_AUTO_TEST_CASE(ImagesCache_prefetch)
+{
+    CacheFixture scene(4);
+    ImagesCache ic(scene.mp.get(), 0);
+
+    ic.setAccessPlan({0, 1, 2, 3}, 1);
+
+    // accessing 0 loads 1 in the background
+    ic.getImg_sync(0);
+    waitForPrefetch(ic, 1, 0);
+    checkStatistics(ic, 0, 1, 1, 0);
+
+    // 1 is already loaded, and accessing it loads 2 in the background
+    ImagesCache::ImgSharedPtr img1 = ic.getImg_sync(1);
+    BOOST_CHECK_CLOSE(img1->at(0, 0).r, 10.0f / 255.0f, 1e-3);
+    // 0 is evicted when 2 is loaded
+    waitForPrefetch(ic, 2, 1);
+    checkStatistics(ic, 1, 1, 2, 1);
+
+    ic.getImg_sync(2);
+    waitForPrefetch(ic, 3, 2);
+    checkStatistics(ic, 2, 1, 3, 2);
+}
+
+BOOST_AUTO_TEST_CASE(ImagesCache_prefetchSeveral)
+{
+    CacheFixture scene(4);
+    ImagesCache ic(scene.mp.get(), 0);
+
+    ic.setAccessPlan({0, 1, 2, 3}, 2);
+
+    // accessing 0 loads 1 and 2 in the background, and 0 is evicted to keep both of them
+    ic.getImg_sync(0);
+    waitForPrefetch(ic, 2, 1);
+    checkStatistics(ic, 0, 1, 2, 1);
+
+    // accessing 1 loads 3 in the background, 1 is evicted as it is not waiting for its first access as 2
+    ic.getImg_sync(1);
+    waitForPrefetch(ic, 3, 2);
+    checkStatistics(ic, 1, 1, 3, 2);
+
+    ImagesCache::ImgSharedPtr img2 = ic.getImg_sync(2);
+    BOOST_CHECK_CLOSE(img2->at(0, 0).r, 20.0f / 255.0f, 1e-3);
+    ic.getImg_sync(3);
+
+    // all the prefetched images are read from the cache, and each image is loaded once
+    const ImagesCache::Statistics stats = ic.getStatistics();
+    BOOST_CHECK_GT(stats.nbHits, 0);
+    BOOST_CHECK_EQUAL(stats.nbMisses + stats.nbPrefetched, 4);
+    checkStatistics(ic, 3, 1, 3, 2);
+}
@@ -0,0 +1,128 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Rgb.hpp>
+#include <aliceVision/mvsData/structures.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/imageIO/image.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace mvsUtils {
+
+/**
+ * @brief Camera looking at the origin from the given center, without distortion.
+ */
+inline CameraMatrices lookAtOrigin(const Point3d& center, int width, int height, float focal = 60.0f)
+{
+    const Point3d z = (Point3d(0.0, 0.0, 0.0) - center).normalize();
+    const Point3d x = cross(Point3d(0.0, 1.0, 0.0), z).normalize();
+    const Point3d y = cross(z, x);
+
+    CameraMatrices cam;
+    cam.R.m11 = x.x; cam.R.m12 = x.y; cam.R.m13 = x.z;
+    cam.R.m21 = y.x; cam.R.m22 = y.y; cam.R.m23 = y.z;
+    cam.R.m31 = z.x; cam.R.m32 = z.y; cam.R.m33 = z.z;
+
+    cam.f = focal;
+    cam.k1 = 0.0f;
+    cam.k2 = 0.0f;
+    cam.K.m11 = cam.f;
+    cam.K.m13 = width / 2.0;
+    cam.K.m22 = cam.f;
+    cam.K.m23 = height / 2.0;
+    cam.K.m33 = 1.0;
+
+    cam.C = center;
+    cam.P = cam.K * (cam.R | (Point3d(0.0, 0.0, 0.0) - cam.R * center));
+    cam.iR = cam.R.inverse();
+    cam.iK = cam.K.inverse();
+    cam.iCam = cam.iR * cam.iK;
+    return cam;
+}
+
+/**
+ * @brief Centers of cameras on a circle of radius 5 around the origin, at alternating heights.
+ */
+inline std::vector<Point3d> cameraCentersAroundOrigin(int nbCameras)
+{
+    std::vector<Point3d> centers;
+    centers.reserve(nbCameras);
+    for(int i = 0; i < nbCameras; ++i)
+    {
+        const double angle = 2.0 * M_PI * i / nbCameras;
+        centers.push_back(Point3d(5.0 * std::cos(angle), 1.0 + (i % 2), 5.0 * std::sin(angle)));
+    }
+    return centers;
+}
+
+/**
+ * @brief Multi-view scene in a temporary folder: cameras looking at the origin from the given centers,
+ *        their images (each image has its own color) and the mvs.ini file, removed at destruction.
+ */
+struct SceneFixture
+{
+    boost::filesystem::path folder;
+    StaticVector<CameraMatrices> cameras;
+    std::unique_ptr<MultiViewParams> mp;
+
+    /**
+     * @param[in] name the prefix of the temporary folder
+     * @param[in] centers the camera centers
+     * @param[in] width the images width
+     * @param[in] height the images height
+     * @param[in] iniSections additional sections of the mvs.ini file
+     */
+    SceneFixture(const std::string& name, const std::vector<Point3d>& centers, int width, int height,
+                 const std::string& iniSections = "")
+    {
+        namespace bfs = boost::filesystem;
+
+        folder = bfs::temp_directory_path() / bfs::unique_path(name + "_%%%%-%%%%");
+        bfs::create_directories(folder);
+
+        const int nbCameras = static_cast<int>(centers.size());
+        const std::string iniFile = (folder / "mvs.ini").string();
+        {
+            std::ofstream ini(iniFile);
+            ini << "[global]\n"
+                << "ncams=" << nbCameras << "\n"
+                << "imgExt=png\n"
+                << iniSections
+                << "[imageResolutions]\n";
+            for(int i = 0; i < nbCameras; ++i)
+                ini << i << "=" << width << "x" << height << "\n";
+        }
+
+        cameras.reserve(nbCameras);
+        for(int i = 0; i < nbCameras; ++i)
+        {
+            const std::vector<rgb> image(width * height, rgb(10 * i, 20, 30));
+            imageIO::writeImage((folder / (std::to_string(i) + ".png")).string(), width, height, image);
+            cameras.push_back(lookAtOrigin(centers[i], width, height));
+        }
+
+        mp.reset(new MultiViewParams(iniFile, folder.string(), folder.string(), false, 1, &cameras));
+    }
+
+    ~SceneFixture()
+    {
+        mp.reset();
+        boost::filesystem::remove_all(folder);
+    }
+};
+
+} // namespace mvsUtils
+} // namespace aliceVision
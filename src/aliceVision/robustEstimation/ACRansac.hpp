@@ -37,6 +37,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <limits>
@@ -144,6 +146,99 @@ inline ErrorIndex bestNFA(
   return bestIndex;
 }
 
+/**
+ * @brief Bound of the residuals needed to find a NFA lower than minNFA with bestNFA.
+ *
+ * The residuals lower than maxThreshold are counted in bins of their binary exponent and
+ * two first mantissa bits (4 bins per octave). The NFA of the k first sorted residuals is
+ * bounded below by the NFA computed with the lower edge of the bin of the k-th residual,
+ * so only the residuals of the bins up to the last one with a bound lower than minNFA have
+ * to be sorted, and the model can be skipped without any sort if there is no such bin.
+ *
+ * @param[in] startIndex number of point required for estimation
+ * @param[in] residuals residuals of the model
+ * @param[in] minNFA best NFA so far
+ * @param[in,out] histogram buffer of the bins, reused from one call to the other
+ * @return the residuals upper bound (exclusive), a negative value if the NFA can't be lower than minNFA
+ */
+inline double boundNFAResiduals(
+  int startIndex,
+  double logalpha0,
+  const std::vector<double>& residuals,
+  double loge0,
+  double maxThreshold,
+  const std::vector<float> &logc_n,
+  const std::vector<float> &logc_k,
+  double multError,
+  double minNFA,
+  std::vector<int>& histogram)
+{
+  if(minNFA == std::numeric_limits<double>::infinity())
+    return std::numeric_limits<double>::infinity();
+
+  // bin of a positive residual: the order of the bits of positive doubles is the order of their values
+  const auto binOf = [](double value) -> int
+  {
+    value = (value > 0.0) ? value : 0.0;
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return static_cast<int>(bits >> 50);
+  };
+  const auto binLowerEdge = [](int bin) -> double
+  {
+    const std::uint64_t bits = static_cast<std::uint64_t>(bin) << 50;
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  };
+
+  int minBin = std::numeric_limits<int>::max();
+  int maxBin = 0;
+  for(const double residual : residuals)
+  {
+    if(residual <= maxThreshold) // also excludes the NaN residuals
+    {
+      const int bin = binOf(residual);
+      minBin = std::min(minBin, bin);
+      maxBin = std::max(maxBin, bin);
+    }
+  }
+  if(minBin > maxBin)
+    return -1.0;
+
+  histogram.assign(maxBin - minBin + 1, 0);
+  for(const double residual : residuals)
+  {
+    if(residual <= maxThreshold)
+      ++histogram[binOf(residual) - minBin];
+  }
+
+  // small margin against the rounding differences with bestNFA
+  const double threshold = minNFA + 1e-9 * std::max(1.0, std::abs(minNFA));
+  double bound = -1.0;
+  std::size_t nbResiduals = 0;
+  for(std::size_t b = 0; b < histogram.size(); ++b)
+  {
+    if(histogram[b] == 0)
+      continue;
+    const std::size_t kBegin = std::max(nbResiduals + 1, static_cast<std::size_t>(startIndex + 1));
+    nbResiduals += histogram[b];
+    if(kBegin > nbResiduals)
+      continue;
+    const double logalpha = logalpha0 +
+      multError * log10(binLowerEdge(minBin + b) + std::numeric_limits<float>::epsilon());
+    for(std::size_t k = kBegin; k <= nbResiduals; ++k)
+    {
+      if(loge0 + logalpha * (double) (k - startIndex) + logc_n[k] + logc_k[k] < threshold)
+      {
+        bound = binLowerEdge(minBin + b + 1);
+        break;
+      }
+    }
+  }
+  return bound;
+}
+
 
 /**
  * @brief ACRANSAC routine (ErrorThreshold, NFA)
@@ -176,8 +271,10 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
     std::numeric_limits<double>::infinity() :
     precision * kernel.normalizer2()(0,0) * kernel.normalizer2()(0,0);
 
-  std::vector<ErrorIndex> vec_residuals(nData); // [residual,index]
+  std::vector<ErrorIndex> vec_residuals; // [residual,index]
+  vec_residuals.reserve(nData);
   std::vector<double> vec_residuals_(nData);
+  std::vector<int> histogram; // residuals histogram of boundNFAResiduals
 
   // Possible sampling indices [0,..,nData] (will change in the optimization phase)
   std::vector<size_t> vec_index(nData);
@@ -230,10 +327,27 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
       }
       if (bACRansacMode)
       {
+        // Only the residuals that can give a better NFA are sorted
+        const double residualsBound = boundNFAResiduals(
+          sizeSample,
+          kernel.logalpha0(),
+          vec_residuals_,
+          loge0,
+          maxThreshold,
+          vec_logc_n,
+          vec_logc_k,
+          kernel.multError(),
+          minNFA,
+          histogram);
+        if (residualsBound < 0.0)
+          continue; // the model can't be better than the best model so far
+
+        vec_residuals.clear();
         for (size_t i = 0; i < nData; ++i)
         {
           const double error = vec_residuals_[i];
-          vec_residuals[i] = ErrorIndex(error, i);
+          if (error <= maxThreshold && error < residualsBound)
+            vec_residuals.emplace_back(error, i);
         }
         std::sort(vec_residuals.begin(), vec_residuals.end());
 
@@ -84,6 +84,29 @@ inline bool hasStrongSupport(const matching::MatchesPerDescType& matchesPerDesc,
   return (score > minimumSamples);
 }
 
+/// Errors of all the correspondences with the vectorized Errors() of the error model, if it has one
+template <typename ErrorT, typename ModelT>
+auto computeTwoViewErrors(const ModelT &model, const Mat &x1, const Mat &x2, std::vector<double> &vec_errors, int)
+  -> decltype(ErrorT::Errors(model, x1, x2, vec_errors), void())
+{
+  ErrorT::Errors(model, x1, x2, vec_errors);
+}
+
+/// Errors of all the correspondences, one by one
+template <typename ErrorT, typename ModelT>
+void computeTwoViewErrors(const ModelT &model, const Mat &x1, const Mat &x2, std::vector<double> &vec_errors, long)
+{
+  vec_errors.resize(x1.cols());
+  for(std::size_t sample = 0; sample < x1.cols(); ++sample)
+    vec_errors[sample] = ErrorT::Error(model, x1.col(sample), x2.col(sample));
+}
+
+/// Errors of all the correspondences of a two view error model
+template <typename ErrorT, typename ModelT>
+void computeTwoViewErrors(const ModelT &model, const Mat &x1, const Mat &x2, std::vector<double> &vec_errors)
+{
+  computeTwoViewErrors<ErrorT>(model, x1, x2, vec_errors, 0);
+}
 
 /// Two view Kernel adapter for the A contrario model estimator
 /// Handle data normalization and compute the corresponding logalpha 0
@@ -154,9 +177,7 @@ public:
 
   void Errors(const Model & model, std::vector<double> & vec_errors) const
   {
-    vec_errors.resize(x1_.cols());
-    for(std::size_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x1_.col(sample), x2_.col(sample));
+    computeTwoViewErrors<ErrorT>(model, x1_, x2_, vec_errors);
   }
 
   std::size_t NumSamples() const
@@ -411,9 +432,7 @@ public:
   {
     Mat3 F;
     FundamentalFromEssential(model, K1_, K2_, &F);
-    vec_errors.resize(x1_.cols());
-    for(std::size_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(F, this->x1_.col(sample), this->x2_.col(sample));
+    computeTwoViewErrors<ErrorT>(F, x1_, x2_, vec_errors);
   }
 
   std::size_t NumSamples() const { return x1_.cols(); }
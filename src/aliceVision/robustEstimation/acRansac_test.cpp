@@ -5,6 +5,7 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file,
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
+#include <algorithm>
 #include <iterator>
 #include <random>
 
@@ -362,3 +363,71 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACSimu)
 
   }
 }
+
+// Check that the NFA of the residuals bounded by boundNFAResiduals is the NFA of all the residuals,
+// when it is lower than the best NFA so far
+BOOST_AUTO_TEST_CASE(ACRANSAC_boundNFAResiduals)
+{
+  const std::size_t nData = 500;
+  const int sizeSample = 2;
+  const double logalpha0 = log10(2.0 / 100.0);
+  const double loge0 = log10(1.0 * (nData - sizeSample));
+  std::vector<float> vec_logc_n, vec_logc_k;
+  makelogcombi(sizeSample, nData, vec_logc_k, vec_logc_n);
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> outlierDistribution(0.0, 1e4);
+  std::exponential_distribution<double> inlierDistribution(1.0);
+  std::vector<int> histogram;
+  int nbSkipped = 0;
+
+  for(int iter = 0; iter < 200; ++iter)
+  {
+    // residuals of a model with a random inlier ratio
+    const std::size_t nbInliers = (iter * 7) % nData;
+    std::vector<double> residuals(nData);
+    for(std::size_t i = 0; i < nData; ++i)
+      residuals[i] = (i < nbInliers) ? inlierDistribution(gen) : outlierDistribution(gen);
+    residuals[iter % nData] = 0.0;
+
+    std::vector<ErrorIndex> sortedResiduals;
+    for(std::size_t i = 0; i < nData; ++i)
+      sortedResiduals.emplace_back(residuals[i], i);
+    std::sort(sortedResiduals.begin(), sortedResiduals.end());
+
+    for(const double maxThreshold : {std::numeric_limits<double>::infinity(), 50.0})
+    {
+      const ErrorIndex best = bestNFA(sizeSample, logalpha0, sortedResiduals, loge0, maxThreshold, vec_logc_n, vec_logc_k, 0.5);
+
+      for(const double minNFA : {std::numeric_limits<double>::infinity(), 10.0, -10.0, -100.0, best.first, best.first + 1e-3})
+      {
+        const double bound = boundNFAResiduals(sizeSample, logalpha0, residuals, loge0, maxThreshold, vec_logc_n, vec_logc_k, 0.5, minNFA, histogram);
+        if(bound < 0.0)
+        {
+          // no better NFA
+          BOOST_CHECK(!(best.first < minNFA));
+          ++nbSkipped;
+          continue;
+        }
+        std::vector<ErrorIndex> boundedResiduals;
+        for(const ErrorIndex& residual : sortedResiduals)
+        {
+          if(residual.first <= maxThreshold && residual.first < bound)
+            boundedResiduals.push_back(residual);
+        }
+        const ErrorIndex boundedBest = bestNFA(sizeSample, logalpha0, boundedResiduals, loge0, maxThreshold, vec_logc_n, vec_logc_k, 0.5);
+        if(best.first < minNFA)
+        {
+          BOOST_CHECK_EQUAL(boundedBest.first, best.first);
+          BOOST_CHECK_EQUAL(boundedBest.second, best.second);
+        }
+        else
+        {
+          BOOST_CHECK(!(boundedBest.first < minNFA));
+        }
+      }
+    }
+  }
+  // most of the models worse than the best NFA are skipped without sorting their residuals
+  BOOST_CHECK_GT(nbSkipped, 0);
+}
@@ -19,8 +19,29 @@ using namespace aliceVision::camera;
 using namespace aliceVision::geometry;
 
 /// Create the appropriate cost functor according the provided input camera intrinsic model
-ceres::CostFunction* createCostFunctionFromIntrinsics(IntrinsicBase* intrinsic, const Vec2& observation)
+ceres::CostFunction* createCostFunctionFromIntrinsics(IntrinsicBase* intrinsic, const Vec2& observation, bool analyticJacobians)
 {
+  if(analyticJacobians)
+  {
+    switch(intrinsic->getType())
+    {
+      case PINHOLE_CAMERA:
+        return new ResidualErrorCostFunction<distortion::Pinhole>(observation.data());
+      case PINHOLE_CAMERA_RADIAL1:
+        return new ResidualErrorCostFunction<distortion::PinholeRadialK1>(observation.data());
+      case PINHOLE_CAMERA_RADIAL3:
+        return new ResidualErrorCostFunction<distortion::PinholeRadialK3>(observation.data());
+      case PINHOLE_CAMERA_BROWN:
+        return new ResidualErrorCostFunction<distortion::PinholeBrownT2>(observation.data());
+      case PINHOLE_CAMERA_FISHEYE:
+        return new ResidualErrorCostFunction<distortion::PinholeFisheye>(observation.data());
+      case PINHOLE_CAMERA_FISHEYE1:
+        return new ResidualErrorCostFunction<distortion::PinholeFisheye1>(observation.data());
+      default:
+        throw std::logic_error("Unrecognized intrinsic type in BA.");
+    }
+  }
+
   switch(intrinsic->getType())
   {
     case PINHOLE_CAMERA:
@@ -51,8 +72,29 @@ ceres::CostFunction* createCostFunctionFromIntrinsics(IntrinsicBase* intrinsic,
 }
 
 /// Create the appropriate cost functor according the provided input rig camera intrinsic model
-ceres::CostFunction* createRigCostFunctionFromIntrinsics(IntrinsicBase* intrinsic, const Vec2& observation)
+ceres::CostFunction* createRigCostFunctionFromIntrinsics(IntrinsicBase* intrinsic, const Vec2& observation, bool analyticJacobians)
 {
+  if(analyticJacobians)
+  {
+    switch(intrinsic->getType())
+    {
+      case PINHOLE_CAMERA:
+        return new ResidualErrorRigCostFunction<distortion::Pinhole>(observation.data());
+      case PINHOLE_CAMERA_RADIAL1:
+        return new ResidualErrorRigCostFunction<distortion::PinholeRadialK1>(observation.data());
+      case PINHOLE_CAMERA_RADIAL3:
+        return new ResidualErrorRigCostFunction<distortion::PinholeRadialK3>(observation.data());
+      case PINHOLE_CAMERA_BROWN:
+        return new ResidualErrorRigCostFunction<distortion::PinholeBrownT2>(observation.data());
+      case PINHOLE_CAMERA_FISHEYE:
+        return new ResidualErrorRigCostFunction<distortion::PinholeFisheye>(observation.data());
+      case PINHOLE_CAMERA_FISHEYE1:
+        return new ResidualErrorRigCostFunction<distortion::PinholeFisheye1>(observation.data());
+      default:
+        throw std::logic_error("Unrecognized intrinsic type in BA.");
+    }
+  }
+
   switch(intrinsic->getType())
   {
     case PINHOLE_CAMERA:
@@ -151,6 +193,7 @@ BundleAdjustmentCeres::BA_options::BA_options(const bool verbose, bool multithre
     _nbThreads = 1;
 
   _bCeres_Summary = false;
+  _bAnalyticJacobians = false;
   
   // Use dense BA by default
   setDenseBA();
@@ -199,9 +242,32 @@ BundleAdjustmentCeres::BundleAdjustmentCeres(
   : _aliceVision_options(options)
 {}
 
+HashMap<IndexT, std::size_t> BundleAdjustmentCeres::computeIntrinsicsUsage(const sfmData::SfMData& sfmData)
+{
+  HashMap<IndexT, std::size_t> intrinsicsUsage;
+  for(const auto& itView: sfmData.getViews())
+  {
+    const sfmData::View* v = itView.second.get();
+    if (sfmData.isPoseAndIntrinsicDefined(v))
+    {
+      if(intrinsicsUsage.find(v->getIntrinsicId()) == intrinsicsUsage.end())
+        intrinsicsUsage[v->getIntrinsicId()] = 1;
+      else
+        ++intrinsicsUsage[v->getIntrinsicId()];
+    }
+    else
+    {
+      if(intrinsicsUsage.find(v->getIntrinsicId()) == intrinsicsUsage.end())
+        intrinsicsUsage[v->getIntrinsicId()] = 0;
+    }
+  }
+  return intrinsicsUsage;
+}
+
 void BundleAdjustmentCeres::createProblem(sfmData::SfMData& sfmData,
                                           BA_Refine refineOptions,
-                                          ceres::Problem& problem)
+                                          ceres::Problem& problem,
+                                          const HashMap<IndexT, std::size_t>* intrinsicsUsage)
 {
   // Ensure we are not using incompatible options:
   //  - BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS and BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA cannot be used at the same time
@@ -246,35 +312,21 @@ void BundleAdjustmentCeres::createProblem(sfmData::SfMData& sfmData,
     }
   }
 
-  HashMap<IndexT, std::size_t> intrinsicsUsage;
-
   // Setup Intrinsics data & subparametrization
   const bool refineIntrinsicsOpticalCenter = (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) || (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA);
   const bool refineIntrinsics = (refineOptions & BA_REFINE_INTRINSICS_FOCAL) ||
                                 (refineOptions & BA_REFINE_INTRINSICS_DISTORTION) ||
                                 refineIntrinsicsOpticalCenter;
-  for(const auto& itView: sfmData.getViews())
-  {
-    const sfmData::View* v = itView.second.get();
-    if (sfmData.isPoseAndIntrinsicDefined(v))
-    {
-      if(intrinsicsUsage.find(v->getIntrinsicId()) == intrinsicsUsage.end())
-        intrinsicsUsage[v->getIntrinsicId()] = 1;
-      else
-        ++intrinsicsUsage[v->getIntrinsicId()];
-    }
-    else
-    {
-      if(intrinsicsUsage.find(v->getIntrinsicId()) == intrinsicsUsage.end())
-        intrinsicsUsage[v->getIntrinsicId()] = 0;
-    }
-  }
+
+  HashMap<IndexT, std::size_t> localIntrinsicsUsage = computeIntrinsicsUsage(sfmData);
+  // the optical centers may be refined from the usage of the intrinsics in a larger scene
+  const HashMap<IndexT, std::size_t>& opticalCenterUsage = (intrinsicsUsage != nullptr) ? *intrinsicsUsage : localIntrinsicsUsage;
 
   // Setup Intrinsics data & subparametrization
   for(const auto& itIntrinsic: sfmData.getIntrinsics())
   {
     const IndexT idIntrinsics = itIntrinsic.first;
-    if(intrinsicsUsage[idIntrinsics] == 0)
+    if(localIntrinsicsUsage[idIntrinsics] == 0)
     {
       continue;
     }
@@ -321,7 +373,8 @@ void BundleAdjustmentCeres::createProblem(sfmData::SfMData& sfmData,
 
       // Optical center
       if((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) ||
-         ((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA) && intrinsicsUsage[idIntrinsics] > minImagesForOpticalCenter)
+         ((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA) &&
+          opticalCenterUsage.count(idIntrinsics) && opticalCenterUsage.at(idIntrinsics) > minImagesForOpticalCenter)
          )
       {
         // Refine optical center within 10% of the image size.
@@ -383,7 +436,7 @@ void BundleAdjustmentCeres::createProblem(sfmData::SfMData& sfmData,
 
       if(view->isPartOfRig())
       {
-        ceres::CostFunction* costFunction = createRigCostFunctionFromIntrinsics(sfmData.intrinsics[view->getIntrinsicId()].get(), observationIt.second.x);
+        ceres::CostFunction* costFunction = createRigCostFunctionFromIntrinsics(sfmData.intrinsics[view->getIntrinsicId()].get(), observationIt.second.x, _aliceVision_options._bAnalyticJacobians);
 
         const sfmData::Rig& rig = sfmData.getRig(*view);
         const sfmData::RigSubPose& rigSubPose = rig.getSubPose(view->getSubPoseId());
@@ -401,7 +454,7 @@ void BundleAdjustmentCeres::createProblem(sfmData::SfMData& sfmData,
       }
       else
       {
-        ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(sfmData.intrinsics[view->getIntrinsicId()].get(), observationIt.second.x);
+        ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(sfmData.intrinsics[view->getIntrinsicId()].get(), observationIt.second.x, _aliceVision_options._bAnalyticJacobians);
 
         problem.AddResidualBlock(
           costFunction,
@@ -435,6 +488,27 @@ void BundleAdjustmentCeres::createJacobian(sfmData::SfMData& sfmData,
   problem.Evaluate(evalOpt, &cost, NULL, NULL, &jacobian);
 }
 
+double* BundleAdjustmentCeres::getPoseParameterBlock(IndexT poseId)
+{
+  auto it = map_poses.find(poseId);
+  return (it == map_poses.end()) ? nullptr : it->second.data();
+}
+
+double* BundleAdjustmentCeres::getSubPoseParameterBlock(IndexT rigId, IndexT subPoseId)
+{
+  auto rigIt = map_subposes.find(rigId);
+  if(rigIt == map_subposes.end())
+    return nullptr;
+  auto it = rigIt->second.find(subPoseId);
+  return (it == rigIt->second.end()) ? nullptr : it->second.data();
+}
+
+double* BundleAdjustmentCeres::getIntrinsicParameterBlock(IndexT intrinsicId)
+{
+  auto it = map_intrinsics.find(intrinsicId);
+  return (it == map_intrinsics.end()) ? nullptr : it->second.data();
+}
+
 bool BundleAdjustmentCeres::Adjust(sfmData::SfMData& sfmData,     // the SfM scene to refine
                                    BA_Refine refineOptions)
 {
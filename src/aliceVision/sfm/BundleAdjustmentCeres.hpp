@@ -10,6 +10,7 @@
 #include <aliceVision/types.hpp>
 #include <aliceVision/sfm/BundleAdjustment.hpp>
 #include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
 
 #include <ceres/ceres.h>
 
@@ -21,9 +22,15 @@ class SfMData;
 
 namespace sfm {
 
-/// Create the appropriate cost functor according the provided input camera intrinsic model
-ceres::CostFunction* createCostFunctionFromIntrinsics(camera::IntrinsicBase* intrinsic, const Vec2& observation);
-ceres::CostFunction* createRigCostFunctionFromIntrinsics(camera::IntrinsicBase* intrinsic, const Vec2& observation);
+/**
+ * @brief Create the appropriate cost functor according the provided input camera intrinsic model
+ * @param[in] intrinsic the camera intrinsic model
+ * @param[in] observation the 2D observation
+ * @param[in] analyticJacobians use the cost functions with analytic Jacobians (ResidualErrorCostFunction)
+ *            instead of the automatic differentiation of the ResidualErrorFunctor_* functors
+ */
+ceres::CostFunction* createCostFunctionFromIntrinsics(camera::IntrinsicBase* intrinsic, const Vec2& observation, bool analyticJacobians = false);
+ceres::CostFunction* createRigCostFunctionFromIntrinsics(camera::IntrinsicBase* intrinsic, const Vec2& observation, bool analyticJacobians = false);
 
 class BundleAdjustmentCeres : public BundleAdjustment
 {
@@ -33,6 +40,8 @@ public:
     bool _bVerbose;
     unsigned int _nbThreads;
     bool _bCeres_Summary;
+    /// use the cost functions with analytic Jacobians instead of the automatic differentiation (off by default)
+    bool _bAnalyticJacobians;
     ceres::LinearSolverType _linear_solver_type;
     ceres::PreconditionerType _preconditioner_type;
     ceres::SparseLinearAlgebraLibraryType _sparse_linear_algebra_library_type;
@@ -54,9 +63,28 @@ private:
 public:
 
   BundleAdjustmentCeres(BundleAdjustmentCeres::BA_options options = BA_options());
-  void createProblem(sfmData::SfMData& sfmData, BA_Refine refineOptions, ceres::Problem& problem);
+
+  /**
+   * @brief Number of views with a pose using each intrinsic of a scene
+   */
+  static HashMap<IndexT, std::size_t> computeIntrinsicsUsage(const sfmData::SfMData& sfmData);
+
+  /**
+   * @brief Create the bundle adjustment problem of a scene
+   * @param[in] intrinsicsUsage number of views using each intrinsic, to decide the refinement of the optical centers
+   *            with BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA (computed from sfmData if nullptr)
+   */
+  void createProblem(sfmData::SfMData& sfmData, BA_Refine refineOptions, ceres::Problem& problem,
+                     const HashMap<IndexT, std::size_t>* intrinsicsUsage = nullptr);
   void createJacobian(sfmData::SfMData& sfmData, BA_Refine refineOptions, ceres::CRSMatrix& jacobian);
 
+  /// Parameter block [R;t] of a pose in the problem created by createProblem (nullptr if not in the problem)
+  double* getPoseParameterBlock(IndexT poseId);
+  /// Parameter block [R;t] of a rig sub-pose in the problem created by createProblem (nullptr if not in the problem)
+  double* getSubPoseParameterBlock(IndexT rigId, IndexT subPoseId);
+  /// Parameter block of an intrinsic in the problem created by createProblem (nullptr if not in the problem)
+  double* getIntrinsicParameterBlock(IndexT intrinsicId);
+
   /**
    * @see BundleAdjustment::Adjust
    */
@@ -0,0 +1,954 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/BundleAdjustmentPartitioned.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <ceres/rotation.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <queue>
+#include <set>
+
+namespace aliceVision {
+namespace sfm {
+
+using namespace aliceVision::camera;
+using namespace aliceVision::geometry;
+
+namespace {
+
+/**
+ * @brief Proximal term of a parameter block to its consensus value:
+ *        residual_i = sqrt(weight_i) * (x_i - target_i)
+ *        The target is updated between the solves.
+ */
+class ConsensusCostFunction : public ceres::CostFunction
+{
+public:
+  ConsensusCostFunction(const double* target, const std::vector<double>& weights)
+    : _target(target)
+  {
+    _sqrtWeights.reserve(weights.size());
+    for(double weight : weights)
+      _sqrtWeights.push_back(std::sqrt(weight));
+    set_num_residuals(weights.size());
+    mutable_parameter_block_sizes()->push_back(weights.size());
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const std::size_t size = _sqrtWeights.size();
+    for(std::size_t i = 0; i < size; ++i)
+      residuals[i] = _sqrtWeights[i] * (parameters[0][i] - _target[i]);
+
+    if(jacobians != nullptr && jacobians[0] != nullptr)
+    {
+      std::fill(jacobians[0], jacobians[0] + size * size, 0.0);
+      for(std::size_t i = 0; i < size; ++i)
+        jacobians[0][i * size + i] = _sqrtWeights[i];
+    }
+    return true;
+  }
+
+private:
+  const double* _target;
+  std::vector<double> _sqrtWeights;
+};
+
+/**
+ * @brief Parameter block shared by several clusters
+ */
+struct ConsensusParameter
+{
+  /// consensus value
+  std::vector<double> value;
+  /// accumulators of the weighted average of the cluster values
+  std::vector<double> weightedSum;
+  std::vector<double> weightSum;
+};
+
+/**
+ * @brief Type of a parameter block shared by several clusters
+ */
+enum class ESharedParameter
+{
+  POSE,
+  SUBPOSE,
+  INTRINSIC,
+  LANDMARK
+};
+
+/**
+ * @brief Copy of a shared parameter block in a cluster
+ */
+struct LocalParameter
+{
+  ESharedParameter type = ESharedParameter::POSE;
+  /// id of the pose, rig, intrinsic or landmark
+  IndexT id = UndefinedIndexT;
+  /// id of the sub-pose in the rig
+  IndexT subPoseId = UndefinedIndexT;
+  std::size_t consensusId = 0;
+  /// value in the cluster after its last solve
+  std::vector<double> value;
+  /// weights of the proximal term
+  std::vector<double> weights;
+  /// scaled dual variable
+  std::vector<double> dual;
+  /// target of the proximal term (consensus value - dual variable)
+  std::vector<double> target;
+};
+
+/**
+ * @brief State of a cluster between its solves.
+ *        The sub-scene and the ceres::Problem of a cluster only exist while the cluster is solved,
+ *        the state only keeps the content of the sub-scene and the values of the shared parameters.
+ *        The parameters only refined by this cluster are kept in the scene.
+ */
+struct ClusterState
+{
+  /// poses of the sub-scene (assigned poses and poses of its views)
+  std::vector<IndexT> poseIds;
+  /// views of the sub-scene
+  std::vector<IndexT> viewIds;
+  /// landmarks of the sub-scene
+  std::vector<IndexT> landmarkIds;
+  /// views of the observations of the landmarks assigned to the cluster:
+  /// observationViewIds[observationOffsets[i], observationOffsets[i + 1]) for the landmark landmarkIds[i]
+  std::vector<std::size_t> observationOffsets = {0};
+  std::vector<IndexT> observationViewIds;
+  std::vector<LocalParameter> sharedParameters;
+  std::size_t nbResiduals = 0;
+};
+
+/**
+ * @brief Identifiers of the consensus parameters, for each type of parameter block
+ */
+struct ConsensusIds
+{
+  HashMap<IndexT, std::size_t> poses;
+  std::map<std::pair<IndexT, IndexT>, std::size_t> subPoses;
+  HashMap<IndexT, std::size_t> intrinsics;
+  HashMap<IndexT, std::size_t> landmarks;
+};
+
+/// Rig sub-poses observed by the views of a scene
+std::set<std::pair<IndexT, IndexT>> getObservedSubPoses(const sfmData::SfMData& sfmData)
+{
+  std::set<std::pair<IndexT, IndexT>> subPoses;
+  for(const auto& viewIt : sfmData.getViews())
+  {
+    if(viewIt.second->isPartOfRig())
+      subPoses.emplace(viewIt.second->getRigId(), viewIt.second->getSubPoseId());
+  }
+  return subPoses;
+}
+
+/**
+ * @brief Accumulate the diagonal of the Gauss-Newton Hessian (J^T.J) of the reprojection errors
+ *        for each parameter block of the problem of a cluster.
+ * @param[in] analyticJacobians evaluate the cost functions with analytic Jacobians instead of automatic differentiation
+ * @return the number of residuals
+ */
+std::size_t computeHessianDiagonal(sfmData::SfMData& sfmData, BundleAdjustmentCeres& ba, bool analyticJacobians,
+                                   std::map<const double*, std::vector<double>>& hessianDiagonal)
+{
+  std::size_t nbResiduals = 0;
+  std::vector<std::vector<double>> jacobians(4);
+
+  for(auto& landmarkIt : sfmData.structure)
+  {
+    for(const auto& observationIt : landmarkIt.second.observations)
+    {
+      const sfmData::View& view = *sfmData.getViews().at(observationIt.first);
+      IntrinsicBase* intrinsic = sfmData.getIntrinsics().at(view.getIntrinsicId()).get();
+
+      std::vector<double*> blocks;
+      blocks.push_back(ba.getIntrinsicParameterBlock(view.getIntrinsicId()));
+      blocks.push_back(ba.getPoseParameterBlock(view.getPoseId()));
+      std::vector<int> blockSizes = {static_cast<int>(intrinsic->getParams().size()), 6};
+
+      std::unique_ptr<ceres::CostFunction> costFunction;
+      if(view.isPartOfRig())
+      {
+        costFunction.reset(createRigCostFunctionFromIntrinsics(intrinsic, observationIt.second.x, analyticJacobians));
+        blocks.push_back(ba.getSubPoseParameterBlock(view.getRigId(), view.getSubPoseId()));
+        blockSizes.push_back(6);
+      }
+      else
+      {
+        costFunction.reset(createCostFunctionFromIntrinsics(intrinsic, observationIt.second.x, analyticJacobians));
+      }
+      blocks.push_back(landmarkIt.second.X.data());
+      blockSizes.push_back(3);
+
+      std::vector<double*> jacobiansPtr;
+      for(std::size_t i = 0; i < blocks.size(); ++i)
+      {
+        jacobians[i].resize(2 * blockSizes[i]);
+        jacobiansPtr.push_back(jacobians[i].data());
+      }
+
+      double residuals[2];
+      costFunction->Evaluate(blocks.data(), residuals, jacobiansPtr.data());
+
+      for(std::size_t i = 0; i < blocks.size(); ++i)
+      {
+        std::vector<double>& diagonal = hessianDiagonal[blocks[i]];
+        diagonal.resize(blockSizes[i], 0.0);
+        for(int j = 0; j < blockSizes[i]; ++j)
+          diagonal[j] += jacobians[i][j] * jacobians[i][j] + jacobians[i][blockSizes[i] + j] * jacobians[i][blockSizes[i] + j];
+      }
+      nbResiduals += 2;
+    }
+  }
+  return nbResiduals;
+}
+
+/// Convert a [R;t] parameter block to a pose
+geometry::Pose3 poseFromBlock(const double* block)
+{
+  Mat3 R;
+  ceres::AngleAxisToRotationMatrix(block, R.data());
+  const Vec3 t(block[3], block[4], block[5]);
+  return poseFromRT(R, t);
+}
+
+/// Parameter block of a shared parameter in the problem of a cluster
+double* getParameterBlock(BundleAdjustmentCeres& ba, sfmData::SfMData& sfmData, const LocalParameter& parameter)
+{
+  switch(parameter.type)
+  {
+    case ESharedParameter::POSE:      return ba.getPoseParameterBlock(parameter.id);
+    case ESharedParameter::SUBPOSE:   return ba.getSubPoseParameterBlock(parameter.id, parameter.subPoseId);
+    case ESharedParameter::INTRINSIC: return ba.getIntrinsicParameterBlock(parameter.id);
+    case ESharedParameter::LANDMARK:  return sfmData.structure.at(parameter.id).X.data();
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Build the sub-scene of a cluster from the current values of the scene.
+ *        Each cluster refines its own copy of the intrinsics.
+ */
+void buildClusterScene(const sfmData::SfMData& sfmData, const ClusterState& cluster, sfmData::SfMData& clusterSfmData)
+{
+  for(IndexT poseId : cluster.poseIds)
+    clusterSfmData.getPoses()[poseId] = sfmData.getPoses().at(poseId);
+
+  for(IndexT viewId : cluster.viewIds)
+  {
+    const std::shared_ptr<sfmData::View>& view = sfmData.views.at(viewId);
+    clusterSfmData.views[viewId] = view;
+    if(!clusterSfmData.intrinsics.count(view->getIntrinsicId()))
+      clusterSfmData.intrinsics[view->getIntrinsicId()].reset(sfmData.intrinsics.at(view->getIntrinsicId())->clone());
+    if(view->isPartOfRig() && !clusterSfmData.getRigs().count(view->getRigId()))
+      clusterSfmData.getRigs()[view->getRigId()] = sfmData.getRigs().at(view->getRigId());
+  }
+
+  for(std::size_t i = 0; i < cluster.landmarkIds.size(); ++i)
+  {
+    const sfmData::Landmark& landmark = sfmData.structure.at(cluster.landmarkIds[i]);
+    sfmData::Landmark& clusterLandmark = clusterSfmData.structure.emplace(cluster.landmarkIds[i],
+      sfmData::Landmark(landmark.X, landmark.descType, sfmData::Observations(), landmark.rgb)).first->second;
+    for(std::size_t j = cluster.observationOffsets[i]; j < cluster.observationOffsets[i + 1]; ++j)
+      clusterLandmark.observations[cluster.observationViewIds[j]] = landmark.observations.at(cluster.observationViewIds[j]);
+  }
+}
+
+/**
+ * @brief Keep the refined values of the problem of a cluster, before its problem and sub-scene are released:
+ *        the shared parameters in the cluster state, the parameters only refined by this cluster in the scene.
+ */
+void updateFromCluster(ClusterState& cluster, sfmData::SfMData& clusterSfmData, BundleAdjustmentCeres& ba,
+                       const ConsensusIds& consensusIds, bool refinePoses, bool refineIntrinsics, bool refineStructure,
+                       sfmData::SfMData& sfmData)
+{
+  for(LocalParameter& parameter : cluster.sharedParameters)
+  {
+    const double* block = getParameterBlock(ba, clusterSfmData, parameter);
+    parameter.value.assign(block, block + parameter.value.size());
+  }
+
+  if(refinePoses)
+  {
+    for(const auto& poseIt : clusterSfmData.getPoses())
+    {
+      const double* block = ba.getPoseParameterBlock(poseIt.first);
+      if(block != nullptr && !poseIt.second.isLocked() && !consensusIds.poses.count(poseIt.first))
+        sfmData.getPoses().at(poseIt.first).setTransform(poseFromBlock(block));
+    }
+    for(const auto& subPose : getObservedSubPoses(clusterSfmData))
+    {
+      const double* block = ba.getSubPoseParameterBlock(subPose.first, subPose.second);
+      sfmData::RigSubPose& rigSubPose = sfmData.getRigs().at(subPose.first).getSubPose(subPose.second);
+      if(block != nullptr && rigSubPose.status == sfmData::ERigSubPoseStatus::ESTIMATED && !consensusIds.subPoses.count(subPose))
+        rigSubPose.pose = poseFromBlock(block);
+    }
+  }
+
+  if(refineIntrinsics)
+  {
+    for(const auto& intrinsicIt : clusterSfmData.getIntrinsics())
+    {
+      const double* block = ba.getIntrinsicParameterBlock(intrinsicIt.first);
+      if(block != nullptr && !intrinsicIt.second->isLocked() && !consensusIds.intrinsics.count(intrinsicIt.first))
+        sfmData.intrinsics.at(intrinsicIt.first)->updateFromParams(std::vector<double>(block, block + intrinsicIt.second->getParams().size()));
+    }
+  }
+
+  // the landmarks are refined in place in the sub-scene
+  if(refineStructure)
+  {
+    for(const auto& landmarkIt : clusterSfmData.getLandmarks())
+    {
+      if(!consensusIds.landmarks.count(landmarkIt.first))
+        sfmData.structure.at(landmarkIt.first).X = landmarkIt.second.X;
+    }
+  }
+}
+
+} // namespace
+
+BundleAdjustmentPartitioned::BundleAdjustmentPartitioned(const PartitionedBA_options& options)
+  : _options(options)
+{}
+
+std::vector<BundleAdjustmentPartitioned::Cluster> BundleAdjustmentPartitioned::computeClusters(const sfmData::SfMData& sfmData,
+                                                                                              std::size_t maxClusterSize,
+                                                                                              double overlapRatio)
+{
+  const std::size_t noCluster = std::numeric_limits<std::size_t>::max();
+
+  std::vector<IndexT> poseIds;
+  poseIds.reserve(sfmData.getPoses().size());
+  for(const auto& poseIt : sfmData.getPoses())
+    poseIds.push_back(poseIt.first);
+  std::sort(poseIds.begin(), poseIds.end());
+
+  const std::size_t nbPoses = poseIds.size();
+  HashMap<IndexT, std::size_t> poseIndexes;
+  for(std::size_t i = 0; i < nbPoses; ++i)
+    poseIndexes[poseIds[i]] = i;
+
+  // poses observing each landmark and landmarks observed by each pose
+  std::vector<std::vector<std::size_t>> posesPerLandmark;
+  std::vector<std::vector<std::size_t>> landmarksPerPose(nbPoses);
+  posesPerLandmark.reserve(sfmData.getLandmarks().size());
+
+  for(const auto& landmarkIt : sfmData.getLandmarks())
+  {
+    std::vector<std::size_t> poses;
+    for(const auto& observationIt : landmarkIt.second.observations)
+    {
+      const sfmData::View* view = sfmData.getViews().at(observationIt.first).get();
+      if(sfmData.isPoseAndIntrinsicDefined(view))
+        poses.push_back(poseIndexes.at(view->getPoseId()));
+    }
+    std::sort(poses.begin(), poses.end());
+    poses.erase(std::unique(poses.begin(), poses.end()), poses.end());
+
+    // the landmark does not connect poses
+    if(poses.size() < 2)
+      continue;
+
+    const std::size_t landmarkIndex = posesPerLandmark.size();
+    for(std::size_t poseIndex : poses)
+      landmarksPerPose[poseIndex].push_back(landmarkIndex);
+    posesPerLandmark.push_back(std::move(poses));
+  }
+
+  std::vector<Cluster> clusters;
+  std::vector<std::size_t> poseCluster(nbPoses, noCluster);
+  std::vector<std::size_t> landmarkCluster(posesPerLandmark.size(), noCluster);
+
+  // number of landmarks shared by each pose with the current cluster
+  std::vector<std::size_t> scores(nbPoses, 0);
+  std::vector<std::size_t> scoredPoses;
+  // candidate poses (score, nbPoses - pose index): highest score first, then lowest pose index
+  using Candidate = std::pair<std::size_t, std::size_t>;
+  std::priority_queue<Candidate> candidates;
+  std::size_t clusterSize = maxClusterSize;
+
+  for(std::size_t seed = 0; seed < nbPoses; ++seed)
+  {
+    if(poseCluster[seed] != noCluster)
+      continue;
+
+    if(clusterSize >= maxClusterSize)
+    {
+      // start a new cluster
+      clusters.emplace_back();
+      clusterSize = 0;
+      for(std::size_t poseIndex : scoredPoses)
+        scores[poseIndex] = 0;
+      scoredPoses.clear();
+      candidates = std::priority_queue<Candidate>();
+    }
+
+    // grow the cluster from the seed, the disconnected parts are merged in the same cluster
+    const std::size_t clusterIndex = clusters.size() - 1;
+    candidates.emplace(scores[seed], nbPoses - seed);
+
+    while(!candidates.empty() && clusterSize < maxClusterSize)
+    {
+      const Candidate candidate = candidates.top();
+      candidates.pop();
+      const std::size_t poseIndex = nbPoses - candidate.second;
+
+      // already in a cluster or outdated score
+      if(poseCluster[poseIndex] != noCluster || candidate.first != scores[poseIndex])
+        continue;
+
+      poseCluster[poseIndex] = clusterIndex;
+      clusters.back().poses.push_back(poseIds[poseIndex]);
+      ++clusterSize;
+
+      for(std::size_t landmarkIndex : landmarksPerPose[poseIndex])
+      {
+        if(landmarkCluster[landmarkIndex] == clusterIndex)
+          continue;
+        landmarkCluster[landmarkIndex] = clusterIndex;
+
+        for(std::size_t otherPoseIndex : posesPerLandmark[landmarkIndex])
+        {
+          if(poseCluster[otherPoseIndex] != noCluster)
+            continue;
+          if(scores[otherPoseIndex] == 0)
+            scoredPoses.push_back(otherPoseIndex);
+          ++scores[otherPoseIndex];
+          candidates.emplace(scores[otherPoseIndex], nbPoses - otherPoseIndex);
+        }
+      }
+    }
+  }
+
+  // extend each cluster with the poses of the other clusters sharing the most landmarks with it
+  std::vector<std::size_t> sharedLandmarks(nbPoses, 0);
+  std::vector<std::size_t> landmarkVisited(posesPerLandmark.size(), noCluster);
+  std::vector<std::size_t> neighbors;
+
+  for(std::size_t clusterIndex = 0; clusterIndex < clusters.size(); ++clusterIndex)
+  {
+    Cluster& cluster = clusters.at(clusterIndex);
+    const std::size_t nbOverlapPoses = static_cast<std::size_t>(std::ceil(overlapRatio * cluster.poses.size()));
+
+    neighbors.clear();
+    for(IndexT poseId : cluster.poses)
+    {
+      for(std::size_t landmarkIndex : landmarksPerPose[poseIndexes.at(poseId)])
+      {
+        if(landmarkVisited[landmarkIndex] == clusterIndex)
+          continue;
+        landmarkVisited[landmarkIndex] = clusterIndex;
+
+        for(std::size_t otherPoseIndex : posesPerLandmark[landmarkIndex])
+        {
+          if(poseCluster[otherPoseIndex] == clusterIndex)
+            continue;
+          if(sharedLandmarks[otherPoseIndex]++ == 0)
+            neighbors.push_back(otherPoseIndex);
+        }
+      }
+    }
+
+    const auto overlapEnd = neighbors.begin() + std::min(nbOverlapPoses, neighbors.size());
+    std::partial_sort(neighbors.begin(), overlapEnd, neighbors.end(), [&](std::size_t a, std::size_t b)
+    {
+      if(sharedLandmarks[a] != sharedLandmarks[b])
+        return sharedLandmarks[a] > sharedLandmarks[b];
+      return a < b;
+    });
+
+    for(auto it = neighbors.begin(); it != overlapEnd; ++it)
+      cluster.overlapPoses.push_back(poseIds[*it]);
+
+    for(std::size_t poseIndex : neighbors)
+      sharedLandmarks[poseIndex] = 0;
+
+    std::sort(cluster.poses.begin(), cluster.poses.end());
+    std::sort(cluster.overlapPoses.begin(), cluster.overlapPoses.end());
+  }
+
+  return clusters;
+}
+
+bool BundleAdjustmentPartitioned::Adjust(sfmData::SfMData& sfmData, BA_Refine refineOptions)
+{
+  if(sfmData.getPoses().size() <= _options._maxClusterSize)
+  {
+    BundleAdjustmentCeres bundleAdjustment(_options);
+    return bundleAdjustment.Adjust(sfmData, refineOptions);
+  }
+
+  system::Timer timer;
+
+  const std::vector<Cluster> clusters = computeClusters(sfmData, _options._maxClusterSize, _options._overlapRatio);
+  const std::size_t nbClusters = clusters.size();
+
+  ALICEVISION_LOG_DEBUG("Partitioned Bundle Adjustment: " << sfmData.getPoses().size() << " poses in " << nbClusters << " clusters.");
+
+  // build the sub-scene of each cluster
+  // each observation is assigned to a single cluster, so the sum of the cluster problems is the problem of the whole scene
+
+  std::vector<ClusterState> clusterStates(nbClusters);
+  // clusters of each pose, starting with the cluster the pose is assigned to
+  HashMap<IndexT, std::vector<std::size_t>> clustersPerPose;
+
+  for(std::size_t c = 0; c < nbClusters; ++c)
+  {
+    for(IndexT poseId : clusters[c].poses)
+      clustersPerPose[poseId].push_back(c);
+  }
+  for(std::size_t c = 0; c < nbClusters; ++c)
+  {
+    for(IndexT poseId : clusters[c].overlapPoses)
+      clustersPerPose[poseId].push_back(c);
+  }
+
+  // the poses assigned to a cluster are in its sub-scene, even without observations
+  for(std::size_t c = 0; c < nbClusters; ++c)
+    clusterStates[c].poseIds = clusters[c].poses;
+
+  const auto addView = [&](std::size_t c, const sfmData::View& view)
+  {
+    clusterStates[c].viewIds.push_back(view.getViewId());
+    clusterStates[c].poseIds.push_back(view.getPoseId());
+  };
+
+  for(const auto& viewIt : sfmData.getViews())
+  {
+    if(sfmData.isPoseAndIntrinsicDefined(viewIt.second.get()))
+      addView(clustersPerPose.at(viewIt.second->getPoseId()).front(), *viewIt.second);
+  }
+
+  // number of observations of the current landmark in each cluster
+  std::vector<std::pair<std::size_t, std::size_t>> nbObservationsPerCluster;
+  const auto nbObservations = [&](std::size_t c) -> std::size_t&
+  {
+    auto it = std::find_if(nbObservationsPerCluster.begin(), nbObservationsPerCluster.end(),
+                           [c](const std::pair<std::size_t, std::size_t>& count) { return count.first == c; });
+    if(it == nbObservationsPerCluster.end())
+    {
+      nbObservationsPerCluster.emplace_back(c, 0);
+      return nbObservationsPerCluster.back().second;
+    }
+    return it->second;
+  };
+
+  for(const auto& landmarkIt : sfmData.structure)
+  {
+    nbObservationsPerCluster.clear();
+    for(const auto& observationIt : landmarkIt.second.observations)
+    {
+      const sfmData::View* view = sfmData.views.at(observationIt.first).get();
+      if(!sfmData.isPoseAndIntrinsicDefined(view))
+        continue;
+      for(std::size_t c : clustersPerPose.at(view->getPoseId()))
+        ++nbObservations(c);
+    }
+
+    for(const auto& observationIt : landmarkIt.second.observations)
+    {
+      const sfmData::View& view = *sfmData.views.at(observationIt.first);
+      if(!sfmData.isPoseAndIntrinsicDefined(&view))
+        continue;
+
+      // the cluster with the most observations of the landmark, to split as few landmarks as possible
+      const std::vector<std::size_t>& poseClusters = clustersPerPose.at(view.getPoseId());
+      std::size_t bestCluster = poseClusters.front();
+      for(std::size_t c : poseClusters)
+      {
+        if(nbObservations(c) > nbObservations(bestCluster))
+          bestCluster = c;
+      }
+
+      ClusterState& cluster = clusterStates[bestCluster];
+      addView(bestCluster, view);
+
+      // the landmarks are processed one after the other, so the landmark is the last one of the cluster if it is already in it
+      if(cluster.landmarkIds.empty() || cluster.landmarkIds.back() != landmarkIt.first)
+      {
+        cluster.landmarkIds.push_back(landmarkIt.first);
+        cluster.observationOffsets.push_back(cluster.observationViewIds.size());
+      }
+      cluster.observationViewIds.push_back(observationIt.first);
+      ++cluster.observationOffsets.back();
+    }
+  }
+
+  for(ClusterState& cluster : clusterStates)
+  {
+    for(std::vector<IndexT>* ids : {&cluster.poseIds, &cluster.viewIds})
+    {
+      std::sort(ids->begin(), ids->end());
+      ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+    }
+  }
+
+  // the refinement of the optical centers is decided on the whole scene, so all the clusters refine the same parameters
+  const HashMap<IndexT, std::size_t> intrinsicsUsage = BundleAdjustmentCeres::computeIntrinsicsUsage(sfmData);
+
+  // find the parameter blocks shared by several clusters and not constant
+
+  const bool refinePoses = (refineOptions & BA_REFINE_ROTATION) || (refineOptions & BA_REFINE_TRANSLATION);
+  const bool refineIntrinsics = (refineOptions & BA_REFINE_INTRINSICS_FOCAL) ||
+                                (refineOptions & BA_REFINE_INTRINSICS_DISTORTION) ||
+                                (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) ||
+                                (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA);
+  const bool refineStructure = (refineOptions & BA_REFINE_STRUCTURE);
+
+  ConsensusIds consensusIds;
+  std::vector<ConsensusParameter> consensusParameters;
+  {
+    HashMap<IndexT, std::size_t> nbClustersPerPose;
+    HashMap<IndexT, std::size_t> nbClustersPerIntrinsic;
+    std::map<std::pair<IndexT, IndexT>, std::size_t> nbClustersPerSubPose;
+    HashMap<IndexT, std::size_t> nbClustersPerLandmark;
+
+    for(const ClusterState& cluster : clusterStates)
+    {
+      std::set<IndexT> intrinsics;
+      std::set<std::pair<IndexT, IndexT>> subPoses;
+      for(IndexT viewId : cluster.viewIds)
+      {
+        const sfmData::View& view = *sfmData.getViews().at(viewId);
+        intrinsics.insert(view.getIntrinsicId());
+        if(view.isPartOfRig())
+          subPoses.emplace(view.getRigId(), view.getSubPoseId());
+      }
+
+      for(IndexT poseId : cluster.poseIds)
+        ++nbClustersPerPose[poseId];
+      for(IndexT intrinsicId : intrinsics)
+        ++nbClustersPerIntrinsic[intrinsicId];
+      for(const auto& subPose : subPoses)
+        ++nbClustersPerSubPose[subPose];
+      for(IndexT landmarkId : cluster.landmarkIds)
+        ++nbClustersPerLandmark[landmarkId];
+    }
+
+    const auto addConsensusParameter = [&](const std::vector<double>& value)
+    {
+      consensusParameters.emplace_back();
+      // the values are set from the parameter blocks of the clusters
+      consensusParameters.back().value = value;
+      return consensusParameters.size() - 1;
+    };
+
+    if(refinePoses)
+    {
+      for(const auto& poseIt : nbClustersPerPose)
+      {
+        const sfmData::CameraPose& cameraPose = sfmData.getPoses().at(poseIt.first);
+        if(poseIt.second < 2 || cameraPose.isLocked())
+          continue;
+        consensusIds.poses[poseIt.first] = addConsensusParameter(std::vector<double>(6, 0.0));
+      }
+      for(const auto& subPoseIt : nbClustersPerSubPose)
+      {
+        const sfmData::RigSubPose& rigSubPose = sfmData.getRigs().at(subPoseIt.first.first).getSubPose(subPoseIt.first.second);
+        if(subPoseIt.second < 2 || rigSubPose.status != sfmData::ERigSubPoseStatus::ESTIMATED)
+          continue;
+        consensusIds.subPoses[subPoseIt.first] = addConsensusParameter(std::vector<double>(6, 0.0));
+      }
+    }
+    if(refineIntrinsics)
+    {
+      for(const auto& intrinsicIt : nbClustersPerIntrinsic)
+      {
+        const IntrinsicBase& intrinsic = *sfmData.getIntrinsics().at(intrinsicIt.first);
+        if(intrinsicIt.second < 2 || intrinsic.isLocked())
+          continue;
+        consensusIds.intrinsics[intrinsicIt.first] = addConsensusParameter(intrinsic.getParams());
+      }
+    }
+    if(refineStructure)
+    {
+      for(const auto& landmarkIt : nbClustersPerLandmark)
+      {
+        if(landmarkIt.second < 2)
+          continue;
+        const Vec3& X = sfmData.getLandmarks().at(landmarkIt.first).X;
+        consensusIds.landmarks[landmarkIt.first] = addConsensusParameter({X(0), X(1), X(2)});
+      }
+    }
+  }
+
+  // the clusters are processed concurrently, the threads are split between them
+  const int nbConcurrentClusters = std::max(1, std::min(static_cast<int>(nbClusters), static_cast<int>(_options._nbThreads)));
+  const int nbThreadsPerCluster = std::max(1, static_cast<int>(_options._nbThreads) / nbConcurrentClusters);
+
+  // the shared parameters of each cluster, with the weights of their proximal terms
+
+  #pragma omp parallel for schedule(dynamic) num_threads(nbConcurrentClusters)
+  for(int c = 0; c < static_cast<int>(nbClusters); ++c)
+  {
+    ClusterState& cluster = clusterStates[c];
+    sfmData::SfMData clusterSfmData;
+    buildClusterScene(sfmData, cluster, clusterSfmData);
+
+    BundleAdjustmentCeres ba(_options);
+    ceres::Problem problem;
+    ba.createProblem(clusterSfmData, refineOptions, problem, &intrinsicsUsage);
+
+    std::map<const double*, std::vector<double>> hessianDiagonal;
+    cluster.nbResiduals = computeHessianDiagonal(clusterSfmData, ba, _options._bAnalyticJacobians, hessianDiagonal);
+
+    const auto addSharedParameter = [&](ESharedParameter type, IndexT id, IndexT subPoseId, std::size_t consensusId)
+    {
+      LocalParameter parameter;
+      parameter.type = type;
+      parameter.id = id;
+      parameter.subPoseId = subPoseId;
+      parameter.consensusId = consensusId;
+
+      const double* block = getParameterBlock(ba, clusterSfmData, parameter);
+      if(block == nullptr)
+        return;
+
+      const std::size_t size = consensusParameters[consensusId].value.size();
+      parameter.value.assign(block, block + size);
+      parameter.weights = hessianDiagonal[block];
+      parameter.weights.resize(size, 0.0);
+      for(double& weight : parameter.weights)
+        weight *= _options._consensusWeight;
+      parameter.dual.assign(size, 0.0);
+      parameter.target = parameter.value;
+      cluster.sharedParameters.push_back(std::move(parameter));
+    };
+
+    for(const auto& poseIt : clusterSfmData.getPoses())
+    {
+      auto it = consensusIds.poses.find(poseIt.first);
+      if(it != consensusIds.poses.end())
+        addSharedParameter(ESharedParameter::POSE, poseIt.first, UndefinedIndexT, it->second);
+    }
+    for(const auto& subPose : getObservedSubPoses(clusterSfmData))
+    {
+      auto it = consensusIds.subPoses.find(subPose);
+      if(it != consensusIds.subPoses.end())
+        addSharedParameter(ESharedParameter::SUBPOSE, subPose.first, subPose.second, it->second);
+    }
+    for(const auto& intrinsicIt : clusterSfmData.getIntrinsics())
+    {
+      auto it = consensusIds.intrinsics.find(intrinsicIt.first);
+      if(it != consensusIds.intrinsics.end())
+        addSharedParameter(ESharedParameter::INTRINSIC, intrinsicIt.first, UndefinedIndexT, it->second);
+    }
+    for(const auto& landmarkIt : clusterSfmData.getLandmarks())
+    {
+      auto it = consensusIds.landmarks.find(landmarkIt.first);
+      if(it != consensusIds.landmarks.end())
+        addSharedParameter(ESharedParameter::LANDMARK, landmarkIt.first, UndefinedIndexT, it->second);
+    }
+  }
+
+  // the consensus values start from the initial values of the parameters
+  for(const ClusterState& cluster : clusterStates)
+  {
+    for(const LocalParameter& parameter : cluster.sharedParameters)
+      consensusParameters[parameter.consensusId].value = parameter.value;
+  }
+
+  std::size_t nbResiduals = 0;
+  for(const ClusterState& cluster : clusterStates)
+    nbResiduals += cluster.nbResiduals;
+
+  /**
+   * Solve the clusters concurrently, each with its share of the threads.
+   * The sub-scene and the problem of a cluster are built for its solve and released right after,
+   * with the proximal terms to the consensus values or, once the consensus is reached,
+   * with the shared parameters set constant to their consensus values.
+   * The sub-scenes are built from the scene and the parameters only refined by a cluster are written back to it,
+   * so both are serialized.
+   */
+  const auto solveClusters = [&](int maxNumIterations, bool consensusReached)
+  {
+    bool success = true;
+
+    #pragma omp parallel for schedule(dynamic) num_threads(nbConcurrentClusters)
+    for(int c = 0; c < static_cast<int>(nbClusters); ++c)
+    {
+      ClusterState& cluster = clusterStates[c];
+      sfmData::SfMData clusterSfmData;
+      #pragma omp critical(partitionedBAScene)
+      buildClusterScene(sfmData, cluster, clusterSfmData);
+
+      BundleAdjustmentCeres ba(_options);
+      ceres::Problem problem;
+      ba.createProblem(clusterSfmData, refineOptions, problem, &intrinsicsUsage);
+
+      for(LocalParameter& parameter : cluster.sharedParameters)
+      {
+        double* block = getParameterBlock(ba, clusterSfmData, parameter);
+        if(consensusReached)
+        {
+          const ConsensusParameter& consensus = consensusParameters[parameter.consensusId];
+          std::copy(consensus.value.begin(), consensus.value.end(), block);
+          problem.SetParameterBlockConstant(block);
+        }
+        else
+        {
+          // the scene only holds the initial values of the shared parameters, start from the last value of the cluster
+          std::copy(parameter.value.begin(), parameter.value.end(), block);
+          // the targets are not moved during the solve
+          problem.AddResidualBlock(new ConsensusCostFunction(parameter.target.data(), parameter.weights), nullptr, block);
+        }
+      }
+
+      ceres::Solver::Options options;
+      options.preconditioner_type = _options._preconditioner_type;
+      options.linear_solver_type = _options._linear_solver_type;
+      options.sparse_linear_algebra_library_type = _options._sparse_linear_algebra_library_type;
+      options.minimizer_progress_to_stdout = false;
+      options.logging_type = ceres::SILENT;
+      options.num_threads = nbThreadsPerCluster;
+      options.num_linear_solver_threads = nbThreadsPerCluster;
+      options.max_num_iterations = maxNumIterations;
+
+      ceres::Solver::Summary summary;
+      ceres::Solve(options, &problem, &summary);
+      if(_options._bCeres_Summary)
+        ALICEVISION_LOG_DEBUG(summary.FullReport());
+
+      if(!summary.IsSolutionUsable())
+      {
+        #pragma omp critical(partitionedBAScene)
+        success = false;
+        continue;
+      }
+
+      #pragma omp critical(partitionedBAScene)
+      updateFromCluster(cluster, clusterSfmData, ba, consensusIds, refinePoses, refineIntrinsics, refineStructure, sfmData);
+    }
+    return success;
+  };
+
+  // consensus ADMM iterations
+
+  double disagreement = 0.0;
+  std::size_t iteration = 0;
+  for(; iteration < _options._maxConsensusIterations; ++iteration)
+  {
+    if(!solveClusters(_options._maxClusterSolverIterations, false))
+    {
+      ALICEVISION_LOG_WARNING("Partitioned Bundle Adjustment failed.");
+      return false;
+    }
+
+    // consensus values: weighted average of the cluster values
+    for(ConsensusParameter& consensus : consensusParameters)
+    {
+      consensus.weightedSum.assign(consensus.value.size(), 0.0);
+      consensus.weightSum.assign(consensus.value.size(), 0.0);
+    }
+    for(const ClusterState& cluster : clusterStates)
+    {
+      for(const LocalParameter& parameter : cluster.sharedParameters)
+      {
+        ConsensusParameter& consensus = consensusParameters[parameter.consensusId];
+        for(std::size_t i = 0; i < parameter.weights.size(); ++i)
+        {
+          consensus.weightedSum[i] += parameter.weights[i] * (parameter.value[i] + parameter.dual[i]);
+          consensus.weightSum[i] += parameter.weights[i];
+        }
+      }
+    }
+    for(ConsensusParameter& consensus : consensusParameters)
+    {
+      for(std::size_t i = 0; i < consensus.value.size(); ++i)
+      {
+        // the parameter is not observed (e.g. constant part of a subset parameterization)
+        if(consensus.weightSum[i] > 0.0)
+          consensus.value[i] = consensus.weightedSum[i] / consensus.weightSum[i];
+      }
+    }
+
+    // dual variables and proximal terms targets
+    double sumSquaredDisagreement = 0.0;
+    for(ClusterState& cluster : clusterStates)
+    {
+      for(LocalParameter& parameter : cluster.sharedParameters)
+      {
+        const ConsensusParameter& consensus = consensusParameters[parameter.consensusId];
+        for(std::size_t i = 0; i < parameter.weights.size(); ++i)
+        {
+          const double residual = parameter.value[i] - consensus.value[i];
+          parameter.dual[i] += residual;
+          parameter.target[i] = consensus.value[i] - parameter.dual[i];
+          sumSquaredDisagreement += parameter.weights[i] * residual * residual;
+        }
+      }
+    }
+
+    // RMS of the displacement of the reprojections due to the disagreement between the clusters
+    disagreement = std::sqrt(sumSquaredDisagreement / (_options._consensusWeight * std::max(nbResiduals, std::size_t(1))));
+
+    ALICEVISION_LOG_DEBUG("Partitioned Bundle Adjustment: iteration " << iteration << ", disagreement between the clusters: " << disagreement << " px");
+
+    if(disagreement < _options._consensusTolerance)
+    {
+      ++iteration;
+      break;
+    }
+  }
+
+  // set the shared parameters to their consensus values and refine the other parameters of each cluster
+  if(!solveClusters(ceres::Solver::Options().max_num_iterations, true))
+  {
+    ALICEVISION_LOG_WARNING("Partitioned Bundle Adjustment failed.");
+    return false;
+  }
+
+  if(_options._bVerbose)
+  {
+    ALICEVISION_LOG_DEBUG(
+      "Partitioned Bundle Adjustment statistics:\n"
+      "\t- # views: " << sfmData.views.size() << "\n"
+      "\t- # poses: " << sfmData.getPoses().size() << "\n"
+      "\t- # intrinsics: " << sfmData.intrinsics.size() << "\n"
+      "\t- # tracks: " << sfmData.structure.size() << "\n"
+      "\t- # clusters: " << nbClusters << "\n"
+      "\t- # shared parameter blocks: " << consensusParameters.size() << "\n"
+      "\t- # consensus iterations: " << iteration << "\n"
+      "\t- final disagreement (px): " << disagreement << "\n"
+      "\t- time (s): " << timer.elapsed());
+  }
+
+  // update the scene with the consensus values of the shared parameters,
+  // the other parameters are written back to the scene after each solve
+
+  for(const auto& poseIt : consensusIds.poses)
+    sfmData.getPoses().at(poseIt.first).setTransform(poseFromBlock(consensusParameters[poseIt.second].value.data()));
+
+  for(const auto& subPoseIt : consensusIds.subPoses)
+  {
+    sfmData.getRigs().at(subPoseIt.first.first).getSubPose(subPoseIt.first.second).pose =
+      poseFromBlock(consensusParameters[subPoseIt.second].value.data());
+  }
+
+  for(const auto& intrinsicIt : consensusIds.intrinsics)
+    sfmData.intrinsics.at(intrinsicIt.first)->updateFromParams(consensusParameters[intrinsicIt.second].value);
+
+  for(const auto& landmarkIt : consensusIds.landmarks)
+  {
+    const std::vector<double>& X = consensusParameters[landmarkIt.second].value;
+    sfmData.structure.at(landmarkIt.first).X = Vec3(X[0], X[1], X[2]);
+  }
+
+  return true;
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,98 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+
+namespace sfmData {
+class SfMData;
+} // namespace sfmData
+
+namespace sfm {
+
+/**
+ * @brief Bundle adjustment of large scenes, partitioned in overlapping clusters of poses.
+ *
+ * Each cluster has its own ceres::Problem. The clusters are solved concurrently, the threads being split between them.
+ * The sub-scene and the problem of a cluster are only built for its solve and released right after,
+ * so at most one problem per solving thread is in memory.
+ * The parameters shared by several clusters (poses, rig sub-poses, intrinsics and landmarks)
+ * are reconciled by consensus ADMM:
+ * - each cluster minimizes its reprojection errors plus a proximal term to the consensus values,
+ * - the consensus values are the weighted average of the cluster values,
+ * until the clusters agree on the shared parameters.
+ * Each observation is assigned to a single cluster, so the clusters converge to the solution of the whole scene.
+ * The proximal terms are weighted by the diagonal of the Gauss-Newton Hessian of each cluster,
+ * so the disagreement between clusters is measured in pixels.
+ * The refinement of the optical centers (BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA) is decided
+ * on the whole scene, so all the clusters refine the same intrinsic parameters.
+ *
+ * Scenes with less poses than the maximum cluster size are adjusted by BundleAdjustmentCeres.
+ */
+class BundleAdjustmentPartitioned : public BundleAdjustment
+{
+public:
+  struct PartitionedBA_options : public BundleAdjustmentCeres::BA_options
+  {
+    PartitionedBA_options(const bool bVerbose = true, bool bmultithreaded = true)
+      : BundleAdjustmentCeres::BA_options(bVerbose, bmultithreaded)
+    {}
+
+    /// maximum number of poses assigned to a cluster
+    std::size_t _maxClusterSize = 500;
+    /// number of poses of the neighbor clusters added to a cluster, relative to its size
+    double _overlapRatio = 0.2;
+    /// maximum number of consensus iterations
+    std::size_t _maxConsensusIterations = 50;
+    /// maximum number of solver iterations on each cluster, per consensus iteration
+    std::size_t _maxClusterSolverIterations = 10;
+    /// weight of the proximal terms, relative to the reprojection errors
+    double _consensusWeight = 1.0;
+    /// stop when the RMS disagreement between the clusters on the shared parameters is below (in pixels)
+    double _consensusTolerance = 1e-3;
+  };
+
+  /**
+   * @brief Cluster of poses
+   */
+  struct Cluster
+  {
+    /// poses assigned to the cluster (each pose is assigned to one cluster)
+    std::vector<IndexT> poses;
+    /// poses of the neighbor clusters also refined in this cluster
+    std::vector<IndexT> overlapPoses;
+  };
+
+  BundleAdjustmentPartitioned(const PartitionedBA_options& options = PartitionedBA_options());
+
+  /**
+   * @brief Split the poses of a scene in clusters.
+   *        Each cluster is grown from a seed pose by adding the pose sharing the most landmarks with the cluster,
+   *        then extended by the poses of the other clusters sharing the most landmarks with it.
+   * @param[in] sfmData the scene
+   * @param[in] maxClusterSize the maximum number of poses assigned to a cluster
+   * @param[in] overlapRatio the number of overlap poses of a cluster, relative to its size
+   * @return the clusters
+   */
+  static std::vector<Cluster> computeClusters(const sfmData::SfMData& sfmData, std::size_t maxClusterSize, double overlapRatio);
+
+  /**
+   * @see BundleAdjustment::Adjust
+   */
+  bool Adjust(sfmData::SfMData& sfmData, BA_Refine refineOptions = BA_REFINE_ALL);
+
+private:
+  PartitionedBA_options _options;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -132,7 +132,7 @@ bool LocalBundleAdjustmentCeres::Adjust(sfmData::SfMData& sfm_data, const LocalB
       // dimensional residual. Internally, the cost function stores the observed
       // image location and compares the reprojection against the observation.
       ceres::CostFunction* cost_function = 
-          createCostFunctionFromIntrinsics(sfm_data.intrinsics[intrinsicId].get(), observationIt.second.x);
+          createCostFunctionFromIntrinsics(sfm_data.intrinsics[intrinsicId].get(), observationIt.second.x, _LBAOptions._bAnalyticJacobians);
       
       if (cost_function)
       {
@@ -207,7 +207,7 @@ void LocalBundleAdjustmentData::resetParametersCounter()
 
 void LocalBundleAdjustmentData::updateGraphWithNewViews(
     const sfmData::SfMData& sfm_data,
-    const track::TracksPerView& map_tracksPerView,
+    const track::TracksCSR& tracks,
     const std::set<IndexT>& newReconstructedViews,
     const std::size_t kMinNbOfMatches)
 {
@@ -275,7 +275,7 @@ void LocalBundleAdjustmentData::updateGraphWithNewViews(
   if (!addedViewsId.empty())
   {
     // Count the nb of common landmarks between the new views and the all the reconstructed views of the scene
-    std::map<Pair, std::size_t> nbSharedLandmarksPerImagesPair = countSharedLandmarksPerImagesPair(sfm_data, map_tracksPerView, addedViewsId);
+    std::map<Pair, std::size_t> nbSharedLandmarksPerImagesPair = countSharedLandmarksPerImagesPair(sfm_data, tracks, addedViewsId);
     
     for(const auto& x: nbSharedLandmarksPerImagesPair)
     {
@@ -435,7 +435,7 @@ void LocalBundleAdjustmentData::convertDistancesToLBAStates(const sfmData::SfMDa
 
 std::map<Pair, std::size_t> LocalBundleAdjustmentData::countSharedLandmarksPerImagesPair(
     const sfmData::SfMData& sfm_data,
-    const track::TracksPerView& map_tracksPerView,
+    const track::TracksCSR& tracks,
     const std::set<IndexT>& newViewsId)
 {
   std::map<Pair, std::size_t> map_imagesPair_nbSharedLandmarks;
@@ -450,7 +450,7 @@ std::map<Pair, std::size_t> LocalBundleAdjustmentData::countSharedLandmarksPerIm
   for(const auto& viewId: newViewsId)
   {
     // Get all the tracks of the new added view
-    const aliceVision::track::TrackIdSet& newView_trackIds = map_tracksPerView.at(viewId);
+    const track::ArrayRange<IndexT> newView_trackIds = tracks.viewTracks(viewId);
     
     // Keep the reconstructed tracks (with an associated landmark)
     std::vector<IndexT> newView_landmarks; // all landmarks (already reconstructed) visible from the new view
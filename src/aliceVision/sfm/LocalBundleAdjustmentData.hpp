@@ -9,6 +9,8 @@
 #include <aliceVision/types.hpp>
 #include <aliceVision/track/Track.hpp>
 
+#include <lemon/list_graph.h>
+
 namespace aliceVision {
 
 namespace sfmData {
@@ -102,11 +104,11 @@ public:
   
   /// @brief Complete the graph with the newly resected views or all the posed views if the graph is empty.
   /// @param[in] sfm_data 
-  /// @param[in] map_tracksPerView A map giving the tracks for each view
+  /// @param[in] tracks All the tracks, with the tracks of each view
   /// @param[in] newReconstructedViews The list of the newly resected views
   /// @param[in] kMinNbOfMatches The min. number of shared matches to create an edge between two views (nodes)
   void updateGraphWithNewViews(const sfmData::SfMData& sfm_data,
-      const track::TracksPerView& map_tracksPerView, 
+      const track::TracksCSR& tracks, 
       const std::set<IndexT> &newReconstructedViews, 
       const std::size_t kMinNbOfMatches = 50);
   
@@ -189,12 +191,12 @@ private:
   
   /// @brief Count the number of shared landmarks between all the new views and each already resected cameras.
   /// @param[in] sfm_data
-  /// @param[in] map_tracksPerView
+  /// @param[in] tracks
   /// @param[in] newViewsId A set with the views index that we want to count matches with resected cameras. 
   /// @return A map giving the number of matches for each images pair.
   static std::map<Pair, std::size_t> countSharedLandmarksPerImagesPair(
       const sfmData::SfMData& sfm_data,
-      const track::TracksPerView& map_tracksPerView,
+      const track::TracksCSR& tracks,
       const std::set<IndexT>& newViewsId);
   
   /// @brief Return the state of the focal length (constant or not) for a specific intrinsic.
@@ -0,0 +1,441 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <ceres/ceres.h>
+#include <ceres/rotation.h>
+
+#include <cmath>
+#include <limits>
+
+// Ceres cost functions with analytic Jacobians for each AliceVision camera model.
+// They compute the same residuals as the ResidualErrorFunctor_* functors
+// (see ResidualErrorFunctor.hpp), without the cost of the automatic differentiation.
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Distortion models used by the analytic cost functions.
+ *
+ * Each model distorts an undistorted point (x_u, y_u) and computes:
+ * - the Jacobian of the distorted point w.r.t. the undistorted point (2x2, row-major),
+ * - the Jacobian of the distorted point w.r.t. the distortion parameters (2xNB_DISTO_PARAMS, row-major).
+ * The distortion parameters follow [focal, principal point x, principal point y] in the intrinsic data block.
+ */
+namespace distortion {
+
+struct Pinhole
+{
+  enum { NB_DISTO_PARAMS = 0 };
+
+  static void apply(const double* /*disto*/, double x_u, double y_u,
+                    double* pt_d, double* dPtd_dPtu, double* /*dPtd_dDisto*/)
+  {
+    pt_d[0] = x_u;
+    pt_d[1] = y_u;
+    dPtd_dPtu[0] = 1.0; dPtd_dPtu[1] = 0.0;
+    dPtd_dPtu[2] = 0.0; dPtd_dPtu[3] = 1.0;
+  }
+};
+
+/// Radial distortion x_d = x_u * r_coeff(r2), with the derivative of r_coeff w.r.t. r2
+inline void applyRadial(double x_u, double y_u, double r_coeff, double dRcoeff_dR2,
+                        double* pt_d, double* dPtd_dPtu)
+{
+  pt_d[0] = x_u * r_coeff;
+  pt_d[1] = y_u * r_coeff;
+  dPtd_dPtu[0] = r_coeff + 2.0 * dRcoeff_dR2 * x_u * x_u;
+  dPtd_dPtu[1] = 2.0 * dRcoeff_dR2 * x_u * y_u;
+  dPtd_dPtu[2] = dPtd_dPtu[1];
+  dPtd_dPtu[3] = r_coeff + 2.0 * dRcoeff_dR2 * y_u * y_u;
+}
+
+struct PinholeRadialK1
+{
+  enum { NB_DISTO_PARAMS = 1 };
+
+  static void apply(const double* disto, double x_u, double y_u,
+                    double* pt_d, double* dPtd_dPtu, double* dPtd_dDisto)
+  {
+    const double& k1 = disto[0];
+    const double r2 = x_u*x_u + y_u*y_u;
+    applyRadial(x_u, y_u, 1.0 + k1*r2, k1, pt_d, dPtd_dPtu);
+    dPtd_dDisto[0] = x_u * r2;
+    dPtd_dDisto[1] = y_u * r2;
+  }
+};
+
+struct PinholeRadialK3
+{
+  enum { NB_DISTO_PARAMS = 3 };
+
+  static void apply(const double* disto, double x_u, double y_u,
+                    double* pt_d, double* dPtd_dPtu, double* dPtd_dDisto)
+  {
+    const double& k1 = disto[0];
+    const double& k2 = disto[1];
+    const double& k3 = disto[2];
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    applyRadial(x_u, y_u, 1.0 + k1*r2 + k2*r4 + k3*r6, k1 + 2.0*k2*r2 + 3.0*k3*r4, pt_d, dPtd_dPtu);
+    dPtd_dDisto[0] = x_u * r2; dPtd_dDisto[1] = x_u * r4; dPtd_dDisto[2] = x_u * r6;
+    dPtd_dDisto[3] = y_u * r2; dPtd_dDisto[4] = y_u * r4; dPtd_dDisto[5] = y_u * r6;
+  }
+};
+
+struct PinholeBrownT2
+{
+  enum { NB_DISTO_PARAMS = 5 };
+
+  static void apply(const double* disto, double x_u, double y_u,
+                    double* pt_d, double* dPtd_dPtu, double* dPtd_dDisto)
+  {
+    const double& k1 = disto[0];
+    const double& k2 = disto[1];
+    const double& k3 = disto[2];
+    const double& t1 = disto[3];
+    const double& t2 = disto[4];
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    applyRadial(x_u, y_u, 1.0 + k1*r2 + k2*r4 + k3*r6, k1 + 2.0*k2*r2 + 3.0*k3*r4, pt_d, dPtd_dPtu);
+
+    // tangential distortion
+    pt_d[0] += t2 * (r2 + 2.0 * x_u*x_u) + 2.0 * t1 * x_u * y_u;
+    pt_d[1] += t1 * (r2 + 2.0 * y_u*y_u) + 2.0 * t2 * x_u * y_u;
+    dPtd_dPtu[0] += 6.0 * t2 * x_u + 2.0 * t1 * y_u;
+    dPtd_dPtu[1] += 2.0 * t2 * y_u + 2.0 * t1 * x_u;
+    dPtd_dPtu[2] += 2.0 * t1 * x_u + 2.0 * t2 * y_u;
+    dPtd_dPtu[3] += 6.0 * t1 * y_u + 2.0 * t2 * x_u;
+
+    dPtd_dDisto[0] = x_u * r2; dPtd_dDisto[1] = x_u * r4; dPtd_dDisto[2] = x_u * r6;
+    dPtd_dDisto[3] = 2.0 * x_u * y_u;
+    dPtd_dDisto[4] = r2 + 2.0 * x_u*x_u;
+    dPtd_dDisto[5] = y_u * r2; dPtd_dDisto[6] = y_u * r4; dPtd_dDisto[7] = y_u * r6;
+    dPtd_dDisto[8] = r2 + 2.0 * y_u*y_u;
+    dPtd_dDisto[9] = 2.0 * x_u * y_u;
+  }
+};
+
+struct PinholeFisheye
+{
+  enum { NB_DISTO_PARAMS = 4 };
+
+  static void apply(const double* disto, double x_u, double y_u,
+                    double* pt_d, double* dPtd_dPtu, double* dPtd_dDisto)
+  {
+    const double& k1 = disto[0];
+    const double& k2 = disto[1];
+    const double& k3 = disto[2];
+    const double& k4 = disto[3];
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r = std::sqrt(r2);
+
+    if(!(r > 1e-8))
+    {
+      // same threshold as ResidualErrorFunctor_PinholeFisheye, the distortion is constant
+      Pinhole::apply(disto, x_u, y_u, pt_d, dPtd_dPtu, dPtd_dDisto);
+      for(int i = 0; i < 2 * NB_DISTO_PARAMS; ++i)
+        dPtd_dDisto[i] = 0.0;
+      return;
+    }
+
+    const double theta = std::atan(r);
+    const double theta2 = theta*theta, theta3 = theta2*theta, theta4 = theta2*theta2, theta5 = theta4*theta,
+    theta6 = theta3*theta3, theta7 = theta6*theta, theta8 = theta4*theta4, theta9 = theta8*theta;
+    const double theta_dist = theta + k1*theta3 + k2*theta5 + k3*theta7 + k4*theta9;
+    const double dThetaDist_dTheta = 1.0 + 3.0*k1*theta2 + 5.0*k2*theta4 + 7.0*k3*theta6 + 9.0*k4*theta8;
+    const double inv_r = 1.0 / r;
+    const double cdist = theta_dist * inv_r;
+    // derivative of cdist w.r.t. r, with dtheta/dr = 1 / (1 + r2)
+    const double dCdist_dR = (dThetaDist_dTheta / (1.0 + r2) - cdist) * inv_r;
+
+    applyRadial(x_u, y_u, cdist, 0.5 * dCdist_dR * inv_r, pt_d, dPtd_dPtu);
+
+    const double thetas[4] = {theta3 * inv_r, theta5 * inv_r, theta7 * inv_r, theta9 * inv_r};
+    for(int i = 0; i < NB_DISTO_PARAMS; ++i)
+    {
+      dPtd_dDisto[i] = x_u * thetas[i];
+      dPtd_dDisto[NB_DISTO_PARAMS + i] = y_u * thetas[i];
+    }
+  }
+};
+
+struct PinholeFisheye1
+{
+  enum { NB_DISTO_PARAMS = 1 };
+
+  static void apply(const double* disto, double x_u, double y_u,
+                    double* pt_d, double* dPtd_dPtu, double* dPtd_dDisto)
+  {
+    const double& k1 = disto[0];
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r = std::sqrt(r2);
+    const double tanHalfK1 = std::tan(0.5 * k1);
+    const double a = 2.0 * tanHalfK1;
+    const double atanAR = std::atan(a * r);
+    const double r_coeff = (atanAR / k1) / r;
+
+    const double dAtanAR_dAR = 1.0 / (1.0 + a * a * r2);
+    const double dRcoeff_dR = (a * dAtanAR_dAR / k1 - r_coeff) / r;
+    applyRadial(x_u, y_u, r_coeff, 0.5 * dRcoeff_dR / r, pt_d, dPtd_dPtu);
+
+    // da/dk1 = 1 + tan(k1/2)^2
+    const double dRcoeff_dK1 = (dAtanAR_dAR * (1.0 + tanHalfK1 * tanHalfK1) - r_coeff) / k1;
+    dPtd_dDisto[0] = x_u * dRcoeff_dK1;
+    dPtd_dDisto[1] = y_u * dRcoeff_dK1;
+  }
+};
+
+} // namespace distortion
+
+/**
+ * @brief Rotate a point with an angle axis rotation, as ceres::AngleAxisRotatePoint,
+ *        and compute the Jacobians of the rotated point.
+ * @param[in] angleAxis the angle axis rotation
+ * @param[in] pt the 3D point
+ * @param[out] rotatedPt the rotated point
+ * @param[out] R the rotation matrix, i.e. the Jacobian of the rotated point w.r.t. the point
+ * @param[out] dRotatedPt_dAngleAxis the Jacobian of the rotated point w.r.t. the angle axis (can be null)
+ */
+inline void angleAxisRotatePointJacobian(const double* angleAxis, const Vec3& pt,
+                                         Vec3& rotatedPt, Mat3& R, Mat3* dRotatedPt_dAngleAxis)
+{
+  const Vec3 w(angleAxis[0], angleAxis[1], angleAxis[2]);
+  // column-major, as Eigen matrices
+  ceres::AngleAxisToRotationMatrix(angleAxis, R.data());
+  rotatedPt = R * pt;
+
+  if(dRotatedPt_dAngleAxis == nullptr)
+    return;
+
+  const double theta2 = w.squaredNorm();
+  if(theta2 > std::numeric_limits<double>::epsilon())
+  {
+    // G. Gallego, A. Yezzi, "A compact formula for the derivative of a 3-D rotation in exponential coordinates"
+    // d(R.pt)/dw = -R.[pt]x.(w.w^T + (R^T - I).[w]x) / theta2
+    *dRotatedPt_dAngleAxis = -R * CrossProductMatrix(pt) *
+                             (w * w.transpose() + (R.transpose() - Mat3::Identity()) * CrossProductMatrix(w)) / theta2;
+  }
+  else
+  {
+    // first order approximation used by ceres near the identity: R.pt = pt + w x pt
+    *dRotatedPt_dAngleAxis = -CrossProductMatrix(pt);
+  }
+}
+
+/**
+ * @brief Project a point in camera coordinates with the intrinsic parameters
+ *        and compute the residual and its Jacobians.
+ * @param[in] cam_K the intrinsic data block [focal, principal point x, principal point y, distortion parameters...]
+ * @param[in] pt the point in camera coordinates
+ * @param[in] observation the 2D observation
+ * @param[out] residuals the difference between the projection and the observation
+ * @param[out] dRes_dPt the Jacobian of the residual w.r.t. the point (can be null)
+ * @param[out] dRes_dK the Jacobian of the residual w.r.t. the intrinsic data block, row-major (can be null)
+ */
+template <typename DistortionModel>
+void projectPointJacobian(const double* cam_K, const Vec3& pt, const double* observation,
+                          double* residuals, Eigen::Matrix<double, 2, 3, Eigen::RowMajor>* dRes_dPt, double* dRes_dK)
+{
+  enum { NB_INTRINSIC_PARAMS = 3 + DistortionModel::NB_DISTO_PARAMS };
+
+  const double& focal = cam_K[0];
+  const double& principal_point_x = cam_K[1];
+  const double& principal_point_y = cam_K[2];
+
+  // Transform the point from homogeneous to euclidean (undistorted point)
+  const double inv_z = 1.0 / pt(2);
+  const double x_u = pt(0) * inv_z;
+  const double y_u = pt(1) * inv_z;
+
+  double pt_d[2];
+  Eigen::Matrix<double, 2, 2, Eigen::RowMajor> dPtd_dPtu;
+  double dPtd_dDisto[2 * DistortionModel::NB_DISTO_PARAMS + 1];
+  DistortionModel::apply(cam_K + 3, x_u, y_u, pt_d, dPtd_dPtu.data(), dPtd_dDisto);
+
+  residuals[0] = principal_point_x + focal * pt_d[0] - observation[0];
+  residuals[1] = principal_point_y + focal * pt_d[1] - observation[1];
+
+  if(dRes_dPt != nullptr)
+  {
+    Eigen::Matrix<double, 2, 3, Eigen::RowMajor> dPtu_dPt;
+    dPtu_dPt << inv_z, 0.0, -x_u * inv_z,
+                0.0, inv_z, -y_u * inv_z;
+    *dRes_dPt = focal * dPtd_dPtu * dPtu_dPt;
+  }
+
+  if(dRes_dK != nullptr)
+  {
+    double* row0 = dRes_dK;
+    double* row1 = dRes_dK + NB_INTRINSIC_PARAMS;
+    row0[0] = pt_d[0]; row0[1] = 1.0; row0[2] = 0.0;
+    row1[0] = pt_d[1]; row1[1] = 0.0; row1[2] = 1.0;
+    for(int i = 0; i < DistortionModel::NB_DISTO_PARAMS; ++i)
+    {
+      row0[3 + i] = focal * dPtd_dDisto[i];
+      row1[3 + i] = focal * dPtd_dDisto[DistortionModel::NB_DISTO_PARAMS + i];
+    }
+  }
+}
+
+/**
+ * @brief Ceres cost function with analytic Jacobians for a camera and a 3D point.
+ *        Same residuals as the ResidualErrorFunctor_* functors.
+ *
+ *  Data parameter blocks are the following <2,K,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - K => the intrinsic data block [focal, principal point x, principal point y, distortion parameters...],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ */
+template <typename DistortionModel>
+class ResidualErrorCostFunction
+  : public ceres::SizedCostFunction<2, 3 + DistortionModel::NB_DISTO_PARAMS, 6, 3>
+{
+public:
+  enum { NB_INTRINSIC_PARAMS = 3 + DistortionModel::NB_DISTO_PARAMS };
+
+  explicit ResidualErrorCostFunction(const double* const pos_2dpoint)
+  {
+    m_pos_2dpoint[0] = pos_2dpoint[0];
+    m_pos_2dpoint[1] = pos_2dpoint[1];
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* cam_Rt = parameters[1];
+    const Vec3 pos_3dpoint(parameters[2][0], parameters[2][1], parameters[2][2]);
+
+    const bool computeJacobians = (jacobians != nullptr);
+    const bool needPoseJacobian = computeJacobians && (jacobians[1] != nullptr);
+
+    // Apply external parameters (Pose)
+    Vec3 pos_proj;
+    Mat3 R;
+    Mat3 dRX_dR;
+    angleAxisRotatePointJacobian(cam_Rt, pos_3dpoint, pos_proj, R, needPoseJacobian ? &dRX_dR : nullptr);
+    pos_proj += Vec3(cam_Rt[3], cam_Rt[4], cam_Rt[5]);
+
+    // Apply intrinsic parameters
+    Eigen::Matrix<double, 2, 3, Eigen::RowMajor> dRes_dPt;
+    projectPointJacobian<DistortionModel>(cam_K, pos_proj, m_pos_2dpoint, residuals,
+                                          computeJacobians ? &dRes_dPt : nullptr,
+                                          computeJacobians ? jacobians[0] : nullptr);
+    if(!computeJacobians)
+      return true;
+
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> dRes_dRt(jacobians[1]);
+      dRes_dRt.leftCols<3>() = dRes_dPt * dRX_dR;
+      dRes_dRt.rightCols<3>() = dRes_dPt;
+    }
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> dRes_dX(jacobians[2]);
+      dRes_dX = dRes_dPt * R;
+    }
+    return true;
+  }
+
+private:
+  double m_pos_2dpoint[2]; // The 2D observation
+};
+
+/**
+ * @brief Ceres cost function with analytic Jacobians for a camera of a rig and a 3D point.
+ *        Same residuals as the ResidualErrorFunctor_* functors with a rig sub-pose.
+ *
+ *  Data parameter blocks are the following <2,K,6,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - K => the intrinsic data block [focal, principal point x, principal point y, distortion parameters...],
+ *  - 6 => the rig pose data block [R;t], rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 6 => the camera sub-pose data block in the rig [R;t].
+ *  - 3 => a 3D point data block.
+ */
+template <typename DistortionModel>
+class ResidualErrorRigCostFunction
+  : public ceres::SizedCostFunction<2, 3 + DistortionModel::NB_DISTO_PARAMS, 6, 6, 3>
+{
+public:
+  enum { NB_INTRINSIC_PARAMS = 3 + DistortionModel::NB_DISTO_PARAMS };
+
+  explicit ResidualErrorRigCostFunction(const double* const pos_2dpoint)
+  {
+    m_pos_2dpoint[0] = pos_2dpoint[0];
+    m_pos_2dpoint[1] = pos_2dpoint[1];
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* cam_Rt = parameters[1];
+    const double* subpose_Rt = parameters[2];
+    const Vec3 pos_3dpoint(parameters[3][0], parameters[3][1], parameters[3][2]);
+
+    const bool computeJacobians = (jacobians != nullptr);
+    const bool needPoseJacobian = computeJacobians && (jacobians[1] != nullptr);
+    const bool needSubposeJacobian = computeJacobians && (jacobians[2] != nullptr);
+
+    // Apply RIG pose
+    Vec3 pos_rig;
+    Mat3 R;
+    Mat3 dRX_dR;
+    angleAxisRotatePointJacobian(cam_Rt, pos_3dpoint, pos_rig, R, needPoseJacobian ? &dRX_dR : nullptr);
+    pos_rig += Vec3(cam_Rt[3], cam_Rt[4], cam_Rt[5]);
+
+    // Apply RIG sub-pose
+    Vec3 pos_proj;
+    Mat3 subR;
+    Mat3 dSubRX_dSubR;
+    angleAxisRotatePointJacobian(subpose_Rt, pos_rig, pos_proj, subR, needSubposeJacobian ? &dSubRX_dSubR : nullptr);
+    pos_proj += Vec3(subpose_Rt[3], subpose_Rt[4], subpose_Rt[5]);
+
+    // Apply intrinsic parameters
+    Eigen::Matrix<double, 2, 3, Eigen::RowMajor> dRes_dPt;
+    projectPointJacobian<DistortionModel>(cam_K, pos_proj, m_pos_2dpoint, residuals,
+                                          computeJacobians ? &dRes_dPt : nullptr,
+                                          computeJacobians ? jacobians[0] : nullptr);
+    if(!computeJacobians)
+      return true;
+
+    // Jacobian of the residual w.r.t. the point in rig coordinates
+    const Eigen::Matrix<double, 2, 3, Eigen::RowMajor> dRes_dPtRig = dRes_dPt * subR;
+
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> dRes_dRt(jacobians[1]);
+      dRes_dRt.leftCols<3>() = dRes_dPtRig * dRX_dR;
+      dRes_dRt.rightCols<3>() = dRes_dPtRig;
+    }
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> dRes_dSubRt(jacobians[2]);
+      dRes_dSubRt.leftCols<3>() = dRes_dPt * dSubRX_dSubR;
+      dRes_dSubRt.rightCols<3>() = dRes_dPt;
+    }
+    if(jacobians[3] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> dRes_dX(jacobians[3]);
+      dRes_dX = dRes_dPtRig * R;
+    }
+    return true;
+  }
+
+private:
+  double m_pos_2dpoint[2]; // The 2D observation
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -9,9 +9,11 @@
 #include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/multiview/NViewDataSet.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <iostream>
+#include <set>
 
 #define BOOST_TEST_MODULE bundleAdjustment
 #include <boost/test/included/unit_test.hpp>
@@ -27,7 +29,7 @@ double RMSE(const SfMData& sfmData);
 
 SfMData getInputScene(const NViewDataSet& d, const NViewDatasetConfigurator& config, EINTRINSIC eintrinsic);
 
-track::TracksPerView getTracksPerViews(const SfMData& sfmData);
+track::TracksCSR getTracks(const SfMData& sfmData);
 
 // Test summary:
 // - Create a SfMData scene from a synthetic dataset
@@ -136,6 +138,30 @@ BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_EffectiveMinimization_PinholeFisheye)
   BOOST_CHECK(dResidual_before > dResidual_after);
 }
 
+// The analytic Jacobians (optional) reach the same minimum as the automatic differentiation (default)
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_AnalyticJacobians)
+{
+  const int nviews = 6;
+  const int npoints = 32;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  for(EINTRINSIC eintrinsic : {PINHOLE_CAMERA, PINHOLE_CAMERA_RADIAL3, PINHOLE_CAMERA_BROWN, PINHOLE_CAMERA_FISHEYE})
+  {
+    SfMData sfmDataAutodiff = getInputScene(d, config, eintrinsic);
+    SfMData sfmDataAnalytic = sfmDataAutodiff;
+
+    BundleAdjustmentCeres::BA_options options;
+    BOOST_CHECK(!options._bAnalyticJacobians);
+    BOOST_CHECK(BundleAdjustmentCeres(options).Adjust(sfmDataAutodiff));
+
+    options._bAnalyticJacobians = true;
+    BOOST_CHECK(BundleAdjustmentCeres(options).Adjust(sfmDataAnalytic));
+
+    BOOST_CHECK_CLOSE(RMSE(sfmDataAnalytic), RMSE(sfmDataAutodiff), 1e-2);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_CamerasRing)
 {
   const int nviews = 4;
@@ -163,7 +189,7 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   sfmData.structure[2].observations.erase(0);
   sfmData.structure[2].observations.erase(1);
 
-  track::TracksPerView tracksPerView = getTracksPerViews(sfmData);
+  const track::TracksCSR tracks = getTracks(sfmData);
 
   // Set the view "v0' as new (graph-distance(v0) = 0):
   std::set<IndexT> newReconstructedViews;
@@ -198,7 +224,7 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   // Assign the refinement rule for all the parameters (poses, landmarks & intrinsics) according to the LBA strategy:
   // 1. Add the new reconstructed views to the graph
   const std::size_t kMinNbOfMatches = 1;
-  localBAData.updateGraphWithNewViews(sfmData, tracksPerView, newReconstructedViews, kMinNbOfMatches);
+  localBAData.updateGraphWithNewViews(sfmData, tracks, newReconstructedViews, kMinNbOfMatches);
   // 2. Compute the graph-distance between each newly reconstructed views and all the reconstructed views
   localBAData.computeGraphDistances(sfmData, newReconstructedViews);
   // 3. Use the graph-distances to assign a LBA state (Refine, Constant & Ignore) for each parameter (poses, intrinsics & landmarks)
@@ -236,6 +262,63 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   BOOST_CHECK(dResidual_before > dResidual_after);
 }
 
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_Partitioned_Clusters)
+{
+  const int nviews = 12;
+  const int npoints = 30;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+  const SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA);
+
+  const std::size_t maxClusterSize = 4;
+  const std::vector<BundleAdjustmentPartitioned::Cluster> clusters = BundleAdjustmentPartitioned::computeClusters(sfmData, maxClusterSize, 0.5);
+
+  BOOST_CHECK_EQUAL(clusters.size(), 3);
+
+  // each pose is assigned to one cluster
+  std::set<IndexT> poses;
+  for(const BundleAdjustmentPartitioned::Cluster& cluster : clusters)
+  {
+    BOOST_CHECK(cluster.poses.size() <= maxClusterSize);
+    BOOST_CHECK_EQUAL(cluster.overlapPoses.size(), 2);
+    for(IndexT poseId : cluster.overlapPoses)
+      BOOST_CHECK(std::find(cluster.poses.begin(), cluster.poses.end(), poseId) == cluster.poses.end());
+    poses.insert(cluster.poses.begin(), cluster.poses.end());
+  }
+  BOOST_CHECK_EQUAL(poses.size(), nviews);
+}
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_Partitioned_EffectiveMinimization)
+{
+  const int nviews = 12;
+  const int npoints = 30;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA_RADIAL3);
+  SfMData sfmDataPartitioned = sfmData;
+
+  const double dResidual_before = RMSE(sfmData);
+
+  BundleAdjustmentCeres bundleAdjustment;
+  BOOST_CHECK(bundleAdjustment.Adjust(sfmData));
+
+  BundleAdjustmentPartitioned::PartitionedBA_options options;
+  options._maxClusterSize = 4;
+  options._overlapRatio = 0.5;
+  options._maxConsensusIterations = 500;
+  options._consensusTolerance = 1e-4;
+  BundleAdjustmentPartitioned partitionedBundleAdjustment(options);
+  BOOST_CHECK(partitionedBundleAdjustment.Adjust(sfmDataPartitioned));
+
+  const double dResidual_after = RMSE(sfmData);
+  const double dResidual_afterPartitioned = RMSE(sfmDataPartitioned);
+
+  BOOST_CHECK(dResidual_before > dResidual_afterPartitioned);
+  // same reprojection error as the bundle adjustment of the whole scene (in percent)
+  BOOST_CHECK_CLOSE(dResidual_afterPartitioned, dResidual_after, 0.1);
+}
+
 /// Compute the Root Mean Square Error of the residuals
 double RMSE(const SfMData & sfm_data)
 {
@@ -319,28 +402,22 @@ SfMData getInputScene(const NViewDataSet & d, const NViewDatasetConfigurator & c
   return sfm_data;
 }
 
-track::TracksPerView getTracksPerViews(const SfMData& sfmData)
+track::TracksCSR getTracks(const SfMData& sfmData)
 {
-  track::TracksPerView tracksPerView;
-  for (const auto& landIt : sfmData.getLandmarks())
+  // the track ids are the landmark ids (from 0 to the number of landmarks - 1)
+  track::TracksCSR tracks;
+  for(IndexT landmarkId = 0; landmarkId < sfmData.getLandmarks().size(); ++landmarkId)
   {
-    for (const auto& obsIt : landIt.second.observations)
+    const Landmark& landmark = sfmData.getLandmarks().at(landmarkId);
+    for(const auto& obsIt : landmark.observations)
     {
-      IndexT viewId = obsIt.first;
-      track::TrackIdSet& tracksSet = tracksPerView[viewId];
-      tracksSet.push_back(landIt.first);
+      tracks.viewIds.push_back(obsIt.first);
+      tracks.featIds.push_back(obsIt.second.id_feat);
     }
+    tracks.descTypes.push_back(landmark.descType);
+    tracks.offsets.push_back(tracks.viewIds.size());
   }
-
-  // sort tracks Ids in each view
-  #pragma omp parallel for
-  for(int i = 0; i < tracksPerView.size(); ++i)
-  {
-    track::TracksPerView::iterator it = tracksPerView.begin();
-    std::advance(it, i);
-    std::sort(it->second.begin(), it->second.end());
-  }
-
-  return tracksPerView;
+  tracks.computeViewsIndex();
+  return tracks;
 }
 
@@ -41,12 +41,10 @@ bool GlobalSfMRotationAveragingSolver::Run(
       //-------------------
       // Triplet inference (test over the composition error)
       //-------------------
-      PairSet pairs = getPairs(relativeRotations);
-      std::vector< graph::Triplet > vec_triplets = graph::tripletListing(pairs);
       //-- Rejection triplet that are 'not' identity rotation (error to identity > 5°)
-      TripletRotationRejection(5.0f, vec_triplets, relativeRotations);
+      TripletRotationRejection(5.0f, relativeRotations);
 
-      pairs = getPairs(relativeRotations);
+      PairSet pairs = getPairs(relativeRotations);
       const std::set<IndexT> set_remainingIds = graph::CleanGraph_KeepLargestBiEdge_Nodes<PairSet, IndexT>(pairs);
       if(set_remainingIds.empty())
         return false;
@@ -147,80 +145,89 @@ bool GlobalSfMRotationAveragingSolver::Run(
 ///  angular error once rotation composition have been computed.
 void GlobalSfMRotationAveragingSolver::TripletRotationRejection(
   const double max_angular_error,
-  std::vector< graph::Triplet > & vec_triplets,
   RelativeRotations & relativeRotations) const
 {
   const size_t edges_start_count = relativeRotations.size();
 
-  RelativeRotationsMap map_relatives = getMap(relativeRotations);
-  RelativeRotationsMap map_relatives_validated;
+  const RelativeRotationsMap map_relatives = getMap(relativeRotations);
+  const graph::SortedAdjacencyGraph graph(getPairs(relativeRotations));
+
+  // Relative rotation of each edge of the graph, from its node of lower id to the other one
+  // (the relative rotation from the lower id is used if the two directions exist).
+  std::vector<const RelativeRotation*> edgeRelatives(graph.nbEdges(), nullptr);
+  std::vector<Mat3> edgeRotations(graph.nbEdges());
+  for (const auto & relative : map_relatives)
+  {
+    const Pair & pair = relative.first;
+    if (pair.first == pair.second)
+      continue;
+    const std::size_t edge = graph.edgeId(pair.first, pair.second);
+    if (edgeRelatives[edge] != nullptr)
+      continue;
+    edgeRelatives[edge] = &relative.second;
+    edgeRotations[edge] = (pair.first < pair.second) ? relative.second.Rij : Mat3(relative.second.Rij.transpose());
+  }
 
   //--
   // ROTATION OUTLIERS DETECTION
   //--
 
-  std::vector< graph::Triplet > vec_triplets_validated;
-  vec_triplets_validated.reserve(vec_triplets.size());
-
+  std::vector<char> validatedEdges(graph.nbEdges(), 0);
   std::vector<float> vec_errToIdentityPerTriplet;
-  vec_errToIdentityPerTriplet.reserve(vec_triplets.size());
-  // Compute the composition error for each length 3 cycles
-  for (size_t i = 0; i < vec_triplets.size(); ++i)
-  {
-    const graph::Triplet & triplet = vec_triplets[i];
-    const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
+  std::size_t nbValidatedTriplets = 0;
 
-    //-- Find the three relative rotations
-    const Pair ij(I,J), ji(J,I);
-    const Mat3 RIJ = (map_relatives.count(ij)) ?
-      map_relatives.at(ij).Rij : Mat3(map_relatives.at(ji).Rij.transpose());
-
-    const Pair jk(J,K), kj(K,J);
-    const Mat3 RJK = (map_relatives.count(jk)) ?
-      map_relatives.at(jk).Rij : Mat3(map_relatives.at(kj).Rij.transpose());
+  // Compute the composition error for each length 3 cycles,
+  // while enumerating the triplets of the graph in parallel over their first node
+  const std::ptrdiff_t nbNodes = graph.nbNodes();
+  #pragma omp parallel
+  {
+    std::vector<float> errors;
+    std::vector<char> validated(graph.nbEdges(), 0);
+    std::size_t nbValidated = 0;
+    auto evaluateTriplet = [&](std::size_t, std::size_t, std::size_t, std::size_t ij, std::size_t ik, std::size_t jk)
+    {
+      const Mat3 Rot_To_Identity = edgeRotations[ij] * edgeRotations[jk] * edgeRotations[ik].transpose(); // motion composition
+      const float angularErrorDegree = static_cast<float>(radianToDegree(getRotationMagnitude(Rot_To_Identity)));
+      errors.push_back(angularErrorDegree);
 
-    const Pair ki(K,I), ik(I,K);
-    const Mat3 RKI = (map_relatives.count(ki)) ?
-      map_relatives.at(ki).Rij : Mat3(map_relatives.at(ik).Rij.transpose());
+      if (angularErrorDegree < max_angular_error)
+      {
+        ++nbValidated;
+        validated[ij] = validated[ik] = validated[jk] = 1;
+      }
+    };
 
-    const Mat3 Rot_To_Identity = RIJ * RJK * RKI; // motion composition
-    const float angularErrorDegree = static_cast<float>(radianToDegree(getRotationMagnitude(Rot_To_Identity)));
-    vec_errToIdentityPerTriplet.push_back(angularErrorDegree);
+    #pragma omp for schedule(dynamic, 16)
+    for (std::ptrdiff_t i = 0; i < nbNodes; ++i)
+      graph::forEachNodeTriplet(graph, i, evaluateTriplet);
 
-    if (angularErrorDegree < max_angular_error)
+    #pragma omp critical
     {
-      vec_triplets_validated.push_back(triplet);
-
-      if (map_relatives.count(ij))
-        map_relatives_validated[ij] = map_relatives.at(ij);
-      else
-        map_relatives_validated[ji] = map_relatives.at(ji);
-
-      if (map_relatives.count(jk))
-        map_relatives_validated[jk] = map_relatives.at(jk);
-      else
-        map_relatives_validated[kj] = map_relatives.at(kj);
-
-      if (map_relatives.count(ki))
-        map_relatives_validated[ki] = map_relatives.at(ki);
-      else
-        map_relatives_validated[ik] = map_relatives.at(ik);
+      vec_errToIdentityPerTriplet.insert(vec_errToIdentityPerTriplet.end(), errors.begin(), errors.end());
+      nbValidatedTriplets += nbValidated;
+      for (std::size_t edge = 0; edge < validated.size(); ++edge)
+        validatedEdges[edge] |= validated[edge];
     }
   }
-  map_relatives = std::move(map_relatives_validated);
 
   // update to keep only useful triplets
   relativeRotations.clear();
-  relativeRotations.reserve(map_relatives.size());
-  std::transform(map_relatives.begin(), map_relatives.end(), std::back_inserter(relativeRotations), stl::RetrieveValue());
-  std::transform(map_relatives.begin(), map_relatives.end(), std::inserter(used_pairs, used_pairs.begin()), stl::RetrieveKey());
+  for (const auto & relative : map_relatives)
+  {
+    if (relative.first.first == relative.first.second)
+      continue;
+    const std::size_t edge = graph.edgeId(relative.first.first, relative.first.second);
+    if (validatedEdges[edge] && edgeRelatives[edge] == &relative.second)
+    {
+      relativeRotations.push_back(relative.second);
+      used_pairs.insert(relative.first);
+    }
+  }
 
   // Display statistics about rotation triplets error:
   ALICEVISION_LOG_DEBUG("Statistics about rotation triplets:");
   ALICEVISION_LOG_DEBUG(MinMaxMeanMedian<float>(vec_errToIdentityPerTriplet.begin(), vec_errToIdentityPerTriplet.end()));
 
-  std::sort(vec_errToIdentityPerTriplet.begin(), vec_errToIdentityPerTriplet.end());
-
   if (!vec_errToIdentityPerTriplet.empty())
   {
     Histogram<float> histo(0.0f, *max_element(vec_errToIdentityPerTriplet.begin(), vec_errToIdentityPerTriplet.end()), 20);
@@ -231,12 +238,10 @@ void GlobalSfMRotationAveragingSolver::TripletRotationRejection(
   {
     ALICEVISION_LOG_DEBUG("Triplets filtering based on composition error on unit cycles");
     ALICEVISION_LOG_DEBUG(
-      "#Triplets before: " << vec_triplets.size() << "\n"
-      "#Triplets after: " << vec_triplets_validated.size());
+      "#Triplets before: " << vec_errToIdentityPerTriplet.size() << "\n"
+      "#Triplets after: " << nbValidatedTriplets);
   }
 
-  vec_triplets = std::move(vec_triplets_validated);
-
   const size_t edges_end_count = relativeRotations.size();
   ALICEVISION_LOG_DEBUG("#Edges removed by triplet inference: " << edges_start_count - edges_end_count);
 }
@@ -47,9 +47,10 @@ public:
   /**
    * @brief Reject edges of the view graph that do not produce triplets with tiny
    * angular error once rotation composition have been computed.
+   * The triplets are enumerated in parallel and their composition error is computed
+   * in the same pass (the triplets are not stored).
    */
   void TripletRotationRejection(const double max_angular_error,
-                                std::vector<graph::Triplet>& vec_triplets,
                                 rotationAveraging::RelativeRotations& relativeRotations) const;
   /**
    * @brief Return the pairs validated by the GlobalRotation routine (inference can remove some)
@@ -111,6 +111,11 @@ void ReconstructionEngine_globalSfM::SetTranslationAveragingMethod(ETranslationA
   _eTranslationAveragingMethod = eTranslationAveragingMethod;
 }
 
+void ReconstructionEngine_globalSfM::SetUseAnalyticJacobians(bool useAnalyticJacobians)
+{
+  _useAnalyticJacobians = useAnalyticJacobians;
+}
+
 bool ReconstructionEngine_globalSfM::process()
 {
   // keep only the largest biedge connected subgraph
@@ -281,25 +286,24 @@ bool ReconstructionEngine_globalSfM::Compute_Initial_Structure(matching::Pairwis
     tracksBuilder.build(tripletWise_matches);
 #endif
     tracksBuilder.filter(3);
-    TracksMap map_selectedTracks; // reconstructed track (visibility per 3D point)
-    tracksBuilder.exportToSTL(map_selectedTracks);
+    TracksCSR selectedTracks; // reconstructed track (visibility per 3D point)
+    tracksBuilder.exportToCSR(selectedTracks);
 
     // Fill sfm_data with the computed tracks (no 3D yet)
     Landmarks & structure = _sfmData.structure;
-    IndexT idx(0);
-    for (TracksMap::const_iterator itTracks = map_selectedTracks.begin();
-      itTracks != map_selectedTracks.end();
-      ++itTracks, ++idx)
+    for (IndexT idx = 0; idx < selectedTracks.nbTracks(); ++idx)
     {
-      const Track & track = itTracks->second;
+      const feature::EImageDescriberType descType = selectedTracks.descTypes[idx];
+      const ArrayRange<IndexT> trackViewIds = selectedTracks.trackViewIds(idx);
+      const ArrayRange<IndexT> trackFeatIds = selectedTracks.trackFeatIds(idx);
       Landmark& newLandmark = structure[idx];
-      newLandmark.descType = track.descType;
+      newLandmark.descType = descType;
       Observations & obs = newLandmark.observations;
-      for (Track::FeatureIdPerView::const_iterator it = track.featPerView.begin(); it != track.featPerView.end(); ++it)
+      for (std::size_t i = 0; i < trackViewIds.size(); ++i)
       {
-        const size_t imaIndex = it->first;
-        const size_t featIndex = it->second;
-        const PointFeature & pt = _featuresPerView->getFeatures(imaIndex, track.descType)[featIndex];
+        const size_t imaIndex = trackViewIds[i];
+        const size_t featIndex = trackFeatIds[i];
+        const PointFeature & pt = _featuresPerView->getFeatures(imaIndex, descType)[featIndex];
         obs[imaIndex] = Observation(pt.coords().cast<double>(), featIndex);
       }
     }
@@ -310,19 +314,18 @@ bool ReconstructionEngine_globalSfM::Compute_Initial_Structure(matching::Pairwis
       //-- Display stats:
       //    - number of images
       //    - number of tracks
-      std::set<size_t> set_imagesId;
-      tracksUtilsMap::imageIdInTracks(map_selectedTracks, set_imagesId);
       osTrack << "------------------" << "\n"
         << "-- Tracks Stats --" << "\n"
         << " Tracks number: " << tracksBuilder.nbTracks() << "\n"
         << " Images Id: " << "\n";
-      std::copy(set_imagesId.begin(),
-        set_imagesId.end(),
+      std::copy(selectedTracks.views.begin(),
+        selectedTracks.views.end(),
         std::ostream_iterator<size_t>(osTrack, ", "));
       osTrack << "\n------------------" << "\n";
 
       std::map<size_t, size_t> map_Occurence_TrackLength;
-      tracksUtilsMap::tracksLength(map_selectedTracks, map_Occurence_TrackLength);
+      for (std::size_t trackId = 0; trackId < selectedTracks.nbTracks(); ++trackId)
+        ++map_Occurence_TrackLength[selectedTracks.trackLength(trackId)];
       osTrack << "TrackLength, Occurrence" << "\n";
       for (std::map<size_t, size_t>::const_iterator iter = map_Occurence_TrackLength.begin();
         iter != map_Occurence_TrackLength.end(); ++iter)  {
@@ -361,7 +364,9 @@ bool ReconstructionEngine_globalSfM::Adjust()
 {
   // Refine sfm_scene (in a 3 iteration process (free the parameters regarding their incertainty order)):
 
-  BundleAdjustmentCeres bundle_adjustment_obj;
+  BundleAdjustmentCeres::BA_options options;
+  options._bAnalyticJacobians = _useAnalyticJacobians;
+  BundleAdjustmentCeres bundle_adjustment_obj(options);
   // - refine only Structure and translations
   bool b_BA_Status = bundle_adjustment_obj.Adjust(_sfmData, BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE);
   if (b_BA_Status)
@@ -584,6 +589,7 @@ void ReconstructionEngine_globalSfM::Compute_Relative_Rotations(rotationAveragin
         // - refine only Structure and Rotations & translations (keep intrinsic constant)
         BundleAdjustmentCeres::BA_options options(false, false);
         options._linear_solver_type = ceres::DENSE_SCHUR;
+        options._bAnalyticJacobians = _useAnalyticJacobians;
         BundleAdjustmentCeres bundle_adjustment_obj(options);
         if (bundle_adjustment_obj.Adjust(tinyScene, BA_REFINE_ROTATION | BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE))
         {
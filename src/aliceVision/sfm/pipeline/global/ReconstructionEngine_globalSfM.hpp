@@ -34,6 +34,9 @@ public:
   void SetRotationAveragingMethod(ERotationAveragingMethod eRotationAveragingMethod);
   void SetTranslationAveragingMethod(ETranslationAveragingMethod eTranslationAveragingMethod);
 
+  /// Use the cost functions with analytic Jacobians in the bundle adjustments instead of the automatic differentiation
+  void SetUseAnalyticJacobians(bool useAnalyticJacobians);
+
   virtual bool process();
 
 protected:
@@ -62,6 +65,7 @@ private:
   // Parameter
   ERotationAveragingMethod _eRotationAveragingMethod;
   ETranslationAveragingMethod _eTranslationAveragingMethod;
+  bool _useAnalyticJacobians = false;
 
   // Data provider
   feature::FeaturesPerView* _featuresPerView;
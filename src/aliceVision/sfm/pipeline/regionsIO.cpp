@@ -20,6 +20,24 @@ namespace sfm {
 
 using namespace sfmData;
 
+/**
+ * @brief Get the path of the features file of a view in the given folder.
+ * @note The binary keypoints file (.featb) is preferred over the ASCII one (.feat).
+ * @return the features file path or an empty path if there is no features file
+ */
+static fs::path getFeaturesPath(const std::string& folder, const std::string& basename, const std::string& imageDescriberTypeName)
+{
+  const fs::path featBinPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + feature::featsBinFileExtension);
+  if(fs::exists(featBinPath))
+    return featBinPath;
+
+  const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
+  if(fs::exists(featPath))
+    return featPath;
+
+  return fs::path();
+}
+
 std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders,
                                               IndexT viewId,
                                               const feature::ImageDescriber& imageDescriber)
@@ -34,10 +52,10 @@ std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& fo
 
   for(const std::string& folder : folders)
   {
-    const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
+    const fs::path featPath = getFeaturesPath(folder, basename, imageDescriberTypeName);
     const fs::path descPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".desc");
 
-    if(fs::exists(featPath) && fs::exists(descPath))
+    if(!featPath.empty() && fs::exists(descPath))
     {
       featFilename = featPath.string();
       descFilename = descPath.string();
@@ -86,8 +104,8 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
 
   for(const std::string& folder : folders)
   {
-    const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
-    if(fs::exists(featPath))
+    const fs::path featPath = getFeaturesPath(folder, basename, imageDescriberTypeName);
+    if(!featPath.empty())
       featFilename = featPath.string();
   }
 
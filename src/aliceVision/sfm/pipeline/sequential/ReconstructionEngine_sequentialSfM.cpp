@@ -10,6 +10,7 @@
 #include <aliceVision/sfm/utils/statistics.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/BundleAdjustmentPartitioned.hpp>
 #include <aliceVision/sfm/LocalBundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/sfmFilters.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
@@ -26,6 +27,7 @@
 #include <aliceVision/system/cpu.hpp>
 #include <aliceVision/system/MemoryInfo.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <dependencies/htmlDoc/htmlDoc.hpp>
 
@@ -54,22 +56,21 @@ using namespace aliceVision::sfmData;
  * @brief Compute indexes of all features in a fixed size pyramid grid.
  * These precomputed values are useful to the next best view selection for incremental SfM.
  *
- * @param[in] tracksPerView: The list of TrackID per view
- * @param[in] map_tracks: All putative tracks
+ * @param[in] tracks: All putative tracks, with the views index
  * @param[in] views: All views
  * @param[in] featuresProvider: Input features and descriptors
  * @param[in] pyramidDepth: Depth of the pyramid.
- * @param[out] tracksPyramidPerView:
- *             Precomputed list of pyramid cells ID for each track in each view.
+ * @param[out] tracksPyramid:
+ *             Precomputed pyramid cell ID of each observation of the views index
+ *             (in the order of tracks.viewTrackIds), pyramidDepth values per observation.
  */
 void computeTracksPyramidPerView(
-    const track::TracksPerView& tracksPerView,
-    const track::TracksMap& map_tracks,
+    const track::TracksCSR& tracks,
     const Views& views,
     const feature::FeaturesPerView& featuresProvider,
     const std::size_t pyramidBase,
     const std::size_t pyramidDepth,
-    track::TracksPyramidPerView& tracksPyramidPerView)
+    std::vector<IndexT>& tracksPyramid)
 {
   std::vector<std::size_t> widthPerLevel(pyramidDepth);
   std::vector<std::size_t> startPerLevel(pyramidDepth);
@@ -81,18 +82,12 @@ void computeTracksPyramidPerView(
     start += Square(widthPerLevel[level]);
   }
 
-  tracksPyramidPerView.reserve(tracksPerView.size());
-  for(const auto& viewTracks: tracksPerView)
-  {
-    auto& trackPyramid = tracksPyramidPerView[viewTracks.first];
-    // reserve 500 tracks in each view
-    trackPyramid.reserve(500 * pyramidDepth);
-  }
+  tracksPyramid.resize(tracks.viewTrackIds.size() * pyramidDepth);
 
-  for(const auto& viewTracks: tracksPerView)
+#pragma omp parallel for schedule(dynamic)
+  for(int v = 0; v < static_cast<int>(tracks.views.size()); ++v)
   {
-    const auto viewId = viewTracks.first;
-    auto& tracksPyramidIndex = tracksPyramidPerView[viewId];
+    const IndexT viewId = tracks.views[v];
     const View& view = *views.at(viewId).get();
     std::vector<double> cellWidthPerLevel(pyramidDepth);
     std::vector<double> cellHeightPerLevel(pyramidDepth);
@@ -101,13 +96,12 @@ void computeTracksPyramidPerView(
       cellWidthPerLevel[level] = (double)view.getWidth() / (double)widthPerLevel[level];
       cellHeightPerLevel[level] = (double)view.getHeight() / (double)widthPerLevel[level];
     }
-    for(std::size_t i = 0; i < viewTracks.second.size(); ++i)
+    for(std::size_t i = tracks.viewOffsets[v]; i < tracks.viewOffsets[v + 1]; ++i)
     {
-      const std::size_t trackId = viewTracks.second[i];
-      const track::Track& track = map_tracks.at(trackId);
-      const std::size_t featIndex = track.featPerView.at(viewId);
-      const auto& feature = featuresProvider.getFeatures(viewId, track.descType)[featIndex]; 
-      
+      const IndexT trackId = tracks.viewTrackIds[i];
+      const IndexT featIndex = tracks.viewFeatIds[i];
+      const auto& feature = featuresProvider.getFeatures(viewId, tracks.descTypes[trackId])[featIndex];
+
       for(std::size_t level = 0; level < pyramidDepth; ++level)
       {
         std::size_t xCell = std::floor(std::max(feature.x(), 0.0f) / cellWidthPerLevel[level]);
@@ -116,7 +110,7 @@ void computeTracksPyramidPerView(
         yCell = std::min(yCell, widthPerLevel[level] - 1);
         const std::size_t levelIndex = xCell + yCell * widthPerLevel[level];
         assert(levelIndex < Square(widthPerLevel[level]));
-        tracksPyramidIndex[trackId * pyramidDepth + level] = startPerLevel[level] + levelIndex;
+        tracksPyramid[i * pyramidDepth + level] = startPerLevel[level] + levelIndex;
       }
     }
   }
@@ -217,25 +211,22 @@ std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
     }
 
     ALICEVISION_LOG_DEBUG("Track export to internal structure");
-    // build tracks with STL compliant type
-    tracksBuilder.exportToSTL(_map_tracks);
-    ALICEVISION_LOG_DEBUG("Build tracks per view");
-    track::tracksUtilsMap::computeTracksPerView(_map_tracks, _map_tracksPerView);
+    // build tracks and tracks per view
+    tracksBuilder.exportToCSR(_tracks);
     ALICEVISION_LOG_DEBUG("Build tracks pyramid per view");
     computeTracksPyramidPerView(
-            _map_tracksPerView, _map_tracks, _sfmData.views, *_featuresPerView, _pyramidBase, _pyramidDepth, _map_featsPyramidPerView);
+            _tracks, _sfmData.views, *_featuresPerView, _pyramidBase, _pyramidDepth, _featsPyramid);
 
     // display stats
     {
-      std::set<size_t> imagesId;
-      track::tracksUtilsMap::imageIdInTracks(_map_tracksPerView, imagesId);
-
       ALICEVISION_LOG_INFO("Fuse matches into tracks: " << std::endl
         << "\t- # tracks: " << tracksBuilder.nbTracks() << std::endl
-        << "\t- # images in tracks: " << imagesId.size());
+        << "\t- # images in tracks: " << _tracks.views.size() << std::endl
+        << "\t- tracks memory size: " << (_tracks.memorySize() + _featsPyramid.capacity() * sizeof(IndexT)) / (1024 * 1024) << " MB");
 
       std::map<size_t, size_t> map_Occurence_TrackLength;
-      track::tracksUtilsMap::tracksLength(_map_tracks, map_Occurence_TrackLength);
+      for(std::size_t trackId = 0; trackId < _tracks.nbTracks(); ++trackId)
+        ++map_Occurence_TrackLength[_tracks.trackLength(trackId)];
       ALICEVISION_LOG_INFO("TrackLength, Occurrence");
       for(const auto& iter: map_Occurence_TrackLength)
       {
@@ -245,7 +236,7 @@ std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
       }
     }
   }
-  return _map_tracks.size();
+  return _tracks.nbTracks();
 }
 
 std::vector<Pair> ReconstructionEngine_sequentialSfM::getInitialImagePairsCandidates()
@@ -313,14 +304,14 @@ void ReconstructionEngine_sequentialSfM::remapLandmarkIdsToTrackIds()
   ALICEVISION_LOG_DEBUG("Find corresponding landmark id per track id");
 
   // find corresponding landmark id per track id
-  for(const auto& trackPair : _map_tracks)
+  for(IndexT trackId = 0; trackId < _tracks.nbTracks(); ++trackId)
   {
-    const IndexT trackId = trackPair.first;
-    const Track& track = trackPair.second;
+    const track::ArrayRange<IndexT> trackViewIds = _tracks.trackViewIds(trackId);
+    const track::ArrayRange<IndexT> trackFeatIds = _tracks.trackFeatIds(trackId);
 
-    for(const auto& featView : track.featPerView)
+    for(std::size_t i = 0; i < trackViewIds.size(); ++i)
     {
-      const ObsToLandmark::const_iterator it = obsToLandmark.find(ObsKey(featView.first, featView.second, track.descType));
+      const ObsToLandmark::const_iterator it = obsToLandmark.find(ObsKey(trackViewIds[i], trackFeatIds[i], _tracks.descTypes[trackId]));
 
       if(it != obsToLandmark.end())
       {
@@ -332,7 +323,7 @@ void ReconstructionEngine_sequentialSfM::remapLandmarkIdsToTrackIds()
   }
 
   ALICEVISION_LOG_INFO("Landmark ids to track ids reampping: " << std::endl
-                        << "\t- # tracks: " << _map_tracks.size() << std::endl
+                        << "\t- # tracks: " << _tracks.nbTracks() << std::endl
                         << "\t- # input landmarks: " << landmarks.size() << std::endl
                         << "\t- # output landmarks: " << _sfmData.getLandmarks().size());
 }
@@ -406,8 +397,11 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
   // get reconstructed views before resection
   const std::set<IndexT> prevReconstructedViews = _sfmData.getValidViews();
 
-  // add images to the 3D reconstruction
-#pragma omp parallel for
+  // compute the resection of the new images in parallel, the scene is not modified
+  std::vector<ResectionData> resectionDataPerView(bestViewIds.size());
+  std::vector<char> hasResected(bestViewIds.size(), false);
+
+#pragma omp parallel for schedule(dynamic)
   for(int i = 0; i < bestViewIds.size(); ++i)
   {
     const IndexT viewId = bestViewIds.at(i);
@@ -423,10 +417,6 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
           << "\t- view id: " << viewId << std::endl
           << "\t- rig id: " << view.getRigId() << std::endl
           << "\t- sub-pose id: " << view.getSubPoseId());
-
-#pragma omp critical
-        viewIds.erase(viewId);
-
         continue;
       }
 
@@ -442,32 +432,29 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
           << "\t- view id: " << viewId << std::endl
           << "\t- rig id: " << view.getRigId() << std::endl
           << "\t- sub-pose id: " << view.getSubPoseId());
-
-#pragma omp critical
-        viewIds.erase(viewId);
-
         continue;
       }
     }
 
-    ResectionData newResectionData;
-    const bool hasResected = computeResection(viewId, newResectionData);
+    hasResected[i] = computeResection(viewId, resectionDataPerView[i]);
 
-#pragma omp critical
+    if(hasResected[i])
+      ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) succeed.");
+    else
+      ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) was not possible.");
+  }
+
+  // add the resected images to the 3D reconstruction, in the order of bestViewIds
+  for(std::size_t i = 0; i < bestViewIds.size(); ++i)
+  {
+    const IndexT viewId = bestViewIds.at(i);
+    if(hasResected[i])
     {
-      if(hasResected)
-      {
-        imageAdded |= hasResected;
-        updateScene(viewId, newResectionData);
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) succeed.");
-        _sfmData.getViews().at(viewId)->setResectionId(resectionId);
-      }
-      else
-      {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) was not possible.");
-      }
-      viewIds.erase(viewId);
+      imageAdded = true;
+      updateScene(viewId, resectionDataPerView[i]);
+      _sfmData.getViews().at(viewId)->setResectionId(resectionId);
     }
+    viewIds.erase(viewId);
   }
 
   ALICEVISION_LOG_DEBUG("Resection of " << bestViewIds.size() << " new images took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
@@ -489,11 +476,7 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
   // triangulate
   chrono_start = std::chrono::steady_clock::now();
 
-  // allow to use to the old triangulatation algorithm (using 2 views only)
-  if(_minNbObservationsForTriangulation == 0)
-    triangulate(_sfmData, prevReconstructedViews, newReconstructedViews);
-  else
-    triangulateMultiViews_LORANSAC(_sfmData, prevReconstructedViews, newReconstructedViews);
+  triangulateTracks(prevReconstructedViews, newReconstructedViews);
 
   ALICEVISION_LOG_DEBUG("Triangulation of the " << newReconstructedViews.size() << " newly reconstructed views took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
 
@@ -564,6 +547,15 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
      << "\t- # landmarks: " << _sfmData.getLandmarks().size());
 }
 
+void ReconstructionEngine_sequentialSfM::triangulateTracks(const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
+{
+  // allow to use to the old triangulatation algorithm (using 2 views only)
+  if(_minNbObservationsForTriangulation == 0)
+    triangulate(_sfmData, previousReconstructedViews, newReconstructedViews);
+  else
+    triangulateMultiViews_LORANSAC(_sfmData, previousReconstructedViews, newReconstructedViews);
+}
+
 void ReconstructionEngine_sequentialSfM::exportStatistics(double reconstructionTime)
 {
   const double residual = RMSE(_sfmData);
@@ -659,10 +651,12 @@ bool ReconstructionEngine_sequentialSfM::findConnectedViews(
     return false;
 
   // Collect tracksIds
-  std::set<size_t> reconstructed_trackId;
+  std::vector<IndexT> reconstructed_trackId;
+  reconstructed_trackId.reserve(_sfmData.getLandmarks().size());
   std::transform(_sfmData.getLandmarks().begin(), _sfmData.getLandmarks().end(),
-                 std::inserter(reconstructed_trackId, reconstructed_trackId.begin()),
+                 std::back_inserter(reconstructed_trackId),
                  stl::RetrieveKey());
+  std::sort(reconstructed_trackId.begin(), reconstructed_trackId.end());
 
   const std::set<IndexT> reconstructedIntrinsics = _sfmData.getReconstructedIntrinsics();
 
@@ -676,11 +670,7 @@ bool ReconstructionEngine_sequentialSfM::findConnectedViews(
     const bool isIntrinsicsReconstructed = reconstructedIntrinsics.count(intrinsicId);
 
     // Compute 2D - 3D possible content
-    aliceVision::track::TracksPerView::const_iterator tracksIdsIt = _map_tracksPerView.find(viewId);
-    if(tracksIdsIt == _map_tracksPerView.end())
-      continue;
-
-    const aliceVision::track::TrackIdSet& set_tracksIds = tracksIdsIt->second;
+    const track::ArrayRange<IndexT> set_tracksIds = _tracks.viewTracks(viewId);
     if (set_tracksIds.empty())
       continue;
 
@@ -712,7 +702,7 @@ bool ReconstructionEngine_sequentialSfM::findConnectedViews(
 
     // Count the common possible putative point
     //  with the already 3D reconstructed trackId
-    std::vector<std::size_t> vec_trackIdForResection;
+    std::vector<IndexT> vec_trackIdForResection;
     vec_trackIdForResection.reserve(set_tracksIds.size());
     std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
                           reconstructed_trackId.begin(),
@@ -879,26 +869,20 @@ bool ReconstructionEngine_sequentialSfM::makeInitialPair3D(const Pair& current_p
 
   // b. Get common features between the two views
   // use the track to have a more dense match correspondence set
-  aliceVision::track::TracksMap map_tracksCommon;
-  const std::set<std::size_t> set_imageIndex= {I, J};
-  track::tracksUtilsMap::getCommonTracksInImagesFast(set_imageIndex, _map_tracks, _map_tracksPerView, map_tracksCommon);
+  std::vector<track::TracksCSR::CommonTrack> tracksCommon;
+  _tracks.getCommonTracks(I, J, tracksCommon);
 
   //-- Copy point to arrays
-  const std::size_t n = map_tracksCommon.size();
+  const std::size_t n = tracksCommon.size();
   Mat xI(2,n), xJ(2,n);
-  std::size_t cptIndex = 0;
-  for (aliceVision::track::TracksMap::const_iterator
-    iterT = map_tracksCommon.begin(); iterT != map_tracksCommon.end();
-    ++iterT, ++cptIndex)
+  for (std::size_t cptIndex = 0; cptIndex < n; ++cptIndex)
   {
-    assert(iterT->second.featPerView.size() == 2);
-    auto iter = iterT->second.featPerView.begin();
-    const std::size_t i = iter->second;
-    const std::size_t j = (++iter)->second;
+    const track::TracksCSR::CommonTrack& commonTrack = tracksCommon[cptIndex];
+    const feature::EImageDescriberType descType = _tracks.descTypes[commonTrack.trackId];
 
-    Vec2 feat = _featuresPerView->getFeatures(I, iterT->second.descType)[i].coords().cast<double>();
+    Vec2 feat = _featuresPerView->getFeatures(I, descType)[commonTrack.featI].coords().cast<double>();
     xI.col(cptIndex) = camI->get_ud_pixel(feat);
-    feat = _featuresPerView->getFeatures(J, iterT->second.descType)[j].coords().cast<double>();
+    feat = _featuresPerView->getFeatures(J, descType)[commonTrack.featJ].coords().cast<double>();
     xJ.col(cptIndex) = camJ->get_ud_pixel(feat);
   }
   ALICEVISION_LOG_INFO(n << " matches in the image pair for the initial pose estimation.");
@@ -1097,31 +1081,24 @@ bool ReconstructionEngine_sequentialSfM::getBestInitialImagePairs(std::vector<Pa
     if (camI == nullptr || camJ == nullptr)
       continue;
 
-    aliceVision::track::TracksMap map_tracksCommon;
-    const std::set<size_t> set_imageIndex= {I, J};
-    track::tracksUtilsMap::getCommonTracksInImagesFast(set_imageIndex, _map_tracks, _map_tracksPerView, map_tracksCommon);
+    std::vector<track::TracksCSR::CommonTrack> tracksCommon;
+    _tracks.getCommonTracks(I, J, tracksCommon);
 
     // Copy points correspondences to arrays for relative pose estimation
-    const size_t n = map_tracksCommon.size();
+    const size_t n = tracksCommon.size();
     ALICEVISION_LOG_INFO("AutomaticInitialPairChoice, test I: " << I << ", J: " << J << ", nbCommonTracks: " << n);
     Mat xI(2,n), xJ(2,n);
-    size_t cptIndex = 0;
-    std::vector<std::size_t> commonTracksIds(n);
-    for (aliceVision::track::TracksMap::const_iterator
-      iterT = map_tracksCommon.begin(); iterT != map_tracksCommon.end();
-      ++iterT, ++cptIndex)
+    for (size_t cptIndex = 0; cptIndex < n; ++cptIndex)
     {
-      auto iter = iterT->second.featPerView.begin();
-      const size_t i = iter->second;
-      const size_t j = (++iter)->second;
-      commonTracksIds[cptIndex] = iterT->first;
-      
-      const auto& viewI = _featuresPerView->getFeatures(I, iterT->second.descType); 
-      const auto& viewJ = _featuresPerView->getFeatures(J, iterT->second.descType);
+      const track::TracksCSR::CommonTrack& commonTrack = tracksCommon[cptIndex];
+      const feature::EImageDescriberType descType = _tracks.descTypes[commonTrack.trackId];
+
+      const auto& viewI = _featuresPerView->getFeatures(I, descType);
+      const auto& viewJ = _featuresPerView->getFeatures(J, descType);
       
-      Vec2 feat = viewI[i].coords().cast<double>();
+      Vec2 feat = viewI[commonTrack.featI].coords().cast<double>();
       xI.col(cptIndex) = camI->get_ud_pixel(feat);
-      feat = viewJ[j].coords().cast<double>();
+      feat = viewJ[commonTrack.featJ].coords().cast<double>();
       xJ.col(cptIndex) = camJ->get_ud_pixel(feat);
     }
     
@@ -1139,7 +1116,7 @@ bool ReconstructionEngine_sequentialSfM::getBestInitialImagePairs(std::vector<Pa
     {
       // Triangulate inliers & compute angle between bearing vectors
       std::vector<float> vec_angles(relativePose_info.vec_inliers.size());
-      std::vector<std::size_t> validCommonTracksIds(relativePose_info.vec_inliers.size());
+      std::vector<IndexT> validCommonTracksIds(relativePose_info.vec_inliers.size());
       const Pose3 pose_I = Pose3(Mat3::Identity(), Vec3::Zero());
       const Pose3 pose_J = relativePose_info.relativePose;
       const Mat34 PI = camI->get_projective_equivalent(pose_I);
@@ -1149,12 +1126,12 @@ bool ReconstructionEngine_sequentialSfM::getBestInitialImagePairs(std::vector<Pa
       {
         Vec3 X;
         TriangulateDLT(PI, xI.col(inlier_idx), PJ, xJ.col(inlier_idx), &X);
-        IndexT trackId = commonTracksIds[inlier_idx];
-        auto iter = map_tracksCommon[trackId].featPerView.begin();
-        const Vec2 featI = _featuresPerView->getFeatures(I, map_tracksCommon[trackId].descType)[iter->second].coords().cast<double>();
-        const Vec2 featJ = _featuresPerView->getFeatures(J, map_tracksCommon[trackId].descType)[(++iter)->second].coords().cast<double>();
+        const track::TracksCSR::CommonTrack& commonTrack = tracksCommon[inlier_idx];
+        const feature::EImageDescriberType descType = _tracks.descTypes[commonTrack.trackId];
+        const Vec2 featI = _featuresPerView->getFeatures(I, descType)[commonTrack.featI].coords().cast<double>();
+        const Vec2 featJ = _featuresPerView->getFeatures(J, descType)[commonTrack.featJ].coords().cast<double>();
         vec_angles[i] = AngleBetweenRays(pose_I, camI, pose_J, camJ, featI, featJ);
-        validCommonTracksIds[i] = trackId;
+        validCommonTracksIds[i] = commonTrack.trackId;
         ++i;
       }
       // Compute the median triangulation angle
@@ -1278,24 +1255,40 @@ double ReconstructionEngine_sequentialSfM::computeTracksLengthsHistogram(Histogr
   return stats.mean;
 }
 
-std::size_t ReconstructionEngine_sequentialSfM::computeImageScore(IndexT viewId, const std::vector<std::size_t>& trackIds) const
+std::size_t ReconstructionEngine_sequentialSfM::computeImageScore(IndexT viewId, const std::vector<IndexT>& trackIds) const
 {
 #ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
   return trackIds.size();
 #else
+  std::size_t viewIndex;
+  if(!_tracks.getViewIndex(viewId, viewIndex))
+    return 0;
+
+  // position of the tracks in the observations of the view (sorted by track id)
+  const auto viewTracksBegin = _tracks.viewTrackIds.begin() + _tracks.viewOffsets[viewIndex];
+  const auto viewTracksEnd = _tracks.viewTrackIds.begin() + _tracks.viewOffsets[viewIndex + 1];
+  std::vector<std::size_t> observations;
+  observations.reserve(trackIds.size());
+  for(IndexT trackId: trackIds)
+  {
+    const auto it = std::lower_bound(viewTracksBegin, viewTracksEnd, trackId);
+    if(it != viewTracksEnd && *it == trackId)
+      observations.push_back(std::distance(_tracks.viewTrackIds.begin(), it));
+  }
+
   std::size_t score = 0;
   // The number of cells of the pyramid grid represent the score
   // and ensure a proper repartition of features in images.
-  const auto& featsPyramid = _map_featsPyramidPerView.at(viewId);
+  std::vector<IndexT> featIndexes; // grid cell indexes in the pyramid
+  featIndexes.reserve(observations.size());
   for(std::size_t level = 0; level < _pyramidDepth; ++level)
   {
-    std::set<std::size_t> featIndexes; // Set of grid cell indexes in the pyramid
-    for(IndexT trackId: trackIds)
-    {
-      std::size_t pyramidIndex = featsPyramid.at(trackId * _pyramidDepth + level);
-      featIndexes.insert(pyramidIndex);
-    }
-    score += featIndexes.size() * _pyramidWeights[level];
+    featIndexes.clear();
+    for(std::size_t observation: observations)
+      featIndexes.push_back(_featsPyramid[observation * _pyramidDepth + level]);
+    std::sort(featIndexes.begin(), featIndexes.end());
+    const std::size_t nbCells = std::distance(featIndexes.begin(), std::unique(featIndexes.begin(), featIndexes.end()));
+    score += nbCells * _pyramidWeights[level];
   }
   return score;
 #endif
@@ -1318,19 +1311,20 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex
 
   // A. Compute 2D/3D matches
   // A1. list tracks ids used by the view
-  const aliceVision::track::TrackIdSet& set_tracksIds = _map_tracksPerView.at(viewIndex);
+  const track::ArrayRange<IndexT> viewTrackIds = _tracks.viewTracks(viewIndex);
+  const track::ArrayRange<IndexT> viewFeatIds = _tracks.viewFeatures(viewIndex);
 
   // A2. intersects the track list with the reconstructed
-  std::set<std::size_t> reconstructed_trackId;
-  std::transform(_sfmData.getLandmarks().begin(), _sfmData.getLandmarks().end(),
-                 std::inserter(reconstructed_trackId, reconstructed_trackId.begin()),
-                 stl::RetrieveKey());
-  
-  // Get the ids of the already reconstructed tracks
-  std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
-                        reconstructed_trackId.begin(),
-                        reconstructed_trackId.end(),
-                        std::inserter(resectionData.tracksId, resectionData.tracksId.begin()));
+  // and get back featId associated to a tracksID already reconstructed.
+  // These 2D/3D associations will be used for the resection.
+  for(std::size_t i = 0; i < viewTrackIds.size(); ++i)
+  {
+    const IndexT trackId = viewTrackIds[i];
+    if(_sfmData.getLandmarks().count(trackId) == 0)
+      continue;
+    resectionData.tracksId.insert(resectionData.tracksId.end(), trackId);
+    resectionData.featuresId.emplace_back(_tracks.descTypes[trackId], viewFeatIds[i]);
+  }
   
   if (resectionData.tracksId.empty())
   {
@@ -1339,13 +1333,6 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex
     return false;
   }
   
-  // Get back featId associated to a tracksID already reconstructed.
-  // These 2D/3D associations will be used for the resection.
-  tracksUtilsMap::getFeatureIdInViewPerTrack(_map_tracks,
-                                             resectionData.tracksId,
-                                             viewIndex,
-                                             &resectionData.featuresId);
-  
   // Localize the image inside the SfM reconstruction
   resectionData.pt2D.resize(2, resectionData.tracksId.size());
   resectionData.pt3D.resize(3, resectionData.tracksId.size());
@@ -1512,43 +1499,46 @@ bool ReconstructionEngine_sequentialSfM::checkAngles(const Vec3 &pt3D, const std
 
 void ReconstructionEngine_sequentialSfM::getTracksToTriangulate(const std::set<IndexT>& previousReconstructedViews, 
                                                                 const std::set<IndexT>& newReconstructedViews, 
+                                                                std::size_t minNbObservations,
                                                                 std::map<IndexT, std::set<IndexT>> & mapTracksToTriangulate) const
 {
   std::set<IndexT> allReconstructedViews;
   allReconstructedViews.insert(previousReconstructedViews.begin(), previousReconstructedViews.end());
   allReconstructedViews.insert(newReconstructedViews.begin(), newReconstructedViews.end());
   
-  std::set<IndexT> allTracksInNewViews;
-  track::tracksUtilsMap::getTracksInImagesFast(newReconstructedViews, _map_tracksPerView, allTracksInNewViews);
-  
-  std::set<IndexT>::iterator it;
-#pragma omp parallel private(it)
+  std::vector<IndexT> allTracksInNewViews;
+  for(IndexT viewId: newReconstructedViews)
   {
-    for (it = allTracksInNewViews.begin(); it != allTracksInNewViews.end(); ++it)
-    {
-#pragma omp single nowait
-      {
-        const std::size_t trackId = *it;
-        
-        const track::Track& track = _map_tracks.at(trackId);
-        
-        std::set<IndexT> allViewsSharingTheTrack;
-        std::transform(track.featPerView.begin(), track.featPerView.end(),
-                       std::inserter(allViewsSharingTheTrack, allViewsSharingTheTrack.begin()),
-                       stl::RetrieveKey());
-        
-        std::set<IndexT> allReconstructedViewsSharingTheTrack;
-        std::set_intersection(allViewsSharingTheTrack.begin(), allViewsSharingTheTrack.end(),
-                              allReconstructedViews.begin(), allReconstructedViews.end(),
-                              std::inserter(allReconstructedViewsSharingTheTrack, allReconstructedViewsSharingTheTrack.begin()));
-        
-        if (allReconstructedViewsSharingTheTrack.size() >= _minNbObservationsForTriangulation)
-        {
-#pragma omp critical        
-          mapTracksToTriangulate[trackId] = allReconstructedViewsSharingTheTrack;
-        }
-      }
-    }
+    const track::ArrayRange<IndexT> viewTrackIds = _tracks.viewTracks(viewId);
+    allTracksInNewViews.insert(allTracksInNewViews.end(), viewTrackIds.begin(), viewTrackIds.end());
+  }
+  std::sort(allTracksInNewViews.begin(), allTracksInNewViews.end());
+  allTracksInNewViews.erase(std::unique(allTracksInNewViews.begin(), allTracksInNewViews.end()), allTracksInNewViews.end());
+
+  // tracks to triangulate found by each thread, merged at the end
+  std::vector<std::vector<std::pair<IndexT, std::set<IndexT>>>> tracksPerThread(omp_get_max_threads());
+
+#pragma omp parallel for schedule(dynamic, 256)
+  for (int i = 0; i < static_cast<int>(allTracksInNewViews.size()); ++i)
+  {
+    const IndexT trackId = allTracksInNewViews[i];
+
+    // the views of the track are sorted
+    const track::ArrayRange<IndexT> allViewsSharingTheTrack = _tracks.trackViewIds(trackId);
+    
+    std::set<IndexT> allReconstructedViewsSharingTheTrack;
+    std::set_intersection(allViewsSharingTheTrack.begin(), allViewsSharingTheTrack.end(),
+                          allReconstructedViews.begin(), allReconstructedViews.end(),
+                          std::inserter(allReconstructedViewsSharingTheTrack, allReconstructedViewsSharingTheTrack.end()));
+    
+    if (allReconstructedViewsSharingTheTrack.size() >= minNbObservations)
+      tracksPerThread[omp_get_thread_num()].emplace_back(trackId, std::move(allReconstructedViewsSharingTheTrack));
+  }
+
+  for(auto& tracks : tracksPerThread)
+  {
+    for(auto& track : tracks)
+      mapTracksToTriangulate[track.first] = std::move(track.second);
   }
 }
 
@@ -1560,20 +1550,25 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
   // This map contains all the tracks that will be triangulated (for the first time, or not)
   // These tracks are seen by at least one new reconstructed view.  
   std::map<IndexT, std::set<IndexT>> mapTracksToTriangulate; // <trackId, observations> 
-  getTracksToTriangulate(previousReconstructedViews, newReconstructedViews, mapTracksToTriangulate);
+  getTracksToTriangulate(previousReconstructedViews, newReconstructedViews, _minNbObservationsForTriangulation, mapTracksToTriangulate);
   
   std::vector<IndexT> setTracksId; // <trackId>
   std::transform(mapTracksToTriangulate.begin(), mapTracksToTriangulate.end(),
                  std::inserter(setTracksId, setTracksId.begin()),
                  stl::RetrieveKey());
-                   
-#pragma omp parallel for 
+
+  // the tracks are triangulated independently, the scene is only updated at the end:
+  // landmarks triangulated and tracks rejected by each thread
+  std::vector<std::vector<std::pair<IndexT, Landmark>>> landmarksPerThread(omp_get_max_threads());
+  std::vector<std::vector<IndexT>> rejectedTracksPerThread(omp_get_max_threads());
+
+#pragma omp parallel for schedule(dynamic, 64)
   for (int i = 0; i < setTracksId.size(); i++) // each track (already reconstructed or not)
   {
     const IndexT trackId = setTracksId.at(i);
     bool isValidTrack = true;
-    const track::Track& track = _map_tracks.at(trackId);
-    std::set<IndexT>& observations = mapTracksToTriangulate.at(trackId); // all the posed views possessing the track
+    const feature::EImageDescriberType descType = _tracks.descTypes[trackId];
+    const std::set<IndexT>& observations = mapTracksToTriangulate.at(trackId); // all the posed views possessing the track
     
     // The track needs to be seen by a min. number of views to be triangulated
     if (observations.size() < _minNbObservationsForTriangulation)
@@ -1599,14 +1594,18 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
       const IntrinsicBase* camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId()).get();
       const Pose3 poseI = scene.getPose(*viewI).getTransform();
       const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
-      const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
-      const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
+      IndexT featI = UndefinedIndexT;
+      IndexT featJ = UndefinedIndexT;
+      _tracks.getFeatureId(trackId, I, featI);
+      _tracks.getFeatureId(trackId, J, featJ);
+      const Vec2 xI = _featuresPerView->getFeatures(I, descType)[featI].coords().cast<double>();
+      const Vec2 xJ = _featuresPerView->getFeatures(J, descType)[featJ].coords().cast<double>();
   
       // -- Triangulate:
       TriangulateDLT(camI->get_projective_equivalent(poseI), 
                      camI->get_ud_pixel(xI), 
                      camJ->get_projective_equivalent(poseJ), 
-                     camI->get_ud_pixel(xJ), 
+                     camJ->get_ud_pixel(xJ), 
                      &X_euclidean);
       
       // -- Check:
@@ -1636,14 +1635,14 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
       Mat2X features(2, observations.size()); // undistorted 2D features (one per pose)
       std::vector<Mat34> Ps; // projective matrices (one per pose)
       {
-        const track::Track& track = _map_tracks.at(trackId);
-        
         int i = 0;
         for (const IndexT& viewId : observations)
         {
           const View* view = scene.getViews().at(viewId).get();
           const IntrinsicBase* cam = scene.getIntrinsics().at(view->getIntrinsicId()).get();
-          const Vec2 x_ud = cam->get_ud_pixel(_featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>()); // undistorted 2D point
+          IndexT featId = UndefinedIndexT;
+          _tracks.getFeatureId(trackId, viewId, featId);
+          const Vec2 x_ud = cam->get_ud_pixel(_featuresPerView->getFeatures(viewId, descType)[featId].coords().cast<double>()); // undistorted 2D point
           features(0,i) = x_ud(0); 
           features(1,i) = x_ud(1);  
           Ps.push_back(cam->get_projective_equivalent(scene.getPose(*view).getTransform()));
@@ -1678,26 +1677,33 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
     {
       Landmark landmark;
       landmark.X = X_euclidean;
-      landmark.descType = track.descType;
+      landmark.descType = descType;
       for (const IndexT & viewId : inliers) // add inliers as observations
       {
-        const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
-        landmark.observations[viewId] = Observation(x, track.featPerView.at(viewId));
+        IndexT featId = UndefinedIndexT;
+        _tracks.getFeatureId(trackId, viewId, featId);
+        const Vec2 x = _featuresPerView->getFeatures(viewId, descType)[featId].coords().cast<double>();
+        landmark.observations[viewId] = Observation(x, featId);
       }
-#pragma omp critical
-      {
-        scene.structure[trackId] = landmark;
-      }      
+      landmarksPerThread[omp_get_thread_num()].emplace_back(trackId, std::move(landmark));
     }
-    else
+    else if (scene.structure.find(trackId) != scene.structure.end())
     {
-#pragma omp critical
-      {
-        if (scene.structure.find(trackId) != scene.structure.end()) 
-          scene.structure.erase(trackId);
-      }
+      rejectedTracksPerThread[omp_get_thread_num()].push_back(trackId);
     }
   } // for all shared tracks 
+
+  // update the scene
+  for (auto& landmarks : landmarksPerThread)
+  {
+    for (auto& landmark : landmarks)
+      scene.structure[landmark.first] = std::move(landmark.second);
+  }
+  for (const auto& rejectedTracks : rejectedTracksPerThread)
+  {
+    for (IndexT trackId : rejectedTracks)
+      scene.structure.erase(trackId);
+  }
 }
 
 void ReconstructionEngine_sequentialSfM::triangulate(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
@@ -1713,93 +1719,88 @@ void ReconstructionEngine_sequentialSfM::triangulate(SfMData& scene, const std::
     
     assert(intersection.empty());
   }
-  
-  std::set<IndexT> allReconstructedViews;
-  allReconstructedViews.insert(previousReconstructedViews.begin(), previousReconstructedViews.end());
-  allReconstructedViews.insert(newReconstructedViews.begin(), newReconstructedViews.end());
-  
-#pragma omp parallel for schedule(dynamic)
-  for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(allReconstructedViews.size()); ++i)
+
+  // tracks seen by a new view and at least another reconstructed view
+  std::map<IndexT, std::set<IndexT>> mapTracksToTriangulate; // <trackId, reconstructed views>
+  getTracksToTriangulate(previousReconstructedViews, newReconstructedViews, 2, mapTracksToTriangulate);
+
+  std::vector<IndexT> setTracksId; // <trackId>
+  std::transform(mapTracksToTriangulate.begin(), mapTracksToTriangulate.end(),
+                 std::inserter(setTracksId, setTracksId.begin()),
+                 stl::RetrieveKey());
+
+  // the tracks are triangulated independently, the scene is only updated at the end:
+  // landmarks created or extended by each thread
+  std::vector<std::vector<std::pair<IndexT, Landmark>>> landmarksPerThread(omp_get_max_threads());
+
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int i = 0; i < setTracksId.size(); ++i)
   {
-    std::set<IndexT>::const_iterator iter = allReconstructedViews.begin();
-    std::advance(iter, i);
-    const IndexT indexAll = *iter;
-    
-    for(IndexT indexNew: newReconstructedViews)
-    {
-      if(indexAll == indexNew)
-        continue;
-      
-      const std::size_t I = std::min((IndexT)indexNew, indexAll);
-      const std::size_t J = std::max((IndexT)indexNew, indexAll);
-      
-      // Find track correspondences between I and J
-      const std::set<std::size_t> set_viewIndex = { I, J };
-      track::TracksMap map_tracksCommonIJ;
-      track::tracksUtilsMap::getCommonTracksInImagesFast(set_viewIndex, _map_tracks, _map_tracksPerView, map_tracksCommonIJ);
+    const IndexT trackId = setTracksId.at(i);
+    const feature::EImageDescriberType descType = _tracks.descTypes[trackId];
+    const std::set<IndexT>& trackViews = mapTracksToTriangulate.at(trackId);
 
-      const View* viewI = scene.getViews().at(I).get();
-      const View* viewJ = scene.getViews().at(J).get();
-      const IntrinsicBase* camI = scene.getIntrinsics().at(viewI->getIntrinsicId()).get();
-      const IntrinsicBase* camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId()).get();
-      const Pose3 poseI = scene.getPose(*viewI).getTransform();
-      const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
-      
-      std::size_t new_putative_track = 0, new_added_track = 0, extented_track = 0;
-      for (const std::pair<std::size_t, track::Track >& trackIt : map_tracksCommonIJ)
+    const auto landmarkIt = scene.structure.find(trackId);
+    bool trackIdExists = (landmarkIt != scene.structure.end());
+    Landmark landmark = trackIdExists ? landmarkIt->second : Landmark();
+    bool landmarkUpdated = false;
+
+    // each pair of a reconstructed view and a new view
+    for(IndexT indexAll : trackViews)
+    {
+      for(IndexT indexNew : trackViews)
       {
-        const std::size_t trackId = trackIt.first;
-        const track::Track & track = trackIt.second;
-
-        const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
-        const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
-        
-        // test if the track already exists in 3D
-        bool trackIdExists;
-#pragma omp critical
-        {
-          trackIdExists = scene.structure.find(trackId) != scene.structure.end();
-        }
+        if(indexAll == indexNew || newReconstructedViews.count(indexNew) == 0)
+          continue;
+
+        const IndexT I = std::min(indexNew, indexAll);
+        const IndexT J = std::max(indexNew, indexAll);
+
+        const View* viewI = scene.getViews().at(I).get();
+        const View* viewJ = scene.getViews().at(J).get();
+        const IntrinsicBase* camI = scene.getIntrinsics().at(viewI->getIntrinsicId()).get();
+        const IntrinsicBase* camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId()).get();
+        const Pose3 poseI = scene.getPose(*viewI).getTransform();
+        const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
+
+        IndexT featI = UndefinedIndexT;
+        IndexT featJ = UndefinedIndexT;
+        _tracks.getFeatureId(trackId, I, featI);
+        _tracks.getFeatureId(trackId, J, featJ);
+        const Vec2 xI = _featuresPerView->getFeatures(I, descType)[featI].coords().cast<double>();
+        const Vec2 xJ = _featuresPerView->getFeatures(J, descType)[featJ].coords().cast<double>();
+
+        // TODO assert(acThresholdIt != _map_ACThreshold.end());
+        const auto& acThresholdItI = _map_ACThreshold.find(I);
+        const auto& acThresholdItJ = _map_ACThreshold.find(J);
+        const double acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
+        const double acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
+
         if (trackIdExists)
         {
           // 3D point triangulated before, only add image observation if needed
-#pragma omp critical
+          if (landmark.observations.count(I) == 0)
           {
-            Landmark& landmark = scene.structure.at(trackId);
-            if (landmark.observations.count(I) == 0)
+            const Vec2 residual = camI->residual(poseI, landmark.X, xI);
+            if (poseI.depth(landmark.X) > 0 && residual.norm() < std::max(4.0, acThresholdI))
             {
-              const Vec2 residual = camI->residual(poseI, landmark.X, xI);
-              const auto& acThresholdIt = _map_ACThreshold.find(I);
-              // TODO assert(acThresholdIt != _map_ACThreshold.end());
-              const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
-              if (poseI.depth(landmark.X) > 0 && residual.norm() < std::max(4.0, acThreshold))
-              {
-                landmark.observations[I] = Observation(xI, track.featPerView.at(I));
-                ++extented_track;
-              }
+              landmark.observations[I] = Observation(xI, featI);
+              landmarkUpdated = true;
             }
-            if (landmark.observations.count(J) == 0)
+          }
+          if (landmark.observations.count(J) == 0)
+          {
+            const Vec2 residual = camJ->residual(poseJ, landmark.X, xJ);
+            if (poseJ.depth(landmark.X) > 0 && residual.norm() < std::max(4.0, acThresholdJ))
             {
-              const Vec2 residual = camJ->residual(poseJ, landmark.X, xJ);
-              const auto& acThresholdIt = _map_ACThreshold.find(J);
-              // TODO assert(acThresholdIt != _map_ACThreshold.end());
-              const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
-              if (poseJ.depth(landmark.X) > 0 && residual.norm() < std::max(4.0, acThreshold))
-              {
-                landmark.observations[J] = Observation(xJ, track.featPerView.at(J));
-                ++extented_track;
-              }
+              landmark.observations[J] = Observation(xJ, featJ);
+              landmarkUpdated = true;
             }
           }
         }
         else
         {
           // A new 3D point must be added
-#pragma omp critical
-          {
-            ++new_putative_track;
-          }
-          
           Vec3 X_euclidean = Vec3::Zero();
           const Vec2 xI_ud = camI->get_ud_pixel(xI);
           const Vec2 xJ_ud = camJ->get_ud_pixel(xJ);
@@ -1816,52 +1817,58 @@ void ReconstructionEngine_sequentialSfM::triangulate(SfMData& scene, const std::
           const Vec2 residualI = camI->residual(poseI, X_euclidean, xI);
           const Vec2 residualJ = camJ->residual(poseJ, X_euclidean, xJ);
           
-          // TODO assert(acThresholdIt != _map_ACThreshold.end());
-          
-          const auto& acThresholdItI = _map_ACThreshold.find(I);
-          const auto& acThresholdItJ = _map_ACThreshold.find(J);
-          
-          const double& acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
-          const double& acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
-          
           if (angle > _minAngleForTriangulation &&
               poseI.depth(X_euclidean) > 0 &&
               poseJ.depth(X_euclidean) > 0 &&
               residualI.norm() < acThresholdI &&
               residualJ.norm() < acThresholdJ)
           {
-#pragma omp critical
-            {
-              // Add a new track
-              Landmark & landmark = scene.structure[trackId];
-              landmark.X = X_euclidean;
-              landmark.descType = track.descType;
-              
-              landmark.observations[I] = Observation(xI, track.featPerView.at(I));
-              landmark.observations[J] = Observation(xJ, track.featPerView.at(J));
-              
-              ++new_added_track;
-            } // critical
+            // Add a new track
+            landmark.X = X_euclidean;
+            landmark.descType = descType;
+            landmark.observations[I] = Observation(xI, featI);
+            landmark.observations[J] = Observation(xJ, featJ);
+
+            trackIdExists = true;
+            landmarkUpdated = true;
           } // 3D point is valid
         } // else (New 3D point)
-      }// for all correspondences
+      }
     }
 
-//  #pragma omp critical
-//  if (!map_tracksCommonIJ.empty())
-//  {
-//    ALICEVISION_LOG_DEBUG("--Triangulated 3D points [" << I << "-" << J << "]:\n"
-//                      "\t#Track extented: " << extented_track << "\n"
-//                      "\t#Validated/#Possible: " << new_added_track << "/" << new_putative_track << "\n"
-//                      "\t#3DPoint for the entire scene: " << scene.getLandmarks().size());
-//  }
+    if (landmarkUpdated)
+      landmarksPerThread[omp_get_thread_num()].emplace_back(trackId, std::move(landmark));
+  }
+
+  // update the scene
+  for (auto& landmarks : landmarksPerThread)
+  {
+    for (auto& landmark : landmarks)
+      scene.structure[landmark.first] = std::move(landmark.second);
   }
 }
 
 /// Bundle adjustment to refine Structure; Motion and Intrinsics
 bool ReconstructionEngine_sequentialSfM::BundleAdjustment(bool fixedIntrinsics)
 {
+  BA_Refine refineOptions = BA_REFINE_ROTATION | BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE;
+  if(!fixedIntrinsics)
+    refineOptions |= BA_REFINE_INTRINSICS_ALL;
+
+  if(_partitionedBundleAdjustmentClusterSize > 0 && _sfmData.getPoses().size() > _partitionedBundleAdjustmentClusterSize)
+  {
+    ALICEVISION_LOG_DEBUG("Global BundleAdjustment partitioned");
+    BundleAdjustmentPartitioned::PartitionedBA_options options;
+    options._maxClusterSize = _partitionedBundleAdjustmentClusterSize;
+    options._bAnalyticJacobians = _useAnalyticJacobians;
+    if(_partitionedBundleAdjustmentClusterSize > 100)
+      options.setSparseBA();
+    BundleAdjustmentPartitioned bundle_adjustment_obj(options);
+    return bundle_adjustment_obj.Adjust(_sfmData, refineOptions);
+  }
+
   BundleAdjustmentCeres::BA_options options;
+  options._bAnalyticJacobians = _useAnalyticJacobians;
   if (_sfmData.getPoses().size() > 100)
   {
     ALICEVISION_LOG_DEBUG("Global BundleAdjustment sparse");
@@ -1873,9 +1880,6 @@ bool ReconstructionEngine_sequentialSfM::BundleAdjustment(bool fixedIntrinsics)
     options.setDenseBA();
   }
   BundleAdjustmentCeres bundle_adjustment_obj(options);
-  BA_Refine refineOptions = BA_REFINE_ROTATION | BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE;
-  if(!fixedIntrinsics)
-    refineOptions |= BA_REFINE_INTRINSICS_ALL;
   return bundle_adjustment_obj.Adjust(_sfmData, refineOptions);
 }
 
@@ -1886,6 +1890,7 @@ bool ReconstructionEngine_sequentialSfM::localBundleAdjustment(const std::set<In
   
   LocalBundleAdjustmentCeres::LocalBA_options options;
   options.enableParametersOrdering();
+  options._bAnalyticJacobians = _useAnalyticJacobians;
   
   if (_sfmData.getPoses().size() > 100) // default value: 100 
   {
@@ -1901,7 +1906,7 @@ bool ReconstructionEngine_sequentialSfM::localBundleAdjustment(const std::set<In
   bool isBaSucceed;
   
   // Add the new reconstructed views to the graph
-  _localBA_data->updateGraphWithNewViews(_sfmData, _map_tracksPerView, newReconstructedViews, kMinNbOfMatches);
+  _localBA_data->updateGraphWithNewViews(_sfmData, _tracks, newReconstructedViews, kMinNbOfMatches);
   
   // -- Prepare Local BA & Adjust
   LocalBundleAdjustmentCeres localBA_ceres;
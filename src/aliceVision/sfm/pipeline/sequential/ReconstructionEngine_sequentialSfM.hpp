@@ -117,6 +117,24 @@ public:
       _localBA_data->setGraphDistanceLimit(distance);
   }
 
+  /**
+   * @brief Use a partitioned bundle adjustment for the scenes with more poses than the cluster size
+   * @param[in] maxClusterSize maximum number of poses of each cluster (0 to disable)
+   */
+  void setPartitionedBundleAdjustmentClusterSize(std::size_t maxClusterSize)
+  {
+    _partitionedBundleAdjustmentClusterSize = maxClusterSize;
+  }
+
+  /**
+   * @brief Use the cost functions with analytic Jacobians in the bundle adjustments
+   *        instead of the automatic differentiation
+   */
+  void setUseAnalyticJacobians(bool useAnalyticJacobians)
+  {
+    _useAnalyticJacobians = useAnalyticJacobians;
+  }
+
   void setUseLocalBundleAdjustmentStrategy(bool v)
   {
     _uselocalBundleAdjustment = v;
@@ -181,6 +199,15 @@ public:
    */
   void updateReconstruction(IndexT resectionId, const std::vector<IndexT>& bestViewIds, std::set<IndexT>& viewIds);
 
+  /**
+   * @brief Triangulate the tracks seen by the newly reconstructed views:
+   *        with the 2-view algorithm if the minimum number of observations for triangulation is 0,
+   *        else with the multi-view Lo-RANSAC algorithm.
+   * @param[in] previousReconstructedViews The old reconstructed views.
+   * @param[in] newReconstructedViews The newly reconstructed views.
+   */
+  void triangulateTracks(const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews);
+
   /**
    * @brief Export and print statistics of a complete reconstruction
    * @param[in] reconstructionTime The duration of the reconstruction
@@ -273,7 +300,7 @@ private:
    * @param[in] trackIds: set of track IDs contained in viewId
    * @return the computed score
    */
-  std::size_t computeImageScore(IndexT viewId, const std::vector<std::size_t>& trackIds) const;
+  std::size_t computeImageScore(IndexT viewId, const std::vector<IndexT>& trackIds) const;
 
   /**
    * @brief Apply the resection on a single view.
@@ -294,14 +321,17 @@ private:
   /**
    * @brief  Triangulate new possible 2D tracks
    * List tracks that share content with this view and add observations and new 3D track if required.
-   * @param previousReconstructedViews
-   * @param newReconstructedViews
+   * The tracks are triangulated in parallel, each one with the pairs of views in the order of a serial triangulation.
+   * @param[in,out] scene All the data about the 3D reconstruction.
+   * @param[in] previousReconstructedViews The list of the old reconstructed views (views index).
+   * @param[in] newReconstructedViews The list of the new reconstructed views (views index).
    */
   void triangulate(sfmData::SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews);
   
   /**
    * @brief Triangulate new possible 2D tracks
    * List tracks that share content with this view and run a multiview triangulation on them, using the Lo-RANSAC algorithm.
+   * The tracks are triangulated in parallel and the scene is updated at the end.
    * @param[in,out] scene All the data about the 3D reconstruction.
    * @param[in] previousReconstructedViews The list of the old reconstructed views (views index).
    * @param[in] newReconstructedViews The list of the new reconstructed views (views index).
@@ -344,14 +374,16 @@ private:
   /**
    * @brief Select the candidate tracks for the next triangulation step. 
    * @details A track is considered as triangulable if it is visible by at least one new reconsutructed 
-   * view and at least \c _minNbObservationsForTriangulation (new and previous) reconstructed view.
+   * view and at least \c minNbObservations (new and previous) reconstructed view.
    * @param[in] previousReconstructedViews The old reconstructed views.
    * @param[in] newReconstructedViews The newly reconstructed views.
+   * @param[in] minNbObservations The minimum number of reconstructed views of a track.
    * @param[out] mapTracksToTriangulate A map with the tracks to triangulate and the observations to do it.
    */
   void getTracksToTriangulate(
       const std::set<IndexT>& previousReconstructedViews,
       const std::set<IndexT>& newReconstructedViews,
+      std::size_t minNbObservations,
       std::map<IndexT, std::set<IndexT> > & mapTracksToTriangulate) const;
 
   /**
@@ -371,6 +403,10 @@ private:
   int _minTrackLength = 2;
   int _minPointsPerPose = 30;
   bool _uselocalBundleAdjustment = false;
+  /// maximum number of poses of each cluster of the partitioned bundle adjustment (0 to disable)
+  std::size_t _partitionedBundleAdjustmentClusterSize = 0;
+  /// use the cost functions with analytic Jacobians in the bundle adjustments
+  bool _useAnalyticJacobians = false;
   /// minimum number of obersvations to triangulate a 3d point.
   std::size_t _minNbObservationsForTriangulation = 2;
   /// a 3D point must have at least 2 obervations not too much aligned.
@@ -397,12 +433,10 @@ private:
 
   // Temporary data
 
-  /// Putative landmark tracks (visibility per potential 3D point)
-  track::TracksMap _map_tracks;
-  /// Putative tracks per view
-  track::TracksPerView _map_tracksPerView;
-  /// Precomputed pyramid index for each trackId of each viewId.
-  track::TracksPyramidPerView _map_featsPyramidPerView;
+  /// Putative landmark tracks (visibility per potential 3D point) and putative tracks per view
+  track::TracksCSR _tracks;
+  /// Precomputed pyramid index for each observation of the views index of _tracks (_pyramidDepth values per observation).
+  std::vector<IndexT> _featsPyramid;
   /// Per camera confidence (A contrario estimated threshold error)
   HashMap<IndexT, double> _map_ACThreshold;
 
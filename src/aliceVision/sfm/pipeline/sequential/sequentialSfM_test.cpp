@@ -9,10 +9,17 @@
 #include <aliceVision/sfm/utils/statistics.hpp>
 #include <aliceVision/sfm/utils/syntheticScene.hpp>
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/system/Timer.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
 
 #define BOOST_TEST_MODULE SEQUENTIAL_SFM
 #include <boost/test/included/unit_test.hpp>
@@ -195,3 +202,317 @@ BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Known_Rig)
   BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getLandmarks().size(), nbPoints);
 }
 
+
+// Triangulation of the tracks of a scene with known poses and noise-free features,
+// with the 2-view and the multi-view triangulation, adding half of the views then the other half:
+// each landmark is the ground-truth point of its track, observed by all the reconstructed views
+BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Triangulation_GroundTruth)
+{
+  const int nviews = 8;
+  const int npoints = 64;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene, keep the poses
+  const SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA);
+  SfMData sfmData2 = sfmData;
+  sfmData2.structure.clear();
+
+  // the feature i of each view is the projection of the point i
+  const auto noNoise = [](std::default_random_engine&) { return 0.0; };
+
+  feature::FeaturesPerView featuresPerView;
+  generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, sfmData, noNoise);
+
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  std::set<IndexT> previousViews;
+  std::set<IndexT> newViews;
+  for(int viewId = 0; viewId < nviews; ++viewId)
+  {
+    if(viewId < nviews / 2)
+      previousViews.insert(viewId);
+    else
+      newViews.insert(viewId);
+  }
+
+  // check the landmarks against the ground truth, for the given reconstructed views
+  const auto checkLandmarks = [&](const SfMData& scene, const std::set<IndexT>& reconstructedViews)
+  {
+    BOOST_CHECK_EQUAL(scene.getLandmarks().size(), npoints);
+
+    std::set<IndexT> points;
+    for(const auto& landmarkIt : scene.getLandmarks())
+    {
+      const Landmark& landmark = landmarkIt.second;
+      BOOST_REQUIRE(!landmark.observations.empty());
+
+      // the feature ids of the observations are the index of the point
+      const IndexT pointId = landmark.observations.begin()->second.id_feat;
+      points.insert(pointId);
+
+      std::set<IndexT> observedViews;
+      for(const auto& observationIt : landmark.observations)
+      {
+        BOOST_CHECK_EQUAL(observationIt.second.id_feat, pointId);
+        observedViews.insert(observationIt.first);
+      }
+      BOOST_CHECK(observedViews == reconstructedViews);
+
+      BOOST_CHECK_SMALL((landmark.X - d._X.col(pointId)).norm(), 1e-4);
+    }
+    BOOST_CHECK_EQUAL(points.size(), npoints);
+  };
+
+  std::set<IndexT> allViews = previousViews;
+  allViews.insert(newViews.begin(), newViews.end());
+
+  for(const std::size_t minNbObservations : {0, 2})
+  {
+    ReconstructionEngine_sequentialSfM sfmEngine(
+      sfmData2,
+      "./",
+      "./Reconstruction_Report.html");
+
+    sfmEngine.setFeatures(&featuresPerView);
+    sfmEngine.setMatches(&pairwiseMatches);
+    sfmEngine.setNbOfObservationsForTriangulation(minNbObservations);
+
+    sfmEngine.initializePyramidScoring();
+    BOOST_CHECK_EQUAL(sfmEngine.fuseMatchesIntoTracks(), npoints);
+
+    sfmEngine.triangulateTracks(std::set<IndexT>(), previousViews);
+    checkLandmarks(sfmEngine.getSfMData(), previousViews);
+
+    sfmEngine.triangulateTracks(previousViews, newViews);
+    checkLandmarks(sfmEngine.getSfMData(), allViews);
+  }
+}
+
+/**
+ * @brief Scores of the next best views on a small scene of 320x320 views, with hand-computed values.
+ *
+ * The pyramid cells are 160, 80, 40, 20 and 10 pixels wide, with the weights 16, 8, 4, 2 and 1,
+ * so a reconstructed track adds 31 to the score when it is alone in its cell at each level.
+ * - view 1 has no track: it is not connected;
+ * - view 2 sees 4 reconstructed tracks in the same 10x10 cell: score 31;
+ * - view 3 sees 4 reconstructed tracks in the 4 corners: score 4 * 31 = 124,
+ *   and 1 track at the center that is not reconstructed (not counted).
+ */
+BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_NextBestViews_Scores)
+{
+  const std::size_t size = 320;
+
+  SfMData sfmData;
+  sfmData.intrinsics[0] = std::make_shared<Pinhole>(size, size, 300.0, size / 2.0, size / 2.0);
+  for(IndexT viewId = 0; viewId < 4; ++viewId)
+    sfmData.views[viewId] = std::make_shared<View>("", viewId, 0, viewId, size, size);
+
+  const feature::EImageDescriberType descType = feature::EImageDescriberType::UNKNOWN;
+  feature::FeaturesPerView featuresPerView;
+  featuresPerView.addFeatures(0, descType, feature::PointFeatures(9, feature::PointFeature(100.0f, 100.0f)));
+  featuresPerView.addFeatures(1, descType, feature::PointFeatures(1, feature::PointFeature(100.0f, 100.0f)));
+  featuresPerView.addFeatures(2, descType, {{5.0f, 5.0f}, {6.0f, 6.0f}, {7.0f, 7.0f}, {8.0f, 8.0f}});
+  featuresPerView.addFeatures(3, descType, {{5.0f, 5.0f}, {315.0f, 5.0f}, {5.0f, 315.0f}, {315.0f, 315.0f}, {160.0f, 160.0f}});
+
+  matching::PairwiseMatches pairwiseMatches;
+  pairwiseMatches[Pair(0, 2)][descType] = {{0, 0}, {1, 1}, {2, 2}, {3, 3}};
+  pairwiseMatches[Pair(0, 3)][descType] = {{4, 0}, {5, 1}, {6, 2}, {7, 3}, {8, 4}};
+
+  ReconstructionEngine_sequentialSfM sfmEngine(sfmData, "./", "./Reconstruction_Report.html");
+  sfmEngine.setFeatures(&featuresPerView);
+  sfmEngine.setMatches(&pairwiseMatches);
+  sfmEngine.initializePyramidScoring();
+  BOOST_CHECK_EQUAL(sfmEngine.fuseMatchesIntoTracks(), 9);
+
+  // same track ids as the engine: all the tracks are reconstructed, except the one of the center of view 3
+  track::TracksBuilder tracksBuilder;
+  tracksBuilder.build(pairwiseMatches);
+  tracksBuilder.filter(2);
+  track::TracksCSR tracks;
+  tracksBuilder.exportToCSR(tracks);
+  for(std::size_t trackId = 0; trackId < tracks.nbTracks(); ++trackId)
+  {
+    IndexT featId;
+    if(!tracks.getFeatureId(trackId, 3, featId) || featId != 4)
+      sfmEngine.getSfMData().structure[trackId] = Landmark(Vec3::Zero(), descType);
+  }
+  BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getLandmarks().size(), 8);
+
+  std::vector<ViewConnectionScore> connectedViews;
+  BOOST_CHECK(sfmEngine.findConnectedViews(connectedViews, {1, 2, 3}));
+
+  std::map<IndexT, std::pair<std::size_t, std::size_t>> scores;
+  for(const ViewConnectionScore& connectedView : connectedViews)
+    scores[std::get<0>(connectedView)] = std::make_pair(std::get<1>(connectedView), std::get<2>(connectedView));
+
+  const std::map<IndexT, std::pair<std::size_t, std::size_t>> expectedScores{{2, {4, 31}}, {3, {4, 124}}};
+  BOOST_CHECK(scores == expectedScores);
+}
+
+/**
+ * @brief Next best view scores computed with the map-based tracks store used before the CSR one
+ *        (tracks per view, set of the reconstructed tracks and map of the pyramid cells per view).
+ *        It is the baseline of the next best view benchmark.
+ */
+class MapBasedViewScoring
+{
+public:
+  MapBasedViewScoring(const SfMData& sfmData, const feature::FeaturesPerView& featuresPerView,
+                      const matching::PairwiseMatches& pairwiseMatches)
+  {
+    track::TracksBuilder tracksBuilder;
+    tracksBuilder.build(pairwiseMatches);
+    tracksBuilder.filter(2);
+    tracksBuilder.exportToSTL(_tracks);
+    track::tracksUtilsMap::computeTracksPerView(_tracks, _tracksPerView);
+
+    for(std::size_t level = 0; level < _pyramidDepth; ++level)
+    {
+      _widthPerLevel.push_back(std::pow(_pyramidBase, level + 1));
+      _startPerLevel.push_back(level == 0 ? 0 : _startPerLevel.back() + Square(_widthPerLevel[level - 1]));
+      _weightPerLevel.push_back(std::pow(2.0, _pyramidDepth - (level + 1)));
+    }
+
+    for(const auto& viewTracks : _tracksPerView)
+    {
+      const IndexT viewId = viewTracks.first;
+      const View& view = *sfmData.getViews().at(viewId);
+      auto& tracksPyramid = _tracksPyramidPerView[viewId];
+      for(std::size_t trackId : viewTracks.second)
+      {
+        const track::Track& track = _tracks.at(trackId);
+        const auto& feature = featuresPerView.getFeatures(viewId, track.descType)[track.featPerView.at(viewId)];
+        for(std::size_t level = 0; level < _pyramidDepth; ++level)
+        {
+          const double cellWidth = (double)view.getWidth() / (double)_widthPerLevel[level];
+          const double cellHeight = (double)view.getHeight() / (double)_widthPerLevel[level];
+          const std::size_t xCell = std::min<std::size_t>(std::floor(std::max(feature.x(), 0.0f) / cellWidth), _widthPerLevel[level] - 1);
+          const std::size_t yCell = std::min<std::size_t>(std::floor(std::max(feature.y(), 0.0f) / cellHeight), _widthPerLevel[level] - 1);
+          tracksPyramid[trackId * _pyramidDepth + level] = _startPerLevel[level] + xCell + yCell * _widthPerLevel[level];
+        }
+      }
+    }
+  }
+
+  /// Number of reconstructed tracks and score of the remaining views
+  std::map<IndexT, std::pair<std::size_t, std::size_t>> score(const SfMData& sfmData, const std::set<IndexT>& remainingViewIds) const
+  {
+    std::set<std::size_t> reconstructedTrackIds;
+    for(const auto& landmarkIt : sfmData.getLandmarks())
+      reconstructedTrackIds.insert(landmarkIt.first);
+
+    std::map<IndexT, std::pair<std::size_t, std::size_t>> scores;
+    for(IndexT viewId : remainingViewIds)
+    {
+      const auto tracksIt = _tracksPerView.find(viewId);
+      if(tracksIt == _tracksPerView.end() || tracksIt->second.empty())
+        continue;
+
+      std::vector<std::size_t> trackIds;
+      std::set_intersection(tracksIt->second.begin(), tracksIt->second.end(),
+                            reconstructedTrackIds.begin(), reconstructedTrackIds.end(),
+                            std::back_inserter(trackIds));
+
+      const auto& tracksPyramid = _tracksPyramidPerView.at(viewId);
+      std::size_t score = 0;
+      for(std::size_t level = 0; level < _pyramidDepth; ++level)
+      {
+        std::set<std::size_t> cells;
+        for(std::size_t trackId : trackIds)
+          cells.insert(tracksPyramid.at(trackId * _pyramidDepth + level));
+        score += cells.size() * _weightPerLevel[level];
+      }
+      scores[viewId] = std::make_pair(trackIds.size(), score);
+    }
+    return scores;
+  }
+
+private:
+  // same pyramid as the sequential engine
+  const std::size_t _pyramidBase = 2;
+  const std::size_t _pyramidDepth = 5;
+  std::vector<std::size_t> _widthPerLevel;
+  std::vector<std::size_t> _startPerLevel;
+  std::vector<std::size_t> _weightPerLevel;
+
+  track::TracksMap _tracks;
+  track::TracksPerView _tracksPerView;
+  track::TracksPyramidPerView _tracksPyramidPerView;
+};
+
+// Benchmark the next best view selection of a larger scene, against the map-based tracks store
+BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_NextBestViews_Benchmark)
+{
+  const int nviews = 24;
+  const int npoints = 8192;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene, keep the poses
+  const SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA);
+  SfMData sfmData2 = sfmData;
+  sfmData2.structure.clear();
+
+  std::normal_distribution<double> distribution(0.0,0.5);
+
+  feature::FeaturesPerView featuresPerView;
+  generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, sfmData, distribution);
+
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  // the first half of the views is reconstructed
+  std::set<IndexT> reconstructedViews;
+  std::set<IndexT> remainingViews;
+  for(int viewId = 0; viewId < nviews; ++viewId)
+  {
+    if(viewId < nviews / 2)
+      reconstructedViews.insert(viewId);
+    else
+      remainingViews.insert(viewId);
+  }
+
+  ReconstructionEngine_sequentialSfM sfmEngine(
+    sfmData2,
+    "./",
+    "./Reconstruction_Report.html");
+
+  sfmEngine.setFeatures(&featuresPerView);
+  sfmEngine.setMatches(&pairwiseMatches);
+  sfmEngine.initializePyramidScoring();
+  BOOST_CHECK_EQUAL(sfmEngine.fuseMatchesIntoTracks(), npoints);
+  sfmEngine.triangulateTracks(std::set<IndexT>(), reconstructedViews);
+  BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getLandmarks().size(), npoints);
+
+  const MapBasedViewScoring mapBasedScoring(sfmData2, featuresPerView, pairwiseMatches);
+
+  const int nbRepeats = 10;
+
+  system::Timer timer;
+  std::map<IndexT, std::pair<std::size_t, std::size_t>> mapScores;
+  for(int i = 0; i < nbRepeats; ++i)
+    mapScores = mapBasedScoring.score(sfmEngine.getSfMData(), remainingViews);
+  const double mapTime = timer.elapsedMs() / nbRepeats;
+
+  timer.reset();
+  std::vector<ViewConnectionScore> connectedViews;
+  for(int i = 0; i < nbRepeats; ++i)
+    sfmEngine.findConnectedViews(connectedViews, remainingViews);
+  const double csrTime = timer.elapsedMs() / nbRepeats;
+
+  ALICEVISION_LOG_INFO("Next best views among " << remainingViews.size() << " views with " << npoints << " reconstructed tracks:" << std::endl
+    << "\t- tracks map and tracks per view: " << system::prettyTime(mapTime) << std::endl
+    << "\t- CSR with views index: " << system::prettyTime(csrTime));
+
+  // same scores as the map-based store
+  BOOST_CHECK_EQUAL(connectedViews.size(), mapScores.size());
+  for(const ViewConnectionScore& connectedView : connectedViews)
+  {
+    const auto scoreIt = mapScores.find(std::get<0>(connectedView));
+    BOOST_REQUIRE(scoreIt != mapScores.end());
+    BOOST_CHECK_EQUAL(std::get<1>(connectedView), scoreIt->second.first);
+    BOOST_CHECK_EQUAL(std::get<2>(connectedView), scoreIt->second.second);
+  }
+}
@@ -247,11 +247,11 @@ void StructureEstimationFromKnownPoses::triangulate(
   SfMData& sfmData,
   const feature::RegionsPerView& regionsPerView)
 {
-  track::TracksMap map_tracksCommon;
+  track::TracksCSR tracksCommon;
   track::TracksBuilder tracksBuilder;
   tracksBuilder.build(_tripletMatches);
   tracksBuilder.filter(3);
-  tracksBuilder.exportToSTL(map_tracksCommon);
+  tracksBuilder.exportToCSR(tracksCommon);
   matching::PairwiseMatches().swap(_tripletMatches);
 
   // Generate new Structure tracks
@@ -259,19 +259,18 @@ void StructureEstimationFromKnownPoses::triangulate(
 
   // Fill sfm_data with the computed tracks (no 3D yet)
   Landmarks & structure = sfmData.structure;
-  IndexT idx(0);
-  for (track::TracksMap::const_iterator itTracks = map_tracksCommon.begin();
-    itTracks != map_tracksCommon.end();
-    ++itTracks, ++idx)
+  for (IndexT idx = 0; idx < tracksCommon.nbTracks(); ++idx)
   {
-    const track::Track & track = itTracks->second;
-    structure[idx] = Landmark(track.descType);
+    const feature::EImageDescriberType descType = tracksCommon.descTypes[idx];
+    const track::ArrayRange<IndexT> trackViewIds = tracksCommon.trackViewIds(idx);
+    const track::ArrayRange<IndexT> trackFeatIds = tracksCommon.trackFeatIds(idx);
+    structure[idx] = Landmark(descType);
     Observations & observations = structure.at(idx).observations;
-    for (auto it = track.featPerView.begin(); it != track.featPerView.end(); ++it)
+    for (std::size_t i = 0; i < trackViewIds.size(); ++i)
     {
-      const size_t imaIndex = it->first;
-      const size_t featIndex = it->second;
-      const Vec2 pt = regionsPerView.getRegions(imaIndex, track.descType).GetRegionPosition(featIndex);
+      const size_t imaIndex = trackViewIds[i];
+      const size_t featIndex = trackFeatIds[i];
+      const Vec2 pt = regionsPerView.getRegions(imaIndex, descType).GetRegionPosition(featIndex);
       observations[imaIndex] = Observation(pt, featIndex);
     }
   }
@@ -0,0 +1,150 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE residualErrorCostFunction
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+// Test summary:
+// - Evaluate the cost functions with analytic Jacobians and the automatic differentiation
+//   of the corresponding functors on random cameras and points
+// - Check that the residuals and the Jacobians of all the parameter blocks are the same
+// - Perform the test for all the camera models, with and without rig, including rotations close to the identity
+
+namespace {
+
+/// Compare the residuals and Jacobians of two cost functions with the same parameter blocks
+void checkCostFunctions(const ceres::CostFunction& analytic,
+                        const ceres::CostFunction& autodiff,
+                        std::vector<std::vector<double>>& blocks)
+{
+  std::vector<const double*> parameters;
+  std::vector<std::vector<double>> analyticJacobians;
+  std::vector<std::vector<double>> autodiffJacobians;
+  for(const std::vector<double>& block : blocks)
+  {
+    parameters.push_back(block.data());
+    analyticJacobians.emplace_back(2 * block.size());
+    autodiffJacobians.emplace_back(2 * block.size());
+  }
+  std::vector<double*> analyticJacobiansPtr;
+  std::vector<double*> autodiffJacobiansPtr;
+  for(std::size_t i = 0; i < blocks.size(); ++i)
+  {
+    analyticJacobiansPtr.push_back(analyticJacobians[i].data());
+    autodiffJacobiansPtr.push_back(autodiffJacobians[i].data());
+  }
+
+  double analyticResiduals[2];
+  double autodiffResiduals[2];
+  BOOST_CHECK(analytic.Evaluate(parameters.data(), analyticResiduals, analyticJacobiansPtr.data()));
+  BOOST_CHECK(autodiff.Evaluate(parameters.data(), autodiffResiduals, autodiffJacobiansPtr.data()));
+
+  for(int r = 0; r < 2; ++r)
+    BOOST_CHECK_SMALL(analyticResiduals[r] - autodiffResiduals[r], 1e-8);
+
+  for(std::size_t i = 0; i < blocks.size(); ++i)
+  {
+    for(std::size_t j = 0; j < analyticJacobians[i].size(); ++j)
+    {
+      const double scale = std::max(1.0, std::abs(autodiffJacobians[i][j]));
+      BOOST_CHECK_SMALL((analyticJacobians[i][j] - autodiffJacobians[i][j]) / scale, 1e-8);
+    }
+  }
+
+  // residuals only
+  double residuals[2];
+  BOOST_CHECK(analytic.Evaluate(parameters.data(), residuals, nullptr));
+  BOOST_CHECK_SMALL(residuals[0] - analyticResiduals[0], 1e-12);
+  BOOST_CHECK_SMALL(residuals[1] - analyticResiduals[1], 1e-12);
+}
+
+template <typename Functor, typename DistortionModel, int NbIntrinsicParams>
+void checkCameraModel(const std::vector<double>& distortion, double maxDisto, double minDisto = 0.0)
+{
+  std::mt19937 randomNumberGenerator(42);
+  std::uniform_real_distribution<double> unit(-1.0, 1.0);
+
+  for(int i = 0; i < 50; ++i)
+  {
+    // rotations close to the identity every 5 iterations
+    const double rotationScale = (i % 5 == 0) ? 1e-10 : 0.5;
+
+    std::vector<double> intrinsics = {1000.0 + 100.0 * unit(randomNumberGenerator),
+                                      500.0 + 10.0 * unit(randomNumberGenerator),
+                                      400.0 + 10.0 * unit(randomNumberGenerator)};
+    for(double d : distortion)
+      intrinsics.push_back(d + minDisto + maxDisto * unit(randomNumberGenerator));
+
+    std::vector<double> pose(6);
+    std::vector<double> subpose(6);
+    for(int j = 0; j < 3; ++j)
+    {
+      pose[j] = rotationScale * unit(randomNumberGenerator);
+      pose[3 + j] = 0.3 * unit(randomNumberGenerator);
+      subpose[j] = 0.2 * unit(randomNumberGenerator);
+      subpose[3 + j] = 0.1 * unit(randomNumberGenerator);
+    }
+    const std::vector<double> point = {unit(randomNumberGenerator), unit(randomNumberGenerator), 5.0 + unit(randomNumberGenerator)};
+    const double observation[2] = {500.0 + 300.0 * unit(randomNumberGenerator), 400.0 + 300.0 * unit(randomNumberGenerator)};
+
+    {
+      ResidualErrorCostFunction<DistortionModel> analytic(observation);
+      ceres::AutoDiffCostFunction<Functor, 2, NbIntrinsicParams, 6, 3> autodiff(new Functor(observation));
+      std::vector<std::vector<double>> blocks = {intrinsics, pose, point};
+      checkCostFunctions(analytic, autodiff, blocks);
+    }
+    {
+      ResidualErrorRigCostFunction<DistortionModel> analytic(observation);
+      ceres::AutoDiffCostFunction<Functor, 2, NbIntrinsicParams, 6, 6, 3> autodiff(new Functor(observation));
+      std::vector<std::vector<double>> blocks = {intrinsics, pose, subpose, point};
+      checkCostFunctions(analytic, autodiff, blocks);
+    }
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ResidualErrorCostFunction_Pinhole)
+{
+  checkCameraModel<ResidualErrorFunctor_Pinhole, distortion::Pinhole, 3>({}, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(ResidualErrorCostFunction_PinholeRadialK1)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeRadialK1, distortion::PinholeRadialK1, 4>({0.0}, 0.2);
+}
+
+BOOST_AUTO_TEST_CASE(ResidualErrorCostFunction_PinholeRadialK3)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeRadialK3, distortion::PinholeRadialK3, 6>({0.0, 0.0, 0.0}, 0.1);
+}
+
+BOOST_AUTO_TEST_CASE(ResidualErrorCostFunction_PinholeBrownT2)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeBrownT2, distortion::PinholeBrownT2, 8>({0.0, 0.0, 0.0, 0.0, 0.0}, 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(ResidualErrorCostFunction_PinholeFisheye)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeFisheye, distortion::PinholeFisheye, 7>({0.0, 0.0, 0.0, 0.0}, 0.05);
+}
+
+BOOST_AUTO_TEST_CASE(ResidualErrorCostFunction_PinholeFisheye1)
+{
+  // k1 in [0.5, 1.5]
+  checkCameraModel<ResidualErrorFunctor_PinholeFisheye1, distortion::PinholeFisheye1, 4>({0.0}, 0.5, 1.0);
+}
@@ -6,12 +6,15 @@
 
 #include "jsonIO.hpp"
 #include <aliceVision/camera/camera.hpp>
+#include <aliceVision/sfmDataIO/jsonStream.hpp>
 #include <aliceVision/sfmDataIO/viewIO.hpp>
+#include <aliceVision/system/Logger.hpp>
 
-#include <boost/property_tree/json_parser.hpp>
-
+#include <fstream>
 #include <memory>
 #include <cassert>
+#include <stdexcept>
+#include <vector>
 
 namespace aliceVision {
 namespace sfmDataIO {
@@ -253,6 +256,192 @@ void loadLandmark(IndexT& landmarkId, sfmData::Landmark& landmark, bpt::ptree& l
 }
 
 
+namespace {
+
+/**
+ * @brief Write the landmarks in a JSON stream, as saveLandmark.
+ * @param[in] name The array name
+ * @param[in] landmarks The landmarks
+ * @param[in,out] writer The JSON stream writer
+ */
+void writeLandmarks(const std::string& name, const sfmData::Landmarks& landmarks, JsonStreamWriter& writer)
+{
+  writer.beginArray(name);
+
+  for(const auto& landmarkPair : landmarks)
+  {
+    const sfmData::Landmark& landmark = landmarkPair.second;
+
+    writer.beginObject();
+    writer.value("landmarkId", landmarkPair.first);
+    writer.value("descType", feature::EImageDescriberType_enumToString(landmark.descType));
+    writer.matrix("color", landmark.rgb);
+    writer.matrix("X", landmark.X);
+
+    // observations
+    writer.beginArray("observations");
+    for(const auto& obsPair : landmark.observations)
+    {
+      const sfmData::Observation& observation = obsPair.second;
+
+      writer.beginObject();
+      writer.value("observationId", obsPair.first);
+      writer.value("featureId", observation.id_feat);
+      writer.matrix("x", observation.x);
+      writer.endLevel();
+    }
+    writer.endLevel();
+
+    writer.endLevel();
+  }
+
+  writer.endLevel();
+}
+
+/**
+ * @brief Read a landmark from a JSON stream, as loadLandmark.
+ * @param[out] landmarkId The output landmark Id
+ * @param[out] landmark The output landmark
+ * @param[in,out] reader The JSON stream reader
+ */
+void readLandmark(IndexT& landmarkId, sfmData::Landmark& landmark, JsonStreamReader& reader)
+{
+  std::string key;
+  std::string value;
+
+  landmarkId = UndefinedIndexT;
+
+  if(!reader.beginLevel(false))
+    reader.throwError("empty landmark");
+
+  while(reader.nextKey(key))
+  {
+    if(key == "landmarkId")
+    {
+      landmarkId = static_cast<IndexT>(reader.readUnsigned());
+    }
+    else if(key == "descType")
+    {
+      reader.readString(value);
+      landmark.descType = feature::EImageDescriberType_stringToEnum(value);
+    }
+    else if(key == "color")
+    {
+      reader.readMatrix(landmark.rgb);
+    }
+    else if(key == "X")
+    {
+      reader.readMatrix(landmark.X);
+    }
+    else if(key == "observations")
+    {
+      if(!reader.beginLevel(true))
+        continue;
+
+      while(reader.nextElement())
+      {
+        IndexT observationId = UndefinedIndexT;
+        sfmData::Observation observation;
+
+        if(reader.beginLevel(false))
+        {
+          while(reader.nextKey(key))
+          {
+            if(key == "observationId")
+              observationId = static_cast<IndexT>(reader.readUnsigned());
+            else if(key == "featureId")
+              observation.id_feat = static_cast<IndexT>(reader.readUnsigned());
+            else if(key == "x")
+              reader.readMatrix(observation.x);
+            else
+              reader.skipValue();
+          }
+        }
+
+        if(observationId == UndefinedIndexT)
+          reader.throwError("observation without observationId");
+
+        landmark.observations.emplace(observationId, observation);
+      }
+    }
+    else
+    {
+      reader.skipValue();
+    }
+  }
+
+  if(landmarkId == UndefinedIndexT)
+    reader.throwError("landmark without landmarkId");
+}
+
+/**
+ * @brief Read an array of landmarks from a JSON stream.
+ *        The landmarks are delimited first, then parsed in parallel.
+ * @param[in] bufferBegin The beginning of the reader buffer
+ * @param[out] landmarks The output landmarks
+ * @param[in,out] reader The JSON stream reader
+ */
+void readLandmarks(const char* bufferBegin, sfmData::Landmarks& landmarks, JsonStreamReader& reader)
+{
+  std::vector<std::pair<const char*, const char*>> landmarkRanges;
+
+  if(reader.beginLevel(true))
+  {
+    while(reader.nextElement())
+    {
+      const char* landmarkBegin = reader.position();
+      reader.skipValue();
+      landmarkRanges.emplace_back(landmarkBegin, reader.position());
+    }
+  }
+
+  std::vector<std::pair<IndexT, sfmData::Landmark>> landmarksVec(landmarkRanges.size());
+  std::string errorMessage;
+
+  #pragma omp parallel for schedule(dynamic, 256)
+  for(int i = 0; i < landmarkRanges.size(); ++i)
+  {
+    const auto& range = landmarkRanges.at(i);
+    JsonStreamReader landmarkReader(range.first, range.second, range.first - bufferBegin);
+
+    try
+    {
+      readLandmark(landmarksVec.at(i).first, landmarksVec.at(i).second, landmarkReader);
+      landmarkReader.checkEnd();
+    }
+    catch(const std::exception& e)
+    {
+      #pragma omp critical
+      errorMessage = e.what();
+    }
+  }
+
+  if(!errorMessage.empty())
+    throw std::runtime_error(errorMessage);
+
+  for(auto& landmarkPair : landmarksVec)
+    landmarks.emplace(landmarkPair.first, std::move(landmarkPair.second));
+}
+
+/**
+ * @brief Read the string values of an array from a JSON stream.
+ * @param[out] values The output values
+ * @param[in,out] reader The JSON stream reader
+ */
+void readStrings(std::vector<std::string>& values, JsonStreamReader& reader)
+{
+  if(!reader.beginLevel(true))
+    return;
+
+  while(reader.nextElement())
+  {
+    values.emplace_back();
+    reader.readString(values.back());
+  }
+}
+
+} // namespace
+
 bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
 {
   const Vec3 version = {1, 0, 0};
@@ -264,61 +453,69 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
   const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
   const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
 
-  // main tree
-  bpt::ptree fileTree;
+  std::ofstream stream(filename);
+
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Cannot open the JSON SfMData file: " << filename);
+    return false;
+  }
+
+  // the file is written element by element, with the same layout as bpt::write_json
+  JsonStreamWriter writer(stream);
 
   // file version
-  saveMatrix("version", version, fileTree);
+  writer.matrix("version", version);
 
   // folders
   if(!sfmData.getRelativeFeaturesFolders().empty())
   {
-    bpt::ptree featureFoldersTree;
+    writer.beginArray("featuresFolders");
 
     for(const std::string& featuresFolder : sfmData.getRelativeFeaturesFolders())
-    {
-      bpt::ptree featureFolderTree;
-      featureFolderTree.put("", featuresFolder);
-      featureFoldersTree.push_back(std::make_pair("", featureFolderTree));
-    }
+      writer.value("", featuresFolder);
 
-    fileTree.add_child("featuresFolders", featureFoldersTree);
+    writer.endLevel();
   }
 
   if(!sfmData.getRelativeMatchesFolders().empty())
   {
-    bpt::ptree matchingFoldersTree;
+    writer.beginArray("matchesFolders");
 
     for(const std::string& matchesFolder : sfmData.getRelativeMatchesFolders())
-    {
-      bpt::ptree matchingFolderTree;
-      matchingFolderTree.put("", matchesFolder);
-      matchingFoldersTree.push_back(std::make_pair("", matchingFolderTree));
-    }
+      writer.value("", matchesFolder);
 
-    fileTree.add_child("matchesFolders", matchingFoldersTree);
+    writer.endLevel();
   }
 
   // views
   if(saveViews && !sfmData.getViews().empty())
   {
-    bpt::ptree viewsTree;
+    writer.beginArray("views");
 
     for(const auto& viewPair : sfmData.getViews())
-      saveView("", *(viewPair.second), viewsTree);
+    {
+      bpt::ptree viewTree;
+      saveView("", *(viewPair.second), viewTree);
+      writer.tree("", viewTree.front().second);
+    }
 
-    fileTree.add_child("views", viewsTree);
+    writer.endLevel();
   }
 
   // intrinsics
   if(saveIntrinsics && !sfmData.getIntrinsics().empty())
   {
-    bpt::ptree intrinsicsTree;
+    writer.beginArray("intrinsics");
 
     for(const auto& intrinsicPair : sfmData.getIntrinsics())
-      saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
+    {
+      bpt::ptree intrinsicTree;
+      saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicTree);
+      writer.tree("", intrinsicTree.front().second);
+    }
 
-    fileTree.add_child("intrinsics", intrinsicsTree);
+    writer.endLevel();
   }
 
   //extrinsics
@@ -327,7 +524,7 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
     // poses
     if(!sfmData.getPoses().empty())
     {
-      bpt::ptree posesTree;
+      writer.beginArray("poses");
 
       for(const auto& posePair : sfmData.getPoses())
       {
@@ -335,50 +532,44 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
 
         poseTree.put("poseId", posePair.first);
         saveCameraPose("pose", posePair.second, poseTree);
-        posesTree.push_back(std::make_pair("", poseTree));
+        writer.tree("", poseTree);
       }
 
-      fileTree.add_child("poses", posesTree);
+      writer.endLevel();
     }
 
     // rigs
     if(!sfmData.getRigs().empty())
     {
-      bpt::ptree rigsTree;
+      writer.beginArray("rigs");
 
       for(const auto& rigPair : sfmData.getRigs())
-        saveRig("", rigPair.first, rigPair.second, rigsTree);
+      {
+        bpt::ptree rigTree;
+        saveRig("", rigPair.first, rigPair.second, rigTree);
+        writer.tree("", rigTree.front().second);
+      }
 
-      fileTree.add_child("rigs", rigsTree);
+      writer.endLevel();
     }
   }
 
   // structure
   if(saveStructure && !sfmData.getLandmarks().empty())
-  {
-    bpt::ptree structureTree;
-
-    for(const auto& structurePair : sfmData.getLandmarks())
-      saveLandmark("", structurePair.first, structurePair.second, structureTree);
-
-    fileTree.add_child("structure", structureTree);
-  }
+    writeLandmarks("structure", sfmData.getLandmarks(), writer);
 
   // control points
   if(saveControlPoints && !sfmData.getControlPoints().empty())
-  {
-    bpt::ptree controlPointTree;
+    writeLandmarks("controlPoints", sfmData.getControlPoints(), writer);
 
-    for(const auto& controlPointPair : sfmData.getControlPoints())
-      saveLandmark("", controlPointPair.first, controlPointPair.second, controlPointTree);
+  writer.end();
 
-    fileTree.add_child("controlPoints", controlPointTree);
+  if(!stream.good())
+  {
+    ALICEVISION_LOG_ERROR("Cannot write the JSON SfMData file: " << filename);
+    return false;
   }
 
-  // write the json file with the tree
-
-  bpt::write_json(filename, fileTree);
-
   return true;
 }
 
@@ -393,62 +584,162 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
   const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
   const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
 
-  // main tree
-  bpt::ptree fileTree;
+  // read the json file in memory
+  std::string buffer;
+  {
+    std::ifstream stream(filename, std::ios::in | std::ios::binary);
 
-  // read the json file and initialize the tree
-  bpt::read_json(filename, fileTree);
+    if(!stream.is_open())
+    {
+      ALICEVISION_LOG_ERROR("Cannot open the JSON SfMData file: " << filename);
+      return false;
+    }
 
-  // version
-  loadMatrix("version", version, fileTree);
+    stream.seekg(0, std::ios::end);
+    buffer.resize(static_cast<std::size_t>(stream.tellg()));
+    stream.seekg(0, std::ios::beg);
+    stream.read(&buffer[0], buffer.size());
 
-  // folders
-  if(fileTree.count("featuresFolders"))
-    for(bpt::ptree::value_type& featureFolderNode : fileTree.get_child("featuresFolders"))
-      sfmData.addFeaturesFolder(featureFolderNode.second.get_value<std::string>());
+    if(!stream)
+    {
+      ALICEVISION_LOG_ERROR("Cannot read the JSON SfMData file: " << filename);
+      return false;
+    }
+  }
 
-  if(fileTree.count("matchesFolders"))
-    for(bpt::ptree::value_type& matchingFolderNode : fileTree.get_child("matchesFolders"))
-      sfmData.addMatchesFolder(matchingFolderNode.second.get_value<std::string>());
+  // parse the file without intermediate tree,
+  // only the views, intrinsics, poses and rigs are parsed in small trees
+  JsonStreamReader reader(buffer.data(), buffer.data() + buffer.size());
+  std::vector<sfmData::View> viewsVec;
 
-  // intrinsics
-  if(loadIntrinsics && fileTree.count("intrinsics"))
+  try
   {
-    sfmData::Intrinsics& intrinsics = sfmData.getIntrinsics();
+    std::string key;
 
-    for(bpt::ptree::value_type &intrinsicNode : fileTree.get_child("intrinsics"))
+    if(reader.beginLevel(false))
     {
-      IndexT intrinsicId;
-      std::shared_ptr<camera::IntrinsicBase> intrinsic;
+      while(reader.nextKey(key))
+      {
+        if(key == "version")
+        {
+          reader.readMatrix(version);
+        }
+        else if(key == "featuresFolders")
+        {
+          std::vector<std::string> featuresFolders;
+          readStrings(featuresFolders, reader);
+          for(const std::string& featuresFolder : featuresFolders)
+            sfmData.addFeaturesFolder(featuresFolder);
+        }
+        else if(key == "matchesFolders")
+        {
+          std::vector<std::string> matchesFolders;
+          readStrings(matchesFolders, reader);
+          for(const std::string& matchesFolder : matchesFolders)
+            sfmData.addMatchesFolder(matchesFolder);
+        }
+        else if(key == "views" && loadViews)
+        {
+          if(!reader.beginLevel(true))
+            continue;
+
+          while(reader.nextElement())
+          {
+            bpt::ptree viewTree;
+            reader.readTree(viewTree);
+            viewsVec.emplace_back();
+            loadView(viewsVec.back(), viewTree);
+          }
+        }
+        else if(key == "intrinsics" && loadIntrinsics)
+        {
+          if(!reader.beginLevel(true))
+            continue;
+
+          sfmData::Intrinsics& intrinsics = sfmData.getIntrinsics();
+
+          while(reader.nextElement())
+          {
+            bpt::ptree intrinsicTree;
+            IndexT intrinsicId;
+            std::shared_ptr<camera::IntrinsicBase> intrinsic;
+
+            reader.readTree(intrinsicTree);
+            loadIntrinsic(intrinsicId, intrinsic, intrinsicTree);
+
+            intrinsics.emplace(intrinsicId, intrinsic);
+          }
+        }
+        else if(key == "poses" && loadExtrinsics)
+        {
+          if(!reader.beginLevel(true))
+            continue;
+
+          sfmData::Poses& poses = sfmData.getPoses();
+
+          while(reader.nextElement())
+          {
+            bpt::ptree poseTree;
+            sfmData::CameraPose pose;
+
+            reader.readTree(poseTree);
+            loadCameraPose("pose", pose, poseTree);
+
+            poses.emplace(poseTree.get<IndexT>("poseId"), pose);
+          }
+        }
+        else if(key == "rigs" && loadExtrinsics)
+        {
+          if(!reader.beginLevel(true))
+            continue;
+
+          sfmData::Rigs& rigs = sfmData.getRigs();
 
-      loadIntrinsic(intrinsicId, intrinsic, intrinsicNode.second);
+          while(reader.nextElement())
+          {
+            bpt::ptree rigTree;
+            IndexT rigId;
+            sfmData::Rig rig;
+
+            reader.readTree(rigTree);
+            loadRig(rigId, rig, rigTree);
 
-      intrinsics.emplace(intrinsicId, intrinsic);
+            rigs.emplace(rigId, rig);
+          }
+        }
+        else if(key == "structure" && loadStructure)
+        {
+          readLandmarks(buffer.data(), sfmData.getLandmarks(), reader);
+        }
+        else if(key == "controlPoints" && loadControlPoints)
+        {
+          readLandmarks(buffer.data(), sfmData.getControlPoints(), reader);
+        }
+        else
+        {
+          reader.skipValue();
+        }
+      }
     }
+    reader.checkEnd();
+  }
+  catch(const std::exception& e)
+  {
+    throw std::runtime_error("Cannot load the JSON SfMData file: " + filename + "\n" + e.what());
   }
 
   // views
-  if(loadViews && fileTree.count("views"))
+  if(loadViews && !viewsVec.empty())
   {
     sfmData::Views& views = sfmData.getViews();
 
     if(incompleteViews)
     {
-      // store incomplete views in a vector
-      std::vector<sfmData::View> incompleteViews(fileTree.get_child("views").size());
-
-      int viewIndex = 0;
-      for(bpt::ptree::value_type &viewNode : fileTree.get_child("views"))
-      {
-        loadView(incompleteViews.at(viewIndex), viewNode.second);
-        ++viewIndex;
-      }
-
       // update incomplete views
       #pragma omp parallel for
-      for(int i = 0; i < incompleteViews.size(); ++i)
+      for(int i = 0; i < viewsVec.size(); ++i)
       {
-        sfmData::View& v = incompleteViews.at(i);
+        sfmData::View& v = viewsVec.at(i);
         // if we have the intrinsics and the view has an valid associated intrinsics
         // update the width and height field of View (they are mirrored)
         if (loadIntrinsics && v.getIntrinsicId() != UndefinedIndexT)
@@ -466,91 +757,13 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
           v.setWidth(intrinsics->w());
           v.setHeight(intrinsics->h());
         }
-        updateIncompleteView(incompleteViews.at(i));
-      }
-
-      // copy complete views in the SfMData views map
-      for(const sfmData::View& view : incompleteViews)
-        views.emplace(view.getViewId(), std::make_shared<sfmData::View>(view));
-    }
-    else
-    {
-      // store directly in the SfMData views map
-      for(bpt::ptree::value_type &viewNode : fileTree.get_child("views"))
-      {
-        sfmData::View view;
-        loadView(view, viewNode.second);
-        views.emplace(view.getViewId(), std::make_shared<sfmData::View>(view));
-      }
-    }
-  }
-
-  // extrinsics
-  if(loadExtrinsics)
-  {
-    // poses
-    if(fileTree.count("poses"))
-    {
-      sfmData::Poses& poses = sfmData.getPoses();
-
-      for(bpt::ptree::value_type &poseNode : fileTree.get_child("poses"))
-      {
-        bpt::ptree& poseTree = poseNode.second;
-        sfmData::CameraPose pose;
-
-        loadCameraPose("pose", pose, poseTree);
-
-        poses.emplace(poseTree.get<IndexT>("poseId"), pose);
-      }
-    }
-
-    // rigs
-    if(fileTree.count("rigs"))
-    {
-      sfmData::Rigs& rigs = sfmData.getRigs();
-
-      for(bpt::ptree::value_type &rigNode : fileTree.get_child("rigs"))
-      {
-        IndexT rigId;
-        sfmData::Rig rig;
-
-        loadRig(rigId, rig, rigNode.second);
-
-        rigs.emplace(rigId, rig);
+        updateIncompleteView(viewsVec.at(i));
       }
     }
-  }
-
-  // structure
-  if(loadStructure && fileTree.count("structure"))
-  {
-    sfmData::Landmarks& structure = sfmData.getLandmarks();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("structure"))
-    {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
-
-      structure.emplace(landmarkId, landmark);
-    }
-  }
-
-  // control points
-  if(loadControlPoints && fileTree.count("controlPoints"))
-  {
-    sfmData::Landmarks& controlPoints = sfmData.getControlPoints();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("controlPoints"))
-    {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
 
-      controlPoints.emplace(landmarkId, landmark);
-    }
+    // copy views in the SfMData views map
+    for(const sfmData::View& view : viewsVec)
+      views.emplace(view.getViewId(), std::make_shared<sfmData::View>(view));
   }
 
   return true;
@@ -0,0 +1,510 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "jsonStream.hpp"
+
+#include <boost/property_tree/json_parser.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+JsonStreamWriter::JsonStreamWriter(std::ostream& stream)
+  : _stream(stream)
+{
+  // the root object is always written, even if empty
+  _levels.push_back({"", false, true, 0});
+  _stream << "{\n";
+}
+
+void JsonStreamWriter::beginObject(const std::string& key)
+{
+  beginLevel(key, false);
+}
+
+void JsonStreamWriter::beginArray(const std::string& key)
+{
+  beginLevel(key, true);
+}
+
+void JsonStreamWriter::beginLevel(const std::string& key, bool isArray)
+{
+  // opened with its first element: an empty object or array is written as an empty value
+  _levels.push_back({key, isArray, false, 0});
+}
+
+void JsonStreamWriter::endLevel()
+{
+  if(_levels.size() < 2)
+    throw std::logic_error("JsonStreamWriter: no object or array to end.");
+
+  const Level level = _levels.back();
+  _levels.pop_back();
+
+  if(!level.isOpened)
+  {
+    writeString(level.key, std::string());
+    return;
+  }
+
+  if(level.nbElements > 0)
+    _stream << '\n';
+  _stream << std::string(4 * _levels.size(), ' ') << (level.isArray ? ']' : '}');
+}
+
+void JsonStreamWriter::tree(const std::string& key, const bpt::ptree& tree)
+{
+  // same layout as boost::property_tree::json_parser::write_json_helper
+  if(tree.empty())
+  {
+    writeString(key, tree.data());
+    return;
+  }
+
+  beginLevel(key, tree.count(std::string()) == tree.size());
+  for(const bpt::ptree::value_type& child : tree)
+    this->tree(child.first, child.second);
+  endLevel();
+}
+
+void JsonStreamWriter::end()
+{
+  while(_levels.size() > 1)
+    endLevel();
+
+  const Level& root = _levels.back();
+  if(root.nbElements > 0)
+    _stream << '\n';
+  _stream << '}' << std::endl;
+  _levels.clear();
+}
+
+void JsonStreamWriter::openLevels()
+{
+  for(std::size_t i = 1; i < _levels.size(); ++i)
+  {
+    Level& level = _levels.at(i);
+
+    if(level.isOpened)
+      continue;
+
+    writeElementPrefix(i - 1, level.key);
+    _stream << (level.isArray ? '[' : '{') << '\n';
+    level.isOpened = true;
+  }
+}
+
+void JsonStreamWriter::writeElementPrefix(std::size_t parentLevel, const std::string& key)
+{
+  Level& parent = _levels.at(parentLevel);
+
+  if(parent.nbElements > 0)
+    _stream << ",\n";
+  ++parent.nbElements;
+
+  _stream << std::string(4 * (parentLevel + 1), ' ');
+
+  if(!parent.isArray)
+    _stream << '"' << bpt::json_parser::create_escapes(key) << "\": ";
+}
+
+void JsonStreamWriter::writeString(const std::string& key, const std::string& value)
+{
+  if(_levels.empty())
+    throw std::logic_error("JsonStreamWriter: cannot write after the end of the root object.");
+
+  openLevels();
+  writeElementPrefix(_levels.size() - 1, key);
+  _stream << '"' << bpt::json_parser::create_escapes(value) << '"';
+}
+
+namespace {
+
+inline bool isWhitespace(char c)
+{
+  return (c == ' ' || c == '\n' || c == '\r' || c == '\t');
+}
+
+inline bool isTokenEnd(char c)
+{
+  return (isWhitespace(c) || c == ',' || c == ':' || c == '}' || c == ']');
+}
+
+inline void appendUtf8(unsigned long codepoint, std::string& value)
+{
+  if(codepoint < 0x80)
+  {
+    value += static_cast<char>(codepoint);
+  }
+  else if(codepoint < 0x800)
+  {
+    value += static_cast<char>(0xC0 | (codepoint >> 6));
+    value += static_cast<char>(0x80 | (codepoint & 0x3F));
+  }
+  else if(codepoint < 0x10000)
+  {
+    value += static_cast<char>(0xE0 | (codepoint >> 12));
+    value += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+    value += static_cast<char>(0x80 | (codepoint & 0x3F));
+  }
+  else
+  {
+    value += static_cast<char>(0xF0 | (codepoint >> 18));
+    value += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+    value += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+    value += static_cast<char>(0x80 | (codepoint & 0x3F));
+  }
+}
+
+} // namespace
+
+bool JsonStreamReader::beginLevel(bool isArray)
+{
+  skipWhitespaces();
+
+  if(_pos == _end)
+    throwError("unexpected end of file");
+
+  if(*_pos == '"')
+  {
+    // empty object or array written as an empty value
+    readQuotedString(_buffer);
+    if(!_buffer.empty())
+      throwError(std::string("expected ") + (isArray ? "an array" : "an object"));
+    return false;
+  }
+
+  expect(isArray ? '[' : '{');
+  _nbElements.push_back(0);
+  return true;
+}
+
+bool JsonStreamReader::nextKey(std::string& key)
+{
+  skipWhitespaces();
+
+  if(_pos != _end && *_pos == '}')
+  {
+    ++_pos;
+    _nbElements.pop_back();
+    return false;
+  }
+
+  if(_nbElements.back() > 0)
+  {
+    expect(',');
+    skipWhitespaces();
+  }
+  ++_nbElements.back();
+
+  if(_pos == _end || *_pos != '"')
+    throwError("expected a key");
+
+  readQuotedString(key);
+  skipWhitespaces();
+  expect(':');
+  skipWhitespaces();
+  return true;
+}
+
+bool JsonStreamReader::nextElement()
+{
+  skipWhitespaces();
+
+  if(_pos != _end && *_pos == ']')
+  {
+    ++_pos;
+    _nbElements.pop_back();
+    return false;
+  }
+
+  if(_nbElements.back() > 0)
+  {
+    expect(',');
+    skipWhitespaces();
+  }
+  ++_nbElements.back();
+  return true;
+}
+
+void JsonStreamReader::readString(std::string& value)
+{
+  skipWhitespaces();
+
+  if(_pos != _end && *_pos == '"')
+  {
+    readQuotedString(value);
+    return;
+  }
+
+  if(_pos != _end && (*_pos == '{' || *_pos == '['))
+    throwError("expected a value");
+
+  // numbers and literals are read as strings
+  const char* tokenBegin = _pos;
+  const char* tokenEnd = readToken();
+  value.assign(tokenBegin, tokenEnd);
+}
+
+double JsonStreamReader::readDouble()
+{
+  readString(_buffer);
+
+  const char* begin = _buffer.c_str();
+  char* end = nullptr;
+  const double value = std::strtod(begin, &end);
+
+  // as boost::property_tree::stream_translator, trailing whitespaces are accepted
+  while(end != begin && isWhitespace(*end))
+    ++end;
+
+  if(_buffer.empty() || end != begin + _buffer.size())
+    throwError("invalid number: '" + _buffer + "'");
+
+  return value;
+}
+
+unsigned long long JsonStreamReader::readUnsigned()
+{
+  readString(_buffer);
+
+  const char* begin = _buffer.c_str();
+  char* end = nullptr;
+  const unsigned long long value = std::strtoull(begin, &end, 10);
+
+  while(end != begin && isWhitespace(*end))
+    ++end;
+
+  if(_buffer.empty() || end != begin + _buffer.size())
+    throwError("invalid integer: '" + _buffer + "'");
+
+  return value;
+}
+
+void JsonStreamReader::readTree(bpt::ptree& tree)
+{
+  skipWhitespaces();
+
+  if(_pos == _end)
+    throwError("unexpected end of file");
+
+  if(*_pos == '{')
+  {
+    std::string key;
+    beginLevel(false);
+    while(nextKey(key))
+    {
+      bpt::ptree& child = tree.push_back(std::make_pair(key, bpt::ptree()))->second;
+      readTree(child);
+    }
+  }
+  else if(*_pos == '[')
+  {
+    beginLevel(true);
+    while(nextElement())
+    {
+      bpt::ptree& child = tree.push_back(std::make_pair(std::string(), bpt::ptree()))->second;
+      readTree(child);
+    }
+  }
+  else
+  {
+    readString(tree.data());
+  }
+}
+
+void JsonStreamReader::skipValue()
+{
+  skipWhitespaces();
+
+  if(_pos == _end)
+    throwError("unexpected end of file");
+
+  if(*_pos == '"')
+  {
+    skipQuotedString();
+    return;
+  }
+
+  if(*_pos != '{' && *_pos != '[')
+  {
+    readToken();
+    return;
+  }
+
+  // skip the object or array without interpreting its content
+  std::size_t depth = 0;
+  while(_pos != _end)
+  {
+    const char c = *_pos;
+
+    if(c == '"')
+    {
+      skipQuotedString();
+      continue;
+    }
+
+    ++_pos;
+
+    if(c == '{' || c == '[')
+    {
+      ++depth;
+    }
+    else if(c == '}' || c == ']')
+    {
+      if(--depth == 0)
+        return;
+    }
+  }
+  throwError("unexpected end of file");
+}
+
+void JsonStreamReader::checkEnd()
+{
+  skipWhitespaces();
+
+  if(_pos != _end)
+    throwError("unexpected data after the end of the root object");
+}
+
+void JsonStreamReader::throwError(const std::string& message) const
+{
+  throw std::runtime_error("Invalid JSON at offset " + std::to_string(_offset + (_pos - _begin)) + ": " + message + ".");
+}
+
+void JsonStreamReader::skipWhitespaces()
+{
+  while(_pos != _end && isWhitespace(*_pos))
+    ++_pos;
+}
+
+void JsonStreamReader::expect(char c)
+{
+  if(_pos == _end || *_pos != c)
+    throwError(std::string("expected '") + c + "'");
+  ++_pos;
+}
+
+void JsonStreamReader::readQuotedString(std::string& value)
+{
+  expect('"');
+  value.clear();
+
+  while(true)
+  {
+    // copy the characters up to the next quote or escape sequence
+    const char* chunkEnd = _pos;
+    while(chunkEnd != _end && *chunkEnd != '"' && *chunkEnd != '\\')
+      ++chunkEnd;
+
+    value.append(_pos, chunkEnd);
+    _pos = chunkEnd;
+
+    if(_pos == _end)
+      throwError("unterminated string");
+
+    if(*_pos == '"')
+    {
+      ++_pos;
+      return;
+    }
+
+    // escape sequence
+    ++_pos;
+    if(_pos == _end)
+      throwError("unterminated string");
+
+    switch(*_pos++)
+    {
+      case '"':  value += '"';  break;
+      case '\\': value += '\\'; break;
+      case '/':  value += '/';  break;
+      case 'b':  value += '\b'; break;
+      case 'f':  value += '\f'; break;
+      case 'n':  value += '\n'; break;
+      case 'r':  value += '\r'; break;
+      case 't':  value += '\t'; break;
+      case 'u':
+      {
+        auto readHex = [this]() -> unsigned long
+        {
+          if(_end - _pos < 4)
+            throwError("invalid unicode escape sequence");
+          unsigned long codeUnit = 0;
+          for(int i = 0; i < 4; ++i)
+          {
+            const char c = *_pos++;
+            codeUnit <<= 4;
+            if(c >= '0' && c <= '9')
+              codeUnit |= static_cast<unsigned long>(c - '0');
+            else if(c >= 'a' && c <= 'f')
+              codeUnit |= static_cast<unsigned long>(c - 'a' + 10);
+            else if(c >= 'A' && c <= 'F')
+              codeUnit |= static_cast<unsigned long>(c - 'A' + 10);
+            else
+              throwError("invalid unicode escape sequence");
+          }
+          return codeUnit;
+        };
+
+        unsigned long codepoint = readHex();
+
+        // surrogate pair
+        if(codepoint >= 0xD800 && codepoint <= 0xDBFF)
+        {
+          if(_end - _pos < 2 || _pos[0] != '\\' || _pos[1] != 'u')
+            throwError("invalid unicode surrogate pair");
+          _pos += 2;
+          const unsigned long low = readHex();
+          if(low < 0xDC00 || low > 0xDFFF)
+            throwError("invalid unicode surrogate pair");
+          codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+        }
+        appendUtf8(codepoint, value);
+        break;
+      }
+      default:
+        --_pos;
+        throwError("invalid escape sequence");
+    }
+  }
+}
+
+void JsonStreamReader::skipQuotedString()
+{
+  expect('"');
+
+  while(_pos != _end)
+  {
+    const char c = *_pos++;
+
+    if(c == '"')
+      return;
+
+    if(c == '\\' && _pos != _end)
+      ++_pos;
+  }
+  throwError("unterminated string");
+}
+
+const char* JsonStreamReader::readToken()
+{
+  const char* tokenBegin = _pos;
+
+  while(_pos != _end && !isTokenEnd(*_pos))
+    ++_pos;
+
+  if(_pos == tokenBegin)
+    throwError("expected a value");
+
+  return _pos;
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -0,0 +1,242 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/stream_translator.hpp>
+
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace bpt = boost::property_tree;
+
+/**
+ * @brief Incremental JSON writer.
+ *        The output is identical to boost::property_tree::write_json of the equivalent property tree:
+ *        - all the values are written as escaped strings,
+ *        - the empty objects and arrays are written as empty strings,
+ *        - the elements are indented with 4 spaces.
+ *        Objects and arrays are only opened when their first element is written.
+ */
+class JsonStreamWriter
+{
+public:
+  /**
+   * @brief JsonStreamWriter constructor, open the root object.
+   * @param[out] stream The output stream
+   */
+  explicit JsonStreamWriter(std::ostream& stream);
+
+  /**
+   * @brief Begin an object.
+   * @param[in] key The object key ( "" in an array )
+   */
+  void beginObject(const std::string& key = "");
+
+  /**
+   * @brief Begin an array.
+   * @param[in] key The array key ( "" in an array )
+   */
+  void beginArray(const std::string& key = "");
+
+  /**
+   * @brief End the last object or array.
+   *        The root object is closed by end().
+   */
+  void endLevel();
+
+  /**
+   * @brief Write a value, converted as boost::property_tree::ptree::put does.
+   * @param[in] key The value key ( "" in an array )
+   * @param[in] value The value
+   */
+  template<typename T>
+  void value(const std::string& key, const T& value)
+  {
+    _valueStream.str(std::string());
+    _valueStream.clear();
+    bpt::customize_stream<char, std::char_traits<char>, T>::insert(_valueStream, value);
+    writeString(key, _valueStream.str());
+  }
+
+  /**
+   * @brief Write a string value.
+   * @param[in] key The value key ( "" in an array )
+   * @param[in] value The string value
+   */
+  void value(const std::string& key, const std::string& value)
+  {
+    writeString(key, value);
+  }
+
+  /**
+   * @brief Write an array of the coefficients of an Eigen Matrix (or Vector), as saveMatrix.
+   * @param[in] key The array key ( "" in an array )
+   * @param[in] matrix The input matrix
+   */
+  template<typename Derived>
+  void matrix(const std::string& key, const Derived& matrix)
+  {
+    beginArray(key);
+    for(int i = 0; i < matrix.size(); ++i)
+      value("", matrix(i));
+    endLevel();
+  }
+
+  /**
+   * @brief Write a boost property tree.
+   * @param[in] key The tree key ( "" in an array )
+   * @param[in] tree The input tree
+   */
+  void tree(const std::string& key, const bpt::ptree& tree);
+
+  /**
+   * @brief Close all the opened objects and arrays, including the root object.
+   */
+  void end();
+
+private:
+  struct Level
+  {
+    std::string key;
+    bool isArray;
+    bool isOpened;
+    std::size_t nbElements;
+  };
+
+  void beginLevel(const std::string& key, bool isArray);
+  void openLevels();
+  void writeElementPrefix(std::size_t parentLevel, const std::string& key);
+  void writeString(const std::string& key, const std::string& value);
+
+  std::ostream& _stream;
+  std::ostringstream _valueStream;
+  std::vector<Level> _levels;
+};
+
+/**
+ * @brief JSON reader on an in-memory buffer, without intermediate document.
+ *        Values may be JSON strings, numbers or literals:
+ *        as in boost::property_tree::read_json, they are all read as strings,
+ *        and an empty string is an empty object or array.
+ *        Readers on sub-ranges of the same buffer can parse in parallel.
+ */
+class JsonStreamReader
+{
+public:
+  /**
+   * @brief JsonStreamReader constructor.
+   * @param[in] begin The beginning of the buffer
+   * @param[in] end The end of the buffer
+   * @param[in] offset The offset of begin in the file (for error messages)
+   */
+  JsonStreamReader(const char* begin, const char* end, std::size_t offset = 0)
+    : _begin(begin)
+    , _pos(begin)
+    , _end(end)
+    , _offset(offset)
+  {}
+
+  /// @return the current position in the buffer
+  const char* position() const { return _pos; }
+
+  /**
+   * @brief Begin an object or an array.
+   * @param[in] isArray True to begin an array
+   * @return false if the value is an empty string (empty object or array)
+   */
+  bool beginLevel(bool isArray);
+
+  /**
+   * @brief Go to the next element of the current object.
+   * @param[out] key The key of the next element
+   * @return false at the end of the object
+   */
+  bool nextKey(std::string& key);
+
+  /**
+   * @brief Go to the next element of the current array.
+   * @return false at the end of the array
+   */
+  bool nextElement();
+
+  /**
+   * @brief Read a value as a string.
+   * @param[out] value The value
+   */
+  void readString(std::string& value);
+
+  /// @return the next value converted to a double
+  double readDouble();
+
+  /// @return the next value converted to an unsigned integer
+  unsigned long long readUnsigned();
+
+  /**
+   * @brief Read a value into a boost property tree, as read_json does.
+   * @param[out] tree The output tree
+   */
+  void readTree(bpt::ptree& tree);
+
+  /**
+   * @brief Read the values of an array into an Eigen Matrix (or Vector), as loadMatrix.
+   * @param[out] matrix The output matrix
+   */
+  template<typename Derived>
+  void readMatrix(Derived& matrix)
+  {
+    int i = 0;
+    if(beginLevel(true))
+    {
+      while(nextElement())
+      {
+        if(i >= matrix.size())
+          throwError("too many matrix coefficients");
+        matrix(i++) = static_cast<typename Derived::Scalar>(readDouble());
+      }
+    }
+  }
+
+  /**
+   * @brief Skip the next value.
+   */
+  void skipValue();
+
+  /**
+   * @brief Check that only whitespaces remain in the buffer.
+   */
+  void checkEnd();
+
+  /**
+   * @brief Throw a std::runtime_error with the current offset.
+   * @param[in] message The error message
+   */
+  [[noreturn]] void throwError(const std::string& message) const;
+
+private:
+  void skipWhitespaces();
+  void expect(char c);
+  void readQuotedString(std::string& value);
+  void skipQuotedString();
+  const char* readToken();
+
+  const char* _begin;
+  const char* _pos;
+  const char* _end;
+  std::size_t _offset;
+  /// number of elements already read in the current object or array
+  std::vector<std::size_t> _nbElements;
+  std::string _buffer;
+};
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -7,9 +7,16 @@
 
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfmDataIO/jsonIO.hpp>
 
 #include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
 #include <sstream>
 
 #define BOOST_TEST_MODULE sfmDataIO
@@ -72,7 +79,7 @@ sfmData::SfMData createTestScene(std::size_t viewsCount = 2, std::size_t observa
 
 BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
 
-  const std::vector<std::string> ext_Type = {"sfm","json"};
+  const std::vector<std::string> ext_Type = {"sfm","json","sfmb"};
 
   for(int i = 0; i < ext_Type.size(); ++i)
   {
@@ -177,7 +184,7 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
 BOOST_AUTO_TEST_CASE(SfMData_IO_BigFile) {
   const int nbViews = 1000;
   const int nbObservationPerView = 100000;
-  std::vector<std::string> ext_Type = {"sfm","json"};
+  std::vector<std::string> ext_Type = {"sfm","json","sfmb"};
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
   ext_Type.push_back("abc");
@@ -211,6 +218,293 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_BigFile) {
 }
 */
 
+BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_SFMB) {
+
+  const std::string filename = "SAVE_LOAD_FULL.sfmb";
+
+  sfmData::SfMData sfmData = createTestScene(4, 3, false);
+  sfmData.addFeaturesFolder("features");
+  sfmData.addMatchesFolder("matches");
+  sfmData.views.at(0)->addMetadata("Make", "Canon");
+  sfmData.views.at(0)->addMetadata("Model", "EOS 5D");
+  sfmData.views.at(1)->setResectionId(3);
+  sfmData.getPoses().at(1).lock();
+  sfmData.intrinsics.at(2)->lock();
+  sfmData.structure[0].rgb = image::RGBColor(10, 20, 30);
+  sfmData.control_points[5] = sfmData::Landmark(Vec3(1,2,3), feature::EImageDescriberType::SIFT);
+  sfmData.control_points[5].observations[1] = sfmData::Observation(Vec2(4,5), 6);
+
+  // a rig with two sub-poses
+  {
+    sfmData::Rig rig(2);
+    sfmData::RigSubPose subPose(Pose3(RotationAroundY(0.1), Vec3(0.5,0,0)), sfmData::ERigSubPoseStatus::ESTIMATED);
+    rig.setSubPose(1, subPose);
+    sfmData.getRigs().emplace(0, rig);
+    sfmData.views.at(2)->setRigAndSubPoseId(0, 0);
+    sfmData.views.at(3)->setRigAndSubPoseId(0, 1);
+    sfmData.views.at(3)->setPoseId(2);
+    sfmData.getPoses().erase(3);
+  }
+
+  BOOST_CHECK( Save(sfmData, filename, ALL) );
+
+  // LOAD
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, ALL) );
+    BOOST_CHECK( sfmDataLoad == sfmData );
+    BOOST_CHECK( sfmDataLoad.getRelativeFeaturesFolders() == sfmData.getRelativeFeaturesFolders() );
+    BOOST_CHECK( sfmDataLoad.getRelativeMatchesFolders() == sfmData.getRelativeMatchesFolders() );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.at(0)->getMetadata().size(), 2);
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.at(1)->getResectionId(), 3);
+    BOOST_CHECK( sfmDataLoad.getPoses().at(1).isLocked() );
+    BOOST_CHECK( sfmDataLoad.intrinsics.at(2)->isLocked() );
+    BOOST_CHECK( sfmDataLoad.structure.at(0).rgb == sfmData.structure.at(0).rgb );
+    BOOST_CHECK( sfmDataLoad.control_points == sfmData.control_points );
+  }
+
+  // LOAD (structure without observations)
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, STRUCTURE) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), sfmData.structure.size());
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.at(0).observations.size(), 0);
+    BOOST_CHECK( sfmDataLoad.structure.at(0).X == sfmData.structure.at(0).X );
+  }
+
+  // SAVE (structure without observations)
+  {
+    BOOST_CHECK( Save(sfmData, filename, ESfMData(VIEWS | STRUCTURE)) );
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, ESfMData(VIEWS | STRUCTURE | OBSERVATIONS)) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), sfmData.views.size());
+    BOOST_CHECK_EQUAL( sfmDataLoad.getPoses().size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), sfmData.structure.size());
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.at(0).observations.size(), 0);
+  }
+
+  // LOAD (corrupted sections table)
+  {
+    BOOST_CHECK( Save(sfmData, filename, ALL) );
+
+    std::string content;
+    {
+      std::ifstream file(filename, std::ios::binary);
+      content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    BOOST_REQUIRE_GT(content.size(), 16 + 24);
+
+    const auto writeCorrupted = [&](std::size_t position, std::uint64_t value)
+    {
+      std::string corrupted = content;
+      std::memcpy(&corrupted[position], &value, sizeof(value));
+      std::ofstream(filename, std::ios::binary) << corrupted;
+    };
+
+    // number of sections (header bytes [8,16))
+    writeCorrupted(8, std::numeric_limits<std::uint64_t>::max() / 24);
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( !Load(sfmDataLoad, filename, ALL) );
+
+    // size of the first section (entry bytes [16,24))
+    writeCorrupted(16 + 16, std::numeric_limits<std::uint64_t>::max());
+    BOOST_CHECK( !Load(sfmDataLoad, filename, ALL) );
+
+    // offset of the first section (entry bytes [8,16))
+    writeCorrupted(16 + 8, content.size() + 1);
+    BOOST_CHECK( !Load(sfmDataLoad, filename, ALL) );
+  }
+
+  // LOAD (invalid file)
+  {
+    std::ofstream(filename) << "not a binary SfMData file";
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( !Load(sfmDataLoad, filename, ALL) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_PROPERTY_TREE) {
+
+  const std::string filename = "SAVE_LOAD_PTREE.sfm";
+
+  sfmData::SfMData sfmData = createTestScene(3, 4, false);
+  sfmData.addFeaturesFolder("features");
+  sfmData.views.at(0)->addMetadata("Make", "Canon \"EOS\"");
+  sfmData.structure[0].rgb = image::RGBColor(10, 20, 30);
+  sfmData.structure[1].X = Vec3(0.1, -1e-20, 1e20);
+  sfmData.structure[1].descType = feature::EImageDescriberType::SIFT;
+
+  BOOST_CHECK( saveJSON(sfmData, filename, ALL) );
+
+  // the streamed file is read by the property tree parser
+  {
+    bpt::ptree fileTree;
+    bpt::read_json(filename, fileTree);
+
+    BOOST_CHECK_EQUAL( fileTree.get_child("views").size(), sfmData.views.size());
+    BOOST_CHECK_EQUAL( fileTree.get_child("intrinsics").size(), sfmData.intrinsics.size());
+    BOOST_CHECK_EQUAL( fileTree.get_child("featuresFolders").front().second.data(), "features");
+
+    sfmData::View view;
+    loadView(view, fileTree.get_child("views").front().second);
+    BOOST_CHECK( view == *sfmData.views.at(0) );
+    BOOST_CHECK( view.getMetadata() == sfmData.views.at(0)->getMetadata() );
+
+    sfmData::Landmarks structure;
+    for(bpt::ptree::value_type& landmarkNode : fileTree.get_child("structure"))
+    {
+      IndexT landmarkId;
+      sfmData::Landmark landmark;
+      loadLandmark(landmarkId, landmark, landmarkNode.second);
+      structure.emplace(landmarkId, landmark);
+    }
+    BOOST_CHECK( structure == sfmData.structure );
+    BOOST_CHECK( structure.at(0).rgb == sfmData.structure.at(0).rgb );
+  }
+
+  // the property tree output is read by the streaming parser
+  {
+    bpt::ptree fileTree;
+    bpt::read_json(filename, fileTree);
+    bpt::write_json(filename, fileTree);
+
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( loadJSON(sfmDataLoad, filename, ALL) );
+    BOOST_CHECK( sfmDataLoad == sfmData );
+    BOOST_CHECK( sfmDataLoad.getRelativeFeaturesFolders() == sfmData.getRelativeFeaturesFolders() );
+    BOOST_CHECK( sfmDataLoad.views.at(0)->getMetadata() == sfmData.views.at(0)->getMetadata() );
+  }
+
+  // unquoted numbers, compact layout and unknown keys
+  {
+    std::ofstream(filename) << "{\"version\":[1,0,0],\"unknown\":{\"a\":[{},\"b\"]},"
+                               "\"structure\":[{\"landmarkId\":7,\"descType\":\"sift\",\"color\":[1,2,3],\"X\":[1.5,-2e3,0],"
+                               "\"observations\":[{\"observationId\":2,\"featureId\":9,\"x\":[0.5,1]}]},"
+                               "{\"landmarkId\":\"8\",\"descType\":\"sift\",\"color\":[1,2,3],\"X\":[0,0,0],\"observations\":\"\"}]}";
+
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( loadJSON(sfmDataLoad, filename, ALL) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), 2);
+    BOOST_CHECK( sfmDataLoad.structure.at(7).X == Vec3(1.5, -2e3, 0) );
+    BOOST_CHECK( sfmDataLoad.structure.at(7).observations.at(2).x == Vec2(0.5, 1) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.at(7).observations.at(2).id_feat, 9);
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.at(8).observations.size(), 0);
+  }
+
+  // invalid file
+  {
+    std::ofstream(filename) << "{\"structure\":[{\"landmarkId\":7,";
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK_THROW( loadJSON(sfmDataLoad, filename, ALL), std::runtime_error );
+  }
+}
+
+/**
+ * @brief Property tree of a scene, built as saveJSON did before the incremental writer
+ */
+bpt::ptree getPropertyTree(const sfmData::SfMData& sfmData)
+{
+  bpt::ptree fileTree;
+  saveMatrix("version", Vec3(1, 0, 0), fileTree);
+
+  const auto saveFolders = [&](const std::string& name, const std::vector<std::string>& folders)
+  {
+    bpt::ptree foldersTree;
+    for(const std::string& folder : folders)
+    {
+      bpt::ptree folderTree;
+      folderTree.put("", folder);
+      foldersTree.push_back(std::make_pair("", folderTree));
+    }
+    fileTree.add_child(name, foldersTree);
+  };
+  saveFolders("featuresFolders", sfmData.getRelativeFeaturesFolders());
+  saveFolders("matchesFolders", sfmData.getRelativeMatchesFolders());
+
+  bpt::ptree viewsTree;
+  for(const auto& viewPair : sfmData.getViews())
+    saveView("", *(viewPair.second), viewsTree);
+  fileTree.add_child("views", viewsTree);
+
+  bpt::ptree intrinsicsTree;
+  for(const auto& intrinsicPair : sfmData.getIntrinsics())
+    saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
+  fileTree.add_child("intrinsics", intrinsicsTree);
+
+  bpt::ptree posesTree;
+  for(const auto& posePair : sfmData.getPoses())
+  {
+    bpt::ptree poseTree;
+    poseTree.put("poseId", posePair.first);
+    saveCameraPose("pose", posePair.second, poseTree);
+    posesTree.push_back(std::make_pair("", poseTree));
+  }
+  fileTree.add_child("poses", posesTree);
+
+  bpt::ptree rigsTree;
+  for(const auto& rigPair : sfmData.getRigs())
+    saveRig("", rigPair.first, rigPair.second, rigsTree);
+  fileTree.add_child("rigs", rigsTree);
+
+  bpt::ptree structureTree;
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+    saveLandmark("", landmarkPair.first, landmarkPair.second, structureTree);
+  fileTree.add_child("structure", structureTree);
+
+  bpt::ptree controlPointsTree;
+  for(const auto& controlPointPair : sfmData.getControlPoints())
+    saveLandmark("", controlPointPair.first, controlPointPair.second, controlPointsTree);
+  fileTree.add_child("controlPoints", controlPointsTree);
+
+  return fileTree;
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_SAME_AS_PROPERTY_TREE) {
+
+  const std::string filename = "SAVE_PTREE_EQUAL.sfm";
+
+  sfmData::SfMData sfmData = createTestScene(4, 3, false);
+  sfmData.addFeaturesFolder("features");
+  sfmData.addFeaturesFolder("other features");
+  sfmData.addMatchesFolder("matches");
+  sfmData.views.at(0)->addMetadata("Make", "Canon \"EOS\"\\\t");
+  sfmData.views.at(0)->addMetadata("Model", "");
+  sfmData.views.at(1)->setResectionId(3);
+  sfmData.getPoses().at(1).lock();
+  sfmData.getPoses().at(2) = sfmData::CameraPose(Pose3(RotationAroundX(0.3), Vec3(-1.5, 1e-7, 123456789.125)));
+  sfmData.intrinsics.at(2)->lock();
+  sfmData.structure[0].rgb = image::RGBColor(10, 20, 30);
+  sfmData.structure[1].X = Vec3(0.1, -1e-20, 1e20);
+  sfmData.structure[1].descType = feature::EImageDescriberType::SIFT;
+  sfmData.control_points[5] = sfmData::Landmark(Vec3(1,2,3), feature::EImageDescriberType::SIFT);
+  sfmData.control_points[5].observations[1] = sfmData::Observation(Vec2(4.25,-5), 6);
+
+  // a rig with an initialized and an uninitialized sub-pose
+  {
+    sfmData::Rig rig(2);
+    rig.setSubPose(1, sfmData::RigSubPose(Pose3(RotationAroundY(0.1), Vec3(0.5,0,0)), sfmData::ERigSubPoseStatus::ESTIMATED));
+    sfmData.getRigs().emplace(0, rig);
+    sfmData.views.at(2)->setRigAndSubPoseId(0, 0);
+    sfmData.views.at(3)->setRigAndSubPoseId(0, 1);
+  }
+
+  BOOST_CHECK( saveJSON(sfmData, filename, ALL) );
+
+  std::string streamed;
+  {
+    std::ifstream file(filename, std::ios::binary);
+    streamed.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  std::ostringstream propertyTree;
+  bpt::write_json(propertyTree, getPropertyTree(sfmData));
+
+  // the incremental writer gives the same bytes as the property tree writer
+  BOOST_CHECK_EQUAL( streamed.size(), propertyTree.str().size() );
+  BOOST_CHECK( streamed == propertyTree.str() );
+}
+
 BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_PLY) {
 
   // SAVE as PLY
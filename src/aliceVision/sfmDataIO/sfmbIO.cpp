@@ -0,0 +1,931 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "sfmbIO.hpp"
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace {
+
+/// Type of a section of a binary SfMData file
+enum class ESfMBSection : std::uint32_t
+{
+  FOLDERS = 0,
+  VIEWS = 1,
+  INTRINSICS = 2,
+  POSES = 3,
+  RIGS = 4,
+  STRUCTURE = 5,
+  OBSERVATIONS = 6,
+  CONTROL_POINTS = 7,
+  CONTROL_POINTS_OBSERVATIONS = 8
+};
+
+/**
+ * @brief Header of a binary SfMData file (.sfmb).
+ *
+ * The header is followed by a table of nbSections SfMBSectionEntry, then by the sections data.
+ */
+struct SfMBFileHeader
+{
+  /// "AVSB" in little-endian byte order
+  static constexpr std::uint32_t magic = 0x42535641;
+  static constexpr std::uint32_t currentVersion = 1;
+
+  std::uint32_t fileMagic = magic;
+  std::uint32_t version = currentVersion;
+  std::uint64_t nbSections = 0;
+};
+
+/**
+ * @brief Entry of the sections table of a binary SfMData file (.sfmb).
+ */
+struct SfMBSectionEntry
+{
+  std::uint32_t type = 0;
+  std::uint32_t padding = 0;
+  /// position of the section in the file (in bytes)
+  std::uint64_t offset = 0;
+  /// size of the section (in bytes)
+  std::uint64_t size = 0;
+};
+
+static_assert(sizeof(SfMBFileHeader) == 16, "Unexpected binary SfMData file header size.");
+static_assert(sizeof(SfMBSectionEntry) == 24, "Unexpected binary SfMData file section entry size.");
+
+/**
+ * @brief Write the columns of a section in a buffer.
+ */
+class SectionWriter
+{
+public:
+  template <typename T>
+  void write(const std::vector<T>& column)
+  {
+    static_assert(std::is_pod<T>::value, "Only POD columns can be written.");
+    writeSize(column.size());
+    append(column.data(), column.size() * sizeof(T));
+  }
+
+  /// strings are stored as offsets (number of strings + 1) and characters
+  void write(const std::vector<std::string>& column)
+  {
+    std::vector<std::uint64_t> offsets(1, 0);
+    std::vector<char> characters;
+    offsets.reserve(column.size() + 1);
+    for(const std::string& value : column)
+    {
+      characters.insert(characters.end(), value.begin(), value.end());
+      offsets.push_back(characters.size());
+    }
+    write(offsets);
+    write(characters);
+  }
+
+  const std::vector<char>& data() const { return _data; }
+
+private:
+  void writeSize(std::uint64_t size)
+  {
+    append(&size, sizeof(size));
+  }
+
+  void append(const void* data, std::size_t size)
+  {
+    const char* begin = static_cast<const char*>(data);
+    _data.insert(_data.end(), begin, begin + size);
+  }
+
+  std::vector<char> _data;
+};
+
+/**
+ * @brief Read the columns of a section from a buffer.
+ *        Throws if the section is truncated.
+ */
+class SectionReader
+{
+public:
+  explicit SectionReader(const std::vector<char>& data)
+    : _data(data)
+  {}
+
+  template <typename T>
+  void read(std::vector<T>& column)
+  {
+    static_assert(std::is_pod<T>::value, "Only POD columns can be read.");
+    const std::uint64_t size = readSize();
+    if(size > (_data.size() - _position) / sizeof(T))
+      throw std::runtime_error("Truncated binary SfMData section.");
+    column.resize(size);
+    if(size > 0)
+      std::memcpy(column.data(), _data.data() + _position, size * sizeof(T));
+    _position += size * sizeof(T);
+  }
+
+  void read(std::vector<std::string>& column)
+  {
+    std::vector<std::uint64_t> offsets;
+    std::vector<char> characters;
+    read(offsets);
+    read(characters);
+    if(offsets.empty() || offsets.back() != characters.size())
+      throw std::runtime_error("Invalid strings in binary SfMData section.");
+    column.resize(offsets.size() - 1);
+    for(std::size_t i = 0; i < column.size(); ++i)
+    {
+      if(offsets[i] > offsets[i + 1])
+        throw std::runtime_error("Invalid strings in binary SfMData section.");
+      column[i].assign(characters.data() + offsets[i], characters.data() + offsets[i + 1]);
+    }
+  }
+
+private:
+  std::uint64_t readSize()
+  {
+    std::uint64_t size = 0;
+    if(_data.size() - _position < sizeof(size))
+      throw std::runtime_error("Truncated binary SfMData section.");
+    std::memcpy(&size, _data.data() + _position, sizeof(size));
+    _position += sizeof(size);
+    return size;
+  }
+
+  const std::vector<char>& _data;
+  std::size_t _position = 0;
+};
+
+/// Check the number of values of a column
+template <typename T>
+void checkColumnSize(const std::vector<T>& column, std::size_t expectedSize)
+{
+  if(column.size() != expectedSize)
+    throw std::runtime_error("Inconsistent column size in binary SfMData section.");
+}
+
+/// Check that the offsets of a column are a valid partition of its values
+void checkOffsets(const std::vector<std::uint64_t>& offsets, std::size_t nbElements, std::size_t nbValues)
+{
+  checkColumnSize(offsets, nbElements + 1);
+  for(std::size_t i = 0; i < nbElements; ++i)
+  {
+    if(offsets[i] > offsets[i + 1])
+      throw std::runtime_error("Invalid offsets in binary SfMData section.");
+  }
+  if(offsets.front() != 0 || offsets.back() != nbValues)
+    throw std::runtime_error("Invalid offsets in binary SfMData section.");
+}
+
+void writePose3(const geometry::Pose3& pose, std::vector<double>& rotations, std::vector<double>& centers)
+{
+  // column-major rotation matrix
+  rotations.insert(rotations.end(), pose.rotation().data(), pose.rotation().data() + 9);
+  centers.insert(centers.end(), pose.center().data(), pose.center().data() + 3);
+}
+
+geometry::Pose3 readPose3(const std::vector<double>& rotations, const std::vector<double>& centers, std::size_t i)
+{
+  return geometry::Pose3(Eigen::Map<const Mat3>(rotations.data() + 9 * i),
+                         Eigen::Map<const Vec3>(centers.data() + 3 * i));
+}
+
+void writeFolders(const sfmData::SfMData& sfmData, SectionWriter& writer)
+{
+  writer.write(sfmData.getRelativeFeaturesFolders());
+  writer.write(sfmData.getRelativeMatchesFolders());
+}
+
+void readFolders(SectionReader& reader, sfmData::SfMData& sfmData)
+{
+  std::vector<std::string> featuresFolders;
+  std::vector<std::string> matchesFolders;
+  reader.read(featuresFolders);
+  reader.read(matchesFolders);
+
+  for(const std::string& featuresFolder : featuresFolders)
+    sfmData.addFeaturesFolder(featuresFolder);
+  for(const std::string& matchesFolder : matchesFolders)
+    sfmData.addMatchesFolder(matchesFolder);
+}
+
+void writeViews(const sfmData::Views& views, SectionWriter& writer)
+{
+  std::vector<std::uint32_t> viewIds;
+  std::vector<std::uint32_t> poseIds;
+  std::vector<std::uint32_t> intrinsicIds;
+  std::vector<std::uint32_t> rigIds;
+  std::vector<std::uint32_t> subPoseIds;
+  std::vector<std::uint32_t> resectionIds;
+  std::vector<std::uint64_t> widths;
+  std::vector<std::uint64_t> heights;
+  std::vector<std::string> paths;
+  std::vector<std::uint64_t> metadataOffsets(1, 0);
+  std::vector<std::string> metadataKeys;
+  std::vector<std::string> metadataValues;
+
+  for(const auto& viewPair : views)
+  {
+    const sfmData::View& view = *viewPair.second;
+
+    viewIds.push_back(view.getViewId());
+    poseIds.push_back(view.getPoseId());
+    intrinsicIds.push_back(view.getIntrinsicId());
+    rigIds.push_back(view.isPartOfRig() ? view.getRigId() : UndefinedIndexT);
+    subPoseIds.push_back(view.isPartOfRig() ? view.getSubPoseId() : UndefinedIndexT);
+    resectionIds.push_back(view.getResectionId());
+    widths.push_back(view.getWidth());
+    heights.push_back(view.getHeight());
+    paths.push_back(view.getImagePath());
+
+    for(const auto& metadataPair : view.getMetadata())
+    {
+      metadataKeys.push_back(metadataPair.first);
+      metadataValues.push_back(metadataPair.second);
+    }
+    metadataOffsets.push_back(metadataKeys.size());
+  }
+
+  writer.write(viewIds);
+  writer.write(poseIds);
+  writer.write(intrinsicIds);
+  writer.write(rigIds);
+  writer.write(subPoseIds);
+  writer.write(resectionIds);
+  writer.write(widths);
+  writer.write(heights);
+  writer.write(paths);
+  writer.write(metadataOffsets);
+  writer.write(metadataKeys);
+  writer.write(metadataValues);
+}
+
+void readViews(SectionReader& reader, sfmData::Views& views)
+{
+  std::vector<std::uint32_t> viewIds;
+  std::vector<std::uint32_t> poseIds;
+  std::vector<std::uint32_t> intrinsicIds;
+  std::vector<std::uint32_t> rigIds;
+  std::vector<std::uint32_t> subPoseIds;
+  std::vector<std::uint32_t> resectionIds;
+  std::vector<std::uint64_t> widths;
+  std::vector<std::uint64_t> heights;
+  std::vector<std::string> paths;
+  std::vector<std::uint64_t> metadataOffsets;
+  std::vector<std::string> metadataKeys;
+  std::vector<std::string> metadataValues;
+
+  reader.read(viewIds);
+  reader.read(poseIds);
+  reader.read(intrinsicIds);
+  reader.read(rigIds);
+  reader.read(subPoseIds);
+  reader.read(resectionIds);
+  reader.read(widths);
+  reader.read(heights);
+  reader.read(paths);
+  reader.read(metadataOffsets);
+  reader.read(metadataKeys);
+  reader.read(metadataValues);
+
+  const std::size_t nbViews = viewIds.size();
+  checkColumnSize(poseIds, nbViews);
+  checkColumnSize(intrinsicIds, nbViews);
+  checkColumnSize(rigIds, nbViews);
+  checkColumnSize(subPoseIds, nbViews);
+  checkColumnSize(resectionIds, nbViews);
+  checkColumnSize(widths, nbViews);
+  checkColumnSize(heights, nbViews);
+  checkColumnSize(paths, nbViews);
+  checkColumnSize(metadataValues, metadataKeys.size());
+  checkOffsets(metadataOffsets, nbViews, metadataKeys.size());
+
+  for(std::size_t i = 0; i < nbViews; ++i)
+  {
+    std::shared_ptr<sfmData::View> view = std::make_shared<sfmData::View>();
+
+    view->setViewId(viewIds[i]);
+    view->setPoseId(poseIds[i]);
+    if(rigIds[i] != UndefinedIndexT)
+      view->setRigAndSubPoseId(rigIds[i], subPoseIds[i]);
+    view->setIntrinsicId(intrinsicIds[i]);
+    view->setResectionId(resectionIds[i]);
+    view->setImagePath(paths[i]);
+    view->setWidth(widths[i]);
+    view->setHeight(heights[i]);
+
+    for(std::size_t m = metadataOffsets[i]; m < metadataOffsets[i + 1]; ++m)
+      view->addMetadata(metadataKeys[m], metadataValues[m]);
+
+    views.emplace(viewIds[i], view);
+  }
+}
+
+void writeIntrinsics(const sfmData::Intrinsics& intrinsics, SectionWriter& writer)
+{
+  std::vector<std::uint32_t> intrinsicIds;
+  std::vector<std::string> types;
+  std::vector<std::uint32_t> widths;
+  std::vector<std::uint32_t> heights;
+  std::vector<std::string> serialNumbers;
+  std::vector<double> pxInitialFocalLengths;
+  std::vector<double> pxFocalLengths;
+  std::vector<double> principalPoints;
+  std::vector<std::uint64_t> distortionOffsets(1, 0);
+  std::vector<double> distortionParams;
+  std::vector<std::uint8_t> locked;
+
+  for(const auto& intrinsicPair : intrinsics)
+  {
+    const camera::IntrinsicBase& intrinsic = *intrinsicPair.second;
+    const camera::EINTRINSIC intrinsicType = intrinsic.getType();
+
+    intrinsicIds.push_back(intrinsicPair.first);
+    types.push_back(camera::EINTRINSIC_enumToString(intrinsicType));
+    widths.push_back(intrinsic.w());
+    heights.push_back(intrinsic.h());
+    serialNumbers.push_back(intrinsic.serialNumber());
+    pxInitialFocalLengths.push_back(intrinsic.initialFocalLengthPix());
+
+    if(camera::isPinhole(intrinsicType))
+    {
+      const camera::Pinhole& pinholeIntrinsic = dynamic_cast<const camera::Pinhole&>(intrinsic);
+      const std::vector<double> params = pinholeIntrinsic.getDistortionParams();
+
+      pxFocalLengths.push_back(pinholeIntrinsic.getFocalLengthPix());
+      principalPoints.push_back(pinholeIntrinsic.getPrincipalPoint()(0));
+      principalPoints.push_back(pinholeIntrinsic.getPrincipalPoint()(1));
+      distortionParams.insert(distortionParams.end(), params.begin(), params.end());
+    }
+    else
+    {
+      pxFocalLengths.push_back(0.0);
+      principalPoints.push_back(0.0);
+      principalPoints.push_back(0.0);
+    }
+    distortionOffsets.push_back(distortionParams.size());
+    locked.push_back(intrinsic.isLocked());
+  }
+
+  writer.write(intrinsicIds);
+  writer.write(types);
+  writer.write(widths);
+  writer.write(heights);
+  writer.write(serialNumbers);
+  writer.write(pxInitialFocalLengths);
+  writer.write(pxFocalLengths);
+  writer.write(principalPoints);
+  writer.write(distortionOffsets);
+  writer.write(distortionParams);
+  writer.write(locked);
+}
+
+void readIntrinsics(SectionReader& reader, sfmData::Intrinsics& intrinsics)
+{
+  std::vector<std::uint32_t> intrinsicIds;
+  std::vector<std::string> types;
+  std::vector<std::uint32_t> widths;
+  std::vector<std::uint32_t> heights;
+  std::vector<std::string> serialNumbers;
+  std::vector<double> pxInitialFocalLengths;
+  std::vector<double> pxFocalLengths;
+  std::vector<double> principalPoints;
+  std::vector<std::uint64_t> distortionOffsets;
+  std::vector<double> distortionParams;
+  std::vector<std::uint8_t> locked;
+
+  reader.read(intrinsicIds);
+  reader.read(types);
+  reader.read(widths);
+  reader.read(heights);
+  reader.read(serialNumbers);
+  reader.read(pxInitialFocalLengths);
+  reader.read(pxFocalLengths);
+  reader.read(principalPoints);
+  reader.read(distortionOffsets);
+  reader.read(distortionParams);
+  reader.read(locked);
+
+  const std::size_t nbIntrinsics = intrinsicIds.size();
+  checkColumnSize(types, nbIntrinsics);
+  checkColumnSize(widths, nbIntrinsics);
+  checkColumnSize(heights, nbIntrinsics);
+  checkColumnSize(serialNumbers, nbIntrinsics);
+  checkColumnSize(pxInitialFocalLengths, nbIntrinsics);
+  checkColumnSize(pxFocalLengths, nbIntrinsics);
+  checkColumnSize(principalPoints, 2 * nbIntrinsics);
+  checkColumnSize(locked, nbIntrinsics);
+  checkOffsets(distortionOffsets, nbIntrinsics, distortionParams.size());
+
+  for(std::size_t i = 0; i < nbIntrinsics; ++i)
+  {
+    const camera::EINTRINSIC intrinsicType = camera::EINTRINSIC_stringToEnum(types[i]);
+
+    // check if the camera is a Pinhole model
+    if(!camera::isPinhole(intrinsicType))
+      throw std::out_of_range("Only Pinhole camera model supported");
+
+    // pinhole parameters
+    std::shared_ptr<camera::Pinhole> pinholeIntrinsic = camera::createPinholeIntrinsic(
+          intrinsicType, widths[i], heights[i], pxFocalLengths[i], principalPoints[2 * i], principalPoints[2 * i + 1]);
+    pinholeIntrinsic->setInitialFocalLengthPix(pxInitialFocalLengths[i]);
+    pinholeIntrinsic->setSerialNumber(serialNumbers[i]);
+
+    std::vector<double> params(distortionParams.begin() + distortionOffsets[i], distortionParams.begin() + distortionOffsets[i + 1]);
+
+    // Ensure that we have the right number of params
+    params.resize(pinholeIntrinsic->getDistortionParams().size(), 0.0);
+    pinholeIntrinsic->setDistortionParams(params);
+
+    std::shared_ptr<camera::IntrinsicBase> intrinsic = std::static_pointer_cast<camera::IntrinsicBase>(pinholeIntrinsic);
+
+    // intrinsic lock
+    if(locked[i])
+      intrinsic->lock();
+    else
+      intrinsic->unlock();
+
+    intrinsics.emplace(intrinsicIds[i], intrinsic);
+  }
+}
+
+void writePoses(const sfmData::Poses& poses, SectionWriter& writer)
+{
+  std::vector<std::uint32_t> poseIds;
+  std::vector<double> rotations;
+  std::vector<double> centers;
+  std::vector<std::uint8_t> locked;
+
+  for(const auto& posePair : poses)
+  {
+    poseIds.push_back(posePair.first);
+    writePose3(posePair.second.getTransform(), rotations, centers);
+    locked.push_back(posePair.second.isLocked());
+  }
+
+  writer.write(poseIds);
+  writer.write(rotations);
+  writer.write(centers);
+  writer.write(locked);
+}
+
+void readPoses(SectionReader& reader, sfmData::Poses& poses)
+{
+  std::vector<std::uint32_t> poseIds;
+  std::vector<double> rotations;
+  std::vector<double> centers;
+  std::vector<std::uint8_t> locked;
+
+  reader.read(poseIds);
+  reader.read(rotations);
+  reader.read(centers);
+  reader.read(locked);
+
+  const std::size_t nbPoses = poseIds.size();
+  checkColumnSize(rotations, 9 * nbPoses);
+  checkColumnSize(centers, 3 * nbPoses);
+  checkColumnSize(locked, nbPoses);
+
+  for(std::size_t i = 0; i < nbPoses; ++i)
+    poses.emplace(poseIds[i], sfmData::CameraPose(readPose3(rotations, centers, i), locked[i] != 0));
+}
+
+void writeRigs(const sfmData::Rigs& rigs, SectionWriter& writer)
+{
+  std::vector<std::uint32_t> rigIds;
+  std::vector<std::uint64_t> subPoseOffsets(1, 0);
+  std::vector<std::uint8_t> statuses;
+  std::vector<double> rotations;
+  std::vector<double> centers;
+
+  for(const auto& rigPair : rigs)
+  {
+    rigIds.push_back(rigPair.first);
+    for(const sfmData::RigSubPose& subPose : rigPair.second.getSubPoses())
+    {
+      statuses.push_back(static_cast<std::uint8_t>(subPose.status));
+      writePose3(subPose.pose, rotations, centers);
+    }
+    subPoseOffsets.push_back(statuses.size());
+  }
+
+  writer.write(rigIds);
+  writer.write(subPoseOffsets);
+  writer.write(statuses);
+  writer.write(rotations);
+  writer.write(centers);
+}
+
+void readRigs(SectionReader& reader, sfmData::Rigs& rigs)
+{
+  std::vector<std::uint32_t> rigIds;
+  std::vector<std::uint64_t> subPoseOffsets;
+  std::vector<std::uint8_t> statuses;
+  std::vector<double> rotations;
+  std::vector<double> centers;
+
+  reader.read(rigIds);
+  reader.read(subPoseOffsets);
+  reader.read(statuses);
+  reader.read(rotations);
+  reader.read(centers);
+
+  const std::size_t nbSubPoses = statuses.size();
+  checkOffsets(subPoseOffsets, rigIds.size(), nbSubPoses);
+  checkColumnSize(rotations, 9 * nbSubPoses);
+  checkColumnSize(centers, 3 * nbSubPoses);
+
+  for(std::size_t i = 0; i < rigIds.size(); ++i)
+  {
+    sfmData::Rig rig(subPoseOffsets[i + 1] - subPoseOffsets[i]);
+    for(std::size_t s = subPoseOffsets[i]; s < subPoseOffsets[i + 1]; ++s)
+    {
+      sfmData::RigSubPose subPose;
+      subPose.status = static_cast<sfmData::ERigSubPoseStatus>(statuses[s]);
+      subPose.pose = readPose3(rotations, centers, s);
+      rig.setSubPose(s - subPoseOffsets[i], subPose);
+    }
+    rigs.emplace(rigIds[i], rig);
+  }
+}
+
+/**
+ * @brief Write landmarks in two sections: the landmarks and their observations,
+ *        in the same order.
+ */
+void writeLandmarks(const sfmData::Landmarks& landmarks, SectionWriter& landmarksWriter, SectionWriter& observationsWriter)
+{
+  std::vector<std::uint32_t> landmarkIds;
+  std::vector<std::uint32_t> descTypes;
+  std::vector<double> positions;
+  std::vector<std::uint8_t> colors;
+
+  std::vector<std::uint64_t> observationOffsets(1, 0);
+  std::vector<std::uint32_t> viewIds;
+  std::vector<std::uint32_t> featureIds;
+  std::vector<double> coordinates;
+
+  landmarkIds.reserve(landmarks.size());
+  descTypes.reserve(landmarks.size());
+  positions.reserve(3 * landmarks.size());
+  colors.reserve(3 * landmarks.size());
+  observationOffsets.reserve(landmarks.size() + 1);
+
+  for(const auto& landmarkPair : landmarks)
+  {
+    const sfmData::Landmark& landmark = landmarkPair.second;
+
+    landmarkIds.push_back(landmarkPair.first);
+    descTypes.push_back(static_cast<std::uint32_t>(landmark.descType));
+    positions.insert(positions.end(), landmark.X.data(), landmark.X.data() + 3);
+    colors.push_back(landmark.rgb.r());
+    colors.push_back(landmark.rgb.g());
+    colors.push_back(landmark.rgb.b());
+
+    for(const auto& observationPair : landmark.observations)
+    {
+      viewIds.push_back(observationPair.first);
+      featureIds.push_back(observationPair.second.id_feat);
+      coordinates.push_back(observationPair.second.x(0));
+      coordinates.push_back(observationPair.second.x(1));
+    }
+    observationOffsets.push_back(viewIds.size());
+  }
+
+  landmarksWriter.write(landmarkIds);
+  landmarksWriter.write(descTypes);
+  landmarksWriter.write(positions);
+  landmarksWriter.write(colors);
+
+  observationsWriter.write(observationOffsets);
+  observationsWriter.write(viewIds);
+  observationsWriter.write(featureIds);
+  observationsWriter.write(coordinates);
+}
+
+/**
+ * @brief Read landmarks without their observations
+ * @param[in] reader the landmarks section reader
+ * @param[out] landmarks the landmarks
+ * @param[out] landmarkIds the landmark ids, in the order of the section
+ */
+void readLandmarks(SectionReader& reader, sfmData::Landmarks& landmarks, std::vector<std::uint32_t>& landmarkIds)
+{
+  std::vector<std::uint32_t> descTypes;
+  std::vector<double> positions;
+  std::vector<std::uint8_t> colors;
+
+  reader.read(landmarkIds);
+  reader.read(descTypes);
+  reader.read(positions);
+  reader.read(colors);
+
+  const std::size_t nbLandmarks = landmarkIds.size();
+  checkColumnSize(descTypes, nbLandmarks);
+  checkColumnSize(positions, 3 * nbLandmarks);
+  checkColumnSize(colors, 3 * nbLandmarks);
+
+  for(std::size_t i = 0; i < nbLandmarks; ++i)
+  {
+    sfmData::Landmark landmark(Vec3(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]),
+                               static_cast<feature::EImageDescriberType>(descTypes[i]),
+                               sfmData::Observations(),
+                               image::RGBColor(colors[3 * i], colors[3 * i + 1], colors[3 * i + 2]));
+    landmarks.emplace(landmarkIds[i], std::move(landmark));
+  }
+}
+
+/**
+ * @brief Read the observations of landmarks already read
+ * @param[in] reader the observations section reader
+ * @param[in] landmarkIds the landmark ids, in the order of the landmarks section
+ * @param[in,out] landmarks the landmarks
+ */
+void readObservations(SectionReader& reader, const std::vector<std::uint32_t>& landmarkIds, sfmData::Landmarks& landmarks)
+{
+  std::vector<std::uint64_t> observationOffsets;
+  std::vector<std::uint32_t> viewIds;
+  std::vector<std::uint32_t> featureIds;
+  std::vector<double> coordinates;
+
+  reader.read(observationOffsets);
+  reader.read(viewIds);
+  reader.read(featureIds);
+  reader.read(coordinates);
+
+  const std::size_t nbObservations = viewIds.size();
+  checkOffsets(observationOffsets, landmarkIds.size(), nbObservations);
+  checkColumnSize(featureIds, nbObservations);
+  checkColumnSize(coordinates, 2 * nbObservations);
+
+  for(std::size_t i = 0; i < landmarkIds.size(); ++i)
+  {
+    sfmData::Observations& observations = landmarks.at(landmarkIds[i]).observations;
+    for(std::size_t o = observationOffsets[i]; o < observationOffsets[i + 1]; ++o)
+      observations.emplace(viewIds[o], sfmData::Observation(Vec2(coordinates[2 * o], coordinates[2 * o + 1]), featureIds[o]));
+  }
+}
+
+/**
+ * @brief Read a section of a binary SfMData file
+ * @note the sections are expected to be in the file (checked when the sections table is read)
+ * @return false if the file has no such section
+ */
+bool readSection(std::ifstream& stream, const std::vector<SfMBSectionEntry>& sections, ESfMBSection type, std::vector<char>& data)
+{
+  for(const SfMBSectionEntry& entry : sections)
+  {
+    if(entry.type != static_cast<std::uint32_t>(type))
+      continue;
+
+    data.resize(entry.size);
+    stream.seekg(entry.offset);
+    stream.read(data.data(), data.size());
+
+    if(!stream)
+      throw std::runtime_error("Truncated binary SfMData file.");
+    return true;
+  }
+  return false;
+}
+
+} // namespace
+
+bool saveSFMB(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // save flags
+  const bool saveViews = (partFlag & VIEWS) == VIEWS;
+  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveObservations = (partFlag & OBSERVATIONS) == OBSERVATIONS;
+  const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+
+  std::vector<std::pair<ESfMBSection, SectionWriter>> sections;
+
+  // folders
+  sections.emplace_back(ESfMBSection::FOLDERS, SectionWriter());
+  writeFolders(sfmData, sections.back().second);
+
+  // views
+  if(saveViews)
+  {
+    sections.emplace_back(ESfMBSection::VIEWS, SectionWriter());
+    writeViews(sfmData.getViews(), sections.back().second);
+  }
+
+  // intrinsics
+  if(saveIntrinsics)
+  {
+    sections.emplace_back(ESfMBSection::INTRINSICS, SectionWriter());
+    writeIntrinsics(sfmData.getIntrinsics(), sections.back().second);
+  }
+
+  // extrinsics
+  if(saveExtrinsics)
+  {
+    sections.emplace_back(ESfMBSection::POSES, SectionWriter());
+    writePoses(sfmData.getPoses(), sections.back().second);
+
+    sections.emplace_back(ESfMBSection::RIGS, SectionWriter());
+    writeRigs(sfmData.getRigs(), sections.back().second);
+  }
+
+  // structure
+  if(saveStructure)
+  {
+    SectionWriter landmarksWriter;
+    SectionWriter observationsWriter;
+    writeLandmarks(sfmData.getLandmarks(), landmarksWriter, observationsWriter);
+
+    sections.emplace_back(ESfMBSection::STRUCTURE, std::move(landmarksWriter));
+    if(saveObservations)
+      sections.emplace_back(ESfMBSection::OBSERVATIONS, std::move(observationsWriter));
+  }
+
+  // control points
+  if(saveControlPoints)
+  {
+    SectionWriter landmarksWriter;
+    SectionWriter observationsWriter;
+    writeLandmarks(sfmData.getControlPoints(), landmarksWriter, observationsWriter);
+
+    sections.emplace_back(ESfMBSection::CONTROL_POINTS, std::move(landmarksWriter));
+    if(saveObservations)
+      sections.emplace_back(ESfMBSection::CONTROL_POINTS_OBSERVATIONS, std::move(observationsWriter));
+  }
+
+  // sections table
+  SfMBFileHeader header;
+  header.nbSections = sections.size();
+
+  std::vector<SfMBSectionEntry> table(sections.size());
+  std::uint64_t offset = sizeof(SfMBFileHeader) + table.size() * sizeof(SfMBSectionEntry);
+  for(std::size_t i = 0; i < sections.size(); ++i)
+  {
+    table[i].type = static_cast<std::uint32_t>(sections[i].first);
+    table[i].offset = offset;
+    table[i].size = sections[i].second.data().size();
+    offset += table[i].size;
+  }
+
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary);
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Cannot open the binary SfMData file: " << filename);
+    return false;
+  }
+
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(SfMBFileHeader));
+  stream.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(SfMBSectionEntry));
+  for(const auto& section : sections)
+    stream.write(section.second.data().data(), section.second.data().size());
+
+  return stream.good();
+}
+
+bool loadSFMB(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // load flags
+  const bool loadViews = (partFlag & VIEWS) == VIEWS;
+  const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool loadExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool loadObservations = (partFlag & OBSERVATIONS) == OBSERVATIONS;
+  const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Cannot open the binary SfMData file: " << filename);
+    return false;
+  }
+
+  SfMBFileHeader header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(SfMBFileHeader));
+
+  if(!stream || header.fileMagic != SfMBFileHeader::magic)
+  {
+    ALICEVISION_LOG_ERROR("Invalid binary SfMData file: " << filename);
+    return false;
+  }
+
+  if(header.version > SfMBFileHeader::currentVersion)
+  {
+    ALICEVISION_LOG_ERROR("Unsupported binary SfMData file version (" << header.version << "): " << filename);
+    return false;
+  }
+
+  try
+  {
+    // read the sections table, the header and the table entries are checked against the file size
+    // before any allocation, so a corrupted file cannot lead to huge allocations
+    stream.seekg(0, std::ios::end);
+    const std::uint64_t fileSize = static_cast<std::uint64_t>(stream.tellg());
+    stream.seekg(sizeof(SfMBFileHeader));
+
+    if(!stream || header.nbSections > (fileSize - sizeof(SfMBFileHeader)) / sizeof(SfMBSectionEntry))
+      throw std::runtime_error("Invalid binary SfMData file sections table.");
+
+    std::vector<SfMBSectionEntry> table(header.nbSections);
+    stream.read(reinterpret_cast<char*>(table.data()), table.size() * sizeof(SfMBSectionEntry));
+
+    if(!stream)
+      throw std::runtime_error("Invalid binary SfMData file sections table.");
+
+    for(const SfMBSectionEntry& entry : table)
+    {
+      if(entry.offset > fileSize || entry.size > fileSize - entry.offset)
+        throw std::runtime_error("Invalid binary SfMData file section: out of the file.");
+    }
+
+    // only read the requested sections
+    std::vector<char> data;
+
+    if(readSection(stream, table, ESfMBSection::FOLDERS, data))
+    {
+      SectionReader reader(data);
+      readFolders(reader, sfmData);
+    }
+
+    if(loadIntrinsics && readSection(stream, table, ESfMBSection::INTRINSICS, data))
+    {
+      SectionReader reader(data);
+      readIntrinsics(reader, sfmData.getIntrinsics());
+    }
+
+    if(loadViews && readSection(stream, table, ESfMBSection::VIEWS, data))
+    {
+      SectionReader reader(data);
+      readViews(reader, sfmData.getViews());
+    }
+
+    if(loadExtrinsics)
+    {
+      if(readSection(stream, table, ESfMBSection::POSES, data))
+      {
+        SectionReader reader(data);
+        readPoses(reader, sfmData.getPoses());
+      }
+
+      if(readSection(stream, table, ESfMBSection::RIGS, data))
+      {
+        SectionReader reader(data);
+        readRigs(reader, sfmData.getRigs());
+      }
+    }
+
+    if(loadStructure && readSection(stream, table, ESfMBSection::STRUCTURE, data))
+    {
+      std::vector<std::uint32_t> landmarkIds;
+      {
+        SectionReader reader(data);
+        readLandmarks(reader, sfmData.getLandmarks(), landmarkIds);
+      }
+
+      if(loadObservations && readSection(stream, table, ESfMBSection::OBSERVATIONS, data))
+      {
+        SectionReader reader(data);
+        readObservations(reader, landmarkIds, sfmData.getLandmarks());
+      }
+    }
+
+    if(loadControlPoints && readSection(stream, table, ESfMBSection::CONTROL_POINTS, data))
+    {
+      std::vector<std::uint32_t> landmarkIds;
+      {
+        SectionReader reader(data);
+        readLandmarks(reader, sfmData.getControlPoints(), landmarkIds);
+      }
+
+      if(loadObservations && readSection(stream, table, ESfMBSection::CONTROL_POINTS_OBSERVATIONS, data))
+      {
+        SectionReader reader(data);
+        readObservations(reader, landmarkIds, sfmData.getControlPoints());
+      }
+    }
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR("Cannot read the binary SfMData file: " << filename << std::endl << e.what());
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
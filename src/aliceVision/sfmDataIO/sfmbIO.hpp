@@ -0,0 +1,49 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+
+#include <string>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+// AliceVision binary SfMData file (.sfmb):
+// -- Header
+// magic "AVSB", version, #sections
+// -- Sections table
+// [section type, offset, size] (one entry per section)
+// -- Sections
+// folders, views, intrinsics, poses, rigs, structure, observations, control points, control points observations
+// --
+// Each section is a sequence of typed columns (one array per field: ids, positions, ...),
+// stored as a number of elements followed by the raw little-endian values.
+// The observations of the landmarks are stored in their own section,
+// so the sections skipped by the ESfMData load flag are never read.
+
+/**
+ * @brief Save an SfMData in a binary file (.sfmb).
+ * @param[in] sfmData The input SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData save flag
+ * @return true if completed
+ */
+bool saveSFMB(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+/**
+ * @brief Load a binary SfMData file (.sfmb).
+ *        Only the sections requested by the ESfMData flag are read.
+ * @param[out] sfmData The output SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData load flag
+ * @return true if completed
+ */
+bool loadSFMB(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -7,80 +7,228 @@
 
 #include "Track.hpp"
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
 namespace aliceVision {
 namespace track {
 
 using namespace aliceVision::matching;
-using namespace lemon;
+
+namespace {
+
+/// contiguous range of the features of a view for a describer type
+struct FeaturesBlock
+{
+  IndexT viewId;
+  feature::EImageDescriberType descType;
+  /// index of the first feature of the block
+  std::size_t offset;
+  /// number of features of the block (max feature index referenced + 1)
+  std::size_t size;
+};
+
+/// matches between two views for a describer type
+struct PairMatches
+{
+  const IndMatches* matches;
+  std::size_t blockI;
+  std::size_t blockJ;
+};
+
+typedef std::vector<std::atomic<std::uint32_t>> ParentsVector;
+
+/**
+ * @brief Return the representative of the set of a feature.
+ *        The paths are compressed (path halving), concurrent calls are safe.
+ */
+std::uint32_t findRoot(ParentsVector& parents, std::uint32_t node)
+{
+  while(true)
+  {
+    std::uint32_t parent = parents[node].load();
+    if(parent == node)
+      return node;
+    const std::uint32_t grandParent = parents[parent].load();
+    // path halving, it does not matter if another thread changed the parent in the meantime
+    if(parent != grandParent)
+      parents[node].compare_exchange_weak(parent, grandParent);
+    node = grandParent;
+  }
+}
+
+/**
+ * @brief Merge the sets of two features, concurrent calls are safe.
+ *        The parent of a feature always has a smaller index, so the representative of a set
+ *        is its smallest feature whatever the order of the unions.
+ */
+void uniteRoots(ParentsVector& parents, std::uint32_t nodeA, std::uint32_t nodeB)
+{
+  while(true)
+  {
+    nodeA = findRoot(parents, nodeA);
+    nodeB = findRoot(parents, nodeB);
+    if(nodeA == nodeB)
+      return;
+    if(nodeA < nodeB)
+      std::swap(nodeA, nodeB);
+    // retry if nodeA is not a representative anymore
+    std::uint32_t expected = nodeA;
+    if(parents[nodeA].compare_exchange_strong(expected, nodeB))
+      return;
+  }
+}
+
+} // namespace
 
 void TracksBuilder::build(const PairwiseMatches& pairwiseMatches)
 {
-  typedef std::set<IndexedFeaturePair> SetIndexedPair;
+  _tracks.clear();
 
-  // set of all features of all images: (imageIndex, featureIndex)
-  SetIndexedPair allFeatures;
+  // list the matches and the referenced features blocks
+  typedef std::pair<IndexT, feature::EImageDescriberType> BlockKey;
+  std::map<BlockKey, std::size_t> blockIndexes;
+  std::vector<std::pair<BlockKey, BlockKey>> pairsBlocks;
+  std::vector<PairMatches> allMatches;
 
-  // for each couple of images make the union according the pair matches
   for(const auto& matchesPerDescIt: pairwiseMatches)
   {
-    const std::size_t& I = matchesPerDescIt.first.first;
-    const std::size_t& J = matchesPerDescIt.first.second;
+    const IndexT I = matchesPerDescIt.first.first;
+    const IndexT J = matchesPerDescIt.first.second;
     const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
 
     for(const auto& matchesIt: matchesPerDesc)
     {
-      const feature::EImageDescriberType descType = matchesIt.first;
-      const IndMatches& matches = matchesIt.second;
-      // we have correspondences between I and J image index.
-      for(const IndMatch& m: matches)
-      {
-        IndexedFeaturePair pairI(I, KeypointId(descType, m._i));
-        IndexedFeaturePair pairJ(J, KeypointId(descType, m._j));
-        allFeatures.insert(pairI);
-        allFeatures.insert(pairJ);
-      }
+      if(matchesIt.second.empty())
+        continue;
+      const BlockKey blockI(I, matchesIt.first);
+      const BlockKey blockJ(J, matchesIt.first);
+      blockIndexes[blockI] = 0;
+      blockIndexes[blockJ] = 0;
+      pairsBlocks.emplace_back(blockI, blockJ);
+      allMatches.push_back({&matchesIt.second, 0, 0});
     }
   }
 
-  // build the node indirection for each referenced feature
-  MapIndexToNode map_indexToNode;
-  map_indexToNode.reserve(allFeatures.size());
-  _map_nodeToIndex.reserve(allFeatures.size());
+  std::vector<FeaturesBlock> blocks;
+  blocks.reserve(blockIndexes.size());
+  for(auto& blockIndex: blockIndexes)
+  {
+    blockIndex.second = blocks.size();
+    blocks.push_back({blockIndex.first.first, blockIndex.first.second, 0, 0});
+  }
+
+  // size of each block: max referenced feature index + 1
+  const std::int64_t nbPairs = allMatches.size();
+  std::vector<std::pair<std::size_t, std::size_t>> pairsSizes(nbPairs, {0, 0});
 
-  for(const IndexedFeaturePair& featPair: allFeatures)
+  #pragma omp parallel for schedule(dynamic)
+  for(std::int64_t p = 0; p < nbPairs; ++p)
   {
-    lemon::ListDigraph::Node node = _graph.addNode();
-    map_indexToNode.insert(std::make_pair(featPair, node));
-    _map_nodeToIndex.insert(std::make_pair(node, featPair));
+    std::pair<std::size_t, std::size_t>& sizes = pairsSizes[p];
+    for(const IndMatch& m: *allMatches[p].matches)
+    {
+      sizes.first = std::max(sizes.first, static_cast<std::size_t>(m._i) + 1);
+      sizes.second = std::max(sizes.second, static_cast<std::size_t>(m._j) + 1);
+    }
   }
 
-  // add the element of myset to the UnionFind insert method.
-  _index = std::unique_ptr<IndexMap>( new IndexMap(_graph) );
-  _tracksUF = std::unique_ptr<UnionFindObject>(new UnionFindObject(*_index));
+  for(std::int64_t p = 0; p < nbPairs; ++p)
+  {
+    PairMatches& pairMatches = allMatches[p];
+    pairMatches.blockI = blockIndexes.at(pairsBlocks[p].first);
+    pairMatches.blockJ = blockIndexes.at(pairsBlocks[p].second);
+    blocks[pairMatches.blockI].size = std::max(blocks[pairMatches.blockI].size, pairsSizes[p].first);
+    blocks[pairMatches.blockJ].size = std::max(blocks[pairMatches.blockJ].size, pairsSizes[p].second);
+  }
+  pairsBlocks.clear();
+  pairsSizes.clear();
 
-  for(ListDigraph::NodeIt it(_graph); it != INVALID; ++it)
+  // dense index of the features: blocks in (viewId, descType) order, then feature index
+  std::size_t nbFeatures = 0;
+  for(FeaturesBlock& block: blocks)
   {
-    _tracksUF->insert(it);
+    block.offset = nbFeatures;
+    nbFeatures += block.size;
   }
 
-  // make the union according the pair matches
-  for(const auto& matchesPerDescIt: pairwiseMatches)
+  if(nbFeatures >= std::numeric_limits<std::uint32_t>::max())
+    throw std::runtime_error("Too many features to build the tracks: " + std::to_string(nbFeatures));
+
+  // union-find of the matched features
+  ParentsVector parents(nbFeatures);
+
+  #pragma omp parallel for
+  for(std::int64_t i = 0; i < static_cast<std::int64_t>(nbFeatures); ++i)
+    parents[i].store(static_cast<std::uint32_t>(i));
+
+  #pragma omp parallel for schedule(dynamic)
+  for(std::int64_t p = 0; p < nbPairs; ++p)
   {
-    const std::size_t& I = matchesPerDescIt.first.first;
-    const std::size_t& J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
+    const PairMatches& pairMatches = allMatches[p];
+    const std::size_t offsetI = blocks[pairMatches.blockI].offset;
+    const std::size_t offsetJ = blocks[pairMatches.blockJ].offset;
 
-    for(const auto& matchesIt: matchesPerDesc)
+    for(const IndMatch& m: *pairMatches.matches)
+      uniteRoots(parents, static_cast<std::uint32_t>(offsetI + m._i), static_cast<std::uint32_t>(offsetJ + m._j));
+  }
+  allMatches.clear();
+
+  std::vector<std::uint32_t> roots(nbFeatures);
+
+  #pragma omp parallel for
+  for(std::int64_t i = 0; i < static_cast<std::int64_t>(nbFeatures); ++i)
+    roots[i] = findRoot(parents, static_cast<std::uint32_t>(i));
+
+  ParentsVector().swap(parents);
+
+  // number of features of each set, then track id of each set
+  // a feature alone in its set is not referenced by the matches
+  const std::uint32_t invalidTrackId = std::numeric_limits<std::uint32_t>::max();
+  std::vector<std::uint32_t> setTrackIds(nbFeatures, 0);
+
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+    ++setTrackIds[roots[i]];
+
+  // tracks ordered by their first feature
+  for(const FeaturesBlock& block: blocks)
+  {
+    for(std::size_t i = block.offset; i < block.offset + block.size; ++i)
     {
-      const feature::EImageDescriberType descType = matchesIt.first;
-      const IndMatches& matches = matchesIt.second;
-      // we have correspondences between I and J image index.
-      for(const IndMatch& m: matches)
+      if(roots[i] != i)
+        continue;
+      if(setTrackIds[i] < 2)
       {
-        IndexedFeaturePair pairI(I, KeypointId(descType, m._i));
-        IndexedFeaturePair pairJ(J, KeypointId(descType, m._j));
-        _tracksUF->join(map_indexToNode[pairI], map_indexToNode[pairJ]);
+        setTrackIds[i] = invalidTrackId;
+        continue;
       }
+      _tracks.offsets.push_back(_tracks.offsets.back() + setTrackIds[i]);
+      _tracks.descTypes.push_back(block.descType);
+      setTrackIds[i] = static_cast<std::uint32_t>(_tracks.descTypes.size() - 1);
+    }
+  }
+
+  // observations of each track, sorted by view id
+  const std::size_t nbObservations = _tracks.offsets.back();
+  _tracks.viewIds.resize(nbObservations);
+  _tracks.featIds.resize(nbObservations);
+
+  std::vector<std::size_t> trackPos(_tracks.offsets.begin(), _tracks.offsets.end() - 1);
+
+  for(const FeaturesBlock& block: blocks)
+  {
+    for(std::size_t featId = 0; featId < block.size; ++featId)
+    {
+      const std::uint32_t trackId = setTrackIds[roots[block.offset + featId]];
+      if(trackId == invalidTrackId)
+        continue;
+      const std::size_t pos = trackPos[trackId]++;
+      _tracks.viewIds[pos] = block.viewId;
+      _tracks.featIds[pos] = static_cast<IndexT>(featId);
     }
   }
 }
@@ -91,49 +239,53 @@ void TracksBuilder::filter(std::size_t minTrackLength, bool multithreaded)
   // - track that are too short,
   // - track with id conflicts (many times the same image index)
 
-  std::set<int> set_classToErase;
+  const std::int64_t nbTracks = _tracks.nbTracks();
+  std::vector<unsigned char> validTracks(nbTracks, 0);
 
-#pragma omp parallel if(multithreaded)
-  for(lemon::UnionFindEnum<IndexMap>::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
+  #pragma omp parallel for if(multithreaded)
+  for(std::int64_t t = 0; t < nbTracks; ++t)
   {
+    if(_tracks.trackLength(t) < minTrackLength)
+      continue;
+    // the observations are sorted by view id
+    const auto viewsBegin = _tracks.viewIds.begin() + _tracks.offsets[t];
+    const auto viewsEnd = _tracks.viewIds.begin() + _tracks.offsets[t + 1];
+    validTracks[t] = (std::adjacent_find(viewsBegin, viewsEnd) == viewsEnd);
+  }
 
-#pragma omp single nowait
-    {
-      std::size_t cpt = 0;
-      std::set<std::size_t> myset;
-      for(lemon::UnionFindEnum<IndexMap>::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
-      {
-        myset.insert(_map_nodeToIndex[iit].first);
-        ++cpt;
-      }
-      if(myset.size() != cpt || myset.size() < minTrackLength)
-      {
-#pragma omp critical
-        set_classToErase.insert(cit.operator int());
-      }
-    }
+  // remove the invalid tracks in place
+  std::size_t nbValidTracks = 0;
+  std::size_t nbValidObservations = 0;
+
+  for(std::int64_t t = 0; t < nbTracks; ++t)
+  {
+    if(!validTracks[t])
+      continue;
+    const std::size_t begin = _tracks.offsets[t];
+    const std::size_t end = _tracks.offsets[t + 1];
+    std::copy(_tracks.viewIds.begin() + begin, _tracks.viewIds.begin() + end, _tracks.viewIds.begin() + nbValidObservations);
+    std::copy(_tracks.featIds.begin() + begin, _tracks.featIds.begin() + end, _tracks.featIds.begin() + nbValidObservations);
+    nbValidObservations += end - begin;
+    _tracks.descTypes[nbValidTracks] = _tracks.descTypes[t];
+    _tracks.offsets[++nbValidTracks] = nbValidObservations;
   }
 
-  std::for_each(set_classToErase.begin(), set_classToErase.end(),
-    std::bind1st(std::mem_fun(&UnionFindObject::eraseClass), _tracksUF.get()));
+  _tracks.offsets.resize(nbValidTracks + 1);
+  _tracks.descTypes.resize(nbValidTracks);
+  _tracks.viewIds.resize(nbValidObservations);
+  _tracks.featIds.resize(nbValidObservations);
 }
 
 bool TracksBuilder::exportToStream(std::ostream& os)
 {
-  std::size_t cpt = 0;
-  for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
+  for(std::size_t t = 0; t < _tracks.nbTracks(); ++t)
   {
-    os << "Class: " << cpt++ << std::endl;
-    std::size_t cptTrackLength = 0;
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
-    {
-      ++cptTrackLength;
-    }
-    os << "\t" << "track length: " << cptTrackLength << std::endl;
+    os << "Class: " << t << std::endl;
+    os << "\t" << "track length: " << _tracks.trackLength(t) << std::endl;
 
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
+    for(std::size_t i = _tracks.offsets[t]; i < _tracks.offsets[t + 1]; ++i)
     {
-      os << _map_nodeToIndex[ iit ].first << "  " << _map_nodeToIndex[ iit ].second << std::endl;
+      os << _tracks.viewIds[i] << "  " << KeypointId(_tracks.descTypes[t], _tracks.featIds[i]) << std::endl;
     }
   }
   return os.good();
@@ -141,26 +293,151 @@ bool TracksBuilder::exportToStream(std::ostream& os)
 
 void TracksBuilder::exportToSTL(TracksMap& allTracks) const
 {
-  allTracks.clear();
+  _tracks.toTracksMap(allTracks);
+}
 
-  std::size_t trackIndex = 0;
-  for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit, ++trackIndex)
+void TracksBuilder::exportToCSR(TracksCSR& allTracks) const
+{
+  allTracks = _tracks;
+  allTracks.computeViewsIndex();
+}
+
+bool TracksCSR::getFeatureId(std::size_t trackId, IndexT viewId, IndexT& featId) const
+{
+  // the observations of a track are sorted by view id
+  const auto begin = viewIds.begin() + offsets[trackId];
+  const auto end = viewIds.begin() + offsets[trackId + 1];
+  const auto it = std::lower_bound(begin, end, viewId);
+  if(it == end || *it != viewId)
+    return false;
+  featId = featIds[std::distance(viewIds.begin(), it)];
+  return true;
+}
+
+void TracksCSR::computeViewsIndex()
+{
+  // number of observations per view
+  std::unordered_map<IndexT, std::size_t> viewIndexes;
+  for(IndexT viewId: viewIds)
+    ++viewIndexes[viewId];
+
+  views.clear();
+  views.reserve(viewIndexes.size());
+  for(const auto& viewIt: viewIndexes)
+    views.push_back(viewIt.first);
+  std::sort(views.begin(), views.end());
+
+  viewOffsets.assign(views.size() + 1, 0);
+  for(std::size_t v = 0; v < views.size(); ++v)
+  {
+    std::size_t& viewIndex = viewIndexes.at(views[v]);
+    viewOffsets[v + 1] = viewOffsets[v] + viewIndex;
+    viewIndex = v;
+  }
+
+  // tracks are visited in increasing order, so the tracks of each view are sorted
+  viewTrackIds.resize(viewIds.size());
+  viewFeatIds.resize(viewIds.size());
+  std::vector<std::size_t> viewPos(viewOffsets.begin(), viewOffsets.end() - 1);
+
+  for(std::size_t t = 0; t < nbTracks(); ++t)
   {
-    // create the output track
-    std::pair<TracksMap::iterator, bool> ret = allTracks.insert(std::make_pair(trackIndex, Track()));
+    for(std::size_t i = offsets[t]; i < offsets[t + 1]; ++i)
+    {
+      const std::size_t pos = viewPos[viewIndexes.at(viewIds[i])]++;
+      viewTrackIds[pos] = static_cast<IndexT>(t);
+      viewFeatIds[pos] = featIds[i];
+    }
+  }
+}
 
-    Track& outTrack = ret.first->second;
+bool TracksCSR::getViewIndex(IndexT viewId, std::size_t& viewIndex) const
+{
+  const auto it = std::lower_bound(views.begin(), views.end(), viewId);
+  if(it == views.end() || *it != viewId)
+    return false;
+  viewIndex = std::distance(views.begin(), it);
+  return true;
+}
 
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
+ArrayRange<IndexT> TracksCSR::viewTracks(IndexT viewId) const
+{
+  std::size_t v;
+  if(!getViewIndex(viewId, v))
+    return ArrayRange<IndexT>();
+  return ArrayRange<IndexT>(viewTrackIds.data() + viewOffsets[v], viewTrackIds.data() + viewOffsets[v + 1]);
+}
+
+ArrayRange<IndexT> TracksCSR::viewFeatures(IndexT viewId) const
+{
+  std::size_t v;
+  if(!getViewIndex(viewId, v))
+    return ArrayRange<IndexT>();
+  return ArrayRange<IndexT>(viewFeatIds.data() + viewOffsets[v], viewFeatIds.data() + viewOffsets[v + 1]);
+}
+
+void TracksCSR::getCommonTracks(IndexT viewI, IndexT viewJ, std::vector<CommonTrack>& commonTracks) const
+{
+  commonTracks.clear();
+
+  const ArrayRange<IndexT> tracksI = viewTracks(viewI);
+  const ArrayRange<IndexT> tracksJ = viewTracks(viewJ);
+  const ArrayRange<IndexT> featsI = viewFeatures(viewI);
+  const ArrayRange<IndexT> featsJ = viewFeatures(viewJ);
+
+  // intersection of the sorted track ids
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while(i < tracksI.size() && j < tracksJ.size())
+  {
+    if(tracksI[i] < tracksJ[j])
+      ++i;
+    else if(tracksJ[j] < tracksI[i])
+      ++j;
+    else
     {
-      const IndexedFeaturePair & currentPair = _map_nodeToIndex.at(iit);
-      // all descType inside the track will be the same
-      outTrack.descType = currentPair.second.descType;
-      outTrack.featPerView[currentPair.first] = currentPair.second.featIndex;
+      commonTracks.push_back({tracksI[i], featsI[i], featsJ[j]});
+      ++i;
+      ++j;
     }
   }
 }
 
+void TracksCSR::toTracksMap(TracksMap& tracksMap) const
+{
+  tracksMap.clear();
+
+  const std::int64_t nbTracks = this->nbTracks();
+  tracksMap.reserve(nbTracks);
+
+  for(std::int64_t t = 0; t < nbTracks; ++t)
+    tracksMap.emplace_hint(tracksMap.end(), t, Track());
+
+  #pragma omp parallel for
+  for(std::int64_t t = 0; t < nbTracks; ++t)
+  {
+    Track& outTrack = (tracksMap.begin() + t)->second;
+    outTrack.descType = descTypes[t];
+    outTrack.featPerView.reserve(trackLength(t));
+
+    // the observations are sorted by view id
+    for(std::size_t i = offsets[t]; i < offsets[t + 1]; ++i)
+      outTrack.featPerView.emplace_hint(outTrack.featPerView.end(), viewIds[i], featIds[i]);
+  }
+}
+
+std::size_t TracksCSR::memorySize() const
+{
+  return offsets.capacity() * sizeof(std::size_t) +
+         viewIds.capacity() * sizeof(IndexT) +
+         featIds.capacity() * sizeof(IndexT) +
+         descTypes.capacity() * sizeof(feature::EImageDescriberType) +
+         views.capacity() * sizeof(IndexT) +
+         viewOffsets.capacity() * sizeof(std::size_t) +
+         viewTrackIds.capacity() * sizeof(IndexT) +
+         viewFeatIds.capacity() * sizeof(IndexT);
+}
+
 namespace tracksUtilsMap {
 
 bool getCommonTracksInImages(const std::set<std::size_t>& imageIndexes,
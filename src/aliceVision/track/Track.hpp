@@ -8,15 +8,14 @@
 #pragma once
 
 #include <aliceVision/config.hpp>
+#include <aliceVision/types.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/stl/FlatMap.hpp>
 #include <aliceVision/stl/FlatSet.hpp>
 
-#include <lemon/list_graph.h>
-#include <lemon/unionfind.h>
-
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <functional>
 #include <vector>
@@ -28,7 +27,6 @@ namespace aliceVision {
 namespace track {
 
 using namespace aliceVision::matching;
-using namespace lemon;
 
 /**
  * @brief A Track is a feature visible accross multiple views.
@@ -101,6 +99,132 @@ inline std::ostream& operator<<(std::ostream& os, const KeypointId& k)
     return os;
 }
 
+/**
+ * @brief Read-only view on a contiguous range of an array.
+ */
+template <typename T>
+class ArrayRange
+{
+public:
+  ArrayRange() {}
+  ArrayRange(const T* begin, const T* end)
+    : _begin(begin)
+    , _end(end)
+  {}
+
+  const T* begin() const { return _begin; }
+  const T* end() const { return _end; }
+  std::size_t size() const { return static_cast<std::size_t>(_end - _begin); }
+  bool empty() const { return _begin == _end; }
+  const T& operator[](std::size_t i) const { return _begin[i]; }
+
+private:
+  const T* _begin = nullptr;
+  const T* _end = nullptr;
+};
+
+/**
+ * @brief Tracks stored in a compressed sparse row layout.
+ *
+ * The observations of the track i are in [offsets[i], offsets[i+1]) of viewIds and featIds,
+ * sorted by increasing view id. All the observations of a track have the same describer type.
+ *
+ * The views index (computeViewsIndex) is the inverted layout: the observations of each view,
+ * sorted by increasing track id.
+ */
+struct TracksCSR
+{
+  /// observations range of each track (size: number of tracks + 1)
+  std::vector<std::size_t> offsets{0};
+  /// view id of each observation
+  std::vector<IndexT> viewIds;
+  /// feature index of each observation
+  std::vector<IndexT> featIds;
+  /// describer type of each track
+  std::vector<feature::EImageDescriberType> descTypes;
+
+  /// sorted ids of the views with observations
+  std::vector<IndexT> views;
+  /// observations range of each view in viewTrackIds and viewFeatIds (size: number of views + 1)
+  std::vector<std::size_t> viewOffsets{0};
+  /// track id of each observation, per view
+  std::vector<IndexT> viewTrackIds;
+  /// feature index of each observation, per view
+  std::vector<IndexT> viewFeatIds;
+
+  /// observations of two views for a common track
+  struct CommonTrack
+  {
+    IndexT trackId;
+    IndexT featI;
+    IndexT featJ;
+  };
+
+  std::size_t nbTracks() const { return offsets.size() - 1; }
+  std::size_t trackLength(std::size_t trackId) const { return offsets[trackId + 1] - offsets[trackId]; }
+
+  /// sorted view ids of a track
+  ArrayRange<IndexT> trackViewIds(std::size_t trackId) const
+  {
+    return ArrayRange<IndexT>(viewIds.data() + offsets[trackId], viewIds.data() + offsets[trackId + 1]);
+  }
+
+  /// feature indexes of a track, in the order of trackViewIds
+  ArrayRange<IndexT> trackFeatIds(std::size_t trackId) const
+  {
+    return ArrayRange<IndexT>(featIds.data() + offsets[trackId], featIds.data() + offsets[trackId + 1]);
+  }
+
+  /**
+   * @brief Get the feature index of a track in a view
+   * @return false if the track is not observed by the view
+   */
+  bool getFeatureId(std::size_t trackId, IndexT viewId, IndexT& featId) const;
+
+  /**
+   * @brief Build the views index from the tracks
+   */
+  void computeViewsIndex();
+
+  /**
+   * @brief Get the position of a view in the views index
+   * @return false if the view has no observation
+   */
+  bool getViewIndex(IndexT viewId, std::size_t& viewIndex) const;
+
+  /// sorted track ids of a view (empty if the view has no observation)
+  ArrayRange<IndexT> viewTracks(IndexT viewId) const;
+
+  /// feature indexes of a view, in the order of viewTracks
+  ArrayRange<IndexT> viewFeatures(IndexT viewId) const;
+
+  /**
+   * @brief Get the tracks observed by two views
+   * @param[in] viewI first view id
+   * @param[in] viewJ second view id
+   * @param[out] commonTracks the common tracks, sorted by track id
+   */
+  void getCommonTracks(IndexT viewI, IndexT viewJ, std::vector<CommonTrack>& commonTracks) const;
+
+  /// Convert to a map of tracks
+  void toTracksMap(TracksMap& tracksMap) const;
+
+  /// Memory size of the arrays (in bytes)
+  std::size_t memorySize() const;
+
+  void clear()
+  {
+    offsets.assign(1, 0);
+    viewIds.clear();
+    featIds.clear();
+    descTypes.clear();
+    views.clear();
+    viewOffsets.assign(1, 0);
+    viewTrackIds.clear();
+    viewFeatIds.clear();
+  }
+};
+
 /**
  * @brief Allows to create Tracks from a set of Matches accross Views.
  *
@@ -115,6 +239,10 @@ inline std::ostream& operator<<(std::ostream& os, const KeypointId& k)
  *
  * From map< [imageI,ImageJ], [indexed matches array] > it builds tracks.
  *
+ * The features are densely indexed by (viewId, descType, featureId) in contiguous arrays
+ * and merged by a lock-free union-find shared by the threads.
+ * The tracks are ordered by their first feature, so the result does not depend on the number of threads.
+ *
  * Usage:
  * @code{.cpp}
  *  PairWiseMatches matches;
@@ -129,31 +257,6 @@ inline std::ostream& operator<<(std::ostream& os, const KeypointId& k)
  */
 struct TracksBuilder
 {
-  /// IndexedFeaturePair is: map<viewId, keypointId>
-  typedef std::pair<std::size_t, KeypointId> IndexedFeaturePair;
-  typedef ListDigraph::NodeMap<std::size_t> IndexMap;
-  typedef lemon::UnionFindEnum< IndexMap > UnionFindObject;
-
-  typedef stl::flat_map< lemon::ListDigraph::Node, IndexedFeaturePair> MapNodeToIndex;
-  typedef stl::flat_map< IndexedFeaturePair, lemon::ListDigraph::Node > MapIndexToNode;
-
-  /// graph container to create the node
-  lemon::ListDigraph _graph;
-  /// node to index map
-  MapNodeToIndex _map_nodeToIndex;
-  std::unique_ptr<IndexMap> _index;
-  std::unique_ptr<UnionFindObject> _tracksUF;
-
-  const UnionFindObject& getUnionFindEnum() const
-  {
-    return *_tracksUF;
-  }
-
-  const MapNodeToIndex& getReverseMap() const
-  {
-    return _map_nodeToIndex;
-  }
-
   /**
    * @brief Build tracks for a given series of pairWise matches
    * @param[in] pairwiseMatches PairWise matches
@@ -181,16 +284,22 @@ struct TracksBuilder
   void exportToSTL(TracksMap& allTracks) const;
 
   /**
-   * @brief Return the number of connected set in the UnionFind structure (tree forest)
-   * @return number of connected set in the UnionFind structure
+   * @brief Export tracks in a compressed sparse row layout, with the views index
+   */
+  void exportToCSR(TracksCSR& allTracks) const;
+
+  /**
+   * @brief Return the number of tracks
+   * @return number of tracks
    */
   std::size_t nbTracks() const
   {
-    std::size_t cpt = 0;
-    for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
-      ++cpt;
-    return cpt;
+    return _tracks.nbTracks();
   }
+
+private:
+  /// tracks built from the matches
+  TracksCSR _tracks;
 };
 
 namespace tracksUtilsMap {
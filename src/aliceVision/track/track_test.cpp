@@ -7,7 +7,12 @@
 
 #include "aliceVision/track/Track.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
+#include "aliceVision/system/Logger.hpp"
+#include "aliceVision/system/Timer.hpp"
 
+#include <cstddef>
+#include <random>
+#include <set>
 #include <vector>
 #include <utility>
 
@@ -226,3 +231,319 @@ BOOST_AUTO_TEST_CASE(Track_GetCommonTracksInImages)
     BOOST_CHECK_EQUAL(base.size(), set_visibleTracks.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(Track_CSR)
+{
+  //A    B    C
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6
+  //2 -> 3
+  PairwiseMatches map_pairwisematches;
+  map_pairwisematches[std::make_pair(0, 1)][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,1), IndMatch(2,3)};
+  map_pairwisematches[std::make_pair(1, 2)][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,6)};
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches);
+  trackBuilder.filter(3);
+
+  TracksCSR tracks;
+  trackBuilder.exportToCSR(tracks);
+
+  BOOST_CHECK_EQUAL(2, tracks.nbTracks());
+  const std::vector<std::size_t> offsets{0, 3, 6};
+  const std::vector<aliceVision::IndexT> viewIds{0, 1, 2, 0, 1, 2};
+  const std::vector<aliceVision::IndexT> featIds{0, 0, 0, 1, 1, 6};
+  BOOST_CHECK(tracks.offsets == offsets);
+  BOOST_CHECK(tracks.viewIds == viewIds);
+  BOOST_CHECK(tracks.featIds == featIds);
+  BOOST_CHECK(tracks.descTypes[0] == EImageDescriberType::UNKNOWN);
+  BOOST_CHECK(tracks.descTypes[1] == EImageDescriberType::UNKNOWN);
+}
+
+BOOST_AUTO_TEST_CASE(Track_DescriberTypes)
+{
+  // features of different describer types are never in the same track
+  PairwiseMatches map_pairwisematches;
+  map_pairwisematches[std::make_pair(0, 1)][EImageDescriberType::SIFT] = {IndMatch(0,0), IndMatch(1,1)};
+  map_pairwisematches[std::make_pair(0, 1)][EImageDescriberType::AKAZE] = {IndMatch(0,0)};
+  map_pairwisematches[std::make_pair(1, 2)][EImageDescriberType::AKAZE] = {IndMatch(0,5)};
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches);
+  BOOST_CHECK_EQUAL(3, trackBuilder.nbTracks());
+
+  TracksMap map_tracks;
+  trackBuilder.exportToSTL(map_tracks);
+
+  std::size_t nbSiftTracks = 0;
+  for(const auto& trackIt: map_tracks)
+  {
+    const Track& track = trackIt.second;
+    if(track.descType == EImageDescriberType::SIFT)
+    {
+      ++nbSiftTracks;
+      BOOST_CHECK_EQUAL(2, track.featPerView.size());
+    }
+    else
+    {
+      BOOST_CHECK(track.descType == EImageDescriberType::AKAZE);
+      BOOST_CHECK_EQUAL(3, track.featPerView.size());
+      BOOST_CHECK_EQUAL(5, track.featPerView.at(2));
+    }
+  }
+  BOOST_CHECK_EQUAL(2, nbSiftTracks);
+}
+
+BOOST_AUTO_TEST_CASE(Track_Chains)
+{
+  // long chains of matches, merged by many threads:
+  // feature f of view v is matched with feature (f + 1) % nbFeatures of view v + 1
+  const std::size_t nbViews = 50;
+  const std::size_t nbFeatures = 200;
+
+  PairwiseMatches map_pairwisematches;
+  for(std::size_t v = 0; v + 1 < nbViews; ++v)
+  {
+    IndMatches& matches = map_pairwisematches[std::make_pair(v, v + 1)][EImageDescriberType::UNKNOWN];
+    for(std::size_t f = 0; f < nbFeatures; ++f)
+      matches.emplace_back(f, (f + 1) % nbFeatures);
+  }
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches);
+  trackBuilder.filter();
+  BOOST_CHECK_EQUAL(nbFeatures, trackBuilder.nbTracks());
+
+  TracksMap map_tracks;
+  trackBuilder.exportToSTL(map_tracks);
+
+  // the track i starts with the feature i of the first view
+  for(const auto& trackIt: map_tracks)
+  {
+    const Track& track = trackIt.second;
+    BOOST_CHECK_EQUAL(nbViews, track.featPerView.size());
+    for(const auto& featIt: track.featPerView)
+      BOOST_CHECK_EQUAL((trackIt.first + featIt.first) % nbFeatures, featIt.second);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Track_CSR_ViewsIndex)
+{
+  //A    B    C
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6
+  //2 -> 3
+  PairwiseMatches map_pairwisematches;
+  map_pairwisematches[std::make_pair(10, 20)][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,1), IndMatch(2,3)};
+  map_pairwisematches[std::make_pair(20, 30)][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,6)};
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches);
+
+  TracksCSR tracks;
+  trackBuilder.exportToCSR(tracks);
+  BOOST_CHECK_EQUAL(3, tracks.nbTracks());
+
+  const std::vector<aliceVision::IndexT> views{10, 20, 30};
+  BOOST_CHECK(tracks.views == views);
+
+  const ArrayRange<aliceVision::IndexT> tracksC = tracks.viewTracks(30);
+  const ArrayRange<aliceVision::IndexT> featsC = tracks.viewFeatures(30);
+  BOOST_CHECK_EQUAL(2, tracksC.size());
+  BOOST_CHECK_EQUAL(0, tracksC[0]);
+  BOOST_CHECK_EQUAL(1, tracksC[1]);
+  BOOST_CHECK_EQUAL(0, featsC[0]);
+  BOOST_CHECK_EQUAL(6, featsC[1]);
+  BOOST_CHECK(tracks.viewTracks(40).empty());
+
+  aliceVision::IndexT featId = 0;
+  BOOST_CHECK(tracks.getFeatureId(2, 20, featId));
+  BOOST_CHECK_EQUAL(3, featId);
+  BOOST_CHECK(!tracks.getFeatureId(2, 30, featId));
+
+  std::vector<TracksCSR::CommonTrack> commonTracks;
+  tracks.getCommonTracks(10, 30, commonTracks);
+  BOOST_CHECK_EQUAL(2, commonTracks.size());
+  BOOST_CHECK_EQUAL(1, commonTracks[1].trackId);
+  BOOST_CHECK_EQUAL(1, commonTracks[1].featI);
+  BOOST_CHECK_EQUAL(6, commonTracks[1].featJ);
+
+  // same tracks as the map export
+  TracksMap map_tracks;
+  tracks.toTracksMap(map_tracks);
+  for(const auto& trackIt: map_tracks)
+  {
+    const ArrayRange<aliceVision::IndexT> trackViews = tracks.trackViewIds(trackIt.first);
+    const ArrayRange<aliceVision::IndexT> trackFeats = tracks.trackFeatIds(trackIt.first);
+    BOOST_CHECK_EQUAL(trackIt.second.featPerView.size(), trackViews.size());
+    std::size_t i = 0;
+    for(const auto& featIt: trackIt.second.featPerView)
+    {
+      BOOST_CHECK_EQUAL(featIt.first, trackViews[i]);
+      BOOST_CHECK_EQUAL(featIt.second, trackFeats[i]);
+      ++i;
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Track_CSR_HandComputed)
+{
+  // tracks of 2 describer types, the features of each type are numbered independently:
+  //         view 1   view 5   view 7
+  // SIFT    0     -> 2     -> 4
+  // SIFT             3     -> 1
+  // AKAZE   0     -> 0
+  PairwiseMatches map_pairwisematches;
+  map_pairwisematches[std::make_pair(1, 5)][EImageDescriberType::SIFT] = {IndMatch(0,2)};
+  map_pairwisematches[std::make_pair(1, 5)][EImageDescriberType::AKAZE] = {IndMatch(0,0)};
+  map_pairwisematches[std::make_pair(5, 7)][EImageDescriberType::SIFT] = {IndMatch(2,4), IndMatch(3,1)};
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches);
+
+  TracksCSR tracks;
+  trackBuilder.exportToCSR(tracks);
+  BOOST_REQUIRE_EQUAL(3, tracks.nbTracks());
+
+  // the tracks are identified by their describer type and their observation in view 5
+  std::size_t siftTrack3Views = 0;
+  std::size_t siftTrack2Views = 0;
+  std::size_t akazeTrack = 0;
+  for(std::size_t trackId = 0; trackId < tracks.nbTracks(); ++trackId)
+  {
+    aliceVision::IndexT featId = 0;
+    BOOST_REQUIRE(tracks.getFeatureId(trackId, 5, featId));
+    if(tracks.descTypes[trackId] == EImageDescriberType::AKAZE)
+      akazeTrack = trackId;
+    else if(featId == 2)
+      siftTrack3Views = trackId;
+    else
+      siftTrack2Views = trackId;
+  }
+  BOOST_CHECK(tracks.descTypes[siftTrack3Views] == EImageDescriberType::SIFT);
+  BOOST_CHECK(tracks.descTypes[siftTrack2Views] == EImageDescriberType::SIFT);
+  BOOST_CHECK_EQUAL(3, tracks.trackLength(siftTrack3Views));
+  BOOST_CHECK_EQUAL(2, tracks.trackLength(siftTrack2Views));
+  BOOST_CHECK_EQUAL(2, tracks.trackLength(akazeTrack));
+
+  // 7 observations in 3 views
+  const std::vector<aliceVision::IndexT> views{1, 5, 7};
+  const std::vector<std::size_t> viewOffsets{0, 2, 5, 7};
+  BOOST_CHECK(tracks.views == views);
+  BOOST_CHECK(tracks.viewOffsets == viewOffsets);
+  BOOST_CHECK_EQUAL(7, tracks.viewIds.size());
+  BOOST_CHECK_EQUAL(7, tracks.viewTrackIds.size());
+
+  const ArrayRange<aliceVision::IndexT> tracksView7 = tracks.viewTracks(7);
+  const ArrayRange<aliceVision::IndexT> featsView7 = tracks.viewFeatures(7);
+  BOOST_REQUIRE_EQUAL(2, tracksView7.size());
+  const std::size_t firstView7 = (siftTrack3Views < siftTrack2Views) ? 0 : 1;
+  BOOST_CHECK_EQUAL(siftTrack3Views, tracksView7[firstView7]);
+  BOOST_CHECK_EQUAL(4, featsView7[firstView7]);
+  BOOST_CHECK_EQUAL(siftTrack2Views, tracksView7[1 - firstView7]);
+  BOOST_CHECK_EQUAL(1, featsView7[1 - firstView7]);
+
+  // view 1 and view 7 only share the long SIFT track
+  std::vector<TracksCSR::CommonTrack> commonTracks;
+  tracks.getCommonTracks(1, 7, commonTracks);
+  BOOST_REQUIRE_EQUAL(1, commonTracks.size());
+  BOOST_CHECK_EQUAL(siftTrack3Views, commonTracks[0].trackId);
+  BOOST_CHECK_EQUAL(0, commonTracks[0].featI);
+  BOOST_CHECK_EQUAL(4, commonTracks[0].featJ);
+
+  // views 5 and 1 share the 2 tracks of view 1, with the features of view 5 first
+  tracks.getCommonTracks(5, 1, commonTracks);
+  BOOST_REQUIRE_EQUAL(2, commonTracks.size());
+  for(const TracksCSR::CommonTrack& commonTrack : commonTracks)
+  {
+    BOOST_CHECK_EQUAL(0, commonTrack.featJ);
+    BOOST_CHECK_EQUAL((commonTrack.trackId == akazeTrack) ? 0 : 2, commonTrack.featI);
+  }
+
+  // unknown views have no common track
+  tracks.getCommonTracks(1, 3, commonTracks);
+  BOOST_CHECK(commonTracks.empty());
+}
+
+/// Memory size of the map-based tracks store (in bytes)
+std::size_t tracksMapMemorySize(const TracksMap& tracks, const TracksPerView& tracksPerView)
+{
+  std::size_t memorySize = sizeof(TracksMap) + tracks.capacity() * sizeof(TracksMap::value_type);
+  for(const auto& trackIt: tracks)
+    memorySize += trackIt.second.featPerView.capacity() * sizeof(Track::FeatureIdPerView::value_type);
+
+  memorySize += sizeof(TracksPerView) + tracksPerView.capacity() * sizeof(TracksPerView::value_type);
+  for(const auto& viewIt: tracksPerView)
+    memorySize += viewIt.second.capacity() * sizeof(TrackIdSet::value_type);
+  return memorySize;
+}
+
+BOOST_AUTO_TEST_CASE(Track_CSR_Benchmark)
+{
+  // tracks of 2 to 8 consecutive views, with unique features in each view
+  const std::size_t nbViews = 100;
+  const std::size_t nbTracks = 200000;
+
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<std::size_t> firstViewDistribution(0, nbViews - 2);
+  std::uniform_int_distribution<std::size_t> lengthDistribution(2, 8);
+
+  std::vector<std::size_t> nbFeatures(nbViews, 0);
+  PairwiseMatches map_pairwisematches;
+  for(std::size_t t = 0; t < nbTracks; ++t)
+  {
+    const std::size_t firstView = firstViewDistribution(generator);
+    const std::size_t lastView = std::min(nbViews - 1, firstView + lengthDistribution(generator) - 1);
+    for(std::size_t v = firstView; v < lastView; ++v)
+      map_pairwisematches[std::make_pair(v, v + 1)][EImageDescriberType::UNKNOWN].emplace_back(nbFeatures[v]++, nbFeatures[v + 1]);
+    ++nbFeatures[lastView];
+  }
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches);
+  BOOST_CHECK_EQUAL(nbTracks, trackBuilder.nbTracks());
+
+  aliceVision::system::Timer timer;
+  TracksMap map_tracks;
+  TracksPerView map_tracksPerView;
+  trackBuilder.exportToSTL(map_tracks);
+  tracksUtilsMap::computeTracksPerView(map_tracks, map_tracksPerView);
+  const double mapExportTime = timer.elapsedMs();
+
+  timer.reset();
+  TracksCSR tracks;
+  trackBuilder.exportToCSR(tracks);
+  const double csrExportTime = timer.elapsedMs();
+
+  const std::size_t mapMemorySize = tracksMapMemorySize(map_tracks, map_tracksPerView);
+  ALICEVISION_LOG_INFO("Tracks store of " << nbTracks << " tracks in " << nbViews << " views:" << std::endl
+                       << "\t- tracks map and tracks per view: " << mapExportTime << " ms, " << mapMemorySize / (1024 * 1024) << " MB" << std::endl
+                       << "\t- CSR with views index: " << csrExportTime << " ms, " << tracks.memorySize() / (1024 * 1024) << " MB");
+  BOOST_CHECK_LT(tracks.memorySize(), mapMemorySize);
+
+  // common tracks of the consecutive views
+  timer.reset();
+  std::size_t mapNbCommonTracks = 0;
+  for(std::size_t v = 0; v + 1 < nbViews; ++v)
+  {
+    TracksMap commonTracks;
+    tracksUtilsMap::getCommonTracksInImagesFast({v, v + 1}, map_tracks, map_tracksPerView, commonTracks);
+    mapNbCommonTracks += commonTracks.size();
+  }
+  const double mapCommonTime = timer.elapsedMs();
+
+  timer.reset();
+  std::size_t csrNbCommonTracks = 0;
+  std::vector<TracksCSR::CommonTrack> commonTracks;
+  for(std::size_t v = 0; v + 1 < nbViews; ++v)
+  {
+    tracks.getCommonTracks(v, v + 1, commonTracks);
+    csrNbCommonTracks += commonTracks.size();
+  }
+  const double csrCommonTime = timer.elapsedMs();
+
+  ALICEVISION_LOG_INFO("Common tracks of " << nbViews - 1 << " pairs of views:" << std::endl
+                       << "\t- tracks map and tracks per view: " << mapCommonTime << " ms" << std::endl
+                       << "\t- CSR with views index: " << csrCommonTime << " ms");
+  BOOST_CHECK_EQUAL(mapNbCommonTracks, csrNbCommonTracks);
+}
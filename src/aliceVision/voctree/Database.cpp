@@ -8,7 +8,10 @@
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/tail.hpp>
 #include <boost/progress.hpp>
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <fstream>
 #include <stdexcept>
 #include <boost/format.hpp>
@@ -35,17 +38,25 @@ DocId Database::insert(DocId doc_id, const SparseHistogram& document)
   // Ensure that the new document to insert is not already there.
   assert(database_.find(doc_id) == database_.end());
 
+  const uint32_t docIndex = doc_ids_.size();
+  uint32_t docSize = 0;
+
   // For each word, retrieve its inverted file and increment the count for doc_id.
   for(SparseHistogram::const_iterator it = document.begin(), end = document.end(); it != end; ++it)
   {
     Word word = it->first;
     InvertedFile& file = word_files_[word];
-    if(file.empty() || file.back().id != doc_id)
-      file.push_back(WordFrequency(doc_id, it->second.size()));
+    if(file.empty() || file.back().docIndex != docIndex)
+      file.push_back(WordFrequency(docIndex, it->second.size()));
     else
       file.back().count += it->second.size();
+    docSize += it->second.size();
   }
 
+  doc_ids_.push_back(doc_id);
+  doc_sizes_.push_back(docSize);
+  docs_by_size_.insert(std::make_pair(docSize, docIndex));
+
   database_[doc_id] = document;
 
   return doc_id;
@@ -110,11 +121,51 @@ void Database::find(const std::vector<Word>& document, std::size_t N, std::vecto
  */
 void Database::find( const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod) const
 {
+  std::vector<float> scores(doc_ids_.size(), 0.0f);
+  find(query, N, matches, distanceMethod, scores);
+}
+
+void Database::findBatch(const std::vector<SparseHistogram>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string& distanceMethod) const
+{
+  std::vector<const SparseHistogram*> queryPtrs;
+  queryPtrs.reserve(queries.size());
+  for(const SparseHistogram& query : queries)
+    queryPtrs.push_back(&query);
+  findBatch(queryPtrs, N, matches, distanceMethod);
+}
+
+void Database::findBatch(const std::vector<const SparseHistogram*>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string& distanceMethod) const
+{
+  matches.resize(queries.size());
+
+  #pragma omp parallel
+  {
+    // per-thread scoring buffer, reused between the queries of the thread
+    std::vector<float> scores(doc_ids_.size(), 0.0f);
+
+    #pragma omp for schedule(dynamic)
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(queries.size()); ++i)
+    {
+      find(*queries[i], N, matches[i], distanceMethod, scores);
+    }
+  }
+}
+
+void Database::find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches,
+                    const std::string& distanceMethod, std::vector<float>& scores) const
+{
+  if(distanceMethod == "classic" ||
+     distanceMethod == "commonPoints" ||
+     distanceMethod == "strongCommonPoints")
+  {
+    findInvertedFile(query, N, distanceMethod, matches, scores);
+    return;
+  }
+
   // Accumulate the best N matches
   using bestN_tag = boost::accumulators::tag::tail<boost::accumulators::left>;
   boost::accumulators::accumulator_set<DocMatch, boost::accumulators::features<bestN_tag> > acc(bestN_tag::cache_size = N);
 
-  /// @todo Try only computing distances against documents sharing at least one word
   for(const auto& document: database_)
   {
     // for each document/image in the database compute the distance between the 
@@ -129,6 +180,95 @@ void Database::find( const SparseHistogram& query, std::size_t N, std::vector<Do
   std::copy(bestN(acc).begin(), bestN(acc).end(), matches.begin());
 }
 
+void Database::findInvertedFile(const SparseHistogram& query, std::size_t N, const std::string& distanceMethod,
+                                std::vector<DocMatch>& matches, std::vector<float>& scores) const
+{
+  const bool classic = (distanceMethod == "classic");
+  const bool strongCommonPoints = (distanceMethod == "strongCommonPoints");
+
+  assert(scores.size() == doc_ids_.size());
+
+  matches.clear();
+  if(N == 0)
+    return;
+
+  // accumulate the similarity with each document sharing at least one word with the query:
+  // - classic, commonPoints: sum over the shared words of min(queryCount, docCount)
+  // - strongCommonPoints: number of shared words seen only once in both documents
+  // every contribution is strictly positive, so a score of 0 means the document shares no word.
+  std::vector<uint32_t> touched;
+  float querySize = 0.0f;
+
+  for(const auto& word : query)
+  {
+    const uint32_t queryCount = word.second.size();
+    querySize += queryCount;
+
+    if(word.first >= word_files_.size())
+      continue;
+
+    if(strongCommonPoints && queryCount != 1)
+      continue;
+
+    for(const WordFrequency& frequency : word_files_[word.first])
+    {
+      if(strongCommonPoints && frequency.count != 1)
+        continue;
+
+      float& score = scores[frequency.docIndex];
+      if(score == 0.0f)
+        touched.push_back(frequency.docIndex);
+      score += std::min(queryCount, frequency.count);
+    }
+  }
+
+  std::vector<DocMatch> candidates;
+  candidates.reserve(touched.size() + std::min(N, doc_ids_.size()));
+
+  for(uint32_t docIndex : touched)
+  {
+    // classic: L1 distance between the histograms, i.e. |q| + |d| - 2 * sum(min(q_w, d_w))
+    const float distance = classic ? (querySize + doc_sizes_[docIndex] - 2.0f * scores[docIndex]) : -scores[docIndex];
+    candidates.push_back(DocMatch(doc_ids_[docIndex], distance));
+  }
+
+  // documents sharing no word with the query:
+  // - classic: the distance is |q| + |d|, the best ones are the smallest documents
+  // - commonPoints, strongCommonPoints: the distance is 0, only needed if there are not enough candidates
+  if(classic)
+  {
+    std::size_t nbUntouched = 0;
+    for(auto it = docs_by_size_.begin(); it != docs_by_size_.end() && nbUntouched < N; ++it)
+    {
+      if(scores[it->second] != 0.0f)
+        continue;
+      candidates.push_back(DocMatch(doc_ids_[it->second], querySize + it->first));
+      ++nbUntouched;
+    }
+  }
+  else
+  {
+    for(uint32_t docIndex = 0; docIndex < doc_ids_.size() && candidates.size() < N; ++docIndex)
+    {
+      if(scores[docIndex] == 0.0f)
+        candidates.push_back(DocMatch(doc_ids_[docIndex], 0.0f));
+    }
+  }
+
+  // restore the scratch buffer
+  for(uint32_t docIndex : touched)
+    scores[docIndex] = 0.0f;
+
+  // extract the best N (ties are ordered by DocId)
+  const std::size_t nbMatches = std::min(N, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + nbMatches, candidates.end(),
+                    [](const DocMatch& a, const DocMatch& b)
+                    {
+                      return a.score < b.score || (a.score == b.score && a.id < b.id);
+                    });
+  matches.assign(candidates.begin(), candidates.begin() + nbMatches);
+}
+
 /**
  * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
  * training examples into the database.
@@ -10,6 +10,8 @@
 #include <aliceVision/types.hpp>
 
 #include <map>
+#include <set>
+#include <vector>
 #include <cstddef>
 #include <string>
 
@@ -97,6 +99,10 @@ public:
     /**
    * @brief Find the top N matches in the database for the query document.
    *
+   * For the "classic", "commonPoints" and "strongCommonPoints" distance methods,
+   * only the documents sharing at least one word with the query are scored
+   * through the inverted file, the other methods compare the query with every document.
+   *
    * @param[in] query The query document, a normalized set of quantized words.
    * @param[int] N        The number of matches to return.
    * @param[in] distanceMethod distance method (norm L1, etc.)
@@ -104,6 +110,30 @@ public:
    */
   void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
 
+  /**
+   * @brief Find the top N matches in the database for each query document.
+   *
+   * Queries are processed in parallel, each thread reusing its own scoring buffer
+   * over the shared inverted file. The result does not depend on the number of threads.
+   *
+   * @param[in] queries The query documents, normalized sets of quantized words.
+   * @param[in] N The number of matches to return for each query.
+   * @param[out] matches IDs and scores for the top N matching database documents, per query (same order as \p queries).
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void findBatch(const std::vector<SparseHistogram>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string& distanceMethod = "strongCommonPoints") const;
+
+  /**
+   * @brief Find the top N matches in the database for each query document, without copying the queries.
+   * @see findBatch
+   *
+   * @param[in] queries The query documents (for instance the histograms of the database documents).
+   * @param[in] N The number of matches to return for each query.
+   * @param[out] matches IDs and scores for the top N matching database documents, per query (same order as \p queries).
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void findBatch(const std::vector<const SparseHistogram*>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string& distanceMethod = "strongCommonPoints") const;
+
   /**
    * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
    * training examples into the database.
@@ -136,17 +166,18 @@ private:
 
   struct WordFrequency
   {
-    DocId id;
+    /// index of the document in doc_ids_
+    uint32_t docIndex;
     uint32_t count;
 
     WordFrequency() = default;
-    WordFrequency(DocId _id, uint32_t _count)
-      : id(_id)
+    WordFrequency(uint32_t _docIndex, uint32_t _count)
+      : docIndex(_docIndex)
       , count(_count)
     {}
   };
 
-  // Stored in increasing order by DocId
+  /// Posting list of a word, stored in increasing order of document index
   typedef std::vector<WordFrequency> InvertedFile;
 
   /// @todo Use sorted vector?
@@ -158,6 +189,37 @@ private:
   std::vector<float> word_weights_;
   SparseHistogramPerImage database_; // Precomputed for inserted documents
 
+  /// DocId of each inserted document, by document index
+  std::vector<DocId> doc_ids_;
+  /// Number of features (L1 norm of the histogram) of each inserted document, by document index
+  std::vector<uint32_t> doc_sizes_;
+  /// Document indexes sorted by increasing number of features
+  std::set<std::pair<uint32_t, uint32_t> > docs_by_size_;
+
+  /**
+   * @brief Find the top N matches in the database for the query document.
+   * @see find()
+   * @param[in,out] scores scratch buffer, of size doc_ids_.size() and filled with 0.0f (restored on exit)
+   */
+  void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches,
+            const std::string& distanceMethod, std::vector<float>& scores) const;
+
+  /**
+   * @brief Find the top N matches in the database for the query document,
+   * only scoring the documents sharing at least one word with the query.
+   *
+   * Only available for the distance methods where the score of a document sharing
+   * no word with the query does not depend on its content.
+   *
+   * @param[in] query The query document
+   * @param[in] N The number of matches to return.
+   * @param[in] distanceMethod distance method ("classic", "commonPoints" or "strongCommonPoints")
+   * @param[out] matches IDs and scores for the top N matching database documents.
+   * @param[in,out] scores scratch buffer, of size doc_ids_.size() and filled with 0.0f (restored on exit)
+   */
+  void findInvertedFile(const SparseHistogram& query, std::size_t N, const std::string& distanceMethod,
+                        std::vector<DocMatch>& matches, std::vector<float>& scores) const;
+
   /**
    * Normalize a document vector representing the histogram of visual words for a given image
    * @param[in/out] v the unnormalized histogram of visual words
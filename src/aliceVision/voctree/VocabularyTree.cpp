@@ -34,7 +34,7 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
       }
       else
       {
-        distance += fabs(i1->second.size() - i2->second.size());
+        distance += fabs(static_cast<float>(i1->second.size()) - static_cast<float>(i2->second.size()));
         ++i1;
         ++i2;
       }
@@ -9,6 +9,7 @@
 #include <aliceVision/config.hpp>
 #include "distance.hpp"
 #include "DefaultAllocator.hpp"
+#include "nearestCenter.hpp"
 
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/regionsFactory.hpp>
@@ -190,8 +191,6 @@ template<class Feature, template<typename, typename> class Distance, class Featu
 template<class DescriptorT>
 Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const DescriptorT& feature) const
 {
-  typedef typename Distance<Feature, DescriptorT>::result_type distance_type;
-
   //	printf("asserting\n");
   assert(initialized());
   //	printf("initialized\n");
@@ -200,21 +199,12 @@ Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const Descrip
   {
     // Calculate the offset to the first child of the current index.
     int32_t first_child = (index + 1) * splits();
-    // Find the child center closest to the query.
-    int32_t best_child = first_child;
-    distance_type best_distance = std::numeric_limits<distance_type>::max();
-    for(int32_t child = first_child; child < first_child + (int32_t) splits(); ++child)
-    {
-      if(!valid_centers_[child])
-        break; // Fewer than splits() children.
-      distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers_[child]);
-      if(child_distance < best_distance)
-      {
-        best_child = child;
-        best_distance = child_distance;
-      }
-    }
-    index = best_child;
+    // Count the valid children (fewer than splits() children are possible).
+    int32_t nb_children = 0;
+    while(nb_children < (int32_t) splits() && valid_centers_[first_child + nb_children])
+      ++nb_children;
+    // Find the child center closest to the query, the children are stored contiguously.
+    index = first_child + NearestCenter<DescriptorT, Feature, Distance>::find(feature, &centers_[first_child], nb_children);
   }
 
   return index - word_start_;
@@ -149,6 +149,8 @@ void queryDatabase(const sfmData::SfMData& sfmData,
   ALICEVISION_LOG_DEBUG("queryDatabase: Reading the descriptors from " << descriptorsFiles.size() << " files...");
   boost::progress_display display(descriptorsFiles.size());
 
+  std::vector<SparseHistogram> queries(descriptorsFiles.size());
+
   #pragma omp parallel for
   // Run through the path vector and read the descriptors
   for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFiles.size()); ++i)
@@ -161,22 +163,29 @@ void queryDatabase(const sfmData::SfMData& sfmData,
     loadDescsFromBinFile(currentFileIt->second, descriptors, false, Nmax);
 
     // quantize the descriptors
-    SparseHistogram query = tree.quantizeToSparse(descriptors);
+    queries[i] = tree.quantizeToSparse(descriptors);
 
-    aliceVision::voctree::DocMatches docMatches;
-    // query the database
-    db.find(query, numResults, docMatches, distanceMethod);
     #pragma omp critical
     {
-      // add the vector to the documents
-      documents[currentFileIt->first] = query;
-
-      // add the matches to the result vector
-      allDocMatches[currentFileIt->first] = docMatches;
-
       ++display;
     }
   }
+
+  // query the database with all the documents at once
+  std::vector<DocMatches> docMatches;
+  db.findBatch(queries, numResults, docMatches, distanceMethod);
+
+  std::size_t i = 0;
+  for(const auto& currentFile : descriptorsFiles)
+  {
+    // add the vector to the documents
+    documents[currentFile.first] = std::move(queries[i]);
+
+    // add the matches to the result vector
+    allDocMatches[currentFile.first] = std::move(docMatches[i]);
+
+    ++i;
+  }
 }
 
 template<class DescriptorT, class VocDescriptorT>
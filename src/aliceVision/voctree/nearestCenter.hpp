@@ -0,0 +1,287 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/config.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
+#include "distance.hpp"
+
+#include <stdint.h>
+#include <cstddef>
+#include <limits>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <emmintrin.h>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+#endif
+
+namespace aliceVision {
+namespace voctree {
+
+/**
+ * @brief Find the center closest to a descriptor among the children of a tree node.
+ *
+ * The children of a node are stored contiguously, so all of them are evaluated in a single call.
+ * The generic version calls the \c Distance functor on each center.
+ * It is specialized for the L2 distance on feature::Descriptor types to evaluate the children
+ * by blocks of 4 centers with SSE/AVX, sharing the loads of the query descriptor.
+ * The float distances are accumulated in double, like the L2 functor.
+ *
+ * @note As in the generic version, the first center with the smallest distance is returned.
+ */
+template<class DescriptorT, class Feature, template<typename, typename> class Distance>
+struct NearestCenter
+{
+  /**
+   * @param[in] feature the query descriptor
+   * @param[in] centers pointer to the first child center
+   * @param[in] nbCenters number of (valid) child centers
+   * @return the index of the closest center, relative to \p centers (0 if \p nbCenters is 0)
+   */
+  static int32_t find(const DescriptorT& feature, const Feature* centers, int32_t nbCenters)
+  {
+    typedef typename Distance<Feature, DescriptorT>::result_type distance_type;
+
+    int32_t bestCenter = 0;
+    distance_type bestDistance = std::numeric_limits<distance_type>::max();
+    for(int32_t c = 0; c < nbCenters; ++c)
+    {
+      const distance_type distance = Distance<DescriptorT, Feature>()(feature, centers[c]);
+      if(distance < bestDistance)
+      {
+        bestCenter = c;
+        bestDistance = distance;
+      }
+    }
+    return bestCenter;
+  }
+};
+
+namespace simd {
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+
+inline double horizontalSum(__m128d v)
+{
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+inline int32_t horizontalSum(__m128i v)
+{
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(v);
+}
+
+#if defined(__AVX__)
+inline double horizontalSum(__m256d v)
+{
+  return horizontalSum(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+#endif
+
+#endif // ALICEVISION_HAVE_SSE
+
+/**
+ * @brief Squared L2 distances between a float query and \p NB float centers.
+ * @note As in the L2 functor, the distances are accumulated in double. The differences and
+ *       their squares are exact in double, only the order of the sums differs from the functor.
+ * @param[in] q the query (size L)
+ * @param[in] c the centers (each of size L)
+ * @param[out] out the NB squared distances
+ */
+template<int NB, std::size_t L>
+inline void squaredL2(const float* q, const float* const* c, double* out)
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#if defined(__AVX__)
+  const std::size_t simdEnd = L - L % 4;
+  __m256d acc[NB];
+  for(int j = 0; j < NB; ++j)
+    acc[j] = _mm256_setzero_pd();
+
+  for(std::size_t i = 0; i < simdEnd; i += 4)
+  {
+    const __m256d vq = _mm256_cvtps_pd(_mm_loadu_ps(q + i));
+    for(int j = 0; j < NB; ++j)
+    {
+      const __m256d d = _mm256_sub_pd(vq, _mm256_cvtps_pd(_mm_loadu_ps(c[j] + i)));
+      acc[j] = _mm256_add_pd(acc[j], _mm256_mul_pd(d, d));
+    }
+  }
+  for(int j = 0; j < NB; ++j)
+    out[j] = horizontalSum(acc[j]);
+#else
+  const std::size_t simdEnd = L - L % 4;
+  __m128d acc[NB];
+  for(int j = 0; j < NB; ++j)
+    acc[j] = _mm_setzero_pd();
+
+  for(std::size_t i = 0; i < simdEnd; i += 4)
+  {
+    const __m128 vq = _mm_loadu_ps(q + i);
+    const __m128d vqLo = _mm_cvtps_pd(vq);
+    const __m128d vqHi = _mm_cvtps_pd(_mm_movehl_ps(vq, vq));
+    for(int j = 0; j < NB; ++j)
+    {
+      const __m128 vc = _mm_loadu_ps(c[j] + i);
+      const __m128d dLo = _mm_sub_pd(vqLo, _mm_cvtps_pd(vc));
+      const __m128d dHi = _mm_sub_pd(vqHi, _mm_cvtps_pd(_mm_movehl_ps(vc, vc)));
+      acc[j] = _mm_add_pd(acc[j], _mm_mul_pd(dLo, dLo));
+      acc[j] = _mm_add_pd(acc[j], _mm_mul_pd(dHi, dHi));
+    }
+  }
+  for(int j = 0; j < NB; ++j)
+    out[j] = horizontalSum(acc[j]);
+#endif
+#else
+  const std::size_t simdEnd = 0;
+  for(int j = 0; j < NB; ++j)
+    out[j] = 0.0;
+#endif
+
+  // remaining dimensions
+  for(std::size_t i = simdEnd; i < L; ++i)
+  {
+    for(int j = 0; j < NB; ++j)
+    {
+      const double d = static_cast<double>(q[i]) - static_cast<double>(c[j][i]);
+      out[j] += d * d;
+    }
+  }
+}
+
+/**
+ * @brief Squared L2 distances between an unsigned char query and \p NB unsigned char centers.
+ * @note Computed with integers, so the result is exact.
+ */
+template<int NB, std::size_t L>
+inline void squaredL2(const unsigned char* q, const unsigned char* const* c, int32_t* out)
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+  const std::size_t simdEnd = L - L % 16;
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc[NB];
+  for(int j = 0; j < NB; ++j)
+    acc[j] = _mm_setzero_si128();
+
+  for(std::size_t i = 0; i < simdEnd; i += 16)
+  {
+    const __m128i vq = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i));
+    const __m128i vqLo = _mm_unpacklo_epi8(vq, zero);
+    const __m128i vqHi = _mm_unpackhi_epi8(vq, zero);
+    for(int j = 0; j < NB; ++j)
+    {
+      const __m128i vc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c[j] + i));
+      const __m128i dLo = _mm_sub_epi16(vqLo, _mm_unpacklo_epi8(vc, zero));
+      const __m128i dHi = _mm_sub_epi16(vqHi, _mm_unpackhi_epi8(vc, zero));
+      acc[j] = _mm_add_epi32(acc[j], _mm_madd_epi16(dLo, dLo));
+      acc[j] = _mm_add_epi32(acc[j], _mm_madd_epi16(dHi, dHi));
+    }
+  }
+  for(int j = 0; j < NB; ++j)
+    out[j] = horizontalSum(acc[j]);
+#else
+  const std::size_t simdEnd = 0;
+  for(int j = 0; j < NB; ++j)
+    out[j] = 0;
+#endif
+
+  // remaining dimensions
+  for(std::size_t i = simdEnd; i < L; ++i)
+  {
+    for(int j = 0; j < NB; ++j)
+    {
+      const int32_t d = static_cast<int32_t>(q[i]) - static_cast<int32_t>(c[j][i]);
+      out[j] += d * d;
+    }
+  }
+}
+
+/**
+ * @brief Find the closest center by blocks of 4 centers.
+ * @param[in] q the query data
+ * @param[in] centers the centers
+ * @param[in] nbCenters the number of centers
+ */
+template<typename DistanceT, std::size_t L, typename ValueT, typename CenterT>
+inline int32_t findNearestCenter(const ValueT* q, const CenterT* centers, int32_t nbCenters)
+{
+  int32_t bestCenter = 0;
+  DistanceT bestDistance = std::numeric_limits<DistanceT>::max();
+
+  const ValueT* c[4];
+  DistanceT distances[4];
+
+  int32_t first = 0;
+  for(; first + 4 <= nbCenters; first += 4)
+  {
+    for(int j = 0; j < 4; ++j)
+      c[j] = centers[first + j].getData();
+    squaredL2<4, L>(q, c, distances);
+    for(int j = 0; j < 4; ++j)
+    {
+      if(distances[j] < bestDistance)
+      {
+        bestCenter = first + j;
+        bestDistance = distances[j];
+      }
+    }
+  }
+  for(; first < nbCenters; ++first)
+  {
+    c[0] = centers[first].getData();
+    squaredL2<1, L>(q, c, distances);
+    if(distances[0] < bestDistance)
+    {
+      bestCenter = first;
+      bestDistance = distances[0];
+    }
+  }
+  return bestCenter;
+}
+
+} // namespace simd
+
+/// Float centers, float query.
+template<std::size_t L>
+struct NearestCenter<feature::Descriptor<float, L>, feature::Descriptor<float, L>, L2>
+{
+  static int32_t find(const feature::Descriptor<float, L>& feature, const feature::Descriptor<float, L>* centers, int32_t nbCenters)
+  {
+    return simd::findNearestCenter<double, L>(feature.getData(), centers, nbCenters);
+  }
+};
+
+/// Float centers, unsigned char query: the query is converted to float once for all the centers.
+template<std::size_t L>
+struct NearestCenter<feature::Descriptor<unsigned char, L>, feature::Descriptor<float, L>, L2>
+{
+  static int32_t find(const feature::Descriptor<unsigned char, L>& feature, const feature::Descriptor<float, L>* centers, int32_t nbCenters)
+  {
+    float q[L];
+    const unsigned char* data = feature.getData();
+    for(std::size_t i = 0; i < L; ++i)
+      q[i] = static_cast<float>(data[i]);
+    return simd::findNearestCenter<double, L>(q, centers, nbCenters);
+  }
+};
+
+/// Unsigned char centers, unsigned char query: exact integer distances.
+template<std::size_t L>
+struct NearestCenter<feature::Descriptor<unsigned char, L>, feature::Descriptor<unsigned char, L>, L2>
+{
+  static int32_t find(const feature::Descriptor<unsigned char, L>& feature, const feature::Descriptor<unsigned char, L>* centers, int32_t nbCenters)
+  {
+    return simd::findNearestCenter<int32_t, L>(feature.getData(), centers, nbCenters);
+  }
+};
+
+} // namespace voctree
+} // namespace aliceVision
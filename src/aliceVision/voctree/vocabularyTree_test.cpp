@@ -5,8 +5,13 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/voctree/MutableVocabularyTree.hpp>
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
+#include <type_traits>
 #include <fstream>
 #include <vector>
 
@@ -17,6 +22,63 @@
 using namespace std;
 using namespace aliceVision::voctree;
 
+/**
+ * @brief Reference quantization, evaluating the L2 distance to each child with the generic functor.
+ */
+template<class Feature, class DescriptorT>
+Word quantizeReference(const MutableVocabularyTree<Feature>& tree, const DescriptorT& feature)
+{
+  int32_t index = -1;
+  for(unsigned level = 0; level < tree.levels(); ++level)
+  {
+    const int32_t firstChild = (index + 1) * tree.splits();
+    int32_t bestChild = firstChild;
+    double bestDistance = std::numeric_limits<double>::max();
+    for(int32_t child = firstChild; child < firstChild + (int32_t) tree.splits() && tree.validCenters()[child]; ++child)
+    {
+      const double distance = L2<DescriptorT, Feature>()(feature, tree.centers()[child]);
+      if(distance < bestDistance)
+      {
+        bestChild = child;
+        bestDistance = distance;
+      }
+    }
+    index = bestChild;
+  }
+  return index - (tree.nodes() - tree.words());
+}
+
+template<typename CenterT, typename QueryT>
+void checkQuantize(uint32_t levels, uint32_t splits, std::size_t nbFeatures)
+{
+  typedef aliceVision::feature::Descriptor<CenterT, 128> Center;
+  typedef aliceVision::feature::Descriptor<QueryT, 128> Query;
+
+  MutableVocabularyTree<Center> tree;
+  tree.setSize(levels, splits);
+  tree.centers().resize(tree.nodes());
+  tree.validCenters().resize(tree.nodes(), 1);
+
+  // fractional float centers, so the distances are not exact in float
+  const double fraction = std::is_floating_point<CenterT>::value ? 1.0 / RAND_MAX : 0.0;
+  for(Center& center : tree.centers())
+    for(std::size_t i = 0; i < 128; ++i)
+      center[i] = static_cast<CenterT>(std::rand() % 256 + fraction * std::rand());
+
+  // some nodes with fewer than splits() children
+  for(std::size_t c = splits - 1; c < tree.nodes(); c += 3 * splits)
+    tree.validCenters()[c] = 0;
+
+  std::vector<Query> features(nbFeatures);
+  for(Query& feature : features)
+    for(std::size_t i = 0; i < 128; ++i)
+      feature[i] = static_cast<QueryT>(std::rand() % 256);
+
+  const std::vector<Word> words = tree.quantize(features);
+  for(std::size_t i = 0; i < features.size(); ++i)
+    BOOST_CHECK_EQUAL(quantizeReference(tree, features[i]), words[i]);
+}
+
 BOOST_AUTO_TEST_CASE(database)
 {
   const int cardDocuments = 10;
@@ -57,3 +119,111 @@ BOOST_AUTO_TEST_CASE(database)
     BOOST_CHECK_SMALL(static_cast<double>(match[0].score), 0.001);
   }
 }
+
+BOOST_AUTO_TEST_CASE(database_invertedFile)
+{
+  const int cardDocuments = 50;
+  const int cardWords = 200;
+  const int nbFeaturesPerDocument = 40;
+  const std::size_t N = 10;
+
+  std::srand(0);
+
+  // Create random documents, with repeated words
+  vector<SparseHistogram> documents(cardDocuments);
+  Database db(cardWords);
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<Word> document(std::rand() % nbFeaturesPerDocument + 1);
+    for(Word& word : document)
+      word = std::rand() % cardWords;
+    computeSparseHistogram(document, documents[i]);
+    db.insert(i, documents[i]);
+  }
+  db.computeTfIdfWeights();
+
+  for(const std::string distanceMethod : {"classic", "commonPoints", "strongCommonPoints"})
+  {
+    for(int i = 0; i < cardDocuments; ++i)
+    {
+      // Brute force scores against every document
+      vector<float> expectedScores;
+      for(int j = 0; j < cardDocuments; ++j)
+        expectedScores.push_back(sparseDistance(documents[i], documents[j], distanceMethod));
+      std::sort(expectedScores.begin(), expectedScores.end());
+
+      vector<DocMatch> matches;
+      db.find(documents[i], N, matches, distanceMethod);
+
+      BOOST_CHECK_EQUAL(N, matches.size());
+      for(std::size_t k = 0; k < matches.size(); ++k)
+      {
+        BOOST_CHECK_EQUAL(expectedScores[k], matches[k].score);
+        BOOST_CHECK_EQUAL(matches[k].score, sparseDistance(documents[i], documents[matches[k].id], distanceMethod));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(database_findBatch)
+{
+  const int cardDocuments = 30;
+  const int cardWords = 100;
+  const std::size_t N = 5;
+
+  std::srand(0);
+
+  vector<SparseHistogram> documents(cardDocuments);
+  Database db(cardWords);
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<Word> document(std::rand() % 30 + 1);
+    for(Word& word : document)
+      word = std::rand() % cardWords;
+    computeSparseHistogram(document, documents[i]);
+    db.insert(i, documents[i]);
+  }
+  db.computeTfIdfWeights();
+
+  for(const std::string distanceMethod : {"classic", "strongCommonPoints", "inversedWeightedCommonPoints"})
+  {
+    vector<DocMatches> batchMatches;
+    db.findBatch(documents, N, batchMatches, distanceMethod);
+    BOOST_CHECK_EQUAL(documents.size(), batchMatches.size());
+
+    for(int i = 0; i < cardDocuments; ++i)
+    {
+      DocMatches matches;
+      db.find(documents[i], N, matches, distanceMethod);
+      BOOST_CHECK_EQUAL(matches.size(), batchMatches[i].size());
+      for(std::size_t k = 0; k < matches.size(); ++k)
+        BOOST_CHECK_EQUAL(matches[k].score, batchMatches[i][k].score);
+    }
+
+    // query the histograms of the database in place
+    vector<const SparseHistogram*> queries;
+    for(int i = 0; i < cardDocuments; ++i)
+      queries.push_back(&db.getSparseHistogramPerImage().at(i));
+
+    vector<DocMatches> inPlaceMatches;
+    db.findBatch(queries, N, inPlaceMatches, distanceMethod);
+    BOOST_CHECK_EQUAL(queries.size(), inPlaceMatches.size());
+
+    for(int i = 0; i < cardDocuments; ++i)
+    {
+      BOOST_CHECK_EQUAL(batchMatches[i].size(), inPlaceMatches[i].size());
+      for(std::size_t k = 0; k < batchMatches[i].size(); ++k)
+        BOOST_CHECK_EQUAL(batchMatches[i][k].score, inPlaceMatches[i][k].score);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(vocabularyTree_quantize)
+{
+  std::srand(0);
+
+  checkQuantize<float, float>(3, 10, 200);
+  checkQuantize<float, unsigned char>(3, 10, 200);
+  checkQuantize<unsigned char, unsigned char>(3, 10, 200);
+  checkQuantize<unsigned char, unsigned char>(2, 7, 200);
+}
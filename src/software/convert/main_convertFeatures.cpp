@@ -0,0 +1,175 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/PointFeature.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <cstdlib>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+/**
+ * @brief Get the image describer type from a features filename (<viewId>.<describerType>.feat)
+ * @param[in] path the features file path
+ * @return the image describer type or UNKNOWN
+ */
+feature::EImageDescriberType getDescriberTypeFromFilename(const fs::path& path)
+{
+  const std::string describerTypeName = path.stem().extension().string();
+
+  if(describerTypeName.size() < 2)
+    return feature::EImageDescriberType::UNKNOWN;
+
+  try
+  {
+    return feature::EImageDescriberType_stringToEnum(describerTypeName.substr(1));
+  }
+  catch(const std::exception&)
+  {
+    return feature::EImageDescriberType::UNKNOWN;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string inputFolder;
+  std::string outputFolder;
+  bool toBinary = true;
+
+  po::options_description allParams("This program is used to convert keypoints files between the ASCII (.feat) and the binary (.featb) formats.\n"
+                                    "Descriptors files (.desc) are copied as-is.\n"
+                                    "AliceVision convertFeatures");
+
+  allParams.add_options()
+    ("help,h", "Print this message.");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&inputFolder)->required(),
+      "Input folder containing the features files.")
+    ("output,o", po::value<std::string>(&outputFolder)->required(),
+      "Output folder for the converted features files.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("toBinary", po::value<bool>(&toBinary)->default_value(toBinary),
+      "Convert to the binary keypoints format (.featb) if true, to the ASCII keypoints format (.feat) otherwise.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal,  error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(!(fs::exists(inputFolder) && fs::is_directory(inputFolder)))
+  {
+    ALICEVISION_LOG_ERROR(inputFolder << " does not exists or it is not a folder");
+    return EXIT_FAILURE;
+  }
+
+  if(fs::exists(outputFolder) && fs::equivalent(inputFolder, outputFolder))
+  {
+    ALICEVISION_LOG_ERROR("Input and output folders must be different");
+    return EXIT_FAILURE;
+  }
+
+  // if the folder does not exist create it (recursively)
+  if(!fs::exists(outputFolder))
+    fs::create_directories(outputFolder);
+
+  const std::string outputExtension = toBinary ? feature::featsBinFileExtension : ".feat";
+
+  std::size_t countFeat = 0;
+  std::size_t countDesc = 0;
+
+  for(fs::directory_iterator it(inputFolder); it != fs::directory_iterator(); ++it)
+  {
+    std::string ext = it->path().extension().string();
+    boost::to_lower(ext);
+
+    if(ext == ".desc")
+    {
+      // just copy the file into the output folder
+      fs::copy_file(it->path(), fs::path(outputFolder) / it->path().filename(), fs::copy_option::overwrite_if_exists);
+      ++countDesc;
+      continue;
+    }
+
+    if(ext != ".feat" && ext != feature::featsBinFileExtension)
+      continue;
+
+    const std::string outputPath = (fs::path(outputFolder) / it->path().stem()).string() + outputExtension;
+
+    try
+    {
+      // loadFeatsFromFile detects the input format from the file content
+      std::vector<feature::SIOPointFeature> features;
+      feature::loadFeatsFromFile(it->path().string(), features);
+
+      // saveFeatsToFile picks the output format from the extension
+      feature::saveFeatsToFile(outputPath, features, getDescriberTypeFromFilename(it->path()));
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Failed to convert features file '" << it->path().string() << "': " << e.what());
+      return EXIT_FAILURE;
+    }
+
+    ++countFeat;
+  }
+
+  ALICEVISION_LOG_INFO("Converted " << countFeat << " features files and copied " << countDesc << " descriptors files");
+  return EXIT_SUCCESS;
+}
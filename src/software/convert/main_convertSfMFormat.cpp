@@ -51,7 +51,7 @@ int main(int argc, char **argv)
     ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
       "SfMData file.")
     ("output,o", po::value<std::string>(&outputSfMDataFilename)->required(),
-      "Path to the output Alembic file.");
+      "Path to the output SfMData file (*.sfm, *.json, *.sfmb, *.abc, *.ply, *.baf).");
 
   po::options_description optionalParams("Optional parameters");
   optionalParams.add_options()
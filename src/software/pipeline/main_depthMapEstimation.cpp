@@ -11,6 +11,7 @@
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 #include <aliceVision/mvsUtils/PreMatchCams.hpp>
+#include <aliceVision/depthMap/ComputeBackend.hpp>
 #include <aliceVision/depthMap/RefineRc.hpp>
 #include <aliceVision/depthMap/SemiGlobalMatchingRc.hpp>
 #include <aliceVision/system/gpu.hpp>
@@ -21,7 +22,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -42,6 +43,9 @@ int main(int argc, char* argv[])
     // image downscale factor during process
     int downscale = 2;
 
+    // implementation of the plane sweeping
+    depthMap::EComputeBackend computeBackend = depthMap::EComputeBackend_default();
+
     // semiGlobalMatching
     int sgmMaxTCams = 10;
     int sgmWSH = 4;
@@ -77,6 +81,10 @@ int main(int argc, char* argv[])
             "Compute a sub-range of N images (N=rangeSize).")
         ("downscale", po::value<int>(&downscale)->default_value(downscale),
             "Image downscale factor.")
+        ("computeBackend", po::value<depthMap::EComputeBackend>(&computeBackend)->default_value(computeBackend),
+            "Plane sweeping implementation:\n"
+            "* cuda: CUDA kernels, needs a CUDA-Enabled GPU (only if AliceVision is built with CUDA)\n"
+            "* cpu: multithreaded CPU implementation, slower but no GPU needed")
         ("sgmMaxTCams", po::value<int>(&sgmMaxTCams)->default_value(sgmMaxTCams),
             "Semi Global Matching: Number of neighbour cameras.")
         ("sgmWSH", po::value<int>(&sgmWSH)->default_value(sgmWSH),
@@ -144,14 +152,18 @@ int main(int argc, char* argv[])
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
 
-    // print GPU Information
-    ALICEVISION_LOG_INFO(system::gpuInformationCUDA());
-
-    // check if the gpu suppport CUDA compute capability 2.0
-    if(!system::gpuSupportCUDA(2,0))
+    if(computeBackend == depthMap::EComputeBackend::CUDA)
     {
-      ALICEVISION_LOG_ERROR("This program needs a CUDA-Enabled GPU (with at least compute capablility 2.0).");
-      return EXIT_FAILURE;
+      // print GPU Information
+      ALICEVISION_LOG_INFO(system::gpuInformationCUDA());
+
+      // check if the gpu suppport CUDA compute capability 2.0
+      if(!system::gpuSupportCUDA(2,0))
+      {
+        ALICEVISION_LOG_ERROR("This program needs a CUDA-Enabled GPU (with at least compute capablility 2.0)." << std::endl
+                              << "Use '--computeBackend cpu' to compute the depth maps without GPU.");
+        return EXIT_FAILURE;
+      }
     }
 
     // check if the scale is correct
@@ -166,6 +178,9 @@ int main(int argc, char* argv[])
 
     // set params in bpt
 
+    // global
+    mp._ini.put("global.computeBackend", depthMap::EComputeBackend_enumToString(computeBackend));
+
     // semiGlobalMatching
     mp._ini.put("semiGlobalMatching.maxTCams", sgmMaxTCams);
     mp._ini.put("semiGlobalMatching.wsh", sgmWSH);
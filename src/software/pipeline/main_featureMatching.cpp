@@ -22,6 +22,7 @@
 #include <aliceVision/matchingImageCollection/GeometricFilterMatrix_H_AC.hpp>
 #include <aliceVision/matchingImageCollection/GeometricFilterMatrix_HGrowing.hpp>
 #include <aliceVision/matchingImageCollection/GeometricFilterType.hpp>
+#include <aliceVision/matchingImageCollection/RegionsCache.hpp>
 #include <aliceVision/matching/pairwiseAdjacencyDisplay.hpp>
 #include <aliceVision/matching/io.hpp>
 #include <aliceVision/system/Timer.hpp>
@@ -40,7 +41,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 3
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -55,10 +56,9 @@ using namespace std;
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
 
-void getStatsMap(const PairwiseMatches& map)
+void accumulateStatsMap(const PairwiseMatches& map, std::map<int,int>& stats)
 {
 #ifdef ALICEVISION_DEBUG_MATCHING
-  std::map<int,int> stats;
   for(const auto& imgMatches: map)
   {
     for(const auto& featMatchesPerDesc: imgMatches.second)
@@ -73,11 +73,212 @@ void getStatsMap(const PairwiseMatches& map)
       }
     }
   }
+#endif
+}
+
+void logStatsMap(const std::map<int,int>& stats)
+{
   for(const auto& stat: stats)
   {
     ALICEVISION_LOG_DEBUG(std::to_string(stat.first) + "\t" + std::to_string(stat.second));
   }
-#endif
+}
+
+/**
+ * @brief Compute the putative matches of pairs of views (descriptors matching).
+ * @param[in] imageCollectionMatcher the photometric matcher
+ * @param[in] regionPerView the regions of the views of the pairs
+ * @param[in] pairs the pairs to match
+ * @param[in] describerTypes the describer types to match
+ * @param[in] geometricFilterType the geometric filter applied afterwards
+ * @param[out] out_putativeMatches the putative matches of the pairs
+ */
+void computePutativeMatches(const IImageCollectionMatcher& imageCollectionMatcher,
+                            const RegionsPerView& regionPerView,
+                            const PairSet& pairs,
+                            const std::vector<feature::EImageDescriberType>& describerTypes,
+                            EGeometricFilterType geometricFilterType,
+                            PairwiseMatches& out_putativeMatches)
+{
+  for(const feature::EImageDescriberType descType : describerTypes)
+  {
+    assert(descType != feature::EImageDescriberType::UNINITIALIZED);
+    ALICEVISION_LOG_INFO(EImageDescriberType_enumToString(descType) + " Regions Matching");
+
+    // photometric matching of putative pairs
+    imageCollectionMatcher.Match(regionPerView, pairs, descType, out_putativeMatches);
+
+    // TODO: DELI
+    // if(!guided_matching) regionPerView.clearDescriptors()
+  }
+
+  if(geometricFilterType == EGeometricFilterType::HOMOGRAPHY_GROWING)
+  {
+    // sort putative matches according to their Lowe ratio
+    // This is suggested by [F.Srajer, 2016]: the matches used to be the seeds of the homographies growing are chosen according
+    // to the putative matches order. This modification should improve recall.
+    for(auto& imgPair: out_putativeMatches)
+    {
+      for(auto& descType: imgPair.second)
+      {
+        IndMatches & matches = descType.second;
+        sortMatches_byDistanceRatio(matches);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Compute the geometric matches of pairs of views from their putative matches (robust model estimation).
+ * @param[in] sfmData the SfMData with the views and intrinsics
+ * @param[in] regionPerView the regions of the views of the pairs
+ * @param[in] putativeMatches the putative matches of the pairs
+ * @param[in] geometricFilterType the geometric model
+ * @param[in] geometricErrorMax the maximum reprojection error (0 to let the ACRansac select an optimal value)
+ * @param[in] maxIteration the maximum number of iterations of the robust estimation
+ * @param[in] geometricEstimator the robust estimator
+ * @param[in] guidedMatching use the found model to improve the pairwise correspondences
+ * @param[out] out_geometricMatches the geometric matches of the pairs
+ */
+void computeGeometricMatches(const SfMData& sfmData,
+                             const RegionsPerView& regionPerView,
+                             const PairwiseMatches& putativeMatches,
+                             EGeometricFilterType geometricFilterType,
+                             double geometricErrorMax,
+                             int maxIteration,
+                             robustEstimation::ERobustEstimator geometricEstimator,
+                             bool guidedMatching,
+                             PairwiseMatches& out_geometricMatches)
+{
+  switch(geometricFilterType)
+  {
+
+    case EGeometricFilterType::NO_FILTERING:
+      out_geometricMatches = putativeMatches;
+    break;
+
+    case EGeometricFilterType::FUNDAMENTAL_MATRIX:
+    {
+      matchingImageCollection::robustModelEstimation(out_geometricMatches,
+        &sfmData,
+        regionPerView,
+        GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator),
+        putativeMatches,
+        guidedMatching);
+    }
+    break;
+
+    case EGeometricFilterType::ESSENTIAL_MATRIX:
+    {
+      matchingImageCollection::robustModelEstimation(out_geometricMatches,
+        &sfmData,
+        regionPerView,
+        GeometricFilterMatrix_E_AC(std::numeric_limits<double>::infinity(), maxIteration),
+        putativeMatches,
+        guidedMatching);
+
+      // perform an additional check to remove pairs with poor overlap
+      std::vector<PairwiseMatches::key_type> toRemoveVec;
+      for(PairwiseMatches::const_iterator iterMap = out_geometricMatches.begin();
+        iterMap != out_geometricMatches.end(); ++iterMap)
+      {
+        const size_t putativePhotometricCount = putativeMatches.find(iterMap->first)->second.getNbAllMatches();
+        const size_t putativeGeometricCount = iterMap->second.getNbAllMatches();
+        const float ratio = putativeGeometricCount / (float)putativePhotometricCount;
+        if (putativeGeometricCount < 50 || ratio < .3f)
+          toRemoveVec.push_back(iterMap->first); // the image pair will be removed
+      }
+
+      // remove discarded pairs
+      for(std::vector<PairwiseMatches::key_type>::const_iterator iter = toRemoveVec.begin();
+          iter != toRemoveVec.end(); ++iter)
+        out_geometricMatches.erase(*iter);
+    }
+    break;
+
+    case EGeometricFilterType::HOMOGRAPHY_MATRIX:
+    {
+      const bool onlyGuidedMatching = true;
+      matchingImageCollection::robustModelEstimation(out_geometricMatches,
+        &sfmData,
+        regionPerView,
+        GeometricFilterMatrix_H_AC(std::numeric_limits<double>::infinity(), maxIteration),
+        putativeMatches, guidedMatching,
+        onlyGuidedMatching ? -1.0 : 0.6);
+    }
+    break;
+
+    case EGeometricFilterType::HOMOGRAPHY_GROWING:
+    {
+      matchingImageCollection::robustModelEstimation(out_geometricMatches,
+        &sfmData,
+        regionPerView,
+        GeometricFilterMatrix_HGrowing(std::numeric_limits<double>::infinity(), maxIteration),
+        putativeMatches,
+        guidedMatching);
+    }
+    break;
+  }
+}
+
+/**
+ * @brief Sort the geometric matches of pairs of views by features scale and filter them with a grid.
+ * @param[in] sfmData the SfMData with the views
+ * @param[in] regionPerView the regions of the views of the pairs
+ * @param[in] geometricMatches the geometric matches of the pairs
+ * @param[in] useGridSort use the matching grid sort
+ * @param[in] numMatchesToKeep the maximum number of matches to keep per pair (0 to keep all of them)
+ * @param[out] out_finalMatches the filtered matches of the pairs
+ */
+void computeGridFilteredMatches(const SfMData& sfmData,
+                                const RegionsPerView& regionPerView,
+                                const PairwiseMatches& geometricMatches,
+                                bool useGridSort,
+                                std::size_t numMatchesToKeep,
+                                PairwiseMatches& out_finalMatches)
+{
+  for(const auto& geometricMatch: geometricMatches)
+  {
+    //Get the image pair and their matches.
+    const Pair& indexImagePair = geometricMatch.first;
+    const aliceVision::matching::MatchesPerDescType& matchesPerDesc = geometricMatch.second;
+
+    for(const auto& match: matchesPerDesc)
+    {
+      const feature::EImageDescriberType descType = match.first;
+      assert(descType != feature::EImageDescriberType::UNINITIALIZED);
+      const aliceVision::matching::IndMatches& inputMatches = match.second;
+
+      const feature::FeatRegions<feature::SIOPointFeature>* rRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionPerView.getRegions(indexImagePair.second, descType));
+      const feature::FeatRegions<feature::SIOPointFeature>* lRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionPerView.getRegions(indexImagePair.first, descType));
+
+      // get the regions for the current view pair:
+      if(rRegions && lRegions)
+      {
+        // sorting function:
+        aliceVision::matching::IndMatches outMatches;
+        sortMatches_byFeaturesScale(inputMatches, *lRegions, *rRegions, outMatches);
+
+        if(useGridSort)
+        {
+          // TODO: rename as matchesGridOrdering
+          matchesGridFiltering(*lRegions, *rRegions, indexImagePair, sfmData, outMatches);
+        }
+        if(numMatchesToKeep > 0)
+        {
+          size_t finalSize = std::min(numMatchesToKeep, outMatches.size());
+          outMatches.resize(finalSize);
+        }
+
+        // std::cout << "Left features: " << lRegions->Features().size() << ", right features: " << rRegions->Features().size() << ", num matches: " << inputMatches.size() << ", num filtered matches: " << outMatches.size() << std::endl;
+        out_finalMatches[indexImagePair].insert(std::make_pair(descType, outMatches));
+      }
+      else
+      {
+        ALICEVISION_LOG_INFO("You cannot perform the grid filtering with these regions");
+      }
+    }
+  }
 }
 
 /// Compute corresponding features between a series of views:
@@ -112,7 +313,9 @@ int main(int argc, char **argv)
   size_t numMatchesToKeep = 0;
   bool useGridSort = true;
   bool exportDebugFiles = false;
-  const std::string fileExtension = "txt";
+  std::string fileExtension = "txt";
+  std::size_t regionsCacheSize = 0;
+  int matchingBlockSize = 64;
 
   po::options_description allParams(
      "Compute corresponding features between a series of views:\n"
@@ -146,6 +349,7 @@ int main(int argc, char **argv)
       "* CASCADE_HASHING_L2: L2 Cascade Hashing matching\n"
       "* FAST_CASCADE_HASHING_L2: L2 Cascade Hashing with precomputed hashed regions\n"
       "(faster than CASCADE_HASHING_L2 but use more memory)\n"
+      "* BLOCKED_BRUTE_FORCE_L2: L2 BruteForce matching by blocks of descriptors (faster than BRUTE_FORCE_L2)\n"
       "For Binary based descriptor:\n"
       "* BRUTE_FORCE_HAMMING: BruteForce Hamming matching")
     ("geometricEstimator", po::value<std::string>(&geometricEstimatorName)->default_value(geometricEstimatorName),
@@ -161,6 +365,10 @@ int main(int argc, char **argv)
       "Use the found model to improve the pairwise correspondences.")
     ("matchFilePerImage", po::value<bool>(&matchFilePerImage)->default_value(matchFilePerImage),
       "Save matches in a separate file per image.")
+    ("matchesFileExtension", po::value<std::string>(&fileExtension)->default_value(fileExtension),
+      "Matches file format:\n"
+      "* txt: text file\n"
+      "* bin: binary file with a per-pair index (faster to load)")
     ("distanceRatio", po::value<float>(&distRatio)->default_value(distRatio),
       "Distance ratio to discard non meaningful matches.")
     ("maxIteration", po::value<int>(&maxIteration)->default_value(maxIteration),
@@ -174,7 +382,14 @@ int main(int argc, char **argv)
     ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
       "Range image index start.")
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
-      "Range size.");
+      "Range size.")
+    ("regionsCacheSize", po::value<std::size_t>(&regionsCacheSize)->default_value(regionsCacheSize),
+      "Maximum memory size (in MB) of the regions kept in memory between the blocks of pairs.\n"
+      "If 0, the regions of all the views are loaded before the matching. "
+      "Otherwise, the pairs are matched by blocks and the regions are loaded on demand (out-of-core matching).")
+    ("matchingBlockSize", po::value<int>(&matchingBlockSize)->default_value(matchingBlockSize),
+      "Number of views of a group for the out-of-core matching: "
+      "a block contains the pairs between two groups of views.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -225,6 +440,12 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  if(fileExtension != "txt" && fileExtension != "bin")
+  {
+    ALICEVISION_LOG_ERROR("Invalid matches file extension: " + fileExtension);
+    return EXIT_FAILURE;
+  }
+
   const matchingImageCollection::EGeometricFilterType geometricFilterType = matchingImageCollection::EGeometricFilterType_stringToEnum(geometricFilterTypeName);
 
   if(describerTypesName.empty())
@@ -233,6 +454,12 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  if(regionsCacheSize > 0 && matchingBlockSize <= 0)
+  {
+    ALICEVISION_LOG_ERROR("Invalid matching block size: " << matchingBlockSize);
+    return EXIT_FAILURE;
+  }
+
   // Feature matching
   // a. Load SfMData Views & intrinsics data
   // b. Compute putative descriptor matches
@@ -283,10 +510,6 @@ int main(int argc, char **argv)
     filter.insert(pair.second);
   }
 
-  ALICEVISION_LOG_INFO("Putative matches");
-
-  PairwiseMatches mapPutativesMatches;
-
   // allocate the right Matcher according the Matching requested method
   EMatcherType collectionMatcherType = EMatcherType_stringToEnum(nearestMatchingMethod);
   std::unique_ptr<IImageCollectionMatcher> imageCollectionMatcher = createImageCollectionMatcher(collectionMatcherType, distRatio);
@@ -295,61 +518,127 @@ int main(int argc, char **argv)
 
   ALICEVISION_LOG_INFO("There are " + std::to_string(sfmData.getViews().size()) + " views and " + std::to_string(pairs.size()) + " image pairs.");
 
-  // load the corresponding view regions
-  RegionsPerView regionPerView;
-  if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter))
+  PairwiseMatches mapPutativesMatches;
+  PairwiseMatches finalMatches;
+  std::size_t nbPutativePairs = 0;
+  std::size_t nbGeometricPairs = 0;
+
+  // distribution of the matches distances (debug statistics)
+  std::map<int,int> putativeStats;
+  std::map<int,int> geometricStats;
+
+  double putativeMatchingTime = 0.0;
+  double geometricFilteringTime = 0.0;
+
+  ALICEVISION_LOG_INFO("Geometric filtering: using " << matchingImageCollection::EGeometricFilterType_enumToString(geometricFilterType));
+
+  // match a set of pairs with the regions of their views:
+  // putative matches, geometric filtering of putative matches and grid filtering
+  const auto matchPairs = [&](const RegionsPerView& regionPerView, const PairSet& pairsToMatch)
   {
-    ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "'");
-    return EXIT_FAILURE;
+    // b. Compute putative descriptor matches
+    //    - Descriptor matching (according user method choice)
+    //    - Keep correspondences only if NearestNeighbor ratio is ok
+    system::Timer timer;
+    PairwiseMatches putativeMatches;
+    computePutativeMatches(*imageCollectionMatcher, regionPerView, pairsToMatch, describerTypes, geometricFilterType, putativeMatches);
+    putativeMatchingTime += timer.elapsed();
+
+    for(const auto& imageMatch: putativeMatches)
+      ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(imageMatch.first.first) << ", " + std::to_string(imageMatch.first.second) + ") contains " + std::to_string(imageMatch.second.getNbAllMatches()) + " putative matches.");
+
+    // c. Geometric filtering of putative matches
+    //    - AContrario Estimation of the desired geometric model
+    //    - Use an upper bound for the a contrario estimated threshold
+    timer.reset();
+    PairwiseMatches pairsGeometricMatches;
+    computeGeometricMatches(sfmData, regionPerView, putativeMatches, geometricFilterType, geometricErrorMax, maxIteration, geometricEstimator, guidedMatching, pairsGeometricMatches);
+
+    // grid filtering
+    computeGridFilteredMatches(sfmData, regionPerView, pairsGeometricMatches, useGridSort, numMatchesToKeep, finalMatches);
+    geometricFilteringTime += timer.elapsed();
+
+    for(const auto& matchGeo: pairsGeometricMatches)
+      ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGeo.first.first) + ", " + std::to_string(matchGeo.first.second) + ") contains " + std::to_string(matchGeo.second.getNbAllMatches()) + " geometric matches.");
+
+    nbPutativePairs += putativeMatches.size();
+    nbGeometricPairs += pairsGeometricMatches.size();
+
+    accumulateStatsMap(putativeMatches, putativeStats);
+    accumulateStatsMap(pairsGeometricMatches, geometricStats);
+
+    // the putative and geometric matches of the pairs are logged and dropped, unless the putative matches are saved
+    if(savePutativeMatches)
+      mapPutativesMatches.insert(std::make_move_iterator(putativeMatches.begin()), std::make_move_iterator(putativeMatches.end()));
+  };
+
+  if(regionsCacheSize == 0)
+  {
+    // load the corresponding view regions
+    RegionsPerView regionPerView;
+    if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter))
+    {
+      ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "'");
+      return EXIT_FAILURE;
+    }
+
+    matchPairs(regionPerView, pairs);
   }
+  else
+  {
+    // out-of-core matching: the pairs are matched by blocks, with the regions of their views loaded on demand
+    if(collectionMatcherType == FAST_CASCADE_HASHING_L2)
+    {
+      ALICEVISION_LOG_ERROR("The " << EMatcherType_enumToString(collectionMatcherType) << " matcher needs all the regions in memory, "
+                            "it can't be used with the option --regionsCacheSize.");
+      return EXIT_FAILURE;
+    }
 
-  // perform the matching
-  system::Timer timer;
+    std::vector<std::string> allFeaturesFolders = sfmData.getFeaturesFolders();
+    allFeaturesFolders.insert(allFeaturesFolders.end(), featuresFolders.begin(), featuresFolders.end());
 
-  for(const feature::EImageDescriberType descType : describerTypes)
-  {
-    assert(descType != feature::EImageDescriberType::UNINITIALIZED);
-    ALICEVISION_LOG_INFO(EImageDescriberType_enumToString(descType) + " Regions Matching");
+    std::map<feature::EImageDescriberType, std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+    for(const feature::EImageDescriberType descType : describerTypes)
+      imageDescribers[descType] = feature::createImageDescriber(descType);
 
-    // photometric matching of putative pairs
-    imageCollectionMatcher->Match(regionPerView, pairs, descType, mapPutativesMatches);
+    const RegionsCache::RegionsLoader loader = [&](IndexT viewId, feature::EImageDescriberType descType)
+    {
+      return sfm::loadRegions(allFeaturesFolders, viewId, *imageDescribers.at(descType));
+    };
 
-    // TODO: DELI
-    // if(!guided_matching) regionPerView.clearDescriptors()
+    const std::vector<PairSet> blocks = getPairBlocks(pairs, matchingBlockSize);
+    ALICEVISION_LOG_INFO("Out-of-core matching of " << pairs.size() << " pairs in " << blocks.size() << " blocks, "
+                         "with a regions cache of " << regionsCacheSize << " MB.");
+
+    RegionsCache regionsCache(loader, describerTypes, regionsCacheSize * 1024 * 1024);
+    try
+    {
+      processPairBlocks(regionsCache, blocks, matchPairs);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "': " << e.what());
+      return EXIT_FAILURE;
+    }
+
+    ALICEVISION_LOG_INFO("Regions of " << filter.size() << " views loaded " << regionsCache.getNbLoads() << " times "
+                         "(" << regionsCache.getNbHits() << " views reused from the cache).");
   }
 
-  if(mapPutativesMatches.empty())
+  if(nbPutativePairs == 0)
   {
     ALICEVISION_LOG_INFO("No putative matches.");
     // If we only compute a selection of matches, we may have no match.
     return rangeSize ? EXIT_SUCCESS : EXIT_FAILURE;
   }
 
-  if(geometricFilterType == EGeometricFilterType::HOMOGRAPHY_GROWING)
-  {
-    // sort putative matches according to their Lowe ratio
-    // This is suggested by [F.Srajer, 2016]: the matches used to be the seeds of the homographies growing are chosen according
-    // to the putative matches order. This modification should improve recall.
-    for(auto& imgPair: mapPutativesMatches)
-    {
-      for(auto& descType: imgPair.second)
-      {
-        IndMatches & matches = descType.second;
-        sortMatches_byDistanceRatio(matches);
-      }
-    }
-  }
-
-  ALICEVISION_LOG_INFO(std::to_string(mapPutativesMatches.size()) << " putative image pair matches");
-
-  for(const auto& imageMatch: mapPutativesMatches)
-    ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(imageMatch.first.first) << ", " + std::to_string(imageMatch.first.second) + ") contains " + std::to_string(imageMatch.second.getNbAllMatches()) + " putative matches.");
+  ALICEVISION_LOG_INFO(std::to_string(nbPutativePairs) << " putative image pair matches");
 
   // export putative matches
   if(savePutativeMatches)
     Save(mapPutativesMatches, (fs::path(matchesFolder) / "putativeMatches").string(), fileExtension, matchFilePerImage);
 
-  ALICEVISION_LOG_INFO("Task (Regions Matching) done in (s): " + std::to_string(timer.elapsed()));
+  ALICEVISION_LOG_INFO("Task (Regions Matching) done in (s): " + std::to_string(putativeMatchingTime));
 
   /*
   // TODO: DELI
@@ -378,152 +667,22 @@ int main(int argc, char **argv)
 #ifdef ALICEVISION_DEBUG_MATCHING
     {
       ALICEVISION_LOG_DEBUG("PUTATIVE");
-      getStatsMap(mapPutativesMatches);
+      logStatsMap(putativeStats);
     }
 #endif
 
-  // c. Geometric filtering of putative matches
-  //    - AContrario Estimation of the desired geometric model
-  //    - Use an upper bound for the a contrario estimated threshold
-
-  timer.reset();
-
-  matching::PairwiseMatches geometricMatches;
-
-  ALICEVISION_LOG_INFO("Geometric filtering: using " << matchingImageCollection::EGeometricFilterType_enumToString(geometricFilterType));
-
-  switch(geometricFilterType)
-  {
-
-    case EGeometricFilterType::NO_FILTERING:
-      geometricMatches = mapPutativesMatches;
-    break;
-
-    case EGeometricFilterType::FUNDAMENTAL_MATRIX:
-    {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator),
-        mapPutativesMatches,
-        guidedMatching);
-    }
-    break;
-
-    case EGeometricFilterType::ESSENTIAL_MATRIX:
-    {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_E_AC(std::numeric_limits<double>::infinity(), maxIteration),
-        mapPutativesMatches,
-        guidedMatching);
-
-      // perform an additional check to remove pairs with poor overlap
-      std::vector<PairwiseMatches::key_type> toRemoveVec;
-      for(PairwiseMatches::const_iterator iterMap = geometricMatches.begin();
-        iterMap != geometricMatches.end(); ++iterMap)
-      {
-        const size_t putativePhotometricCount = mapPutativesMatches.find(iterMap->first)->second.getNbAllMatches();
-        const size_t putativeGeometricCount = iterMap->second.getNbAllMatches();
-        const float ratio = putativeGeometricCount / (float)putativePhotometricCount;
-        if (putativeGeometricCount < 50 || ratio < .3f)
-          toRemoveVec.push_back(iterMap->first); // the image pair will be removed
-      }
-
-      // remove discarded pairs
-      for(std::vector<PairwiseMatches::key_type>::const_iterator iter = toRemoveVec.begin();
-          iter != toRemoveVec.end(); ++iter)
-        geometricMatches.erase(*iter);
-    }
-    break;
-
-    case EGeometricFilterType::HOMOGRAPHY_MATRIX:
-    {
-      const bool onlyGuidedMatching = true;
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_H_AC(std::numeric_limits<double>::infinity(), maxIteration),
-        mapPutativesMatches, guidedMatching,
-        onlyGuidedMatching ? -1.0 : 0.6);
-    }
-    break;
-
-    case EGeometricFilterType::HOMOGRAPHY_GROWING:
-    {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_HGrowing(std::numeric_limits<double>::infinity(), maxIteration),
-        mapPutativesMatches,
-        guidedMatching);
-    }
-    break;
-  }
-
-  ALICEVISION_LOG_INFO(std::to_string(geometricMatches.size()) + " geometric image pair matches:");
-  for(const auto& matchGeo: geometricMatches)
-    ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGeo.first.first) + ", " + std::to_string(matchGeo.first.second) + ") contains " + std::to_string(matchGeo.second.getNbAllMatches()) + " geometric matches.");
+  ALICEVISION_LOG_INFO(std::to_string(nbGeometricPairs) + " geometric image pair matches");
 
-  // grid filtering
-  ALICEVISION_LOG_INFO("Grid filtering");
+  ALICEVISION_LOG_INFO("After grid filtering:");
+  for(const auto& matchGridFiltering: finalMatches)
+    ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGridFiltering.first.first) + ", " + std::to_string(matchGridFiltering.first.second) + ") contains " + std::to_string(matchGridFiltering.second.getNbAllMatches()) + " geometric matches.");
 
-  PairwiseMatches finalMatches;
-  
-  {
-    for(const auto& geometricMatch: geometricMatches)
-    {
-      //Get the image pair and their matches.
-      const Pair& indexImagePair = geometricMatch.first;
-      const aliceVision::matching::MatchesPerDescType& matchesPerDesc = geometricMatch.second;
-
-      for(const auto& match: matchesPerDesc)
-      {
-        const feature::EImageDescriberType descType = match.first;
-        assert(descType != feature::EImageDescriberType::UNINITIALIZED);
-        const aliceVision::matching::IndMatches& inputMatches = match.second;
-
-        const feature::FeatRegions<feature::SIOPointFeature>* rRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionPerView.getRegions(indexImagePair.second, descType));
-        const feature::FeatRegions<feature::SIOPointFeature>* lRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionPerView.getRegions(indexImagePair.first, descType));
-
-        // get the regions for the current view pair:
-        if(rRegions && lRegions)
-        {
-          // sorting function:
-          aliceVision::matching::IndMatches outMatches;
-          sortMatches_byFeaturesScale(inputMatches, *lRegions, *rRegions, outMatches);
-
-          if(useGridSort)
-          {
-            // TODO: rename as matchesGridOrdering
-            matchesGridFiltering(*lRegions, *rRegions, indexImagePair, sfmData, outMatches);
-          }
-          if(numMatchesToKeep > 0)
-          {
-            size_t finalSize = std::min(numMatchesToKeep, outMatches.size());
-            outMatches.resize(finalSize);
-          }
-
-          // std::cout << "Left features: " << lRegions->Features().size() << ", right features: " << rRegions->Features().size() << ", num matches: " << inputMatches.size() << ", num filtered matches: " << outMatches.size() << std::endl;
-          finalMatches[indexImagePair].insert(std::make_pair(descType, outMatches));
-        }
-        else
-        {
-          ALICEVISION_LOG_INFO("You cannot perform the grid filtering with these regions");
-        }
-      }
-    }
-
-    ALICEVISION_LOG_INFO("After grid filtering:");
-    for(const auto& matchGridFiltering: finalMatches)
-      ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGridFiltering.first.first) + ", " + std::to_string(matchGridFiltering.first.second) + ") contains " + std::to_string(matchGridFiltering.second.getNbAllMatches()) + " geometric matches.");
-  }
+  system::Timer timer;
 
   // export geometric filtered matches
   ALICEVISION_LOG_INFO("Save geometric matches.");
   Save(finalMatches, matchesFolder, fileExtension, matchFilePerImage);
-  ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
+  ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(geometricFilteringTime + timer.elapsed()));
 
   // d. Export some statistics
   if(exportDebugFiles)
@@ -550,7 +709,7 @@ int main(int argc, char **argv)
 #ifdef ALICEVISION_DEBUG_MATCHING
   {
     ALICEVISION_LOG_DEBUG("GEOMETRIC");
-    getStatsMap(geometricMatches);
+    logStatsMap(geometricStats);
   }
 #endif
 
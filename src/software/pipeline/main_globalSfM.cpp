@@ -46,6 +46,7 @@ int main(int argc, char **argv)
   int rotationAveragingMethod = static_cast<int>(sfm::ROTATION_AVERAGING_L2);
   int translationAveragingMethod = static_cast<int>(sfm::TRANSLATION_AVERAGING_SOFTL1);
   bool refineIntrinsics = true;
+  bool useAnalyticJacobians = false;
 
   po::options_description allParams("Implementation of the paper\n"
     "\"Global Fusion of Relative Motions for "
@@ -77,7 +78,9 @@ int main(int argc, char **argv)
       "* 1: L1 minimization\n"
       "* 2: L2 minimization of sum of squared Chordal distances")
     ("refineIntrinsics", po::value<bool>(&refineIntrinsics)->default_value(refineIntrinsics),
-      "Refine intrinsic parameters.");
+      "Refine intrinsic parameters.")
+    ("useAnalyticJacobians", po::value<bool>(&useAnalyticJacobians)->default_value(useAnalyticJacobians),
+      "Use the cost functions with analytic Jacobians in the bundle adjustments instead of the automatic differentiation.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -193,6 +196,7 @@ int main(int argc, char **argv)
 
   // configure reconstruction parameters
   sfmEngine.setFixedIntrinsics(!refineIntrinsics);
+  sfmEngine.SetUseAnalyticJacobians(useAnalyticJacobians);
 
   // configure motion averaging method
   sfmEngine.SetRotationAveragingMethod(sfm::ERotationAveragingMethod(rotationAveragingMethod));
@@ -312,7 +312,13 @@ void generateFromVoctree(PairList& allMatches,
       allMatches[descriptorPair.first] = {};
   }
 
-  // query each document
+  // the sparse histogram of each document: in the DB, or computed from the descriptors of A in mode AB
+  std::vector<aliceVision::voctree::SparseHistogram> histogramsA;
+  std::vector<const aliceVision::voctree::SparseHistogram*> queries(descriptorsFiles.size());
+
+  if(modeMultiSfM == EImageMatchingMode::A_B)
+    histogramsA.resize(descriptorsFiles.size());
+
   #pragma omp parallel for
   for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFiles.size()); ++i)
   {
@@ -321,12 +327,10 @@ void generateFromVoctree(PairList& allMatches,
     const IndexT viewIdA = itA->first;
     const std::string featuresPathA = itA->second;
 
-    aliceVision::voctree::SparseHistogram imageSH;
-
     if(modeMultiSfM != EImageMatchingMode::A_B)
     {
       // sparse histogram of A is already computed in the DB
-      imageSH = db.getSparseHistogramPerImage().at(viewIdA);
+      queries[i] = &db.getSparseHistogramPerImage().at(viewIdA);
     }
     else // mode AB
     {
@@ -334,14 +338,20 @@ void generateFromVoctree(PairList& allMatches,
       std::vector<DescriptorUChar> descriptors;
       // read the descriptors
       loadDescsFromBinFile(featuresPathA, descriptors, false, nbMaxDescriptors);
-      imageSH = tree.quantizeToSparse(descriptors);
+      histogramsA[i] = tree.quantizeToSparse(descriptors);
+      queries[i] = &histogramsA[i];
     }
+  }
 
-    std::vector<aliceVision::voctree::DocMatch> matches;
-
-    db.find(imageSH, numImageQuery, matches);
+  // query all the documents at once
+  std::vector<aliceVision::voctree::DocMatches> allDocMatches;
+  db.findBatch(queries, numImageQuery, allDocMatches);
 
-    ListOfImageID& imgMatches = allMatches.at(viewIdA);
+  std::size_t i = 0;
+  for(const auto& descriptorPair : descriptorsFiles)
+  {
+    ListOfImageID& imgMatches = allMatches.at(descriptorPair.first);
+    const aliceVision::voctree::DocMatches& matches = allDocMatches.at(i++);
     imgMatches.reserve(imgMatches.size() + matches.size());
 
     for(const aliceVision::voctree::DocMatch& m : matches)
@@ -24,7 +24,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -96,6 +96,8 @@ int main(int argc, char **argv)
   bool useTrackFiltering = true;
   bool lockScenePreviouslyReconstructed = true;
   std::size_t localBundelAdjustementGraphDistanceLimit = 1;
+  std::size_t partitionedBAClusterSize = 0;
+  bool useAnalyticJacobians = false;
   std::string localizerEstimatorName = robustEstimation::ERobustEstimator_enumToString(robustEstimation::ERobustEstimator::ACRANSAC);
 
   po::options_description allParams(
@@ -154,6 +156,12 @@ int main(int argc, char **argv)
       "It reduces the reconstruction time, especially for big datasets (500+ images).")
     ("localBAGraphDistance", po::value<std::size_t>(&localBundelAdjustementGraphDistanceLimit)->default_value(localBundelAdjustementGraphDistanceLimit),
       "Graph-distance limit setting the Active region in the Local Bundle Adjustment strategy.")
+    ("partitionedBAClusterSize", po::value<std::size_t>(&partitionedBAClusterSize)->default_value(partitionedBAClusterSize),
+      "Maximum number of poses of each cluster of the partitioned global bundle adjustment.\n"
+      "The scenes with more poses are adjusted by clusters solved in parallel, which reduces the memory and time for very large scenes.\n"
+      "Set it to 0 to disable the partitioned bundle adjustment.")
+    ("useAnalyticJacobians", po::value<bool>(&useAnalyticJacobians)->default_value(useAnalyticJacobians),
+      "Use the cost functions with analytic Jacobians in the bundle adjustments instead of the automatic differentiation.")
     ("localizerEstimator", po::value<std::string>(&localizerEstimatorName)->default_value(localizerEstimatorName),
       "Estimator type used to localize cameras (acransac (default), ransac, lsmeds, loransac, maxconsensus)")
     ("useOnlyMatchesFromInputFolder", po::value<bool>(&useOnlyMatchesFromInputFolder)->default_value(useOnlyMatchesFromInputFolder),
@@ -273,6 +281,8 @@ int main(int argc, char **argv)
   sfmEngine.setIntermediateFileExtension(outInterFileExtension);
   sfmEngine.setUseLocalBundleAdjustmentStrategy(useLocalBundleAdjustment);
   sfmEngine.setLocalBundleAdjustmentGraphDistance(localBundelAdjustementGraphDistanceLimit);
+  sfmEngine.setPartitionedBundleAdjustmentClusterSize(partitionedBAClusterSize);
+  sfmEngine.setUseAnalyticJacobians(useAnalyticJacobians);
   sfmEngine.setLocalizerEstimator(robustEstimation::ERobustEstimator_stringToEnum(localizerEstimatorName));
   sfmEngine.useTrackFiltering(useTrackFiltering);
 
@@ -24,7 +24,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -96,6 +96,7 @@ int main(int argc, char* argv[])
     int maxPtsPerVoxel = 6000000;
 
     fuseCut::FuseParams fuseParams;
+    fuseCut::EMaxFlowMethod maxflowMethod = fuseCut::EMaxFlowMethod::BoykovKolmogorov;
 
     po::options_description allParams("AliceVision meshing");
 
@@ -128,7 +129,11 @@ int main(int argc, char* argv[])
         ("partitioning", po::value<EPartitioningMode>(&partitioningMode)->default_value(partitioningMode),
             "Partitioning: 'singleBlock' or 'auto'.")
         ("repartition", po::value<ERepartitionMode>(&repartitionMode)->default_value(repartitionMode),
-            "Repartition: 'multiResolution' or 'regularGrid'.");
+            "Repartition: 'multiResolution' or 'regularGrid'.")
+        ("maxflowMethod", po::value<fuseCut::EMaxFlowMethod>(&maxflowMethod)->default_value(maxflowMethod),
+            "Maxflow algorithm used for the graph cut:\n"
+            "* BoykovKolmogorov: Boykov-Kolmogorov on an adjacency list graph\n"
+            "* IBFS: incremental breadth-first search on a compact graph, faster and uses less memory");
 
     po::options_description advancedParams("Advanced parameters");
     advancedParams.add_options()
@@ -290,6 +295,7 @@ int main(int argc, char* argv[])
                         voxelNeighs[i] = i;
 
                     fuseCut::DelaunayGraphCut delaunayGC(lsbase.mp, lsbase.pc);
+                    delaunayGC.maxflowMethod = maxflowMethod;
                     Point3d* hexah = &lsbase.space[0];
                     delaunayGC.reconstructVoxel(hexah, &voxelNeighs, outDirectory.string()+"/", lsbase.getSpaceCamsTracksDir(), false,
                                           (fuseCut::VoxelsGrid*)&rp, lsbase.getSpaceSteps(), fuseParams);
@@ -334,6 +340,7 @@ int main(int argc, char* argv[])
                 {
                     ALICEVISION_LOG_INFO("Meshing mode: multi-resolution, partitioning: single block.");
                     fuseCut::DelaunayGraphCut delaunayGC(&mp, &pc);
+                    delaunayGC.maxflowMethod = maxflowMethod;
                     std::array<Point3d, 8> hexah;
 
                     float minPixSize;
@@ -20,7 +20,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 2
 
 using namespace aliceVision;
 
@@ -75,6 +75,9 @@ int main(int argc, char* argv[])
             "Fill texture holes with plausible values.")
         ("padding", po::value<unsigned int>(&texParams.padding)->default_value(texParams.padding),
             "Texture edge padding size in pixel")
+        ("maxMemory", po::value<unsigned int>(&texParams.maxMemoryMB)->default_value(texParams.maxMemoryMB),
+            "Memory budget (in MB) for the texture buffers, it limits the number of textures generated in parallel "
+            "and the size of the tiles. 0 to use half of the available memory.")
         ("inputMesh", po::value<std::string>(&inputMeshFilepath),
             "Optional input mesh to texture. By default, it will texture the inputReconstructionMesh.")
         ("flipNormals", po::value<bool>(&flipNormals)->default_value(flipNormals),
@@ -87,11 +90,14 @@ int main(int argc, char* argv[])
             "(0.0 to disable angle hard threshold filtering).")
         ("forceVisibleByAllVertices", po::value<bool>(&texParams.forceVisibleByAllVertices)->default_value(texParams.forceVisibleByAllVertices),
             "triangle visibility is based on the union of vertices visiblity.")
+        ("discardOccludedCameras", po::value<bool>(&texParams.discardOccludedCameras)->default_value(texParams.discardOccludedCameras),
+            "Rasterize the mesh in each camera to discard the cameras where a triangle is hidden by the mesh.")
         ("visibilityRemappingMethod", po::value<std::string>(&visibilityRemappingMethod)->default_value(visibilityRemappingMethod),
             "Method to remap visibilities from the reconstruction to the input mesh.\n"
             " * Pull: For each vertex of the input mesh, pull the visibilities from the closest vertex in the reconstruction.\n"
             " * Push: For each vertex of the reconstruction, push the visibilities to the closest triangle in the input mesh.\n"
-            " * PullPush: Combine results from Pull and Push results.'");
+            " * PullPush: Combine results from Pull and Push results.\n"
+            " * RayCast: For each vertex of the input mesh, cast rays from the cameras of the closest vertex in the reconstruction and keep the ones facing the vertex without occlusion by the input mesh.'");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -152,7 +158,7 @@ int main(int argc, char* argv[])
     // texturing from input mesh
     if(!inputMeshFilepath.empty())
     {
-       mesh.replaceMesh(inputMeshFilepath, flipNormals);
+       mesh.replaceMesh(mp, inputMeshFilepath, flipNormals);
     }
 
     if(!mesh.hasUVs())